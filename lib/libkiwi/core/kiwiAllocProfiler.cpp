@@ -0,0 +1,541 @@
+#include <libkiwi.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace kiwi {
+namespace {
+
+/**
+ * @brief Codewarrior stack frame
+ */
+struct StackFrame {
+    const StackFrame* next;
+    const void* lr;
+};
+
+/**
+ * @brief Describes a code address using the map file
+ *
+ * @param[out] pBuffer Description buffer
+ * @param size Description buffer size
+ * @param pAddr Code address
+ */
+void GetSymbolName(char* pBuffer, u32 size, const void* pAddr) {
+    K_ASSERT(pBuffer != nullptr);
+
+    // Symbol's offset from the start of module code
+    ptrdiff_t textOffset = PtrDistance(GetModuleTextStart(), pAddr);
+
+    // Symbol is from game (outside module)
+    if (textOffset < 0 || textOffset >= GetModuleTextSize()) {
+        std::snprintf(pBuffer, size, "%p (game)", pAddr);
+        return;
+    }
+
+    const MapFile::Symbol* pSym = MapFile::GetInstance().QueryTextSymbol(pAddr);
+
+    // Map file isn't loaded or doesn't know the symbol
+    if (pSym == nullptr) {
+        std::snprintf(pBuffer, size, "%08X (RELOC)", textOffset);
+        return;
+    }
+
+    std::snprintf(pBuffer, size, "%s(+0x%04X)", pSym->pName,
+                  PtrDistance(pSym->GetAddress(), pAddr));
+}
+
+} // namespace
+
+/**
+ * @brief Profiling toggle
+ */
+bool AllocProfiler::sIsEnabled = false;
+
+/**
+ * @brief Reporting in progress (see AutoSuspend)
+ */
+u32 AllocProfiler::sSuspendCount = 0;
+
+/**
+ * @brief Callsite hash table
+ */
+AllocProfiler::Callsite AllocProfiler::sCallsites[MAX_CALLSITES];
+
+/**
+ * @brief Number of callsites
+ */
+u32 AllocProfiler::sNumCallsites = 0;
+
+/**
+ * @brief Live block hash table (MAX_BLOCKS slots)
+ */
+AllocProfiler::Block* AllocProfiler::spBlocks = nullptr;
+
+/**
+ * @brief Number of live blocks
+ */
+u32 AllocProfiler::sNumBlocks = 0;
+
+/**
+ * @brief Allocations which could not be tracked
+ */
+u32 AllocProfiler::sNumDropped = 0;
+
+/**
+ * @brief Toggles profiling
+ * @note Enabling the profiler clears any previous results
+ *
+ * @param enable Whether to profile allocations
+ */
+void AllocProfiler::SetEnabled(bool enable) {
+    // Live block table is only needed once profiling is used
+    if (enable && spBlocks == nullptr) {
+        spBlocks = new (32, EMemory_MEM2) Block[MAX_BLOCKS];
+        K_ASSERT(spBlocks != nullptr);
+    }
+
+    AutoInterruptLock lock;
+
+    // Blocks freed while disabled would leave stale entries
+    if (enable && !sIsEnabled) {
+        Reset();
+    }
+
+    sIsEnabled = enable;
+}
+
+/**
+ * @brief Clears all callsites and live blocks
+ */
+void AllocProfiler::Reset() {
+    AutoInterruptLock lock;
+
+    std::memset(sCallsites, 0, sizeof(sCallsites));
+    sNumCallsites = 0;
+
+    if (spBlocks != nullptr) {
+        std::memset(spBlocks, 0, MAX_BLOCKS * sizeof(Block));
+    }
+
+    sNumBlocks = 0;
+    sNumDropped = 0;
+}
+
+/**
+ * @brief Records a new block
+ * @note Safe to call from interrupt context
+ *
+ * @param pBlock Block
+ * @param size Block size
+ * @param pCaller Return address into the caller
+ */
+void AllocProfiler::RecordAlloc(const void* pBlock, u32 size,
+                                const void* pCaller) {
+    if (!sIsEnabled || pBlock == nullptr) {
+        return;
+    }
+
+    AutoInterruptLock lock;
+
+    // Profiler is allocating for its own report
+    if (sSuspendCount > 0) {
+        return;
+    }
+
+    // Keep the block table at most 3/4 full so probes stay short. This is
+    // checked first so dropped blocks don't claim callsite slots.
+    if (sNumBlocks >= MAX_BLOCKS / 4 * 3) {
+        sNumDropped++;
+        return;
+    }
+
+    u16 site = FindCallsite(pCaller);
+    if (site == scNoSite) {
+        sNumDropped++;
+        return;
+    }
+
+    Callsite& rSite = sCallsites[site];
+    rSite.numAllocs++;
+    rSite.numLive++;
+    rSite.liveBytes += size;
+    rSite.peakBytes = Max(rSite.peakBytes, rSite.liveBytes);
+    rSite.totalBytes += size;
+
+    u32 slot = Hash(pBlock) & (MAX_BLOCKS - 1);
+    while (spBlocks[slot].pBlock != nullptr) {
+        slot = (slot + 1) & (MAX_BLOCKS - 1);
+    }
+
+    Block& rBlock = spBlocks[slot];
+    rBlock.pBlock = pBlock;
+    rBlock.size = size;
+    rBlock.site = site;
+    rBlock.region = OSIsMEM1Region(pBlock) ? EMemory_MEM1 : EMemory_MEM2;
+
+    sNumBlocks++;
+}
+
+/**
+ * @brief Records a freed block
+ * @note Safe to call from interrupt context
+ *
+ * @param pBlock Block
+ */
+void AllocProfiler::RecordFree(const void* pBlock) {
+    if (!sIsEnabled || pBlock == nullptr) {
+        return;
+    }
+
+    AutoInterruptLock lock;
+
+    // Allocated before profiling started, or dropped
+    u32 slot = FindBlock(pBlock);
+    if (slot == MAX_BLOCKS) {
+        return;
+    }
+
+    const Block& rBlock = spBlocks[slot];
+    Callsite& rSite = sCallsites[rBlock.site];
+
+    K_ASSERT(rSite.numLive > 0);
+    rSite.numLive--;
+    rSite.liveBytes -= rBlock.size;
+
+    RemoveBlock(slot);
+}
+
+/**
+ * @brief Gets a return address from the call stack
+ * @note Don't call this from an inline function, as it won't have its
+ * own stack frame
+ *
+ * @param depth Number of stack frames to go up (1 is the caller of the
+ * function calling GetCaller)
+ */
+const void* AllocProfiler::GetCaller(u32 depth) {
+    const StackFrame* pFrame =
+        static_cast<const StackFrame*>(OSGetStackPointer());
+
+    // Our own frame comes first
+    for (u32 i = 0; i <= depth; i++) {
+        if (pFrame == nullptr || !PtrUtil::IsPointer(pFrame)) {
+            return nullptr;
+        }
+
+        pFrame = pFrame->next;
+    }
+
+    if (pFrame == nullptr || !PtrUtil::IsPointer(pFrame)) {
+        return nullptr;
+    }
+
+    return pFrame->lr;
+}
+
+/**
+ * @brief Gets the callsites which allocated most often
+ *
+ * @param[out] pSites Callsite array
+ * @param num Callsite array length
+ * @return Number of callsites written
+ */
+u32 AllocProfiler::GetTopCallsites(Callsite* pSites, u32 num) {
+    K_ASSERT(pSites != nullptr || num == 0);
+
+    AutoInterruptLock lock;
+    u32 count = 0;
+
+    // Insertion sort keeps the output ordered by allocation count
+    for (u32 i = 0; i < MAX_CALLSITES; i++) {
+        const Callsite& rSite = sCallsites[i];
+
+        if (rSite.numAllocs == 0) {
+            continue;
+        }
+
+        u32 j = count;
+        while (j > 0 && pSites[j - 1].numAllocs < rSite.numAllocs) {
+            if (j < num) {
+                pSites[j] = pSites[j - 1];
+            }
+
+            j--;
+        }
+
+        if (j < num) {
+            pSites[j] = rSite;
+            count = Min(count + 1, num);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Gets the live blocks (in no particular order)
+ *
+ * @param[out] pBlocks Block array
+ * @param num Block array length
+ * @return Number of blocks written
+ */
+u32 AllocProfiler::GetLiveBlocks(Block* pBlocks, u32 num) {
+    K_ASSERT(pBlocks != nullptr || num == 0);
+
+    if (spBlocks == nullptr) {
+        return 0;
+    }
+
+    AutoInterruptLock lock;
+    u32 count = 0;
+
+    for (u32 i = 0; i < MAX_BLOCKS && count < num; i++) {
+        if (spBlocks[i].pBlock != nullptr) {
+            pBlocks[count++] = spBlocks[i];
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Gets a callsite's statistics
+ *
+ * @param site Callsite index
+ */
+AllocProfiler::Callsite AllocProfiler::GetCallsite(u16 site) {
+    K_ASSERT(site < MAX_CALLSITES);
+
+    AutoInterruptLock lock;
+    return sCallsites[site];
+}
+
+/**
+ * @brief Prints the top callsites and live blocks to the Nw4rConsole
+ *
+ * @param numSites Largest number of callsites to print
+ * @param numBlocks Largest number of live blocks to print
+ */
+void AllocProfiler::Print(u32 numSites, u32 numBlocks) {
+    // Report's own allocations shouldn't show up in it
+    AutoSuspend suspend;
+
+    Nw4rConsole& rConsole = Nw4rConsole::GetInstance();
+    char symbol[128];
+
+    rConsole.Printf("Allocation profile%s\n", sIsEnabled ? "" : " (disabled)");
+    rConsole.Printf("  %u callsites, %u live blocks, %u dropped\n",
+                    sNumCallsites, sNumBlocks, sNumDropped);
+
+    // Results are copied out so the lock isn't held while printing
+    Callsite* pSites = new (EAllocTag_Bulk) Callsite[Max<u32>(numSites, 1)];
+    u32 num = GetTopCallsites(pSites, numSites);
+
+    for (u32 i = 0; i < num; i++) {
+        const Callsite& rSite = pSites[i];
+        GetSymbolName(symbol, sizeof(symbol), rSite.pCaller);
+
+        rConsole.Printf("  %s\n", symbol);
+        rConsole.Printf("    allocs %u, live %u (%u bytes), peak %u bytes\n",
+                        rSite.numAllocs, rSite.numLive, rSite.liveBytes,
+                        rSite.peakBytes);
+    }
+
+    delete[] pSites;
+
+    Block* pBlocks = new (EAllocTag_Bulk) Block[Max<u32>(numBlocks, 1)];
+    num = GetLiveBlocks(pBlocks, numBlocks);
+
+    for (u32 i = 0; i < num; i++) {
+        const Block& rBlock = pBlocks[i];
+        GetSymbolName(symbol, sizeof(symbol),
+                      GetCallsite(rBlock.site).pCaller);
+
+        rConsole.Printf("  %p: %u bytes (MEM%d) from %s\n", rBlock.pBlock,
+                        rBlock.size, rBlock.region + 1, symbol);
+    }
+
+    delete[] pBlocks;
+}
+
+/**
+ * @brief Encodes the top callsites and live blocks into a JSON stream
+ *
+ * @param rWriter JSON stream writer
+ * @param numSites Largest number of callsites to encode
+ * @param numBlocks Largest number of live blocks to encode
+ */
+void AllocProfiler::Encode(json::StreamWriter& rWriter, u32 numSites,
+                           u32 numBlocks) {
+    // Report's own allocations shouldn't show up in it
+    AutoSuspend suspend;
+
+    char symbol[128];
+
+    rWriter.BeginObject();
+    rWriter.WriteKey("enabled");
+    rWriter.WriteBoolean(sIsEnabled);
+    rWriter.WriteKey("callsiteCount");
+    rWriter.WriteNumber(sNumCallsites);
+    rWriter.WriteKey("liveCount");
+    rWriter.WriteNumber(sNumBlocks);
+    rWriter.WriteKey("dropped");
+    rWriter.WriteNumber(sNumDropped);
+
+    Callsite* pSites = new (EAllocTag_Bulk) Callsite[Max<u32>(numSites, 1)];
+    u32 num = GetTopCallsites(pSites, numSites);
+
+    rWriter.WriteKey("callsites");
+    rWriter.BeginArray();
+    for (u32 i = 0; i < num; i++) {
+        const Callsite& rSite = pSites[i];
+        GetSymbolName(symbol, sizeof(symbol), rSite.pCaller);
+
+        rWriter.BeginObject();
+        rWriter.WriteKey("caller");
+        rWriter.WriteString(symbol);
+        rWriter.WriteKey("allocs");
+        rWriter.WriteNumber(rSite.numAllocs);
+        rWriter.WriteKey("live");
+        rWriter.WriteNumber(rSite.numLive);
+        rWriter.WriteKey("liveBytes");
+        rWriter.WriteNumber(rSite.liveBytes);
+        rWriter.WriteKey("peakBytes");
+        rWriter.WriteNumber(rSite.peakBytes);
+        rWriter.WriteKey("totalBytes");
+        rWriter.WriteNumber(static_cast<f64>(rSite.totalBytes));
+        rWriter.EndObject();
+    }
+    rWriter.EndArray();
+
+    delete[] pSites;
+
+    Block* pBlocks = new (EAllocTag_Bulk) Block[Max<u32>(numBlocks, 1)];
+    num = GetLiveBlocks(pBlocks, numBlocks);
+
+    rWriter.WriteKey("blocks");
+    rWriter.BeginArray();
+    for (u32 i = 0; i < num; i++) {
+        const Block& rBlock = pBlocks[i];
+        GetSymbolName(symbol, sizeof(symbol),
+                      GetCallsite(rBlock.site).pCaller);
+
+        rWriter.BeginObject();
+        rWriter.WriteKey("address");
+        rWriter.WriteNumber(reinterpret_cast<u32>(rBlock.pBlock));
+        rWriter.WriteKey("size");
+        rWriter.WriteNumber(rBlock.size);
+        rWriter.WriteKey("region");
+        rWriter.WriteString(rBlock.region == EMemory_MEM1 ? "MEM1" : "MEM2");
+        rWriter.WriteKey("caller");
+        rWriter.WriteString(symbol);
+        rWriter.EndObject();
+    }
+    rWriter.EndArray();
+
+    delete[] pBlocks;
+
+    rWriter.EndObject();
+}
+
+/**
+ * @brief Writes the top callsites and live blocks to a stream as JSON
+ * (UTF-8)
+ *
+ * @param rStrm Destination stream
+ * @param pretty Whether to pretty-print
+ * @return Success
+ */
+bool AllocProfiler::Dump(IStream& rStrm, bool pretty) {
+    // Writer buffers count as part of the report
+    AutoSuspend suspend;
+
+    json::StreamWriter writer(rStrm, pretty);
+    Encode(writer);
+    return writer.Flush();
+}
+
+/**
+ * @brief Finds or adds the table slot of a callsite
+ *
+ * @param pCaller Return address into the caller
+ * @return Callsite index, or scNoSite if the table is full
+ */
+u16 AllocProfiler::FindCallsite(const void* pCaller) {
+    u32 slot = Hash(pCaller) & (MAX_CALLSITES - 1);
+
+    for (u32 i = 0; i < MAX_CALLSITES; i++) {
+        Callsite& rSite = sCallsites[slot];
+
+        // Unused slot, so this is a new callsite
+        if (rSite.numAllocs == 0) {
+            rSite.pCaller = pCaller;
+            sNumCallsites++;
+            return slot;
+        }
+
+        if (rSite.pCaller == pCaller) {
+            return slot;
+        }
+
+        slot = (slot + 1) & (MAX_CALLSITES - 1);
+    }
+
+    return scNoSite;
+}
+
+/**
+ * @brief Finds the table slot of a live block
+ *
+ * @param pBlock Block
+ * @return Slot index, or MAX_BLOCKS if the block isn't tracked
+ */
+u32 AllocProfiler::FindBlock(const void* pBlock) {
+    u32 slot = Hash(pBlock) & (MAX_BLOCKS - 1);
+
+    // Table is never full, so there is always an empty slot to stop at
+    while (spBlocks[slot].pBlock != nullptr) {
+        if (spBlocks[slot].pBlock == pBlock) {
+            return slot;
+        }
+
+        slot = (slot + 1) & (MAX_BLOCKS - 1);
+    }
+
+    return MAX_BLOCKS;
+}
+
+/**
+ * @brief Removes a live block from the table
+ *
+ * @param slot Slot index
+ */
+void AllocProfiler::RemoveBlock(u32 slot) {
+    K_ASSERT(slot < MAX_BLOCKS);
+    K_ASSERT(sNumBlocks > 0);
+
+    u32 hole = slot;
+
+    // Shift later entries back so lookups never stop early at the hole
+    for (u32 next = (hole + 1) & (MAX_BLOCKS - 1);
+         spBlocks[next].pBlock != nullptr;
+         next = (next + 1) & (MAX_BLOCKS - 1)) {
+
+        u32 home = Hash(spBlocks[next].pBlock) & (MAX_BLOCKS - 1);
+
+        // Entry can move if its home slot isn't between the hole and it
+        bool stay = hole <= next ? hole < home && home <= next
+                                 : hole < home || home <= next;
+
+        if (!stay) {
+            spBlocks[hole] = spBlocks[next];
+            hole = next;
+        }
+    }
+
+    spBlocks[hole].pBlock = nullptr;
+    sNumBlocks--;
+}
+
+} // namespace kiwi
@@ -0,0 +1,256 @@
+#ifndef LIBKIWI_CORE_ALLOC_PROFILER_H
+#define LIBKIWI_CORE_ALLOC_PROFILER_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/util/kiwiAutoLock.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+/**
+ * @brief Gets the return address into the code calling the current function,
+ * for allocation profiling
+ * @note Only evaluated while profiling, as walking the stack isn't free
+ */
+#define K_ALLOC_CALLER                                                         \
+    (kiwi::AllocProfiler::IsEnabled() ? kiwi::AllocProfiler::GetCaller(1)     \
+                                      : nullptr)
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+
+// Forward declarations
+class IStream;
+
+namespace json {
+class StreamWriter;
+}
+
+/**
+ * @brief Per-callsite allocation profiler
+ * @details MemoryMgr reports every allocation and free to the profiler, which
+ * remembers the caller, size, and region of each live block, and keeps
+ * counters for each callsite. Callsites are symbolized using the MapFile when
+ * one is loaded.
+ *
+ * Profiling is opt-in, so nothing is recorded (and no memory is used for the
+ * live block table) until it is enabled. While enabled, a report is printed
+ * to the Nw4rConsole whenever a scene exits.
+ */
+class AllocProfiler {
+    friend class MemoryMgr;
+
+public:
+    /**
+     * @brief Allocation callsite statistics
+     */
+    struct Callsite {
+        const void* pCaller; // Return address into the caller
+        u32 numAllocs;       // Number of allocations
+        u32 numLive;         // Number of live blocks
+        u32 liveBytes;       // Bytes in live blocks
+        u32 peakBytes;       // Largest number of live bytes
+        u64 totalBytes;      // Bytes ever allocated
+    };
+
+    /**
+     * @brief Live block information
+     */
+    struct Block {
+        const void* pBlock; // Block address
+        u32 size;           // Block size
+        u16 site;           // Callsite index
+        u8 region;          // Memory region (EMemory)
+    };
+
+    //! Largest number of callsites
+    static const u32 MAX_CALLSITES = 256;
+    //! Largest number of live blocks
+    static const u32 MAX_BLOCKS = 8192;
+
+public:
+    /**
+     * @brief Toggles profiling
+     * @note Enabling the profiler clears any previous results
+     *
+     * @param enable Whether to profile allocations
+     */
+    static void SetEnabled(bool enable);
+    /**
+     * @brief Tests whether allocations are being profiled
+     */
+    static bool IsEnabled() {
+        return sIsEnabled;
+    }
+
+    /**
+     * @brief Clears all callsites and live blocks
+     */
+    static void Reset();
+
+    /**
+     * @brief Records a new block
+     * @note Safe to call from interrupt context
+     *
+     * @param pBlock Block
+     * @param size Block size
+     * @param pCaller Return address into the caller
+     */
+    static void RecordAlloc(const void* pBlock, u32 size, const void* pCaller);
+    /**
+     * @brief Records a freed block
+     * @note Safe to call from interrupt context
+     *
+     * @param pBlock Block
+     */
+    static void RecordFree(const void* pBlock);
+
+    /**
+     * @brief Gets a return address from the call stack
+     * @note Don't call this from an inline function, as it won't have its
+     * own stack frame
+     *
+     * @param depth Number of stack frames to go up (1 is the caller of the
+     * function calling GetCaller)
+     */
+    static const void* GetCaller(u32 depth);
+
+    /**
+     * @brief Gets the callsites which allocated most often
+     *
+     * @param[out] pSites Callsite array
+     * @param num Callsite array length
+     * @return Number of callsites written
+     */
+    static u32 GetTopCallsites(Callsite* pSites, u32 num);
+    /**
+     * @brief Gets the live blocks (in no particular order)
+     *
+     * @param[out] pBlocks Block array
+     * @param num Block array length
+     * @return Number of blocks written
+     */
+    static u32 GetLiveBlocks(Block* pBlocks, u32 num);
+    /**
+     * @brief Gets a callsite's statistics
+     *
+     * @param site Callsite index
+     */
+    static Callsite GetCallsite(u16 site);
+
+    /**
+     * @brief Gets the number of live blocks
+     */
+    static u32 GetNumLiveBlocks() {
+        return sNumBlocks;
+    }
+    /**
+     * @brief Gets the number of allocations which could not be tracked
+     */
+    static u32 GetNumDropped() {
+        return sNumDropped;
+    }
+
+    /**
+     * @brief Prints the top callsites and live blocks to the Nw4rConsole
+     *
+     * @param numSites Largest number of callsites to print
+     * @param numBlocks Largest number of live blocks to print
+     */
+    static void Print(u32 numSites = 10, u32 numBlocks = 10);
+
+    /**
+     * @brief Encodes the top callsites and live blocks into a JSON stream
+     *
+     * @param rWriter JSON stream writer
+     * @param numSites Largest number of callsites to encode
+     * @param numBlocks Largest number of live blocks to encode
+     */
+    static void Encode(json::StreamWriter& rWriter, u32 numSites = 32,
+                       u32 numBlocks = 256);
+    /**
+     * @brief Writes the top callsites and live blocks to a stream as JSON
+     * (UTF-8)
+     *
+     * @param rStrm Destination stream
+     * @param pretty Whether to pretty-print
+     * @return Success
+     */
+    static bool Dump(IStream& rStrm, bool pretty = false);
+
+private:
+    /**
+     * @brief Stops recording allocations for the lifetime of the object
+     * @details Used while the profiler reports results, so its own
+     * allocations don't show up in them
+     */
+    class AutoSuspend : private NonCopyable {
+    public:
+        /**
+         * @brief Constructor
+         */
+        AutoSuspend() {
+            AutoInterruptLock lock;
+            sSuspendCount++;
+        }
+
+        /**
+         * @brief Destructor
+         */
+        ~AutoSuspend() {
+            AutoInterruptLock lock;
+            K_ASSERT(sSuspendCount > 0);
+            sSuspendCount--;
+        }
+    };
+
+private:
+    /**
+     * @brief Finds or adds the table slot of a callsite
+     *
+     * @param pCaller Return address into the caller
+     * @return Callsite index, or scNoSite if the table is full
+     */
+    static u16 FindCallsite(const void* pCaller);
+    /**
+     * @brief Finds the table slot of a live block
+     *
+     * @param pBlock Block
+     * @return Slot index, or MAX_BLOCKS if the block isn't tracked
+     */
+    static u32 FindBlock(const void* pBlock);
+    /**
+     * @brief Removes a live block from the table
+     *
+     * @param slot Slot index
+     */
+    static void RemoveBlock(u32 slot);
+
+    /**
+     * @brief Hashes an address for the profiler tables
+     *
+     * @param pAddr Address
+     */
+    static u32 Hash(const void* pAddr) {
+        // Blocks and instructions are at least 4-byte aligned
+        return (reinterpret_cast<u32>(pAddr) >> 2) * 0x9E3779B1;
+    }
+
+private:
+    //! Callsite index for untracked blocks
+    static const u16 scNoSite = 0xFFFF;
+
+    static bool sIsEnabled;   // Profiling toggle
+    static u32 sSuspendCount; // Reporting in progress (see AutoSuspend)
+
+    static Callsite sCallsites[MAX_CALLSITES]; // Callsite hash table
+    static u32 sNumCallsites;                  // Number of callsites
+
+    static Block* spBlocks; // Live block hash table (MAX_BLOCKS slots)
+    static u32 sNumBlocks;  // Number of live blocks
+    static u32 sNumDropped; // Allocations which could not be tracked
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef LIBKIWI_CORE_ALLOCATOR_H
+#define LIBKIWI_CORE_ALLOCATOR_H
+#include <libkiwi/k_types.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+
+/**
+ * @brief Memory allocator interface
+ * @details Containers (TVector, TMap, TList, StringImpl) can be given an
+ * allocator for their storage. Without one, they use the default heap.
+ *
+ * Copies of a container use the default heap, so they can safely outlive
+ * the source's allocator. Moved containers take their allocator with them.
+ *
+ * TVector and StringImpl try to resize their buffer in place before moving
+ * it to a new block.
+ */
+class IAllocator {
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~IAllocator() {}
+
+    /**
+     * @brief Allocates a block of memory
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @return Pointer to allocated block
+     */
+    virtual void* Alloc(u32 size, s32 align) = 0;
+
+    /**
+     * @brief Frees a block of memory
+     *
+     * @param pBlock Block
+     */
+    virtual void Free(void* pBlock) = 0;
+
+    /**
+     * @brief Resizes a block of memory in place
+     * @details Allocators which can't do this keep the default, which always
+     * fails
+     *
+     * @param pBlock Block
+     * @param size New block size
+     * @return Success
+     */
+    virtual bool Resize(void* pBlock, u32 size) {
+        return false;
+    }
+
+    /**
+     * @brief Allocates a block of memory
+     * @details Blocks have the same alignment as the global operator new
+     *
+     * @param pAllocator Allocator (nullptr for the default heap)
+     * @param size Block size
+     * @return Pointer to allocated block
+     */
+    static void* AllocFrom(IAllocator* pAllocator, u32 size) {
+        if (pAllocator == nullptr) {
+            return new u8[size];
+        }
+
+        return pAllocator->Alloc(size, 4);
+    }
+
+    /**
+     * @brief Frees a block of memory
+     *
+     * @param pAllocator Allocator (nullptr for the default heap)
+     * @param pBlock Block
+     */
+    static void FreeTo(IAllocator* pAllocator, void* pBlock) {
+        if (pAllocator == nullptr) {
+            delete[] static_cast<u8*>(pBlock);
+            return;
+        }
+
+        pAllocator->Free(pBlock);
+    }
+
+    /**
+     * @brief Resizes a block of memory in place
+     *
+     * @param pAllocator Allocator (nullptr for the default heap)
+     * @param pBlock Block
+     * @param size New block size
+     * @return Success (always fails for the default heap)
+     */
+    static bool ResizeIn(IAllocator* pAllocator, void* pBlock, u32 size) {
+        if (pAllocator == nullptr || pBlock == nullptr) {
+            return false;
+        }
+
+        return pAllocator->Resize(pBlock, size);
+    }
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
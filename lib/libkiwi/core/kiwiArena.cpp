@@ -0,0 +1,210 @@
+#include <libkiwi.h>
+
+namespace kiwi {
+
+/**
+ * @brief Constructor
+ * @note No memory is allocated until the first allocation
+ *
+ * @param region Memory region for the arena
+ * @param chunkSize Smallest chunk size
+ */
+Arena::Arena(EMemory region, u32 chunkSize)
+    : mRegion(region),
+      mChunkSize(chunkSize),
+      mpChunkHead(nullptr),
+      mpChunk(nullptr),
+      mpLastBlock(nullptr),
+      mArenaSize(0),
+      mPeakSize(0) {
+
+    K_ASSERT(chunkSize > sizeof(Chunk));
+}
+
+/**
+ * @brief Destructor
+ */
+Arena::~Arena() {
+    Clear();
+}
+
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param align Block alignment
+ * @return Pointer to allocated block
+ */
+void* Arena::Alloc(u32 size, s32 align) {
+    // Negative alignment only chooses which end of a heap to use
+    u32 absAlign = align < 0 ? -align : align;
+
+    K_ASSERT(absAlign > 0 && (absAlign & (absAlign - 1)) == 0);
+    K_ASSERT_EX(absAlign <= 32, "Chunks are only 32-byte aligned");
+
+    if (mpChunk == nullptr ||
+        ROUND_UP(mpChunk->used, absAlign) + size > mpChunk->size) {
+        NextChunk(size, absAlign);
+    }
+
+    u32 offset = ROUND_UP(mpChunk->used, absAlign);
+    mpChunk->used = offset + size;
+
+    mpLastBlock = AddToPtr<u8>(mpChunk, offset);
+    mPeakSize = Max(mPeakSize, mpChunk->base + mpChunk->used);
+
+    return mpLastBlock;
+}
+
+/**
+ * @brief Frees a block of memory
+ * @details Only the most recent block is actually reclaimed
+ *
+ * @param pBlock Block
+ */
+void Arena::Free(void* pBlock) {
+    if (pBlock == nullptr || pBlock != mpLastBlock) {
+        return;
+    }
+
+    // Most recent block is always in the current chunk
+    mpChunk->used = PtrDistance(mpChunk, pBlock);
+    mpLastBlock = nullptr;
+}
+
+/**
+ * @brief Resizes a block of memory in place
+ * @details Only the most recent block can be resized, and only within its
+ * chunk
+ *
+ * @param pBlock Block
+ * @param size New block size
+ * @return Success
+ */
+bool Arena::Resize(void* pBlock, u32 size) {
+    if (pBlock == nullptr || pBlock != mpLastBlock) {
+        return false;
+    }
+
+    // Most recent block is always in the current chunk
+    u32 offset = PtrDistance(mpChunk, pBlock);
+    if (offset + size > mpChunk->size) {
+        return false;
+    }
+
+    mpChunk->used = offset + size;
+    mPeakSize = Max(mPeakSize, mpChunk->base + mpChunk->used);
+
+    return true;
+}
+
+/**
+ * @brief Gets the current arena position
+ */
+Arena::Marker Arena::GetMarker() {
+    // Blocks from before the marker must not be rolled back past it
+    mpLastBlock = nullptr;
+
+    Marker marker;
+    marker.pChunk = mpChunk;
+    marker.used = mpChunk != nullptr ? mpChunk->used : 0;
+
+    return marker;
+}
+
+/**
+ * @brief Releases all memory allocated since the marker was taken
+ *
+ * @param rMarker Arena position
+ */
+void Arena::Release(const Marker& rMarker) {
+    // Marker was taken before the first chunk existed
+    if (rMarker.pChunk == nullptr) {
+        Reset();
+        return;
+    }
+
+    mpChunk = static_cast<Chunk*>(rMarker.pChunk);
+    mpChunk->used = rMarker.used;
+    mpLastBlock = nullptr;
+}
+
+/**
+ * @brief Releases all memory, keeping the chunks for reuse
+ */
+void Arena::Reset() {
+    mpChunk = mpChunkHead;
+    mpLastBlock = nullptr;
+
+    if (mpChunk != nullptr) {
+        mpChunk->used = sizeof(Chunk);
+        mpChunk->base = 0;
+    }
+}
+
+/**
+ * @brief Releases all memory and frees the chunks
+ */
+void Arena::Clear() {
+    while (mpChunkHead != nullptr) {
+        Chunk* pNext = mpChunkHead->pNext;
+        delete[] reinterpret_cast<u8*>(mpChunkHead);
+        mpChunkHead = pNext;
+    }
+
+    mpChunk = nullptr;
+    mpLastBlock = nullptr;
+    mArenaSize = 0;
+}
+
+/**
+ * @brief Gets the number of bytes in use
+ */
+u32 Arena::GetUsedSize() const {
+    return mpChunk != nullptr ? mpChunk->base + mpChunk->used : 0;
+}
+
+/**
+ * @brief Moves to a chunk which can fit the specified block
+ *
+ * @param size Block size
+ * @param align Block alignment
+ */
+void Arena::NextChunk(u32 size, u32 align) {
+    u32 base = mpChunk != nullptr ? mpChunk->base + mpChunk->used : 0;
+    Chunk* pNext = mpChunk != nullptr ? mpChunk->pNext : mpChunkHead;
+
+    // Chunk header is followed by the aligned block
+    u32 offset = ROUND_UP(sizeof(Chunk), align);
+
+    // Reuse the next chunk if the block fits
+    if (pNext != nullptr && offset + size <= pNext->size) {
+        mpChunk = pNext;
+        mpChunk->used = sizeof(Chunk);
+        mpChunk->base = base;
+        return;
+    }
+
+    // Larger blocks get a chunk to themselves
+    u32 chunkSize = Max(mChunkSize, offset + size);
+
+    Chunk* pChunk = reinterpret_cast<Chunk*>(new (32, mRegion) u8[chunkSize]);
+    K_ASSERT(pChunk != nullptr);
+
+    // Retained chunks which are too small stay after the new one
+    pChunk->pNext = pNext;
+    pChunk->size = chunkSize;
+    pChunk->used = sizeof(Chunk);
+    pChunk->base = base;
+
+    if (mpChunk != nullptr) {
+        mpChunk->pNext = pChunk;
+    } else {
+        mpChunkHead = pChunk;
+    }
+
+    mpChunk = pChunk;
+    mArenaSize += chunkSize;
+}
+
+} // namespace kiwi
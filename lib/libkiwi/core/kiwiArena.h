@@ -0,0 +1,199 @@
+#ifndef LIBKIWI_CORE_ARENA_H
+#define LIBKIWI_CORE_ARENA_H
+#include <libkiwi/core/kiwiAllocator.h>
+#include <libkiwi/core/kiwiMemoryMgr.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+
+/**
+ * @brief Linear (bump) allocator
+ * @details Memory is taken from chunks in order, and is only given back all
+ * at once, either by releasing to a marker or by resetting the arena. Chunks
+ * are kept for reuse until the arena is cleared.
+ *
+ * Freeing individual blocks does nothing, except for the most recent block
+ * which is rolled back. Likewise, only the most recent block can be resized
+ * in place. TVector and StringImpl buffers at the top of the arena grow
+ * without moving, but any other growth (including TMap rehashes) leaves the
+ * old block unusable until the arena is released or reset. Reserve container
+ * space up front where the final size is known.
+ *
+ * SceneHookMgr provides a frame arena (reset every frame) and a scene arena
+ * (cleared on every scene change).
+ * @note Not thread-safe
+ */
+class Arena : public IAllocator, private NonCopyable {
+public:
+    /**
+     * @brief Arena position
+     */
+    struct Marker {
+        void* pChunk; // Chunk in use
+        u32 used;     // Chunk bytes in use
+    };
+
+    //! Default size of arena chunks
+    static const u32 DEFAULT_CHUNK_SIZE = OS_MEM_KB_TO_B(16);
+
+public:
+    /**
+     * @brief Constructor
+     * @note No memory is allocated until the first allocation
+     *
+     * @param region Memory region for the arena
+     * @param chunkSize Smallest chunk size
+     */
+    explicit Arena(EMemory region = EMemory_MEM2,
+                   u32 chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~Arena();
+
+    /**
+     * @brief Allocates a block of memory
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @return Pointer to allocated block
+     */
+    virtual void* Alloc(u32 size, s32 align);
+
+    /**
+     * @brief Frees a block of memory
+     * @details Only the most recent block is actually reclaimed
+     *
+     * @param pBlock Block
+     */
+    virtual void Free(void* pBlock);
+
+    /**
+     * @brief Resizes a block of memory in place
+     * @details Only the most recent block can be resized, and only within
+     * its chunk
+     *
+     * @param pBlock Block
+     * @param size New block size
+     * @return Success
+     */
+    virtual bool Resize(void* pBlock, u32 size);
+
+    /**
+     * @brief Gets the current arena position
+     */
+    Marker GetMarker();
+    /**
+     * @brief Releases all memory allocated since the marker was taken
+     *
+     * @param rMarker Arena position
+     */
+    void Release(const Marker& rMarker);
+
+    /**
+     * @brief Releases all memory, keeping the chunks for reuse
+     */
+    void Reset();
+    /**
+     * @brief Releases all memory and frees the chunks
+     */
+    void Clear();
+
+    /**
+     * @brief Gets the number of bytes in use
+     */
+    u32 GetUsedSize() const;
+    /**
+     * @brief Gets the total size of the arena chunks
+     */
+    u32 GetArenaSize() const {
+        return mArenaSize;
+    }
+    /**
+     * @brief Gets the largest number of bytes ever in use
+     */
+    u32 GetPeakSize() const {
+        return mPeakSize;
+    }
+
+private:
+    /**
+     * @brief Arena memory chunk
+     */
+    struct Chunk {
+        Chunk* pNext; // Next (newer) chunk
+        u32 size;     // Chunk size (including header)
+        u32 used;     // Number of bytes used (including header)
+        u32 base;     // Bytes in use in all older chunks
+    };
+
+private:
+    /**
+     * @brief Moves to a chunk which can fit the specified block
+     *
+     * @param size Block size
+     * @param align Block alignment
+     */
+    void NextChunk(u32 size, u32 align);
+
+private:
+    EMemory mRegion; // Arena memory region
+    u32 mChunkSize;  // Smallest chunk size
+
+    Chunk* mpChunkHead; // Oldest chunk
+    Chunk* mpChunk;     // Chunk in use
+    u8* mpLastBlock;    // Most recent block
+
+    u32 mArenaSize; // Total size of all chunks
+    u32 mPeakSize;  // Largest number of bytes in use
+};
+
+/**
+ * @brief Scoped arena position
+ * @details Everything allocated from the arena during the scope is released
+ * when the scope ends.
+ */
+class ScopedArena : private NonCopyable {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rArena Arena to mark
+     */
+    explicit ScopedArena(Arena& rArena)
+        : mrArena(rArena), mMarker(rArena.GetMarker()) {}
+
+    /**
+     * @brief Destructor
+     */
+    ~ScopedArena() {
+        mrArena.Release(mMarker);
+    }
+
+    /**
+     * @brief Gets the underlying arena
+     */
+    Arena& GetArena() const {
+        return mrArena;
+    }
+
+    /**
+     * @brief Gets the underlying arena as an allocator
+     */
+    operator IAllocator*() const {
+        return &mrArena;
+    }
+
+private:
+    Arena& mrArena;        // Marked arena
+    Arena::Marker mMarker; // Arena position at the start of the scope
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
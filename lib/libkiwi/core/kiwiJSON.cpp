@@ -24,10 +24,7 @@ namespace json {
  *
  * @param rOther Element to copy
  */
-Element::Element(const Element& rOther) {
-    // Don't leak existing memory
-    Clear();
-
+Element::Element(const Element& rOther) : mType(EType_Undefined) {
     if (rOther.IsUndefined()) {
         return;
     }
@@ -1012,7 +1009,7 @@ bool Reader::ParseFraction(u32& rPos, String& rToken) {
         DONT_MATCH();
     }
 
-    rToken = '.' + digits;
+    rToken = String('.') + digits;
     MATCH();
 }
 
@@ -1039,9 +1036,11 @@ bool Reader::ParseExponent(u32& rPos, String& rToken) {
         DONT_MATCH();
     }
 
+    String exponent(prefix);
+
     char sign;
-    if (!ParseLiteral('-', pos, sign)) {
-        ParseLiteral('+', pos, sign);
+    if (ParseLiteral('-', pos, sign) || ParseLiteral('+', pos, sign)) {
+        exponent += sign;
     }
 
     String digits = "";
@@ -1051,7 +1050,7 @@ bool Reader::ParseExponent(u32& rPos, String& rToken) {
         DONT_MATCH();
     }
 
-    rToken = prefix + (sign + digits);
+    rToken = exponent + digits;
     MATCH();
 }
 
@@ -17,6 +17,8 @@ namespace json {
 
 // Forward declarations
 class Element;
+class StreamReader;
+class StreamWriter;
 
 //! JSON array contains zero or more elements
 typedef TVector<Element> Array;
@@ -86,46 +88,30 @@ public:
      * @name Value constructors
      */
     /**@{*/
-    // clang-format off
-    Element(f64 x)           { Set<f64>(x);    }
-    Element(s64 x)           { Set<s64>(x);    }
-    Element(bool x)          { Set<bool>(x);   }
-    Element(const String& x) { Set<String>(x); }
-    Element(const Array& x)  { Set<Array>(x);  }
-    Element(const Object& x) { Set<Object>(x); }
-    Element(Null_t x)        { Set<Null_t>(x); }
-    // clang-format on
+    // (Defined after the Get/Set specializations, see kiwiJSONImpl.hpp)
+    Element(f64 x);
+    Element(s64 x);
+    Element(bool x);
+    Element(const String& x);
+    Element(const Array& x);
+    Element(const Object& x);
+    Element(Null_t x);
     /**@}*/
 
     /**
      * @name Array access
      */
     /**@{*/
-    Element& operator[](int i) {
-        K_ASSERT(mType == EType_Array);
-        return Get<Array>()[i];
-    }
-    const Element& operator[](int i) const {
-        K_ASSERT(mType == EType_Array);
-        return Get<Array>()[i];
-    }
+    Element& operator[](int i);
+    const Element& operator[](int i) const;
     /**@}*/
 
     /**
      * @name Object access
      */
     /**@{*/
-    Element& operator[](const String& rKey) {
-        K_ASSERT(mType == EType_Object);
-        return Get<Object>()[rKey];
-    }
-    const Element& operator[](const String& rKey) const {
-        K_ASSERT(mType == EType_Object);
-        const Element* pElement = Get<Object>().Find(rKey);
-
-        K_ASSERT(pElement != nullptr);
-        return *pElement;
-    }
+    Element& operator[](const String& rKey);
+    const Element& operator[](const String& rKey) const;
     /**@}*/
 
     /**
@@ -231,6 +217,26 @@ public:
     virtual bool Deserialize(const Element& /* rElem */) {
         return true;
     }
+
+    /**
+     * @brief Encodes this object directly into a JSON stream
+     * @details Override this to skip building an element tree. By default,
+     * the object is serialized into an element which is then written.
+     *
+     * @param rWriter JSON stream writer
+     */
+    virtual void Encode(StreamWriter& rWriter) const;
+
+    /**
+     * @brief Decodes a JSON stream into this object
+     * @details Override this to skip building an element tree (e.g. by
+     * parsing with a custom event handler). By default, the stream is read
+     * into an element which is then deserialized.
+     *
+     * @param rReader JSON stream reader
+     * @return Success
+     */
+    virtual bool Decode(StreamReader& rReader);
 };
 
 /**
@@ -0,0 +1,821 @@
+#include <libkiwi.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace kiwi {
+namespace json {
+namespace {
+
+/**
+ * @brief Exactly representable powers of ten
+ */
+const f64 scPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                       1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                       1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//! Largest integer which a double can represent exactly
+const u64 scMaxExactInt = 1ULL << 53;
+//! Largest number of significant digits that fit in a u64
+const u32 scMaxDigits = 19;
+//! Largest number of characters in a number that can be parsed slowly
+const u32 scMaxNumberLength = 64;
+
+/**
+ * @brief Tests whether character is a decimal digit
+ *
+ * @param c Character
+ */
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Converts a hexadecimal character to its value
+ *
+ * @param c Character
+ * @return Value, or -1 if the character is not hexadecimal
+ */
+s32 HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+} // namespace
+
+namespace detail {
+
+/**
+ * @brief Parses four hexadecimal digits (unicode escape sequence)
+ *
+ * @param pStr Hex digits
+ * @param[out] rCode Character code
+ * @return Success
+ */
+bool ParseHex4(const char* pStr, u32& rCode) {
+    rCode = 0;
+
+    for (int i = 0; i < 4; i++) {
+        s32 value = HexValue(pStr[i]);
+        if (value < 0) {
+            return false;
+        }
+
+        rCode = (rCode << 4) | value;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Encodes a unicode code point as UTF-8
+ *
+ * @param code Code point
+ * @param[out] pDst Destination buffer (at least four bytes)
+ * @return Number of bytes written
+ */
+u32 EncodeUTF8(u32 code, char* pDst) {
+    if (code < 0x80) {
+        pDst[0] = static_cast<char>(code);
+        return 1;
+    }
+
+    if (code < 0x800) {
+        pDst[0] = static_cast<char>(0xC0 | (code >> 6));
+        pDst[1] = static_cast<char>(0x80 | (code & 0x3F));
+        return 2;
+    }
+
+    if (code < 0x10000) {
+        pDst[0] = static_cast<char>(0xE0 | (code >> 12));
+        pDst[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        pDst[2] = static_cast<char>(0x80 | (code & 0x3F));
+        return 3;
+    }
+
+    pDst[0] = static_cast<char>(0xF0 | (code >> 18));
+    pDst[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    pDst[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    pDst[3] = static_cast<char>(0x80 | (code & 0x3F));
+    return 4;
+}
+
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Number'
+ * @details Digits are accumulated directly from the input bytes
+ *
+ * @param[in, out] rpCursor Parser position
+ * @param pEnd End of input data
+ * @param[out] rNumber Destination number
+ * @return Success
+ */
+bool ParseNumber(const char*& rpCursor, const char* pEnd, f64& rNumber) {
+    K_ASSERT(rpCursor != nullptr || rpCursor == pEnd);
+
+    const char* pBegin = rpCursor;
+    const char* pIt = rpCursor;
+
+    u64 mantissa = 0;  // Significant digits
+    u32 digits = 0;    // Number of significant digits
+    s32 exponent = 0;  // Decimal exponent
+    bool exact = true; // Whether all digits fit in the mantissa
+
+    /**
+     * Number = '-'? Integer Fraction? Exponent?
+     */
+    bool negative = pIt < pEnd && *pIt == '-';
+    if (negative) {
+        pIt++;
+    }
+
+    /**
+     * Integer = '0' | (OneNine Digits?)
+     */
+    if (pIt >= pEnd || !IsDigit(*pIt)) {
+        return false;
+    }
+
+    if (*pIt == '0') {
+        pIt++;
+    } else {
+        for (; pIt < pEnd && IsDigit(*pIt); pIt++) {
+            if (digits < scMaxDigits) {
+                mantissa = mantissa * 10 + (*pIt - '0');
+                digits++;
+            } else {
+                // Digit doesn't fit, but it still scales the number
+                exponent++;
+                exact = false;
+            }
+        }
+    }
+
+    /**
+     * Fraction = '.' Digits
+     */
+    if (pIt < pEnd && *pIt == '.') {
+        pIt++;
+
+        // Trailing decimal point
+        if (pIt >= pEnd || !IsDigit(*pIt)) {
+            return false;
+        }
+
+        for (; pIt < pEnd && IsDigit(*pIt); pIt++) {
+            if (digits < scMaxDigits) {
+                mantissa = mantissa * 10 + (*pIt - '0');
+                exponent--;
+
+                // Leading zeros aren't significant
+                if (mantissa != 0) {
+                    digits++;
+                }
+            } else {
+                exact = false;
+            }
+        }
+    }
+
+    /**
+     * Exponent = ('e' | 'E') ('-' | '+')? Digits
+     */
+    if (pIt < pEnd && (*pIt == 'e' || *pIt == 'E')) {
+        pIt++;
+
+        bool negExp = false;
+        if (pIt < pEnd && (*pIt == '-' || *pIt == '+')) {
+            negExp = *pIt == '-';
+            pIt++;
+        }
+
+        // Need at least one digit
+        if (pIt >= pEnd || !IsDigit(*pIt)) {
+            return false;
+        }
+
+        s32 value = 0;
+        for (; pIt < pEnd && IsDigit(*pIt); pIt++) {
+            // Anything this large is already infinity/zero
+            if (value < 10000) {
+                value = value * 10 + (*pIt - '0');
+            }
+        }
+
+        exponent += negExp ? -value : value;
+    }
+
+    rpCursor = pIt;
+
+    // Fast path: both the mantissa and the power of ten are exact
+    if (exact && mantissa <= scMaxExactInt && exponent >= -22 &&
+        exponent <= 22) {
+        f64 number = static_cast<f64>(mantissa);
+
+        number = exponent >= 0 ? number * scPow10[exponent]
+                               : number / scPow10[-exponent];
+
+        rNumber = negative ? -number : number;
+        return true;
+    }
+
+    // Slow path: let the C library round correctly
+    u32 len = pIt - pBegin;
+    if (len < scMaxNumberLength) {
+        char buffer[scMaxNumberLength];
+        std::memcpy(buffer, pBegin, len);
+        buffer[len] = '\0';
+
+        rNumber = std::atof(buffer);
+    } else {
+        rNumber = std::atof(String(pBegin, len));
+    }
+
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief Returned by failed lookups
+ */
+const Value Value::scUndefined;
+
+/**
+ * @brief Accesses a member of this object by name
+ * @details Returns an undefined value if the member doesn't exist, so
+ * lookups can be chained.
+ *
+ * @param rKey Member name
+ */
+const Value& Value::operator[](const StringView& rKey) const {
+    const Value* pValue = Find(rKey);
+    return pValue != nullptr ? *pValue : scUndefined;
+}
+
+/**
+ * @brief Looks for a member of this object by name
+ *
+ * @param rKey Member name
+ * @return Member value if it exists
+ */
+const Value* Value::Find(const StringView& rKey) const {
+    if (mType != Element::EType_Object) {
+        return nullptr;
+    }
+
+    // Search backwards so duplicate names behave like Reader (last one wins)
+    for (u32 i = mSize; i > 0; i--) {
+        if (mpChildren[i - 1].GetKey() == rKey) {
+            return &mpChildren[i - 1];
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Copies this value into a (heap-allocated) element tree
+ *
+ * @param[out] rElement Destination element
+ */
+void Value::ToElement(Element& rElement) const {
+    switch (mType) {
+    case Element::EType_Number: {
+        rElement.Set(mNumber);
+        break;
+    }
+
+    case Element::EType_String: {
+        rElement.Set(String(GetString()));
+        break;
+    }
+
+    case Element::EType_Boolean: {
+        rElement.Set(mBoolean);
+        break;
+    }
+
+    case Element::EType_Array: {
+        rElement.Set(Array());
+        rElement.Get<Array>().Reserve(mSize);
+
+        for (u32 i = 0; i < mSize; i++) {
+            Element child;
+            mpChildren[i].ToElement(child);
+            rElement.Get<Array>().PushBack(child);
+        }
+        break;
+    }
+
+    case Element::EType_Object: {
+        rElement.Set(Object());
+        rElement.Get<Object>().Reserve(mSize);
+
+        for (u32 i = 0; i < mSize; i++) {
+            Element child;
+            mpChildren[i].ToElement(child);
+            rElement.Get<Object>().Insert(String(mpChildren[i].GetKey()),
+                                          child);
+        }
+        break;
+    }
+
+    case Element::EType_Null: {
+        rElement.Set(json::null);
+        break;
+    }
+
+    default: {
+        rElement.Clear();
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Parses JSON data (UTF-8)
+ *
+ * @param pData JSON data buffer
+ * @param size Data size
+ * @return Success
+ */
+bool Document::Parse(const void* pData, u32 size) {
+    K_ASSERT(pData != nullptr || size == 0);
+
+    // Remove previous data
+    Clear();
+
+    mpCursor = static_cast<const char*>(pData);
+    mpEnd = mpCursor + size;
+
+    // Skip UTF-8 byte order mark
+    if (size >= 3 && std::memcmp(mpCursor, "\xEF\xBB\xBF", 3) == 0) {
+        mpCursor += 3;
+    }
+
+    // JSON must begin with a value
+    ParseWhiteSpace();
+    bool success = ParseValue(mRoot, 0);
+    ParseWhiteSpace();
+
+    // Something else is incorrectly written after the root value
+    if (mpCursor != mpEnd) {
+        success = false;
+    }
+
+    mStack.Clear();
+    mpCursor = mpEnd = nullptr;
+
+    if (!success) {
+        Clear();
+    }
+
+    return success;
+}
+
+/**
+ * @brief Frees all values
+ */
+void Document::Clear() {
+    // Whole arena is released at once
+    while (mpChunkHead != nullptr) {
+        Chunk* pNext = mpChunkHead->pNext;
+        delete[] reinterpret_cast<u8*>(mpChunkHead);
+        mpChunkHead = pNext;
+    }
+
+    mArenaSize = 0;
+
+    mStack.Clear();
+    mRoot = Value();
+}
+
+/**
+ * @brief Allocates memory from the arena
+ *
+ * @param size Block size
+ * @param align Block alignment
+ */
+void* Document::Alloc(u32 size, u32 align) {
+    K_ASSERT(align > 0 && (align & (align - 1)) == 0);
+
+    // Try to fit the block in the current chunk
+    if (mpChunkHead != nullptr) {
+        u32 offset = ROUND_UP(mpChunkHead->used, align);
+
+        if (offset + size <= mpChunkHead->size) {
+            mpChunkHead->used = offset + size;
+            return AddToPtr(mpChunkHead, offset);
+        }
+    }
+
+    // Chunks at least double in size, so large documents need few of them
+    u32 chunkSize =
+        mpChunkHead != nullptr ? mpChunkHead->size * 2 : scMinChunkSize;
+
+    // Chunk header is followed by the aligned block
+    u32 offset = ROUND_UP(sizeof(Chunk), align);
+    chunkSize = Max(chunkSize, offset + size);
+
+    Chunk* pChunk = reinterpret_cast<Chunk*>(new (32, mRegion) u8[chunkSize]);
+    K_ASSERT(pChunk != nullptr);
+
+    pChunk->pNext = mpChunkHead;
+    pChunk->size = chunkSize;
+    pChunk->used = offset + size;
+
+    mpChunkHead = pChunk;
+    mArenaSize += chunkSize;
+
+    return AddToPtr(pChunk, offset);
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Value'
+ *
+ * @param[out] rValue Destination value
+ * @param depth Nesting depth
+ * @return Success
+ */
+bool Document::ParseValue(Value& rValue, u32 depth) {
+    // Prevent buffer overrun
+    if (mpCursor >= mpEnd) {
+        return false;
+    }
+
+    /**
+     * Value = "false" | "null" | "true" | Object | Array | Number | String
+     */
+    switch (*mpCursor) {
+    case '{': {
+        return ParseObject(rValue, depth);
+    }
+
+    case '[': {
+        return ParseArray(rValue, depth);
+    }
+
+    case '\"': {
+        rValue.mType = Element::EType_String;
+        return ParseString(rValue.mpString, rValue.mSize);
+    }
+
+    case 't': {
+        rValue.mType = Element::EType_Boolean;
+        rValue.mBoolean = true;
+        return ParseLiteral("true", sizeof("true") - 1);
+    }
+
+    case 'f': {
+        rValue.mType = Element::EType_Boolean;
+        rValue.mBoolean = false;
+        return ParseLiteral("false", sizeof("false") - 1);
+    }
+
+    case 'n': {
+        rValue.mType = Element::EType_Null;
+        return ParseLiteral("null", sizeof("null") - 1);
+    }
+
+    default: {
+        rValue.mType = Element::EType_Number;
+        return ParseNumber(rValue.mNumber);
+    }
+    }
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Object'
+ *
+ * @param[out] rValue Destination value
+ * @param depth Nesting depth
+ * @return Success
+ */
+bool Document::ParseObject(Value& rValue, u32 depth) {
+    K_ASSERT(mpCursor < mpEnd && *mpCursor == '{');
+
+    // Don't let malicious input overflow the stack
+    if (depth >= scMaxDepth) {
+        return false;
+    }
+
+    /**
+     * Object = '{' WhiteSpace? (Member (',' Member)*)? '}'
+     * Member = WhiteSpace? String WhiteSpace? ':' WhiteSpace? Value WhiteSpace?
+     */
+    mpCursor++;
+    rValue.mType = Element::EType_Object;
+
+    // Members are collected on the stack until the object is complete
+    u32 base = mStack.Size();
+
+    ParseWhiteSpace();
+    if (ParseLiteral("}", 1)) {
+        CommitChildren(rValue, base);
+        return true;
+    }
+
+    while (true) {
+        Value member;
+
+        ParseWhiteSpace();
+        if (!ParseString(member.mpKey, member.mKeyLength)) {
+            return false;
+        }
+
+        ParseWhiteSpace();
+        if (!ParseLiteral(":", 1)) {
+            return false;
+        }
+
+        ParseWhiteSpace();
+        if (!ParseValue(member, depth + 1)) {
+            return false;
+        }
+
+        mStack.PushBack(member);
+
+        ParseWhiteSpace();
+        if (ParseLiteral(",", 1)) {
+            continue;
+        }
+
+        if (ParseLiteral("}", 1)) {
+            break;
+        }
+
+        // Missing ending bracket
+        return false;
+    }
+
+    CommitChildren(rValue, base);
+    return true;
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Array'
+ *
+ * @param[out] rValue Destination value
+ * @param depth Nesting depth
+ * @return Success
+ */
+bool Document::ParseArray(Value& rValue, u32 depth) {
+    K_ASSERT(mpCursor < mpEnd && *mpCursor == '[');
+
+    // Don't let malicious input overflow the stack
+    if (depth >= scMaxDepth) {
+        return false;
+    }
+
+    /**
+     * Array = '[' WhiteSpace? (Element (',' Element)*)? ']'
+     * Element = WhiteSpace? Value WhiteSpace?
+     */
+    mpCursor++;
+    rValue.mType = Element::EType_Array;
+
+    // Elements are collected on the stack until the array is complete
+    u32 base = mStack.Size();
+
+    ParseWhiteSpace();
+    if (ParseLiteral("]", 1)) {
+        CommitChildren(rValue, base);
+        return true;
+    }
+
+    while (true) {
+        Value element;
+
+        ParseWhiteSpace();
+        if (!ParseValue(element, depth + 1)) {
+            return false;
+        }
+
+        mStack.PushBack(element);
+
+        ParseWhiteSpace();
+        if (ParseLiteral(",", 1)) {
+            continue;
+        }
+
+        if (ParseLiteral("]", 1)) {
+            break;
+        }
+
+        // Missing ending bracket
+        return false;
+    }
+
+    CommitChildren(rValue, base);
+    return true;
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'String'
+ * @details Strings without escape sequences reference the input buffer.
+ * Otherwise, the decoded string is written to the arena.
+ *
+ * @param[out] rpString Destination string
+ * @param[out] rLength Destination string length
+ * @return Success
+ */
+bool Document::ParseString(const char*& rpString, u32& rLength) {
+    /**
+     * String = '"' Characters? '"'
+     */
+    if (!ParseLiteral("\"", 1)) {
+        return false;
+    }
+
+    const char* pBegin = mpCursor;
+    const char* pEnd = mpCursor;
+    bool escaped = false;
+
+    // Find the closing quote
+    for (; pEnd < mpEnd; pEnd++) {
+        u8 ch = *pEnd;
+
+        if (ch == '\"') {
+            break;
+        }
+
+        // Control characters must be escaped
+        if (ch < 0x20) {
+            return false;
+        }
+
+        // Skip the escaped character (it may be a quote)
+        if (ch == '\\') {
+            escaped = true;
+            pEnd++;
+        }
+    }
+
+    // Missing closing quote
+    if (pEnd >= mpEnd) {
+        return false;
+    }
+
+    mpCursor = pEnd + 1;
+
+    // No need to copy the string
+    if (!escaped) {
+        rpString = pBegin;
+        rLength = pEnd - pBegin;
+        return true;
+    }
+
+    // Decoded string is never longer than the escaped string
+    char* pDst = static_cast<char*>(Alloc(pEnd - pBegin, 1));
+    u32 len = 0;
+
+    for (const char* pIt = pBegin; pIt < pEnd;) {
+        if (*pIt != '\\') {
+            pDst[len++] = *pIt++;
+            continue;
+        }
+
+        // Skip backslash (closing quote guarantees another character)
+        pIt++;
+
+        /**
+         * Escaped = '\' ('"' | '\' | '/' | 'b' | 'f' | 'n' | 'r' | 't'
+         *                | ('u' Hex{4}))
+         */
+        switch (*pIt++) {
+        case '\"': pDst[len++] = '\"'; break;
+        case '\\': pDst[len++] = '\\'; break;
+        case '/':  pDst[len++] = '/';  break;
+        case 'b':  pDst[len++] = '\b'; break;
+        case 'f':  pDst[len++] = '\f'; break;
+        case 'n':  pDst[len++] = '\n'; break;
+        case 'r':  pDst[len++] = '\r'; break;
+        case 't':  pDst[len++] = '\t'; break;
+
+        case 'u': {
+            u32 code;
+            if (pEnd - pIt < 4 || !detail::ParseHex4(pIt, code)) {
+                return false;
+            }
+
+            pIt += 4;
+
+            // Characters outside the BMP are written as surrogate pairs
+            if (code >= 0xD800 && code <= 0xDBFF && pEnd - pIt >= 6 &&
+                pIt[0] == '\\' && pIt[1] == 'u') {
+                u32 low;
+                if (detail::ParseHex4(pIt + 2, low) && low >= 0xDC00 &&
+                    low <= 0xDFFF) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    pIt += 6;
+                }
+            }
+
+            len += detail::EncodeUTF8(code, pDst + len);
+            break;
+        }
+
+        default: {
+            // Invalid escape sequence
+            return false;
+        }
+        }
+    }
+
+    rpString = pDst;
+    rLength = len;
+    return true;
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Number'
+ *
+ * @param[out] rNumber Destination number
+ * @return Success
+ */
+bool Document::ParseNumber(f64& rNumber) {
+    return detail::ParseNumber(mpCursor, mpEnd, rNumber);
+}
+
+/**
+ * @brief Attempts to parse a literal sequence
+ *
+ * @param pLiteral Literal sequence
+ * @param len Literal length
+ * @return Success
+ */
+bool Document::ParseLiteral(const char* pLiteral, u32 len) {
+    K_ASSERT(pLiteral != nullptr);
+
+    // Prevent buffer overrun
+    if (static_cast<u32>(mpEnd - mpCursor) < len) {
+        return false;
+    }
+
+    if (std::memcmp(mpCursor, pLiteral, len) != 0) {
+        return false;
+    }
+
+    mpCursor += len;
+    return true;
+}
+
+/**
+ * @brief Skips the JSON grammar structure 'WhiteSpace'
+ */
+void Document::ParseWhiteSpace() {
+    /**
+     * WhiteSpace = (' ' | '\t' | '\n' | '\r')*
+     */
+    while (mpCursor < mpEnd) {
+        char ch = *mpCursor;
+
+        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r') {
+            break;
+        }
+
+        mpCursor++;
+    }
+}
+
+/**
+ * @brief Moves parsed children from the stack into the arena
+ *
+ * @param[out] rValue Parent array/object
+ * @param base Stack index of the first child
+ */
+void Document::CommitChildren(Value& rValue, u32 base) {
+    K_ASSERT(base <= mStack.Size());
+
+    u32 num = mStack.Size() - base;
+
+    rValue.mSize = num;
+    rValue.mpChildren = nullptr;
+
+    if (num == 0) {
+        return;
+    }
+
+    // Children are stored contiguously for constant-time indexing
+    rValue.mpChildren = static_cast<Value*>(Alloc(num * sizeof(Value), 8));
+    std::memcpy(rValue.mpChildren, mStack.Data() + base, num * sizeof(Value));
+
+    while (mStack.Size() > base) {
+        mStack.PopBack();
+    }
+}
+
+} // namespace json
+} // namespace kiwi
@@ -0,0 +1,328 @@
+#ifndef LIBKIWI_CORE_JSON_DOCUMENT_H
+#define LIBKIWI_CORE_JSON_DOCUMENT_H
+#include <libkiwi/core/kiwiJSON.h>
+#include <libkiwi/core/kiwiMemoryMgr.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/prim/kiwiStringView.h>
+#include <libkiwi/prim/kiwiVector.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+namespace json {
+//! @addtogroup libkiwi_core
+//! @{
+
+namespace detail {
+
+/**
+ * @name Grammar helpers
+ * @brief Shared by the JSON parsers
+ */
+/**@{*/
+/**
+ * @brief Parses four hexadecimal digits (unicode escape sequence)
+ *
+ * @param pStr Hex digits
+ * @param[out] rCode Character code
+ * @return Success
+ */
+bool ParseHex4(const char* pStr, u32& rCode);
+
+/**
+ * @brief Encodes a unicode code point as UTF-8
+ *
+ * @param code Code point
+ * @param[out] pDst Destination buffer (at least four bytes)
+ * @return Number of bytes written
+ */
+u32 EncodeUTF8(u32 code, char* pDst);
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Number'
+ *
+ * @param[in, out] rpCursor Parser position
+ * @param pEnd End of input data
+ * @param[out] rNumber Destination number
+ * @return Success
+ */
+bool ParseNumber(const char*& rpCursor, const char* pEnd, f64& rNumber);
+/**@}*/
+
+} // namespace detail
+
+/**
+ * @brief Read-only JSON value owned by a Document
+ * @details Strings view the document's input buffer where possible, and
+ * array/object children are stored contiguously in the document's arena.
+ */
+class Value {
+    friend class Document;
+
+public:
+    /**
+     * @brief Constructor
+     * @note Value is undefined (has no contents) by default
+     */
+    Value()
+        : mType(Element::EType_Undefined),
+          mSize(0),
+          mpKey(nullptr),
+          mKeyLength(0),
+          mpChildren(nullptr) {}
+
+    /**
+     * @brief Accesses this value's type
+     */
+    Element::EType GetType() const {
+        return mType;
+    }
+
+    /**
+     * @brief Tests whether the value is null
+     */
+    bool IsNull() const {
+        return mType == Element::EType_Null;
+    }
+
+    /**
+     * @brief Tests whether the value contains valid data
+     */
+    bool IsValid() const {
+        return !IsUndefined();
+    }
+    /**
+     * @brief Tests whether the value is undefined (has no contents)
+     */
+    bool IsUndefined() const {
+        return mType == Element::EType_Undefined;
+    }
+
+    /**
+     * @brief Accesses this value's number
+     */
+    f64 GetNumber() const {
+        K_ASSERT(mType == Element::EType_Number);
+        return mNumber;
+    }
+
+    /**
+     * @brief Accesses this value's boolean
+     */
+    bool GetBoolean() const {
+        K_ASSERT(mType == Element::EType_Boolean);
+        return mBoolean;
+    }
+
+    /**
+     * @brief Accesses this value's string
+     * @note Not null-terminated
+     */
+    StringView GetString() const {
+        K_ASSERT(mType == Element::EType_String);
+        return StringView(mpString, mSize);
+    }
+
+    /**
+     * @brief Accesses this value's member name
+     * @note Only values inside objects have names
+     */
+    StringView GetKey() const {
+        return StringView(mpKey, mKeyLength);
+    }
+
+    /**
+     * @brief Gets the number of children in this array/object
+     */
+    u32 Size() const {
+        K_ASSERT(mType == Element::EType_Array ||
+                 mType == Element::EType_Object);
+        return mSize;
+    }
+
+    /**
+     * @brief Accesses a child of this array/object by index
+     *
+     * @param i Child index
+     */
+    const Value& operator[](u32 i) const {
+        K_ASSERT(i < Size());
+        return mpChildren[i];
+    }
+
+    /**
+     * @brief Accesses a member of this object by name
+     * @details Returns an undefined value if the member doesn't exist, so
+     * lookups can be chained.
+     *
+     * @param rKey Member name
+     */
+    const Value& operator[](const StringView& rKey) const;
+
+    /**
+     * @brief Looks for a member of this object by name
+     *
+     * @param rKey Member name
+     * @return Member value if it exists
+     */
+    const Value* Find(const StringView& rKey) const;
+
+    /**
+     * @brief Copies this value into a (heap-allocated) element tree
+     *
+     * @param[out] rElement Destination element
+     */
+    void ToElement(Element& rElement) const;
+
+private:
+    //! Returned by failed lookups
+    static const Value scUndefined;
+
+    Element::EType mType; // Value type
+    u32 mSize;            // String length or number of children
+
+    const char* mpKey; // Member name (objects only)
+    u32 mKeyLength;    // Member name length
+
+    union {
+        f64 mNumber;          // Double-precision float
+        bool mBoolean;        // Boolean value
+        const char* mpString; // Character sequence (not null-terminated)
+        Value* mpChildren;    // Array elements or object members
+    };
+};
+
+/**
+ * @brief Arena-backed JSON document
+ * @details Zero-copy alternative to Reader. All values and decoded strings
+ * are allocated from one arena which is freed in one shot. Strings without
+ * escape sequences reference the input buffer directly, and numbers are
+ * parsed straight from the input bytes.
+ * @note The input buffer must outlive the document
+ */
+class Document : private NonCopyable {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param region Memory region for the arena
+     */
+    explicit Document(EMemory region = EMemory_MEM2)
+        : mRegion(region),
+          mpChunkHead(nullptr),
+          mArenaSize(0),
+          mpCursor(nullptr),
+          mpEnd(nullptr) {}
+
+    /**
+     * @brief Destructor
+     */
+    ~Document() {
+        Clear();
+    }
+
+    /**
+     * @brief Parses a JSON string (UTF-8)
+     *
+     * @param rStr JSON string
+     * @return Success
+     */
+    bool Parse(const String& rStr) {
+        return Parse(rStr.CStr(), rStr.Length());
+    }
+    /**
+     * @brief Parses JSON data (UTF-8)
+     *
+     * @param pData JSON data buffer
+     * @param size Data size
+     * @return Success
+     */
+    bool Parse(const void* pData, u32 size);
+
+    /**
+     * @brief Frees all values
+     */
+    void Clear();
+
+    /**
+     * @brief Gets the root value
+     */
+    const Value& Get() const {
+        return mRoot;
+    }
+
+    /**
+     * @brief Gets the total size of the arena memory
+     */
+    u32 GetArenaSize() const {
+        return mArenaSize;
+    }
+
+private:
+    /**
+     * @brief Arena memory chunk
+     */
+    struct Chunk {
+        Chunk* pNext; // Next chunk in the arena
+        u32 size;     // Chunk size (including header)
+        u32 used;     // Number of bytes used (including header)
+    };
+
+    //! Smallest chunk allocated for the arena
+    static const u32 scMinChunkSize = OS_MEM_KB_TO_B(4);
+    //! Deepest supported array/object nesting
+    static const u32 scMaxDepth = 128;
+
+private:
+    /**
+     * @brief Allocates memory from the arena
+     *
+     * @param size Block size
+     * @param align Block alignment
+     */
+    void* Alloc(u32 size, u32 align);
+
+    /**
+     * @name Grammar functions
+     */
+    /**@{*/
+    bool ParseValue(Value& rValue, u32 depth);
+    bool ParseObject(Value& rValue, u32 depth);
+    bool ParseArray(Value& rValue, u32 depth);
+    bool ParseString(const char*& rpString, u32& rLength);
+    bool ParseNumber(f64& rNumber);
+    bool ParseLiteral(const char* pLiteral, u32 len);
+    void ParseWhiteSpace();
+    /**@}*/
+
+    /**
+     * @brief Moves parsed children from the stack into the arena
+     *
+     * @param[out] rValue Parent array/object
+     * @param base Stack index of the first child
+     */
+    void CommitChildren(Value& rValue, u32 base);
+
+private:
+    EMemory mRegion;    // Arena memory region
+    Chunk* mpChunkHead; // Most recent arena chunk
+    u32 mArenaSize;     // Total arena size
+
+    const char* mpCursor; // Parser position
+    const char* mpEnd;    // End of input data
+
+    TVector<Value> mStack; // Children of unfinished arrays/objects
+    Value mRoot;           // Document root
+};
+
+//! @}
+} // namespace json
+
+// Values are plain data, so they can be moved byte-wise
+K_TRIVIALLY_RELOCATABLE(json::Value)
+
+//! @}
+} // namespace kiwi
+
+#endif
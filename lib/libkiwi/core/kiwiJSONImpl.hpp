@@ -184,6 +184,52 @@ template <typename T> K_INLINE void Element::Set(const T& rValue) {
 }
 /**@}*/
 
+/**
+ * @name Value constructors
+ */
+/**@{*/
+// clang-format off
+K_INLINE Element::Element(f64 x)           { Set<f64>(x);    }
+K_INLINE Element::Element(s64 x)           { Set<s64>(x);    }
+K_INLINE Element::Element(bool x)          { Set<bool>(x);   }
+K_INLINE Element::Element(const String& x) { Set<String>(x); }
+K_INLINE Element::Element(const Array& x)  { Set<Array>(x);  }
+K_INLINE Element::Element(const Object& x) { Set<Object>(x); }
+K_INLINE Element::Element(Null_t x)        { Set<Null_t>(x); }
+// clang-format on
+/**@}*/
+
+/**
+ * @name Array access
+ */
+/**@{*/
+K_INLINE Element& Element::operator[](int i) {
+    K_ASSERT(mType == EType_Array);
+    return Get<Array>()[i];
+}
+K_INLINE const Element& Element::operator[](int i) const {
+    K_ASSERT(mType == EType_Array);
+    return Get<Array>()[i];
+}
+/**@}*/
+
+/**
+ * @name Object access
+ */
+/**@{*/
+K_INLINE Element& Element::operator[](const String& rKey) {
+    K_ASSERT(mType == EType_Object);
+    return Get<Object>()[rKey];
+}
+K_INLINE const Element& Element::operator[](const String& rKey) const {
+    K_ASSERT(mType == EType_Object);
+    const Element* pElement = Get<Object>().Find(rKey);
+
+    K_ASSERT(pElement != nullptr);
+    return *pElement;
+}
+/**@}*/
+
 } // namespace json
 } // namespace kiwi
 
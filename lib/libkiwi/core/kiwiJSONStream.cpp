@@ -0,0 +1,1024 @@
+#include <libkiwi.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace kiwi {
+namespace json {
+
+/**
+ * @name Serializable interface
+ */
+/**@{*/
+/**
+ * @brief Encodes this object directly into a JSON stream
+ * @details Override this to skip building an element tree. By default,
+ * the object is serialized into an element which is then written.
+ *
+ * @param rWriter JSON stream writer
+ */
+void ISerializable::Encode(StreamWriter& rWriter) const {
+    Element elem;
+    Serialize(elem);
+
+    rWriter.WriteElement(elem);
+}
+
+/**
+ * @brief Decodes a JSON stream into this object
+ * @details Override this to skip building an element tree (e.g. by
+ * parsing with a custom event handler). By default, the stream is read
+ * into an element which is then deserialized.
+ *
+ * @param rReader JSON stream reader
+ * @return Success
+ */
+bool ISerializable::Decode(StreamReader& rReader) {
+    ElementBuilder builder;
+
+    if (!rReader.Parse(builder)) {
+        return false;
+    }
+
+    return Deserialize(builder.Get());
+}
+/**@}*/
+
+/**
+ * @name JSON stream reader
+ */
+/**@{*/
+/**
+ * @brief Constructor
+ *
+ * @param rStrm Source stream
+ * @param size Number of bytes available from the stream's position (if
+ * known). Required for file streams, which can't read past the end.
+ * @param bufferSize Size of the read buffer
+ */
+StreamReader::StreamReader(IStream& rStrm, u32 size, u32 bufferSize)
+    : mrStream(rStrm),
+      mRemaining(size),
+      mpBuffer(nullptr),
+      mBufferSize(ROUND_UP(bufferSize, rStrm.GetSizeAlign())),
+      mpCursor(nullptr),
+      mpEnd(nullptr) {
+    K_ASSERT_EX(rStrm.CanRead(), "Stream does not support reading");
+    K_ASSERT(mBufferSize > 0);
+
+    mpBuffer = new (rStrm.GetBufferAlign()) char[mBufferSize];
+    K_ASSERT(mpBuffer != nullptr);
+}
+
+/**
+ * @brief Destructor
+ */
+StreamReader::~StreamReader() {
+    delete[] mpBuffer;
+    mpBuffer = nullptr;
+}
+
+/**
+ * @brief Parses the stream's JSON data (UTF-8)
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::Parse(IHandler& rHandler) {
+    K_ASSERT_EX(mrStream.IsOpen(), "Stream is not available");
+
+    mStack.Clear();
+
+    // Skip UTF-8 byte order mark
+    if (Peek() == 0xEF && !ParseLiteral("\xEF\xBB\xBF")) {
+        return false;
+    }
+
+    // Nesting is tracked by the stack rather than by recursion
+    while (true) {
+        ParseWhiteSpace();
+        s32 c = Peek();
+
+        if (c == '{' || c == '[') {
+            if (!ParseContainer(rHandler)) {
+                return false;
+            }
+
+            // The first value of a non-empty container comes next
+            ParseWhiteSpace();
+            if (Peek() != (c == '{' ? '}' : ']')) {
+                if (c == '{' && !ParseMember(rHandler)) {
+                    return false;
+                }
+
+                continue;
+            }
+        } else if (!ParseScalar(rHandler)) {
+            return false;
+        }
+
+        // Close finished containers and move on to the next value
+        if (!ParseNext(rHandler)) {
+            return false;
+        }
+
+        // Root value is complete
+        if (mStack.Empty()) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Refills the read buffer once it has been consumed
+ * @return Whether any data is available
+ */
+bool StreamReader::Fill() {
+    if (mpCursor < mpEnd) {
+        return true;
+    }
+
+    if (mRemaining == 0 || mrStream.IsEOF()) {
+        return false;
+    }
+
+    // Don't read past the end of the data (if the size is known)
+    u32 size = mBufferSize;
+    if (mRemaining != scUnknownSize) {
+        size = Min(size, ROUND_UP(mRemaining, mrStream.GetSizeAlign()));
+    }
+
+    s32 n = mrStream.Read(mpBuffer, size);
+    if (n <= 0) {
+        return false;
+    }
+
+    // Aligned reads may return padding after the data
+    u32 valid = n;
+    if (mRemaining != scUnknownSize) {
+        valid = Min(valid, mRemaining);
+        mRemaining -= valid;
+    }
+
+    mpCursor = mpBuffer;
+    mpEnd = mpBuffer + valid;
+
+    return valid > 0;
+}
+
+/**
+ * @brief Attempts to parse the opening of an 'Object' or 'Array'
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::ParseContainer(IHandler& rHandler) {
+    // Don't let malicious input use up all the memory
+    if (mStack.Size() >= scMaxDepth) {
+        return false;
+    }
+
+    s32 c = Next();
+    mStack.PushBack(static_cast<char>(c));
+
+    return c == '{' ? rHandler.OnBeginObject() : rHandler.OnBeginArray();
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structures 'String', 'Number',
+ * "true", "false", or "null"
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::ParseScalar(IHandler& rHandler) {
+    switch (Peek()) {
+    case '\"': {
+        return ParseString() && rHandler.OnString(mToken);
+    }
+
+    case 't': {
+        return ParseLiteral("true") && rHandler.OnBoolean(true);
+    }
+
+    case 'f': {
+        return ParseLiteral("false") && rHandler.OnBoolean(false);
+    }
+
+    case 'n': {
+        return ParseLiteral("null") && rHandler.OnNull();
+    }
+
+    default: {
+        return ParseNumber(rHandler);
+    }
+    }
+}
+
+/**
+ * @brief Attempts to parse the separators/brackets after a value
+ * @details Finished containers are closed until the next value (or the end
+ * of the root value) is reached.
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::ParseNext(IHandler& rHandler) {
+    while (!mStack.Empty()) {
+        ParseWhiteSpace();
+
+        char type = mStack[mStack.Size() - 1];
+        s32 c = Next();
+
+        // Another value follows
+        if (c == ',') {
+            return type == '{' ? ParseMember(rHandler) : true;
+        }
+
+        if (type == '{' && c == '}') {
+            mStack.PopBack();
+
+            if (!rHandler.OnEndObject()) {
+                return false;
+            }
+
+            continue;
+        }
+
+        if (type == '[' && c == ']') {
+            mStack.PopBack();
+
+            if (!rHandler.OnEndArray()) {
+                return false;
+            }
+
+            continue;
+        }
+
+        // Missing separator or mismatched bracket
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Attempts to parse the name of the JSON grammar structure 'Member'
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::ParseMember(IHandler& rHandler) {
+    /**
+     * Member = WhiteSpace? String WhiteSpace? ':' Element
+     */
+    ParseWhiteSpace();
+    if (Peek() != '\"' || !ParseString()) {
+        return false;
+    }
+
+    if (!rHandler.OnKey(mToken)) {
+        return false;
+    }
+
+    ParseWhiteSpace();
+    return Next() == ':';
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'String'
+ * @details The decoded string is written to the current token
+ *
+ * @return Success
+ */
+bool StreamReader::ParseString() {
+    if (Next() != '\"') {
+        return false;
+    }
+
+    mToken.Clear();
+
+    while (Fill()) {
+        // Copy unescaped characters in bulk
+        const char* pRun = mpCursor;
+        for (; mpCursor < mpEnd; mpCursor++) {
+            u8 ch = *mpCursor;
+
+            if (ch == '\"' || ch == '\\' || ch < 0x20) {
+                break;
+            }
+        }
+
+        mToken += StringView(pRun, mpCursor - pRun);
+
+        // Run continues in the next block
+        if (mpCursor >= mpEnd) {
+            continue;
+        }
+
+        s32 c = Next();
+
+        // End of string
+        if (c == '\"') {
+            return true;
+        }
+
+        // Control characters must be escaped
+        if (c != '\\' || !ParseEscaped(Next())) {
+            return false;
+        }
+    }
+
+    // Missing closing quote
+    return false;
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Escaped'
+ *
+ * @param c Character following the backslash
+ * @return Success
+ */
+bool StreamReader::ParseEscaped(s32 c) {
+    switch (c) {
+    case '\"': mToken += '\"'; return true;
+    case '\\': mToken += '\\'; return true;
+    case '/':  mToken += '/';  return true;
+    case 'b':  mToken += '\b'; return true;
+    case 'f':  mToken += '\f'; return true;
+    case 'n':  mToken += '\n'; return true;
+    case 'r':  mToken += '\r'; return true;
+    case 't':  mToken += '\t'; return true;
+
+    case 'u': {
+        u32 code;
+        if (!ParseHex(code)) {
+            return false;
+        }
+
+        // Characters outside the BMP are written as surrogate pairs
+        if (code >= 0xD800 && code <= 0xDBFF && Peek() == '\\') {
+            Next();
+
+            // Not a pair after all
+            s32 next = Next();
+            if (next != 'u') {
+                AppendUTF8(code);
+                return ParseEscaped(next);
+            }
+
+            u32 low;
+            if (!ParseHex(low)) {
+                return false;
+            }
+
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            } else {
+                AppendUTF8(code);
+                code = low;
+            }
+        }
+
+        AppendUTF8(code);
+        return true;
+    }
+
+    default: {
+        // Invalid escape sequence
+        return false;
+    }
+    }
+}
+
+/**
+ * @brief Attempts to parse four hexadecimal digits
+ *
+ * @param[out] rCode Character code
+ * @return Success
+ */
+bool StreamReader::ParseHex(u32& rCode) {
+    char hex[4];
+
+    for (int i = 0; i < K_LENGTHOF(hex); i++) {
+        s32 c = Next();
+        if (c == scEOF) {
+            return false;
+        }
+
+        hex[i] = static_cast<char>(c);
+    }
+
+    return detail::ParseHex4(hex, rCode);
+}
+
+/**
+ * @brief Attempts to parse the JSON grammar structure 'Number'
+ *
+ * @param rHandler Event handler
+ * @return Success
+ */
+bool StreamReader::ParseNumber(IHandler& rHandler) {
+    mToken.Clear();
+
+    // Collect everything that could be part of a number
+    for (s32 c = Peek(); c != scEOF; c = Peek()) {
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != '.' &&
+            c != 'e' && c != 'E') {
+            break;
+        }
+
+        mToken += static_cast<char>(c);
+        mpCursor++;
+    }
+
+    const char* pBegin = mToken.CStr();
+    const char* pEnd = pBegin + mToken.Length();
+
+    // Grammar is validated by the number parser
+    f64 number;
+    if (!detail::ParseNumber(pBegin, pEnd, number) || pBegin != pEnd) {
+        return false;
+    }
+
+    return rHandler.OnNumber(number);
+}
+
+/**
+ * @brief Attempts to parse a literal sequence
+ *
+ * @param pLiteral Literal sequence
+ * @return Success
+ */
+bool StreamReader::ParseLiteral(const char* pLiteral) {
+    K_ASSERT(pLiteral != nullptr);
+
+    for (; *pLiteral != '\0'; pLiteral++) {
+        if (Next() != static_cast<u8>(*pLiteral)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Skips the JSON grammar structure 'WhiteSpace'
+ */
+void StreamReader::ParseWhiteSpace() {
+    /**
+     * WhiteSpace = (' ' | '\t' | '\n' | '\r')*
+     */
+    for (s32 c = Peek(); c != scEOF; c = Peek()) {
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+
+        mpCursor++;
+    }
+}
+
+/**
+ * @brief Appends a unicode character to the current token
+ *
+ * @param code Code point
+ */
+void StreamReader::AppendUTF8(u32 code) {
+    char utf8[4];
+    u32 len = detail::EncodeUTF8(code, utf8);
+
+    mToken += StringView(utf8, len);
+}
+/**@}*/
+
+/**
+ * @name JSON stream writer
+ */
+/**@{*/
+/**
+ * @brief Constructor
+ *
+ * @param rStrm Destination stream
+ * @param pretty Whether to pretty-print
+ * @param bufferSize Size of the write buffer
+ */
+StreamWriter::StreamWriter(IStream& rStrm, bool pretty, u32 bufferSize)
+    : mrStream(rStrm),
+      mIsPretty(pretty),
+      mIsError(false),
+      mpBuffer(nullptr),
+      mBufferSize(ROUND_UP(bufferSize, rStrm.GetSizeAlign())),
+      mBufferPos(0),
+      mIsAfterKey(false) {
+    K_ASSERT_EX(rStrm.CanWrite(), "Stream does not support writing");
+    K_ASSERT(mBufferSize > 0);
+
+    mpBuffer = new (rStrm.GetBufferAlign()) char[mBufferSize];
+    K_ASSERT(mpBuffer != nullptr);
+}
+
+/**
+ * @brief Destructor
+ * @note Remaining buffered data is flushed
+ */
+StreamWriter::~StreamWriter() {
+    K_WARN_EX(!mStack.Empty(), "Unclosed array/object in JSON stream\n");
+
+    Flush();
+
+    delete[] mpBuffer;
+    mpBuffer = nullptr;
+}
+
+/**
+ * @brief Writes the opening of an object
+ * @return Success
+ */
+bool StreamWriter::BeginObject() {
+    BeginValue();
+    Put('{');
+
+    Scope scope;
+    scope.type = '{';
+    scope.empty = true;
+    mStack.PushBack(scope);
+
+    return !mIsError;
+}
+
+/**
+ * @brief Writes the closing of an object
+ * @return Success
+ */
+bool StreamWriter::EndObject() {
+    return EndScope('{', '}');
+}
+
+/**
+ * @brief Writes the opening of an array
+ * @return Success
+ */
+bool StreamWriter::BeginArray() {
+    BeginValue();
+    Put('[');
+
+    Scope scope;
+    scope.type = '[';
+    scope.empty = true;
+    mStack.PushBack(scope);
+
+    return !mIsError;
+}
+
+/**
+ * @brief Writes the closing of an array
+ * @return Success
+ */
+bool StreamWriter::EndArray() {
+    return EndScope('[', ']');
+}
+
+/**
+ * @brief Writes the name of the next object member
+ *
+ * @param rKey Member name
+ * @return Success
+ */
+bool StreamWriter::WriteKey(const StringView& rKey) {
+    K_ASSERT_EX(!mStack.Empty() && mStack[mStack.Size() - 1].type == '{',
+                "Keys can only be written inside objects");
+    K_ASSERT_EX(!mIsAfterKey, "Previous key has no value");
+
+    Scope& rScope = mStack[mStack.Size() - 1];
+
+    // Members are comma separated
+    if (!rScope.empty) {
+        Put(',');
+    }
+
+    rScope.empty = false;
+
+    PutIndent();
+    PutString(rKey);
+    Put(':');
+
+    if (mIsPretty) {
+        Put(' ');
+    }
+
+    mIsAfterKey = true;
+    return !mIsError;
+}
+
+/**
+ * @brief Writes a null value
+ * @return Success
+ */
+bool StreamWriter::WriteNull() {
+    BeginValue();
+    Put("null", sizeof("null") - 1);
+
+    return !mIsError;
+}
+
+/**
+ * @brief Writes a boolean value
+ *
+ * @param value Boolean value
+ * @return Success
+ */
+bool StreamWriter::WriteBoolean(bool value) {
+    BeginValue();
+
+    if (value) {
+        Put("true", sizeof("true") - 1);
+    } else {
+        Put("false", sizeof("false") - 1);
+    }
+
+    return !mIsError;
+}
+
+/**
+ * @brief Writes a number value
+ *
+ * @param value Number value
+ * @return Success
+ */
+bool StreamWriter::WriteNumber(f64 value) {
+    BeginValue();
+
+    // JSON can't represent NaN/infinity
+    if (value != value || value - value != 0.0) {
+        Put("null", sizeof("null") - 1);
+        return !mIsError;
+    }
+
+    // Use the shortest form which still reads back exactly
+    char buffer[32];
+    int len = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+
+    if (std::atof(buffer) != value) {
+        len = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+
+    Put(buffer, len);
+    return !mIsError;
+}
+
+/**
+ * @brief Writes a string value
+ *
+ * @param rValue String value
+ * @return Success
+ */
+bool StreamWriter::WriteString(const StringView& rValue) {
+    BeginValue();
+    PutString(rValue);
+
+    return !mIsError;
+}
+
+/**
+ * @brief Writes an element tree
+ *
+ * @param rElem JSON element
+ * @return Success
+ */
+bool StreamWriter::WriteElement(const Element& rElem) {
+    switch (rElem.GetType()) {
+    case Element::EType_Number: {
+        return WriteNumber(rElem.Get<f64>());
+    }
+
+    case Element::EType_String: {
+        return WriteString(rElem.Get<String>());
+    }
+
+    case Element::EType_Boolean: {
+        return WriteBoolean(rElem.Get<bool>());
+    }
+
+    case Element::EType_Array: {
+        const Array& rArray = rElem.Get<Array>();
+
+        BeginArray();
+
+        for (u32 i = 0; i < rArray.Size(); i++) {
+            WriteElement(rArray[i]);
+        }
+
+        return EndArray();
+    }
+
+    case Element::EType_Object: {
+        const Object& rObject = rElem.Get<Object>();
+
+        BeginObject();
+
+        for (Object::ConstIterator it = rObject.Begin(); it != rObject.End();
+             ++it) {
+            WriteKey(it.Key());
+            WriteElement(it.Value());
+        }
+
+        return EndObject();
+    }
+
+    // Undefined elements can't be represented in JSON
+    default: {
+        return WriteNull();
+    }
+    }
+}
+
+/**
+ * @brief Writes all buffered data to the stream
+ * @note The final block is padded with whitespace if the stream requires
+ * aligned sizes
+ *
+ * @return Success
+ */
+bool StreamWriter::Flush() {
+    FlushBuffer(true);
+    return !mIsError;
+}
+
+/**
+ * @brief Prepares to write a value (separators, indentation)
+ */
+void StreamWriter::BeginValue() {
+    // Member name already handled the separator
+    if (mIsAfterKey) {
+        mIsAfterKey = false;
+        return;
+    }
+
+    // Root value
+    if (mStack.Empty()) {
+        return;
+    }
+
+    Scope& rScope = mStack[mStack.Size() - 1];
+    K_ASSERT_EX(rScope.type == '[', "Object members require a key");
+
+    // Values are comma separated
+    if (!rScope.empty) {
+        Put(',');
+    }
+
+    rScope.empty = false;
+    PutIndent();
+}
+
+/**
+ * @brief Closes the innermost array/object
+ *
+ * @param type Opening bracket
+ * @param close Closing bracket
+ */
+bool StreamWriter::EndScope(char type, char close) {
+    K_ASSERT_EX(!mStack.Empty() && mStack[mStack.Size() - 1].type == type,
+                "Mismatched '%c'", close);
+    K_ASSERT_EX(!mIsAfterKey, "Previous key has no value");
+
+    bool empty = mStack[mStack.Size() - 1].empty;
+    mStack.PopBack();
+
+    // Closing bracket lines up with the opening line
+    if (!empty) {
+        PutIndent();
+    }
+
+    Put(close);
+    return !mIsError;
+}
+
+/**
+ * @brief Writes a line break and indentation (pretty-print only)
+ */
+void StreamWriter::PutIndent() {
+    if (!mIsPretty) {
+        return;
+    }
+
+    Put('\n');
+
+    for (u32 i = 0; i < mStack.Size() * scIndentWidth; i++) {
+        Put(' ');
+    }
+}
+
+/**
+ * @brief Writes an escaped, quoted string
+ *
+ * @param rStr String contents
+ */
+void StreamWriter::PutString(const StringView& rStr) {
+    static const char* scHexDigits = "0123456789abcdef";
+
+    Put('\"');
+
+    // Unescaped characters are written in bulk
+    u32 run = 0;
+
+    for (u32 i = 0; i < rStr.Length(); i++) {
+        u8 ch = rStr[i];
+
+        if (ch != '\"' && ch != '\\' && ch >= 0x20) {
+            continue;
+        }
+
+        Put(rStr.Data() + run, i - run);
+        run = i + 1;
+
+        Put('\\');
+
+        switch (ch) {
+        case '\"': Put('\"'); break;
+        case '\\': Put('\\'); break;
+        case '\b': Put('b');  break;
+        case '\f': Put('f');  break;
+        case '\n': Put('n');  break;
+        case '\r': Put('r');  break;
+        case '\t': Put('t');  break;
+
+        default: {
+            Put("u00", sizeof("u00") - 1);
+            Put(scHexDigits[ch >> 4]);
+            Put(scHexDigits[ch & 0xF]);
+            break;
+        }
+        }
+    }
+
+    Put(rStr.Data() + run, rStr.Length() - run);
+    Put('\"');
+}
+
+/**
+ * @brief Writes raw text to the buffer
+ *
+ * @param pData Text data
+ * @param size Text length
+ */
+void StreamWriter::Put(const char* pData, u32 size) {
+    K_ASSERT(pData != nullptr || size == 0);
+
+    while (size > 0) {
+        if (mBufferPos >= mBufferSize) {
+            FlushBuffer(false);
+        }
+
+        u32 n = Min(size, mBufferSize - mBufferPos);
+        std::memcpy(mpBuffer + mBufferPos, pData, n);
+
+        mBufferPos += n;
+        pData += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief Writes buffered data to the stream
+ *
+ * @param final Whether this is the final flush (may pad the data)
+ */
+void StreamWriter::FlushBuffer(bool final) {
+    if (mBufferPos == 0) {
+        return;
+    }
+
+    // Whitespace is allowed between any tokens
+    if (final) {
+        u32 size = ROUND_UP(mBufferPos, mrStream.GetSizeAlign());
+        K_ASSERT(size <= mBufferSize);
+
+        std::memset(mpBuffer + mBufferPos, ' ', size - mBufferPos);
+        mBufferPos = size;
+    }
+
+    // Once the stream fails, the rest of the data is dropped
+    if (!mIsError) {
+        s32 n = mrStream.Write(mpBuffer, mBufferPos);
+        mIsError = n != static_cast<s32>(mBufferPos);
+    }
+
+    mBufferPos = 0;
+}
+/**@}*/
+
+/**
+ * @name Element tree builder
+ */
+/**@{*/
+/**
+ * @brief Creates the element for the next value
+ */
+Element& ElementBuilder::NextElement() {
+    if (mStack.Empty()) {
+        return mRoot;
+    }
+
+    Element& rParent = *mStack[mStack.Size() - 1];
+
+    if (rParent.GetType() == Element::EType_Array) {
+        return rParent.Get<Array>().EmplaceBack();
+    }
+
+    return rParent.Get<Object>()[mKey];
+}
+
+/**
+ * @brief Handles a null value
+ */
+bool ElementBuilder::OnNull() {
+    NextElement().Set(json::null);
+    return true;
+}
+
+/**
+ * @brief Handles a boolean value
+ *
+ * @param value Boolean value
+ */
+bool ElementBuilder::OnBoolean(bool value) {
+    NextElement().Set(value);
+    return true;
+}
+
+/**
+ * @brief Handles a number value
+ *
+ * @param value Number value
+ */
+bool ElementBuilder::OnNumber(f64 value) {
+    NextElement().Set(value);
+    return true;
+}
+
+/**
+ * @brief Handles a string value
+ *
+ * @param rValue String value
+ */
+bool ElementBuilder::OnString(const StringView& rValue) {
+    NextElement().Set(String(rValue));
+    return true;
+}
+
+/**
+ * @brief Handles the opening of an object
+ */
+bool ElementBuilder::OnBeginObject() {
+    Element& rElem = NextElement();
+    rElem.Set(Object());
+
+    mStack.PushBack(&rElem);
+    return true;
+}
+
+/**
+ * @brief Handles the name of the next object member
+ *
+ * @param rKey Member name
+ */
+bool ElementBuilder::OnKey(const StringView& rKey) {
+    // Reuse the key buffer
+    mKey.Clear();
+    mKey += rKey;
+
+    return true;
+}
+
+/**
+ * @brief Handles the closing of an object
+ */
+bool ElementBuilder::OnEndObject() {
+    mStack.PopBack();
+    return true;
+}
+
+/**
+ * @brief Handles the opening of an array
+ */
+bool ElementBuilder::OnBeginArray() {
+    Element& rElem = NextElement();
+    rElem.Set(Array());
+
+    mStack.PushBack(&rElem);
+    return true;
+}
+
+/**
+ * @brief Handles the closing of an array
+ */
+bool ElementBuilder::OnEndArray() {
+    mStack.PopBack();
+    return true;
+}
+/**@}*/
+
+} // namespace json
+} // namespace kiwi
@@ -0,0 +1,435 @@
+#ifndef LIBKIWI_CORE_JSON_STREAM_H
+#define LIBKIWI_CORE_JSON_STREAM_H
+#include <libkiwi/core/kiwiIStream.h>
+#include <libkiwi/core/kiwiJSON.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/prim/kiwiStringView.h>
+#include <libkiwi/prim/kiwiVector.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+namespace json {
+//! @addtogroup libkiwi_core
+//! @{
+
+/**
+ * @brief JSON event handler interface
+ * @details Receives tokens from a StreamReader as they are parsed. Return
+ * false from any event to stop parsing.
+ * @note Strings/keys are only valid for the duration of the event
+ */
+class IHandler {
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~IHandler() {}
+
+    /**
+     * @name Value events
+     */
+    /**@{*/
+    virtual bool OnNull() = 0;
+    virtual bool OnBoolean(bool value) = 0;
+    virtual bool OnNumber(f64 value) = 0;
+    virtual bool OnString(const StringView& rValue) = 0;
+    /**@}*/
+
+    /**
+     * @name Structure events
+     */
+    /**@{*/
+    virtual bool OnBeginObject() = 0;
+    virtual bool OnKey(const StringView& rKey) = 0;
+    virtual bool OnEndObject() = 0;
+
+    virtual bool OnBeginArray() = 0;
+    virtual bool OnEndArray() = 0;
+    /**@}*/
+};
+
+/**
+ * @brief Streaming (SAX-style) JSON reader
+ * @details Consumes the stream through a small fixed-size buffer, so the
+ * document never needs to be held in memory.
+ * @note Reading stops after the root value, so the stream may contain more
+ * data afterwards (file padding, more documents, etc.)
+ */
+class StreamReader : private NonCopyable {
+public:
+    //! Data size for streams which don't know their length
+    static const u32 scUnknownSize = 0xFFFFFFFF;
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rStrm Source stream
+     * @param size Number of bytes available from the stream's position (if
+     * known). Required for file streams, which can't read past the end.
+     * @param bufferSize Size of the read buffer
+     */
+    StreamReader(IStream& rStrm, u32 size = scUnknownSize,
+                 u32 bufferSize = scDefaultBufferSize);
+
+    /**
+     * @brief Destructor
+     */
+    ~StreamReader();
+
+    /**
+     * @brief Parses the stream's JSON data (UTF-8)
+     *
+     * @param rHandler Event handler
+     * @return Success
+     */
+    bool Parse(IHandler& rHandler);
+
+private:
+    //! Default read buffer size
+    static const u32 scDefaultBufferSize = 1024;
+    //! Deepest supported array/object nesting
+    static const u32 scMaxDepth = 128;
+
+    //! End-of-stream marker
+    static const s32 scEOF = -1;
+
+private:
+    /**
+     * @brief Refills the read buffer once it has been consumed
+     * @return Whether any data is available
+     */
+    bool Fill();
+
+    /**
+     * @brief Gets the next character without consuming it
+     * @return Character, or scEOF
+     */
+    s32 Peek() {
+        return Fill() ? static_cast<u8>(*mpCursor) : scEOF;
+    }
+    /**
+     * @brief Consumes the next character
+     * @return Character, or scEOF
+     */
+    s32 Next() {
+        return Fill() ? static_cast<u8>(*mpCursor++) : scEOF;
+    }
+
+    /**
+     * @name Grammar functions
+     */
+    /**@{*/
+    bool ParseContainer(IHandler& rHandler);
+    bool ParseScalar(IHandler& rHandler);
+    bool ParseNext(IHandler& rHandler);
+    bool ParseMember(IHandler& rHandler);
+    bool ParseString();
+    bool ParseEscaped(s32 c);
+    bool ParseHex(u32& rCode);
+    bool ParseNumber(IHandler& rHandler);
+    bool ParseLiteral(const char* pLiteral);
+    void ParseWhiteSpace();
+    /**@}*/
+
+    /**
+     * @brief Appends a unicode character to the current token
+     *
+     * @param code Code point
+     */
+    void AppendUTF8(u32 code);
+
+private:
+    IStream& mrStream; // Source stream
+    u32 mRemaining;    // Number of bytes left in the stream
+
+    char* mpBuffer;       // Read buffer
+    u32 mBufferSize;      // Read buffer size
+    const char* mpCursor; // Parser position
+    const char* mpEnd;    // End of buffered data
+
+    String mToken;        // Current string/number token
+    TVector<char> mStack; // Open arrays/objects
+};
+
+/**
+ * @brief Streaming JSON writer
+ * @details Emits tokens directly to a stream through a small fixed-size
+ * buffer. It is also an event handler, so a StreamReader can feed it.
+ */
+class StreamWriter : public IHandler, private NonCopyable {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rStrm Destination stream
+     * @param pretty Whether to pretty-print
+     * @param bufferSize Size of the write buffer
+     */
+    StreamWriter(IStream& rStrm, bool pretty = false,
+                 u32 bufferSize = scDefaultBufferSize);
+
+    /**
+     * @brief Destructor
+     * @note Remaining buffered data is flushed
+     */
+    virtual ~StreamWriter();
+
+    /**
+     * @name Structure tokens
+     */
+    /**@{*/
+    bool BeginObject();
+    bool EndObject();
+    bool BeginArray();
+    bool EndArray();
+    bool WriteKey(const StringView& rKey);
+    /**@}*/
+
+    /**
+     * @name Value tokens
+     */
+    /**@{*/
+    bool WriteNull();
+    bool WriteBoolean(bool value);
+    bool WriteNumber(f64 value);
+    bool WriteString(const StringView& rValue);
+    bool WriteElement(const Element& rElem);
+    /**@}*/
+
+    /**
+     * @brief Writes all buffered data to the stream
+     * @note The final block is padded with whitespace if the stream requires
+     * aligned sizes
+     *
+     * @return Success
+     */
+    bool Flush();
+
+    /**
+     * @brief Tests whether a stream error has occurred
+     */
+    bool IsError() const {
+        return mIsError;
+    }
+
+    /**
+     * @name Event handler
+     */
+    /**@{*/
+    // clang-format off
+    virtual bool OnNull()                           { return WriteNull();           }
+    virtual bool OnBoolean(bool value)              { return WriteBoolean(value);   }
+    virtual bool OnNumber(f64 value)                { return WriteNumber(value);    }
+    virtual bool OnString(const StringView& rValue) { return WriteString(rValue);   }
+    virtual bool OnBeginObject()                    { return BeginObject();         }
+    virtual bool OnKey(const StringView& rKey)      { return WriteKey(rKey);        }
+    virtual bool OnEndObject()                      { return EndObject();           }
+    virtual bool OnBeginArray()                     { return BeginArray();          }
+    virtual bool OnEndArray()                       { return EndArray();            }
+    // clang-format on
+    /**@}*/
+
+private:
+    //! Default write buffer size
+    static const u32 scDefaultBufferSize = 1024;
+    //! Indent width, in spaces
+    static const u32 scIndentWidth = 4;
+
+    /**
+     * @brief Open array/object
+     */
+    struct Scope {
+        char type;  // Opening bracket
+        bool empty; // Whether no values have been written yet
+    };
+
+private:
+    /**
+     * @brief Prepares to write a value (separators, indentation)
+     */
+    void BeginValue();
+    /**
+     * @brief Closes the innermost array/object
+     *
+     * @param type Opening bracket
+     * @param close Closing bracket
+     */
+    bool EndScope(char type, char close);
+
+    /**
+     * @brief Writes a line break and indentation (pretty-print only)
+     */
+    void PutIndent();
+    /**
+     * @brief Writes an escaped, quoted string
+     *
+     * @param rStr String contents
+     */
+    void PutString(const StringView& rStr);
+
+    /**
+     * @brief Writes raw text to the buffer
+     *
+     * @param pData Text data
+     * @param size Text length
+     */
+    void Put(const char* pData, u32 size);
+    /**
+     * @brief Writes a raw character to the buffer
+     *
+     * @param c Character
+     */
+    void Put(char c) {
+        if (mBufferPos >= mBufferSize) {
+            FlushBuffer(false);
+        }
+
+        mpBuffer[mBufferPos++] = c;
+    }
+
+    /**
+     * @brief Writes buffered data to the stream
+     *
+     * @param final Whether this is the final flush (may pad the data)
+     */
+    void FlushBuffer(bool final);
+
+private:
+    IStream& mrStream; // Destination stream
+    bool mIsPretty;    // Pretty-print flag
+    bool mIsError;     // Stream error flag
+
+    char* mpBuffer;  // Write buffer
+    u32 mBufferSize; // Write buffer size
+    u32 mBufferPos;  // Write buffer position
+
+    TVector<Scope> mStack; // Open arrays/objects
+    bool mIsAfterKey;      // Whether a key is waiting for its value
+};
+
+/**
+ * @brief Element tree builder
+ * @details Collects reader events into an element tree. Use this to
+ * deserialize types which expect an element.
+ */
+class ElementBuilder : public IHandler, private NonCopyable {
+public:
+    /**
+     * @brief Gets the root element
+     */
+    const Element& Get() const {
+        return mRoot;
+    }
+
+    /**
+     * @name Event handler
+     */
+    /**@{*/
+    virtual bool OnNull();
+    virtual bool OnBoolean(bool value);
+    virtual bool OnNumber(f64 value);
+    virtual bool OnString(const StringView& rValue);
+    virtual bool OnBeginObject();
+    virtual bool OnKey(const StringView& rKey);
+    virtual bool OnEndObject();
+    virtual bool OnBeginArray();
+    virtual bool OnEndArray();
+    /**@}*/
+
+private:
+    /**
+     * @brief Creates the element for the next value
+     */
+    Element& NextElement();
+
+private:
+    Element mRoot; // Tree root
+
+    // Open arrays/objects. Their siblings can't be added while they are
+    // open, so the pointers stay valid.
+    TVector<Element*> mStack;
+    String mKey; // Name of the next object member
+};
+
+/**
+ * @name Stream deserialization utilities
+ */
+/**@{*/
+/**
+ * @brief Decodes JSON data (UTF-8) from a stream into element form
+ *
+ * @param rStrm Source stream
+ * @param size Number of bytes available (if known)
+ */
+K_INLINE Element load(IStream& rStrm,
+                      u32 size = StreamReader::scUnknownSize) {
+    StreamReader reader(rStrm, size);
+    ElementBuilder builder;
+
+    if (!reader.Parse(builder)) {
+        return Element();
+    }
+
+    return builder.Get();
+}
+
+/**
+ * @brief Decodes JSON data (UTF-8) from a stream into an object
+ *
+ * @param rStrm Source stream
+ * @param[out] rObj Object
+ * @param size Number of bytes available (if known)
+ * @return Success
+ */
+K_INLINE bool load(IStream& rStrm, ISerializable& rObj,
+                   u32 size = StreamReader::scUnknownSize) {
+    StreamReader reader(rStrm, size);
+    return rObj.Decode(reader);
+}
+/**@}*/
+
+/**
+ * @name Stream serialization utilities
+ */
+/**@{*/
+/**
+ * @brief Encodes a JSON element into a stream (UTF-8)
+ *
+ * @param rStrm Destination stream
+ * @param rElem JSON element
+ * @param pretty Whether to pretty-print
+ * @return Success
+ */
+K_INLINE bool dump(IStream& rStrm, const Element& rElem, bool pretty = false) {
+    StreamWriter writer(rStrm, pretty);
+    writer.WriteElement(rElem);
+    return writer.Flush();
+}
+
+/**
+ * @brief Encodes an object into a stream (UTF-8)
+ *
+ * @param rStrm Destination stream
+ * @param rObj Object
+ * @param pretty Whether to pretty-print
+ * @return Success
+ */
+K_INLINE bool dump(IStream& rStrm, const ISerializable& rObj,
+                   bool pretty = false) {
+    StreamWriter writer(rStrm, pretty);
+    rObj.Encode(writer);
+    return writer.Flush();
+}
+/**@}*/
+
+//! @}
+} // namespace json
+
+//! @}
+} // namespace kiwi
+
+#endif
@@ -2,6 +2,8 @@
 
 #include <libkiwi.h>
 
+#include <cstring>
+
 namespace kiwi {
 namespace {
 
@@ -42,8 +44,8 @@ void CheckDoubleFree(const void* pBlock) {
     K_ASSERT(pHandle->magic == 'EXPH');
 
     // Check that the block is still marked as used
-    MEMiExpHeapMBlock* pMBlock = static_cast<MEMiExpHeapMBlock*>(
-        AddToPtr(pMBlock, -sizeof(MEMiExpHeapMBlock)));
+    const MEMiExpHeapMBlock* pMBlock = static_cast<const MEMiExpHeapMBlock*>(
+        AddToPtr(pBlock, -sizeof(MEMiExpHeapMBlock)));
     K_ASSERT_EX(pMBlock->state == 'UD', "Double free!");
 #endif
 }
@@ -65,23 +67,46 @@ MemoryMgr::MemoryMgr() {
     LogHeap("RPSysSystem:System", pMem1HeapRP);
     LogHeap("RPSysSystem:Resource", pMem2HeapRP);
 
-    mpHeapMEM1 = EGG::ExpHeap::create(scHeapSize, pMem1HeapRP, 0);
-    K_ASSERT(mpHeapMEM1 != nullptr);
-    K_ASSERT(OSIsMEM1Region(mpHeapMEM1));
-    LogHeap("libkiwi:MEM1", mpHeapMEM1);
+    OSInitMutex(&mMutex);
+    std::memset(mSegments, 0, sizeof(mSegments));
+
+    mpParentHeaps[EMemory_MEM1] = pMem1HeapRP;
+    mpParentHeaps[EMemory_MEM2] = pMem2HeapRP;
+
+    EGG::Heap* pHeapMEM1 = EGG::ExpHeap::create(scHeapSize, pMem1HeapRP, 0);
+    K_ASSERT(pHeapMEM1 != nullptr);
+    K_ASSERT(OSIsMEM1Region(pHeapMEM1));
+    LogHeap("libkiwi:MEM1", pHeapMEM1);
+
+    EGG::Heap* pHeapMEM2 = EGG::ExpHeap::create(scHeapSize, pMem2HeapRP, 0);
+    K_ASSERT(pHeapMEM2 != nullptr);
+    K_ASSERT(OSIsMEM2Region(pHeapMEM2));
+    LogHeap("libkiwi:MEM2", pHeapMEM2);
+
+    mSegments[EMemory_MEM1][0].pHeap = pHeapMEM1;
+    mSegments[EMemory_MEM2][0].pHeap = pHeapMEM2;
+
+    // Slab memory is carved out of the heaps and never returned
+    void* pSlabMEM1 = pHeapMEM1->alloc(scSlabSizeMEM1, 32);
+    K_ASSERT(pSlabMEM1 != nullptr);
+    mSlabMEM1.Init(pSlabMEM1, scSlabSizeMEM1);
 
-    mpHeapMEM2 = EGG::ExpHeap::create(scHeapSize, pMem2HeapRP, 0);
-    K_ASSERT(mpHeapMEM2 != nullptr);
-    K_ASSERT(OSIsMEM2Region(mpHeapMEM2));
-    LogHeap("libkiwi:MEM2", mpHeapMEM2);
+    void* pSlabMEM2 = pHeapMEM2->alloc(scSlabSizeMEM2, 32);
+    K_ASSERT(pSlabMEM2 != nullptr);
+    mSlabMEM2.Init(pSlabMEM2, scSlabSizeMEM2);
 }
 
 /**
  * @brief Destructor
  */
 MemoryMgr::~MemoryMgr() {
-    delete mpHeapMEM1;
-    delete mpHeapMEM2;
+    for (int i = 0; i < EMemory_Max; i++) {
+        for (u32 j = 0; j < scMaxSegments; j++) {
+            if (mSegments[i][j].pHeap != nullptr) {
+                mSegments[i][j].pHeap->destroy();
+            }
+        }
+    }
 }
 
 /**
@@ -90,26 +115,50 @@ MemoryMgr::~MemoryMgr() {
  * @param memory Target memory region
  */
 EGG::Heap* MemoryMgr::GetHeap(EMemory memory) const {
-    EGG::Heap* pHeap = nullptr;
+    K_ASSERT(memory < EMemory_Max);
+
+    // First segment is the region's main heap
+    EGG::Heap* pHeap = mSegments[memory][0].pHeap;
+
+    K_ASSERT(pHeap != nullptr);
+    return pHeap;
+}
+
+/**
+ * @brief Gets the slab heap corresponding to the specified memory region
+ *
+ * @param memory Target memory region
+ */
+SlabHeap& MemoryMgr::GetSlabHeap(EMemory memory) const {
+    K_ASSERT(memory < EMemory_Max);
+    return memory == EMemory_MEM1 ? mSlabMEM1 : mSlabMEM2;
+}
+
+/**
+ * @brief Chooses the memory region for an allocation
+ *
+ * @param size Block size
+ * @param tag Allocation site tag
+ */
+EMemory MemoryMgr::GetPolicyRegion(u32 size, EAllocTag tag) {
+    switch (tag) {
+    case EAllocTag_Hot: {
+        return EMemory_MEM1;
+    }
 
-    switch (memory) {
-    case EMemory_MEM1: {
-        pHeap = mpHeapMEM1;
-        break;
+    case EAllocTag_Bulk: {
+        return EMemory_MEM2;
     }
 
-    case EMemory_MEM2: {
-        pHeap = mpHeapMEM2;
-        break;
+    case EAllocTag_Default: {
+        return size < LIBKIWI_MEMORY_BULK_SIZE ? EMemory_MEM1 : EMemory_MEM2;
     }
 
     default: {
         K_ASSERT(false);
+        return EMemory_MEM1;
     }
     }
-
-    K_ASSERT(pHeap != nullptr);
-    return pHeap;
 }
 
 /**
@@ -118,26 +167,246 @@ EGG::Heap* MemoryMgr::GetHeap(EMemory memory) const {
  * @param size Block size
  * @param align Block alignment
  * @param memory Target memory region
+ * @param pCaller Return address into the allocating code (for profiling,
+ * defaults to the caller of this function)
  * @return void* Pointer to allocated block
  */
-void* MemoryMgr::Alloc(u32 size, s32 align, EMemory memory) const {
-    void* pBlock = GetHeap(memory)->alloc(size, align);
+void* MemoryMgr::Alloc(u32 size, s32 align, EMemory memory,
+                       const void* pCaller) const {
+    void* pBlock = AllocFromRegion(size, align, memory);
     K_ASSERT_EX(pBlock != nullptr, "Out of memory (alloc %d)", size);
 
     K_ASSERT(memory == EMemory_MEM1 ? OSIsMEM1Region(pBlock)
                                     : OSIsMEM2Region(pBlock));
 
+    if (AllocProfiler::IsEnabled()) {
+        // Direct callers are the allocating code
+        if (pCaller == nullptr) {
+            pCaller = AllocProfiler::GetCaller(1);
+        }
+
+        AllocProfiler::RecordAlloc(pBlock, size, pCaller);
+    }
+
+    return pBlock;
+}
+
+/**
+ * @brief Allocates a block of memory using the placement policy
+ *
+ * @param size Block size
+ * @param align Block alignment
+ * @param tag Allocation site tag
+ * @param pCaller Return address into the allocating code (for profiling,
+ * defaults to the caller of this function)
+ * @return Pointer to allocated block
+ */
+void* MemoryMgr::Alloc(u32 size, s32 align, EAllocTag tag,
+                       const void* pCaller) const {
+    EMemory memory = GetPolicyRegion(size, tag);
+    void* pBlock = AllocFromRegion(size, align, memory);
+
+    // Slower memory is better than no memory
+    if (pBlock == nullptr) {
+        memory = memory == EMemory_MEM1 ? EMemory_MEM2 : EMemory_MEM1;
+        pBlock = AllocFromRegion(size, align, memory);
+    }
+
+    K_ASSERT_EX(pBlock != nullptr, "Out of memory (alloc %d)", size);
+
+    if (AllocProfiler::IsEnabled()) {
+        // Direct callers are the allocating code
+        if (pCaller == nullptr) {
+            pCaller = AllocProfiler::GetCaller(1);
+        }
+
+        AllocProfiler::RecordAlloc(pBlock, size, pCaller);
+    }
+
+    return pBlock;
+}
+
+/**
+ * @brief Allocates a block of memory from the specified region
+ *
+ * @param size Block size
+ * @param align Block alignment
+ * @param memory Target memory region
+ * @return Pointer to allocated block, or nullptr if the region is exhausted
+ */
+void* MemoryMgr::AllocFromRegion(u32 size, s32 align, EMemory memory) const {
+    K_ASSERT(memory < EMemory_Max);
+
+    // Small blocks avoid the expanded heap's free list walk
+    void* pBlock = GetSlabHeap(memory).Alloc(size, align);
+    if (pBlock != nullptr) {
+        return pBlock;
+    }
+
+    AutoMutexLock lock(mMutex);
+
+    // Earlier segments are preferred so later ones can empty out
+    for (u32 i = 0; i < scMaxSegments; i++) {
+        Segment& rSegment = mSegments[memory][i];
+
+        if (rSegment.pHeap == nullptr) {
+            continue;
+        }
+
+        pBlock = rSegment.pHeap->alloc(size, align);
+
+        if (pBlock != nullptr) {
+            rSegment.numBlocks++;
+            return pBlock;
+        }
+    }
+
+    // Existing segments are full
+    Segment* pSegment = Grow(size, align, memory);
+    if (pSegment == nullptr) {
+        return nullptr;
+    }
+
+    pBlock = pSegment->pHeap->alloc(size, align);
+
+    if (pBlock != nullptr) {
+        pSegment->numBlocks++;
+    }
+
     return pBlock;
 }
 
+/**
+ * @brief Adds a heap segment which can fit the specified block
+ *
+ * @param size Block size
+ * @param align Block alignment
+ * @param memory Target memory region
+ * @return New segment, or nullptr if the game is out of memory
+ */
+MemoryMgr::Segment* MemoryMgr::Grow(u32 size, s32 align, EMemory memory) const {
+    K_ASSERT(memory < EMemory_Max);
+
+    Segment* pSegment = nullptr;
+
+    for (u32 i = 0; i < scMaxSegments; i++) {
+        if (mSegments[memory][i].pHeap == nullptr) {
+            pSegment = &mSegments[memory][i];
+            break;
+        }
+    }
+
+    // All segment slots are in use
+    if (pSegment == nullptr) {
+        return nullptr;
+    }
+
+    // Negative alignment only chooses which end of a heap to use
+    u32 absAlign = align < 0 ? -align : align;
+
+    // Larger blocks get a segment to themselves
+    u32 heapSize = Max(scSegmentSize,
+                       ROUND_UP(size + absAlign + scSegmentOverhead, 32));
+
+    EGG::Heap* pHeap =
+        EGG::ExpHeap::create(heapSize, mpParentHeaps[memory], 0);
+
+    if (pHeap == nullptr) {
+        return nullptr;
+    }
+
+    LogHeap(memory == EMemory_MEM1 ? "libkiwi:MEM1+" : "libkiwi:MEM2+",
+            pHeap);
+
+    pSegment->pHeap = pHeap;
+    pSegment->numBlocks = 0;
+    return pSegment;
+}
+
+/**
+ * @brief Finds the heap segment which contains a block
+ *
+ * @param pBlock Block
+ */
+MemoryMgr::Segment* MemoryMgr::FindSegment(const void* pBlock) const {
+    for (int i = 0; i < EMemory_Max; i++) {
+        for (u32 j = 0; j < scMaxSegments; j++) {
+            EGG::Heap* pHeap = mSegments[i][j].pHeap;
+
+            if (pHeap == nullptr) {
+                continue;
+            }
+
+            if (pBlock >= pHeap->getStartAddress() &&
+                pBlock < pHeap->getEndAddress()) {
+                return &mSegments[i][j];
+            }
+        }
+    }
+
+    return nullptr;
+}
+
 /**
  * @brief Frees a block of memory
  *
  * @param pBlock Block
  */
 void MemoryMgr::Free(void* pBlock) const {
+    AllocProfiler::RecordFree(pBlock);
+
+    if (mSlabMEM1.IsHeapMemory(pBlock)) {
+        mSlabMEM1.Free(pBlock);
+        return;
+    }
+
+    if (mSlabMEM2.IsHeapMemory(pBlock)) {
+        mSlabMEM2.Free(pBlock);
+        return;
+    }
+
+    // nullptr delete is OK
+    if (pBlock == nullptr) {
+        return;
+    }
+
     CheckDoubleFree(pBlock);
-    EGG::Heap::free(pBlock, nullptr);
+
+    AutoMutexLock lock(mMutex);
+
+    Segment* pSegment = FindSegment(pBlock);
+
+    // Not ours, but let the game's heaps handle it
+    if (pSegment == nullptr) {
+        EGG::Heap::free(pBlock, nullptr);
+        return;
+    }
+
+    K_ASSERT(pSegment->numBlocks > 0);
+    pSegment->numBlocks--;
+
+    pSegment->pHeap->free(pBlock);
+}
+
+/**
+ * @brief Gives empty heap segments back to the game
+ * @note The first segment of each region is always kept
+ */
+void MemoryMgr::ReleaseEmptySegments() {
+    AutoMutexLock lock(mMutex);
+
+    for (int i = 0; i < EMemory_Max; i++) {
+        for (u32 j = 1; j < scMaxSegments; j++) {
+            Segment& rSegment = mSegments[i][j];
+
+            if (rSegment.pHeap == nullptr || rSegment.numBlocks > 0) {
+                continue;
+            }
+
+            rSegment.pHeap->destroy();
+            rSegment.pHeap = nullptr;
+        }
+    }
 }
 
 /**
@@ -146,30 +415,59 @@ void MemoryMgr::Free(void* pBlock) const {
  * @param memory Target memory region
  */
 u32 MemoryMgr::GetFreeSize(EMemory memory) const {
-    return GetHeap(memory)->getAllocatableSize();
+    K_ASSERT(memory < EMemory_Max);
+
+    AutoMutexLock lock(mMutex);
+    u32 size = 0;
+
+    for (u32 i = 0; i < scMaxSegments; i++) {
+        EGG::Heap* pHeap = mSegments[memory][i].pHeap;
+
+        if (pHeap != nullptr) {
+            size += pHeap->getAllocatableSize();
+        }
+    }
+
+    return size;
 }
 
 /**
- * @brief Tests whether an address points to an allocation from this manager
+ * @brief Gets the slab heap statistics
  *
- * @param pAddr Memory address
+ * @param memory Target memory region
  */
-bool MemoryMgr::IsHeapMemory(const void* pAddr) const {
-    K_ASSERT(mpHeapMEM1 != nullptr && mpHeapMEM2 != nullptr);
+SlabHeap::Stats MemoryMgr::GetSlabStats(EMemory memory) const {
+    return GetSlabHeap(memory).GetStats();
+}
 
-    // Check MEM1 heap
-    if (pAddr >= mpHeapMEM1->getStartAddress() &&
-        pAddr < mpHeapMEM1->getEndAddress()) {
-        return true;
-    }
+/**
+ * @brief Gets the number of expanded heap segments
+ *
+ * @param memory Target memory region
+ */
+u32 MemoryMgr::GetNumSegments(EMemory memory) const {
+    K_ASSERT(memory < EMemory_Max);
+
+    AutoMutexLock lock(mMutex);
+    u32 num = 0;
 
-    // Check MEM2 heap
-    if (pAddr >= mpHeapMEM2->getStartAddress() &&
-        pAddr < mpHeapMEM2->getEndAddress()) {
-        return true;
+    for (u32 i = 0; i < scMaxSegments; i++) {
+        if (mSegments[memory][i].pHeap != nullptr) {
+            num++;
+        }
     }
 
-    return false;
+    return num;
+}
+
+/**
+ * @brief Tests whether an address points to an allocation from this manager
+ *
+ * @param pAddr Memory address
+ */
+bool MemoryMgr::IsHeapMemory(const void* pAddr) const {
+    AutoMutexLock lock(mMutex);
+    return FindSegment(pAddr) != nullptr;
 }
 
 } // namespace kiwi
@@ -181,7 +479,8 @@ bool MemoryMgr::IsHeapMemory(const void* pAddr) const {
  * @return Pointer to allocated block
  */
 void* operator new(size_t size) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, kiwi::EMemory_MEM1);
+    return kiwi::MemoryMgr::GetInstance().Alloc(
+        size, 4, kiwi::EAllocTag_Default, K_ALLOC_CALLER);
 }
 /**
  * @brief Allocates a block of memory for an array
@@ -190,7 +489,8 @@ void* operator new(size_t size) {
  * @return Pointer to allocated block
  */
 void* operator new[](size_t size) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, kiwi::EMemory_MEM1);
+    return kiwi::MemoryMgr::GetInstance().Alloc(
+        size, 4, kiwi::EAllocTag_Default, K_ALLOC_CALLER);
 }
 
 /**
@@ -201,8 +501,8 @@ void* operator new[](size_t size) {
  * @return Pointer to allocated block
  */
 void* operator new(size_t size, s32 align) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, align,
-                                                kiwi::EMemory_MEM1);
+    return kiwi::MemoryMgr::GetInstance().Alloc(
+        size, align, kiwi::EAllocTag_Default, K_ALLOC_CALLER);
 }
 /**
  * @brief Allocates a block of memory for an array
@@ -212,8 +512,8 @@ void* operator new(size_t size, s32 align) {
  * @return Pointer to allocated block
  */
 void* operator new[](size_t size, s32 align) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, align,
-                                                kiwi::EMemory_MEM1);
+    return kiwi::MemoryMgr::GetInstance().Alloc(
+        size, align, kiwi::EAllocTag_Default, K_ALLOC_CALLER);
 }
 
 /**
@@ -224,7 +524,8 @@ void* operator new[](size_t size, s32 align) {
  * @return Pointer to allocated block
  */
 void* operator new(size_t size, kiwi::EMemory memory) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, memory);
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, memory,
+                                                K_ALLOC_CALLER);
 }
 /**
  * @brief Allocates a block of memory for an array
@@ -234,7 +535,8 @@ void* operator new(size_t size, kiwi::EMemory memory) {
  * @return Pointer to allocated block
  */
 void* operator new[](size_t size, kiwi::EMemory memory) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, memory);
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, memory,
+                                                K_ALLOC_CALLER);
 }
 
 /**
@@ -246,7 +548,8 @@ void* operator new[](size_t size, kiwi::EMemory memory) {
  * @return Pointer to allocated block
  */
 void* operator new(size_t size, s32 align, kiwi::EMemory memory) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, memory);
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, memory,
+                                                K_ALLOC_CALLER);
 }
 /**
  * @brief Allocates a block of memory for an array
@@ -257,7 +560,56 @@ void* operator new(size_t size, s32 align, kiwi::EMemory memory) {
  * @return Pointer to allocated block
  */
 void* operator new[](size_t size, s32 align, kiwi::EMemory memory) {
-    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, memory);
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, memory,
+                                                K_ALLOC_CALLER);
+}
+
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new(size_t size, kiwi::EAllocTag tag) {
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, tag,
+                                                K_ALLOC_CALLER);
+}
+/**
+ * @brief Allocates a block of memory for an array
+ *
+ * @param size Block size
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new[](size_t size, kiwi::EAllocTag tag) {
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, 4, tag,
+                                                K_ALLOC_CALLER);
+}
+
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param align Block address alignment
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new(size_t size, s32 align, kiwi::EAllocTag tag) {
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, tag,
+                                                K_ALLOC_CALLER);
+}
+/**
+ * @brief Allocates a block of memory for an array
+ *
+ * @param size Block size
+ * @param align Block address alignment
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new[](size_t size, s32 align, kiwi::EAllocTag tag) {
+    return kiwi::MemoryMgr::GetInstance().Alloc(size, align, tag,
+                                                K_ALLOC_CALLER);
 }
 
 /**
@@ -1,9 +1,22 @@
 #ifndef LIBKIWI_CORE_MEMORY_MGR_H
 #define LIBKIWI_CORE_MEMORY_MGR_H
 #include <egg/core.h>
+#include <libkiwi/core/kiwiSlabHeap.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/util/kiwiStaticSingleton.h>
 
+#include <revolution/OS.h>
+
+/**
+ * @brief Smallest default-tagged allocation placed in MEM2
+ * @details Define this in your LIBKIWI_USER_CONFIG to override it. Smaller
+ * values leave more MEM1 free, while larger values keep more objects in the
+ * faster MEM1 region.
+ */
+#ifndef LIBKIWI_MEMORY_BULK_SIZE
+#define LIBKIWI_MEMORY_BULK_SIZE 4096
+#endif
+
 namespace kiwi {
 //! @addtogroup libkiwi_core
 //! @{
@@ -18,8 +31,28 @@ enum EMemory {
     EMemory_Max
 };
 
+/**
+ * @brief Allocation site tag
+ * @details Chooses the memory region for allocations which don't need a
+ * specific one. If the preferred region is exhausted, the other is used.
+ */
+enum EAllocTag {
+    EAllocTag_Default, //!< Small blocks in MEM1, bulk blocks in MEM2
+    EAllocTag_Hot,     //!< Small, frequently used objects (MEM1)
+    EAllocTag_Bulk,    //!< Large buffers (MEM2)
+
+    EAllocTag_Max
+};
+
 /**
  * @brief Memory manager
+ * @details Small allocations are served by a slab heap in each region, and
+ * everything else (or anything the slab heap can't fit) goes to the region's
+ * expanded heaps.
+ *
+ * Each region starts with one expanded heap. When it is exhausted, another
+ * heap segment is taken from the game's root heap, and segments which become
+ * empty are given back on scene changes.
  */
 class MemoryMgr : public StaticSingleton<MemoryMgr> {
     friend class StaticSingleton<MemoryMgr>;
@@ -31,9 +64,24 @@ public:
      * @param size Block size
      * @param align Block alignment
      * @param memory Target memory region
+     * @param pCaller Return address into the allocating code (for
+     * profiling, defaults to the caller of this function)
+     * @return Pointer to allocated block
+     */
+    void* Alloc(u32 size, s32 align, EMemory region,
+                const void* pCaller = nullptr) const;
+    /**
+     * @brief Allocates a block of memory using the placement policy
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @param tag Allocation site tag
+     * @param pCaller Return address into the allocating code (for
+     * profiling, defaults to the caller of this function)
      * @return Pointer to allocated block
      */
-    void* Alloc(u32 size, s32 align, EMemory region) const;
+    void* Alloc(u32 size, s32 align, EAllocTag tag,
+                const void* pCaller = nullptr) const;
 
     /**
      * @brief Frees a block of memory
@@ -49,6 +97,25 @@ public:
      */
     u32 GetFreeSize(EMemory region) const;
 
+    /**
+     * @brief Gets the slab heap statistics
+     *
+     * @param memory Target memory region
+     */
+    SlabHeap::Stats GetSlabStats(EMemory memory) const;
+
+    /**
+     * @brief Gets the number of expanded heap segments
+     *
+     * @param memory Target memory region
+     */
+    u32 GetNumSegments(EMemory memory) const;
+    /**
+     * @brief Gives empty heap segments back to the game
+     * @note The first segment of each region is always kept
+     */
+    void ReleaseEmptySegments();
+
     /**
      * @brief Tests whether an address points to an allocation from this manager
      *
@@ -56,6 +123,15 @@ public:
      */
     bool IsHeapMemory(const void* pAddr) const;
 
+private:
+    /**
+     * @brief Expanded heap segment
+     */
+    struct Segment {
+        EGG::Heap* pHeap; // Expanded heap (nullptr if unused)
+        u32 numBlocks;    // Number of blocks allocated from the heap
+    };
+
 private:
     /**
      * @brief Constructor
@@ -72,19 +148,79 @@ private:
      * @param memory Target memory region
      */
     EGG::Heap* GetHeap(EMemory memory) const;
+    /**
+     * @brief Gets the slab heap corresponding to the specified memory region
+     *
+     * @param memory Target memory region
+     */
+    SlabHeap& GetSlabHeap(EMemory memory) const;
+
+    /**
+     * @brief Allocates a block of memory from the specified region
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @param memory Target memory region
+     * @return Pointer to allocated block, or nullptr if the region is
+     * exhausted
+     */
+    void* AllocFromRegion(u32 size, s32 align, EMemory memory) const;
+
+    /**
+     * @brief Adds a heap segment which can fit the specified block
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @param memory Target memory region
+     * @return New segment, or nullptr if the game is out of memory
+     */
+    Segment* Grow(u32 size, s32 align, EMemory memory) const;
+
+    /**
+     * @brief Finds the heap segment which contains a block
+     *
+     * @param pBlock Block
+     */
+    Segment* FindSegment(const void* pBlock) const;
+
+    /**
+     * @brief Chooses the memory region for an allocation
+     *
+     * @param size Block size
+     * @param tag Allocation site tag
+     */
+    static EMemory GetPolicyRegion(u32 size, EAllocTag tag);
 
 private:
-// TODO: How to get more MEM1 memory from WS2?
 #if defined(PACK_SPORTS) || defined(PACK_PLAY)
     //! Initial size for each heap
     static const u32 scHeapSize = OS_MEM_KB_TO_B(1024);
 #elif defined(PACK_RESORT)
-    //! Initial size for each heap
+    //! Initial size for each heap (more is added on demand)
     static const u32 scHeapSize = OS_MEM_KB_TO_B(512);
 #endif
 
-    EGG::Heap* mpHeapMEM1; //!< Heap in MEM1 region
-    EGG::Heap* mpHeapMEM2; //!< Heap in MEM2 region
+    //! Largest number of heap segments per region
+    static const u32 scMaxSegments = 8;
+    //! Smallest size of additional heap segments
+    static const u32 scSegmentSize = OS_MEM_KB_TO_B(256);
+    //! Room for the heap headers in a segment
+    static const u32 scSegmentOverhead = 0x100;
+
+    //! Size of the MEM1 slab heap
+    static const u32 scSlabSizeMEM1 = OS_MEM_KB_TO_B(64);
+    //! Size of the MEM2 slab heap (most MEM2 buffers are large)
+    static const u32 scSlabSizeMEM2 = OS_MEM_KB_TO_B(16);
+
+    //! Game heaps that segments are taken from
+    EGG::Heap* mpParentHeaps[EMemory_Max];
+    //! Heap segments in each region (the first is never released)
+    mutable Segment mSegments[EMemory_Max][scMaxSegments];
+    //! Segment lock
+    mutable OSMutex mMutex;
+
+    mutable SlabHeap mSlabMEM1; //!< Small blocks in MEM1 region
+    mutable SlabHeap mSlabMEM2; //!< Small blocks in MEM2 region
 };
 
 //! @}
@@ -161,6 +297,42 @@ void* operator new(size_t size, s32 align, kiwi::EMemory memory);
  */
 void* operator new[](size_t size, s32 align, kiwi::EMemory memory);
 
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new(size_t size, kiwi::EAllocTag tag);
+/**
+ * @brief Allocates a block of memory for an array
+ *
+ * @param size Block size
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new[](size_t size, kiwi::EAllocTag tag);
+
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param align Block address alignment
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new(size_t size, s32 align, kiwi::EAllocTag tag);
+/**
+ * @brief Allocates a block of memory for an array
+ *
+ * @param size Block size
+ * @param align Block address alignment
+ * @param tag Allocation site tag
+ * @return Pointer to allocated block
+ */
+void* operator new[](size_t size, s32 align, kiwi::EAllocTag tag);
+
 /**
  * @brief Frees a block of memory
  *
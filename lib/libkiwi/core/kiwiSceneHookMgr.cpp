@@ -25,10 +25,29 @@ RPSysScene* GetCurrentScene() {
 
 } // namespace
 
+/**
+ * @brief Constructor
+ *
+ * @param id Scene ID (-1 for all scenes)
+ */
+ISceneHook::ISceneHook(s32 id) : mSceneID(id) {
+    K_ASSERT_EX(id == -1 || id < ESceneID_Max,
+                "Only RP scenes and -1 (all) are supported");
+
+    SceneHookMgr::GetInstance().AddHook(*this, mSceneID);
+}
+
+/**
+ * @brief Destructor
+ */
+ISceneHook::~ISceneHook() {
+    SceneHookMgr::GetInstance().RemoveHook(*this, mSceneID);
+}
+
 /**
  * @brief Gets list of hooks for the current scene
  */
-TList<ISceneHook>& SceneHookMgr::GetActiveHooks() {
+SceneHookMgr::HookList& SceneHookMgr::GetActiveHooks() {
     K_ASSERT_EX(IsPackScene(), "Only game scenes have hooks");
     s32 id = RP_GET_INSTANCE(RPSysSceneMgr)->getCurrentSceneID();
     return mHookLists[id];
@@ -68,6 +87,11 @@ void SceneHookMgr::RemoveHook(const ISceneHook& rHook, s32 id) {
  * @brief Enter state
  */
 void SceneHookMgr::DoEnter() {
+    // Previous scene is gone, along with anything using its arena
+    GetInstance().mSceneArena.Clear();
+    // Heap segments which grew for the previous scene may be empty now
+    MemoryMgr::GetInstance().ReleaseEmptySegments();
+
     GetCurrentScene()->Configure();
 
     // Global hooks
@@ -153,6 +177,9 @@ KOKESHI_BY_PACK(KM_BRANCH(0x8018695c, SceneHookMgr::DoLoadResource),  // Wii Spo
  * @brief Calculate state
  */
 void SceneHookMgr::DoCalculate() {
+    // Release the previous frame's temporaries
+    GetInstance().mFrameArena.Reset();
+
     // Global hooks
     K_FOREACH (GetInstance().mGlobalHooks) {
         it->BeforeCalculate(GetCurrentScene());
@@ -202,6 +229,11 @@ void SceneHookMgr::DoExit() {
             it->Exit(GetCurrentScene());
         }
     }
+
+    // Blocks still alive here may belong to the scene
+    if (AllocProfiler::IsEnabled()) {
+        AllocProfiler::Print();
+    }
 }
 // clang-format off
 KOKESHI_BY_PACK(KM_BRANCH(0x80185000, SceneHookMgr::DoExit),  // Wii Sports
@@ -1,109 +1,35 @@
 #ifndef LIBKIWI_CORE_SCENE_HOOK_MGR_H
 #define LIBKIWI_CORE_SCENE_HOOK_MGR_H
 #include <Pack/RPSystem.h>
+#include <libkiwi/core/kiwiArena.h>
 #include <libkiwi/core/kiwiSceneCreator.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/prim/kiwiArray.h>
-#include <libkiwi/prim/kiwiLinkList.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
 #include <libkiwi/util/kiwiStaticSingleton.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_core
 //! @{
 
-// Forward declarations
-class ISceneHook;
-
-/**
- * @brief Scene hook manager
- */
-class SceneHookMgr : public StaticSingleton<SceneHookMgr> {
-    friend class StaticSingleton<SceneHookMgr>;
-
-public:
-    /**
-     * @brief Registers new hook
-     *
-     * @param rHook Scene hook
-     * @param id Scene ID (-1 for all scenes)
-     */
-    void AddHook(ISceneHook& rHook, s32 id);
-
-    /**
-     * @brief Unregisters existing hook
-     *
-     * @param rHook Scene hook
-     * @param id Scene ID (-1 for all scenes)
-     */
-    void RemoveHook(const ISceneHook& rHook, s32 id);
-
-private:
-    LIBKIWI_KAMEK_PUBLIC
-
-    /**
-     * @brief Enter state
-     */
-    static void DoEnter();
-    /**
-     * @brief Reset state
-     */
-    static void DoReset();
-    /**
-     * @brief LoadResource state
-     */
-    static void DoLoadResource();
-    /**
-     * @brief Calculate state
-     */
-    static void DoCalculate();
-    /**
-     * @brief Exit state
-     */
-    static void DoExit();
-    /**
-     * @brief Pause state
-     */
-    static void DoPause();
-    /**
-     * @brief Un-pause state
-     */
-    static void DoUnPause();
-
-    /**
-     * @brief Gets list of hooks for the current scene
-     */
-    TList<ISceneHook>& GetActiveHooks();
-
-private:
-    //! Lists of scene hooks
-    TArray<TList<ISceneHook>, ESceneID_Max> mHookLists;
-    //! Global hooks (always active)
-    TList<ISceneHook> mGlobalHooks;
-};
-
 /**
  * @brief Scene hook interface
  */
 class ISceneHook {
+    friend class SceneHookMgr;
+
 public:
     /**
      * @brief Constructor
      *
      * @param id Scene ID (-1 for all scenes)
      */
-    explicit ISceneHook(s32 id) : mSceneID(id) {
-        K_ASSERT_EX(id == -1 || id < ESceneID_Max,
-                    "Only RP scenes and -1 (all) are supported");
-
-        SceneHookMgr::GetInstance().AddHook(*this, mSceneID);
-    }
+    explicit ISceneHook(s32 id);
 
     /**
      * @brief Destructor
      */
-    virtual ~ISceneHook() {
-        SceneHookMgr::GetInstance().RemoveHook(*this, mSceneID);
-    }
+    virtual ~ISceneHook();
 
     /**
      * @brief Configure callback
@@ -169,7 +95,100 @@ public:
     virtual void Pause(RPSysScene* pScene, bool enter) {}
 
 private:
-    s32 mSceneID; //!< Scene to which this hook belongs
+    s32 mSceneID;            //!< Scene to which this hook belongs
+    IntrusiveListNode mNode; //!< Node in the scene hook manager's list
+};
+
+/**
+ * @brief Scene hook manager
+ * @details Also owns the frame and scene arenas. The frame arena is reset at
+ * the start of every frame, before any hooks run. The scene arena is cleared
+ * when the next scene is entered, before any Configure callbacks.
+ */
+class SceneHookMgr : public StaticSingleton<SceneHookMgr> {
+    friend class StaticSingleton<SceneHookMgr>;
+
+public:
+    //! Scene hook list
+    typedef TIntrusiveList<ISceneHook, &ISceneHook::mNode> HookList;
+
+public:
+    /**
+     * @brief Registers new hook
+     *
+     * @param rHook Scene hook
+     * @param id Scene ID (-1 for all scenes)
+     */
+    void AddHook(ISceneHook& rHook, s32 id);
+
+    /**
+     * @brief Unregisters existing hook
+     *
+     * @param rHook Scene hook
+     * @param id Scene ID (-1 for all scenes)
+     */
+    void RemoveHook(const ISceneHook& rHook, s32 id);
+
+    /**
+     * @brief Gets the arena for temporaries which last one frame
+     */
+    Arena& GetFrameArena() {
+        return mFrameArena;
+    }
+    /**
+     * @brief Gets the arena for memory which lasts until the scene exits
+     */
+    Arena& GetSceneArena() {
+        return mSceneArena;
+    }
+
+private:
+    LIBKIWI_KAMEK_PUBLIC
+
+    /**
+     * @brief Enter state
+     */
+    static void DoEnter();
+    /**
+     * @brief Reset state
+     */
+    static void DoReset();
+    /**
+     * @brief LoadResource state
+     */
+    static void DoLoadResource();
+    /**
+     * @brief Calculate state
+     */
+    static void DoCalculate();
+    /**
+     * @brief Exit state
+     */
+    static void DoExit();
+    /**
+     * @brief Pause state
+     */
+    static void DoPause();
+    /**
+     * @brief Un-pause state
+     */
+    static void DoUnPause();
+
+    /**
+     * @brief Gets list of hooks for the current scene
+     */
+    HookList& GetActiveHooks();
+
+private:
+    //! Lists of scene hooks
+    TArray<HookList, ESceneID_Max> mHookLists;
+    //! Global hooks (always active)
+    HookList mGlobalHooks;
+
+    //! Temporaries for the current frame
+    Arena mFrameArena;
+    //! Memory for the current scene
+    Arena mSceneArena;
 };
 
 //! @}
@@ -0,0 +1,237 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Constructor
+ */
+SlabHeap::SlabHeap()
+    : mpMemory(nullptr), mpMemoryEnd(nullptr), mNumPages(0),
+      mFreePages(scNoPage) {
+    std::memset(mPages, 0, sizeof(mPages));
+    std::memset(mClassPages, scNoPage, sizeof(mClassPages));
+    std::memset(&mStats, 0, sizeof(Stats));
+}
+
+/**
+ * @brief Assigns the heap memory
+ *
+ * @param pMemory Heap memory (32-byte aligned)
+ * @param size Memory size
+ */
+void SlabHeap::Init(void* pMemory, u32 size) {
+    K_ASSERT(pMemory != nullptr);
+    K_ASSERT_EX(mpMemory == nullptr, "Heap already has memory");
+    K_ASSERT(reinterpret_cast<u32>(pMemory) % scMaxAlign == 0);
+
+    mNumPages = Min(size / scPageSize, static_cast<u32>(scMaxPages));
+    K_ASSERT(mNumPages > 0);
+
+    mpMemory = static_cast<u8*>(pMemory);
+    mpMemoryEnd = mpMemory + mNumPages * scPageSize;
+
+    // Pushed in reverse so the lowest pages are used first
+    for (s32 i = mNumPages - 1; i >= 0; i--) {
+        mPages[i].sizeClass = scNoClass;
+        PushPage(mFreePages, i);
+    }
+
+    mStats.numPages = mNumPages;
+    mStats.numFreePages = mNumPages;
+}
+
+/**
+ * @brief Allocates a block of memory
+ *
+ * @param size Block size
+ * @param align Block alignment
+ * @return Pointer to allocated block, or nullptr if the request can't be
+ * served by this heap
+ */
+void* SlabHeap::Alloc(u32 size, s32 align) {
+    // Negative alignment only chooses which end of the heap to use
+    u32 absAlign = align < 0 ? -align : align;
+
+    if (mpMemory == nullptr || size > MAX_BLOCK_SIZE ||
+        absAlign > scMaxAlign) {
+        return nullptr;
+    }
+
+    // Blocks are aligned to their size (up to the page alignment)
+    u32 i = GetClassIndex(Max(size, absAlign));
+    ClassStats& rStats = mStats.classes[i];
+
+    AutoInterruptLock lock;
+
+    u32 page = mClassPages[i];
+
+    // Take a new page for the class
+    if (page == scNoPage) {
+        page = mFreePages;
+
+        if (page == scNoPage) {
+            mStats.numFailed++;
+            return nullptr;
+        }
+
+        RemovePage(mFreePages, page);
+        PushPage(mClassPages[i], page);
+
+        Page& rPage = mPages[page];
+        rPage.pFreeList = nullptr;
+        rPage.numInUse = 0;
+        rPage.numCarved = 0;
+        rPage.sizeClass = static_cast<u8>(i);
+
+        mStats.numFreePages--;
+        rStats.numPages++;
+    }
+
+    Page& rPage = mPages[page];
+    void* pBlock = nullptr;
+
+    // Reuse freed blocks before carving new ones
+    if (rPage.pFreeList != nullptr) {
+        pBlock = rPage.pFreeList;
+        rPage.pFreeList = rPage.pFreeList->pNext;
+    } else {
+        pBlock = GetPageMemory(page) + rPage.numCarved * GetClassSize(i);
+        rPage.numCarved++;
+    }
+
+    rPage.numInUse++;
+
+    if (IsPageFull(rPage)) {
+        RemovePage(mClassPages[i], page);
+    }
+
+    rStats.numInUse++;
+    rStats.maxInUse = Max(rStats.maxInUse, rStats.numInUse);
+
+    return pBlock;
+}
+
+/**
+ * @brief Frees a block of memory
+ *
+ * @param pBlock Block (must belong to this heap)
+ */
+void SlabHeap::Free(void* pBlock) {
+    K_ASSERT(IsHeapMemory(pBlock));
+
+    u32 offset = PtrDistance(mpMemory, pBlock);
+    u32 page = offset / scPageSize;
+
+    Page& rPage = mPages[page];
+    u32 i = rPage.sizeClass;
+
+    K_ASSERT_EX(i < NUM_CLASSES, "Block is in an unused page");
+    K_ASSERT_EX(offset % GetClassSize(i) == 0, "Not the start of a block");
+    K_ASSERT_EX(offset % scPageSize / GetClassSize(i) < rPage.numCarved,
+                "Block was never allocated");
+
+    AutoInterruptLock lock;
+
+#ifndef NDEBUG
+    // Pages hold at most 128 blocks, so this stays cheap
+    for (FreeBlock* pIt = rPage.pFreeList; pIt != nullptr; pIt = pIt->pNext) {
+        K_ASSERT_EX(pIt != pBlock, "Double free of %p", pBlock);
+    }
+#endif
+
+    K_ASSERT(rPage.numInUse > 0);
+
+    // Full pages aren't in the class list
+    if (IsPageFull(rPage)) {
+        PushPage(mClassPages[i], page);
+    }
+
+    FreeBlock* pFree = static_cast<FreeBlock*>(pBlock);
+    pFree->pNext = rPage.pFreeList;
+    rPage.pFreeList = pFree;
+
+    rPage.numInUse--;
+    mStats.classes[i].numInUse--;
+
+    // Empty pages go back to the heap, unless they're the last in the class
+    if (rPage.numInUse == 0 &&
+        (mClassPages[i] != page || rPage.next != scNoPage)) {
+        RemovePage(mClassPages[i], page);
+        PushPage(mFreePages, page);
+
+        rPage.sizeClass = scNoClass;
+
+        mStats.numFreePages++;
+        mStats.classes[i].numPages--;
+    }
+}
+
+/**
+ * @brief Gets the heap statistics
+ */
+SlabHeap::Stats SlabHeap::GetStats() const {
+    AutoInterruptLock lock;
+    return mStats;
+}
+
+/**
+ * @brief Gets the size class which fits the specified size
+ *
+ * @param size Block size
+ */
+u32 SlabHeap::GetClassIndex(u32 size) {
+    K_ASSERT(size <= MAX_BLOCK_SIZE);
+
+    if (size <= MIN_BLOCK_SIZE) {
+        return 0;
+    }
+
+    // Round up to the next power of two (smallest class is 1 << 3)
+    return (32 - __cntlzw(size - 1)) - 3;
+}
+
+/**
+ * @brief Adds a page to the front of a list
+ *
+ * @param rHead List head
+ * @param page Page index
+ */
+void SlabHeap::PushPage(u8& rHead, u32 page) {
+    Page& rPage = mPages[page];
+
+    rPage.prev = scNoPage;
+    rPage.next = rHead;
+
+    if (rHead != scNoPage) {
+        mPages[rHead].prev = static_cast<u8>(page);
+    }
+
+    rHead = static_cast<u8>(page);
+}
+
+/**
+ * @brief Removes a page from a list
+ *
+ * @param rHead List head
+ * @param page Page index
+ */
+void SlabHeap::RemovePage(u8& rHead, u32 page) {
+    Page& rPage = mPages[page];
+
+    if (rPage.prev != scNoPage) {
+        mPages[rPage.prev].next = rPage.next;
+    } else {
+        K_ASSERT(rHead == page);
+        rHead = rPage.next;
+    }
+
+    if (rPage.next != scNoPage) {
+        mPages[rPage.next].prev = rPage.prev;
+    }
+
+    rPage.prev = rPage.next = scNoPage;
+}
+
+} // namespace kiwi
@@ -0,0 +1,194 @@
+#ifndef LIBKIWI_CORE_SLAB_HEAP_H
+#define LIBKIWI_CORE_SLAB_HEAP_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+
+/**
+ * @brief Segregated-fit allocator for small blocks
+ * @details The heap memory is split into pages, which are handed out to
+ * power-of-two size classes on demand. Each page keeps an intrusive free
+ * list, so both allocating and freeing are O(1), and blocks have no header
+ * overhead. Pages which empty out go back to the heap for any size class,
+ * except the last page with free blocks in each class, which is kept so a
+ * single block being allocated and freed doesn't move pages back and forth.
+ * @note The heap memory itself is never returned to the heap it came from.
+ * @note Safe to use from any thread
+ */
+class SlabHeap {
+public:
+    //! Number of size classes
+    static const u32 NUM_CLASSES = 6;
+    //! Smallest block size
+    static const u32 MIN_BLOCK_SIZE = 8;
+    //! Largest block size
+    static const u32 MAX_BLOCK_SIZE = MIN_BLOCK_SIZE << (NUM_CLASSES - 1);
+
+    /**
+     * @brief Size class statistics
+     */
+    struct ClassStats {
+        u32 numPages; // Pages assigned to the class
+        u32 numInUse; // Blocks in use
+        u32 maxInUse; // Largest number of blocks in use
+    };
+
+    /**
+     * @brief Heap statistics
+     */
+    struct Stats {
+        u32 numPages;     // Total number of pages
+        u32 numFreePages; // Pages not assigned to a class
+        u32 numFailed;    // Allocations the heap couldn't serve
+
+        ClassStats classes[NUM_CLASSES]; // Per-class statistics
+    };
+
+public:
+    /**
+     * @brief Constructor
+     */
+    SlabHeap();
+
+    /**
+     * @brief Assigns the heap memory
+     *
+     * @param pMemory Heap memory (32-byte aligned)
+     * @param size Memory size
+     */
+    void Init(void* pMemory, u32 size);
+
+    /**
+     * @brief Allocates a block of memory
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @return Pointer to allocated block, or nullptr if the request can't be
+     * served by this heap
+     */
+    void* Alloc(u32 size, s32 align);
+
+    /**
+     * @brief Frees a block of memory
+     *
+     * @param pBlock Block (must belong to this heap)
+     */
+    void Free(void* pBlock);
+
+    /**
+     * @brief Tests whether an address points to this heap's memory
+     *
+     * @param pAddr Memory address
+     */
+    bool IsHeapMemory(const void* pAddr) const {
+        return pAddr >= mpMemory && pAddr < mpMemoryEnd;
+    }
+
+    /**
+     * @brief Gets the heap statistics
+     */
+    Stats GetStats() const;
+
+    /**
+     * @brief Gets the block size of a size class
+     *
+     * @param i Size class index
+     */
+    static u32 GetClassSize(u32 i) {
+        K_ASSERT(i < NUM_CLASSES);
+        return MIN_BLOCK_SIZE << i;
+    }
+
+private:
+    /**
+     * @brief Free block
+     */
+    struct FreeBlock {
+        FreeBlock* pNext; // Next free block
+    };
+
+    /**
+     * @brief Page
+     */
+    struct Page {
+        FreeBlock* pFreeList; // Freed blocks
+        u16 numInUse;         // Blocks in use
+        u16 numCarved;        // Blocks carved so far
+        u8 sizeClass;         // Size class (or scNoClass)
+        u8 prev;              // Previous page in the list (or scNoPage)
+        u8 next;              // Next page in the list (or scNoPage)
+    };
+
+    //! Page size
+    static const u32 scPageSize = 1024;
+    //! Largest number of pages
+    static const u32 scMaxPages = 64;
+    //! Largest alignment that blocks can satisfy
+    static const u32 scMaxAlign = 32;
+    //! Page is not assigned to a size class
+    static const u8 scNoClass = 0xFF;
+    //! End of a page list
+    static const u8 scNoPage = 0xFF;
+
+private:
+    /**
+     * @brief Gets the size class which fits the specified size
+     *
+     * @param size Block size
+     */
+    static u32 GetClassIndex(u32 size);
+
+    /**
+     * @brief Gets the memory of a page
+     *
+     * @param page Page index
+     */
+    u8* GetPageMemory(u32 page) const {
+        return mpMemory + page * scPageSize;
+    }
+
+    /**
+     * @brief Tests whether a page has no more blocks to hand out
+     *
+     * @param rPage Page
+     */
+    static bool IsPageFull(const Page& rPage) {
+        return rPage.pFreeList == nullptr &&
+               rPage.numCarved == scPageSize / GetClassSize(rPage.sizeClass);
+    }
+
+    /**
+     * @brief Adds a page to the front of a list
+     *
+     * @param rHead List head
+     * @param page Page index
+     */
+    void PushPage(u8& rHead, u32 page);
+
+    /**
+     * @brief Removes a page from a list
+     *
+     * @param rHead List head
+     * @param page Page index
+     */
+    void RemovePage(u8& rHead, u32 page);
+
+private:
+    u8* mpMemory;    // Heap memory
+    u8* mpMemoryEnd; // End of heap memory
+    u32 mNumPages;   // Number of pages
+    u8 mFreePages;   // Pages not assigned to a class
+
+    Page mPages[scMaxPages];     // Page table
+    u8 mClassPages[NUM_CLASSES]; // Pages with free blocks, per class
+
+    Stats mStats; // Heap statistics
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
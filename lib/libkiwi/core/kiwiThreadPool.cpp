@@ -0,0 +1,248 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Waits for the task to finish running
+ * @note Not safe to call from interrupt context
+ */
+void Task::Wait() {
+    K_ASSERT_EX(mState != EState_Idle, "Task was never submitted");
+
+    // Interrupts are disabled to avoid missing the wakeup signal
+    AutoInterruptLock lock;
+
+    while (mState != EState_Done) {
+        OSSleepThread(&mDoneQueue);
+    }
+}
+
+/**
+ * @brief Constructor
+ *
+ * @param numThreads Number of worker threads
+ * @param stackSize Worker thread stack size
+ * @param priority Worker thread priority
+ * @param queueSize Largest number of queued tasks
+ */
+ThreadPool::ThreadPool(u32 numThreads, u32 stackSize, s32 priority,
+                       u32 queueSize)
+    : mpThreads(nullptr),
+      mpStacks(nullptr),
+      mNumThreads(numThreads),
+      mStackSize(ROUND_UP(stackSize, 32)),
+      mPriority(priority),
+      mIsStarted(false),
+      mIsExiting(false),
+      mQueueSize(queueSize) {
+
+    K_ASSERT(numThreads > 0);
+    K_ASSERT(queueSize > 0);
+    K_ASSERT(priority >= OS_PRIORITY_MIN && priority <= OS_PRIORITY_MAX);
+
+    std::memset(mpQueueHeads, 0, sizeof(mpQueueHeads));
+    std::memset(mpQueueTails, 0, sizeof(mpQueueTails));
+    std::memset(&mStats, 0, sizeof(Stats));
+
+    OSInitThreadQueue(&mWakeupQueue);
+
+    // Thread & stack aligned to 32
+    mpThreads = new (32) OSThread[mNumThreads];
+    K_ASSERT(mpThreads != nullptr);
+    mpStacks = new (32) u8[mNumThreads * mStackSize];
+    K_ASSERT(mpStacks != nullptr);
+}
+
+/**
+ * @brief Destructor
+ * @note Queued tasks are run before the worker threads exit
+ */
+ThreadPool::~ThreadPool() {
+    {
+        AutoInterruptLock lock;
+
+        mIsExiting = true;
+        OSWakeupThread(&mWakeupQueue);
+    }
+
+    // Nothing was ever submitted
+    for (u32 i = 0; mIsStarted && i < mNumThreads; i++) {
+        OSJoinThread(&mpThreads[i], nullptr);
+
+        K_ASSERT_EX(*mpThreads[i].stackEnd == OS_THREAD_STACK_MAGIC,
+                    "Thread stack overflow!!!");
+    }
+
+    delete[] mpThreads;
+    mpThreads = nullptr;
+
+    delete[] mpStacks;
+    mpStacks = nullptr;
+}
+
+/**
+ * @brief Shared pool
+ */
+ThreadPool* ThreadPool::spDefault = nullptr;
+
+/**
+ * @brief Creates the shared pool for general background work
+ * @note Call this during startup, before the shared pool is used
+ */
+void ThreadPool::CreateDefault() {
+    K_ASSERT_EX(spDefault == nullptr, "Created shared pool twice");
+
+    if (spDefault == nullptr) {
+        spDefault = new ThreadPool(scDefaultNumThreads);
+        K_ASSERT(spDefault != nullptr);
+    }
+}
+
+/**
+ * @brief Destroys the shared pool for general background work
+ */
+void ThreadPool::DestroyDefault() {
+    delete spDefault;
+    spDefault = nullptr;
+}
+
+/**
+ * @brief Submits a task to the pool
+ * @note Safe to call from interrupt context
+ *
+ * @param rTask Task to run
+ * @param priority Task priority
+ * @return Success (false if the queue is full)
+ */
+bool ThreadPool::Submit(Task& rTask, EPriority priority) {
+    K_ASSERT(priority < EPriority_Max);
+    K_ASSERT_EX(!rTask.IsBusy(), "Task is already queued or running");
+
+    AutoInterruptLock lock;
+
+    if (mIsExiting || mStats.numQueued >= mQueueSize) {
+        mStats.numRejected++;
+        return false;
+    }
+
+    rTask.mState = Task::EState_Queued;
+    rTask.mpNext = nullptr;
+
+    // Tasks of the same priority are run in order
+    if (mpQueueTails[priority] != nullptr) {
+        mpQueueTails[priority]->mpNext = &rTask;
+    } else {
+        mpQueueHeads[priority] = &rTask;
+    }
+
+    mpQueueTails[priority] = &rTask;
+
+    mStats.numSubmitted++;
+    mStats.numQueued++;
+    mStats.maxQueued = Max(mStats.maxQueued, mStats.numQueued);
+
+    if (!mIsStarted) {
+        StartThreads();
+    }
+
+    OSWakeupThread(&mWakeupQueue);
+    return true;
+}
+
+/**
+ * @brief Gets the pool statistics
+ */
+ThreadPool::Stats ThreadPool::GetStats() const {
+    AutoInterruptLock lock;
+    return mStats;
+}
+
+/**
+ * @brief Worker thread function
+ *
+ * @param pArg Thread function argument
+ */
+void* ThreadPool::ThreadFunc(void* pArg) {
+    K_ASSERT(pArg != nullptr);
+    ThreadPool& r = *static_cast<ThreadPool*>(pArg);
+
+    Task* pTask;
+    while ((pTask = r.WaitForTask()) != nullptr) {
+        pTask->Run();
+        pTask->OnComplete();
+
+        AutoInterruptLock lock;
+
+        r.mStats.numCompleted++;
+
+        // Waiters may destroy the task, so this is the last access to it
+        pTask->mState = Task::EState_Done;
+        OSWakeupThread(&pTask->mDoneQueue);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Starts the worker threads
+ */
+void ThreadPool::StartThreads() {
+    K_ASSERT(!mIsStarted);
+
+    for (u32 i = 0; i < mNumThreads; i++) {
+        u8* pStackTop = mpStacks + (i + 1) * mStackSize;
+
+        BOOL success = OSCreateThread(&mpThreads[i], ThreadFunc, this,
+                                      pStackTop, mStackSize, mPriority, 0);
+        K_ASSERT(success);
+
+        OSResumeThread(&mpThreads[i]);
+    }
+
+    mIsStarted = true;
+}
+
+/**
+ * @brief Removes the next task from the queue
+ * @note Sleeps until a task is submitted
+ *
+ * @return Next task, or nullptr if the pool is being destroyed
+ */
+Task* ThreadPool::WaitForTask() {
+    // Interrupts are disabled to avoid missing the wakeup signal
+    AutoInterruptLock lock;
+
+    while (true) {
+        for (int i = 0; i < EPriority_Max; i++) {
+            Task* pTask = mpQueueHeads[i];
+
+            if (pTask == nullptr) {
+                continue;
+            }
+
+            mpQueueHeads[i] = pTask->mpNext;
+
+            if (mpQueueHeads[i] == nullptr) {
+                mpQueueTails[i] = nullptr;
+            }
+
+            K_ASSERT(mStats.numQueued > 0);
+            mStats.numQueued--;
+
+            pTask->mpNext = nullptr;
+            pTask->mState = Task::EState_Running;
+            return pTask;
+        }
+
+        // Queue is drained, so the pool can go away
+        if (mIsExiting) {
+            return nullptr;
+        }
+
+        OSSleepThread(&mWakeupQueue);
+    }
+}
+
+} // namespace kiwi
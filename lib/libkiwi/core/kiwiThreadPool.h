@@ -0,0 +1,311 @@
+#ifndef LIBKIWI_CORE_THREAD_POOL_H
+#define LIBKIWI_CORE_THREAD_POOL_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+#include <revolution/OS.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_core
+//! @{
+
+/**
+ * @brief Thread pool task
+ * @details Derived classes hold the task's inputs and results, which must
+ * stay alive until the task is done. A task can be submitted again once it
+ * is done.
+ */
+class Task : private NonCopyable {
+    friend class ThreadPool;
+
+public:
+    /**
+     * @brief Task state
+     */
+    enum EState {
+        EState_Idle,    //!< Never submitted
+        EState_Queued,  //!< Waiting for a worker thread
+        EState_Running, //!< Running on a worker thread
+        EState_Done     //!< Finished running
+    };
+
+public:
+    /**
+     * @brief Constructor
+     */
+    Task() : mState(EState_Idle), mpNext(nullptr) {
+        OSInitThreadQueue(&mDoneQueue);
+    }
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~Task() {
+        K_ASSERT_EX(!IsBusy(), "Don't destroy a queued or running task");
+    }
+
+    /**
+     * @brief Gets the task state
+     */
+    EState GetState() const {
+        return mState;
+    }
+
+    /**
+     * @brief Tests whether the task is queued or running
+     */
+    bool IsBusy() const {
+        return mState == EState_Queued || mState == EState_Running;
+    }
+    /**
+     * @brief Tests whether the task has finished running
+     */
+    bool IsDone() const {
+        return mState == EState_Done;
+    }
+
+    /**
+     * @brief Waits for the task to finish running
+     * @note Not safe to call from interrupt context
+     */
+    void Wait();
+
+protected:
+    /**
+     * @brief Runs the task
+     * @note Called from a worker thread
+     */
+    virtual void Run() = 0;
+
+    /**
+     * @brief Handles task completion
+     * @note Called from the worker thread before the task is marked as done.
+     * The task is still busy, so it must not delete or resubmit itself.
+     */
+    virtual void OnComplete() {}
+
+private:
+    volatile EState mState;   // Task state
+    Task* mpNext;             // Next task in the pool queue
+    OSThreadQueue mDoneQueue; // Threads waiting for the task
+};
+
+/**
+ * @brief Thread pool task which calls a function
+ * @details The function's return value is kept as the task result, and the
+ * completion callback (if any) is called with it from the worker thread.
+ */
+class FuncTask : public Task {
+public:
+    //! Task function
+    typedef void* (*Func)(void* pArg);
+    //! Completion callback
+    typedef void (*Callback)(void* pResult, void* pArg);
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param pFunc Task function
+     * @param pArg Task function argument
+     * @param pCallback Completion callback
+     * @param pCallbackArg Completion callback argument
+     */
+    explicit FuncTask(Func pFunc, void* pArg = nullptr,
+                      Callback pCallback = nullptr,
+                      void* pCallbackArg = nullptr)
+        : mpFunc(pFunc),
+          mpArg(pArg),
+          mpCallback(pCallback),
+          mpCallbackArg(pCallbackArg),
+          mpResult(nullptr) {
+
+        K_ASSERT(pFunc != nullptr);
+    }
+
+    /**
+     * @brief Gets the task function's return value
+     */
+    void* GetResult() const {
+        K_ASSERT_EX(IsDone(), "Task is not done yet");
+        return mpResult;
+    }
+
+protected:
+    /**
+     * @brief Runs the task
+     * @note Called from a worker thread
+     */
+    virtual void Run() {
+        mpResult = mpFunc(mpArg);
+    }
+
+    /**
+     * @brief Handles task completion
+     * @note Called from the worker thread before the task is marked as done
+     */
+    virtual void OnComplete() {
+        if (mpCallback != nullptr) {
+            mpCallback(mpResult, mpCallbackArg);
+        }
+    }
+
+private:
+    Func mpFunc;         // Task function
+    void* mpArg;         // Task function argument
+    Callback mpCallback; // Completion callback
+    void* mpCallbackArg; // Completion callback argument
+    void* mpResult;      // Task function return value
+};
+
+/**
+ * @brief Worker thread pool
+ * @details Worker threads and their stacks are created once, and then run
+ * submitted tasks in priority order (first-in, first-out within a priority).
+ * The task queue is bounded, and tasks are linked through themselves, so
+ * submitting a task never allocates memory.
+ *
+ * The threads are only started by the first submitted task, so a pool which
+ * is never used doesn't keep idle threads around.
+ */
+class ThreadPool : private NonCopyable {
+public:
+    /**
+     * @brief Task priority
+     */
+    enum EPriority {
+        EPriority_High,   //!< Runs before anything else
+        EPriority_Normal, //!< Default priority
+        EPriority_Low,    //!< Runs when nothing else is queued
+
+        EPriority_Max
+    };
+
+    /**
+     * @brief Pool statistics
+     */
+    struct Stats {
+        u32 numSubmitted; // Number of submitted tasks
+        u32 numCompleted; // Number of completed tasks
+        u32 numRejected;  // Number of tasks rejected by a full queue
+        u32 numQueued;    // Number of tasks waiting for a worker thread
+        u32 maxQueued;    // Largest number of tasks waiting
+    };
+
+    //! Default worker thread stack size
+    static const u32 DEFAULT_STACK_SIZE = 0x4000;
+    //! Default worker thread priority (lower than the game's main thread)
+    static const s32 DEFAULT_PRIORITY = 20;
+    //! Default largest number of queued tasks
+    static const u32 DEFAULT_QUEUE_SIZE = 32;
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param numThreads Number of worker threads
+     * @param stackSize Worker thread stack size
+     * @param priority Worker thread priority
+     * @param queueSize Largest number of queued tasks
+     */
+    explicit ThreadPool(u32 numThreads = 1,
+                        u32 stackSize = DEFAULT_STACK_SIZE,
+                        s32 priority = DEFAULT_PRIORITY,
+                        u32 queueSize = DEFAULT_QUEUE_SIZE);
+
+    /**
+     * @brief Destructor
+     * @note Queued tasks are run before the worker threads exit
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Creates the shared pool for general background work
+     * @details Its worker threads start once the first task is submitted
+     * @note Call this during startup, before the shared pool is used
+     */
+    static void CreateDefault();
+    /**
+     * @brief Destroys the shared pool for general background work
+     */
+    static void DestroyDefault();
+    /**
+     * @brief Gets the shared pool for general background work
+     * @note Safe to call from interrupt context
+     */
+    static ThreadPool& GetDefault() {
+        K_ASSERT_EX(spDefault != nullptr, "Call CreateDefault first");
+        return *spDefault;
+    }
+
+    /**
+     * @brief Submits a task to the pool
+     * @note Safe to call from interrupt context
+     *
+     * @param rTask Task to run
+     * @param priority Task priority
+     * @return Success (false if the queue is full)
+     */
+    bool Submit(Task& rTask, EPriority priority = EPriority_Normal);
+
+    /**
+     * @brief Gets the number of worker threads
+     */
+    u32 GetNumThreads() const {
+        return mNumThreads;
+    }
+
+    /**
+     * @brief Gets the pool statistics
+     */
+    Stats GetStats() const;
+
+private:
+    /**
+     * @brief Worker thread function
+     *
+     * @param pArg Thread function argument
+     */
+    static void* ThreadFunc(void* pArg);
+
+    /**
+     * @brief Starts the worker threads
+     */
+    void StartThreads();
+
+    /**
+     * @brief Removes the next task from the queue
+     * @note Sleeps until a task is submitted
+     *
+     * @return Next task, or nullptr if the pool is being destroyed
+     */
+    Task* WaitForTask();
+
+private:
+    //! Number of worker threads in the shared pool
+    static const u32 scDefaultNumThreads = 2;
+
+    static ThreadPool* spDefault; // Shared pool
+
+    OSThread* mpThreads; // Worker threads
+    u8* mpStacks;        // Worker thread stacks
+    u32 mNumThreads;     // Number of worker threads
+    u32 mStackSize;      // Worker thread stack size
+    s32 mPriority;       // Worker thread priority
+    bool mIsStarted;     // Whether the worker threads have started
+
+    OSThreadQueue mWakeupQueue; // Idle worker threads
+    bool mIsExiting;            // Whether the pool is being destroyed
+
+    Task* mpQueueHeads[EPriority_Max]; // Oldest queued task per priority
+    Task* mpQueueTails[EPriority_Max]; // Newest queued task per priority
+    u32 mQueueSize;                    // Largest number of queued tasks
+
+    Stats mStats; // Pool statistics
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
@@ -11,21 +11,24 @@ namespace kiwi {
 
 /**
  * @brief Finalizes the hash and returns the digest
+ * @details The digest is printed as uppercase hex
  */
 String SHA1::Finalize() {
-    u8 buffer[20];
-    detail::SHA1Final(buffer, &mContext);
+    u8 buffer[DIGEST_SIZE];
+    Finalize(buffer);
 
-    // Space for 20 bytes printed as hex
+    // Space for the digest printed as hex
     String digest;
-    digest.Reserve(20 * 2);
+    digest.Reserve(DIGEST_SIZE * 2);
 
     // Convert nibbles to characters
     static const char sHexDigits[] = "0123456789ABCDEF";
     for (int i = 0; i < LENGTHOF(buffer); i++) {
-        digest[i * 2 + 0] = sHexDigits[(buffer[i] & 0xF0) >> 8];
-        digest[i * 2 + 1] = sHexDigits[(buffer[i] & 0x0F) >> 0];
+        digest += sHexDigits[(buffer[i] & 0xF0) >> 4];
+        digest += sHexDigits[(buffer[i] & 0x0F) >> 0];
     }
+
+    return digest;
 }
 
 namespace detail {
@@ -59,6 +59,10 @@ void SHA1Final(u8 pDigest[20], SHA1_CTX* pContext);
  * @brief SHA-1 hash algorithm
  */
 class SHA1 {
+public:
+    //! Size of the digest, in bytes
+    static const u32 DIGEST_SIZE = 20;
+
 public:
     /**
      * @brief Constructor
@@ -79,8 +83,17 @@ public:
 
     /**
      * @brief Finalizes the hash and returns the digest
+     * @details The digest is printed as uppercase hex
      */
     String Finalize();
+    /**
+     * @brief Finalizes the hash and writes out the binary digest
+     *
+     * @param[out] pDigest Digest buffer (DIGEST_SIZE bytes)
+     */
+    void Finalize(u8* pDigest) {
+        detail::SHA1Final(pDigest, &mContext);
+    }
 
 private:
     detail::SHA1_CTX mContext; //!< Hash context
@@ -1,17 +1,74 @@
 #include <libkiwi.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
 namespace kiwi {
+namespace {
+
+/**
+ * @brief Orders symbols by address
+ */
+struct AddressLess {
+    bool operator()(const MapFile::Symbol& rLhs,
+                    const MapFile::Symbol& rRhs) const {
+        return rLhs.offset < rRhs.offset;
+    }
+};
+
+/**
+ * @brief Orders symbol indices by symbol name
+ */
+struct NameLess {
+    explicit NameLess(const MapFile::Symbol* pSymbols) : pSymbols(pSymbols) {}
+
+    bool operator()(u32 lhs, u32 rhs) const {
+        return std::strcmp(pSymbols[lhs].pName, pSymbols[rhs].pName) < 0;
+    }
+
+    const MapFile::Symbol* pSymbols;
+};
+
+/**
+ * @brief Compares a symbol name against a lookup key (like strcmp)
+ *
+ * @param pName Symbol name
+ * @param rKey Lookup key
+ */
+int CompareName(const char* pName, const StringView& rKey) {
+    int diff = std::strncmp(pName, rKey.Data(), rKey.Length());
+    if (diff != 0) {
+        return diff;
+    }
+
+    // Key is a prefix of the name
+    return pName[rKey.Length()] == '\0' ? 0 : 1;
+}
+
+} // namespace
 
 K_DYNAMIC_SINGLETON_IMPL(MapFile);
 
+/**
+ * @brief Resolves the symbol's address
+ */
+const void* MapFile::Symbol::GetAddress() const {
+    return type == ELinkType_Static ? pAddr
+                                    : AddToPtr(GetModuleTextStart(), offset);
+}
+
 /**
  * @brief Constructor
  */
 MapFile::MapFile()
-    : mLinkType(ELinkType_None), mpMapBuffer(nullptr), mIsUnpacked(false) {}
+    : mLinkType(ELinkType_None),
+      mpMapBuffer(nullptr),
+      mIsUnpacked(false),
+      mpSymbols(nullptr),
+      mNumSymbols(0),
+      mpNameIndex(nullptr),
+      mOpenTask(*this) {}
 
 /**
  * @brief Destructor
@@ -22,120 +79,384 @@ MapFile::~MapFile() {
 
 /**
  * @brief Opens a map file from the DVD
+ * @details Text and binary (KMAP) map files are both supported
  *
  * @param rPath Map file path
  * @param type Module linkage type
  */
 void MapFile::Open(const String& rPath, ELinkType type) {
+    WaitAsync();
+    OpenImpl(rPath, type);
+}
+
+/**
+ * @brief Opens a map file from the DVD on the shared thread pool
+ * @details Symbols can't be queried until the map file is loaded (see
+ * IsAvailable), but the caller doesn't wait for the DVD or for parsing.
+ *
+ * @param rPath Map file path
+ * @param type Module linkage type
+ */
+void MapFile::OpenAsync(const String& rPath, ELinkType type) {
+    K_ASSERT(type != ELinkType_None);
+
+    // Only one load can be in progress
+    WaitAsync();
+    mOpenTask.Set(rPath, type);
+
+    // Symbols are only needed for debugging output, so anything else can go
+    // first. The map file is loaded right away if the queue is full.
+    if (!ThreadPool::GetDefault().Submit(mOpenTask,
+                                         ThreadPool::EPriority_Low)) {
+        OpenImpl(rPath, type);
+    }
+}
+
+/**
+ * @brief Closes map file
+ */
+void MapFile::Close() {
+    WaitAsync();
+    CloseImpl();
+}
+
+/**
+ * @brief Opens a map file from the DVD (internal implementation)
+ *
+ * @param rPath Map file path
+ * @param type Module linkage type
+ */
+void MapFile::OpenImpl(const String& rPath, ELinkType type) {
     K_ASSERT(type != ELinkType_None);
 
     // Close existing map file
     if (mpMapBuffer != nullptr) {
-        Close();
+        CloseImpl();
     }
 
+    u32 size = 0;
+    FileRipperArg arg;
+    arg.pSize = &size;
+
     // Try to open file on the DVD
-    mpMapBuffer = static_cast<char*>(FileRipper::Rip(rPath, EStorage_DVD));
+    mpMapBuffer =
+        static_cast<char*>(FileRipper::Rip(rPath, EStorage_DVD, arg));
     if (mpMapBuffer == nullptr) {
         K_LOG_EX("Map file (%s) could not be opened!\n", rPath.CStr());
         return;
     }
 
     mLinkType = type;
-    Unpack();
+
+    // Precompiled map files don't need to be parsed
+    if (size >= sizeof(Header) &&
+        reinterpret_cast<Header*>(mpMapBuffer)->block.kind ==
+            GetBinaryKind()) {
+        Deserialize(mpMapBuffer);
+    } else {
+        Unpack(size);
+    }
 }
 
 /**
- * @brief Closes map file
+ * @brief Closes map file (internal implementation)
  */
-void MapFile::Close() {
-    TList<Symbol>::Iterator it = mSymbols.Begin();
-    for (; it != mSymbols.End(); it++) {
-        TList<Symbol>::Iterator next = it++;
-        mSymbols.Erase(next);
-        delete &*next;
-    }
+void MapFile::CloseImpl() {
+    mIsUnpacked = false;
 
-    delete mpMapBuffer;
+    delete[] mpSymbols;
+    mpSymbols = nullptr;
+    mNumSymbols = 0;
+
+    delete[] mpNameIndex;
+    mpNameIndex = nullptr;
+
+    delete[] mpMapBuffer;
     mpMapBuffer = nullptr;
+}
 
-    mIsUnpacked = false;
+/**
+ * @brief Waits for an asynchronous load to finish
+ */
+void MapFile::WaitAsync() {
+    if (mOpenTask.IsBusy()) {
+        mOpenTask.Wait();
+    }
 }
 
 /**
  * @brief Queries text section symbol
  *
  * @param pAddr Symbol address
+ * @return Symbol containing the address, if one exists
  */
 const MapFile::Symbol* MapFile::QueryTextSymbol(const void* pAddr) const {
     if (!IsAvailable()) {
         return nullptr;
     }
 
-    TList<Symbol>::ConstIterator it = mSymbols.Begin();
-    for (; it != mSymbols.End(); it++) {
-        // Resolve the symbol's address
-        const void* pResolved =
-            it->type == ELinkType_Static
-                ? it->pAddr
-                : AddToPtr(GetModuleTextStart(), it->offset);
+    // Symbols are sorted by their packed location
+    u32 key = mLinkType == ELinkType_Static
+                  ? reinterpret_cast<u32>(pAddr)
+                  : PtrDistance(GetModuleTextStart(), pAddr);
+
+    // Find the first symbol that starts after the address
+    u32 lo = 0;
+    u32 hi = mNumSymbols;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+
+        if (mpSymbols[mid].offset <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Address is before the first symbol
+    if (lo == 0) {
+        return nullptr;
+    }
+
+    // Determine if the specified address falls within the previous symbol
+    const Symbol& rSymbol = mpSymbols[lo - 1];
+    if (key - rSymbol.offset >= rSymbol.size) {
+        return nullptr;
+    }
+
+    return &rSymbol;
+}
+
+/**
+ * @brief Queries symbol by name
+ *
+ * @param rName Mangled symbol name
+ * @return Symbol with the specified name, if one exists
+ */
+const MapFile::Symbol* MapFile::QuerySymbol(const StringView& rName) const {
+    if (!IsAvailable()) {
+        return nullptr;
+    }
+
+    // Find the first symbol whose name is not less than the key
+    u32 lo = 0;
+    u32 hi = mNumSymbols;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
 
-        // Determine if the specified address falls within the symbol
-        if (PtrDistance(pResolved, pAddr) < it->size) {
-            return &*it;
+        if (CompareName(mpSymbols[mpNameIndex[mid]].pName, rName) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
 
-    return nullptr;
+    if (lo == mNumSymbols) {
+        return nullptr;
+    }
+
+    const Symbol& rSymbol = mpSymbols[mpNameIndex[lo]];
+    if (CompareName(rSymbol.pName, rName) != 0) {
+        return nullptr;
+    }
+
+    return &rSymbol;
+}
+
+/**
+ * @brief Gets the serialized size of this object
+ */
+u32 MapFile::GetBinarySize() const {
+    u32 poolSize = 0;
+    for (u32 i = 0; i < mNumSymbols; i++) {
+        poolSize += std::strlen(mpSymbols[i].pName) + 1;
+    }
+
+    return sizeof(Header) +
+           (sizeof(SYMBBlock) + mNumSymbols * sizeof(BinSymbol)) +
+           (sizeof(NAMEBlock) + mNumSymbols * sizeof(u32)) +
+           (sizeof(STRSBlock) + poolSize);
 }
 
 /**
- * @brief Unpacks loaded map file
+ * @brief Unpacks loaded text map file
+ *
+ * @param size Map file size
  */
-void MapFile::Unpack() {
+void MapFile::Unpack(u32 size) {
     K_ASSERT(mpMapBuffer != nullptr);
 
-    // Skip map file header (2 lines)
     char* pIt = mpMapBuffer;
-    for (int i = 0; i < 2; i++) {
-        pIt = std::strchr(pIt, '\n') + 1;
+    char* pEnd = mpMapBuffer + size;
+
+    // Skip map file header (2 lines)
+    for (int i = 0; i < 2 && pIt < pEnd; i++) {
+        char* pEndl = static_cast<char*>(std::memchr(pIt, '\n', pEnd - pIt));
+        pIt = pEndl != nullptr ? pEndl + 1 : pEnd;
     }
 
+    // Count lines so all symbols fit in one allocation
+    u32 maxSymbols = 0;
+    for (char* pEndl = pIt;
+         (pEndl = static_cast<char*>(std::memchr(pEndl, '\n', pEnd - pEndl)));
+         pEndl++) {
+        maxSymbols++;
+    }
+
+    mpSymbols = new Symbol[maxSymbols];
+    K_ASSERT(mpSymbols != nullptr);
+
     // Parse lines
-    for (char* pEndl = pIt; (pEndl = std::strchr(pIt, '\n')); pIt = pEndl + 1) {
-        Symbol* sym = new Symbol();
-        K_ASSERT(sym != nullptr);
+    for (char* pEndl = pIt;
+         (pEndl = static_cast<char*>(std::memchr(pIt, '\n', pEnd - pIt)));
+         pIt = pEndl + 1) {
+        // Terminate symbol string
+        *pEndl = '\0';
+        // Remove carriage return
+        if (pEndl > pIt && *(pEndl - 1) == '\r') {
+            *(pEndl - 1) = '\0';
+        }
+
+        // Skip blank lines
+        if (*pIt == '\0') {
+            continue;
+        }
+
+        Symbol& rSymbol = mpSymbols[mNumSymbols++];
 
         // Location
         if (mLinkType == ELinkType_Static) {
-            sym->pAddr = reinterpret_cast<void*>(std::strtoul(pIt, &pIt, 16));
+            rSymbol.pAddr =
+                reinterpret_cast<void*>(std::strtoul(pIt, &pIt, 16));
         } else {
-            sym->offset = std::strtoul(pIt, &pIt, 16);
+            rSymbol.offset = std::strtoul(pIt, &pIt, 16);
         }
 
         // Linkage
-        sym->type = mLinkType;
+        rSymbol.type = mLinkType;
 
         // Size
-        sym->size = std::strtoul(pIt, &pIt, 16);
+        rSymbol.size = std::strtoul(pIt, &pIt, 16);
 
         // Trim whitespace from name
         while (*pIt == ' ') {
             pIt++;
         }
-        sym->pName = pIt;
+        rSymbol.pName = pIt;
+    }
 
-        // Terminate symbol string
-        *pEndl = '\0';
-        // Remove carriage return
-        if (*(pEndl - 1) == '\r') {
-            *(pEndl - 1) = '\0';
+    SortSymbols();
+    BuildNameIndex();
+
+    mIsUnpacked = true;
+}
+
+/**
+ * @brief Sorts the symbols by address
+ */
+void MapFile::SortSymbols() {
+    // Linker output is usually sorted already
+    for (u32 i = 1; i < mNumSymbols; i++) {
+        if (mpSymbols[i].offset < mpSymbols[i - 1].offset) {
+            std::sort(mpSymbols, mpSymbols + mNumSymbols, AddressLess());
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Builds the name lookup index
+ */
+void MapFile::BuildNameIndex() {
+    delete[] mpNameIndex;
+
+    mpNameIndex = new u32[mNumSymbols];
+    K_ASSERT(mpNameIndex != nullptr);
+
+    for (u32 i = 0; i < mNumSymbols; i++) {
+        mpNameIndex[i] = i;
+    }
+
+    std::sort(mpNameIndex, mpNameIndex + mNumSymbols, NameLess(mpSymbols));
+}
+
+/**
+ * @brief Deserializes binary contents (internal implementation)
+ *
+ * @param rHeader Binary file header
+ */
+void MapFile::DeserializeImpl(const Header& rHeader) {
+    const SYMBBlock* pSymbBlock = nullptr;
+    const NAMEBlock* pNameBlock = nullptr;
+    const STRSBlock* pStrsBlock = nullptr;
+
+    // Find first block
+    const Block* block = AddToPtr<const Block>(&rHeader, rHeader.block.size);
+
+    // Parse blocks
+    for (int i = 0; i < rHeader.numBlocks; i++) {
+        // Check block kind
+        switch (block->kind) {
+        case SYMBBlock::KIND:
+            pSymbBlock = static_cast<const SYMBBlock*>(block);
+            break;
+        case NAMEBlock::KIND:
+            pNameBlock = static_cast<const NAMEBlock*>(block);
+            break;
+        case STRSBlock::KIND:
+            pStrsBlock = static_cast<const STRSBlock*>(block);
+            break;
+        default:
+            K_ASSERT_EX(false, "Unknown block kind: %s (%08X)", block->Kind(),
+                        block->kind);
+            break;
         }
 
-        mSymbols.PushBack(sym);
+        // Advance block pointer
+        block = AddToPtr<const Block>(block, block->size);
+    }
+
+    K_ASSERT_EX(pSymbBlock != nullptr && pStrsBlock != nullptr,
+                "Map file is missing symbols");
+
+    mNumSymbols = pSymbBlock->numSym;
+    mpSymbols = new Symbol[mNumSymbols];
+    K_ASSERT(mpSymbols != nullptr);
+
+    // Symbols are already sorted by the build tool
+    for (u32 i = 0; i < mNumSymbols; i++) {
+        const BinSymbol& rBinSymbol = pSymbBlock->symbols[i];
+        K_ASSERT(rBinSymbol.name < pStrsBlock->poolSize);
+
+        mpSymbols[i].type = mLinkType;
+        mpSymbols[i].offset = rBinSymbol.addr;
+        mpSymbols[i].size = rBinSymbol.size;
+        mpSymbols[i].pName = pStrsBlock->poolData + rBinSymbol.name;
+    }
+
+    // Name index is optional
+    if (pNameBlock != nullptr && pNameBlock->numSym == mNumSymbols) {
+        mpNameIndex = new u32[mNumSymbols];
+        K_ASSERT(mpNameIndex != nullptr);
+
+        std::memcpy(mpNameIndex, pNameBlock->indices,
+                    mNumSymbols * sizeof(u32));
+    } else {
+        BuildNameIndex();
     }
 
     mIsUnpacked = true;
 }
 
+/**
+ * @brief Serializes binary contents (internal implementation)
+ *
+ * @param rHeader Binary file header
+ */
+void MapFile::SerializeImpl(Header& /* rHeader */) const {
+    K_ASSERT_EX(false, "Not supported.");
+}
+
 } // namespace kiwi
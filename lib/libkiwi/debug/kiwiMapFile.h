@@ -1,7 +1,10 @@
 #ifndef LIBKIWI_DEBUG_MAP_FILE_H
 #define LIBKIWI_DEBUG_MAP_FILE_H
+#include <libkiwi/core/kiwiIBinary.h>
+#include <libkiwi/core/kiwiThreadPool.h>
 #include <libkiwi/k_types.h>
-#include <libkiwi/prim/kiwiLinkList.h>
+#include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/prim/kiwiStringView.h>
 #include <libkiwi/util/kiwiDynamicSingleton.h>
 
 namespace kiwi {
@@ -10,8 +13,11 @@ namespace kiwi {
 
 /**
  * @brief Kamek symbol map utility
+ * @details Supports both text map files and precompiled binary map files
+ * (KMAP, see tools/make_binary_map.py). Symbols are kept in one array sorted
+ * by address, so lookups are O(log n).
  */
-class MapFile : public DynamicSingleton<MapFile> {
+class MapFile : public DynamicSingleton<MapFile>, private IBinary {
     friend class DynamicSingleton<MapFile>;
 
 public:
@@ -28,13 +34,18 @@ public:
      * @brief Map file symbol
      */
     struct Symbol {
+        /**
+         * @brief Resolves the symbol's address
+         */
+        const void* GetAddress() const;
+
         ELinkType type; // Linkage
         union {
             void* pAddr; // Address (unpacked)
             u32 offset;  // Offset (packed)
         };
-        u32 size;    // Byte size
-        char* pName; // Mangled name
+        u32 size;          // Byte size
+        const char* pName; // Mangled name
     };
 
 public:
@@ -47,23 +58,150 @@ public:
 
     /**
      * @brief Opens a map file from the DVD
+     * @details Text and binary (KMAP) map files are both supported
      *
      * @param rPath Map file path
      * @param type Module linkage type
      */
     void Open(const String& rPath, ELinkType type);
+    /**
+     * @brief Opens a map file from the DVD on the shared thread pool
+     * @details Symbols can't be queried until the map file is loaded (see
+     * IsAvailable), but the caller doesn't wait for the DVD or for parsing.
+     *
+     * @param rPath Map file path
+     * @param type Module linkage type
+     */
+    void OpenAsync(const String& rPath, ELinkType type);
     /**
      * @brief Closes map file
      */
     void Close();
 
+    /**
+     * @brief Gets the number of symbols in the map file
+     */
+    u32 GetNumSymbols() const {
+        return mNumSymbols;
+    }
+
     /**
      * @brief Queries text section symbol
      *
      * @param pAddr Symbol address
+     * @return Symbol containing the address, if one exists
      */
     const Symbol* QueryTextSymbol(const void* pAddr) const;
 
+    /**
+     * @brief Queries symbol by name
+     *
+     * @param rName Mangled symbol name
+     * @return Symbol with the specified name, if one exists
+     */
+    const Symbol* QuerySymbol(const StringView& rName) const;
+
+    /**
+     * @brief Gets the kind/magic of this object
+     */
+    virtual u32 GetBinaryKind() const {
+        return 'KMAP';
+    }
+
+    /**
+     * @brief Gets the serialized size of this object
+     */
+    virtual u32 GetBinarySize() const;
+
+    /**
+     * @brief Gets the expected version of this object
+     */
+    virtual u16 GetVersion() const {
+        return K_VERSION(1, 0);
+    }
+
+private:
+    /**
+     * @brief Binary map file symbol
+     */
+    struct BinSymbol {
+        /* 0x00 */ u32 addr; //!< Address (static) or offset (relocatable)
+        /* 0x04 */ u32 size; //!< Byte size
+        /* 0x08 */ u32 name; //!< Name offset in the string pool
+    };
+
+    /**
+     * @brief Symbol table block
+     */
+    struct SYMBBlock : Block {
+        //! Block signature
+        static const u32 KIND = 'SYMB';
+
+        /* 0x08 */ u32 numSym;          //!< Number of symbols
+        /* 0x0C */ BinSymbol symbols[]; //!< Symbols (sorted by address)
+    };
+
+    /**
+     * @brief Symbol name index block
+     */
+    struct NAMEBlock : Block {
+        //! Block signature
+        static const u32 KIND = 'NAME';
+
+        /* 0x08 */ u32 numSym;    //!< Number of symbols
+        /* 0x0C */ u32 indices[]; //!< Symbol indices (sorted by name)
+    };
+
+    /**
+     * @brief Symbol string pool block
+     */
+    struct STRSBlock : Block {
+        //! Block signature
+        static const u32 KIND = 'STRS';
+
+        /* 0x08 */ u32 poolSize;    //!< String pool data size
+        /* 0x0C */ char poolData[]; //!< String pool data
+    };
+
+    /**
+     * @brief Map file loading task
+     */
+    class OpenTask : public Task {
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param rMapFile Map file to load into
+         */
+        explicit OpenTask(MapFile& rMapFile)
+            : mrMapFile(rMapFile), mLinkType(ELinkType_None) {}
+
+        /**
+         * @brief Sets the map file to load
+         *
+         * @param rPath Map file path
+         * @param type Module linkage type
+         */
+        void Set(const String& rPath, ELinkType type) {
+            mPath = rPath;
+            mLinkType = type;
+        }
+
+    protected:
+        /**
+         * @brief Runs the task
+         * @note Called from a worker thread
+         */
+        virtual void Run() {
+            mrMapFile.OpenImpl(mPath, mLinkType);
+        }
+
+    private:
+        MapFile& mrMapFile;  // Map file to load into
+        String mPath;        // Map file path
+        ELinkType mLinkType; // Module linkage type
+    };
+
 private:
     /**
      * @brief Constructor
@@ -75,15 +213,62 @@ private:
     virtual ~MapFile();
 
     /**
-     * @brief Unpacks loaded map file
+     * @brief Opens a map file from the DVD (internal implementation)
+     *
+     * @param rPath Map file path
+     * @param type Module linkage type
+     */
+    void OpenImpl(const String& rPath, ELinkType type);
+    /**
+     * @brief Closes map file (internal implementation)
+     */
+    void CloseImpl();
+    /**
+     * @brief Waits for an asynchronous load to finish
      */
-    void Unpack();
+    void WaitAsync();
+
+    /**
+     * @brief Unpacks loaded text map file
+     *
+     * @param size Map file size
+     */
+    void Unpack(u32 size);
+
+    /**
+     * @brief Sorts the symbols by address
+     */
+    void SortSymbols();
+    /**
+     * @brief Builds the name lookup index
+     */
+    void BuildNameIndex();
+
+    /**
+     * @brief Deserializes binary contents (internal implementation)
+     *
+     * @param rHeader Binary file header
+     */
+    virtual void DeserializeImpl(const Header& rHeader);
+    /**
+     * @brief Serializes binary contents (internal implementation)
+     *
+     * @param rHeader Binary file header
+     */
+    virtual void SerializeImpl(Header& rHeader) const;
 
 private:
-    ELinkType mLinkType;    // Linkage
-    char* mpMapBuffer;      // Text buffer
-    bool mIsUnpacked;       // Whether the map has been unpacked
-    TList<Symbol> mSymbols; // Map symbols
+    ELinkType mLinkType; // Linkage
+    char* mpMapBuffer;   // File buffer
+
+    // Set last, as the map may be loaded on another thread
+    volatile bool mIsUnpacked; // Whether the map has been unpacked
+
+    Symbol* mpSymbols; // Map symbols (sorted by address)
+    u32 mNumSymbols;   // Number of map symbols
+    u32* mpNameIndex;  // Symbol indices (sorted by name)
+
+    OpenTask mOpenTask; // Asynchronous load
 };
 
 //! @}
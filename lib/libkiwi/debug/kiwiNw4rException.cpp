@@ -446,10 +446,7 @@ void Nw4rException::PrintSymbol(const void* pAddr) {
     }
 
     // Offset into function where exception occurred
-    u32 offset =
-        sym->type == MapFile::ELinkType_Relocatable
-            ? PtrDistance(AddToPtr(GetModuleTextStart(), sym->offset), pAddr)
-            : PtrDistance(sym->pAddr, pAddr);
+    u32 offset = PtrDistance(sym->GetAddress(), pAddr);
 
     // Print function name and instruction offset
     Printf("%s(+0x%04X)", sym->pName, offset);
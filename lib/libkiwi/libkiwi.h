@@ -1,6 +1,9 @@
 #ifndef LIBKIWI_H
 #define LIBKIWI_H
 
+#include <libkiwi/core/kiwiAllocProfiler.h>
+#include <libkiwi/core/kiwiAllocator.h>
+#include <libkiwi/core/kiwiArena.h>
 #include <libkiwi/core/kiwiColor.h>
 #include <libkiwi/core/kiwiConsoleOut.h>
 #include <libkiwi/core/kiwiController.h>
@@ -10,6 +13,8 @@
 #include <libkiwi/core/kiwiIScene.h>
 #include <libkiwi/core/kiwiIStream.h>
 #include <libkiwi/core/kiwiJSON.h>
+#include <libkiwi/core/kiwiJSONDocument.h>
+#include <libkiwi/core/kiwiJSONStream.h>
 #include <libkiwi/core/kiwiMemStream.h>
 #include <libkiwi/core/kiwiMemoryMgr.h>
 #include <libkiwi/core/kiwiMessage.h>
@@ -18,7 +23,9 @@
 #include <libkiwi/core/kiwiSPR.h>
 #include <libkiwi/core/kiwiSceneCreator.h>
 #include <libkiwi/core/kiwiSceneHookMgr.h>
+#include <libkiwi/core/kiwiSlabHeap.h>
 #include <libkiwi/core/kiwiThread.h>
+#include <libkiwi/core/kiwiThreadPool.h>
 #include <libkiwi/crypt/kiwiBase64.h>
 #include <libkiwi/crypt/kiwiChecksum.h>
 #include <libkiwi/crypt/kiwiSHA1.h>
@@ -36,9 +43,13 @@
 #include <libkiwi/math/kiwiAlgorithm.h>
 #include <libkiwi/net/kiwiAsyncSocket.h>
 #include <libkiwi/net/kiwiEmuRichPresenceClient.h>
+#include <libkiwi/net/kiwiHttpConnectionPool.h>
 #include <libkiwi/net/kiwiHttpRequest.h>
+#include <libkiwi/net/kiwiHttpResponseParser.h>
 #include <libkiwi/net/kiwiIRichPresenceClient.h>
+#include <libkiwi/net/kiwiNetStats.h>
 #include <libkiwi/net/kiwiPacket.h>
+#include <libkiwi/net/kiwiPacketRing.h>
 #include <libkiwi/net/kiwiReliableClient.h>
 #include <libkiwi/net/kiwiReliablePacket.h>
 #include <libkiwi/net/kiwiReliableSocket.h>
@@ -49,12 +60,14 @@
 #include <libkiwi/prim/kiwiArray.h>
 #include <libkiwi/prim/kiwiBitCast.h>
 #include <libkiwi/prim/kiwiHashMap.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
 #include <libkiwi/prim/kiwiLinkList.h>
 #include <libkiwi/prim/kiwiOptional.h>
 #include <libkiwi/prim/kiwiPair.h>
 #include <libkiwi/prim/kiwiSTL.h>
 #include <libkiwi/prim/kiwiSmartPtr.h>
 #include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/prim/kiwiStringView.h>
 #include <libkiwi/prim/kiwiVector.h>
 #include <libkiwi/support/kiwiLibGX.h>
 #include <libkiwi/support/kiwiLibOS.h>
@@ -66,7 +79,9 @@
 #include <libkiwi/util/kiwiExtension.h>
 #include <libkiwi/util/kiwiGlobalInstance.h>
 #include <libkiwi/util/kiwiIosDevice.h>
+#include <libkiwi/util/kiwiIosDispatcher.h>
 #include <libkiwi/util/kiwiIosObject.h>
+#include <libkiwi/util/kiwiIosScratch.h>
 #include <libkiwi/util/kiwiIosVector.h>
 #include <libkiwi/util/kiwiNonCopyable.h>
 #include <libkiwi/util/kiwiPtrUtil.h>
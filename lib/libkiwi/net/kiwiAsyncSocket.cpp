@@ -3,200 +3,725 @@
 namespace kiwi {
 
 /**
- * @brief Socket manager thread
+ * @brief Job queue lock
  */
-OSThread AsyncSocket::sSocketThread;
+OSMutex AsyncSocket::sJobMutex;
 
 /**
- * @brief Thread guard
+ * @brief Reactor/job statistics
  */
-bool AsyncSocket::sSocketThreadCreated = false;
+AsyncSocket::Stats AsyncSocket::sStats;
 
 /**
- * @brief Thread stack
+ * @brief Poll descriptor list
  */
-u8 AsyncSocket::sSocketThreadStack[scThreadStackSize];
+SOPollFD AsyncSocket::sPollFDs[scMaxPollFDs];
+
+/**
+ * @brief Number of polled sockets
+ */
+u32 AsyncSocket::sNumPollFDs = 0;
+
+/**
+ * @brief Whether a poll is in flight
+ */
+bool AsyncSocket::sIsPolling = false;
+
+/**
+ * @brief Loopback socket which restarts polls
+ */
+SOSocket AsyncSocket::sWakeHandle = -1;
+
+/**
+ * @brief Loopback socket address
+ */
+SockAddr4 AsyncSocket::sWakeAddr;
+
+/**
+ * @brief Wakeup send/receive buffer (MEM2)
+ */
+u8* AsyncSocket::spWakeBuffer = nullptr;
+
+/**
+ * @brief Whether the loopback socket was set up
+ */
+bool AsyncSocket::sIsWakeCreated = false;
+
+/**
+ * @brief Whether a wakeup is on its way
+ */
+bool AsyncSocket::sIsWakePending = false;
+
+/**
+ * @brief Whether a wakeup is being received
+ */
+bool AsyncSocket::sIsWakeDraining = false;
 
 /**
  * @brief Open async sockets
  */
-TList<AsyncSocket> AsyncSocket::sSocketList;
-
-/**
- * @brief Async receive operation
- */
-class AsyncSocket::RecvJob {
-public:
-    /**
-     * @brief Constructor
-     *
-     * @param pPacket Packet for this job
-     * @param pDst Destination address
-     * @param[out] pPeer Peer address
-     * @param pCallback Completion callback
-     * @param pArg Callback user argument
-     */
-    RecvJob(Packet* pPacket, void* pDst, SockAddrAny* pPeer,
-            Callback pCallback = nullptr, void* pArg = nullptr)
-        : mpPacket(pPacket),
-          mpDst(pDst),
-          mpPeer(pPeer),
-          mpCallback(pCallback),
-          mpArg(pArg) {
-        K_ASSERT(mpPacket != nullptr);
-        K_ASSERT(mpDst != nullptr);
-        K_ASSERT(OSIsMEM2Region(mpDst));
-    }
-
-    /**
-     * @brief Destructor
-     */
-    ~RecvJob() {
-        delete mpPacket;
+TIntrusiveList<AsyncSocket, &AsyncSocket::mNode> AsyncSocket::sSocketList;
+
+/**
+ * @brief Gets the reactor/job statistics
+ */
+AsyncSocket::Stats AsyncSocket::GetStats() {
+    AutoMutexLock lock(sJobMutex);
+    return sStats;
+}
+
+/**
+ * @brief Resets the reactor/job statistics
+ * @note Queue depth is not reset, as it reflects the current state
+ */
+void AsyncSocket::ResetStats() {
+    AutoMutexLock lock(sJobMutex);
+
+    u32 depth = sStats.queueDepth;
+    std::memset(&sStats, 0, sizeof(Stats));
+
+    sStats.queueDepth = depth;
+    sStats.maxQueueDepth = depth;
+}
+
+/**
+ * @brief Constructor
+ * @details Without a scatter list, the packet buffer must already be the
+ * destination memory.
+ *
+ * @param pSocket Owner socket
+ * @param pPacket Packet for this job
+ * @param pSegments Where to split up packet data (optional)
+ * @param num Number of segments
+ * @param[out] pPeer Peer address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ */
+AsyncSocket::RecvJob::RecvJob(AsyncSocket* pSocket, Packet* pPacket,
+                              const SockSegment* pSegments, u32 num,
+                              SockAddrAny* pPeer, Callback pCallback,
+                              void* pArg)
+    : mpSocket(pSocket),
+      mpPacket(pPacket),
+      mpSegments(nullptr),
+      mNumSegments(0),
+      mpPeer(pPeer),
+      mIsPosted(false),
+      mpCallback(pCallback),
+      mpArg(pArg) {
+    K_ASSERT(mpSocket != nullptr);
+    K_ASSERT(mpPacket != nullptr);
+
+    // Caller's segment list doesn't need to outlive the job
+    if (pSegments != nullptr && num > 0) {
+        mpSegments = new SockSegment[num];
+        K_ASSERT(mpSegments != nullptr);
+
+        std::memcpy(mpSegments, pSegments, num * sizeof(SockSegment));
+        mNumSegments = num;
     }
+}
+
+/**
+ * @brief Destructor
+ */
+AsyncSocket::RecvJob::~RecvJob() {
+    K_ASSERT_EX(!mIsPosted, "Don't destroy a job while it is in flight");
+
+    delete mpPacket;
+    delete[] mpSegments;
+}
+
+/**
+ * @brief Tests whether the receive operation is complete
+ */
+bool AsyncSocket::RecvJob::IsComplete() const {
+    K_ASSERT(mpPacket != nullptr);
+    return mpPacket->IsWriteComplete();
+}
+
+/**
+ * @brief Constructor
+ *
+ * @param pSocket Owner socket
+ * @param pPacket Packet for this job
+ * @param pRing Ring holding the packet (optional)
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ */
+AsyncSocket::SendJob::SendJob(AsyncSocket* pSocket, Packet* pPacket,
+                              PacketRing* pRing, Callback pCallback, void* pArg)
+    : mpSocket(pSocket),
+      mpPacket(pPacket),
+      mpRing(pRing),
+      mIsRingOwner(false),
+      mIsPosted(false),
+      mpCallback(pCallback),
+      mpArg(pArg) {
+    K_ASSERT(mpSocket != nullptr);
+    K_ASSERT(mpPacket != nullptr);
+}
+
+/**
+ * @brief Destructor
+ */
+AsyncSocket::SendJob::~SendJob() {
+    K_ASSERT_EX(!mIsPosted, "Don't destroy a job while it is in flight");
 
-    /**
-     * @brief Tests whether the receive operation is complete
-     */
-    bool IsComplete() const {
-        K_ASSERT(mpPacket != nullptr);
-        return mpPacket->IsWriteComplete();
+    // Ring slots belong to the ring
+    if (mpRing == nullptr) {
+        delete mpPacket;
+    } else if (mIsRingOwner) {
+        delete mpRing;
     }
+}
+
+/**
+ * @brief Tests whether the send operation is complete
+ */
+bool AsyncSocket::SendJob::IsComplete() const {
+    K_ASSERT(mpPacket != nullptr);
+    return mpPacket->IsReadComplete();
+}
 
-    /**
-     * @brief Updates job using the specified socket
-     *
-     * @param socket Socket descriptor
-     * @return Whether the job is complete
-     */
-    bool Calc(SOSocket socket) {
-        K_ASSERT(mpPacket != nullptr);
-        K_ASSERT(socket >= 0);
+/**
+ * @brief Receive completion callback
+ *
+ * @param result Bytes received or IOS error code
+ * @param pArg Receive job
+ */
+void AsyncSocket::RecvCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the job
+    RecvJob* pJob = static_cast<RecvJob*>(pArg);
+
+    Callback pCallback = nullptr;
+    void* pCallbackArg = nullptr;
+    SOResult status;
+
+    {
+        AutoMutexLock lock(sJobMutex);
+
+        pJob->mIsPosted = false;
 
-        // Nothing left to do
-        if (IsComplete()) {
-            return true;
+        // Socket was destroyed while the job was in flight
+        AsyncSocket* pSocket = pJob->mpSocket;
+        if (pSocket == nullptr) {
+            delete pJob;
+            return;
         }
 
-        // Update
-        mpPacket->Recv(socket);
-        bool done = IsComplete();
+        K_ASSERT(&pSocket->mRecvJobs.Front() == pJob);
+        NetStats::Count(pSocket->mCounters, NetStats::EOp_Recv, result);
 
-        // Write out data
-        if (done) {
-            K_ASSERT(mpDst != nullptr);
-            K_ASSERT(OSIsMEM2Region(mpDst));
+        // Datagrams arrive whole, so a short one still completes the job
+        bool isStream = pSocket->mType == SO_SOCK_STREAM;
 
-            std::memcpy(mpDst, mpPacket->GetContent(),
-                        mpPacket->GetContentSize());
+        if (result > 0) {
+            sStats.recvBytes += result;
 
-            // Write peer information
-            if (mpPeer != nullptr) {
-                *mpPeer = mpPacket->GetPeer();
+            // Rest of the data is most likely already on its way, so it is
+            // received directly rather than waiting for another poll
+            if (isStream && !pJob->IsComplete()) {
+                pSocket->SubmitRecv();
+                return;
             }
+        }
+
+        if (result < 0) {
+            status = static_cast<SOResult>(result);
+        } else if (isStream && !pJob->IsComplete()) {
+            // Peer closed the connection before the job finished
+            status = SO_ECONNRESET;
+        } else {
+            status = SO_SUCCESS;
+
+            // Data is already in place unless it must be split up
+            const u8* pContent =
+                static_cast<const u8*>(pJob->mpPacket->GetContent());
+
+            u32 remain = pJob->mpPacket->GetContentSize() -
+                         pJob->mpPacket->WriteRemain();
+
+            for (u32 i = 0; i < pJob->mNumSegments; i++) {
+                SockSegment& rSegment = pJob->mpSegments[i];
+
+                u32 n = Min(rSegment.size, remain);
+                std::memcpy(rSegment.pData, pContent, n);
 
-            // Notify user
-            if (mpCallback != nullptr) {
-                mpCallback(LibSO::GetLastError(), mpArg);
+                pContent += n;
+                remain -= n;
+            }
+
+            // Write peer information
+            if (pJob->mpPeer != nullptr) {
+                *pJob->mpPeer = pJob->mpPacket->GetPeer();
             }
         }
 
-        return done;
+        pCallback = pJob->mpCallback;
+        pCallbackArg = pJob->mpArg;
+
+        // Remove from queue
+        pSocket->mRecvJobs.PopFront();
+        UpdateQueueDepth(-1);
+        delete pJob;
+
+        // Start on the next job
+        pSocket->PostRecv();
+    }
+
+    // Callback may destroy the socket
+    if (pCallback != nullptr) {
+        pCallback(status, pCallbackArg);
     }
+}
+
+/**
+ * @brief Send completion callback
+ *
+ * @param result Bytes sent or IOS error code
+ * @param pArg Send job
+ */
+void AsyncSocket::SendCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the job
+    SendJob* pJob = static_cast<SendJob*>(pArg);
+
+    Callback pCallback = nullptr;
+    void* pCallbackArg = nullptr;
+    SOResult status;
+
+    {
+        AutoMutexLock lock(sJobMutex);
+
+        pJob->mIsPosted = false;
+
+        // Socket was destroyed while the job was in flight
+        AsyncSocket* pSocket = pJob->mpSocket;
+        if (pSocket == nullptr) {
+            delete pJob;
+            return;
+        }
+
+        K_ASSERT(&pSocket->mSendJobs.Front() == pJob);
+        NetStats::Count(pSocket->mCounters, NetStats::EOp_Send, result);
+
+        if (result > 0) {
+            sStats.sendBytes += result;
+
+            // Packet isn't complete yet
+            if (!pJob->IsComplete()) {
+                pSocket->PostSend();
+                return;
+            }
+        }
+
+        if (result < 0) {
+            status = static_cast<SOResult>(result);
+        } else if (!pJob->IsComplete()) {
+            // Nothing could be sent
+            status = SO_ECONNRESET;
+        } else {
+            status = SO_SUCCESS;
+        }
+
+        pCallback = pJob->mpCallback;
+        pCallbackArg = pJob->mpArg;
 
-private:
-    Packet* mpPacket;   // Packet to complete
-    void* mpDst;        // Where to store packet data
-    SOSockAddr* mpPeer; // Where to store peer address
+        // Ring slots are released in the order they were queued
+        if (pJob->mpRing != nullptr) {
+            K_ASSERT(pJob->mpRing->BeginPop() == pJob->mpPacket);
+            pJob->mpRing->EndPop();
+        }
+
+        // Remove from queue
+        pSocket->mSendJobs.PopFront();
+        UpdateQueueDepth(-1);
+        delete pJob;
 
-    Callback mpCallback; // Completion callback
-    void* mpArg;         // Completion callback user argument
-};
+        // Start on the next job
+        pSocket->PostSend();
+    }
+
+    // Callback may destroy the socket
+    if (pCallback != nullptr) {
+        pCallback(status, pCallbackArg);
+    }
+}
 
 /**
- * @brief Async send operation
+ * @brief Connect completion callback
+ *
+ * @param result IOS error code
+ * @param pArg Control job
  */
-class AsyncSocket::SendJob {
-public:
-    /**
-     * @brief Constructor
-     *
-     * @param pPacket Packet for this job
-     * @param pCallback Completion callback
-     * @param pArg Callback user argument
-     */
-    SendJob(Packet* pPacket, Callback pCallback = nullptr, void* pArg = nullptr)
-        : mpPacket(pPacket), mpCallback(pCallback), mpArg(pArg) {
-        K_ASSERT(mpPacket != nullptr);
+void AsyncSocket::ConnectCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the job
+    ControlJob* pJob = static_cast<ControlJob*>(pArg);
+
+    Callback pCallback = nullptr;
+    void* pCallbackArg = nullptr;
+
+    {
+        AutoMutexLock lock(sJobMutex);
+
+        AsyncSocket* pSocket = pJob->pSocket;
+        delete pJob;
+
+        // Socket was destroyed while the job was in flight
+        if (pSocket == nullptr) {
+            return;
+        }
+
+        pSocket->mpControlJob = nullptr;
+        NetStats::Count(pSocket->mCounters, NetStats::EOp_Connect, result);
+
+        pCallback = pSocket->mpConnectCallback;
+        pCallbackArg = pSocket->mpConnectCallbackArg;
     }
 
-    /**
-     * @brief Destructor
-     */
-    ~SendJob() {
-        delete mpPacket;
+    // Callback may destroy the socket
+    if (pCallback != nullptr) {
+        pCallback(result == SO_EISCONN ? SO_SUCCESS
+                                       : static_cast<SOResult>(result),
+                  pCallbackArg);
     }
+}
+
+/**
+ * @brief Accept completion callback
+ *
+ * @param result Peer descriptor or IOS error code
+ * @param pArg Control job
+ */
+void AsyncSocket::AcceptCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the job
+    ControlJob* pJob = static_cast<ControlJob*>(pArg);
+
+    AcceptCallback pCallback = nullptr;
+    void* pCallbackArg = nullptr;
+    AsyncSocket* pPeer = nullptr;
+    SockAddrAny peer;
+
+    {
+        AutoMutexLock lock(sJobMutex);
 
-    /**
-     * @brief Tests whether the send operation is complete
-     */
-    bool IsComplete() const {
-        K_ASSERT(mpPacket != nullptr);
-        return mpPacket->IsReadComplete();
+        AsyncSocket* pSocket = pJob->pSocket;
+        peer = pJob->peer;
+        delete pJob;
+
+        // Socket was destroyed while the job was in flight
+        if (pSocket == nullptr) {
+            // Nobody will own the peer connection
+            if (result >= 0) {
+                LibSO::Close(result);
+            }
+
+            return;
+        }
+
+        pSocket->mpControlJob = nullptr;
+
+        // Result code is the peer descriptor
+        if (result >= 0) {
+            pPeer = new AsyncSocket(result, pSocket->mFamily, pSocket->mType);
+            K_ASSERT(pPeer != nullptr);
+        }
+
+        pCallback = pSocket->mpAcceptCallback;
+        pCallbackArg = pSocket->mpAcceptCallbackArg;
+    }
+
+    // Callback may destroy the socket
+    if (pCallback != nullptr) {
+        pCallback(result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result),
+                  pPeer, peer, pCallbackArg);
     }
+}
 
-    /**
-     * @brief Updates job using the specified socket
-     *
-     * @param socket Socket descriptor
-     * @return Whether the job is complete
-     */
-    bool Calc(SOSocket socket) {
-        K_ASSERT(mpPacket != nullptr);
-        K_ASSERT(socket >= 0);
+/**
+ * @brief Poll completion callback
+ *
+ * @param result Number of ready sockets or IOS error code
+ * @param pArg Callback user argument
+ */
+void AsyncSocket::PollCallbackFunc(s32 result, void* pArg) {
+#pragma unused(pArg)
 
-        // Nothing left to do
-        if (IsComplete()) {
-            return true;
+    AutoMutexLock lock(sJobMutex);
+
+    sIsPolling = false;
+    sStats.wakeups++;
+
+    if (result == 0) {
+        sStats.timeouts++;
+
+        // Wakeup which didn't arrive in time was lost, so allow another one
+        sIsWakePending = false;
+    }
+
+    K_FOREACH (sSocketList) {
+        // Socket was added after the poll began
+        if (it->mPollIndex < 0) {
+            continue;
         }
 
-        // Update
-        mpPacket->Send(socket);
-        bool done = IsComplete();
+        const SOPollFD& rFD = sPollFDs[it->mPollIndex];
+        it->mPollIndex = -1;
+
+        if (!it->mIsRecvWaiting) {
+            continue;
+        }
 
-        // Fire callback
-        if (done && mpCallback != nullptr) {
-            mpCallback(LibSO::GetLastError(), mpArg);
+        // Receives go straight to IOS if the poll fails, rather than waiting
+        // on a poll which may keep failing
+        if (result < 0 ||
+            (rFD.fd == it->mHandle && (rFD.revents & scRecvEvents) != 0)) {
+            it->SubmitRecv();
         }
+    }
+
+    // Wakeup datagram must be received, or every poll would end right away.
+    // The next poll is armed once it has been.
+    if (result > 0 && sWakeHandle >= 0 && sPollFDs[0].fd == sWakeHandle &&
+        (sPollFDs[0].revents & scRecvEvents) != 0) {
+
+        sIsWakeDraining = true;
+        LibSO::RecvAsync(sWakeHandle, spWakeBuffer + scWakeBufferSize,
+                         scWakeBufferSize, 0, nullptr, WakeRecvCallbackFunc,
+                         nullptr);
+        return;
+    }
+
+    // Sockets which are still waiting (or started waiting) are polled again
+    ArmPoll();
+}
+
+/**
+ * @brief Wakeup send completion callback
+ *
+ * @param result Bytes sent or IOS error code
+ * @param pArg Callback user argument
+ */
+void AsyncSocket::WakeSendCallbackFunc(s32 result, void* pArg) {
+#pragma unused(pArg)
 
-        return done;
+    if (result >= 0) {
+        return;
     }
 
-private:
-    Packet* mpPacket; // Packet to complete
+    AutoMutexLock lock(sJobMutex);
 
-    Callback mpCallback; // Completion callback
-    void* mpArg;         // Completion callback user argument
-};
+    // Poll will end with its timeout instead
+    sIsWakePending = false;
+}
 
 /**
- * @brief Socket thread function
+ * @brief Wakeup receive completion callback
  *
- * @param pArg Thread function argument
+ * @param result Bytes received or IOS error code
+ * @param pArg Callback user argument
  */
-void* AsyncSocket::ThreadFunc(void* pArg) {
+void AsyncSocket::WakeRecvCallbackFunc(s32 result, void* pArg) {
 #pragma unused(pArg)
 
-    // Update all open sockets
-    while (true) {
-        for (TList<AsyncSocket>::Iterator it = sSocketList.Begin();
-             it != sSocketList.End(); it++) {
-            K_ASSERT(it->IsOpen());
-            it->Calc();
+    AutoMutexLock lock(sJobMutex);
+
+    sIsWakeDraining = false;
+    sIsWakePending = false;
+
+    // Broken loopback socket would keep the poll from waiting
+    if (result < 0) {
+        DestroyWakeSocket();
+    }
+
+    ArmPoll();
+}
+
+/**
+ * @brief Submits a poll for the sockets waiting to receive
+ * @details If a poll is already in flight, it is restarted so the new socket
+ * is included
+ */
+void AsyncSocket::ArmPoll() {
+    AutoMutexLock lock(sJobMutex);
+
+    if (sIsPolling) {
+        WakePoll();
+        return;
+    }
+
+    // Poll is armed again once the wakeup has been received
+    if (sIsWakeDraining) {
+        return;
+    }
+
+    if (!sIsWakeCreated) {
+        CreateWakeSocket();
+    }
+
+    sNumPollFDs = PreparePoll();
+    if (sNumPollFDs == 0) {
+        return;
+    }
+
+    // Without the loopback socket, new sockets must wait for the poll to end
+    u32 timeout = sWakeHandle >= 0 ? scPollTimeoutMsec : scPollFallbackMsec;
+
+    sIsPolling = true;
+    LibSO::PollAsync(sPollFDs, sNumPollFDs, OS_MSEC_TO_TICKS(timeout),
+                     PollCallbackFunc, nullptr);
+}
+
+/**
+ * @brief Builds the poll descriptor list from the open sockets
+ * @details Sockets which don't fit are moved to the front of the list, so
+ * they are polled first next time
+ *
+ * @return Number of descriptors to poll
+ */
+u32 AsyncSocket::PreparePoll() {
+    // First descriptor is reserved for the loopback socket
+    u32 first = sWakeHandle >= 0 ? 1 : 0;
+    u32 numfds = first;
+
+    AsyncSocket* pOverflow = nullptr;
+
+    K_FOREACH (sSocketList) {
+        it->mPollIndex = -1;
+
+        if (!it->mIsRecvWaiting) {
+            continue;
         }
+
+        // Closed sockets can't be polled, so their receive fails right away
+        if (!it->IsOpen()) {
+            it->SubmitRecv();
+            continue;
+        }
+
+        if (numfds >= scMaxPollFDs) {
+            if (pOverflow == nullptr) {
+                pOverflow = &*it;
+            }
+
+            continue;
+        }
+
+        it->mPollIndex = numfds;
+
+        SOPollFD& rFD = sPollFDs[numfds++];
+        rFD.fd = it->mHandle;
+        rFD.events = SO_POLLRDNORM;
+        rFD.revents = 0;
     }
 
-    return nullptr;
+    // Nothing to wait for
+    if (numfds == first) {
+        return 0;
+    }
+
+    if (first > 0) {
+        SOPollFD& rFD = sPollFDs[0];
+        rFD.fd = sWakeHandle;
+        rFD.events = SO_POLLRDNORM;
+        rFD.revents = 0;
+    }
+
+    // Rotate the list so sockets which didn't fit aren't starved
+    if (pOverflow != nullptr) {
+        K_LOG("Too many async sockets, some will be delayed\n");
+
+        while (&sSocketList.Front() != pOverflow) {
+            AsyncSocket& rSocket = sSocketList.Front();
+            sSocketList.PopFront();
+            sSocketList.PushBack(&rSocket);
+        }
+    }
+
+    return numfds;
+}
+
+/**
+ * @brief Creates the loopback socket used to restart polls
+ */
+void AsyncSocket::CreateWakeSocket() {
+    // Only try once, as failures won't fix themselves
+    sIsWakeCreated = true;
+
+    sWakeHandle = LibSO::Socket(SO_PF_INET, SO_SOCK_DGRAM);
+    if (sWakeHandle < 0) {
+        K_LOG_EX("Can't create wakeup socket (%d), polls won't restart\n",
+                 sWakeHandle);
+        sWakeHandle = -1;
+        return;
+    }
+
+    sWakeAddr = SockAddr4("127.0.0.1");
+
+    // IOS can't choose the port, so try a few in the private range
+    bool success = false;
+    for (int i = 0; i < 10 && !success; i++) {
+        sWakeAddr.port = Random().NextU32(49152, 65535);
+        success = LibSO::Bind(sWakeHandle, sWakeAddr) == SO_SUCCESS;
+    }
+
+    if (!success) {
+        K_LOG("Can't bind wakeup socket, polls won't restart\n");
+        DestroyWakeSocket();
+        return;
+    }
+
+    // Send and receive halves are kept apart
+    spWakeBuffer = new (32, EMemory_MEM2) u8[scWakeBufferSize * 2];
+    K_ASSERT(spWakeBuffer != nullptr);
+    std::memset(spWakeBuffer, 0, scWakeBufferSize * 2);
+}
+
+/**
+ * @brief Closes the loopback socket after an error
+ */
+void AsyncSocket::DestroyWakeSocket() {
+    if (sWakeHandle >= 0) {
+        LibSO::Close(sWakeHandle);
+        sWakeHandle = -1;
+    }
+
+    // Buffer may still be in use by a send, so it is kept
+}
+
+/**
+ * @brief Ends the poll in flight early by sending to the loopback socket
+ */
+void AsyncSocket::WakePoll() {
+    // One wakeup is enough to restart the poll
+    if (sWakeHandle < 0 || sIsWakePending) {
+        return;
+    }
+
+    sIsWakePending = true;
+    sStats.restarts++;
+
+    const SockAddrAny& rAddr = sWakeAddr;
+    LibSO::SendAsync(sWakeHandle, spWakeBuffer, 1, 0, &rAddr,
+                     WakeSendCallbackFunc, nullptr);
+}
+
+/**
+ * @brief Updates the queue depth statistics
+ *
+ * @param delta Change in the number of pending jobs
+ */
+void AsyncSocket::UpdateQueueDepth(s32 delta) {
+    sStats.queueDepth += delta;
+    sStats.maxQueueDepth = Max(sStats.maxQueueDepth, sStats.queueDepth);
 }
 
 /**
@@ -207,11 +732,15 @@ void* AsyncSocket::ThreadFunc(void* pArg) {
  */
 AsyncSocket::AsyncSocket(SOProtoFamily family, SOSockType type)
     : SocketBase(family, type),
-      mState(EState_Thinking),
+      mIsRecvWaiting(false),
+      mpSendRing(nullptr),
+      mIsRingClaimed(false),
+      mpControlJob(nullptr),
       mpConnectCallback(nullptr),
       mpConnectCallbackArg(nullptr),
       mpAcceptCallback(nullptr),
-      mpAcceptCallbackArg(nullptr) {
+      mpAcceptCallbackArg(nullptr),
+      mPollIndex(-1) {
     Initialize();
 }
 
@@ -224,34 +753,89 @@ AsyncSocket::AsyncSocket(SOProtoFamily family, SOSockType type)
  */
 AsyncSocket::AsyncSocket(SOSocket socket, SOProtoFamily family, SOSockType type)
     : SocketBase(socket, family, type),
-      mState(EState_Thinking),
+      mIsRecvWaiting(false),
+      mpSendRing(nullptr),
+      mIsRingClaimed(false),
+      mpControlJob(nullptr),
       mpConnectCallback(nullptr),
       mpConnectCallbackArg(nullptr),
       mpAcceptCallback(nullptr),
-      mpAcceptCallbackArg(nullptr) {
+      mpAcceptCallbackArg(nullptr),
+      mPollIndex(-1) {
     Initialize();
 }
 
+/**
+ * @brief Destructor
+ */
+AsyncSocket::~AsyncSocket() {
+    AutoMutexLock lock(sJobMutex);
+
+    // Reactor must not see this socket again
+    sSocketList.Remove(this);
+
+    // Jobs are owned by the socket, except for those still in flight. Closing
+    // the socket aborts them, and their callbacks finish the cleanup.
+    while (!mRecvJobs.Empty()) {
+        RecvJob& rJob = mRecvJobs.Front();
+        mRecvJobs.PopFront();
+        UpdateQueueDepth(-1);
+
+        if (rJob.mIsPosted) {
+            rJob.mpSocket = nullptr;
+        } else {
+            delete &rJob;
+        }
+    }
+
+    // Ring slot of the send in flight must outlive the socket
+    SendJob* pRingJob = nullptr;
+
+    while (!mSendJobs.Empty()) {
+        SendJob& rJob = mSendJobs.Front();
+        mSendJobs.PopFront();
+        UpdateQueueDepth(-1);
+
+        if (rJob.mIsPosted) {
+            rJob.mpSocket = nullptr;
+
+            if (rJob.mpRing != nullptr) {
+                pRingJob = &rJob;
+            }
+        } else {
+            delete &rJob;
+        }
+    }
+
+    // Job destroys the ring once it completes. Other queued slots don't need
+    // to be released, as nothing will push to the ring again.
+    if (pRingJob != nullptr) {
+        pRingJob->mIsRingOwner = true;
+    } else {
+        delete mpSendRing;
+    }
+
+    mpSendRing = nullptr;
+
+    if (mpControlJob != nullptr) {
+        mpControlJob->pSocket = nullptr;
+        mpControlJob = nullptr;
+    }
+}
+
 /**
  * @brief Prepares socket for async operation
  */
 void AsyncSocket::Initialize() {
-    // Make socket non-blocking
-    bool success = SetBlocking(false);
+    // Operations wait inside IOS rather than on this thread, so the socket
+    // must block (non-blocking sockets would just complete with EWOULDBLOCK)
+    bool success = SetBlocking(true);
     K_ASSERT(success);
 
-    // Thread needs to see this socket
-    sSocketList.PushBack(this);
-
-    // Thread must exist if there is an open socket
-    if (!sSocketThreadCreated) {
-        OSCreateThread(&sSocketThread, ThreadFunc, nullptr,
-                       sSocketThreadStack + sizeof(sSocketThreadStack),
-                       sizeof(sSocketThreadStack), OS_PRIORITY_MAX, 0);
+    AutoMutexLock lock(sJobMutex);
 
-        sSocketThreadCreated = true;
-        OSResumeThread(&sSocketThread);
-    }
+    // Reactor needs to see this socket
+    sSocketList.PushBack(this);
 }
 
 /**
@@ -266,12 +850,23 @@ bool AsyncSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
                           void* pArg) {
     K_ASSERT(IsOpen());
 
-    mState = EState_Connecting;
-    mPeer = rAddr;
+    AutoMutexLock lock(sJobMutex);
+
+    K_ASSERT_EX(mpControlJob == nullptr,
+                "Socket is already connecting/accepting");
+
+    mpControlJob = new ControlJob();
+    K_ASSERT(mpControlJob != nullptr);
+
+    mpControlJob->pSocket = this;
+    mpControlJob->peer = rAddr;
 
     mpConnectCallback = pCallback;
     mpConnectCallbackArg = pArg;
 
+    LibSO::ConnectAsync(mHandle, mpControlJob->peer, ConnectCallbackFunc,
+                        mpControlJob);
+
     // Connect doesn't actually happen on this thread
     return false;
 }
@@ -286,111 +881,230 @@ bool AsyncSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
 AsyncSocket* AsyncSocket::Accept(AcceptCallback pCallback, void* pArg) {
     K_ASSERT(IsOpen());
 
-    mState = EState_Accepting;
+    AutoMutexLock lock(sJobMutex);
+
+    K_ASSERT_EX(mpControlJob == nullptr,
+                "Socket is already connecting/accepting");
+
+    mpControlJob = new ControlJob();
+    K_ASSERT(mpControlJob != nullptr);
+
+    mpControlJob->pSocket = this;
+
+    // Address type hints to IOS which family to expect
+    if (mFamily == SO_PF_INET6) {
+        mpControlJob->peer = SockAddr6();
+    } else {
+        mpControlJob->peer = SockAddr4();
+    }
 
     mpAcceptCallback = pCallback;
     mpAcceptCallbackArg = pArg;
 
+    LibSO::AcceptAsync(mHandle, mpControlJob->peer, AcceptCallbackFunc,
+                       mpControlJob);
+
     // Accept doesn't actually happen on this thread
     return nullptr;
 }
 
 /**
- * @brief Processes pending socket tasks
+ * @brief Gets the send ring statistics
+ * @details The byte rate shows how close sends get to the link rate
  */
-void AsyncSocket::Calc() {
-    s32 result;
+PacketRing::Stats AsyncSocket::GetRingStats() const {
+    // Ring is only created once the socket sends something
+    if (mpSendRing == nullptr) {
+        PacketRing::Stats stats;
+        std::memset(&stats, 0, sizeof(PacketRing::Stats));
+        return stats;
+    }
 
-    K_ASSERT(IsOpen());
+    return mpSendRing->GetStats();
+}
+
+/**
+ * @brief Resets the send ring statistics
+ */
+void AsyncSocket::ResetRingStats() {
+    if (mpSendRing != nullptr) {
+        mpSendRing->ResetStats();
+    }
+}
 
-    switch (mState) {
-    case EState_Thinking:
-        CalcRecv();
-        CalcSend();
-        break;
+/**
+ * @brief Gets a send ring slot for an outgoing message
+ * @details The ring is left to the caller until the slot is queued
+ *
+ * @param size Message size
+ * @param pAddr Message recipient
+ * @return Packet to fill, or nullptr if no slot is available
+ */
+Packet* AsyncSocket::BeginRingSend(u32 size, const SockAddrAny* pAddr) {
+    if (size == 0 || size > scRingSlotSize) {
+        return nullptr;
+    }
 
-    case EState_Connecting:
-        result = LibSO::Connect(mHandle, mPeer);
+    // Ring only supports one producer, so other threads sending at the same
+    // time use the heap instead of waiting
+    {
+        AutoInterruptLock lock;
 
-        // Blocking, try again
-        if (result == SO_EINPROGRESS || result == SO_EALREADY) {
-            break;
+        if (mIsRingClaimed) {
+            return nullptr;
         }
 
-        // Connection complete (looking for EISCONN here)
-        mState = EState_Thinking;
-        mpConnectCallback(result == SO_EISCONN ? SO_SUCCESS
-                                               : LibSO::GetLastError(),
-                          mpConnectCallbackArg);
+        mIsRingClaimed = true;
+    }
 
-        break;
+    // Sockets which never send (or only receive) don't pay for the ring
+    if (mpSendRing == nullptr) {
+        mpSendRing = new PacketRing(scRingCapacity, scRingSlotSize);
+        K_ASSERT(mpSendRing != nullptr);
+    }
 
-    case EState_Accepting:
-        result = LibSO::Accept(mHandle, mPeer);
+    Packet* pPacket = mpSendRing->BeginPush();
 
-        // Report non-blocking results
-        if (result != SO_EWOULDBLOCK) {
-            // Peer connection
-            AsyncSocket* pSocket = nullptr;
+    // All slots are still waiting to be sent
+    if (pPacket == nullptr) {
+        mIsRingClaimed = false;
+        return nullptr;
+    }
 
-            // Result code is the peer descriptor
-            if (result >= 0) {
-                pSocket = new AsyncSocket(result, mFamily, mType);
-                K_ASSERT(pSocket != nullptr);
-            }
+    pPacket->Alloc(size);
 
-            mState = EState_Thinking;
-            mpAcceptCallback(LibSO::GetLastError(), pSocket, mPeer,
-                             mpAcceptCallbackArg);
-        }
-        break;
+    // Slot may still hold the previous recipient
+    if (pAddr != nullptr) {
+        pPacket->SetPeer(*pAddr);
+    } else {
+        pPacket->SetPeer(SockAddr4());
     }
+
+    return pPacket;
 }
 
 /**
- * @brief Receives packet data over socket
+ * @brief Queues a receive job
+ *
+ * @param pPacket Packet to hold incoming data
+ * @param pSegments Where to split up packet data (optional)
+ * @param num Number of segments
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
  */
-void AsyncSocket::CalcRecv() {
-    K_ASSERT(IsOpen());
+void AsyncSocket::QueueRecv(Packet* pPacket, const SockSegment* pSegments,
+                            u32 num, SockAddrAny* pAddr, Callback pCallback,
+                            void* pArg) {
+    K_ASSERT(pPacket != nullptr);
+
+    // Asynchronous job
+    RecvJob* pJob =
+        new RecvJob(this, pPacket, pSegments, num, pAddr, pCallback, pArg);
+    K_ASSERT(pJob != nullptr);
+
+    AutoMutexLock lock(sJobMutex);
+
+    mRecvJobs.PushBack(pJob);
+    UpdateQueueDepth(1);
+
+    // Starts immediately if the socket is idle
+    PostRecv();
+}
+
+/**
+ * @brief Queues a send job
+ *
+ * @param pPacket Packet holding outgoing data
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ */
+void AsyncSocket::QueueSend(Packet* pPacket, Callback pCallback, void* pArg) {
+    K_ASSERT(pPacket != nullptr);
+
+    // Packet may be a slot from BeginRingSend
+    PacketRing* pRing = nullptr;
+    if (mpSendRing != nullptr && mpSendRing->IsSlot(pPacket)) {
+        K_ASSERT(mIsRingClaimed);
+        pRing = mpSendRing;
+    }
+
+    // Asynchronous job
+    SendJob* pJob = new SendJob(this, pPacket, pRing, pCallback, pArg);
+    K_ASSERT(pJob != nullptr);
+
+    AutoMutexLock lock(sJobMutex);
+
+    // Slot must be queued in the same order it was pushed, so the ring isn't
+    // given up until the job is in the queue
+    if (pRing != nullptr) {
+        pRing->EndPush();
+        mIsRingClaimed = false;
+    }
+
+    mSendJobs.PushBack(pJob);
+    UpdateQueueDepth(1);
+
+    // Starts immediately if the socket is idle
+    PostSend();
+}
+
+/**
+ * @brief Schedules the oldest receive job
+ * @details The job is submitted to IOS once the socket is readable
+ */
+void AsyncSocket::PostRecv() {
+    AutoMutexLock lock(sJobMutex);
 
-    // Nothing to do
     if (mRecvJobs.Empty()) {
         return;
     }
 
-    // Find next incomplete job (FIFO)
+    // Only one receive can be in flight, or data could arrive out of order
     RecvJob& rJob = mRecvJobs.Front();
-    K_ASSERT_EX(!rJob.IsComplete(), "Completed job should be removed");
-
-    // Attempt to complete job
-    if (rJob.Calc(mHandle)) {
-        // Remove from queue
-        mRecvJobs.PopFront();
-        delete &rJob;
+    if (rJob.mIsPosted || mIsRecvWaiting) {
+        return;
     }
+
+    // Receive ioctls stay in IOS until data arrives, so the reactor waits on
+    // all sockets at once instead
+    mIsRecvWaiting = true;
+    ArmPoll();
 }
 
 /**
- * @brief Sends packet data over socket
+ * @brief Submits the oldest receive job to IOS without polling
  */
-void AsyncSocket::CalcSend() {
-    K_ASSERT(IsOpen());
+void AsyncSocket::SubmitRecv() {
+    K_ASSERT(!mRecvJobs.Empty());
+
+    mIsRecvWaiting = false;
+
+    RecvJob& rJob = mRecvJobs.Front();
+    K_ASSERT(!rJob.mIsPosted);
+
+    rJob.mIsPosted = true;
+    rJob.mpPacket->RecvAsync(mHandle, RecvCallbackFunc, &rJob);
+}
+
+/**
+ * @brief Submits the oldest send job to IOS
+ */
+void AsyncSocket::PostSend() {
+    AutoMutexLock lock(sJobMutex);
 
-    // Nothing to do
     if (mSendJobs.Empty()) {
         return;
     }
 
-    // Find next incomplete job (FIFO)
+    // Only one send can be in flight, or data could leave out of order
     SendJob& rJob = mSendJobs.Front();
-    K_ASSERT_EX(!rJob.IsComplete(), "Completed job should be removed");
-
-    // Attempt to complete job
-    if (rJob.Calc(mHandle)) {
-        // Remove from queue
-        mSendJobs.PopFront();
-        delete &rJob;
+    if (rJob.mIsPosted) {
+        return;
     }
+
+    rJob.mIsPosted = true;
+    rJob.mpPacket->SendAsync(mHandle, SendCallbackFunc, &rJob);
 }
 
 /**
@@ -411,14 +1125,14 @@ SOResult AsyncSocket::RecvImpl(void* pDst, u32 len, u32& rRecv,
     K_ASSERT(pDst != nullptr);
     K_ASSERT(OSIsMEM2Region(pDst));
 
-    // Packet to hold incoming data
-    Packet* pPacket = new Packet(len);
+    // Data is received straight into the destination
+    Packet* pPacket = new Packet();
     K_ASSERT(pPacket != nullptr);
 
-    // Asynchronous job
-    RecvJob* pJob = new RecvJob(pPacket, pDst, pAddr, pCallback, pArg);
-    K_ASSERT(pJob != nullptr);
-    mRecvJobs.PushBack(pJob);
+    pPacket->Attach(pDst, len);
+    pPacket->Alloc(len);
+
+    QueueRecv(pPacket, nullptr, 0, pAddr, pCallback, pArg);
 
     // Receive doesn't actually happen on this thread
     rRecv = 0;
@@ -443,17 +1157,178 @@ SOResult AsyncSocket::SendImpl(const void* pSrc, u32 len, u32& rSend,
     K_ASSERT(pSrc != nullptr);
     K_ASSERT(OSIsMEM2Region(pSrc));
 
-    // Packet to hold incoming data
-    Packet* pPacket = new Packet(len, pAddr);
-    K_ASSERT(pPacket != nullptr);
+    // Packet to hold outgoing data (heap is only used if the ring can't be)
+    Packet* pPacket = BeginRingSend(len, pAddr);
+    if (pPacket == nullptr) {
+        pPacket = new Packet(len, pAddr);
+        K_ASSERT(pPacket != nullptr);
+    }
 
     // Store data inside packet
     pPacket->Write(pSrc, len);
 
-    // Asynchronous job
-    SendJob* pJob = new SendJob(pPacket, pCallback, pArg);
-    K_ASSERT(pJob != nullptr);
-    mSendJobs.PushBack(pJob);
+    QueueSend(pPacket, pCallback, pArg);
+
+    // Send doesn't actually happen on this thread
+    rSend = 0;
+    return SO_EWOULDBLOCK;
+}
+
+/**
+ * @brief Receives data into several buffers and records sender address
+ * (internal implementation)
+ * @details Stream data is received directly into the segments, with one job
+ * per segment. Datagrams are split up once they arrive.
+ *
+ * @param pSegments Destination segments
+ * @param num Number of segments
+ * @param[out] rRecv Number of bytes received
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult AsyncSocket::RecvVImpl(const SockSegment* pSegments, u32 num,
+                                u32& rRecv, SockAddrAny* pAddr,
+                                Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    // Datagrams can't be split between receives
+    if (mType != SO_SOCK_STREAM) {
+        Packet* pPacket = new Packet(GetSegmentsSize(pSegments, num));
+        K_ASSERT(pPacket != nullptr);
+
+        QueueRecv(pPacket, pSegments, num, pAddr, pCallback, pArg);
+
+        rRecv = 0;
+        return SO_EWOULDBLOCK;
+    }
+
+    // Last segment completes the operation
+    u32 last = num - 1;
+    while (pSegments[last].size == 0) {
+        K_ASSERT(last > 0);
+        last--;
+    }
+
+    {
+        // Other receives can't be queued between the segments
+        AutoMutexLock lock(sJobMutex);
+
+        for (u32 i = 0; i <= last; i++) {
+            if (pSegments[i].size == 0) {
+                continue;
+            }
+
+            // Data is received straight into the segment
+            Packet* pPacket = new Packet();
+            K_ASSERT(pPacket != nullptr);
+
+            pPacket->Attach(pSegments[i].pData, pSegments[i].size);
+            pPacket->Alloc(pSegments[i].size);
+
+            // Errors on earlier segments carry over to the last one, as the
+            // connection is no longer usable
+            if (i == last) {
+                QueueRecv(pPacket, nullptr, 0, pAddr, pCallback, pArg);
+            } else {
+                QueueRecv(pPacket, nullptr, 0, nullptr, nullptr, nullptr);
+            }
+        }
+    }
+
+    // Receive doesn't actually happen on this thread
+    rRecv = 0;
+    return SO_EWOULDBLOCK;
+}
+
+/**
+ * @brief Sends data from several buffers to specified connection
+ * (internal implementation)
+ * @details Large messages in MEM2 are sent straight from the segments, with
+ * one job per segment. Otherwise, the segments are gathered into the job's
+ * packet.
+ * @note Segments which are sent directly must outlive the operation
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param[out] rSend Number of bytes sent
+ * @param pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult AsyncSocket::SendVImpl(const SockSegment* pSegments, u32 num,
+                                u32& rSend, const SockAddrAny* pAddr,
+                                Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    u32 size = GetSegmentsSize(pSegments, num);
+
+    // Datagrams must be sent whole, and copying a small message is cheaper
+    // than a job per segment
+    if ((mType == SO_SOCK_STREAM || num == 1) && size > scMaxGatherSize &&
+        IsSegmentsMEM2(pSegments, num)) {
+
+        // Last segment completes the operation
+        u32 last = num - 1;
+        while (pSegments[last].size == 0) {
+            K_ASSERT(last > 0);
+            last--;
+        }
+
+        // Other sends can't be queued between the segments
+        AutoMutexLock lock(sJobMutex);
+
+        for (u32 i = 0; i <= last; i++) {
+            if (pSegments[i].size == 0) {
+                continue;
+            }
+
+            // Data is sent straight from the segment
+            Packet* pPacket = new Packet();
+            K_ASSERT(pPacket != nullptr);
+
+            pPacket->Attach(pSegments[i].pData, pSegments[i].size);
+            pPacket->Alloc(pSegments[i].size);
+            pPacket->WriteInPlace(pSegments[i].size);
+
+            if (pAddr != nullptr) {
+                pPacket->SetPeer(*pAddr);
+            }
+
+            // Errors on earlier segments carry over to the last one, as the
+            // connection is no longer usable
+            if (i == last) {
+                QueueSend(pPacket, pCallback, pArg);
+            } else {
+                QueueSend(pPacket, nullptr, nullptr);
+            }
+        }
+
+        rSend = 0;
+        return SO_EWOULDBLOCK;
+    }
+
+    // Packet to hold outgoing data (heap is only used if the ring can't be)
+    Packet* pPacket = BeginRingSend(size, pAddr);
+    if (pPacket == nullptr) {
+        pPacket = new Packet(size, pAddr);
+        K_ASSERT(pPacket != nullptr);
+    }
+
+    // Packet memory is already in MEM2, so no other staging is needed
+    for (u32 i = 0; i < num; i++) {
+        if (pSegments[i].size > 0) {
+            pPacket->Write(pSegments[i].pData, pSegments[i].size);
+        }
+    }
+
+    QueueSend(pPacket, pCallback, pArg);
 
     // Send doesn't actually happen on this thread
     rSend = 0;
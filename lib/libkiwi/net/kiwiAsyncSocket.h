@@ -1,8 +1,9 @@
 #ifndef LIBKIWI_NET_ASYNC_SOCKET_H
 #define LIBKIWI_NET_ASYNC_SOCKET_H
 #include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiPacketRing.h>
 #include <libkiwi/net/kiwiSocketBase.h>
-#include <libkiwi/prim/kiwiLinkList.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
 #include <revolution/OS.h>
 
 namespace kiwi {
@@ -10,10 +11,52 @@ namespace kiwi {
 //! @{
 
 /**
- * @brief Asynchronous (non-blocking) socket
+ * @brief Asynchronous socket
+ * @details Socket operations are submitted to IOS as asynchronous ioctls, so
+ * many of them can be outstanding at once without any thread blocking in IPC.
+ * Each socket keeps one receive and one send in flight, and queued jobs are
+ * completed in order (FIFO).
+ *
+ * Receives are driven by a shared reactor. One asynchronous SOPoll covers
+ * every socket with a pending receive, and the receive ioctl is only
+ * submitted once its socket is readable, so idle sockets don't each hold a
+ * request in IOS. Sends, connects, and accepts are submitted directly.
+ *
+ * The poll also covers a loopback datagram socket, so a socket which starts
+ * waiting can restart the poll in flight instead of waiting for it to end.
+ *
+ * Small outgoing messages are copied into a per-socket ring of preallocated
+ * MEM2 packets (see GetRingStats), so queueing a send doesn't allocate a
+ * message buffer. A send which is in flight when the socket is destroyed
+ * keeps the ring alive until it completes.
+ * @note Callbacks are invoked from the IOS dispatcher thread
  */
 class AsyncSocket : public SocketBase {
 public:
+    /**
+     * @brief Reactor/job statistics
+     */
+    struct Stats {
+        u32 wakeups;       // Number of times the reactor woke up
+        u32 timeouts;      // Number of polls which timed out
+        u32 restarts;      // Number of polls restarted for new sockets
+        u32 recvBytes;     // Total bytes received by jobs
+        u32 sendBytes;     // Total bytes sent by jobs
+        u32 queueDepth;    // Number of pending jobs
+        u32 maxQueueDepth; // Largest number of pending jobs
+    };
+
+public:
+    /**
+     * @brief Gets the reactor/job statistics
+     */
+    static Stats GetStats();
+    /**
+     * @brief Resets the reactor/job statistics
+     * @note Queue depth is not reset, as it reflects the current state
+     */
+    static void ResetStats();
+
     /**
      * @brief Constructor
      *
@@ -25,9 +68,7 @@ public:
     /**
      * @brief Destructor
      */
-    virtual ~AsyncSocket() {
-        sSocketList.Remove(this);
-    }
+    virtual ~AsyncSocket();
 
     /**
      * @brief Connects to a peer
@@ -49,24 +90,206 @@ public:
      */
     virtual AsyncSocket* Accept(AcceptCallback pCallback, void* pArg);
 
+    /**
+     * @brief Gets the send ring statistics
+     * @details The byte rate shows how close sends get to the link rate
+     */
+    PacketRing::Stats GetRingStats() const;
+    /**
+     * @brief Resets the send ring statistics
+     */
+    void ResetRingStats();
+
 private:
     /**
-     * @brief Async state
+     * @brief Async receive operation
      */
-    enum EState { EState_Thinking, EState_Connecting, EState_Accepting };
+    class RecvJob {
+        friend class AsyncSocket;
+
+    public:
+        /**
+         * @brief Constructor
+         * @details Without a scatter list, the packet buffer must already be
+         * the destination memory.
+         *
+         * @param pSocket Owner socket
+         * @param pPacket Packet for this job
+         * @param pSegments Where to split up packet data (optional)
+         * @param num Number of segments
+         * @param[out] pPeer Peer address
+         * @param pCallback Completion callback
+         * @param pArg Callback user argument
+         */
+        RecvJob(AsyncSocket* pSocket, Packet* pPacket,
+                const SockSegment* pSegments, u32 num, SockAddrAny* pPeer,
+                Callback pCallback = nullptr, void* pArg = nullptr);
+
+        /**
+         * @brief Destructor
+         */
+        ~RecvJob();
+
+        /**
+         * @brief Tests whether the receive operation is complete
+         */
+        bool IsComplete() const;
+
+    private:
+        AsyncSocket* mpSocket;   // Owner socket (null once destroyed)
+        Packet* mpPacket;        // Packet to complete
+        SockSegment* mpSegments; // Where to split up packet data
+        u32 mNumSegments;        // Number of scatter segments
+        SOSockAddr* mpPeer;      // Where to store peer address
+        bool mIsPosted;          // Whether an ioctl is in flight
+
+        Callback mpCallback; // Completion callback
+        void* mpArg;         // Completion callback user argument
+
+        IntrusiveListNode mNode; // Node in the socket's job queue
+    };
+
+    /**
+     * @brief Async send operation
+     */
+    class SendJob {
+        friend class AsyncSocket;
+
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param pSocket Owner socket
+         * @param pPacket Packet for this job
+         * @param pRing Ring holding the packet (optional)
+         * @param pCallback Completion callback
+         * @param pArg Callback user argument
+         */
+        SendJob(AsyncSocket* pSocket, Packet* pPacket, PacketRing* pRing,
+                Callback pCallback = nullptr, void* pArg = nullptr);
+
+        /**
+         * @brief Destructor
+         */
+        ~SendJob();
+
+        /**
+         * @brief Tests whether the send operation is complete
+         */
+        bool IsComplete() const;
+
+    private:
+        AsyncSocket* mpSocket; // Owner socket (null once destroyed)
+        Packet* mpPacket;      // Packet to complete
+        PacketRing* mpRing;    // Ring holding the packet (if any)
+        bool mIsRingOwner;     // Whether the job must destroy the ring
+        bool mIsPosted;        // Whether an ioctl is in flight
+
+        Callback mpCallback; // Completion callback
+        void* mpArg;         // Completion callback user argument
 
-    // Async receive operation
-    class RecvJob;
-    // Async send operation
-    class SendJob;
+        IntrusiveListNode mNode; // Node in the socket's job queue
+    };
+
+    /**
+     * @brief Async connect/accept operation
+     */
+    struct ControlJob {
+        AsyncSocket* pSocket; // Owner socket (null once destroyed)
+        SockAddrAny peer;     // Peer address
+    };
+
+    //! Receive job queue
+    typedef TIntrusiveList<RecvJob, &RecvJob::mNode> RecvJobList;
+    //! Send job queue
+    typedef TIntrusiveList<SendJob, &SendJob::mNode> SendJobList;
 
 private:
     /**
-     * @brief Socket thread function
+     * @brief Receive completion callback
+     *
+     * @param result Bytes received or IOS error code
+     * @param pArg Receive job
+     */
+    static void RecvCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Send completion callback
+     *
+     * @param result Bytes sent or IOS error code
+     * @param pArg Send job
+     */
+    static void SendCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Connect completion callback
+     *
+     * @param result IOS error code
+     * @param pArg Control job
+     */
+    static void ConnectCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Accept completion callback
+     *
+     * @param result Peer descriptor or IOS error code
+     * @param pArg Control job
+     */
+    static void AcceptCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Poll completion callback
+     *
+     * @param result Number of ready sockets or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void PollCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Wakeup send completion callback
+     *
+     * @param result Bytes sent or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void WakeSendCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Wakeup receive completion callback
+     *
+     * @param result Bytes received or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void WakeRecvCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Submits a poll for the sockets waiting to receive
+     * @details If a poll is already in flight, it is restarted so the new
+     * socket is included
+     */
+    static void ArmPoll();
+    /**
+     * @brief Builds the poll descriptor list from the open sockets
+     * @details Sockets which don't fit are moved to the front of the list,
+     * so they are polled first next time
+     *
+     * @return Number of descriptors to poll
+     */
+    static u32 PreparePoll();
+
+    /**
+     * @brief Creates the loopback socket used to restart polls
+     */
+    static void CreateWakeSocket();
+    /**
+     * @brief Closes the loopback socket after an error
+     */
+    static void DestroyWakeSocket();
+    /**
+     * @brief Ends the poll in flight early by sending to the loopback socket
+     */
+    static void WakePoll();
+
+    /**
+     * @brief Updates the queue depth statistics
      *
-     * @param pArg Thread function argument
+     * @param delta Change in the number of pending jobs
      */
-    static void* ThreadFunc(void* pArg);
+    static void UpdateQueueDepth(s32 delta);
 
     /**
      * @brief Constructor
@@ -81,19 +304,52 @@ private:
      * @brief Prepares socket for async operation
      */
     void Initialize();
+
+    /**
+     * @brief Queues a receive job
+     *
+     * @param pPacket Packet to hold incoming data
+     * @param pSegments Where to split up packet data (optional)
+     * @param num Number of segments
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     */
+    void QueueRecv(Packet* pPacket, const SockSegment* pSegments, u32 num,
+                   SockAddrAny* pAddr, Callback pCallback, void* pArg);
     /**
-     * @brief Processes pending socket tasks
+     * @brief Queues a send job
+     * @details Send ring slots are published to the ring here
+     *
+     * @param pPacket Packet holding outgoing data
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
      */
-    void Calc();
+    void QueueSend(Packet* pPacket, Callback pCallback, void* pArg);
 
     /**
-     * @brief Receives packet data over socket
+     * @brief Gets a send ring slot for an outgoing message
+     * @details The ring is left to the caller until the slot is queued
+     *
+     * @param size Message size
+     * @param pAddr Message recipient
+     * @return Packet to fill, or nullptr if no slot is available
      */
-    void CalcRecv();
+    Packet* BeginRingSend(u32 size, const SockAddrAny* pAddr);
+
     /**
-     * @brief Sends packet data over socket
+     * @brief Schedules the oldest receive job
+     * @details The job is submitted to IOS once the socket is readable
      */
-    void CalcSend();
+    void PostRecv();
+    /**
+     * @brief Submits the oldest receive job to IOS without polling
+     */
+    void SubmitRecv();
+    /**
+     * @brief Submits the oldest send job to IOS
+     */
+    void PostSend();
 
     /**
      * @brief Receives data and records sender address (internal implementation)
@@ -125,14 +381,69 @@ private:
                               const SockAddrAny* pAddr, Callback pCallback,
                               void* pArg);
 
+protected:
+    /**
+     * @brief Receives data into several buffers and records sender address
+     * (internal implementation)
+     * @details Stream data is received directly into the segments, with one
+     * job per segment. Datagrams are split up once they arrive.
+     *
+     * @param pSegments Destination segments
+     * @param num Number of segments
+     * @param[out] rRecv Number of bytes received
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
+    /**
+     * @brief Sends data from several buffers to specified connection
+     * (internal implementation)
+     * @details Large messages in MEM2 are sent straight from the segments,
+     * with one job per segment. Otherwise, the segments are gathered into
+     * the job's packet.
+     * @note Segments which are sent directly must outlive the operation
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param[out] rSend Number of bytes sent
+     * @param pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
 private:
-    static const u32 scThreadStackSize = 0x4000;
+    //! Most descriptors the reactor can poll at once (including wakeups)
+    static const u32 scMaxPollFDs = 32;
+    //! Poll timeout, when new sockets can restart the poll
+    static const u32 scPollTimeoutMsec = 500;
+    //! Poll timeout, when new sockets must wait for the next poll
+    static const u32 scPollFallbackMsec = 16;
+    //! Size of each half of the wakeup buffer
+    static const u32 scWakeBufferSize = 32;
+    //! Number of send ring slots
+    static const u32 scRingCapacity = 16;
+    //! Size of each send ring slot (largest UDP payload in an Ethernet frame)
+    static const u32 scRingSlotSize = 1472;
+    //! Poll events which may complete a receive
+    static const s32 scRecvEvents = SO_POLLRDNORM | SO_POLLERR | SO_POLLHUP;
+
+    RecvJobList mRecvJobs; // Active receive jobs
+    SendJobList mSendJobs; // Active send jobs
+    bool mIsRecvWaiting;   // Whether the oldest receive waits for the poll
 
-    volatile EState mState; // Current async task
-    SockAddrAny mPeer;      // Peer address
+    PacketRing* mpSendRing;       // Send message ring (created on first use)
+    volatile bool mIsRingClaimed; // Whether a thread is filling a ring slot
 
-    TList<RecvJob> mRecvJobs; // Active receive jobs
-    TList<SendJob> mSendJobs; // Active send jobs
+    ControlJob* mpControlJob; // Active connect/accept job
 
     Callback mpConnectCallback; // Connect callback
     void* mpConnectCallbackArg; // Connect callback user argument
@@ -140,10 +451,25 @@ private:
     AcceptCallback mpAcceptCallback; // Accept callback
     void* mpAcceptCallbackArg;       // Accept callback user argument
 
-    static OSThread sSocketThread;                   // Socket manager thread
-    static bool sSocketThreadCreated;                // Thread guard
-    static u8 sSocketThreadStack[scThreadStackSize]; // Thread stack
-    static TList<AsyncSocket> sSocketList;           // Open async sockets
+    IntrusiveListNode mNode; // Node in the open socket list
+    s32 mPollIndex;          // Index in the poll descriptor list
+
+    static OSMutex sJobMutex; // Job queue lock
+    static Stats sStats;      // Reactor/job statistics
+
+    static SOPollFD sPollFDs[scMaxPollFDs]; // Poll descriptor list
+    static u32 sNumPollFDs;                 // Number of polled sockets
+    static bool sIsPolling;                 // Whether a poll is in flight
+
+    static SOSocket sWakeHandle; // Loopback socket which restarts polls
+    static SockAddr4 sWakeAddr;  // Loopback socket address
+    static u8* spWakeBuffer;     // Wakeup send/receive buffer (MEM2)
+    static bool sIsWakeCreated;  // Whether the loopback socket was set up
+    static bool sIsWakePending;  // Whether a wakeup is on its way
+    static bool sIsWakeDraining; // Whether a wakeup is being received
+
+    //! Open async sockets
+    static TIntrusiveList<AsyncSocket, &AsyncSocket::mNode> sSocketList;
 };
 
 //! @}
@@ -23,7 +23,7 @@ enum {
  */
 u64 EmuRichPresenceClient::GetTimeNow() const {
     if (!IsConnected()) {
-        return;
+        return 0;
     }
 
     TVector<IosVector> input;
@@ -71,32 +71,32 @@ void EmuRichPresenceClient::UpdateActivity() const {
     TVector<IosVector> output;
 
     // Presence info
-    IosString<char> details(mDetails);
-    IosString<char> state(mState);
+    IosString<char> details(mActivity.details);
+    IosString<char> state(mActivity.state);
     input.PushBack(details);
     input.PushBack(state);
 
     // Large image
-    IosString<char> largeKey(mLargeImageKey);
-    IosString<char> largeText(mLargeImageText);
+    IosString<char> largeKey(mActivity.largeImageKey);
+    IosString<char> largeText(mActivity.largeImageText);
     input.PushBack(largeKey);
     input.PushBack(largeText);
 
     // Small image
-    IosString<char> smallKey(mSmallImageKey);
-    IosString<char> smallText(mSmallImageText);
+    IosString<char> smallKey(mActivity.smallImageKey);
+    IosString<char> smallText(mActivity.smallImageText);
     input.PushBack(smallKey);
     input.PushBack(smallText);
 
     // Gameplay timestamps
-    IosObject<u64> startTime(mStartTime);
-    IosObject<u64> endTime(mEndTime);
+    IosObject<u64> startTime(mActivity.startTime);
+    IosObject<u64> endTime(mActivity.endTime);
     input.PushBack(startTime);
     input.PushBack(endTime);
 
     // Party size
-    IosObject<s32> partyNum(mPartyNum);
-    IosObject<s32> partyMax(mPartyMax);
+    IosObject<s32> partyNum(mActivity.partyNum);
+    IosObject<s32> partyMax(mActivity.partyMax);
     input.PushBack(partyNum);
     input.PushBack(partyMax);
 
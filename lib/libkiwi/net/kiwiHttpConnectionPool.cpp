@@ -0,0 +1,922 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Pool lock
+ */
+OSMutex HttpConnectionPool::sMutex;
+
+/**
+ * @brief Constructor
+ *
+ * @param rHost Server hostname
+ * @param _port Server port
+ * @param rAddr Server address
+ */
+HttpConnection::HttpConnection(const String& rHost, u16 _port,
+                               const SockAddr4& rAddr)
+    : host(rHost),
+      port(_port),
+      addr(rAddr),
+      pSocket(nullptr),
+      isConnected(false),
+      isConnecting(false),
+      isSending(false),
+      isReceiving(false),
+      isExclusive(false),
+      isClosing(false),
+      numSent(0),
+      sendOffset(0),
+      pRecvBuffer(nullptr),
+      idleTick(OSGetTick()),
+      activeTick(idleTick),
+      numServed(0) {
+
+    pSocket = new SyncSocket(SO_PF_INET, SO_SOCK_STREAM);
+    K_ASSERT(pSocket != nullptr);
+    K_ASSERT(pSocket->IsOpen());
+
+    // Any local port is fine
+    bool success = pSocket->Bind();
+    K_ASSERT(success);
+}
+
+/**
+ * @brief Destructor
+ */
+HttpConnection::~HttpConnection() {
+    K_ASSERT_EX(!IsBusy(), "Connection is still in use");
+
+    delete pSocket;
+    pSocket = nullptr;
+
+    delete[] pRecvBuffer;
+    pRecvBuffer = nullptr;
+}
+
+/**
+ * @brief Constructor
+ */
+HttpConnectionPool::HttpConnectionPool()
+    : ISceneHook(-1),
+      mMaxConnections(DEFAULT_MAX_CONNECTIONS),
+      mMaxPipeline(DEFAULT_MAX_PIPELINE),
+      mIdleTimeOut(DEFAULT_IDLE_TIMEOUT) {
+
+    ResetStats();
+}
+
+/**
+ * @brief Destructor
+ */
+HttpConnectionPool::~HttpConnectionPool() {
+    Clear();
+}
+
+/**
+ * @brief Sets the connection limit per server
+ * @note Synchronous requests may exceed this, as they can't wait
+ *
+ * @param max Maximum number of connections
+ */
+void HttpConnectionPool::SetMaxConnections(u32 max) {
+    K_ASSERT(max > 0);
+
+    AutoMutexLock lock(sMutex);
+    mMaxConnections = max;
+}
+
+/**
+ * @brief Sets the limit of requests in flight per connection
+ *
+ * @param max Maximum pipeline depth (one to disable pipelining)
+ */
+void HttpConnectionPool::SetMaxPipeline(u32 max) {
+    K_ASSERT(max > 0);
+
+    AutoMutexLock lock(sMutex);
+    mMaxPipeline = max;
+}
+
+/**
+ * @brief Sets how long a connection may stay idle
+ *
+ * @param timeOut Idle time before the connection is closed, in
+ * milliseconds
+ */
+void HttpConnectionPool::SetIdleTimeOut(u32 timeOut) {
+    AutoMutexLock lock(sMutex);
+    mIdleTimeOut = timeOut;
+}
+
+/**
+ * @brief Closes all idle connections
+ */
+void HttpConnectionPool::Clear() {
+    AutoMutexLock lock(sMutex);
+
+    for (ConnectionList::Iterator it = mConnections.Begin();
+         it != mConnections.End();) {
+
+        if (it->IsBusy()) {
+            ++it;
+            continue;
+        }
+
+        HttpConnection* pConnection = &*it;
+        it = mConnections.Erase(it);
+        delete pConnection;
+    }
+}
+
+/**
+ * @brief Gets the pool statistics
+ */
+HttpConnectionPool::Stats HttpConnectionPool::GetStats() const {
+    AutoMutexLock lock(sMutex);
+    return mStats;
+}
+
+/**
+ * @brief Resets the pool statistics
+ */
+void HttpConnectionPool::ResetStats() {
+    AutoMutexLock lock(sMutex);
+    std::memset(&mStats, 0, sizeof(Stats));
+}
+
+/**
+ * @brief Calculate callback (after game logic)
+ * @details Closes connections which have been idle for too long, and
+ * fails those whose async requests have timed out (including requests
+ * over their own sockets)
+ *
+ * @param pScene Current scene
+ */
+void HttpConnectionPool::AfterCalculate(RPSysScene* pScene) {
+#pragma unused(pScene)
+
+    {
+        AutoMutexLock lock(sMutex);
+
+        u32 now = OSGetTick();
+        u32 timeOut = OS_MSEC_TO_TICKS(mIdleTimeOut);
+
+        for (ConnectionList::Iterator it = mConnections.Begin();
+             it != mConnections.End();) {
+
+            // Failing the connection may close it
+            HttpConnection* pConnection = &*it++;
+
+            // Shutting down the socket aborts the operations in flight
+            if (IsTimedOut(pConnection, now)) {
+                Fail(pConnection, EHttpErr_TimedOut, SO_SUCCESS);
+                mStats.numTimeouts++;
+                continue;
+            }
+
+            if (pConnection->IsBusy() ||
+                now - pConnection->idleTick < timeOut) {
+                continue;
+            }
+
+            mConnections.Remove(pConnection);
+            delete pConnection;
+
+            mStats.numEvicted++;
+        }
+
+        K_FOREACH (mWatchList) {
+            if (it->mIsTimedOut || now - it->mActiveTick < it->mTimeOut) {
+                continue;
+            }
+
+            // Request fails once its aborted operation completes
+            it->mIsTimedOut = true;
+            it->mpSocket->Shutdown(SO_SHUT_RDWR);
+            mStats.numTimeouts++;
+        }
+    }
+
+    // Timed-out requests are completed outside of the lock
+    FlushCompletions();
+}
+
+/**
+ * @brief Takes an idle connection to the server, or opens a new one
+ *
+ * @param rRequest HTTP request
+ */
+HttpConnection* HttpConnectionPool::Acquire(const HttpRequest& rRequest) {
+    AutoMutexLock lock(sMutex);
+
+    // Previous connection was lost before anything was received
+    if (rRequest.mIsRetried) {
+        mStats.numRetries++;
+    }
+
+    K_FOREACH (mConnections) {
+        if (it->port != rRequest.mPort || it->host != rRequest.mHost) {
+            continue;
+        }
+
+        // Connection must be idle for exclusive use
+        if (!it->isConnected || it->isClosing || it->IsBusy()) {
+            continue;
+        }
+
+        it->isExclusive = true;
+        mStats.numReuses++;
+        return &*it;
+    }
+
+    HttpConnection* pConnection = Open(rRequest);
+    pConnection->isExclusive = true;
+    return pConnection;
+}
+
+/**
+ * @brief Returns a connection taken with Acquire
+ *
+ * @param pConnection Pooled connection
+ * @param reuse Whether the connection can be used again
+ */
+void HttpConnectionPool::Release(HttpConnection* pConnection, bool reuse) {
+    K_ASSERT(pConnection != nullptr);
+    K_ASSERT(pConnection->isExclusive);
+
+    AutoMutexLock lock(sMutex);
+
+    pConnection->isExclusive = false;
+
+    if (reuse) {
+        pConnection->numServed++;
+        pConnection->idleTick = OSGetTick();
+    } else {
+        Retire(pConnection);
+    }
+
+    // Async requests may have been waiting for this server
+    ServiceWaitQueue();
+}
+
+/**
+ * @brief Sends a request over a pooled connection
+ * @details The request waits in a queue if the server's connections are
+ * all in use.
+ *
+ * @param pRequest HTTP request
+ */
+void HttpConnectionPool::Submit(HttpRequest* pRequest) {
+    K_ASSERT(pRequest != nullptr);
+    K_ASSERT(pRequest->mpAsyncBuffer != nullptr);
+
+    AutoMutexLock lock(sMutex);
+
+    HttpConnection* pConnection = Find(*pRequest);
+
+    if (pConnection != nullptr) {
+        Assign(pConnection, pRequest);
+    } else {
+        mWaitList.PushBack(pRequest);
+    }
+}
+
+/**
+ * @brief Watches an async request over its own socket for time-out
+ *
+ * @param pRequest HTTP request
+ */
+void HttpConnectionPool::Watch(HttpRequest* pRequest) {
+    K_ASSERT(pRequest != nullptr);
+    K_ASSERT(pRequest->mpSocket != nullptr);
+
+    AutoMutexLock lock(sMutex);
+
+    pRequest->mIsTimedOut = false;
+    pRequest->mActiveTick = OSGetTick();
+    mWatchList.PushBack(pRequest);
+}
+
+/**
+ * @brief Stops watching an async request over its own socket
+ *
+ * @param pRequest HTTP request
+ */
+void HttpConnectionPool::Unwatch(HttpRequest* pRequest) {
+    K_ASSERT(pRequest != nullptr);
+
+    AutoMutexLock lock(sMutex);
+
+    // Requests which failed before sending were never watched
+    if (mWatchList.Contains(pRequest)) {
+        mWatchList.Remove(pRequest);
+    }
+}
+
+/**
+ * @brief Opens a connection to the server
+ *
+ * @param rRequest HTTP request
+ */
+HttpConnection* HttpConnectionPool::Open(const HttpRequest& rRequest) {
+    // Address was resolved by the request, on the thread which sent it
+    HttpConnection* pConnection =
+        new HttpConnection(rRequest.mHost, rRequest.mPort, rRequest.mAddr);
+    K_ASSERT(pConnection != nullptr);
+
+    mConnections.PushBack(pConnection);
+    mStats.numConnects++;
+
+    return pConnection;
+}
+
+/**
+ * @brief Finds a connection which can take an async request
+ *
+ * @param rRequest HTTP request
+ * @return Pooled connection, or nullptr if all are in use
+ */
+HttpConnection* HttpConnectionPool::Find(const HttpRequest& rRequest) {
+    HttpConnection* pShortest = nullptr;
+    u32 numOpen = 0;
+
+    K_FOREACH (mConnections) {
+        if (it->port != rRequest.mPort || it->host != rRequest.mHost) {
+            continue;
+        }
+
+        // Closing connections no longer count towards the limit
+        if (it->isClosing) {
+            continue;
+        }
+
+        numOpen++;
+
+        if (it->isExclusive) {
+            continue;
+        }
+
+        // Idle connections are the best choice
+        if (it->pipeline.Empty()) {
+            return &*it;
+        }
+
+        // Requests which change server state shouldn't be pipelined, as they
+        // may not be safe to send again if the connection is lost
+        if (!rRequest.IsIdempotent() || !it->pipeline.Back().IsIdempotent()) {
+            continue;
+        }
+
+        if (it->pipeline.Size() >= mMaxPipeline) {
+            continue;
+        }
+
+        if (pShortest == nullptr ||
+            it->pipeline.Size() < pShortest->pipeline.Size()) {
+            pShortest = &*it;
+        }
+    }
+
+    // Parallel connections don't make requests wait for earlier responses
+    if (numOpen < mMaxConnections) {
+        return Open(rRequest);
+    }
+
+    return pShortest;
+}
+
+/**
+ * @brief Adds an async request to a connection's pipeline
+ *
+ * @param pConnection Pooled connection
+ * @param pRequest HTTP request
+ */
+void HttpConnectionPool::Assign(HttpConnection* pConnection,
+                                HttpRequest* pRequest) {
+    K_ASSERT(pConnection != nullptr);
+    K_ASSERT(pRequest != nullptr);
+    K_ASSERT(!pConnection->isClosing);
+    K_ASSERT(!pConnection->isExclusive);
+
+    if (!pConnection->pipeline.Empty()) {
+        mStats.numPipelined++;
+    } else if (pConnection->numServed > 0) {
+        mStats.numReuses++;
+    }
+
+    if (pConnection->pipeline.Empty()) {
+        // Synchronous requests may have disabled blocking. Async operations
+        // wait inside IOS, so the socket must block.
+        bool success = pConnection->pSocket->SetBlocking(true);
+        K_ASSERT(success);
+
+        // Time-out starts once the connection has something to do
+        pConnection->activeTick = OSGetTick();
+    }
+
+    pConnection->pipeline.PushBack(pRequest);
+    pRequest->mpConnection = pConnection;
+
+    // Connection must be established before sending anything
+    if (!pConnection->isConnected) {
+        if (!pConnection->isConnecting) {
+            pConnection->isConnecting = true;
+
+            LibSO::ConnectAsync(pConnection->pSocket->GetHandle(),
+                                pConnection->addr, ConnectCallbackFunc,
+                                pConnection);
+        }
+
+        return;
+    }
+
+    if (!pConnection->isSending) {
+        PostSend(pConnection);
+    }
+}
+
+/**
+ * @brief Assigns queued requests to available connections
+ */
+void HttpConnectionPool::ServiceWaitQueue() {
+    for (HttpConnection::RequestList::Iterator it = mWaitList.Begin();
+         it != mWaitList.End();) {
+
+        HttpConnection* pConnection = Find(*it);
+        if (pConnection == nullptr) {
+            ++it;
+            continue;
+        }
+
+        HttpRequest* pRequest = &*it;
+        it = mWaitList.Erase(it);
+        Assign(pConnection, pRequest);
+    }
+}
+
+/**
+ * @brief Gets the pipelined request which is next to be sent
+ *
+ * @param pConnection Pooled connection
+ * @return HTTP request, or nullptr if all have been sent
+ */
+HttpRequest*
+HttpConnectionPool::GetNextSend(HttpConnection* pConnection) const {
+    K_ASSERT(pConnection != nullptr);
+
+    // Pipelines are short, so this is cheaper than tracking another pointer
+    u32 i = 0;
+    K_FOREACH (pConnection->pipeline) {
+        if (i++ == pConnection->numSent) {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Sends the rest of the next request
+ *
+ * @param pConnection Pooled connection
+ */
+void HttpConnectionPool::PostSend(HttpConnection* pConnection) {
+    K_ASSERT(pConnection != nullptr);
+    K_ASSERT(!pConnection->isSending);
+
+    HttpRequest* pRequest = GetNextSend(pConnection);
+    if (pRequest == nullptr) {
+        return;
+    }
+
+    K_ASSERT(pConnection->sendOffset < pRequest->mAsyncSize);
+    pConnection->isSending = true;
+
+    LibSO::SendAsync(pConnection->pSocket->GetHandle(),
+                     pRequest->mpAsyncBuffer + pConnection->sendOffset,
+                     pRequest->mAsyncSize - pConnection->sendOffset, 0, nullptr,
+                     SendCallbackFunc, pConnection);
+}
+
+/**
+ * @brief Receives more response data
+ *
+ * @param pConnection Pooled connection
+ */
+void HttpConnectionPool::PostRecv(HttpConnection* pConnection) {
+    K_ASSERT(pConnection != nullptr);
+    K_ASSERT(!pConnection->isReceiving);
+
+    // Buffer is kept for the lifetime of the connection
+    if (pConnection->pRecvBuffer == nullptr) {
+        // Socket needs memory allocated in MEM2
+        pConnection->pRecvBuffer =
+            new (32, EMemory_MEM2) u8[scRecvBufferSize];
+        K_ASSERT(pConnection->pRecvBuffer != nullptr);
+    }
+
+    pConnection->isReceiving = true;
+
+    LibSO::RecvAsync(pConnection->pSocket->GetHandle(),
+                     pConnection->pRecvBuffer, scRecvBufferSize, 0, nullptr,
+                     RecvCallbackFunc, pConnection);
+}
+
+/**
+ * @brief Async connect callback
+ *
+ * @param result Socket library result
+ * @param pArg Callback user argument
+ */
+void HttpConnectionPool::ConnectCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+    HttpConnectionPool& r = GetInstance();
+
+    {
+        AutoMutexLock lock(sMutex);
+        r.CalcConnect(static_cast<HttpConnection*>(pArg), result);
+    }
+
+    r.FlushCompletions();
+}
+
+/**
+ * @brief Async send callback
+ *
+ * @param result Number of bytes sent, or IOS error code
+ * @param pArg Callback user argument
+ */
+void HttpConnectionPool::SendCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+    HttpConnectionPool& r = GetInstance();
+
+    {
+        AutoMutexLock lock(sMutex);
+        r.CalcSend(static_cast<HttpConnection*>(pArg), result);
+    }
+
+    r.FlushCompletions();
+}
+
+/**
+ * @brief Async receive callback
+ *
+ * @param result Number of bytes received, or IOS error code
+ * @param pArg Callback user argument
+ */
+void HttpConnectionPool::RecvCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+    HttpConnectionPool& r = GetInstance();
+
+    {
+        AutoMutexLock lock(sMutex);
+        r.CalcRecv(static_cast<HttpConnection*>(pArg), result);
+    }
+
+    r.FlushCompletions();
+}
+
+/**
+ * @brief Handles the async connect result
+ *
+ * @param pConnection Pooled connection
+ * @param result Socket library result
+ */
+void HttpConnectionPool::CalcConnect(HttpConnection* pConnection, s32 result) {
+    K_ASSERT(pConnection != nullptr);
+    pConnection->isConnecting = false;
+
+    // Connection to the server failed
+    if (result != SO_SUCCESS && result != SO_EISCONN) {
+        Fail(pConnection, EHttpErr_CantConnect, result);
+        return;
+    }
+
+    pConnection->isConnected = true;
+    pConnection->activeTick = OSGetTick();
+
+    PostSend(pConnection);
+}
+
+/**
+ * @brief Handles the async send result
+ *
+ * @param pConnection Pooled connection
+ * @param result Number of bytes sent, or IOS error code
+ */
+void HttpConnectionPool::CalcSend(HttpConnection* pConnection, s32 result) {
+    K_ASSERT(pConnection != nullptr);
+    pConnection->isSending = false;
+
+    // Nothing could be sent
+    if (result <= 0) {
+        Fail(pConnection, EHttpErr_Socket, result);
+        return;
+    }
+
+    // Connection failed while sending
+    if (pConnection->isClosing) {
+        Fail(pConnection, EHttpErr_Closed, SO_SUCCESS);
+        return;
+    }
+
+    HttpRequest* pRequest = GetNextSend(pConnection);
+    K_ASSERT(pRequest != nullptr);
+
+    pConnection->activeTick = OSGetTick();
+
+    // Partial sends are continued
+    pConnection->sendOffset += result;
+    if (pConnection->sendOffset < pRequest->mAsyncSize) {
+        PostSend(pConnection);
+        return;
+    }
+
+    pConnection->numSent++;
+    pConnection->sendOffset = 0;
+
+    // Response may have been handled before this completion (see CalcRecv)
+    if (pConnection->numSent == 1 && pRequest->IsResponseDone()) {
+        pConnection->pipeline.PopFront();
+        pConnection->numSent--;
+        pConnection->numServed++;
+
+        bool reuse = pRequest->IsReusable();
+        Complete(pRequest, EHttpErr_Success, SO_SUCCESS);
+
+        if (!reuse) {
+            Fail(pConnection, EHttpErr_Closed, SO_SUCCESS);
+            return;
+        }
+
+        if (pConnection->pipeline.Empty()) {
+            pConnection->idleTick = OSGetTick();
+
+            // Async requests may have been waiting for this server
+            ServiceWaitQueue();
+            return;
+        }
+    }
+
+    // Later requests are sent without waiting for the response
+    PostSend(pConnection);
+
+    if (!pConnection->isReceiving) {
+        PostRecv(pConnection);
+    }
+}
+
+/**
+ * @brief Handles the async receive result
+ *
+ * @param pConnection Pooled connection
+ * @param result Number of bytes received, or IOS error code
+ */
+void HttpConnectionPool::CalcRecv(HttpConnection* pConnection, s32 result) {
+    K_ASSERT(pConnection != nullptr);
+    pConnection->isReceiving = false;
+
+    if (result < 0) {
+        Fail(pConnection, EHttpErr_Socket, result);
+        return;
+    }
+
+    // Server has terminated the connection
+    if (result == 0) {
+        Fail(pConnection, EHttpErr_Closed, SO_SUCCESS);
+        return;
+    }
+
+    pConnection->activeTick = OSGetTick();
+
+    const u8* pData = pConnection->pRecvBuffer;
+    u32 size = result;
+
+    // Responses arrive in the order the requests were sent
+    while (size > 0 && !pConnection->pipeline.Empty()) {
+        HttpRequest& rRequest = pConnection->pipeline.Front();
+
+        // End of the response is unknown, so later ones can't be found
+        u32 used = 0;
+        if (!rRequest.Consume(pData, size, used)) {
+            Fail(pConnection, EHttpErr_BadResponse, SO_SUCCESS);
+            return;
+        }
+
+        pData += used;
+        size -= used;
+
+        if (!rRequest.IsResponseDone()) {
+            K_ASSERT(size == 0);
+            break;
+        }
+
+        // Send completion hasn't been handled yet (IOS doesn't order the
+        // replies), or the server answered early. The request is completed
+        // once IOS is done with its buffer.
+        if (pConnection->numSent == 0) {
+            break;
+        }
+
+        pConnection->pipeline.PopFront();
+        pConnection->numSent--;
+        pConnection->numServed++;
+
+        if (!rRequest.IsReusable()) {
+            pConnection->isClosing = true;
+        }
+
+        Complete(&rRequest, EHttpErr_Success, SO_SUCCESS);
+
+        if (pConnection->isClosing) {
+            break;
+        }
+    }
+
+    // Data without a matching request means the framing is wrong
+    if (size > 0 && !pConnection->isClosing) {
+        K_LOG("Unexpected HTTP response data\n");
+        pConnection->isClosing = true;
+    }
+
+    if (pConnection->isClosing) {
+        Fail(pConnection, EHttpErr_Closed, SO_SUCCESS);
+        return;
+    }
+
+    // Wait for the next response
+    if (!pConnection->pipeline.Empty()) {
+        // Nothing more can arrive until the next request is sent
+        if (!pConnection->pipeline.Front().IsResponseDone()) {
+            PostRecv(pConnection);
+        }
+
+        return;
+    }
+
+    pConnection->idleTick = OSGetTick();
+
+    // Async requests may have been waiting for this server
+    ServiceWaitQueue();
+}
+
+/**
+ * @brief Stops using a connection after an error or server close
+ * @details Requests which haven't received anything may be sent again
+ * over another connection.
+ *
+ * @param pConnection Pooled connection
+ * @param error Error code
+ * @param exError Internal error code
+ */
+void HttpConnectionPool::Fail(HttpConnection* pConnection, EHttpErr error,
+                              s32 exError) {
+    K_ASSERT(pConnection != nullptr);
+    pConnection->isClosing = true;
+
+    // Abort operations which are still in flight
+    if (pConnection->isSending || pConnection->isReceiving) {
+        (void)pConnection->pSocket->Shutdown(SO_SHUT_RDWR);
+    }
+
+    // Requests whose data is still being sent can't be released until IOS
+    // is done with their buffer
+    HttpRequest* pSending =
+        pConnection->isSending ? GetNextSend(pConnection) : nullptr;
+
+    for (HttpConnection::RequestList::Iterator it =
+             pConnection->pipeline.Begin();
+         it != pConnection->pipeline.End();) {
+
+        if (&*it == pSending) {
+            ++it;
+            continue;
+        }
+
+        HttpRequest* pRequest = &*it;
+        it = pConnection->pipeline.Erase(it);
+
+        // Response may have been complete already, or ended by the close
+        if (pRequest->IsResponseDone() ||
+            (error == EHttpErr_Closed && pRequest->IsCompleteAtClose())) {
+            Complete(pRequest, EHttpErr_Success, SO_SUCCESS);
+            continue;
+        }
+
+        // Nothing was received, so the request most likely never reached the
+        // server (i.e. it closed an idle connection). That can't be known for
+        // sure, so requests which change server state are never sent again.
+        bool retry = !pRequest->mIsRetried && !pRequest->HasResponseData() &&
+                     error != EHttpErr_CantConnect &&
+                     error != EHttpErr_TimedOut && pRequest->IsIdempotent();
+
+        if (!retry) {
+            Complete(pRequest, error, exError);
+            continue;
+        }
+
+        pRequest->ResetResponse();
+        pRequest->mIsRetried = true;
+        pRequest->mpConnection = nullptr;
+
+        mWaitList.PushBack(pRequest);
+        mStats.numRetries++;
+    }
+
+    // Remaining request is now the first to be sent
+    pConnection->numSent = 0;
+    pConnection->sendOffset = 0;
+
+    Retire(pConnection);
+
+    // Retried requests need another connection
+    ServiceWaitQueue();
+}
+
+/**
+ * @brief Tests whether a connection's async requests have timed out
+ *
+ * @param pConnection Pooled connection
+ * @param now Current time
+ */
+bool HttpConnectionPool::IsTimedOut(const HttpConnection* pConnection,
+                                    u32 now) const {
+    K_ASSERT(pConnection != nullptr);
+
+    // Synchronous requests apply their own time-out, and closing connections
+    // have already failed their requests
+    if (pConnection->isExclusive || pConnection->isClosing ||
+        pConnection->pipeline.Empty()) {
+        return false;
+    }
+
+    // Oldest request is the one waiting on the server
+    return now - pConnection->activeTick >=
+           pConnection->pipeline.Front().mTimeOut;
+}
+
+/**
+ * @brief Closes a connection once it is no longer used
+ *
+ * @param pConnection Pooled connection
+ */
+void HttpConnectionPool::Retire(HttpConnection* pConnection) {
+    K_ASSERT(pConnection != nullptr);
+    pConnection->isClosing = true;
+
+    // Last operation to finish will close it
+    if (pConnection->IsBusy()) {
+        return;
+    }
+
+    mConnections.Remove(pConnection);
+    delete pConnection;
+}
+
+/**
+ * @brief Schedules the completion of an async request
+ *
+ * @param pRequest HTTP request
+ * @param error Error code
+ * @param exError Internal error code
+ */
+void HttpConnectionPool::Complete(HttpRequest* pRequest, EHttpErr error,
+                                  s32 exError) {
+    K_ASSERT(pRequest != nullptr);
+
+    pRequest->mResponse.error = error;
+    pRequest->mResponse.exError = exError;
+
+    mDoneList.PushBack(pRequest);
+}
+
+/**
+ * @brief Invokes the callbacks of completed requests
+ * @note Called without holding the pool lock, as the callbacks may send
+ * more requests or destroy theirs
+ */
+void HttpConnectionPool::FlushCompletions() {
+    while (true) {
+        HttpRequest* pRequest = nullptr;
+
+        {
+            AutoMutexLock lock(sMutex);
+
+            if (mDoneList.Empty()) {
+                break;
+            }
+
+            pRequest = &mDoneList.Front();
+            mDoneList.PopFront();
+        }
+
+        pRequest->FinishAsync(pRequest->mResponse.error,
+                              pRequest->mResponse.exError);
+    }
+}
+
+} // namespace kiwi
@@ -0,0 +1,363 @@
+#ifndef LIBKIWI_NET_HTTP_CONNECTION_POOL_H
+#define LIBKIWI_NET_HTTP_CONNECTION_POOL_H
+#include <libkiwi/core/kiwiSceneHookMgr.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiHttpRequest.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
+#include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/util/kiwiStaticSingleton.h>
+
+#include <revolution/OS.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_net
+//! @{
+
+// Forward declarations
+class SocketBase;
+
+/**
+ * @brief Persistent (keep-alive) connection to an HTTP server
+ */
+struct HttpConnection {
+    //! Requests in response order
+    typedef TIntrusiveList<HttpRequest, &HttpRequest::mPoolNode> RequestList;
+
+    /**
+     * @brief Constructor
+     *
+     * @param rHost Server hostname
+     * @param _port Server port
+     * @param rAddr Server address
+     */
+    HttpConnection(const String& rHost, u16 _port, const SockAddr4& rAddr);
+
+    /**
+     * @brief Destructor
+     */
+    ~HttpConnection();
+
+    /**
+     * @brief Tests whether the connection is being used
+     */
+    bool IsBusy() const {
+        return isExclusive || isConnecting || isSending || isReceiving ||
+               !pipeline.Empty();
+    }
+
+    String host;         // Server hostname
+    u16 port;            // Server port
+    SockAddr4 addr;      // Server address
+    SocketBase* pSocket; // Connection to the server
+
+    bool isConnected;  // Whether the connection is established
+    bool isConnecting; // Whether an async connect is in flight
+    bool isSending;    // Whether an async send is in flight
+    bool isReceiving;  // Whether an async receive is in flight
+    bool isExclusive;  // Whether a synchronous request is using it
+    bool isClosing;    // Whether to close it once it is no longer used
+
+    RequestList pipeline; // Async requests sent or waiting to be sent
+    u32 numSent;          // Pipelined requests which have been fully sent
+    u32 sendOffset;       // Data of the next request sent so far
+    u8* pRecvBuffer;      // Response buffer (MEM2)
+
+    u32 idleTick;   // Time when the connection became idle
+    u32 activeTick; // Time of the last progress on an async request
+    u32 numServed;  // Responses received over the connection
+
+    IntrusiveListNode node; // Node in the pool's connection list
+};
+
+/**
+ * @brief HTTP keep-alive connection pool
+ * @details Requests to the same server reuse connections instead of paying
+ * for a new TCP handshake each time. Asynchronous GET requests are pipelined,
+ * so several may be sent before the first response arrives. Connections are
+ * closed when they have been idle for too long, and fail their requests when
+ * the server stops responding for longer than the requests' time-out.
+ *
+ * Requests opt in through HttpRequest::SetKeepAlive.
+ */
+class HttpConnectionPool : public StaticSingleton<HttpConnectionPool>,
+                           public ISceneHook {
+    friend class StaticSingleton<HttpConnectionPool>;
+    friend class HttpRequest;
+
+public:
+    /**
+     * @brief Pool statistics
+     */
+    struct Stats {
+        u32 numConnects;  // Connections opened
+        u32 numReuses;    // Requests sent over an idle connection
+        u32 numPipelined; // Requests sent before the previous response
+        u32 numRetries;   // Requests sent again after the connection closed
+        u32 numEvicted;   // Connections closed after being idle
+        u32 numTimeouts;  // Connections/requests failed after a time-out
+    };
+
+    //! Default connection limit per server
+    static const u32 DEFAULT_MAX_CONNECTIONS = 2;
+    //! Default limit of requests in flight per connection
+    static const u32 DEFAULT_MAX_PIPELINE = 4;
+    //! Default idle time before a connection is closed, in milliseconds
+    static const u32 DEFAULT_IDLE_TIMEOUT = 5000;
+
+public:
+    /**
+     * @brief Sets the connection limit per server
+     * @note Synchronous requests may exceed this, as they can't wait
+     *
+     * @param max Maximum number of connections
+     */
+    void SetMaxConnections(u32 max);
+    /**
+     * @brief Sets the limit of requests in flight per connection
+     *
+     * @param max Maximum pipeline depth (one to disable pipelining)
+     */
+    void SetMaxPipeline(u32 max);
+    /**
+     * @brief Sets how long a connection may stay idle
+     *
+     * @param timeOut Idle time before the connection is closed, in
+     * milliseconds
+     */
+    void SetIdleTimeOut(u32 timeOut);
+
+    /**
+     * @brief Closes all idle connections
+     */
+    void Clear();
+
+    /**
+     * @brief Gets the pool statistics
+     */
+    Stats GetStats() const;
+    /**
+     * @brief Resets the pool statistics
+     */
+    void ResetStats();
+
+    /**
+     * @brief Calculate callback (after game logic)
+     * @details Closes connections which have been idle for too long, and
+     * fails those whose async requests have timed out (including requests
+     * over their own sockets)
+     *
+     * @param pScene Current scene
+     */
+    virtual void AfterCalculate(RPSysScene* pScene);
+
+private:
+    //! Connections in the pool
+    typedef TIntrusiveList<HttpConnection, &HttpConnection::node>
+        ConnectionList;
+
+    //! Size of each connection's response buffer
+    static const u32 scRecvBufferSize = 1024;
+
+private:
+    /**
+     * @brief Constructor
+     */
+    HttpConnectionPool();
+    /**
+     * @brief Destructor
+     */
+    virtual ~HttpConnectionPool();
+
+    /**
+     * @name Synchronous requests
+     */
+    /**@{*/
+    /**
+     * @brief Takes an idle connection to the server, or opens a new one
+     *
+     * @param rRequest HTTP request
+     */
+    HttpConnection* Acquire(const HttpRequest& rRequest);
+    /**
+     * @brief Returns a connection taken with Acquire
+     *
+     * @param pConnection Pooled connection
+     * @param reuse Whether the connection can be used again
+     */
+    void Release(HttpConnection* pConnection, bool reuse);
+    /**@}*/
+
+    /**
+     * @name Asynchronous requests
+     */
+    /**@{*/
+    /**
+     * @brief Sends a request over a pooled connection
+     * @details The request waits in a queue if the server's connections are
+     * all in use.
+     *
+     * @param pRequest HTTP request
+     */
+    void Submit(HttpRequest* pRequest);
+    /**
+     * @brief Watches an async request over its own socket for time-out
+     *
+     * @param pRequest HTTP request
+     */
+    void Watch(HttpRequest* pRequest);
+    /**
+     * @brief Stops watching an async request over its own socket
+     *
+     * @param pRequest HTTP request
+     */
+    void Unwatch(HttpRequest* pRequest);
+    /**@}*/
+
+    /**
+     * @brief Opens a connection to the server
+     *
+     * @param rRequest HTTP request
+     */
+    HttpConnection* Open(const HttpRequest& rRequest);
+    /**
+     * @brief Finds a connection which can take an async request
+     *
+     * @param rRequest HTTP request
+     * @return Pooled connection, or nullptr if all are in use
+     */
+    HttpConnection* Find(const HttpRequest& rRequest);
+    /**
+     * @brief Adds an async request to a connection's pipeline
+     *
+     * @param pConnection Pooled connection
+     * @param pRequest HTTP request
+     */
+    void Assign(HttpConnection* pConnection, HttpRequest* pRequest);
+    /**
+     * @brief Assigns queued requests to available connections
+     */
+    void ServiceWaitQueue();
+
+    /**
+     * @brief Gets the pipelined request which is next to be sent
+     *
+     * @param pConnection Pooled connection
+     * @return HTTP request, or nullptr if all have been sent
+     */
+    HttpRequest* GetNextSend(HttpConnection* pConnection) const;
+
+    /**
+     * @brief Sends the rest of the next request
+     *
+     * @param pConnection Pooled connection
+     */
+    void PostSend(HttpConnection* pConnection);
+    /**
+     * @brief Receives more response data
+     *
+     * @param pConnection Pooled connection
+     */
+    void PostRecv(HttpConnection* pConnection);
+
+    /**
+     * @brief Async connect callback
+     *
+     * @param result Socket library result
+     * @param pArg Callback user argument
+     */
+    static void ConnectCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Async send callback
+     *
+     * @param result Number of bytes sent, or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void SendCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Async receive callback
+     *
+     * @param result Number of bytes received, or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void RecvCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Handles the async connect result
+     *
+     * @param pConnection Pooled connection
+     * @param result Socket library result
+     */
+    void CalcConnect(HttpConnection* pConnection, s32 result);
+    /**
+     * @brief Handles the async send result
+     *
+     * @param pConnection Pooled connection
+     * @param result Number of bytes sent, or IOS error code
+     */
+    void CalcSend(HttpConnection* pConnection, s32 result);
+    /**
+     * @brief Handles the async receive result
+     *
+     * @param pConnection Pooled connection
+     * @param result Number of bytes received, or IOS error code
+     */
+    void CalcRecv(HttpConnection* pConnection, s32 result);
+
+    /**
+     * @brief Stops using a connection after an error or server close
+     * @details Requests which haven't received anything may be sent again
+     * over another connection.
+     *
+     * @param pConnection Pooled connection
+     * @param error Error code
+     * @param exError Internal error code
+     */
+    void Fail(HttpConnection* pConnection, EHttpErr error, s32 exError);
+    /**
+     * @brief Tests whether a connection's async requests have timed out
+     *
+     * @param pConnection Pooled connection
+     * @param now Current time
+     */
+    bool IsTimedOut(const HttpConnection* pConnection, u32 now) const;
+    /**
+     * @brief Closes a connection once it is no longer used
+     *
+     * @param pConnection Pooled connection
+     */
+    void Retire(HttpConnection* pConnection);
+
+    /**
+     * @brief Schedules the completion of an async request
+     *
+     * @param pRequest HTTP request
+     * @param error Error code
+     * @param exError Internal error code
+     */
+    void Complete(HttpRequest* pRequest, EHttpErr error, s32 exError);
+    /**
+     * @brief Invokes the callbacks of completed requests
+     * @note Called without holding the pool lock, as the callbacks may send
+     * more requests or destroy theirs
+     */
+    void FlushCompletions();
+
+private:
+    ConnectionList mConnections;            // Open connections
+    HttpConnection::RequestList mWaitList;  // Requests waiting for connections
+    HttpConnection::RequestList mDoneList;  // Requests waiting for callbacks
+    HttpConnection::RequestList mWatchList; // Requests over their own sockets
+
+    u32 mMaxConnections; // Connection limit per server
+    u32 mMaxPipeline;    // Limit of requests in flight per connection
+    u32 mIdleTimeOut;    // Idle time before closing, in milliseconds
+
+    Stats mStats; // Pool statistics
+
+    static OSMutex sMutex; // Pool lock
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
@@ -1,9 +1,8 @@
 #include <libkiwi.h>
 
-#include <cstdlib>
+#include <cstring>
 
 namespace kiwi {
-
 /**
  * @brief HTTP request method names
  */
@@ -14,26 +13,54 @@ const String HttpRequest::METHOD_NAMES[EMethod_Max] = {"GET", "POST"};
  */
 const String HttpRequest::PROTOCOL_VERSION = "HTTP/1.1";
 
+namespace {
+
+/**
+ * @brief Appends a string to a segment list
+ * @note The string must outlive the segment
+ *
+ * @param rSegments Segment list
+ * @param rStr String
+ * @return String length
+ */
+u32 AddSegment(TVector<SockSegment>& rSegments, const String& rStr) {
+    // Empty segments would only make the list longer
+    if (!rStr.Empty()) {
+        rSegments.PushBack(SockSegment(rStr.CStr(), rStr.Length()));
+    }
+
+    return rStr.Length();
+}
+
+/**
+ * @brief Appends a string literal to a segment list
+ *
+ * @param rSegments Segment list
+ * @param pStr String literal
+ * @return String length
+ */
+u32 AddSegment(TVector<SockSegment>& rSegments, const char* pStr) {
+    K_ASSERT(pStr != nullptr);
+
+    u32 len = std::strlen(pStr);
+    rSegments.PushBack(SockSegment(pStr, len));
+
+    return len;
+}
+
+} // namespace
+
 /**
  * @brief Constructor
  *
  * @param rHost Server hostname
  * @param port Connection port
  */
-HttpRequest::HttpRequest(const String& rHost, u16 port) {
-    // Socket is owned by this request
+HttpRequest::HttpRequest(const String& rHost, u16 port) : mParser(mResponse) {
+    // Socket is owned by this request (or the connection pool), and is
+    // only opened once the request is sent
     mIsUserSocket = false;
-    mpSocket = new SyncSocket(SO_PF_INET, SO_SOCK_STREAM);
-    K_ASSERT(mpSocket != nullptr);
-    K_ASSERT(mpSocket->IsOpen());
-
-    // Timeout requires non-blocking
-    bool success = mpSocket->SetBlocking(false);
-    K_ASSERT(success);
-
-    // Any local port is fine
-    success = mpSocket->Bind();
-    K_ASSERT(success);
+    mpSocket = nullptr;
 
     mHost = rHost;
     mPort = port;
@@ -46,7 +73,7 @@ HttpRequest::HttpRequest(const String& rHost, u16 port) {
  *
  * @param pSocket Socket connected to the server
  */
-HttpRequest::HttpRequest(SocketBase* pSocket) {
+HttpRequest::HttpRequest(SocketBase* pSocket) : mParser(mResponse) {
     // TODO: How can we test here that the socket is connected?
     K_ASSERT(pSocket != nullptr);
     K_ASSERT(pSocket->IsOpen());
@@ -65,8 +92,7 @@ HttpRequest::HttpRequest(SocketBase* pSocket) {
     mHost = "";
     mPort = 0;
 
-    // TODO: Need state machine for request/receive (can reuse for synchronous)
-    K_ASSERT_EX(false, "Not implemented.");
+    Init();
 }
 
 /**
@@ -76,12 +102,24 @@ HttpRequest::~HttpRequest() {
     K_ASSERT_EX(mpCallback == nullptr,
                 "Don't destroy this object while async request is pending.");
 
+    K_ASSERT_EX(mpConnection == nullptr,
+                "Don't destroy this object while its connection is in use.");
+
     // User-provided socket will outlive this request
     if (!mIsUserSocket) {
         delete mpSocket;
     }
 
     mpSocket = nullptr;
+
+    delete[] mpAsyncBuffer;
+    mpAsyncBuffer = nullptr;
+
+    delete[] mpStreamBuffer;
+    mpStreamBuffer = nullptr;
+
+    delete[] mpUpgradeData;
+    mpUpgradeData = nullptr;
 }
 
 /**
@@ -89,6 +127,10 @@ HttpRequest::~HttpRequest() {
  */
 void HttpRequest::Init() {
     mIsSent = false;
+    mIsKeepAlive = false;
+    mIsRetried = false;
+    mIsResolved = false;
+    mpConnection = nullptr;
     mMethod = EMethod_Max;
     mResource = "/";
     mTimeOut = OS_MSEC_TO_TICKS(DEFAULT_TIMEOUT);
@@ -96,6 +138,23 @@ void HttpRequest::Init() {
     mpCallback = nullptr;
     mpCallbackArg = nullptr;
 
+    mState = EState_Idle;
+    mpAsyncBuffer = nullptr;
+    mAsyncBufferSize = 0;
+    mAsyncOffset = 0;
+    mAsyncSize = 0;
+    mActiveTick = 0;
+    mIsTimedOut = false;
+
+    mpBodyStream = nullptr;
+    mpStreamBuffer = nullptr;
+    mStreamBufferSize = 0;
+    mStreamOffset = 0;
+    mIsStreamError = false;
+
+    mpUpgradeData = nullptr;
+    mUpgradeDataSize = 0;
+
     mHeader["Host"] = mHost;
     mHeader["User-Agent"] = "libkiwi";
     mHeader["Connection"] = "close";
@@ -109,8 +168,6 @@ void HttpRequest::Init() {
  */
 const HttpResponse& HttpRequest::Send(EMethod method) {
     K_ASSERT(method < EMethod_Max);
-    K_ASSERT(mpSocket != nullptr);
-    K_ASSERT(mpSocket->IsOpen());
 
     mMethod = method;
     mpCallback = nullptr;
@@ -122,6 +179,13 @@ const HttpResponse& HttpRequest::Send(EMethod method) {
 
 /**
  * @brief Sends request asynchronously
+ * @details Socket operations are completed by IOS, so no thread is
+ * blocked while waiting for the server
+ * @note The hostname is resolved on the calling thread before this
+ * returns. If that fails, the callback is invoked right away.
+ * @note The callback is invoked from the IOS dispatcher thread
+ * @note If the server stops responding for longer than the time-out, the
+ * socket is shut down and the request fails with EHttpErr_TimedOut
  *
  * @param pCallback Response callback
  * @param pArg Callback user argument
@@ -130,16 +194,129 @@ const HttpResponse& HttpRequest::Send(EMethod method) {
 void HttpRequest::SendAsync(Callback pCallback, void* pArg, EMethod method) {
     K_ASSERT_EX(pCallback != nullptr, "You will lose the reponse!");
     K_ASSERT(method < EMethod_Max);
-    K_ASSERT(mpSocket != nullptr);
-    K_ASSERT(mpSocket->IsOpen());
+
+    // See SendImpl
+    K_ASSERT_EX(!mIsSent, "Please don't re-send the same request object.");
+    if (mIsSent) {
+        mResponse.error = EHttpErr_Usage;
+        pCallback(mResponse, pArg);
+        return;
+    }
+
+    // Prevent future usage of this object
+    mIsSent = true;
 
     mMethod = method;
     mpCallback = pCallback;
     mpCallbackArg = pArg;
 
-    // TODO: Need state machine for request/receive (can reuse for synchronous)
-    K_ASSERT_EX(false, "Not implemented.");
-    // Thread t(SendImpl, *this);
+    TVector<SockSegment> segments;
+    u32 size = BuildRequest(segments);
+
+    // Buffer is reused for the response once the request is sent
+    mAsyncBufferSize = Max<u32>(size, TEMP_BUFFER_SIZE);
+
+    // Socket needs memory allocated in MEM2
+    mpAsyncBuffer = new (32, EMemory_MEM2) u8[mAsyncBufferSize];
+    K_ASSERT(mpAsyncBuffer != nullptr);
+
+    // Request is gathered straight into the socket buffer
+    u8* pDst = mpAsyncBuffer;
+    for (u32 i = 0; i < segments.Size(); i++) {
+        std::memcpy(pDst, segments[i].pData, segments[i].size);
+        pDst += segments[i].size;
+    }
+
+    mAsyncOffset = 0;
+    mAsyncSize = size;
+
+    ResetResponse();
+
+    // DNS lookups block, so they must not happen on the dispatcher thread
+    if (!Resolve()) {
+        FinishAsync(EHttpErr_CantConnect, LibSO::GetLastError());
+        return;
+    }
+
+    // Pool decides which connection carries the request
+    if (mIsKeepAlive) {
+        HttpConnectionPool::GetInstance().Submit(this);
+        return;
+    }
+
+    // Request-owned sockets are opened on demand
+    if (!mIsUserSocket) {
+        OpenSocket();
+    }
+
+    // Operations wait inside IOS rather than on this thread, so the socket
+    // must block (non-blocking sockets would just complete with EWOULDBLOCK)
+    bool success = mpSocket->SetBlocking(true);
+    K_ASSERT(success);
+
+    // Pool checks for time-out once per frame
+    HttpConnectionPool::GetInstance().Watch(this);
+
+    // Request-owned sockets won't have a connection yet
+    if (!mIsUserSocket) {
+        mState = EState_Connecting;
+        LibSO::ConnectAsync(mpSocket->GetHandle(), mAddr, AsyncCallbackFunc,
+                            this);
+    } else {
+        mState = EState_Requesting;
+        PostSend();
+    }
+}
+
+/**
+ * @brief Toggles persistent connections (HTTP keep-alive)
+ * @details Requests to the same server share connections from the
+ * HttpConnectionPool, and asynchronous GET requests may be pipelined.
+ * @note Only requests created with a hostname can use the pool
+ *
+ * @param enable Whether to keep the connection alive
+ */
+void HttpRequest::SetKeepAlive(bool enable) {
+    K_ASSERT_EX(!mIsUserSocket, "User-provided sockets can't be pooled.");
+    K_ASSERT_EX(!mIsSent, "Please set this before sending the request.");
+
+    mIsKeepAlive = enable && !mIsUserSocket;
+    mHeader["Connection"] = mIsKeepAlive ? "keep-alive" : "close";
+}
+
+/**
+ * @brief Passes the response body to a callback instead of storing it
+ * @details The body is decoded (de-chunked) before it is passed on, and
+ * HttpResponse::body is left empty.
+ * @note For async requests, the callback is invoked from the IOS
+ * dispatcher thread
+ *
+ * @param pCallback Body callback (nullptr to store the body again)
+ * @param pArg Callback user argument
+ */
+void HttpRequest::SetBodyCallback(BodyCallback pCallback, void* pArg) {
+    K_ASSERT_EX(!mIsSent, "Please set this before sending the request.");
+
+    mpBodyStream = nullptr;
+    mParser.SetBodyCallback(pCallback, pArg);
+}
+
+/**
+ * @brief Writes the response body to a stream instead of storing it
+ * @details Data is staged in an aligned buffer if the stream requires
+ * it, so streams like NAND files can be written directly. The final
+ * block is padded with zeroes up to the stream's size alignment.
+ * @note The stream must outlive the request
+ *
+ * @param pStream Output stream (nullptr to store the body again)
+ */
+void HttpRequest::SetBodyStream(IStream* pStream) {
+    K_ASSERT_EX(!mIsSent, "Please set this before sending the request.");
+    K_ASSERT(pStream == nullptr || pStream->CanWrite());
+
+    mpBodyStream = pStream;
+    mParser.SetBodyCallback(pStream != nullptr ? BodyStreamFunc : nullptr,
+                            this);
 }
 
 /**
@@ -147,8 +324,6 @@ void HttpRequest::SendAsync(Callback pCallback, void* pArg, EMethod method) {
  */
 void HttpRequest::SendImpl() {
     K_ASSERT(mMethod < EMethod_Max);
-    K_ASSERT(mpSocket != nullptr);
-    K_ASSERT(mpSocket->IsOpen());
 
     /**
      * Because the request contains a socket,
@@ -164,23 +339,151 @@ void HttpRequest::SendImpl() {
     // Prevent future usage of this object
     mIsSent = true;
 
+    bool reused = AcquireSocket();
+    bool success = Exchange();
+
+    // Idle connections may have been closed by the server in the meantime.
+    // Nothing was received, so the request most likely never reached the
+    // server, but only requests without side effects are sent again.
+    if (!success && reused && !HasResponseData() && IsIdempotent()) {
+        ReleaseSocket(false);
+
+        ResetResponse();
+        mIsRetried = true;
+
+        (void)AcquireSocket();
+        success = Exchange();
+    }
+
+    ReleaseSocket(success && IsReusable());
+
+    // Staged body data must reach the stream before the response is used
+    if (success && !FlushBodyStream()) {
+        mResponse.error = EHttpErr_Stream;
+    }
+
+    // Dispatch user callback
+    if (mpCallback != nullptr) {
+        mpCallback(mResponse, mpCallbackArg);
+    }
+
+    // Signal to destructor
+#ifndef NDEBUG
+    mpCallback = nullptr;
+#endif
+}
+
+/**
+ * @brief Resolves the server address (once)
+ *
+ * @return Success
+ */
+bool HttpRequest::Resolve() {
+    // User-provided socket is already connected
+    if (mIsUserSocket || mIsResolved) {
+        return true;
+    }
+
+    mAddr = SockAddr4(mHost, mPort);
+    mIsResolved = mAddr.IsValid();
+
+    return mIsResolved;
+}
+
+/**
+ * @brief Prepares a connection to the server (sync)
+ *
+ * @return Whether an existing connection was reused
+ */
+bool HttpRequest::AcquireSocket() {
+    // User-provided socket is already connected
+    if (mIsUserSocket) {
+        return false;
+    }
+
+    // Hostname is only resolved once, even if the request is sent again
+    (void)Resolve();
+
+    if (mIsKeepAlive) {
+        mpConnection = HttpConnectionPool::GetInstance().Acquire(*this);
+        K_ASSERT(mpConnection != nullptr);
+        mpSocket = mpConnection->pSocket;
+    } else {
+        OpenSocket();
+    }
+
+    // Timeout requires non-blocking
+    bool success = mpSocket->SetBlocking(false);
+    K_ASSERT(success);
+
+    return mpConnection != nullptr && mpConnection->isConnected;
+}
+
+/**
+ * @brief Gives up the connection to the server (sync)
+ *
+ * @param reuse Whether the connection can be used again
+ */
+void HttpRequest::ReleaseSocket(bool reuse) {
+    // User-provided socket will outlive this request
+    if (mIsUserSocket) {
+        return;
+    }
+
+    if (mpConnection != nullptr) {
+        HttpConnectionPool::GetInstance().Release(mpConnection, reuse);
+        mpConnection = nullptr;
+    } else {
+        delete mpSocket;
+    }
+
+    mpSocket = nullptr;
+}
+
+/**
+ * @brief Opens a request-owned socket
+ */
+void HttpRequest::OpenSocket() {
+    K_ASSERT(!mIsUserSocket);
+    K_ASSERT(mpSocket == nullptr);
+
+    mpSocket = new SyncSocket(SO_PF_INET, SO_SOCK_STREAM);
+    K_ASSERT(mpSocket != nullptr);
+    K_ASSERT(mpSocket->IsOpen());
+
+    // Any local port is fine
+    bool success = mpSocket->Bind();
+    K_ASSERT(success);
+}
+
+/**
+ * @brief Connects to the server and exchanges the request/response
+ *
+ * @return Success
+ */
+bool HttpRequest::Exchange() {
+    K_ASSERT(mpSocket != nullptr);
+    K_ASSERT(mpSocket->IsOpen());
+
     // Beginning timestamp
     Watch w;
     w.Start();
 
-    // Establish connection with server
-    while (true) {
-        bool connected = true;
+    // User-provided/pooled sockets may already have a connection
+    bool connected =
+        mIsUserSocket || (mpConnection != nullptr && mpConnection->isConnected);
 
-        // Request-owned sockets won't have a connection yet
-        if (!mIsUserSocket) {
-            connected = mpSocket->Connect(SockAddr4(mHost, mPort));
-        }
+    // Hostname could not be resolved (see AcquireSocket)
+    if (!connected && !mIsResolved) {
+        mResponse.error = EHttpErr_CantConnect;
+        mResponse.exError = LibSO::GetLastError();
+        return false;
+    }
 
-        // After connection we can perform the request
+    // Establish connection with server
+    while (!connected) {
+        connected = mpSocket->Connect(mAddr);
         if (connected) {
-            (void)Request();
-            (void)Receive();
             break;
         }
 
@@ -194,19 +497,16 @@ void HttpRequest::SendImpl() {
         if (w.Elapsed() >= mTimeOut) {
             mResponse.error = EHttpErr_TimedOut;
             mResponse.exError = LibSO::GetLastError();
-            break;
+            return false;
         }
     }
 
-    // Dispatch user callback
-    if (mpCallback != nullptr) {
-        mpCallback(mResponse, mpCallbackArg);
+    if (mpConnection != nullptr) {
+        mpConnection->isConnected = true;
     }
 
-    // Signal to destructor
-#ifndef NDEBUG
-    mpCallback = nullptr;
-#endif
+    // After connection we can perform the request
+    return Request() && Receive();
 }
 
 /**
@@ -219,39 +519,12 @@ bool HttpRequest::Request() {
     K_ASSERT(mpSocket != nullptr);
     K_ASSERT(mpSocket->IsOpen());
 
-    // Request line begins with the resource
-    String request = mResource;
-
-    // URL parameter string
-    K_FOREACH (mParams) {
-        // Parameters delimited by ampersand
-        String fmt = it == mParams.Begin() ? "?%s=%s" : "&%s=%s";
-        request += Format(fmt, it.Key().CStr(), it.Value().CStr());
-    }
-
-    // Finish request line
-    request = Format("%s %s %s\n", METHOD_NAMES[mMethod].CStr(), request.CStr(),
-                     PROTOCOL_VERSION.CStr());
-
-    // Build header fields
-    K_FOREACH (mHeader) {
-        request += Format("%s: %s\n", it.Key().CStr(), it.Value().CStr());
-    }
-
-    // Request ends with extra newline
-    request += "\n";
-
-    // Socket needs memory allocated in MEM2
-    WorkBufferArg arg;
-    arg.region = EMemory_MEM2;
-    arg.size = request.Length();
-
-    WorkBuffer buffer(arg);
-    std::memcpy(buffer.Contents(), request.CStr(), request.Length());
+    TVector<SockSegment> segments;
+    u32 size = BuildRequest(segments);
 
-    // Send request data
-    Optional<u32> sent = mpSocket->SendBytes(buffer.Contents(), buffer.Size());
-    bool success = sent && *sent == buffer.Size();
+    // Socket gathers the request into MEM2 itself
+    Optional<u32> sent = mpSocket->SendV(segments.Data(), segments.Size());
+    bool success = sent && *sent == size;
 
     // Record socket library error if it failed
     if (!success) {
@@ -276,24 +549,15 @@ bool HttpRequest::Receive() {
     Watch w;
     w.Start();
 
-    /******************************************************************************
-     * Receive response headers
-     ******************************************************************************/
-    // Buffer for headers
-    String work;
-    // Try to avoid reallocation
-    work.Reserve(TEMP_BUFFER_SIZE * 2);
-
     // Socket needs memory allocated in MEM2
     WorkBufferArg arg;
     arg.region = EMemory_MEM2;
     arg.size = TEMP_BUFFER_SIZE;
     WorkBuffer buffer(arg);
 
-    size_t end = String::npos;
-    while (end == String::npos) {
+    while (!IsResponseDone()) {
         Optional<u32> nrecv =
-            mpSocket->RecvBytes(buffer.Contents(), buffer.AlignedSize() - 1);
+            mpSocket->RecvBytes(buffer.Contents(), buffer.AlignedSize());
 
         // Record socket library error if it failed
         if (!nrecv) {
@@ -304,128 +568,420 @@ bool HttpRequest::Receive() {
 
         // Server has terminated the connection
         if (*nrecv == 0 && LibSO::GetLastError() != SO_EWOULDBLOCK) {
+            // This is only okay if we've read enough of the body
+            if (mParser.Close()) {
+                break;
+            }
+
             mResponse.error = EHttpErr_Closed;
             mResponse.exError = LibSO::GetLastError();
             return false;
         }
 
-        if (*nrecv > 0) {
-            // Continue to build string
-            buffer.Contents()[*nrecv] = '\0';
-            work += reinterpret_cast<char*>(buffer.Contents());
+        // Response is parsed as it arrives
+        u32 used = 0;
+        if (*nrecv > 0 && !Consume(buffer.Contents(), *nrecv, used)) {
+            mResponse.error = EHttpErr_BadResponse;
+            mResponse.exError = LibSO::GetLastError();
+            return false;
+        }
 
-            // Response header ends in double newline
-            end = work.Find("\r\n\r\n");
+        // Anything after a protocol switch belongs to the new protocol
+        if (IsResponseDone()) {
+            KeepUpgradeData(buffer.Contents() + used, *nrecv - used);
+            break;
         }
 
         // Connection timeout
         if (w.Elapsed() >= mTimeOut) {
+            // Timeout may be the only way to end a body without a length
+            if (mParser.Close()) {
+                break;
+            }
+
             mResponse.error = EHttpErr_TimedOut;
             mResponse.exError = LibSO::GetLastError();
             return false;
         }
     }
 
-    // Point index at end of sequence instead of start
-    end += sizeof("\r\n\r\n") - 1;
-    String headers = work.SubStr(0, end);
+    mResponse.error = EHttpErr_Success;
+    mResponse.exError = LibSO::GetLastError();
+    return true;
+}
+
+/**
+ * @brief Lists the pieces of the request message
+ * @details Segments point into the request's own strings, so the message
+ * isn't formatted into one buffer
+ *
+ * @param[out] rSegments Request line, header field, and end segments
+ * @return Request message size
+ */
+u32 HttpRequest::BuildRequest(TVector<SockSegment>& rSegments) const {
+    K_ASSERT(mMethod < EMethod_Max);
 
-    /******************************************************************************
-     * Build header dictionary
-     ******************************************************************************/
-    TVector<String> lines = headers.Split("\r\n");
+    rSegments.Clear();
 
-    // Needs at least one line (for status code)
-    if (lines.Empty()) {
-        mResponse.error = EHttpErr_BadResponse;
-        mResponse.exError = LibSO::GetLastError();
-        return false;
+    // Each parameter and field is split around its separators
+    rSegments.Reserve(6 + mParams.Size() * 4 + mHeader.Size() * 4 + 1);
+
+    u32 size = 0;
+
+    // Request line
+    size += AddSegment(rSegments, METHOD_NAMES[mMethod]);
+    size += AddSegment(rSegments, " ");
+    size += AddSegment(rSegments, mResource);
+
+    // URL parameter string
+    K_FOREACH (mParams) {
+        // Parameters delimited by ampersand
+        size += AddSegment(rSegments, it == mParams.Begin() ? "?" : "&");
+        size += AddSegment(rSegments, it.Key());
+        size += AddSegment(rSegments, "=");
+        size += AddSegment(rSegments, it.Value());
     }
 
-    // Extract status code
-    int num =
-        std::sscanf(lines[0], PROTOCOL_VERSION + " %d", &mResponse.status);
-    if (num != 1) {
-        mResponse.error = EHttpErr_BadResponse;
-        mResponse.exError = LibSO::GetLastError();
+    size += AddSegment(rSegments, " ");
+    size += AddSegment(rSegments, PROTOCOL_VERSION);
+    size += AddSegment(rSegments, "\n");
+
+    // Header fields
+    K_FOREACH (mHeader) {
+        size += AddSegment(rSegments, it.Key());
+        size += AddSegment(rSegments, ": ");
+        size += AddSegment(rSegments, it.Value());
+        size += AddSegment(rSegments, "\n");
+    }
+
+    // Request ends with extra newline
+    size += AddSegment(rSegments, "\n");
+
+    return size;
+}
+
+/**
+ * @brief Discards any response data received so far
+ */
+void HttpRequest::ResetResponse() {
+    mResponse = HttpResponse();
+    mParser.Reset();
+
+    mStreamOffset = 0;
+    mIsStreamError = false;
+}
+
+/**
+ * @brief Handles received response data
+ * @details Data following the end of the response is not used, as it
+ * belongs to the next response on a pipelined connection.
+ *
+ * @param pData Received data
+ * @param size Data size
+ * @param[out] rUsed Number of bytes belonging to this response
+ * @return Success (false if the response is malformed)
+ */
+bool HttpRequest::Consume(const u8* pData, u32 size, u32& rUsed) {
+    K_ASSERT(pData != nullptr);
+    K_ASSERT(!IsResponseDone());
+
+    return mParser.Parse(pData, size, rUsed);
+}
+
+/**
+ * @brief Keeps data which followed a 'Switching Protocols' response
+ *
+ * @param pData Data following the response
+ * @param size Data size
+ */
+void HttpRequest::KeepUpgradeData(const u8* pData, u32 size) {
+    // Otherwise it belongs to the next response on a pipelined connection
+    if (size == 0 || mResponse.status != EHttpStatus_SwitchProto) {
+        return;
+    }
+
+    K_ASSERT(mpUpgradeData == nullptr);
+
+    mpUpgradeData = new u8[size];
+    K_ASSERT(mpUpgradeData != nullptr);
+
+    std::memcpy(mpUpgradeData, pData, size);
+    mUpgradeDataSize = size;
+}
+
+/**
+ * @brief Tests whether the connection can be reused after the response
+ */
+bool HttpRequest::IsReusable() const {
+    // Next response can't be found without knowing where this one ends
+    if (!IsResponseDone() || mResponse.status == EHttpStatus_SwitchProto) {
         return false;
     }
 
-    // Other lines contain key/value pairs
-    for (u32 i = 1; i < lines.Size(); i++) {
-        // NOTE: Use Find over Split in case the value also contains a colon
-        u32 pos = lines[i].Find(": ");
-        u32 after = pos + sizeof(": ") - 1;
+    // Server may not want to keep the connection
+    return !mParser.IsConnectionClose();
+}
 
-        // Malformed line (or part of \r\n\r\n ending)
-        if (pos == String::npos) {
-            // If this isn't one of the trailing newlines, we have a problem
-            if (lines[i] != "\r\n") {
-                mResponse.error = EHttpErr_BadResponse;
-                mResponse.exError = LibSO::GetLastError();
-                return false;
-            }
+/**
+ * @brief Async socket operation callback
+ *
+ * @param result Socket operation result
+ * @param pArg Callback user argument
+ */
+void HttpRequest::AsyncCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
 
-            continue;
-        }
+    // User argument is this object
+    HttpRequest* p = static_cast<HttpRequest*>(pArg);
+    p->CalcAsync(result);
+}
 
-        // Create key/value pair
-        String key = lines[i].SubStr(0, pos);
-        String value = lines[i].SubStr(after);
-        mResponse.header.Insert(key, value);
+/**
+ * @brief Body stream callback
+ *
+ * @param pData Body data
+ * @param size Data size
+ * @param pArg Callback user argument
+ */
+void HttpRequest::BodyStreamFunc(const void* pData, u32 size, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is this object
+    HttpRequest* p = static_cast<HttpRequest*>(pArg);
+    p->WriteBodyStream(static_cast<const u8*>(pData), size);
+}
+
+/**
+ * @brief Writes response body data to the body stream
+ *
+ * @param pData Body data
+ * @param size Data size
+ */
+void HttpRequest::WriteBodyStream(const u8* pData, u32 size) {
+    K_ASSERT(mpBodyStream != nullptr);
+    K_ASSERT(pData != nullptr);
+
+    // Rest of the body is discarded after a failure
+    if (mIsStreamError) {
+        return;
     }
 
-    /******************************************************************************
-     * Receive response body
-     ******************************************************************************/
-    // If we were given the length, we can be 100% sure
-    Optional<u32> len;
-    if (mResponse.header.Contains("Content-Length")) {
-        len = std::strtoul(*mResponse.header.Find("Content-Length"), nullptr, 0);
+    // Data can go straight to the stream if it has no requirements (and
+    // nothing is staged ahead of it)
+    if (mStreamOffset == 0 && mpBodyStream->IsSizeAlign(size) &&
+        mpBodyStream->IsBufferAlign(pData)) {
+        s32 written = mpBodyStream->Write(pData, size);
+        mIsStreamError = written != static_cast<s32>(size);
+        return;
     }
 
-    // We may have read some of the body earlier
-    if (end != work.Length()) {
-        mResponse.body = work.SubStr(end);
+    if (mpStreamBuffer == nullptr) {
+        mStreamBufferSize =
+            ROUND_UP(STREAM_BUFFER_SIZE, mpBodyStream->GetSizeAlign());
+
+        mpStreamBuffer = new (Max<s32>(mpBodyStream->GetBufferAlign(), 4))
+            u8[mStreamBufferSize];
+        K_ASSERT(mpStreamBuffer != nullptr);
     }
 
-    // Receive the rest of the body
-    while (true) {
-        Optional<u32> nrecv =
-            mpSocket->RecvBytes(buffer.Contents(), buffer.AlignedSize() - 1);
+    while (size > 0) {
+        u32 n = Min(size, mStreamBufferSize - mStreamOffset);
+        std::memcpy(mpStreamBuffer + mStreamOffset, pData, n);
 
-        // Record socket library error if it failed
-        if (!nrecv) {
-            mResponse.error = EHttpErr_Socket;
-            mResponse.exError = LibSO::GetLastError();
-            return false;
+        mStreamOffset += n;
+        pData += n;
+        size -= n;
+
+        // Only whole buffers are written until the body is complete
+        if (mStreamOffset < mStreamBufferSize) {
+            break;
         }
 
-        // Server is likely done and has terminated the connection
-        if (*nrecv == 0 && LibSO::GetLastError() != SO_EWOULDBLOCK) {
-            // This is only okay if we've read enough of the body
-            if (!len || mResponse.body.Length() >= *len) {
-                break;
-            }
+        s32 written = mpBodyStream->Write(mpStreamBuffer, mStreamBufferSize);
+        mIsStreamError = written != static_cast<s32>(mStreamBufferSize);
 
-            mResponse.error = EHttpErr_Closed;
-            mResponse.exError = LibSO::GetLastError();
-            return false;
+        mStreamOffset = 0;
+
+        if (mIsStreamError) {
+            break;
         }
+    }
+}
 
-        // Continue building string
-        buffer.Contents()[*nrecv] = '\0';
-        mResponse.body += reinterpret_cast<char*>(buffer.Contents());
+/**
+ * @brief Writes any staged body data to the body stream
+ *
+ * @return Success
+ */
+bool HttpRequest::FlushBodyStream() {
+    if (mpBodyStream == nullptr) {
+        return true;
+    }
 
-        // Timeout may be the only way to end the body, so not a failure
-        if (w.Elapsed() >= mTimeOut) {
+    if (!mIsStreamError && mStreamOffset > 0) {
+        // Final block is padded to the stream's size alignment
+        u32 size = ROUND_UP(mStreamOffset, mpBodyStream->GetSizeAlign());
+        std::memset(mpStreamBuffer + mStreamOffset, 0, size - mStreamOffset);
+
+        s32 written = mpBodyStream->Write(mpStreamBuffer, size);
+        mIsStreamError = written != static_cast<s32>(size);
+    }
+
+    mStreamOffset = 0;
+
+    delete[] mpStreamBuffer;
+    mpStreamBuffer = nullptr;
+
+    return !mIsStreamError;
+}
+
+/**
+ * @brief Advances the async request state machine
+ *
+ * @param result Socket operation result
+ */
+void HttpRequest::CalcAsync(s32 result) {
+    // Time-out is measured from the last operation
+    mActiveTick = OSGetTick();
+
+    switch (mState) {
+    case EState_Connecting:
+        // Connection to the server failed
+        if (result != SO_SUCCESS && result != SO_EISCONN) {
+            FinishAsync(EHttpErr_CantConnect, result);
             break;
         }
-    };
 
-    mResponse.error = EHttpErr_Success;
-    mResponse.exError = LibSO::GetLastError();
-    return true;
+        mState = EState_Requesting;
+        PostSend();
+        break;
+
+    case EState_Requesting:
+        // Nothing could be sent
+        if (result <= 0) {
+            FinishAsync(EHttpErr_Socket, result);
+            break;
+        }
+
+        // Partial sends are continued
+        mAsyncOffset += result;
+        if (mAsyncOffset < mAsyncSize) {
+            PostSend();
+            break;
+        }
+
+        mState = EState_Receiving;
+        PostRecv();
+        break;
+
+    case EState_Receiving:
+        CalcReceive(result);
+        break;
+
+    default:
+        K_ASSERT_EX(false, "Unexpected async state: %d", mState);
+        break;
+    }
+}
+
+/**
+ * @brief Handles received response data (async)
+ *
+ * @param result Number of bytes received, or IOS error code
+ */
+void HttpRequest::CalcReceive(s32 result) {
+    if (result < 0) {
+        FinishAsync(EHttpErr_Socket, result);
+        return;
+    }
+
+    // Server has terminated the connection
+    if (result == 0) {
+        // This is only okay if we've read enough of the body
+        FinishAsync(mParser.Close() ? EHttpErr_Success : EHttpErr_Closed,
+                    SO_SUCCESS);
+        return;
+    }
+
+    // Response is parsed as it arrives
+    u32 used = 0;
+    if (!Consume(mpAsyncBuffer, result, used)) {
+        FinishAsync(EHttpErr_BadResponse, SO_SUCCESS);
+        return;
+    }
+
+    // Whole body has arrived
+    if (IsResponseDone()) {
+        KeepUpgradeData(mpAsyncBuffer + used, result - used);
+        FinishAsync(EHttpErr_Success, SO_SUCCESS);
+        return;
+    }
+
+    PostRecv();
+}
+
+/**
+ * @brief Sends the rest of the request data (async)
+ */
+void HttpRequest::PostSend() {
+    K_ASSERT(mpAsyncBuffer != nullptr);
+    K_ASSERT(mAsyncOffset < mAsyncSize);
+
+    LibSO::SendAsync(mpSocket->GetHandle(), mpAsyncBuffer + mAsyncOffset,
+                     mAsyncSize - mAsyncOffset, 0, nullptr, AsyncCallbackFunc,
+                     this);
+}
+
+/**
+ * @brief Receives more response data (async)
+ */
+void HttpRequest::PostRecv() {
+    K_ASSERT(mpAsyncBuffer != nullptr);
+
+    LibSO::RecvAsync(mpSocket->GetHandle(), mpAsyncBuffer, mAsyncBufferSize, 0,
+                     nullptr, AsyncCallbackFunc, this);
+}
+
+/**
+ * @brief Completes the async request
+ *
+ * @param error Error code
+ * @param exError Internal error code
+ */
+void HttpRequest::FinishAsync(EHttpErr error, s32 exError) {
+    mState = EState_Idle;
+
+    delete[] mpAsyncBuffer;
+    mpAsyncBuffer = nullptr;
+    mpConnection = nullptr;
+
+    // Requests over their own sockets are watched by the pool
+    if (!mIsKeepAlive) {
+        HttpConnectionPool::GetInstance().Unwatch(this);
+
+        // Operation was aborted by shutting down the socket
+        if (mIsTimedOut && error != EHttpErr_Success) {
+            error = EHttpErr_TimedOut;
+        }
+    }
+
+    // Staged body data must reach the stream before the response is used
+    if (error == EHttpErr_Success && !FlushBodyStream()) {
+        error = EHttpErr_Stream;
+    }
+
+    mResponse.error = error;
+    mResponse.exError = exError;
+
+    Callback pCallback = mpCallback;
+    void* pCallbackArg = mpCallbackArg;
+
+    // Signal to destructor
+    mpCallback = nullptr;
+    mpCallbackArg = nullptr;
+
+    // Callback may destroy this request
+    pCallback(mResponse, pCallbackArg);
 }
 
 } // namespace kiwi
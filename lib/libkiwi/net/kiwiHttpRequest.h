@@ -1,16 +1,23 @@
 #ifndef LIBKIWI_NET_HTTP_REQUEST_H
 #define LIBKIWI_NET_HTTP_REQUEST_H
 #include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiHttpResponseParser.h>
 #include <libkiwi/prim/kiwiHashMap.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
 #include <libkiwi/prim/kiwiOptional.h>
 #include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/prim/kiwiVector.h>
+#include <libkiwi/support/kiwiLibSO.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_net
 //! @{
 
 // Forward declarations
+class IStream;
 class SyncSocket;
+struct HttpConnection;
+struct SockSegment;
 
 /**
  * @brief HTTP error
@@ -23,6 +30,7 @@ enum EHttpErr {
     EHttpErr_Closed,      // Connection closed
     EHttpErr_Socket,      // Misc. socket error
     EHttpErr_Usage,       // Invalid usage
+    EHttpErr_Stream,      // Body stream write failed
 };
 
 /**
@@ -36,9 +44,13 @@ enum EHttpStatus {
     EHttpStatus_SwitchProto = 101, // Switching Protocols
 
     // Successful
-    EHttpStatus_OK = 200, // OK
-    EHttpStatus_Created,  // Created
-    EHttpStatus_Accepted, // Accepted
+    EHttpStatus_OK = 200,        // OK
+    EHttpStatus_Created,         // Created
+    EHttpStatus_Accepted,        // Accepted
+    EHttpStatus_NoContent = 204, // No Content
+
+    // Redirection
+    EHttpStatus_NotModified = 304, // Not Modified
 
     // Client error
     EHttpStatus_BadReq = 400, // Bad Request
@@ -76,6 +88,9 @@ struct HttpResponse {
  * @brief HTTP (1.1) request wrapper
  */
 class HttpRequest {
+    friend class HttpConnectionPool;
+    friend struct HttpConnection;
+
 public:
     /**
      * @brief Request method
@@ -96,6 +111,9 @@ public:
      */
     typedef void (*Callback)(const HttpResponse& rResp, void* pArg);
 
+    //! Response body callback
+    typedef HttpResponseParser::BodyCallback BodyCallback;
+
 public:
     /**
      * @brief Constructor
@@ -128,6 +146,13 @@ public:
 
     /**
      * @brief Sends request asynchronously
+     * @details Socket operations are completed by IOS, so no thread is
+     * blocked while waiting for the server
+     * @note The hostname is resolved on the calling thread before this
+     * returns. If that fails, the callback is invoked right away.
+     * @note The callback is invoked from the IOS dispatcher thread
+     * @note If the server stops responding for longer than the time-out, the
+     * socket is shut down and the request fails with EHttpErr_TimedOut
      *
      * @param pCallback Response callback
      * @param pArg Callback user argument
@@ -136,6 +161,49 @@ public:
     void SendAsync(Callback pCallback, void* pArg = nullptr,
                    EMethod method = EMethod_GET);
 
+    /**
+     * @brief Toggles persistent connections (HTTP keep-alive)
+     * @details Requests to the same server share connections from the
+     * HttpConnectionPool, and asynchronous GET requests may be pipelined.
+     * @note Only requests created with a hostname can use the pool
+     *
+     * @param enable Whether to keep the connection alive
+     */
+    void SetKeepAlive(bool enable);
+
+    /**
+     * @brief Passes the response body to a callback instead of storing it
+     * @details The body is decoded (de-chunked) before it is passed on, and
+     * HttpResponse::body is left empty.
+     * @note For async requests, the callback is invoked from the IOS
+     * dispatcher thread
+     *
+     * @param pCallback Body callback (nullptr to store the body again)
+     * @param pArg Callback user argument
+     */
+    void SetBodyCallback(BodyCallback pCallback, void* pArg = nullptr);
+    /**
+     * @brief Writes the response body to a stream instead of storing it
+     * @details Data is staged in an aligned buffer if the stream requires
+     * it, so streams like NAND files can be written directly. The final
+     * block is padded with zeroes up to the stream's size alignment.
+     * @note The stream must outlive the request
+     *
+     * @param pStream Output stream (nullptr to store the body again)
+     */
+    void SetBodyStream(IStream* pStream);
+    /**
+     * @brief Sets the size limit for bodies stored in the response
+     * @details Larger responses fail with EHttpErr_BadResponse. Bodies
+     * passed to a callback or stream aren't limited.
+     *
+     * @param size Maximum body size
+     */
+    void SetMaxBodySize(u32 size) {
+        K_ASSERT_EX(!mIsSent, "Please set this before sending the request.");
+        mParser.SetMaxBodySize(size);
+    }
+
     /**
      * @brief Sets the maximum state duration before timeout
      *
@@ -196,6 +264,32 @@ public:
         mResource = rURI;
     }
 
+    /**
+     * @brief Gets data which the server sent after switching protocols
+     * @details Data following a 'Switching Protocols' response belongs to
+     * the new protocol, and is kept until the request is destroyed.
+     */
+    const u8* GetUpgradeData() const {
+        return mpUpgradeData;
+    }
+    /**
+     * @brief Gets the size of the data sent after switching protocols
+     */
+    u32 GetUpgradeDataSize() const {
+        return mUpgradeDataSize;
+    }
+
+private:
+    /**
+     * @brief Async request state
+     */
+    enum EState {
+        EState_Idle,
+        EState_Connecting,
+        EState_Requesting,
+        EState_Receiving,
+    };
+
 private:
     /**
      * @brief Performs common initialization
@@ -207,6 +301,37 @@ private:
      */
     void SendImpl();
 
+    /**
+     * @brief Resolves the server address (once)
+     *
+     * @return Success
+     */
+    bool Resolve();
+
+    /**
+     * @brief Prepares a connection to the server (sync)
+     *
+     * @return Whether an existing connection was reused
+     */
+    bool AcquireSocket();
+    /**
+     * @brief Gives up the connection to the server (sync)
+     *
+     * @param reuse Whether the connection can be used again
+     */
+    void ReleaseSocket(bool reuse);
+    /**
+     * @brief Opens a request-owned socket
+     */
+    void OpenSocket();
+
+    /**
+     * @brief Connects to the server and exchanges the request/response
+     *
+     * @return Success
+     */
+    bool Exchange();
+
     /**
      * @brief Sends request data
      *
@@ -220,6 +345,129 @@ private:
      */
     bool Receive();
 
+    /**
+     * @brief Lists the pieces of the request message
+     * @details Segments point into the request's own strings, so the message
+     * isn't formatted into one buffer
+     *
+     * @param[out] rSegments Request line, header field, and end segments
+     * @return Request message size
+     */
+    u32 BuildRequest(TVector<SockSegment>& rSegments) const;
+
+    /**
+     * @brief Discards any response data received so far
+     */
+    void ResetResponse();
+    /**
+     * @brief Handles received response data
+     * @details Data following the end of the response is not used, as it
+     * belongs to the next response on a pipelined connection.
+     *
+     * @param pData Received data
+     * @param size Data size
+     * @param[out] rUsed Number of bytes belonging to this response
+     * @return Success (false if the response is malformed)
+     */
+    bool Consume(const u8* pData, u32 size, u32& rUsed);
+    /**
+     * @brief Keeps data which followed a 'Switching Protocols' response
+     *
+     * @param pData Data following the response
+     * @param size Data size
+     */
+    void KeepUpgradeData(const u8* pData, u32 size);
+
+    /**
+     * @brief Tests whether any response data has been received
+     */
+    bool HasResponseData() const {
+        return mParser.HasData();
+    }
+    /**
+     * @brief Tests whether the whole response has been received
+     */
+    bool IsResponseDone() const {
+        return mParser.IsDone();
+    }
+    /**
+     * @brief Tests whether the response is complete if the server closes
+     * the connection now
+     */
+    bool IsCompleteAtClose() const {
+        return mParser.IsDone() || mParser.IsCloseDelimited();
+    }
+    /**
+     * @brief Tests whether the connection can be reused after the response
+     */
+    bool IsReusable() const;
+    /**
+     * @brief Tests whether the request can safely be sent more than once
+     */
+    bool IsIdempotent() const {
+        return mMethod == EMethod_GET;
+    }
+
+    /**
+     * @brief Async socket operation callback
+     *
+     * @param result Socket operation result
+     * @param pArg Callback user argument
+     */
+    static void AsyncCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Body stream callback
+     *
+     * @param pData Body data
+     * @param size Data size
+     * @param pArg Callback user argument
+     */
+    static void BodyStreamFunc(const void* pData, u32 size, void* pArg);
+    /**
+     * @brief Writes response body data to the body stream
+     *
+     * @param pData Body data
+     * @param size Data size
+     */
+    void WriteBodyStream(const u8* pData, u32 size);
+    /**
+     * @brief Writes any staged body data to the body stream
+     *
+     * @return Success
+     */
+    bool FlushBodyStream();
+
+    /**
+     * @brief Advances the async request state machine
+     *
+     * @param result Socket operation result
+     */
+    void CalcAsync(s32 result);
+    /**
+     * @brief Handles received response data (async)
+     *
+     * @param result Number of bytes received, or IOS error code
+     */
+    void CalcReceive(s32 result);
+
+    /**
+     * @brief Sends the rest of the request data (async)
+     */
+    void PostSend();
+    /**
+     * @brief Receives more response data (async)
+     */
+    void PostRecv();
+
+    /**
+     * @brief Completes the async request
+     *
+     * @param error Error code
+     * @param exError Internal error code
+     */
+    void FinishAsync(EHttpErr error, s32 exError);
+
 private:
     //! Default port for HTTP connections
     static const u16 DEFAULT_PORT = 80;
@@ -227,6 +475,8 @@ private:
     static const u32 DEFAULT_TIMEOUT = 10000;
     //! Size of temporary buffer when receiving a response
     static const int TEMP_BUFFER_SIZE = 512;
+    //! Size of staging buffer when streaming the response body
+    static const u32 STREAM_BUFFER_SIZE = 4096;
 
     //! HTTP request method names
     static const String METHOD_NAMES[EMethod_Max];
@@ -234,24 +484,49 @@ private:
     static const String PROTOCOL_VERSION;
 
 private:
-    bool mIsSent; //!< Whether this request object has been used
+    bool mIsSent;      //!< Whether this request object has been used
+    bool mIsKeepAlive; //!< Whether to use a pooled connection
+    bool mIsRetried;   //!< Whether the request has been sent again
+    bool mIsResolved;  //!< Whether the server address is known
 
-    String mHost; //!< Server host name
-    u16 mPort;    //!< Server port
+    String mHost;    //!< Server host name
+    u16 mPort;       //!< Server port
+    SockAddr4 mAddr; //!< Server address (once resolved)
 
     EMethod mMethod;        //!< Request method
     String mResource;       //!< Requested resource
     HttpResponse mResponse; //!< Server response
     u32 mTimeOut;           //!< Connection timeout
 
-    SocketBase* mpSocket; //!< Connection to server
-    bool mIsUserSocket;   //!< Whether the socket is owned by the user
+    SocketBase* mpSocket;         //!< Connection to server
+    bool mIsUserSocket;           //!< Whether the socket is owned by the user
+    HttpConnection* mpConnection; //!< Pooled connection to server
+    IntrusiveListNode mPoolNode;  //!< Node in the connection pool queues
 
     TMap<String, String> mParams; //!< URL parameters
     TMap<String, String> mHeader; //!< Header fields
 
     Callback mpCallback; //!< Response callback
     void* mpCallbackArg; //!< Callback user argument
+
+    EState mState;        //!< Async request state
+    u8* mpAsyncBuffer;    //!< Async I/O buffer (MEM2)
+    u32 mAsyncBufferSize; //!< Async I/O buffer size
+    u32 mAsyncOffset;     //!< Request data sent so far
+    u32 mAsyncSize;       //!< Request data size
+    u32 mActiveTick;      //!< Time of the last async progress
+    bool mIsTimedOut;     //!< Whether the async request has timed out
+
+    HttpResponseParser mParser; //!< Response parser
+
+    IStream* mpBodyStream; //!< Response body stream
+    u8* mpStreamBuffer;    //!< Body stream staging buffer
+    u32 mStreamBufferSize; //!< Body stream staging buffer size
+    u32 mStreamOffset;     //!< Body data staged so far
+    bool mIsStreamError;   //!< Whether a body stream write failed
+
+    u8* mpUpgradeData;    //!< Data sent after switching protocols
+    u32 mUpgradeDataSize; //!< Size of data sent after switching protocols
 };
 
 //! @}
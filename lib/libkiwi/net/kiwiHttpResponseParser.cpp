@@ -0,0 +1,493 @@
+#include <libkiwi.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace kiwi {
+namespace {
+
+/**
+ * @brief Compares two strings, ignoring case
+ *
+ * @param rLhs First string
+ * @param rRhs Second string
+ */
+bool EqualsNoCase(const StringView& rLhs, const StringView& rRhs) {
+    if (rLhs.Length() != rRhs.Length()) {
+        return false;
+    }
+
+    for (u32 i = 0; i < rLhs.Length(); i++) {
+        if (std::tolower(rLhs[i]) != std::tolower(rRhs[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Removes leading and trailing whitespace
+ *
+ * @param rStr String to trim
+ */
+StringView Trim(const StringView& rStr) {
+    u32 begin = 0;
+    u32 end = rStr.Length();
+
+    while (begin < end && (rStr[begin] == ' ' || rStr[begin] == '\t')) {
+        begin++;
+    }
+
+    while (end > begin && (rStr[end - 1] == ' ' || rStr[end - 1] == '\t')) {
+        end--;
+    }
+
+    return rStr.SubStr(begin, end - begin);
+}
+
+/**
+ * @brief Parses a decimal field value
+ * @details Unlike strtoul, anything other than digits is rejected, as is a
+ * value which doesn't fit
+ *
+ * @param rStr Field value
+ * @param[out] rValue Parsed value
+ * @return Success
+ */
+bool ParseDecimal(const StringView& rStr, u32& rValue) {
+    if (rStr.Empty()) {
+        return false;
+    }
+
+    u32 value = 0;
+    for (u32 i = 0; i < rStr.Length(); i++) {
+        if (rStr[i] < '0' || rStr[i] > '9') {
+            return false;
+        }
+
+        u32 digit = rStr[i] - '0';
+
+        // Value is larger than anything we could hold
+        if (value > (0xFFFFFFFF - digit) / 10) {
+            return false;
+        }
+
+        value = value * 10 + digit;
+    }
+
+    rValue = value;
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor
+ *
+ * @param rResponse Response to fill in
+ */
+HttpResponseParser::HttpResponseParser(HttpResponse& rResponse)
+    : mrResponse(rResponse),
+      mMaxBodySize(DEFAULT_MAX_BODY_SIZE),
+      mpBodyCallback(nullptr),
+      mpBodyCallbackArg(nullptr) {
+
+    Reset();
+}
+
+/**
+ * @brief Prepares to parse a new response
+ * @note The body callback and size limit are kept
+ */
+void HttpResponseParser::Reset() {
+    mState = EState_StatusLine;
+    mLine.Clear();
+
+    mContentLength.Reset();
+    mIsChunked = false;
+    mIsConnectionClose = false;
+    mBodySize = 0;
+    mChunkRemain = 0;
+}
+
+/**
+ * @brief Parses received response data
+ * @details Data following the end of the response is not used, as it
+ * belongs to the next response on a pipelined connection.
+ *
+ * @param pData Received data
+ * @param size Data size
+ * @param[out] rUsed Number of bytes belonging to this response
+ * @return Success (false if the response is malformed)
+ */
+bool HttpResponseParser::Parse(const void* pData, u32 size, u32& rUsed) {
+    K_ASSERT(pData != nullptr || size == 0);
+
+    const char* pChars = static_cast<const char*>(pData);
+    rUsed = 0;
+
+    while (rUsed < size && mState != EState_Done && mState != EState_Error) {
+        const char* pNext = pChars + rUsed;
+        u32 avail = size - rUsed;
+
+        switch (mState) {
+        case EState_StatusLine:
+        case EState_Header:
+        case EState_ChunkSize:
+        case EState_ChunkDataEnd:
+        case EState_Trailer: {
+            u32 used = 0;
+            bool complete = ReadLine(pNext, avail, used);
+            rUsed += used;
+
+            if (!complete) {
+                break;
+            }
+
+            if (!HandleLine(mLine)) {
+                mState = EState_Error;
+            }
+
+            mLine.Clear();
+            break;
+        }
+
+        case EState_Body:
+        case EState_ChunkData: {
+            u32 n = Min(avail, mChunkRemain);
+            if (!EmitBody(pNext, n)) {
+                mState = EState_Error;
+                break;
+            }
+
+            rUsed += n;
+
+            mChunkRemain -= n;
+            if (mChunkRemain > 0) {
+                break;
+            }
+
+            // Chunk data is followed by a line break
+            mState = mState == EState_Body ? EState_Done : EState_ChunkDataEnd;
+            break;
+        }
+
+        case EState_BodyUntilClose: {
+            if (!EmitBody(pNext, avail)) {
+                mState = EState_Error;
+                break;
+            }
+
+            rUsed += avail;
+            break;
+        }
+
+        default: {
+            K_ASSERT_EX(false, "Unexpected parser state: %d", mState);
+            break;
+        }
+        }
+    }
+
+    return mState != EState_Error;
+}
+
+/**
+ * @brief Handles the server closing the connection
+ *
+ * @return Whether the response is complete
+ */
+bool HttpResponseParser::Close() {
+    if (mState == EState_BodyUntilClose) {
+        mState = EState_Done;
+    }
+
+    return mState == EState_Done;
+}
+
+/**
+ * @brief Reads data into the current line
+ *
+ * @param pData Received data
+ * @param size Data size
+ * @param[out] rUsed Number of bytes read
+ * @return Whether the line is complete
+ */
+bool HttpResponseParser::ReadLine(const char* pData, u32 size, u32& rUsed) {
+    K_ASSERT(pData != nullptr);
+
+    // Only the new data needs to be searched
+    const char* pEnd = static_cast<const char*>(std::memchr(pData, '\n', size));
+
+    u32 len = pEnd != nullptr ? pEnd - pData : size;
+    rUsed = pEnd != nullptr ? len + 1 : len;
+
+    // Lines should end with CRLF, but a bare LF is tolerated
+    bool isCR = pEnd != nullptr && len > 0 && pData[len - 1] == '\r';
+    if (isCR) {
+        len--;
+    }
+
+    if (mLine.Length() + len > scMaxLineLength) {
+        mState = EState_Error;
+        return false;
+    }
+
+    mLine += StringView(pData, len);
+
+    if (pEnd == nullptr) {
+        return false;
+    }
+
+    // CR may have arrived at the end of the previous data
+    if (!isCR && !mLine.Empty() && mLine[mLine.Length() - 1] == '\r') {
+        mLine = mLine.SubStr(0, mLine.Length() - 1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Handles a complete line
+ *
+ * @param rLine Line contents (without the line break)
+ * @return Success
+ */
+bool HttpResponseParser::HandleLine(const StringView& rLine) {
+    switch (mState) {
+    case EState_StatusLine: {
+        if (!ParseStatusLine(rLine)) {
+            return false;
+        }
+
+        mState = EState_Header;
+        return true;
+    }
+
+    case EState_Header: {
+        // Header ends with an empty line
+        if (rLine.Empty()) {
+            return BeginBody();
+        }
+
+        return ParseField(rLine);
+    }
+
+    case EState_ChunkSize: {
+        return ParseChunkSize(rLine);
+    }
+
+    case EState_ChunkDataEnd: {
+        // Nothing else may follow the chunk data
+        if (!rLine.Empty()) {
+            return false;
+        }
+
+        mState = EState_ChunkSize;
+        return true;
+    }
+
+    case EState_Trailer: {
+        // Trailer ends with an empty line
+        if (rLine.Empty()) {
+            mState = EState_Done;
+            return true;
+        }
+
+        return ParseField(rLine);
+    }
+
+    default: {
+        K_ASSERT_EX(false, "Unexpected parser state: %d", mState);
+        return false;
+    }
+    }
+}
+
+/**
+ * @brief Parses the status line
+ *
+ * @param rLine Line contents
+ * @return Success
+ */
+bool HttpResponseParser::ParseStatusLine(const StringView& rLine) {
+    // Minor version doesn't change the message syntax
+    if (!rLine.StartsWith("HTTP/1.")) {
+        return false;
+    }
+
+    int status = 0;
+    int num = std::sscanf(String(rLine), "HTTP/1.%*d %d", &status);
+    if (num != 1) {
+        return false;
+    }
+
+    mrResponse.status = static_cast<EHttpStatus>(status);
+    return true;
+}
+
+/**
+ * @brief Parses a header/trailer field
+ *
+ * @param rLine Line contents
+ * @return Success
+ */
+bool HttpResponseParser::ParseField(const StringView& rLine) {
+    // NOTE: Use Find over Split in case the value also contains a colon
+    u32 pos = rLine.Find(':');
+    if (pos == StringView::npos) {
+        return false;
+    }
+
+    StringView name = rLine.SubStr(0, pos);
+    StringView value = Trim(rLine.SubStr(pos + 1));
+
+    // Fields which change how the message is framed
+    if (EqualsNoCase(name, "Content-Length")) {
+        u32 length = 0;
+        if (!ParseDecimal(value, length)) {
+            return false;
+        }
+
+        // Conflicting lengths leave the body boundary ambiguous
+        if (mContentLength && *mContentLength != length) {
+            return false;
+        }
+
+        mContentLength = length;
+    } else if (EqualsNoCase(name, "Transfer-Encoding")) {
+        // Chunked must be the final coding if it is present
+        const StringView chunked = "chunked";
+        mIsChunked =
+            value.Length() >= chunked.Length() &&
+            EqualsNoCase(value.SubStr(value.Length() - chunked.Length()),
+                         chunked);
+    } else if (EqualsNoCase(name, "Connection")) {
+        mIsConnectionClose = EqualsNoCase(value, "close");
+    }
+
+    mrResponse.header.Insert(String(name), String(value));
+    return true;
+}
+
+/**
+ * @brief Parses a chunk size line
+ *
+ * @param rLine Line contents
+ * @return Success
+ */
+bool HttpResponseParser::ParseChunkSize(const StringView& rLine) {
+    // Chunk extensions are ignored
+    u32 end = rLine.Find(';');
+    StringView digits = Trim(rLine.SubStr(0, end));
+
+    if (digits.Empty()) {
+        return false;
+    }
+
+    u32 size = 0;
+    for (u32 i = 0; i < digits.Length(); i++) {
+        if (!std::isxdigit(digits[i])) {
+            return false;
+        }
+
+        // Chunk is larger than anything we could hold
+        if (size > (0xFFFFFFFF >> 4)) {
+            return false;
+        }
+
+        char c = std::tolower(digits[i]);
+        size = size * 16 + (c >= 'a' ? c - 'a' + 10 : c - '0');
+    }
+
+    // Last chunk is followed by the trailer
+    if (size == 0) {
+        mState = EState_Trailer;
+        return true;
+    }
+
+    // Don't wait for the data to reject a chunk we can't store
+    if (mpBodyCallback == nullptr && size > mMaxBodySize - mBodySize) {
+        return false;
+    }
+
+    mChunkRemain = size;
+    mState = EState_ChunkData;
+    return true;
+}
+
+/**
+ * @brief Chooses how the body is framed once the header is complete
+ *
+ * @return Success
+ */
+bool HttpResponseParser::BeginBody() {
+    // Connection now belongs to the new protocol, or there is no body
+    if (mrResponse.status == EHttpStatus_SwitchProto ||
+        mrResponse.status == EHttpStatus_NoContent ||
+        mrResponse.status == EHttpStatus_NotModified) {
+        mState = EState_Done;
+        return true;
+    }
+
+    // Chunked transfer coding overrides the length
+    if (mIsChunked) {
+        mContentLength.Reset();
+        mState = EState_ChunkSize;
+        return true;
+    }
+
+    if (mContentLength) {
+        mChunkRemain = *mContentLength;
+        mState = mChunkRemain > 0 ? EState_Body : EState_Done;
+
+        if (mpBodyCallback == nullptr) {
+            // Don't wait for the data to reject a body we can't store
+            if (mChunkRemain > mMaxBodySize) {
+                return false;
+            }
+
+            // Avoid growing the body string as data arrives
+            mrResponse.body.Reserve(mChunkRemain);
+        }
+
+        return true;
+    }
+
+    mState = EState_BodyUntilClose;
+    return true;
+}
+
+/**
+ * @brief Passes decoded body data to the body sink
+ *
+ * @param pData Body data
+ * @param size Data size
+ * @return Success (false if the stored body would be too large)
+ */
+bool HttpResponseParser::EmitBody(const char* pData, u32 size) {
+    K_ASSERT(pData != nullptr);
+
+    if (size == 0) {
+        return true;
+    }
+
+    if (mpBodyCallback != nullptr) {
+        mBodySize += size;
+        mpBodyCallback(pData, size, mpBodyCallbackArg);
+        return true;
+    }
+
+    // Chunked and close-delimited bodies have no size up front
+    if (size > mMaxBodySize - mBodySize) {
+        return false;
+    }
+
+    mBodySize += size;
+    mrResponse.body += StringView(pData, size);
+    return true;
+}
+
+} // namespace kiwi
@@ -0,0 +1,238 @@
+#ifndef LIBKIWI_NET_HTTP_RESPONSE_PARSER_H
+#define LIBKIWI_NET_HTTP_RESPONSE_PARSER_H
+#include <libkiwi/k_types.h>
+#include <libkiwi/prim/kiwiOptional.h>
+#include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+#include <revolution/OS.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_net
+//! @{
+
+// Forward declarations
+struct HttpResponse;
+
+/**
+ * @brief Resumable HTTP (1.1) response parser
+ * @details Data can be fed in pieces of any size as it arrives from the
+ * socket. Only the new bytes are scanned, and only the current header line is
+ * buffered. The body is framed by Content-Length, chunked transfer coding, or
+ * the end of the connection, and is either appended to the response or passed
+ * to a callback as it is decoded.
+ *
+ * Bodies which are stored in the response are limited in size (see
+ * SetMaxBodySize), so a broken or hostile server can't exhaust the heap.
+ */
+class HttpResponseParser : private NonCopyable {
+public:
+    //! Default size limit for bodies stored in the response
+    static const u32 DEFAULT_MAX_BODY_SIZE = OS_MEM_MB_TO_B(1);
+
+    /**
+     * @brief Response body callback
+     *
+     * @param pData Body data
+     * @param size Data size
+     * @param pArg Callback user argument
+     */
+    typedef void (*BodyCallback)(const void* pData, u32 size, void* pArg);
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rResponse Response to fill in
+     */
+    explicit HttpResponseParser(HttpResponse& rResponse);
+
+    /**
+     * @brief Prepares to parse a new response
+     * @note The body callback and size limit are kept
+     */
+    void Reset();
+
+    /**
+     * @brief Sets the response body callback
+     * @details Without a callback, the body is appended to the response
+     *
+     * @param pCallback Body callback
+     * @param pArg Callback user argument
+     */
+    void SetBodyCallback(BodyCallback pCallback, void* pArg = nullptr) {
+        mpBodyCallback = pCallback;
+        mpBodyCallbackArg = pArg;
+    }
+
+    /**
+     * @brief Sets the size limit for bodies stored in the response
+     * @details Responses which are (or announce that they will be) larger
+     * are rejected as malformed. Bodies passed to a callback aren't stored,
+     * so they aren't limited.
+     *
+     * @param size Maximum body size
+     */
+    void SetMaxBodySize(u32 size) {
+        mMaxBodySize = size;
+    }
+
+    /**
+     * @brief Parses received response data
+     * @details Data following the end of the response is not used, as it
+     * belongs to the next response on a pipelined connection.
+     *
+     * @param pData Received data
+     * @param size Data size
+     * @param[out] rUsed Number of bytes belonging to this response
+     * @return Success (false if the response is malformed)
+     */
+    bool Parse(const void* pData, u32 size, u32& rUsed);
+
+    /**
+     * @brief Handles the server closing the connection
+     *
+     * @return Whether the response is complete
+     */
+    bool Close();
+
+    /**
+     * @brief Tests whether any response data has been parsed
+     */
+    bool HasData() const {
+        return mState != EState_StatusLine || !mLine.Empty();
+    }
+    /**
+     * @brief Tests whether the status line and header fields are complete
+     */
+    bool IsHeaderDone() const {
+        return mState > EState_Header;
+    }
+    /**
+     * @brief Tests whether the response is complete
+     */
+    bool IsDone() const {
+        return mState == EState_Done;
+    }
+    /**
+     * @brief Tests whether the response body only ends with the connection
+     */
+    bool IsCloseDelimited() const {
+        return mState == EState_BodyUntilClose;
+    }
+    /**
+     * @brief Tests whether the server will close the connection after the
+     * response
+     */
+    bool IsConnectionClose() const {
+        return mIsConnectionClose;
+    }
+
+    /**
+     * @brief Gets the expected body size (if it was given)
+     */
+    const Optional<u32>& GetContentLength() const {
+        return mContentLength;
+    }
+    /**
+     * @brief Gets the amount of body data decoded so far
+     */
+    u32 GetBodySize() const {
+        return mBodySize;
+    }
+
+private:
+    /**
+     * @brief Parser state
+     */
+    enum EState {
+        EState_StatusLine,     // Reading the status line
+        EState_Header,         // Reading header fields
+        EState_Body,           // Reading a body of known length
+        EState_BodyUntilClose, // Reading a body which ends with the connection
+        EState_ChunkSize,      // Reading a chunk size line
+        EState_ChunkData,      // Reading chunk data
+        EState_ChunkDataEnd,   // Reading the line break after chunk data
+        EState_Trailer,        // Reading trailer fields
+        EState_Done,           // Response is complete
+        EState_Error,          // Response is malformed
+    };
+
+    //! Longest line which will be buffered
+    static const u32 scMaxLineLength = 8192;
+
+private:
+    /**
+     * @brief Reads data into the current line
+     *
+     * @param pData Received data
+     * @param size Data size
+     * @param[out] rUsed Number of bytes read
+     * @return Whether the line is complete
+     */
+    bool ReadLine(const char* pData, u32 size, u32& rUsed);
+
+    /**
+     * @brief Handles a complete line
+     *
+     * @param rLine Line contents (without the line break)
+     * @return Success
+     */
+    bool HandleLine(const StringView& rLine);
+
+    /**
+     * @brief Parses the status line
+     *
+     * @param rLine Line contents
+     * @return Success
+     */
+    bool ParseStatusLine(const StringView& rLine);
+    /**
+     * @brief Parses a header/trailer field
+     *
+     * @param rLine Line contents
+     * @return Success
+     */
+    bool ParseField(const StringView& rLine);
+    /**
+     * @brief Parses a chunk size line
+     *
+     * @param rLine Line contents
+     * @return Success
+     */
+    bool ParseChunkSize(const StringView& rLine);
+
+    /**
+     * @brief Chooses how the body is framed once the header is complete
+     *
+     * @return Success
+     */
+    bool BeginBody();
+    /**
+     * @brief Passes decoded body data to the body sink
+     *
+     * @param pData Body data
+     * @param size Data size
+     * @return Success (false if the stored body would be too large)
+     */
+    bool EmitBody(const char* pData, u32 size);
+
+private:
+    HttpResponse& mrResponse; // Response to fill in
+    EState mState;            // Parser state
+    String mLine;             // Current (incomplete) line
+
+    Optional<u32> mContentLength; // Expected body size
+    bool mIsChunked;              // Whether the body is chunked
+    bool mIsConnectionClose;      // Whether the server will close after this
+    u32 mBodySize;                // Body data decoded so far
+    u32 mChunkRemain;             // Data left in the current chunk/body
+    u32 mMaxBodySize;             // Size limit for stored bodies
+
+    BodyCallback mpBodyCallback; // Body callback
+    void* mpBodyCallbackArg;     // Body callback user argument
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
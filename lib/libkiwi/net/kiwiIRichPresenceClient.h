@@ -2,6 +2,9 @@
 #define LIBKIWI_NET_I_RICH_PRESENCE_CLIENT_H
 #include <libkiwi/k_types.h>
 #include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/util/kiwiAutoLock.h>
+
+#include <revolution/OS.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_net
@@ -9,14 +12,18 @@ namespace kiwi {
 
 /**
  * @brief Rich presence interface
+ * @details Setters only record changes into a pending copy of the activity.
+ * Changes are committed and sent to the client in one batch by Flush, and
+ * nothing is sent if no field actually changed.
  */
 class IRichPresenceClient {
 public:
     /**
      * @brief Constructor
      */
-    explicit IRichPresenceClient()
-        : mStartTime(0), mEndTime(0), mPartyNum(0), mPartyMax(0) {}
+    explicit IRichPresenceClient() : mDirty(0) {
+        OSInitMutex(&mMutex);
+    }
 
     /**
      * @brief Destructor
@@ -42,19 +49,81 @@ public:
      */
     virtual void UpdateActivity() const = 0;
 
+    /**
+     * @brief Commits pending changes and sends them to the client
+     * @note Not safe to call from interrupt context
+     *
+     * @return Whether anything was sent
+     */
+    bool Flush() {
+        u32 dirty = 0;
+
+        {
+            AutoMutexLock lock(mMutex);
+
+            dirty = mDirty;
+            mDirty = 0;
+
+            // Only changed fields need to be copied
+            if (dirty & EDirty_AppID) {
+                mAppID = mPendingAppID;
+            }
+            if (dirty & EDirty_Details) {
+                mActivity.details = mPending.details;
+            }
+            if (dirty & EDirty_State) {
+                mActivity.state = mPending.state;
+            }
+            if (dirty & EDirty_LargeImage) {
+                mActivity.largeImageKey = mPending.largeImageKey;
+                mActivity.largeImageText = mPending.largeImageText;
+            }
+            if (dirty & EDirty_SmallImage) {
+                mActivity.smallImageKey = mPending.smallImageKey;
+                mActivity.smallImageText = mPending.smallImageText;
+            }
+            if (dirty & EDirty_Time) {
+                mActivity.startTime = mPending.startTime;
+                mActivity.endTime = mPending.endTime;
+            }
+            if (dirty & EDirty_Party) {
+                mActivity.partyNum = mPending.partyNum;
+                mActivity.partyMax = mPending.partyMax;
+            }
+        }
+
+        // Client communication happens outside of the lock
+        if (dirty & EDirty_AppID) {
+            UpdateApp();
+        }
+        if (dirty & EDirty_Activity) {
+            UpdateActivity();
+        }
+
+        return dirty != 0;
+    }
+
+    /**
+     * @brief Tests whether there are changes waiting to be flushed
+     */
+    bool IsDirty() const {
+        return mDirty != 0;
+    }
+
     /**
      * @brief Sets the activity's application ID
      *
      * @param rAppID
      */
     void SetAppID(const String& rAppID) {
-        mAppID = rAppID;
+        SetField(mPendingAppID, rAppID, EDirty_AppID);
     }
     /**
      * @brief Gets the activity's application ID
      */
     String GetAppID() const {
-        return mAppID;
+        AutoMutexLock lock(mMutex);
+        return mPendingAppID;
     }
 
     /**
@@ -63,7 +132,7 @@ public:
      * @param rDetails What the player is currently doing
      */
     void SetDetails(const String& rDetails) {
-        mDetails = rDetails;
+        SetField(mPending.details, rDetails, EDirty_Details);
     }
     /**
      * @brief Sets the activity's state
@@ -71,7 +140,7 @@ public:
      * @param rState The user's current status
      */
     void SetState(const String& rState) {
-        mState = rState;
+        SetField(mPending.state, rState, EDirty_State);
     }
 
     /**
@@ -80,7 +149,7 @@ public:
      * @param rKey Key of the uploaded large profile image
      */
     void SetLargeImageKey(const String& rKey) {
-        mLargeImageKey = rKey;
+        SetField(mPending.largeImageKey, rKey, EDirty_LargeImage);
     }
     /**
      * @brief Sets the tooltip for the large profile image
@@ -88,7 +157,7 @@ public:
      * @param rText Tooltip for the large image
      */
     void SetLargeImageText(const String& rText) {
-        mLargeImageText = rText;
+        SetField(mPending.largeImageText, rText, EDirty_LargeImage);
     }
 
     /**
@@ -97,7 +166,7 @@ public:
      * @param rKey Key of the uploaded small profile image
      */
     void SetSmallImageKey(const String& rKey) {
-        mSmallImageKey = rKey;
+        SetField(mPending.smallImageKey, rKey, EDirty_SmallImage);
     }
     /**
      * @brief Sets the tooltip for the small profile image
@@ -105,7 +174,7 @@ public:
      * @param rText Tooltip for the small image
      */
     void SetSmallImageText(const String& rText) {
-        mSmallImageText = rText;
+        SetField(mPending.smallImageText, rText, EDirty_SmallImage);
     }
 
     /**
@@ -115,14 +184,15 @@ public:
      * @param start Epoch seconds for game start
      */
     void SetStartTime(u64 start) {
-        mStartTime = start;
-        mEndTime = 0;
+        AutoMutexLock lock(mMutex);
+        SetField(mPending.startTime, start, EDirty_Time);
+        SetField(mPending.endTime, static_cast<u64>(0), EDirty_Time);
     }
     /**
      * @brief Sets the gameplay start time to the current clock time
      */
     void SetStartTimeNow() {
-        mStartTime = GetTimeNow();
+        SetStartTime(GetTimeNow());
     }
 
     /**
@@ -132,8 +202,9 @@ public:
      * @param start Epoch seconds for game start
      */
     void SetEndTime(u64 end) {
-        mEndTime = end;
-        mStartTime = 0;
+        AutoMutexLock lock(mMutex);
+        SetField(mPending.endTime, end, EDirty_Time);
+        SetField(mPending.startTime, static_cast<u64>(0), EDirty_Time);
     }
 
     /**
@@ -142,7 +213,7 @@ public:
      * @param num Current party size
      */
     void SetPartyNum(s32 num) {
-        mPartyNum = num;
+        SetField(mPending.partyNum, num, EDirty_Party);
     }
     /**
      * @brief Sets the maximum number of players in the party
@@ -150,26 +221,83 @@ public:
      * @param num Maximum party size
      */
     void SetPartyMax(s32 max) {
-        mPartyNum = max;
+        SetField(mPending.partyMax, max, EDirty_Party);
     }
 
 protected:
-    String mAppID; // Application ID
+    /**
+     * @brief Presence activity
+     */
+    struct Activity {
+        String details; // Presence details
+        String state;   // Presence state
+
+        String largeImageKey;  // Large image name
+        String largeImageText; // Large image description
+
+        String smallImageKey;  // Small image name
+        String smallImageText; // Small image description
+
+        u64 startTime; // Gameplay start epoch
+        u64 endTime;   // Gameplay end epoch
+
+        s32 partyNum; // Party size
+        s32 partyMax; // Maximum party size
+
+        /**
+         * @brief Constructor
+         */
+        Activity() : startTime(0), endTime(0), partyNum(0), partyMax(0) {}
+    };
+
+private:
+    /**
+     * @brief Changed field groups
+     */
+    enum EDirty {
+        EDirty_AppID = 1 << 0,
+        EDirty_Details = 1 << 1,
+        EDirty_State = 1 << 2,
+        EDirty_LargeImage = 1 << 3,
+        EDirty_SmallImage = 1 << 4,
+        EDirty_Time = 1 << 5,
+        EDirty_Party = 1 << 6,
+
+        EDirty_Activity = EDirty_Details | EDirty_State | EDirty_LargeImage |
+                          EDirty_SmallImage | EDirty_Time | EDirty_Party
+    };
+
+private:
+    /**
+     * @brief Records a change to a pending field
+     * @details Values equal to the pending value are not marked as dirty
+     *
+     * @param rField Pending field
+     * @param rValue New value
+     * @param dirty Dirty flag for the field
+     */
+    template <typename T>
+    void SetField(T& rField, const T& rValue, u32 dirty) {
+        AutoMutexLock lock(mMutex);
 
-    String mDetails; // Presence details
-    String mState;   // Presence state
+        if (rField == rValue) {
+            return;
+        }
 
-    String mLargeImageKey;  // Large image name
-    String mLargeImageText; // Large image description
+        rField = rValue;
+        mDirty |= dirty;
+    }
 
-    String mSmallImageKey;  // Small image name
-    String mSmallImageText; // Small image description
+protected:
+    String mAppID;      // Application ID (committed)
+    Activity mActivity; // Presence activity (committed)
 
-    u64 mStartTime; // Gameplay start epoch
-    u64 mEndTime;   // Gameplay end epoch
+private:
+    String mPendingAppID; // Application ID (pending)
+    Activity mPending;    // Presence activity (pending)
+    u32 mDirty;           // Pending changes (EDirty)
 
-    s32 mPartyNum; // Party size
-    s32 mPartyMax; // Maximum party size
+    mutable OSMutex mMutex; // Pending data lock
 };
 
 //! @}
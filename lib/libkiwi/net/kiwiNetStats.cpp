@@ -0,0 +1,345 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Clears all samples
+ */
+void LatencyHistogram::Reset() {
+    mCount = 0;
+    mMax = 0;
+    mTotal = 0;
+    std::memset(mBuckets, 0, sizeof(mBuckets));
+}
+
+/**
+ * @brief Records a latency sample
+ *
+ * @param usec Latency, in microseconds
+ */
+void LatencyHistogram::Record(u32 usec) {
+    // Bucket index is the position of the highest set bit
+    u32 i = usec > 1 ? 31 - __cntlzw(usec) : 0;
+    i = Min(i, NUM_BUCKETS - 1);
+
+    mCount++;
+    mMax = Max(mMax, usec);
+    mTotal += usec;
+    mBuckets[i]++;
+}
+
+/**
+ * @brief Estimates a latency percentile
+ * @details Bucket resolution means the result is an upper bound
+ *
+ * @param percent Percentile (0-100)
+ * @return Latency, in microseconds
+ */
+u32 LatencyHistogram::GetPercentile(u32 percent) const {
+    K_ASSERT(percent <= 100);
+
+    if (mCount == 0) {
+        return 0;
+    }
+
+    // Number of samples at or below the percentile (rounded up)
+    u32 target = static_cast<u32>(
+        (static_cast<u64>(mCount) * percent + 99) / 100);
+    target = Max<u32>(target, 1);
+
+    u32 num = 0;
+    for (u32 i = 0; i < NUM_BUCKETS - 1; i++) {
+        num += mBuckets[i];
+
+        // No sample can be larger than the largest one
+        if (num >= target) {
+            return Min<u32>(GetBucketMin(i + 1) - 1, mMax);
+        }
+    }
+
+    return mMax;
+}
+
+/**
+ * @brief Encodes the histogram into a JSON stream
+ *
+ * @param rWriter JSON stream writer
+ */
+void LatencyHistogram::Encode(json::StreamWriter& rWriter) const {
+    rWriter.BeginObject();
+    rWriter.WriteKey("count");
+    rWriter.WriteNumber(mCount);
+    rWriter.WriteKey("mean");
+    rWriter.WriteNumber(GetMean());
+    rWriter.WriteKey("p50");
+    rWriter.WriteNumber(GetPercentile(50));
+    rWriter.WriteKey("p99");
+    rWriter.WriteNumber(GetPercentile(99));
+    rWriter.WriteKey("max");
+    rWriter.WriteNumber(mMax);
+
+    // Bucket N starts at 2^N microseconds
+    rWriter.WriteKey("buckets");
+    rWriter.BeginArray();
+    for (u32 i = 0; i < NUM_BUCKETS; i++) {
+        rWriter.WriteNumber(mBuckets[i]);
+    }
+    rWriter.EndArray();
+    rWriter.EndObject();
+}
+
+/**
+ * @brief Clears all counters
+ */
+void NetCounters::Reset() {
+    std::memset(this, 0, sizeof(NetCounters));
+}
+
+/**
+ * @brief Encodes the counters into a JSON stream
+ *
+ * @param rWriter JSON stream writer
+ */
+void NetCounters::Encode(json::StreamWriter& rWriter) const {
+    rWriter.BeginObject();
+    rWriter.WriteKey("connects");
+    rWriter.WriteNumber(numConnects);
+    rWriter.WriteKey("sends");
+    rWriter.WriteNumber(numSends);
+    rWriter.WriteKey("recvs");
+    rWriter.WriteNumber(numRecvs);
+    rWriter.WriteKey("sendBytes");
+    rWriter.WriteNumber(static_cast<f64>(sendBytes));
+    rWriter.WriteKey("recvBytes");
+    rWriter.WriteNumber(static_cast<f64>(recvBytes));
+    rWriter.WriteKey("wouldBlock");
+    rWriter.WriteNumber(numWouldBlock);
+    rWriter.WriteKey("errors");
+    rWriter.WriteNumber(numErrors);
+    rWriter.EndObject();
+}
+
+/**
+ * @brief Operation names
+ */
+const char* NetStats::scOpNames[EOp_Max] = {"connect", "send", "recv"};
+
+/**
+ * @brief Recording toggle
+ */
+bool NetStats::sIsEnabled = false;
+
+/**
+ * @brief Global counters
+ */
+NetCounters NetStats::sCounters;
+
+/**
+ * @brief Latency per operation
+ */
+LatencyHistogram NetStats::sHistograms[EOp_Max];
+
+/**
+ * @brief Gets the global counters
+ */
+NetCounters NetStats::GetCounters() {
+    AutoInterruptLock lock;
+    return sCounters;
+}
+
+/**
+ * @brief Gets the latency histogram of an operation
+ *
+ * @param op Operation
+ */
+LatencyHistogram NetStats::GetHistogram(EOp op) {
+    K_ASSERT(op < EOp_Max);
+
+    AutoInterruptLock lock;
+    return sHistograms[op];
+}
+
+/**
+ * @brief Clears the global counters and histograms
+ */
+void NetStats::Reset() {
+    AutoInterruptLock lock;
+
+    sCounters.Reset();
+
+    for (int i = 0; i < EOp_Max; i++) {
+        sHistograms[i].Reset();
+    }
+}
+
+/**
+ * @brief Records a completed LibSO operation (global)
+ * @note Safe to call from interrupt context
+ *
+ * @param op Operation
+ * @param result Operation result (bytes transferred or IOS error code)
+ * @param start Tick when the operation started
+ */
+void NetStats::Record(EOp op, s32 result, u32 start) {
+    K_ASSERT(op < EOp_Max);
+
+    if (!sIsEnabled) {
+        return;
+    }
+
+    // Avoid overflow in the tick conversion
+    u64 ticks = OSGetTick() - start;
+    u32 usec = static_cast<u32>(OS_TICKS_TO_USEC(ticks));
+
+    AutoInterruptLock lock;
+
+    Count(sCounters, op, result);
+    sHistograms[op].Record(usec);
+}
+
+/**
+ * @brief Counts a completed operation in a socket's counters
+ * @note Safe to call from interrupt context
+ *
+ * @param rCounters Socket counters
+ * @param op Operation
+ * @param result Operation result (bytes transferred or IOS error code)
+ */
+void NetStats::Count(NetCounters& rCounters, EOp op, s32 result) {
+    K_ASSERT(op < EOp_Max);
+
+    if (!sIsEnabled) {
+        return;
+    }
+
+    AutoInterruptLock lock;
+
+    switch (op) {
+    case EOp_Connect: {
+        rCounters.numConnects++;
+
+        // Non-blocking connections take several calls
+        if (result == SO_EINPROGRESS || result == SO_EALREADY) {
+            rCounters.numWouldBlock++;
+            return;
+        }
+
+        // Connection was established by an earlier call
+        if (result == SO_EISCONN) {
+            return;
+        }
+
+        break;
+    }
+
+    case EOp_Send: {
+        rCounters.numSends++;
+
+        if (result > 0) {
+            rCounters.sendBytes += result;
+        }
+
+        break;
+    }
+
+    case EOp_Recv: {
+        rCounters.numRecvs++;
+
+        if (result > 0) {
+            rCounters.recvBytes += result;
+        }
+
+        break;
+    }
+
+    default: {
+        K_ASSERT_EX(false, "Unknown operation: %d", op);
+        return;
+    }
+    }
+
+    if (result == SO_EWOULDBLOCK) {
+        rCounters.numWouldBlock++;
+    } else if (result < 0) {
+        rCounters.numErrors++;
+    }
+}
+
+/**
+ * @brief Prints the global statistics to the Nw4rConsole
+ */
+void NetStats::Print() {
+    NetCounters counters = GetCounters();
+    Nw4rConsole& rConsole = Nw4rConsole::GetInstance();
+
+    rConsole.Printf("Network I/O statistics%s\n",
+                    sIsEnabled ? "" : " (disabled)");
+
+    rConsole.Printf("  connect: %u calls\n", counters.numConnects);
+    rConsole.Printf("  send:    %u calls, %llu bytes\n", counters.numSends,
+                    counters.sendBytes);
+    rConsole.Printf("  recv:    %u calls, %llu bytes\n", counters.numRecvs,
+                    counters.recvBytes);
+    rConsole.Printf("  would block: %u, errors: %u\n", counters.numWouldBlock,
+                    counters.numErrors);
+
+    for (int i = 0; i < EOp_Max; i++) {
+        LatencyHistogram hist = GetHistogram(static_cast<EOp>(i));
+        if (hist.GetCount() == 0) {
+            continue;
+        }
+
+        rConsole.Printf("  %s latency (us): mean %u, p50 %u, p99 %u, max %u\n",
+                        scOpNames[i], hist.GetMean(), hist.GetPercentile(50),
+                        hist.GetPercentile(99), hist.GetMax());
+
+        // Empty buckets would just be noise
+        for (u32 j = 0; j < LatencyHistogram::NUM_BUCKETS; j++) {
+            if (hist.GetBucket(j) > 0) {
+                rConsole.Printf("    >= %u: %u\n",
+                                LatencyHistogram::GetBucketMin(j),
+                                hist.GetBucket(j));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Encodes the global statistics into a JSON stream
+ *
+ * @param rWriter JSON stream writer
+ */
+void NetStats::Encode(json::StreamWriter& rWriter) {
+    rWriter.BeginObject();
+    rWriter.WriteKey("enabled");
+    rWriter.WriteBoolean(sIsEnabled);
+
+    rWriter.WriteKey("counters");
+    GetCounters().Encode(rWriter);
+
+    rWriter.WriteKey("latency");
+    rWriter.BeginObject();
+    for (int i = 0; i < EOp_Max; i++) {
+        rWriter.WriteKey(scOpNames[i]);
+        GetHistogram(static_cast<EOp>(i)).Encode(rWriter);
+    }
+    rWriter.EndObject();
+    rWriter.EndObject();
+}
+
+/**
+ * @brief Writes the global statistics to a stream as JSON (UTF-8)
+ *
+ * @param rStrm Destination stream
+ * @param pretty Whether to pretty-print
+ * @return Success
+ */
+bool NetStats::Dump(IStream& rStrm, bool pretty) {
+    json::StreamWriter writer(rStrm, pretty);
+    Encode(writer);
+    return writer.Flush();
+}
+
+} // namespace kiwi
@@ -0,0 +1,241 @@
+#ifndef LIBKIWI_NET_NET_STATS_H
+#define LIBKIWI_NET_NET_STATS_H
+#include <libkiwi/k_types.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_net
+//! @{
+
+// Forward declarations
+class IStream;
+
+namespace json {
+class StreamWriter;
+}
+
+/**
+ * @brief Log2-bucketed latency histogram
+ * @details Bucket N counts latencies from 2^N up to 2^(N+1) microseconds.
+ * The first bucket also counts sub-microsecond latencies, and the last bucket
+ * also counts anything larger.
+ */
+class LatencyHistogram {
+public:
+    //! Number of buckets (the last one starts at ~8 seconds)
+    static const u32 NUM_BUCKETS = 24;
+
+public:
+    /**
+     * @brief Constructor
+     */
+    LatencyHistogram() {
+        Reset();
+    }
+
+    /**
+     * @brief Clears all samples
+     */
+    void Reset();
+
+    /**
+     * @brief Records a latency sample
+     *
+     * @param usec Latency, in microseconds
+     */
+    void Record(u32 usec);
+
+    /**
+     * @brief Gets the number of samples
+     */
+    u32 GetCount() const {
+        return mCount;
+    }
+    /**
+     * @brief Gets the largest latency (in microseconds)
+     */
+    u32 GetMax() const {
+        return mMax;
+    }
+    /**
+     * @brief Gets the average latency (in microseconds)
+     */
+    u32 GetMean() const {
+        return mCount > 0 ? static_cast<u32>(mTotal / mCount) : 0;
+    }
+
+    /**
+     * @brief Gets the number of samples in a bucket
+     *
+     * @param i Bucket index
+     */
+    u32 GetBucket(u32 i) const {
+        K_ASSERT(i < NUM_BUCKETS);
+        return mBuckets[i];
+    }
+    /**
+     * @brief Gets the lowest latency counted by a bucket (in microseconds)
+     *
+     * @param i Bucket index
+     */
+    static u32 GetBucketMin(u32 i) {
+        K_ASSERT(i < NUM_BUCKETS);
+        return i > 0 ? 1 << i : 0;
+    }
+
+    /**
+     * @brief Estimates a latency percentile
+     * @details Bucket resolution means the result is an upper bound
+     *
+     * @param percent Percentile (0-100)
+     * @return Latency, in microseconds
+     */
+    u32 GetPercentile(u32 percent) const;
+
+    /**
+     * @brief Encodes the histogram into a JSON stream
+     *
+     * @param rWriter JSON stream writer
+     */
+    void Encode(json::StreamWriter& rWriter) const;
+
+private:
+    u32 mCount;                // Number of samples
+    u32 mMax;                  // Largest sample
+    u64 mTotal;                // Sum of all samples
+    u32 mBuckets[NUM_BUCKETS]; // Samples per bucket
+};
+
+/**
+ * @brief Network I/O counters
+ */
+struct NetCounters {
+    u32 numConnects;   // Connect calls
+    u32 numSends;      // Send calls
+    u32 numRecvs;      // Receive calls
+    u64 sendBytes;     // Total bytes sent
+    u64 recvBytes;     // Total bytes received
+    u32 numWouldBlock; // Calls which would have blocked (SO_EWOULDBLOCK)
+    u32 numErrors;     // Calls which failed
+
+    /**
+     * @brief Constructor
+     */
+    NetCounters() {
+        Reset();
+    }
+
+    /**
+     * @brief Clears all counters
+     */
+    void Reset();
+
+    /**
+     * @brief Encodes the counters into a JSON stream
+     *
+     * @param rWriter JSON stream writer
+     */
+    void Encode(json::StreamWriter& rWriter) const;
+};
+
+/**
+ * @brief Network I/O statistics
+ * @details LibSO records global counters and connect/send/recv latency
+ * histograms, and sockets keep their own counters. Statistics are opt-in, so
+ * nothing is recorded until they are enabled.
+ */
+class NetStats {
+public:
+    /**
+     * @brief Recorded operation
+     */
+    enum EOp {
+        EOp_Connect, //!< Connect
+        EOp_Send,    //!< Send
+        EOp_Recv,    //!< Receive
+
+        EOp_Max
+    };
+
+public:
+    /**
+     * @brief Toggles statistics recording
+     *
+     * @param enable Whether to record statistics
+     */
+    static void SetEnabled(bool enable) {
+        sIsEnabled = enable;
+    }
+    /**
+     * @brief Tests whether statistics are being recorded
+     */
+    static bool IsEnabled() {
+        return sIsEnabled;
+    }
+
+    /**
+     * @brief Gets the global counters
+     */
+    static NetCounters GetCounters();
+    /**
+     * @brief Gets the latency histogram of an operation
+     *
+     * @param op Operation
+     */
+    static LatencyHistogram GetHistogram(EOp op);
+    /**
+     * @brief Clears the global counters and histograms
+     */
+    static void Reset();
+
+    /**
+     * @brief Records a completed LibSO operation (global)
+     * @note Safe to call from interrupt context
+     *
+     * @param op Operation
+     * @param result Operation result (bytes transferred or IOS error code)
+     * @param start Tick when the operation started
+     */
+    static void Record(EOp op, s32 result, u32 start);
+    /**
+     * @brief Counts a completed operation in a socket's counters
+     * @note Safe to call from interrupt context
+     *
+     * @param rCounters Socket counters
+     * @param op Operation
+     * @param result Operation result (bytes transferred or IOS error code)
+     */
+    static void Count(NetCounters& rCounters, EOp op, s32 result);
+
+    /**
+     * @brief Prints the global statistics to the Nw4rConsole
+     */
+    static void Print();
+
+    /**
+     * @brief Encodes the global statistics into a JSON stream
+     *
+     * @param rWriter JSON stream writer
+     */
+    static void Encode(json::StreamWriter& rWriter);
+    /**
+     * @brief Writes the global statistics to a stream as JSON (UTF-8)
+     *
+     * @param rStrm Destination stream
+     * @param pretty Whether to pretty-print
+     * @return Success
+     */
+    static bool Dump(IStream& rStrm, bool pretty = false);
+
+private:
+    //! Operation names
+    static const char* scOpNames[EOp_Max];
+
+    static bool sIsEnabled;                       // Recording toggle
+    static NetCounters sCounters;                 // Global counters
+    static LatencyHistogram sHistograms[EOp_Max]; // Latency per operation
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
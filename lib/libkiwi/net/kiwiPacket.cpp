@@ -4,6 +4,7 @@ namespace kiwi {
 
 /**
  * @brief Allocates message buffer of the specified size
+ * @details The existing buffer is recycled if the message fits
  *
  * @param size Packet size
  */
@@ -11,29 +12,66 @@ void Packet::Alloc(u32 size) {
     K_ASSERT(size > 0);
     K_ASSERT_EX(size < GetMaxContent(), "Must be fragmented!");
 
-    // Free existing message
-    if (mpBuffer != nullptr) {
-        Free();
+    // Protocol may have memory overhead
+    u32 bufferSize = size + GetOverhead();
+
+    // Recycle the existing buffer
+    if (mpBuffer != nullptr && bufferSize <= mBufferCapacity) {
+        mBufferSize = bufferSize;
+        Clear();
+        return;
     }
 
-    // Protocol may have memory overhead
-    mBufferSize = size + GetOverhead();
+    K_ASSERT_EX(mpBuffer == nullptr || mIsBufferOwner,
+                "Message doesn't fit in the attached buffer");
+
+    // Free existing message
+    Free();
 
-    mpBuffer = new (32, EMemory_MEM2) u8[mBufferSize];
+    mpBuffer = new (32, EMemory_MEM2) u8[bufferSize];
     K_ASSERT(mpBuffer != nullptr);
     K_ASSERT(OSIsMEM2Region(mpBuffer));
 
+    mBufferSize = bufferSize;
+    mBufferCapacity = bufferSize;
+    mIsBufferOwner = true;
+
     Clear();
 }
 
+/**
+ * @brief Uses external memory as the message buffer
+ * @note The memory is not owned (or freed) by the packet
+ *
+ * @param pBuffer Buffer memory (MEM2)
+ * @param capacity Buffer memory size
+ */
+void Packet::Attach(void* pBuffer, u32 capacity) {
+    K_ASSERT(pBuffer != nullptr);
+    K_ASSERT(OSIsMEM2Region(pBuffer));
+    K_ASSERT(capacity > GetOverhead());
+
+    // Free existing message
+    Free();
+
+    mpBuffer = static_cast<u8*>(pBuffer);
+    mBufferSize = 0;
+    mBufferCapacity = capacity;
+    mIsBufferOwner = false;
+}
+
 /**
  * @brief Releases message buffer
  */
 void Packet::Free() {
-    AutoMutexLock lock(mBufferMutex);
+    if (mIsBufferOwner) {
+        delete[] mpBuffer;
+    }
 
-    delete mpBuffer;
     mpBuffer = nullptr;
+    mBufferSize = 0;
+    mBufferCapacity = 0;
+    mIsBufferOwner = false;
 
     Clear();
 }
@@ -42,8 +80,6 @@ void Packet::Free() {
  * @brief Clears existing state
  */
 void Packet::Clear() {
-    AutoMutexLock lock(mBufferMutex);
-
     mReadOffset = 0;
     mWriteOffset = 0;
 }
@@ -60,8 +96,6 @@ u32 Packet::Read(void* pDst, u32 n) {
     K_ASSERT(mpBuffer != nullptr);
     K_ASSERT(n <= GetMaxContent());
 
-    AutoMutexLock lock(mBufferMutex);
-
     // Clamp size to avoid overflow
     n = Min(n, ReadRemain());
 
@@ -84,8 +118,6 @@ u32 Packet::Write(const void* pSrc, u32 n) {
     K_ASSERT(mpBuffer != nullptr);
     K_ASSERT(n <= GetMaxContent());
 
-    AutoMutexLock lock(mBufferMutex);
-
     // Clamp size to avoid overflow
     n = Min(n, WriteRemain());
 
@@ -96,6 +128,25 @@ u32 Packet::Write(const void* pSrc, u32 n) {
     return n;
 }
 
+/**
+ * @brief Treats data already in the message buffer as written
+ * @details Lets an attached buffer be sent without copying it
+ *
+ * @param n Data size
+ *
+ * @return Number of bytes written
+ */
+u32 Packet::WriteInPlace(u32 n) {
+    K_ASSERT(mpBuffer != nullptr);
+    K_ASSERT(n <= GetMaxContent());
+
+    // Clamp size to avoid overflow
+    n = Min(n, WriteRemain());
+    mWriteOffset += n;
+
+    return n;
+}
+
 /**
  * @brief Receives message data from socket
  *
@@ -107,8 +158,6 @@ Optional<u32> Packet::Recv(SOSocket socket) {
     K_ASSERT(socket >= 0);
     K_ASSERT(mpBuffer != nullptr);
 
-    AutoMutexLock lock(mBufferMutex);
-
     // Read from socket (try to complete packet)
     s32 result = LibSO::RecvFrom(socket, mpBuffer + mWriteOffset, WriteRemain(),
                                  0, mAddress);
@@ -138,8 +187,6 @@ Optional<u32> Packet::Send(SOSocket socket) {
     K_ASSERT(socket >= 0);
     K_ASSERT(mpBuffer != nullptr);
 
-    AutoMutexLock lock(mBufferMutex);
-
     // Send through socket (try to complete packet)
     s32 result = LibSO::SendTo(socket, mpBuffer + mReadOffset, ReadRemain(), 0,
                                mAddress);
@@ -158,4 +205,110 @@ Optional<u32> Packet::Send(SOSocket socket) {
     return kiwi::nullopt;
 }
 
+/**
+ * @brief Writes message data to socket asynchronously
+ * @note The packet must outlive the operation
+ *
+ * @param socket Socket descriptor
+ * @param pCallback Completion callback (bytes sent or IOS error code)
+ * @param pArg Callback user argument
+ */
+void Packet::SendAsync(SOSocket socket, LibSO::AsyncCallback pCallback,
+                       void* pArg) {
+    K_ASSERT(socket >= 0);
+    K_ASSERT(mpBuffer != nullptr);
+
+    K_ASSERT_EX(mpAsyncCallback == nullptr && mpAsyncArg == nullptr,
+                "Packet already has a pending operation");
+
+    mpAsyncCallback = pCallback;
+    mpAsyncArg = pArg;
+
+    // Send through socket (try to complete packet)
+    LibSO::SendAsync(socket, mpBuffer + mReadOffset, ReadRemain(), 0,
+                     &mAddress, SendAsyncFunc, this);
+}
+
+/**
+ * @brief Receives message data from socket asynchronously
+ * @note The packet must outlive the operation
+ *
+ * @param socket Socket descriptor
+ * @param pCallback Completion callback (bytes received or IOS error code)
+ * @param pArg Callback user argument
+ */
+void Packet::RecvAsync(SOSocket socket, LibSO::AsyncCallback pCallback,
+                       void* pArg) {
+    K_ASSERT(socket >= 0);
+    K_ASSERT(mpBuffer != nullptr);
+
+    K_ASSERT_EX(mpAsyncCallback == nullptr && mpAsyncArg == nullptr,
+                "Packet already has a pending operation");
+
+    mpAsyncCallback = pCallback;
+    mpAsyncArg = pArg;
+
+    // Read from socket (try to complete packet)
+    LibSO::RecvAsync(socket, mpBuffer + mWriteOffset, WriteRemain(), 0,
+                     &mAddress, RecvAsyncFunc, this);
+}
+
+/**
+ * @brief Async send completion callback
+ *
+ * @param result Bytes sent or IOS error code
+ * @param pArg Callback user argument
+ */
+void Packet::SendAsyncFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is this object
+    Packet* p = static_cast<Packet*>(pArg);
+
+    // > 0 means bytes written to socket
+    if (result > 0) {
+        p->mReadOffset += result;
+    }
+
+    LibSO::AsyncCallback pCallback = p->mpAsyncCallback;
+    void* pCallbackArg = p->mpAsyncArg;
+
+    p->mpAsyncCallback = nullptr;
+    p->mpAsyncArg = nullptr;
+
+    // Callback may destroy the packet
+    if (pCallback != nullptr) {
+        pCallback(result, pCallbackArg);
+    }
+}
+
+/**
+ * @brief Async receive completion callback
+ *
+ * @param result Bytes received or IOS error code
+ * @param pArg Callback user argument
+ */
+void Packet::RecvAsyncFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is this object
+    Packet* p = static_cast<Packet*>(pArg);
+
+    // > 0 means bytes read from socket
+    if (result > 0) {
+        p->mWriteOffset += result;
+    }
+
+    LibSO::AsyncCallback pCallback = p->mpAsyncCallback;
+    void* pCallbackArg = p->mpAsyncArg;
+
+    p->mpAsyncCallback = nullptr;
+    p->mpAsyncArg = nullptr;
+
+    // Callback may destroy the packet
+    if (pCallback != nullptr) {
+        pCallback(result, pCallbackArg);
+    }
+}
+
 } // namespace kiwi
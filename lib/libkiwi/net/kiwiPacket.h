@@ -13,9 +13,27 @@ namespace kiwi {
 
 /**
  * @brief Network packet wrapper
+ * @note Packets are not locked, so only their current owner (e.g. one side of
+ * a packet ring, or a pending socket operation) may access them.
  */
 class Packet {
 public:
+    /**
+     * @brief Constructor
+     * @details Creates an empty packet (see Alloc/Attach)
+     */
+    Packet()
+        : mpBuffer(nullptr),
+          mBufferSize(0),
+          mBufferCapacity(0),
+          mIsBufferOwner(false),
+          mReadOffset(0),
+          mWriteOffset(0),
+          mpAsyncCallback(nullptr),
+          mpAsyncArg(nullptr) {
+        mAddress = SockAddr4();
+    }
+
     /**
      * @brief Constructor
      *
@@ -23,8 +41,14 @@ public:
      * @param pAddr Packet recipient
      */
     Packet(u32 size, const SockAddrAny* pAddr = nullptr)
-        : mpBuffer(nullptr), mBufferSize(0), mReadOffset(0), mWriteOffset(0) {
-        OSInitMutex(&mBufferMutex);
+        : mpBuffer(nullptr),
+          mBufferSize(0),
+          mBufferCapacity(0),
+          mIsBufferOwner(false),
+          mReadOffset(0),
+          mWriteOffset(0),
+          mpAsyncCallback(nullptr),
+          mpAsyncArg(nullptr) {
         Alloc(size);
 
         if (pAddr != nullptr) {
@@ -47,6 +71,12 @@ public:
     virtual u32 GetBufferSize() const {
         return mBufferSize;
     }
+    /**
+     * @brief Gets the size of the memory behind the message buffer
+     */
+    u32 GetBufferCapacity() const {
+        return mBufferCapacity;
+    }
     /**
      * @brief Gets the maximum size of the message buffer
      */
@@ -120,14 +150,32 @@ public:
     const SockAddrAny& GetPeer() const {
         return mAddress;
     }
+    /**
+     * @brief Sets the peer socket address
+     *
+     * @param rAddr Packet recipient
+     */
+    void SetPeer(const SockAddrAny& rAddr) {
+        mAddress = rAddr;
+    }
 
     /**
      * @brief Allocates message buffer of the specified size
+     * @details The existing buffer is recycled if the message fits
      *
      * @param size Packet size
      */
     void Alloc(u32 size);
 
+    /**
+     * @brief Uses external memory as the message buffer
+     * @note The memory is not owned (or freed) by the packet
+     *
+     * @param pBuffer Buffer memory (MEM2)
+     * @param capacity Buffer memory size
+     */
+    void Attach(void* pBuffer, u32 capacity);
+
     /**
      * @brief Reads data from message buffer
      *
@@ -146,6 +194,15 @@ public:
      * @return Number of bytes written
      */
     u32 Write(const void* pSrc, u32 n);
+    /**
+     * @brief Treats data already in the message buffer as written
+     * @details Lets an attached buffer be sent without copying it
+     *
+     * @param n Data size
+     *
+     * @return Number of bytes written
+     */
+    u32 WriteInPlace(u32 n);
 
     /**
      * @brief Receives message data from socket
@@ -164,6 +221,27 @@ public:
      */
     Optional<u32> Recv(SOSocket socket);
 
+    /**
+     * @brief Writes message data to socket asynchronously
+     * @note The packet must outlive the operation
+     *
+     * @param socket Socket descriptor
+     * @param pCallback Completion callback (bytes sent or IOS error code)
+     * @param pArg Callback user argument
+     */
+    void SendAsync(SOSocket socket, LibSO::AsyncCallback pCallback,
+                   void* pArg = nullptr);
+    /**
+     * @brief Receives message data from socket asynchronously
+     * @note The packet must outlive the operation
+     *
+     * @param socket Socket descriptor
+     * @param pCallback Completion callback (bytes received or IOS error code)
+     * @param pArg Callback user argument
+     */
+    void RecvAsync(SOSocket socket, LibSO::AsyncCallback pCallback,
+                   void* pArg = nullptr);
+
 protected:
     /**
      * @brief Releases message buffer
@@ -175,15 +253,35 @@ protected:
      */
     void Clear();
 
+private:
+    /**
+     * @brief Async send completion callback
+     *
+     * @param result Bytes sent or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void SendAsyncFunc(s32 result, void* pArg);
+    /**
+     * @brief Async receive completion callback
+     *
+     * @param result Bytes received or IOS error code
+     * @param pArg Callback user argument
+     */
+    static void RecvAsyncFunc(s32 result, void* pArg);
+
 protected:
-    u8* mpBuffer;         // Message buffer
-    u32 mBufferSize;      // Message buffer size
-    OSMutex mBufferMutex; // Buffer access mutex
+    u8* mpBuffer;        // Message buffer
+    u32 mBufferSize;     // Message buffer size
+    u32 mBufferCapacity; // Message buffer memory size
+    bool mIsBufferOwner; // Whether the buffer memory is owned by the packet
 
     s32 mReadOffset;  // Buffer read index
     s32 mWriteOffset; // Buffer write index
 
     SockAddrAny mAddress; // Sender (recv) or recipient (send)
+
+    LibSO::AsyncCallback mpAsyncCallback; // Pending async operation callback
+    void* mpAsyncArg;                     // Async callback user argument
 };
 
 //! @}
@@ -0,0 +1,231 @@
+#ifndef LIBKIWI_NET_PACKET_RING_H
+#define LIBKIWI_NET_PACKET_RING_H
+#include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiPacket.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_net
+//! @{
+
+/**
+ * @brief Fixed-capacity ring of preallocated packets
+ * @details Packet buffers come from one MEM2 allocation and are recycled, so
+ * queueing a message never touches the heap. One thread may push (producer)
+ * while another pops (consumer) without locking, as each index is only ever
+ * written by one side.
+ *
+ * Producer:
+ * @code
+ * Packet* pPacket = ring.BeginPush();
+ * if (pPacket != nullptr) {
+ *     pPacket->Alloc(size);
+ *     pPacket->Write(pData, size);
+ *     ring.EndPush();
+ * }
+ * @endcode
+ *
+ * Consumer:
+ * @code
+ * Packet* pPacket = ring.BeginPop();
+ * if (pPacket != nullptr) {
+ *     pPacket->Read(pData, pPacket->GetContentSize());
+ *     ring.EndPop();
+ * }
+ * @endcode
+ *
+ * @note Only safe for a single producer and a single consumer
+ *
+ * @tparam T Packet type
+ */
+template <typename T = Packet> class TPacketRing : private NonCopyable {
+public:
+    /**
+     * @brief Ring statistics
+     * @details The byte rate is measured as packets are released, so for a
+     * send queue it shows how close the sender gets to the link rate.
+     */
+    struct Stats {
+        u32 numPushed;    // Packets published by the producer
+        u32 numFull;      // Times the producer found no free slot
+        u32 maxUsed;      // Largest number of queued packets
+        u32 numPopped;    // Packets released by the consumer
+        u32 numBytes;     // Message bytes released by the consumer
+        u32 maxLatency;   // Longest time from push to pop (usec)
+        u32 totalLatency; // Sum of times from push to pop (usec)
+        u32 elapsed;      // Time since the statistics were reset (msec)
+        u32 byteRate;     // Message bytes released per second
+    };
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param capacity Number of packet slots (power of two)
+     * @param slotSize Buffer size of each packet slot
+     */
+    TPacketRing(u32 capacity, u32 slotSize);
+
+    /**
+     * @brief Destructor
+     */
+    ~TPacketRing();
+
+    /**
+     * @brief Gets the number of packet slots
+     */
+    u32 GetCapacity() const {
+        return mCapacity;
+    }
+    /**
+     * @brief Gets the buffer size of each packet slot
+     */
+    u32 GetSlotSize() const {
+        return mSlotSize;
+    }
+
+    /**
+     * @brief Gets the number of queued packets
+     */
+    u32 GetSize() const {
+        return mTail - mHead;
+    }
+    /**
+     * @brief Tests whether no packets are queued
+     */
+    bool IsEmpty() const {
+        return GetSize() == 0;
+    }
+    /**
+     * @brief Tests whether all slots are in use
+     */
+    bool IsFull() const {
+        return GetSize() == mCapacity;
+    }
+
+    /**
+     * @brief Tests whether a packet is one of the ring's slots
+     *
+     * @param pPacket Packet
+     */
+    bool IsSlot(const T* pPacket) const {
+        return pPacket >= mpSlots && pPacket < mpSlots + mCapacity;
+    }
+
+    /**
+     * @name Producer
+     */
+    /**@{*/
+    /**
+     * @brief Gets the next free packet slot
+     *
+     * @return Packet to fill, or nullptr if the ring is full
+     */
+    T* BeginPush();
+    /**
+     * @brief Publishes the packet from BeginPush to the consumer
+     */
+    void EndPush();
+    /**@}*/
+
+    /**
+     * @name Consumer
+     */
+    /**@{*/
+    /**
+     * @brief Gets the oldest queued packet
+     *
+     * @return Packet to read, or nullptr if the ring is empty
+     */
+    T* BeginPop();
+    /**
+     * @brief Releases the packet from BeginPop back to the producer
+     */
+    void EndPop();
+    /**@}*/
+
+    /**
+     * @brief Gets the ring statistics
+     * @note Counters may be slightly stale while the ring is in use
+     */
+    Stats GetStats() const;
+    /**
+     * @brief Resets the ring statistics
+     * @details Each side clears its own counters the next time it runs, so
+     * the reset can't race with either of them.
+     */
+    void ResetStats();
+
+private:
+    /**
+     * @brief Counters which only the producer writes
+     */
+    struct ProducerStats {
+        u32 generation; // Reset generation of the counters
+        u32 numPushed;  // Packets published
+        u32 numFull;    // Times no slot was free
+        u32 maxUsed;    // Largest number of queued packets
+    };
+
+    /**
+     * @brief Counters which only the consumer writes
+     */
+    struct ConsumerStats {
+        u32 generation;   // Reset generation of the counters
+        u32 numPopped;    // Packets released
+        u32 numBytes;     // Message bytes released
+        u32 maxLatency;   // Longest time from push to pop (usec)
+        u32 totalLatency; // Sum of times from push to pop (usec)
+    };
+
+private:
+    /**
+     * @brief Converts a free-running index to a slot index
+     *
+     * @param index Free-running index
+     */
+    u32 ToSlot(u32 index) const {
+        return index & (mCapacity - 1);
+    }
+
+    /**
+     * @brief Clears the producer counters if a reset was requested
+     */
+    void SyncProducerStats();
+    /**
+     * @brief Clears the consumer counters if a reset was requested
+     */
+    void SyncConsumerStats();
+
+private:
+    u32 mCapacity; // Number of packet slots
+    u32 mSlotSize; // Buffer size of each packet slot
+
+    u8* mpMemory;     // Slot buffer memory (MEM2)
+    T* mpSlots;       // Packet slots
+    s64* mpPushTimes; // Time when each slot was published
+
+    // Free-running indices (only written by the consumer/producer)
+    volatile u32 mHead; // Next slot to pop
+    volatile u32 mTail; // Next slot to push
+
+    ProducerStats mProducerStats; // Producer counters
+    ConsumerStats mConsumerStats; // Consumer counters
+
+    // Only written by ResetStats
+    volatile u32 mStatsGeneration; // Current reset generation
+    s64 mStatsResetTime;           // Time when the statistics were reset
+};
+
+//! Ring of plain packets
+typedef TPacketRing<Packet> PacketRing;
+
+//! @}
+} // namespace kiwi
+
+// Implementation header
+#ifndef LIBKIWI_NET_PACKET_RING_IMPL_HPP
+#include <libkiwi/net/kiwiPacketRingImpl.hpp>
+#endif
+
+#endif
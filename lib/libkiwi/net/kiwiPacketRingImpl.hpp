@@ -0,0 +1,226 @@
+// Implementation header
+#ifndef LIBKIWI_NET_PACKET_RING_IMPL_HPP
+#define LIBKIWI_NET_PACKET_RING_IMPL_HPP
+
+// Declaration header
+#ifndef LIBKIWI_NET_PACKET_RING_H
+#include <libkiwi/net/kiwiPacketRing.h>
+#endif
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Constructor
+ *
+ * @param capacity Number of packet slots (power of two)
+ * @param slotSize Buffer size of each packet slot
+ */
+template <typename T>
+K_INLINE TPacketRing<T>::TPacketRing(u32 capacity, u32 slotSize)
+    : mCapacity(capacity),
+      // Slots are cache-aligned for IOS
+      mSlotSize(ROUND_UP(slotSize, 32)),
+      mpMemory(nullptr),
+      mpSlots(nullptr),
+      mpPushTimes(nullptr),
+      mHead(0),
+      mTail(0),
+      mStatsGeneration(0),
+      mStatsResetTime(OSGetTime()) {
+    K_ASSERT(mCapacity > 0);
+    K_ASSERT_EX((mCapacity & (mCapacity - 1)) == 0,
+                "Capacity must be a power of two");
+    K_ASSERT(mSlotSize > 0);
+
+    mpMemory = new (32, EMemory_MEM2) u8[mCapacity * mSlotSize];
+    K_ASSERT(mpMemory != nullptr);
+
+    mpSlots = new T[mCapacity];
+    K_ASSERT(mpSlots != nullptr);
+
+    mpPushTimes = new s64[mCapacity];
+    K_ASSERT(mpPushTimes != nullptr);
+
+    // Packets keep their slot for the lifetime of the ring
+    for (u32 i = 0; i < mCapacity; i++) {
+        mpSlots[i].Attach(mpMemory + i * mSlotSize, mSlotSize);
+        mpPushTimes[i] = 0;
+    }
+
+    std::memset(&mProducerStats, 0, sizeof(ProducerStats));
+    std::memset(&mConsumerStats, 0, sizeof(ConsumerStats));
+}
+
+/**
+ * @brief Destructor
+ */
+template <typename T> K_INLINE TPacketRing<T>::~TPacketRing() {
+    // Packets don't own the slot memory
+    delete[] mpSlots;
+    mpSlots = nullptr;
+
+    delete[] mpMemory;
+    mpMemory = nullptr;
+
+    delete[] mpPushTimes;
+    mpPushTimes = nullptr;
+}
+
+/**
+ * @brief Gets the next free packet slot
+ *
+ * @return Packet to fill, or nullptr if the ring is full
+ */
+template <typename T> K_INLINE T* TPacketRing<T>::BeginPush() {
+    SyncProducerStats();
+
+    // Consumer hasn't released any slots yet
+    if (IsFull()) {
+        mProducerStats.numFull++;
+        return nullptr;
+    }
+
+    return &mpSlots[ToSlot(mTail)];
+}
+
+/**
+ * @brief Publishes the packet from BeginPush to the consumer
+ */
+template <typename T> K_INLINE void TPacketRing<T>::EndPush() {
+    K_ASSERT_EX(!IsFull(), "No packet to publish");
+
+    mpPushTimes[ToSlot(mTail)] = OSGetTime();
+
+    // The slot must be written before the consumer can see it. The console
+    // has a single core, so only the compiler could reorder this, and the
+    // index is volatile.
+    mTail = mTail + 1;
+
+    mProducerStats.numPushed++;
+    mProducerStats.maxUsed = Max(mProducerStats.maxUsed, GetSize());
+}
+
+/**
+ * @brief Gets the oldest queued packet
+ *
+ * @return Packet to read, or nullptr if the ring is empty
+ */
+template <typename T> K_INLINE T* TPacketRing<T>::BeginPop() {
+    // Producer hasn't published any packets yet
+    if (IsEmpty()) {
+        return nullptr;
+    }
+
+    return &mpSlots[ToSlot(mHead)];
+}
+
+/**
+ * @brief Releases the packet from BeginPop back to the producer
+ */
+template <typename T> K_INLINE void TPacketRing<T>::EndPop() {
+    K_ASSERT_EX(!IsEmpty(), "No packet to release");
+
+    SyncConsumerStats();
+
+    u32 slot = ToSlot(mHead);
+    u32 latency =
+        static_cast<u32>(OS_TICKS_TO_USEC(OSGetTime() - mpPushTimes[slot]));
+
+    mConsumerStats.numPopped++;
+    mConsumerStats.numBytes += mpSlots[slot].GetContentSize();
+    mConsumerStats.maxLatency = Max(mConsumerStats.maxLatency, latency);
+    mConsumerStats.totalLatency += latency;
+
+    // Slot is reused by the producer after this
+    mHead = mHead + 1;
+}
+
+/**
+ * @brief Gets the ring statistics
+ * @note Counters may be slightly stale while the ring is in use
+ */
+template <typename T>
+K_INLINE typename TPacketRing<T>::Stats TPacketRing<T>::GetStats() const {
+    Stats stats;
+    std::memset(&stats, 0, sizeof(Stats));
+
+    u32 generation = mStatsGeneration;
+
+    // Counters from before a reset are treated as cleared, until their side
+    // gets around to clearing them
+    if (mProducerStats.generation == generation) {
+        stats.numPushed = mProducerStats.numPushed;
+        stats.numFull = mProducerStats.numFull;
+        stats.maxUsed = mProducerStats.maxUsed;
+    } else {
+        stats.maxUsed = GetSize();
+    }
+
+    if (mConsumerStats.generation == generation) {
+        stats.numPopped = mConsumerStats.numPopped;
+        stats.numBytes = mConsumerStats.numBytes;
+        stats.maxLatency = mConsumerStats.maxLatency;
+        stats.totalLatency = mConsumerStats.totalLatency;
+    }
+
+    stats.elapsed =
+        static_cast<u32>(OS_TICKS_TO_MSEC(OSGetTime() - mStatsResetTime));
+
+    if (stats.elapsed > 0) {
+        stats.byteRate = static_cast<u32>(static_cast<u64>(stats.numBytes) *
+                                          1000 / stats.elapsed);
+    }
+
+    return stats;
+}
+
+/**
+ * @brief Resets the ring statistics
+ * @details Each side clears its own counters the next time it runs, so the
+ * reset can't race with either of them.
+ */
+template <typename T> K_INLINE void TPacketRing<T>::ResetStats() {
+    mStatsResetTime = OSGetTime();
+    mStatsGeneration = mStatsGeneration + 1;
+}
+
+/**
+ * @brief Clears the producer counters if a reset was requested
+ */
+template <typename T> K_INLINE void TPacketRing<T>::SyncProducerStats() {
+    u32 generation = mStatsGeneration;
+    if (mProducerStats.generation == generation) {
+        return;
+    }
+
+    mProducerStats.numPushed = 0;
+    mProducerStats.numFull = 0;
+
+    // Usage reflects the current state
+    mProducerStats.maxUsed = GetSize();
+
+    mProducerStats.generation = generation;
+}
+
+/**
+ * @brief Clears the consumer counters if a reset was requested
+ */
+template <typename T> K_INLINE void TPacketRing<T>::SyncConsumerStats() {
+    u32 generation = mStatsGeneration;
+    if (mConsumerStats.generation == generation) {
+        return;
+    }
+
+    mConsumerStats.numPopped = 0;
+    mConsumerStats.numBytes = 0;
+    mConsumerStats.maxLatency = 0;
+    mConsumerStats.totalLatency = 0;
+
+    mConsumerStats.generation = generation;
+}
+
+} // namespace kiwi
+
+#endif
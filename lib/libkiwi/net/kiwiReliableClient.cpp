@@ -2,6 +2,57 @@
 
 namespace kiwi {
 
-;
+/**
+ * @brief Constructor
+ *
+ * @param rPeer Peer address
+ * @param port Local port (zero for a random port)
+ */
+ReliableClient::ReliableClient(const SockAddrAny& rPeer, u16 port)
+    : ISceneHook(-1), mpSocket(nullptr) {
+    K_ASSERT(rPeer.IsValid());
+
+    bool success = false;
+
+    if (rPeer.family == SO_AF_INET6) {
+        mpSocket = new ReliableSocket(SO_PF_INET6);
+        K_ASSERT(mpSocket != nullptr);
+
+        SockAddr6 self(port);
+        success = mpSocket->Bind(self);
+    } else {
+        mpSocket = new ReliableSocket(SO_PF_INET);
+        K_ASSERT(mpSocket != nullptr);
+
+        SockAddr4 self(port);
+        success = mpSocket->Bind(self);
+    }
+
+    K_ASSERT(success);
+
+    success = mpSocket->Connect(rPeer);
+    K_ASSERT(success);
+}
+
+/**
+ * @brief Destructor
+ */
+ReliableClient::~ReliableClient() {
+    delete mpSocket;
+    mpSocket = nullptr;
+}
+
+/**
+ * @brief Calculate callback (after game logic)
+ * @details Drives retransmissions and delayed acknowledgements
+ *
+ * @param pScene Current scene
+ */
+void ReliableClient::AfterCalculate(RPSysScene* pScene) {
+#pragma unused(pScene)
+
+    K_ASSERT(mpSocket != nullptr);
+    mpSocket->Calc();
+}
 
 } // namespace kiwi
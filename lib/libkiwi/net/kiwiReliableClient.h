@@ -1,12 +1,79 @@
 #ifndef LIBKIWI_NET_RELIABLE_CLIENT_H
 #define LIBKIWI_NET_RELIABLE_CLIENT_H
+#include <libkiwi/core/kiwiSceneHookMgr.h>
 #include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiReliableSocket.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_net
 //! @{
 
-class ReliableClient {};
+/**
+ * @brief Reliable UDP (KUDP) client
+ * @details Owns a reliable socket connected to one peer, and drives its
+ * timers once per frame through the scene hook.
+ */
+class ReliableClient : public ISceneHook, private NonCopyable {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rPeer Peer address
+     * @param port Local port (zero for a random port)
+     */
+    explicit ReliableClient(const SockAddrAny& rPeer, u16 port = 0);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~ReliableClient();
+
+    /**
+     * @brief Accesses the underlying socket
+     */
+    ReliableSocket& GetSocket() {
+        K_ASSERT(mpSocket != nullptr);
+        return *mpSocket;
+    }
+
+    /**
+     * @brief Sends a message to the peer
+     *
+     * @param pSrc Message data
+     * @param size Message size
+     * @param pCallback Callback for when the peer acknowledges the message
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    SOResult Send(const void* pSrc, u32 size,
+                  SocketBase::Callback pCallback = nullptr,
+                  void* pArg = nullptr) {
+        return GetSocket().SendMessage(pSrc, size, pCallback, pArg);
+    }
+
+    /**
+     * @brief Sets the received message callback
+     *
+     * @param pCallback Message callback
+     * @param pArg Callback user argument
+     */
+    void SetMessageCallback(ReliableSocket::MessageCallback pCallback,
+                            void* pArg = nullptr) {
+        GetSocket().SetMessageCallback(pCallback, pArg);
+    }
+
+    /**
+     * @brief Calculate callback (after game logic)
+     * @details Drives retransmissions and delayed acknowledgements
+     *
+     * @param pScene Current scene
+     */
+    virtual void AfterCalculate(RPSysScene* pScene);
+
+private:
+    ReliableSocket* mpSocket; // Connection to the peer
+};
 
 //! @}
 } // namespace kiwi
@@ -10,6 +10,9 @@ namespace kiwi {
 
 /**
  * @brief Reliable packet header
+ * @details Every packet carries the sender's receive state (ack/ackBits), so
+ * acknowledgements ride along with data. Packets without EFlags_Reliable only
+ * carry this state and don't use a sequence ID.
  * @note Concepts adapted from NEX PRUDP
  */
 struct KUDPHeader {
@@ -17,16 +20,26 @@ struct KUDPHeader {
      * @brief Constructor
      */
     KUDPHeader()
-        : magic(KUDP_MAGIC), size(0), sequence(0), fragment(0), flags(0) {}
+        : magic(KUDP_MAGIC),
+          size(0),
+          sequence(0),
+          fragment(0),
+          flags(0),
+          ack(0),
+          reserved(0),
+          ackBits(0) {}
 
     /* 0x00 */ u32 magic;    // Identification
     /* 0x04 */ u16 size;     // Message size
     /* 0x06 */ u16 sequence; // Sequence ID
     /* 0x08 */ u16 fragment; // Fragment ID
     /* 0x0A */ u16 flags;    // Status/info
+    /* 0x0C */ u16 ack;      // Next sequence ID expected by the sender
+    /* 0x0E */ u16 reserved; // Reserved for future use
+    /* 0x10 */ u32 ackBits;  // Later IDs received (bit N: ack+N+1)
 
     // Identifier string
-    static const u32 KUDP_MAGIC = 'KUv0';
+    static const u32 KUDP_MAGIC = 'KUv1';
 
     /**
      * @brief Packet flags
@@ -34,6 +47,10 @@ struct KUDPHeader {
     enum EFlags {
         // This packet is only a message fragment, and there will be more
         EFlags_MoreFragments = (1 << 0),
+        // This packet has a sequence ID and must be acknowledged
+        EFlags_Reliable = (1 << 1),
+        // This packet contains several messages, each prefixed by its size
+        EFlags_Bundle = (1 << 2),
     };
 };
 
@@ -52,14 +69,26 @@ public:
     static const u16 MAX_CONTENT_SIZE = MAX_BUFFER_SIZE - sizeof(KUDPHeader);
 
 public:
+    /**
+     * @brief Constructor
+     * @details Creates an empty packet (see Alloc/Attach)
+     */
+    ReliablePacket() {}
+
     /**
      * @brief Constructor
      *
      * @param size Packet buffer size
      * @param pAddr Packet recipient
      */
-    ReliablePacket(u32 size, const SockAddrAny* pAddr = nullptr)
-        : Packet(size, pAddr) {}
+    ReliablePacket(u32 size, const SockAddrAny* pAddr = nullptr) {
+        // Base constructor can't see the header overhead
+        Alloc(size);
+
+        if (pAddr != nullptr) {
+            SetPeer(*pAddr);
+        }
+    }
 
     /**
      * @brief Accesses KUDP protocol header
@@ -1,7 +1,1387 @@
 #include <libkiwi.h>
 
+#include <cstring>
+
 namespace kiwi {
 
-;
+/**
+ * @brief Packet/timer ownership lock
+ * @details Guards the owner pointers of packets and timers, which may
+ * outlive their socket. Take this before any transport lock.
+ */
+OSMutex ReliableSocket::sMutex;
+
+/**
+ * @brief Constructor
+ *
+ * @param family Socket protocol family
+ */
+ReliableSocket::ReliableSocket(SOProtoFamily family)
+    : AsyncSocket(family, SO_SOCK_DGRAM),
+      mIsConnected(false),
+      mStatus(SO_SUCCESS),
+      mpFreeList(nullptr),
+      mpRecvDatagram(nullptr),
+      mSendSeq(0),
+      mSendBase(0),
+      mSendQueueSize(0),
+      mRecvBase(0),
+      mNumUnacked(0),
+      mIsAckPending(false),
+      mAckTick(0),
+      mpAssembly(nullptr),
+      mAssemblySize(0),
+      mAssemblyCapacity(0),
+      mAssemblyFragment(0),
+      mHasRecvRequest(false),
+      mpMessageCallback(nullptr),
+      mpMessageCallbackArg(nullptr),
+      mIsCoalescing(false),
+      mCoalesceDelay(0),
+      mSmoothRtt(0),
+      mRttVar(0),
+      mRto(OS_MSEC_TO_TICKS(scInitialRto)),
+      mpTimer(nullptr) {
+
+    OSInitMutex(&mMutex);
+
+    std::memset(mpSendWindow, 0, sizeof(mpSendWindow));
+    std::memset(mpRecvWindow, 0, sizeof(mpRecvWindow));
+    std::memset(&mRecvRequest, 0, sizeof(RecvRequest));
+    std::memset(&mStats, 0, sizeof(Stats));
+}
+
+/**
+ * @brief Destructor
+ */
+ReliableSocket::~ReliableSocket() {
+    AutoMutexLock ownerLock(sMutex);
+    AutoMutexLock lock(mMutex);
+
+    // Timer is owned by the socket, unless the dispatcher still has it
+    if (mpTimer != nullptr) {
+        OSCancelAlarm(&mpTimer->alarm);
+
+        if (mpTimer->isQueued) {
+            mpTimer->pSocket = nullptr;
+        } else {
+            delete mpTimer;
+        }
+
+        mpTimer = nullptr;
+    }
+
+    // Packets are owned by the socket, except for those still in flight.
+    // Closing the socket aborts them, and their callbacks finish the cleanup.
+    while (!mDatagrams.Empty()) {
+        Datagram& rDatagram = mDatagrams.Front();
+        mDatagrams.PopFront();
+
+        if (rDatagram.isPosted) {
+            rDatagram.pSocket = nullptr;
+        } else {
+            delete &rDatagram;
+        }
+    }
+
+    // Pending callbacks are never invoked
+    OutMessageList* lists[] = {&mSendQueue, &mSendFlight, &mSendDone};
+    for (u32 i = 0; i < LENGTHOF(lists); i++) {
+        while (!lists[i]->Empty()) {
+            OutMessage& rMsg = lists[i]->Front();
+            lists[i]->PopFront();
+
+            delete[] rMsg.pData;
+            delete &rMsg;
+        }
+    }
+
+    while (!mRecvQueue.Empty()) {
+        InMessage& rMsg = mRecvQueue.Front();
+        mRecvQueue.PopFront();
+
+        delete[] rMsg.pData;
+        delete &rMsg;
+    }
+
+    delete[] mpAssembly;
+    mpAssembly = nullptr;
+}
+
+/**
+ * @brief Sets the peer and starts receiving
+ * @note Nothing is sent, so this completes immediately
+ *
+ * @param rAddr Remote address
+ * @param pCallback Connection callback
+ * @param pArg Callback user argument
+ * @return Success
+ */
+bool ReliableSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
+                             void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(rAddr.IsValid());
+
+    {
+        AutoMutexLock lock(mMutex);
+
+        K_ASSERT_EX(!mIsConnected, "Socket is already connected");
+
+        mPeer = rAddr;
+        mIsConnected = true;
+
+        PostRecv();
+
+        // Posting the timer needs the dispatcher, which the receive starts
+        mpTimer = new TimerRequest(this);
+        K_ASSERT(mpTimer != nullptr);
+
+        OSSetPeriodicAlarm(&mpTimer->alarm, OSGetTime(),
+                           OS_MSEC_TO_TICKS(scTimerPeriod), AlarmCallbackFunc);
+    }
+
+    if (pCallback != nullptr) {
+        pCallback(SO_SUCCESS, pArg);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Accepts a peer connection over a new socket
+ * @note Not supported by datagram sockets
+ *
+ * @param pCallback Acceptance callback
+ * @param pArg Callback user argument
+ * @return New socket
+ */
+AsyncSocket* ReliableSocket::Accept(AcceptCallback pCallback, void* pArg) {
+#pragma unused(pCallback)
+#pragma unused(pArg)
+
+    K_ASSERT_EX(false, "Datagram sockets can't accept connections");
+    return nullptr;
+}
+
+/**
+ * @brief Drives the retransmission and acknowledgement timers
+ * @note The socket's timer already does this, so it's only needed to run
+ * the timers right away
+ */
+void ReliableSocket::Calc() {
+    Completions completions;
+
+    {
+        AutoMutexLock lock(mMutex);
+
+        CalcTimers();
+        TakeCompletions(completions);
+    }
+
+    // Callbacks may destroy the socket
+    InvokeCompletions(completions);
+}
+
+/**
+ * @brief Queues a message for the peer
+ * @details Messages are copied, so unlike SendBytes the source can be in
+ * any memory region.
+ *
+ * @param pSrc Message data
+ * @param size Message size
+ * @param pCallback Callback for when the peer acknowledges the message
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult ReliableSocket::SendMessage(const void* pSrc, u32 size,
+                                     Callback pCallback, void* pArg) {
+    u32 nsend = 0;
+    return SendImpl(pSrc, size, nsend, nullptr, pCallback, pArg);
+}
+
+/**
+ * @brief Takes the next received message from the queue
+ * @details Messages are copied, so unlike RecvBytes the destination can be
+ * in any memory region.
+ *
+ * @param pDst Destination buffer
+ * @param len Buffer size
+ * @param[out] rSize Message size
+ * @return Socket library result (SO_EWOULDBLOCK if nothing was received)
+ */
+SOResult ReliableSocket::RecvMessage(void* pDst, u32 len, u32& rSize) {
+    return RecvImpl(pDst, len, rSize, nullptr, nullptr, nullptr);
+}
+
+/**
+ * @brief Sets the received message callback
+ * @details Messages are polled through Recv when no callback is set
+ *
+ * @param pCallback Message callback
+ * @param pArg Callback user argument
+ */
+void ReliableSocket::SetMessageCallback(MessageCallback pCallback,
+                                        void* pArg) {
+    Completions completions;
+
+    {
+        AutoMutexLock lock(mMutex);
+
+        mpMessageCallback = pCallback;
+        mpMessageCallbackArg = pArg;
+
+        // Hand over messages which were already queued
+        TakeCompletions(completions);
+    }
+
+    // Callbacks may destroy the socket
+    InvokeCompletions(completions);
+}
+
+/**
+ * @brief Toggles coalescing of small messages (Nagle's algorithm)
+ * @details While data is unacknowledged, small messages are held until
+ * they fill a packet or the delay expires.
+ *
+ * @param enable Whether to enable coalescing
+ * @param delay Longest time to hold a message (in milliseconds)
+ */
+void ReliableSocket::SetCoalescing(bool enable, u32 delay) {
+    AutoMutexLock lock(mMutex);
+
+    mIsCoalescing = enable;
+    mCoalesceDelay = OS_MSEC_TO_TICKS(delay);
+}
+
+/**
+ * @brief Tests whether all sent messages have been acknowledged
+ */
+bool ReliableSocket::IsIdle() const {
+    AutoMutexLock lock(mMutex);
+    return mSendQueue.Empty() && mSendSeq == mSendBase;
+}
+
+/**
+ * @brief Gets the transport statistics
+ */
+ReliableSocket::Stats ReliableSocket::GetStats() const {
+    AutoMutexLock lock(mMutex);
+
+    Stats stats = mStats;
+    stats.smoothRtt = mSmoothRtt;
+    stats.rto = mRto;
+
+    return stats;
+}
+
+/**
+ * @brief Resets the transport statistics
+ * @note Timing estimates are not reset, as they reflect the current state
+ */
+void ReliableSocket::ResetStats() {
+    AutoMutexLock lock(mMutex);
+    std::memset(&mStats, 0, sizeof(Stats));
+}
+
+/**
+ * @brief Receive completion callback
+ *
+ * @param result Bytes received or IOS error code
+ * @param pArg Received packet
+ */
+void ReliableSocket::RecvCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the packet
+    Datagram* pDatagram = static_cast<Datagram*>(pArg);
+
+    OSLockMutex(&sMutex);
+
+    // Socket was destroyed while the packet was in flight
+    ReliableSocket* pSocket = pDatagram->pSocket;
+    if (pSocket == nullptr) {
+        pDatagram->isPosted = false;
+        OSUnlockMutex(&sMutex);
+        delete pDatagram;
+        return;
+    }
+
+    Completions completions;
+
+    {
+        // Socket can't be destroyed once its transport lock is held
+        AutoMutexLock lock(pSocket->mMutex);
+        OSUnlockMutex(&sMutex);
+
+        pDatagram->isPosted = false;
+
+        K_ASSERT(pSocket->mpRecvDatagram == pDatagram);
+        pSocket->mpRecvDatagram = nullptr;
+
+        if (result < 0) {
+            // Socket can't receive anymore
+            pSocket->FreeDatagram(pDatagram);
+            pSocket->Fail(static_cast<SOResult>(result));
+        } else {
+            if (!pSocket->HandleDatagram(pDatagram, result, OSGetTick())) {
+                pSocket->FreeDatagram(pDatagram);
+            }
+
+            pSocket->PostRecv();
+        }
+
+        pSocket->TakeCompletions(completions);
+    }
+
+    // Callbacks may destroy the socket
+    InvokeCompletions(completions);
+}
+
+/**
+ * @brief Send completion callback
+ *
+ * @param result Bytes sent or IOS error code
+ * @param pArg Sent packet
+ */
+void ReliableSocket::SendCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the packet
+    Datagram* pDatagram = static_cast<Datagram*>(pArg);
+
+    OSLockMutex(&sMutex);
+
+    // Socket was destroyed while the packet was in flight
+    ReliableSocket* pSocket = pDatagram->pSocket;
+    if (pSocket == nullptr) {
+        pDatagram->isPosted = false;
+        OSUnlockMutex(&sMutex);
+        delete pDatagram;
+        return;
+    }
+
+    // Socket can't be destroyed once its transport lock is held
+    AutoMutexLock lock(pSocket->mMutex);
+    OSUnlockMutex(&sMutex);
+
+    pDatagram->isPosted = false;
+
+    // Lost packets are recovered by retransmission
+    K_WARN_EX(result < 0, "KUDP send failed (%d)\n", result);
+
+    // Packet was released while IOS was still using it
+    if (pDatagram->isReleased) {
+        pSocket->FreeDatagram(pDatagram);
+    }
+}
+
+/**
+ * @brief Handles the timer period
+ * @note Called from the dispatcher thread
+ *
+ * @param result IOS result code
+ */
+void ReliableSocket::TimerRequest::OnComplete(s32 result) {
+#pragma unused(result)
+
+    OSLockMutex(&sMutex);
+
+    // Alarm can post the timer again from here on
+    isQueued = false;
+
+    // Socket was destroyed while the timer was queued
+    ReliableSocket* pOwner = pSocket;
+    if (pOwner == nullptr) {
+        OSUnlockMutex(&sMutex);
+        delete this;
+        return;
+    }
+
+    Completions completions;
+
+    {
+        // Socket can't be destroyed once its transport lock is held
+        AutoMutexLock lock(pOwner->mMutex);
+        OSUnlockMutex(&sMutex);
+
+        pOwner->CalcTimers();
+        pOwner->TakeCompletions(completions);
+    }
+
+    // Callbacks may destroy the socket (and this timer)
+    InvokeCompletions(completions);
+}
+
+/**
+ * @brief Timer alarm handler
+ * @note Called from interrupt context
+ *
+ * @param pAlarm Timer alarm
+ * @param pCtx Interrupted thread context
+ */
+void ReliableSocket::AlarmCallbackFunc(OSAlarm* pAlarm, OSContext* pCtx) {
+#pragma unused(pCtx)
+
+    K_ASSERT(pAlarm != nullptr);
+
+    TimerRequest* pTimer =
+        static_cast<TimerRequest*>(OSGetAlarmUserData(pAlarm));
+    K_ASSERT(pTimer != nullptr);
+
+    // Dispatcher hasn't caught up with the last period yet
+    if (pTimer->isQueued) {
+        return;
+    }
+
+    if (IosDispatcher::Post(*pTimer)) {
+        pTimer->isQueued = true;
+    }
+}
+
+/**
+ * @brief Runs the retransmission and acknowledgement timers
+ * @note The transport lock must be held
+ */
+void ReliableSocket::CalcTimers() {
+    if (!mIsConnected || mStatus != SO_SUCCESS) {
+        return;
+    }
+
+    u32 now = OSGetTick();
+
+    Retransmit(now);
+
+    // Coalesced messages may have waited long enough
+    Packetize(now);
+
+    // Held ACK couldn't be piggybacked in time
+    if (mIsAckPending && now - mAckTick >= OS_MSEC_TO_TICKS(scAckDelay)) {
+        SendAck();
+    }
+}
+
+/**
+ * @brief Gets a packet buffer from the free list
+ */
+ReliableSocket::Datagram* ReliableSocket::AllocDatagram() {
+    Datagram* pDatagram = mpFreeList;
+
+    if (pDatagram != nullptr) {
+        mpFreeList = pDatagram->pNextFree;
+    } else {
+        // Packet buffers are passed straight to IOS
+        pDatagram = new (32, EMemory_MEM2) Datagram();
+        K_ASSERT(pDatagram != nullptr);
+
+        pDatagram->pSocket = this;
+        mDatagrams.PushBack(pDatagram);
+    }
+
+    pDatagram->size = 0;
+    pDatagram->sendTick = 0;
+    pDatagram->numSends = 0;
+    pDatagram->isPosted = false;
+    pDatagram->isReleased = false;
+    pDatagram->pNextFree = nullptr;
+
+    return pDatagram;
+}
+
+/**
+ * @brief Returns a packet buffer to the free list
+ * @note Posted packets are recycled once their ioctl completes
+ *
+ * @param pDatagram Packet buffer
+ */
+void ReliableSocket::FreeDatagram(Datagram* pDatagram) {
+    K_ASSERT(pDatagram != nullptr);
+
+    // IOS is still reading from the buffer
+    if (pDatagram->isPosted) {
+        pDatagram->isReleased = true;
+        return;
+    }
+
+    pDatagram->pNextFree = mpFreeList;
+    mpFreeList = pDatagram;
+}
+
+/**
+ * @brief Submits a receive request for the next packet
+ */
+void ReliableSocket::PostRecv() {
+    K_ASSERT(mpRecvDatagram == nullptr);
+
+    mpRecvDatagram = AllocDatagram();
+
+    // Address type hints to IOS which family to expect
+    if (mFamily == SO_PF_INET6) {
+        mpRecvDatagram->peer = SockAddr6();
+    } else {
+        mpRecvDatagram->peer = SockAddr4();
+    }
+
+    mpRecvDatagram->isPosted = true;
+
+    LibSO::RecvAsync(mHandle, mpRecvDatagram->data,
+                     sizeof(mpRecvDatagram->data), 0, &mpRecvDatagram->peer,
+                     RecvCallbackFunc, mpRecvDatagram);
+}
+
+/**
+ * @brief Submits a packet to IOS, with the latest acknowledgements
+ *
+ * @param rDatagram Packet to send
+ * @return Success (fails if the packet is still in flight)
+ */
+bool ReliableSocket::Transmit(Datagram& rDatagram) {
+    // Buffer can't be rewritten while IOS is reading it
+    if (rDatagram.isPosted) {
+        return false;
+    }
+
+    KUDPHeader& rHeader = rDatagram.GetHeader();
+
+    // Piggyback the latest receive state
+    rHeader.ack = mRecvBase;
+    rHeader.ackBits = 0;
+
+    for (u32 i = 0; i < WINDOW_SIZE - 1; i++) {
+        if (mpRecvWindow[ToSlot(mRecvBase + i + 1)] != nullptr) {
+            rHeader.ackBits |= 1 << i;
+        }
+    }
+
+    // Any packet counts as an ACK
+    mNumUnacked = 0;
+    mIsAckPending = false;
+
+    rDatagram.sendTick = OSGetTick();
+    rDatagram.numSends++;
+    rDatagram.isPosted = true;
+
+    mStats.numSent++;
+
+    LibSO::SendAsync(mHandle, rDatagram.data, rDatagram.size, 0, &mPeer,
+                     SendCallbackFunc, &rDatagram);
+
+    return true;
+}
+
+/**
+ * @brief Sends a packet containing only acknowledgements
+ */
+void ReliableSocket::SendAck() {
+    Datagram* pDatagram = AllocDatagram();
+
+    pDatagram->GetHeader() = KUDPHeader();
+    pDatagram->size = sizeof(KUDPHeader);
+
+    Transmit(*pDatagram);
+    mStats.numAckOnly++;
+
+    // Recycled once IOS is done with it
+    FreeDatagram(pDatagram);
+}
+
+/**
+ * @brief Copies queued messages into new packets while the window allows
+ *
+ * @param now Current time
+ */
+void ReliableSocket::Packetize(u32 now) {
+    if (!mIsConnected || mStatus != SO_SUCCESS) {
+        return;
+    }
+
+    while (!mSendQueue.Empty() &&
+           static_cast<u16>(mSendSeq - mSendBase) < WINDOW_SIZE) {
+
+        OutMessage& rFront = mSendQueue.Front();
+
+        // Whole message fits in a bundle with its size prefix
+        bool isSmall =
+            rFront.offset == 0 &&
+            sizeof(u16) + rFront.size <= ReliablePacket::MAX_CONTENT_SIZE;
+
+        bool isBundle = mIsCoalescing && isSmall;
+
+        // Nagle's algorithm: while earlier data is unacknowledged, wait for
+        // enough small messages to fill a packet
+        if (isBundle && mSendSeq != mSendBase &&
+            mSendQueueSize < ReliablePacket::MAX_CONTENT_SIZE &&
+            now - rFront.queueTick < mCoalesceDelay) {
+            break;
+        }
+
+        Datagram* pDatagram = AllocDatagram();
+        u8* pContent = pDatagram->GetContent();
+
+        KUDPHeader& rHeader = pDatagram->GetHeader();
+        rHeader = KUDPHeader();
+        rHeader.sequence = mSendSeq;
+        rHeader.flags = KUDPHeader::EFlags_Reliable;
+
+        if (isBundle) {
+            rHeader.flags |= KUDPHeader::EFlags_Bundle;
+            u32 numMessages = 0;
+
+            // Fill the packet with whole messages
+            while (!mSendQueue.Empty()) {
+                OutMessage& rMsg = mSendQueue.Front();
+
+                if (rMsg.offset != 0 ||
+                    rHeader.size + sizeof(u16) + rMsg.size >
+                        ReliablePacket::MAX_CONTENT_SIZE) {
+                    break;
+                }
+
+                // Size prefix is big endian
+                pContent[rHeader.size++] = static_cast<u8>(rMsg.size >> 8);
+                pContent[rHeader.size++] = static_cast<u8>(rMsg.size >> 0);
+
+                std::memcpy(pContent + rHeader.size, rMsg.pData, rMsg.size);
+                rHeader.size += rMsg.size;
+                mSendQueueSize -= rMsg.size;
+
+                // Data now lives in the packet
+                delete[] rMsg.pData;
+                rMsg.pData = nullptr;
+
+                rMsg.lastSeq = mSendSeq;
+                mSendQueue.PopFront();
+                mSendFlight.PushBack(&rMsg);
+
+                numMessages++;
+            }
+
+            if (numMessages > 1) {
+                mStats.numCoalesced += numMessages;
+            }
+        } else {
+            u32 size = Min<u32>(rFront.size - rFront.offset,
+                                ReliablePacket::MAX_CONTENT_SIZE);
+
+            std::memcpy(pContent, rFront.pData + rFront.offset, size);
+            rHeader.size = size;
+            rHeader.fragment = rFront.fragment++;
+
+            rFront.offset += size;
+            mSendQueueSize -= size;
+
+            if (rFront.offset < rFront.size) {
+                rHeader.flags |= KUDPHeader::EFlags_MoreFragments;
+            } else {
+                if (rFront.fragment > 1) {
+                    mStats.numFragmented++;
+                }
+
+                // Data now lives in the packets
+                delete[] rFront.pData;
+                rFront.pData = nullptr;
+
+                rFront.lastSeq = mSendSeq;
+                mSendQueue.PopFront();
+                mSendFlight.PushBack(&rFront);
+            }
+        }
+
+        pDatagram->size = sizeof(KUDPHeader) + rHeader.size;
+
+        mpSendWindow[ToSlot(mSendSeq)] = pDatagram;
+        mSendSeq++;
+
+        Transmit(*pDatagram);
+    }
+}
+
+/**
+ * @brief Retransmits packets whose timeout has expired
+ *
+ * @param now Current time
+ */
+void ReliableSocket::Retransmit(u32 now) {
+    bool isTimeout = false;
+
+    for (u16 seq = mSendBase; seq != mSendSeq; seq++) {
+        Datagram* pDatagram = mpSendWindow[ToSlot(seq)];
+
+        // Already selectively acknowledged
+        if (pDatagram == nullptr || now - pDatagram->sendTick < mRto) {
+            continue;
+        }
+
+        // Peer has stopped responding
+        if (pDatagram->numSends >= scMaxSends) {
+            Fail(SO_ETIMEDOUT);
+            return;
+        }
+
+        if (Transmit(*pDatagram)) {
+            mStats.numRetransmits++;
+            isTimeout = true;
+        }
+    }
+
+    // Back off while packets keep getting lost
+    if (isTimeout) {
+        mRto = Min<u32>(mRto * 2, OS_MSEC_TO_TICKS(scMaxRto));
+    }
+}
+
+/**
+ * @brief Handles the peer's acknowledgements
+ *
+ * @param ack Next sequence ID expected by the peer
+ * @param ackBits Sequence IDs received by the peer after ack
+ * @param now Current time
+ */
+void ReliableSocket::HandleAck(u16 ack, u32 ackBits, u32 now) {
+    u16 numInFlight = mSendSeq - mSendBase;
+
+    // Stale or bogus acknowledgement
+    if (static_cast<u16>(ack - mSendBase) > numInFlight) {
+        return;
+    }
+
+    // Everything before the ACK has been received
+    for (; mSendBase != ack; mSendBase++) {
+        ReleaseSeq(mSendBase, now);
+    }
+
+    numInFlight = mSendSeq - mSendBase;
+
+    // Selective acknowledgements
+    for (u32 i = 0; i < WINDOW_SIZE - 1 && i + 1 < numInFlight; i++) {
+        if (ackBits & (1 << i)) {
+            ReleaseSeq(ack + i + 1, now);
+        }
+    }
+
+    // Packets are likely lost once enough later ones have arrived. Go from
+    // newest to oldest to count how many later packets were received.
+    u32 numLater = 0;
+
+    for (s32 i = Min<s32>(WINDOW_SIZE - 1, numInFlight) - 1; i >= 0; i--) {
+        // The first packet (i = 0) is the one at the ACK
+        if (i > 0 && (ackBits & (1 << (i - 1)))) {
+            numLater++;
+            continue;
+        }
+
+        Datagram* pDatagram = mpSendWindow[ToSlot(ack + i)];
+        if (pDatagram == nullptr || numLater < scFastResendThreshold) {
+            continue;
+        }
+
+        // Only resend early once, afterwards the timeout takes over. Packets
+        // which are merely reordered should arrive within one RTT.
+        if (pDatagram->numSends > 1 ||
+            now - pDatagram->sendTick < mSmoothRtt + mRttVar) {
+            continue;
+        }
+
+        if (Transmit(*pDatagram)) {
+            mStats.numFastResends++;
+        }
+    }
+
+    // Messages are complete once all their packets are acknowledged
+    while (!mSendFlight.Empty()) {
+        OutMessage& rMsg = mSendFlight.Front();
+
+        if (static_cast<s16>(rMsg.lastSeq - mSendBase) >= 0) {
+            break;
+        }
+
+        mSendFlight.PopFront();
+
+        rMsg.result = SO_SUCCESS;
+        mSendDone.PushBack(&rMsg);
+    }
+
+    // Window may have opened up
+    Packetize(now);
+}
+
+/**
+ * @brief Releases an acknowledged packet from the send window
+ *
+ * @param seq Sequence ID
+ * @param now Current time
+ */
+void ReliableSocket::ReleaseSeq(u16 seq, u32 now) {
+    u32 slot = ToSlot(seq);
+    Datagram* pDatagram = mpSendWindow[slot];
+
+    // Already selectively acknowledged
+    if (pDatagram == nullptr) {
+        return;
+    }
+
+    // Karn's algorithm: ACKs for retransmitted packets are ambiguous
+    if (pDatagram->numSends == 1) {
+        UpdateRtt(now - pDatagram->sendTick);
+    }
+
+    mpSendWindow[slot] = nullptr;
+    FreeDatagram(pDatagram);
+}
+
+/**
+ * @brief Updates the retransmission timeout with a new RTT sample
+ *
+ * @param sample Round-trip time (ticks)
+ */
+void ReliableSocket::UpdateRtt(u32 sample) {
+    u32 minRto = OS_MSEC_TO_TICKS(scMinRto);
+    u32 maxRto = OS_MSEC_TO_TICKS(scMaxRto);
+
+    // Very late ACKs shouldn't overflow the estimate
+    sample = Clamp<u32>(sample, 1, maxRto);
+
+    // First sample (RFC 6298)
+    if (mSmoothRtt == 0) {
+        mSmoothRtt = sample;
+        mRttVar = sample / 2;
+    } else {
+        u32 error =
+            sample > mSmoothRtt ? sample - mSmoothRtt : mSmoothRtt - sample;
+
+        mRttVar = (3 * mRttVar + error) / 4;
+        mSmoothRtt = (7 * mSmoothRtt + sample) / 8;
+    }
+
+    mRto = Clamp<u32>(mSmoothRtt + 4 * mRttVar, minRto, maxRto);
+}
+
+/**
+ * @brief Handles a received packet
+ *
+ * @param pDatagram Packet buffer
+ * @param size Packet size
+ * @param now Current time
+ * @return Whether the packet is kept in the receive window
+ */
+bool ReliableSocket::HandleDatagram(Datagram* pDatagram, u32 size, u32 now) {
+    K_ASSERT(pDatagram != nullptr);
+
+    KUDPHeader& rHeader = pDatagram->GetHeader();
+
+    // Only the peer may talk to this socket
+    if (!mIsConnected || !IsPeerAddr(pDatagram->peer)) {
+        mStats.numInvalid++;
+        return false;
+    }
+
+    // Malformed packet
+    if (size < sizeof(KUDPHeader) ||
+        rHeader.magic != KUDPHeader::KUDP_MAGIC ||
+        rHeader.size != size - sizeof(KUDPHeader)) {
+        mStats.numInvalid++;
+        return false;
+    }
+
+    mStats.numRecv++;
+
+    HandleAck(rHeader.ack, rHeader.ackBits, now);
+
+    // Packet only carries acknowledgements
+    if (!(rHeader.flags & KUDPHeader::EFlags_Reliable)) {
+        return false;
+    }
+
+    // Distance from the next packet to deliver
+    u16 dist = rHeader.sequence - mRecvBase;
+
+    if (dist >= WINDOW_SIZE) {
+        // Peer must have missed our ACK, so repeat it right away
+        if (static_cast<s16>(dist) < 0) {
+            mStats.numDuplicates++;
+            SendAck();
+        } else {
+            mStats.numInvalid++;
+        }
+
+        return false;
+    }
+
+    u32 slot = ToSlot(rHeader.sequence);
+
+    if (mpRecvWindow[slot] != nullptr) {
+        mStats.numDuplicates++;
+        SendAck();
+        return false;
+    }
+
+    mpRecvWindow[slot] = pDatagram;
+
+    // Deliver everything which is now in order
+    u32 numDelivered = 0;
+
+    while (mpRecvWindow[ToSlot(mRecvBase)] != nullptr) {
+        Datagram* pNext = mpRecvWindow[ToSlot(mRecvBase)];
+        mpRecvWindow[ToSlot(mRecvBase)] = nullptr;
+        mRecvBase++;
+
+        Deliver(*pNext);
+        FreeDatagram(pNext);
+
+        numDelivered++;
+    }
+
+    mNumUnacked++;
+
+    // Gaps (and filled gaps) are reported immediately so the peer can resend
+    // quickly, otherwise ACKs are batched
+    if (dist != 0 || numDelivered > 1 || mNumUnacked >= scAckBatch) {
+        SendAck();
+    } else if (!mIsAckPending) {
+        mIsAckPending = true;
+        mAckTick = now;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Extracts messages from the next in-order packet
+ *
+ * @param rDatagram Packet buffer
+ */
+void ReliableSocket::Deliver(Datagram& rDatagram) {
+    const KUDPHeader& rHeader = rDatagram.GetHeader();
+    const u8* pContent = rDatagram.GetContent();
+
+    // Several whole messages, each prefixed by its size
+    if (rHeader.flags & KUDPHeader::EFlags_Bundle) {
+        for (u32 offset = 0; offset + sizeof(u16) <= rHeader.size;) {
+            u32 size = pContent[offset + 0] << 8 | pContent[offset + 1];
+            offset += sizeof(u16);
+
+            if (offset + size > rHeader.size) {
+                K_LOG("Malformed KUDP bundle\n");
+                mStats.numInvalid++;
+                break;
+            }
+
+            QueueMessage(pContent + offset, size);
+            offset += size;
+        }
+
+        return;
+    }
+
+    bool isLast = !(rHeader.flags & KUDPHeader::EFlags_MoreFragments);
+
+    // Unfragmented messages don't need to be reassembled
+    if (rHeader.fragment == 0 && isLast) {
+        QueueMessage(pContent, rHeader.size);
+        return;
+    }
+
+    // Packets are delivered in order, so fragments should be too
+    if (rHeader.fragment == 0) {
+        mAssemblySize = 0;
+        mAssemblyFragment = 0;
+    } else if (rHeader.fragment != mAssemblyFragment) {
+        K_LOG("Unexpected KUDP fragment\n");
+        mStats.numInvalid++;
+        return;
+    }
+
+    u32 required = mAssemblySize + rHeader.size;
+
+    if (required > MAX_MESSAGE_SIZE) {
+        K_LOG("KUDP message is too large\n");
+        mStats.numInvalid++;
+
+        mAssemblySize = 0;
+        mAssemblyFragment = 0;
+        return;
+    }
+
+    // Grow geometrically to avoid copying every fragment
+    if (required > mAssemblyCapacity) {
+        u32 capacity = Max<u32>(required, mAssemblyCapacity * 2);
+        if (capacity > MAX_MESSAGE_SIZE) {
+            capacity = MAX_MESSAGE_SIZE;
+        }
+
+        u8* pAssembly = new u8[capacity];
+        K_ASSERT(pAssembly != nullptr);
+
+        if (mpAssembly != nullptr) {
+            std::memcpy(pAssembly, mpAssembly, mAssemblySize);
+            delete[] mpAssembly;
+        }
+
+        mpAssembly = pAssembly;
+        mAssemblyCapacity = capacity;
+    }
+
+    std::memcpy(mpAssembly + mAssemblySize, pContent, rHeader.size);
+    mAssemblySize += rHeader.size;
+    mAssemblyFragment++;
+
+    if (isLast) {
+        QueueMessage(mpAssembly, mAssemblySize);
+
+        mAssemblySize = 0;
+        mAssemblyFragment = 0;
+    }
+}
+
+/**
+ * @brief Queues a received message for the user
+ *
+ * @param pData Message data
+ * @param size Message size
+ */
+void ReliableSocket::QueueMessage(const void* pData, u32 size) {
+    InMessage* pMsg = new InMessage();
+    K_ASSERT(pMsg != nullptr);
+
+    pMsg->pData = new u8[size];
+    K_ASSERT(pMsg->pData != nullptr);
+
+    std::memcpy(pMsg->pData, pData, size);
+    pMsg->size = size;
+
+    mRecvQueue.PushBack(pMsg);
+}
+
+/**
+ * @brief Fails all pending messages after the peer stops responding
+ *
+ * @param result Socket library result
+ */
+void ReliableSocket::Fail(SOResult result) {
+    // Keep the original error
+    if (mStatus != SO_SUCCESS) {
+        return;
+    }
+
+    K_LOG_EX("KUDP transport failed (%d)\n", result);
+    mStatus = result;
+
+    for (; mSendBase != mSendSeq; mSendBase++) {
+        u32 slot = ToSlot(mSendBase);
+
+        if (mpSendWindow[slot] != nullptr) {
+            FreeDatagram(mpSendWindow[slot]);
+            mpSendWindow[slot] = nullptr;
+        }
+    }
+
+    OutMessageList* lists[] = {&mSendFlight, &mSendQueue};
+    for (u32 i = 0; i < LENGTHOF(lists); i++) {
+        while (!lists[i]->Empty()) {
+            OutMessage& rMsg = lists[i]->Front();
+            lists[i]->PopFront();
+
+            rMsg.result = result;
+            mSendDone.PushBack(&rMsg);
+        }
+    }
+
+    mSendQueueSize = 0;
+}
+
+/**
+ * @brief Collects pending user callbacks
+ *
+ * @param[out] rCompletions Callback list
+ */
+void ReliableSocket::TakeCompletions(Completions& rCompletions) {
+    while (!mSendDone.Empty()) {
+        OutMessage& rMsg = mSendDone.Front();
+        mSendDone.PopFront();
+        rCompletions.sent.PushBack(&rMsg);
+    }
+
+    // Messages go to the callback if there is one
+    if (mpMessageCallback != nullptr) {
+        rCompletions.pMessageCallback = mpMessageCallback;
+        rCompletions.pMessageCallbackArg = mpMessageCallbackArg;
+
+        while (!mRecvQueue.Empty()) {
+            InMessage& rMsg = mRecvQueue.Front();
+            mRecvQueue.PopFront();
+            rCompletions.received.PushBack(&rMsg);
+        }
+
+        return;
+    }
+
+    if (!mHasRecvRequest) {
+        return;
+    }
+
+    if (!mRecvQueue.Empty()) {
+        InMessage& rMsg = mRecvQueue.Front();
+        mRecvQueue.PopFront();
+
+        std::memcpy(mRecvRequest.pDst, rMsg.pData,
+                    Min(mRecvRequest.len, rMsg.size));
+
+        if (mRecvRequest.pAddr != nullptr) {
+            *mRecvRequest.pAddr = mPeer;
+        }
+
+        rCompletions.recvResult =
+            rMsg.size > mRecvRequest.len ? SO_EMSGSIZE : SO_SUCCESS;
+
+        delete[] rMsg.pData;
+        delete &rMsg;
+    } else if (mStatus != SO_SUCCESS) {
+        rCompletions.recvResult = mStatus;
+    } else {
+        return;
+    }
+
+    rCompletions.recvRequest = mRecvRequest;
+    rCompletions.hasRecvRequest = true;
+
+    mHasRecvRequest = false;
+}
+
+/**
+ * @brief Invokes the collected user callbacks
+ * @note Must be called without the transport lock, as the callbacks may
+ * destroy the socket
+ *
+ * @param rCompletions Callback list
+ */
+void ReliableSocket::InvokeCompletions(Completions& rCompletions) {
+    while (!rCompletions.sent.Empty()) {
+        OutMessage& rMsg = rCompletions.sent.Front();
+        rCompletions.sent.PopFront();
+
+        if (rMsg.pCallback != nullptr) {
+            rMsg.pCallback(rMsg.result, rMsg.pArg);
+        }
+
+        delete[] rMsg.pData;
+        delete &rMsg;
+    }
+
+    while (!rCompletions.received.Empty()) {
+        InMessage& rMsg = rCompletions.received.Front();
+        rCompletions.received.PopFront();
+
+        rCompletions.pMessageCallback(rMsg.pData, rMsg.size,
+                                      rCompletions.pMessageCallbackArg);
+
+        delete[] rMsg.pData;
+        delete &rMsg;
+    }
+
+    if (rCompletions.hasRecvRequest &&
+        rCompletions.recvRequest.pCallback != nullptr) {
+        rCompletions.recvRequest.pCallback(rCompletions.recvResult,
+                                           rCompletions.recvRequest.pArg);
+    }
+}
+
+/**
+ * @brief Tests whether an address belongs to the peer
+ *
+ * @param rAddr Socket address
+ */
+bool ReliableSocket::IsPeerAddr(const SockAddrAny& rAddr) const {
+    if (rAddr.family != mPeer.family || rAddr.port != mPeer.port) {
+        return false;
+    }
+
+    if (rAddr.family == SO_AF_INET6) {
+        return std::memcmp(&rAddr.in6.addr, &mPeer.in6.addr,
+                           sizeof(SOInAddr6)) == 0;
+    }
+
+    return std::memcmp(&rAddr.in.addr, &mPeer.in.addr, sizeof(SOInAddr)) == 0;
+}
+
+/**
+ * @brief Receives data and records sender address (internal implementation)
+ *
+ * @param pDst Destination buffer
+ * @param len Buffer size
+ * @param[out] rRecv Number of bytes received
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult ReliableSocket::RecvImpl(void* pDst, u32 len, u32& rRecv,
+                                  SockAddrAny* pAddr, Callback pCallback,
+                                  void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pDst != nullptr);
+    K_ASSERT(len > 0);
+
+    rRecv = 0;
+    SOResult result;
+
+    {
+        AutoMutexLock lock(mMutex);
+
+        K_ASSERT_EX(mpMessageCallback == nullptr,
+                    "Messages are handled by the message callback");
+
+        if (!mRecvQueue.Empty()) {
+            InMessage& rMsg = mRecvQueue.Front();
+            mRecvQueue.PopFront();
+
+            rRecv = Min(len, rMsg.size);
+            std::memcpy(pDst, rMsg.pData, rRecv);
+
+            if (pAddr != nullptr) {
+                *pAddr = mPeer;
+            }
+
+            // Messages are never split between reads
+            result = rMsg.size > len ? SO_EMSGSIZE : SO_SUCCESS;
+
+            delete[] rMsg.pData;
+            delete &rMsg;
+        } else if (mStatus != SO_SUCCESS) {
+            result = mStatus;
+        } else {
+            // Completes once the next message arrives
+            if (pCallback != nullptr) {
+                K_ASSERT_EX(!mHasRecvRequest,
+                            "Only one receive can be outstanding");
+
+                mRecvRequest.pDst = pDst;
+                mRecvRequest.len = len;
+                mRecvRequest.pAddr = pAddr;
+                mRecvRequest.pCallback = pCallback;
+                mRecvRequest.pArg = pArg;
+
+                mHasRecvRequest = true;
+            }
+
+            return SO_EWOULDBLOCK;
+        }
+    }
+
+    if (pCallback != nullptr) {
+        pCallback(result, pArg);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Sends data to specified connection (internal implementation)
+ *
+ * @param pSrc Source buffer
+ * @param len Buffer size
+ * @param[out] rSend Number of bytes sent
+ * @param pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult ReliableSocket::SendImpl(const void* pSrc, u32 len, u32& rSend,
+                                  const SockAddrAny* pAddr, Callback pCallback,
+                                  void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSrc != nullptr);
+    K_ASSERT(len > 0);
+
+    rSend = 0;
+    SOResult result;
+
+    {
+        AutoMutexLock lock(mMutex);
+
+        K_ASSERT_EX(mIsConnected, "Please call Connect first");
+        K_ASSERT_EX(pAddr == nullptr || IsPeerAddr(*pAddr),
+                    "Reliable sockets only talk to their peer");
+
+        if (mStatus != SO_SUCCESS) {
+            result = mStatus;
+        } else if (len > MAX_MESSAGE_SIZE) {
+            result = SO_EMSGSIZE;
+        } else {
+            OutMessage* pMsg = new OutMessage();
+            K_ASSERT(pMsg != nullptr);
+
+            // Caller's buffer doesn't need to outlive this call
+            pMsg->pData = new u8[len];
+            K_ASSERT(pMsg->pData != nullptr);
+            std::memcpy(pMsg->pData, pSrc, len);
+
+            pMsg->size = len;
+            pMsg->offset = 0;
+            pMsg->fragment = 0;
+            pMsg->lastSeq = 0;
+            pMsg->queueTick = OSGetTick();
+            pMsg->result = SO_SUCCESS;
+            pMsg->pCallback = pCallback;
+            pMsg->pArg = pArg;
+
+            mSendQueue.PushBack(pMsg);
+            mSendQueueSize += len;
+
+            // Sends immediately if the window allows it
+            Packetize(pMsg->queueTick);
+
+            // Callback is invoked once the peer acknowledges the message
+            rSend = len;
+            return SO_SUCCESS;
+        }
+    }
+
+    if (pCallback != nullptr) {
+        pCallback(result, pArg);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Receives data into several buffers and records sender address
+ * (internal implementation)
+ * @details Messages are received whole and then split up
+ *
+ * @param pSegments Destination segments
+ * @param num Number of segments
+ * @param[out] rRecv Number of bytes received
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult ReliableSocket::RecvVImpl(const SockSegment* pSegments, u32 num,
+                                   u32& rRecv, SockAddrAny* pAddr,
+                                   Callback pCallback, void* pArg) {
+    // Packet-level receives would bypass the message protocol
+    return SocketBase::RecvVImpl(pSegments, num, rRecv, pAddr, pCallback,
+                                 pArg);
+}
+
+/**
+ * @brief Sends data from several buffers to specified connection
+ * (internal implementation)
+ * @details Segments are gathered into one message
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param[out] rSend Number of bytes sent
+ * @param pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult ReliableSocket::SendVImpl(const SockSegment* pSegments, u32 num,
+                                   u32& rSend, const SockAddrAny* pAddr,
+                                   Callback pCallback, void* pArg) {
+    // Packet-level sends would bypass the message protocol
+    return SocketBase::SendVImpl(pSegments, num, rSend, pAddr, pCallback,
+                                 pArg);
+}
 
 } // namespace kiwi
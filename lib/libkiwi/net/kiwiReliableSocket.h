@@ -2,12 +2,604 @@
 #define LIBKIWI_NET_RELIABLE_SOCKET_H
 #include <libkiwi/k_types.h>
 #include <libkiwi/net/kiwiAsyncSocket.h>
+#include <libkiwi/net/kiwiReliablePacket.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
+#include <libkiwi/util/kiwiIosDispatcher.h>
+#include <revolution/OS.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_net
 //! @{
 
-class ReliableSocket : public AsyncSocket {};
+/**
+ * @brief Reliable UDP (KUDP) socket
+ * @details Messages are delivered in order and exactly once. Each packet is
+ * sequenced and kept in a sliding window until the peer acknowledges it.
+ * Acknowledgements are selective, batched, and piggybacked on outgoing data.
+ * Lost packets are retransmitted on a timeout estimated from the round-trip
+ * time, or sooner when later packets are acknowledged. Messages larger than
+ * one packet are fragmented, and small messages can be coalesced.
+ *
+ * Bind the socket, then call Connect with the peer address. Received messages
+ * are handed to the message callback, or can be polled with RecvMessage.
+ *
+ * Once connected, retransmissions, delayed acknowledgements and coalesced
+ * messages are driven by a periodic alarm, which runs them on the IOS
+ * dispatcher thread. This is much finer than the game's frame rate.
+ *
+ * @note Each socket talks to a single peer
+ */
+class ReliableSocket : public AsyncSocket {
+    struct TimerRequest;
+    friend struct TimerRequest;
+
+public:
+    /**
+     * @brief Received message callback
+     * @note Called from the IOS dispatcher thread
+     *
+     * @param pData Message data
+     * @param size Message size
+     * @param pArg User callback argument
+     */
+    typedef void (*MessageCallback)(const void* pData, u32 size, void* pArg);
+
+    /**
+     * @brief Transport statistics
+     */
+    struct Stats {
+        u32 numSent;        // Packets sent (including retransmissions)
+        u32 numRecv;        // Valid packets received
+        u32 numRetransmits; // Packets sent again after a timeout
+        u32 numFastResends; // Packets sent again after selective ACKs
+        u32 numAckOnly;     // Packets sent only to acknowledge data
+        u32 numDuplicates;  // Packets dropped as already received
+        u32 numInvalid;     // Packets dropped as malformed/out of window
+        u32 numFragmented;  // Messages split across several packets
+        u32 numCoalesced;   // Messages sharing a packet with another
+        u32 smoothRtt;      // Smoothed round-trip time (ticks)
+        u32 rto;            // Retransmission timeout (ticks)
+    };
+
+    //! Maximum number of unacknowledged packets
+    static const u32 WINDOW_SIZE = 32;
+    //! Largest message which can be sent
+    static const u32 MAX_MESSAGE_SIZE = 0x10000;
+    //! Default coalescing delay, in milliseconds
+    static const u32 DEFAULT_COALESCE_DELAY = 5;
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param family Socket protocol family
+     */
+    explicit ReliableSocket(SOProtoFamily family = SO_PF_INET);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~ReliableSocket();
+
+    /**
+     * @brief Sets the peer and starts receiving
+     * @note Nothing is sent, so this completes immediately
+     *
+     * @param rAddr Remote address
+     * @param pCallback Connection callback
+     * @param pArg Callback user argument
+     * @return Success
+     */
+    virtual bool Connect(const SockAddrAny& rAddr, Callback pCallback = nullptr,
+                         void* pArg = nullptr);
+
+    /**
+     * @brief Accepts a peer connection over a new socket
+     * @note Not supported by datagram sockets
+     *
+     * @param pCallback Acceptance callback
+     * @param pArg Callback user argument
+     * @return New socket
+     */
+    virtual AsyncSocket* Accept(AcceptCallback pCallback = nullptr,
+                                void* pArg = nullptr);
+
+    /**
+     * @brief Drives the retransmission and acknowledgement timers
+     * @note The socket's timer already does this, so it's only needed to
+     * run the timers right away
+     */
+    void Calc();
+
+    /**
+     * @brief Queues a message for the peer
+     * @details Messages are copied, so unlike SendBytes the source can be in
+     * any memory region.
+     *
+     * @param pSrc Message data
+     * @param size Message size
+     * @param pCallback Callback for when the peer acknowledges the message
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    SOResult SendMessage(const void* pSrc, u32 size,
+                         Callback pCallback = nullptr, void* pArg = nullptr);
+    /**
+     * @brief Takes the next received message from the queue
+     * @details Messages are copied, so unlike RecvBytes the destination can be
+     * in any memory region.
+     *
+     * @param pDst Destination buffer
+     * @param len Buffer size
+     * @param[out] rSize Message size
+     * @return Socket library result (SO_EWOULDBLOCK if nothing was received)
+     */
+    SOResult RecvMessage(void* pDst, u32 len, u32& rSize);
+
+    /**
+     * @brief Sets the received message callback
+     * @details Messages are polled through RecvMessage when no callback is set
+     *
+     * @param pCallback Message callback
+     * @param pArg Callback user argument
+     */
+    void SetMessageCallback(MessageCallback pCallback, void* pArg = nullptr);
+
+    /**
+     * @brief Toggles coalescing of small messages (Nagle's algorithm)
+     * @details While data is unacknowledged, small messages are held until
+     * they fill a packet or the delay expires.
+     *
+     * @param enable Whether to enable coalescing
+     * @param delay Longest time to hold a message (in milliseconds)
+     */
+    void SetCoalescing(bool enable, u32 delay = DEFAULT_COALESCE_DELAY);
+
+    /**
+     * @brief Gets the transport error (SO_SUCCESS while the peer responds)
+     */
+    SOResult GetStatus() const {
+        return mStatus;
+    }
+
+    /**
+     * @brief Tests whether all sent messages have been acknowledged
+     */
+    bool IsIdle() const;
+
+    /**
+     * @brief Gets the transport statistics
+     */
+    Stats GetStats() const;
+    /**
+     * @brief Resets the transport statistics
+     * @note Timing estimates are not reset, as they reflect the current state
+     */
+    void ResetStats();
+
+private:
+    /**
+     * @brief KUDP packet buffer
+     */
+    struct Datagram {
+        /**
+         * @brief Accesses the KUDP header
+         */
+        KUDPHeader& GetHeader() {
+            return *reinterpret_cast<KUDPHeader*>(data);
+        }
+
+        /**
+         * @brief Accesses the message payload
+         */
+        u8* GetContent() {
+            return data + sizeof(KUDPHeader);
+        }
+
+        // Buffer is first to keep its alignment
+        u8 data[ReliablePacket::MAX_BUFFER_SIZE];
+
+        ReliableSocket* pSocket; // Owner socket (null once destroyed)
+        SockAddrAny peer;        // Sender address (received packets)
+        u32 size;                // Packet size
+        u32 sendTick;            // Time of the latest transmission
+        u16 numSends;            // Number of transmissions
+        bool isPosted;           // Whether an ioctl is in flight
+        bool isReleased;         // Whether to recycle it after the ioctl
+
+        Datagram* pNextFree;    // Next packet in the free list
+        IntrusiveListNode node; // Node in the socket's packet list
+    };
+
+    /**
+     * @brief Message waiting to be sent or acknowledged
+     */
+    struct OutMessage {
+        u8* pData;       // Message data
+        u32 size;        // Message size
+        u32 offset;      // Bytes already copied into packets
+        u16 fragment;    // Next fragment ID
+        u16 lastSeq;     // Sequence ID of the final packet
+        u32 queueTick;   // Time when the message was queued
+        SOResult result; // Completion result
+
+        Callback pCallback; // Completion callback
+        void* pArg;         // Completion callback user argument
+
+        IntrusiveListNode node; // Node in the socket's message queue
+    };
+
+    /**
+     * @brief Message received from the peer
+     */
+    struct InMessage {
+        u8* pData; // Message data
+        u32 size;  // Message size
+
+        IntrusiveListNode node; // Node in the socket's message queue
+    };
+
+    /**
+     * @brief Outstanding receive request
+     */
+    struct RecvRequest {
+        void* pDst;         // Destination buffer
+        u32 len;            // Buffer size
+        SockAddrAny* pAddr; // Where to store the peer address
+        Callback pCallback; // Completion callback
+        void* pArg;         // Completion callback user argument
+    };
+
+    //! Packet list
+    typedef TIntrusiveList<Datagram, &Datagram::node> DatagramList;
+    //! Outgoing message queue
+    typedef TIntrusiveList<OutMessage, &OutMessage::node> OutMessageList;
+    //! Incoming message queue
+    typedef TIntrusiveList<InMessage, &InMessage::node> InMessageList;
+
+    /**
+     * @brief Timer which runs on the IOS dispatcher thread
+     * @details The alarm handler runs in interrupt context, so it only
+     * posts this request to the dispatcher.
+     */
+    struct TimerRequest : public IosRequest {
+        /**
+         * @brief Constructor
+         *
+         * @param pOwner Owner socket
+         */
+        explicit TimerRequest(ReliableSocket* pOwner)
+            : pSocket(pOwner), isQueued(false) {
+            OSCreateAlarm(&alarm);
+            OSSetAlarmUserData(&alarm, this);
+        }
+
+        /**
+         * @brief Handles the timer period
+         * @note Called from the dispatcher thread
+         *
+         * @param result IOS result code
+         */
+        virtual void OnComplete(s32 result);
+
+        ReliableSocket* pSocket; // Owner socket (null once destroyed)
+        OSAlarm alarm;           // Periodic alarm
+        volatile bool isQueued;  // Whether the dispatcher has it queued
+    };
+
+    /**
+     * @brief User callbacks collected under the transport lock
+     */
+    struct Completions {
+        /**
+         * @brief Constructor
+         */
+        Completions()
+            : pMessageCallback(nullptr),
+              pMessageCallbackArg(nullptr),
+              recvResult(SO_SUCCESS),
+              hasRecvRequest(false) {}
+
+        OutMessageList sent;    // Completed outgoing messages
+        InMessageList received; // Messages for the message callback
+
+        MessageCallback pMessageCallback; // Received message callback
+        void* pMessageCallbackArg;        // Message callback user argument
+
+        RecvRequest recvRequest; // Completed receive request
+        SOResult recvResult;     // Receive request result
+        bool hasRecvRequest;     // Whether a receive request completed
+    };
+
+private:
+    /**
+     * @brief Receive completion callback
+     *
+     * @param result Bytes received or IOS error code
+     * @param pArg Received packet
+     */
+    static void RecvCallbackFunc(s32 result, void* pArg);
+    /**
+     * @brief Send completion callback
+     *
+     * @param result Bytes sent or IOS error code
+     * @param pArg Sent packet
+     */
+    static void SendCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Timer alarm handler
+     * @note Called from interrupt context
+     *
+     * @param pAlarm Timer alarm
+     * @param pCtx Interrupted thread context
+     */
+    static void AlarmCallbackFunc(OSAlarm* pAlarm, OSContext* pCtx);
+
+    /**
+     * @brief Runs the retransmission and acknowledgement timers
+     * @note The transport lock must be held
+     */
+    void CalcTimers();
+
+    /**
+     * @brief Gets a packet buffer from the free list
+     */
+    Datagram* AllocDatagram();
+    /**
+     * @brief Returns a packet buffer to the free list
+     * @note Posted packets are recycled once their ioctl completes
+     *
+     * @param pDatagram Packet buffer
+     */
+    void FreeDatagram(Datagram* pDatagram);
+
+    /**
+     * @brief Submits a receive request for the next packet
+     */
+    void PostRecv();
+    /**
+     * @brief Submits a packet to IOS, with the latest acknowledgements
+     *
+     * @param rDatagram Packet to send
+     * @return Success (fails if the packet is still in flight)
+     */
+    bool Transmit(Datagram& rDatagram);
+    /**
+     * @brief Sends a packet containing only acknowledgements
+     */
+    void SendAck();
+
+    /**
+     * @brief Copies queued messages into new packets while the window allows
+     *
+     * @param now Current time
+     */
+    void Packetize(u32 now);
+    /**
+     * @brief Retransmits packets whose timeout has expired
+     *
+     * @param now Current time
+     */
+    void Retransmit(u32 now);
+
+    /**
+     * @brief Handles the peer's acknowledgements
+     *
+     * @param ack Next sequence ID expected by the peer
+     * @param ackBits Sequence IDs received by the peer after ack
+     * @param now Current time
+     */
+    void HandleAck(u16 ack, u32 ackBits, u32 now);
+    /**
+     * @brief Releases an acknowledged packet from the send window
+     *
+     * @param seq Sequence ID
+     * @param now Current time
+     */
+    void ReleaseSeq(u16 seq, u32 now);
+    /**
+     * @brief Updates the retransmission timeout with a new RTT sample
+     *
+     * @param sample Round-trip time (ticks)
+     */
+    void UpdateRtt(u32 sample);
+
+    /**
+     * @brief Handles a received packet
+     *
+     * @param pDatagram Packet buffer
+     * @param size Packet size
+     * @param now Current time
+     * @return Whether the packet is kept in the receive window
+     */
+    bool HandleDatagram(Datagram* pDatagram, u32 size, u32 now);
+    /**
+     * @brief Extracts messages from the next in-order packet
+     *
+     * @param rDatagram Packet buffer
+     */
+    void Deliver(Datagram& rDatagram);
+    /**
+     * @brief Queues a received message for the user
+     *
+     * @param pData Message data
+     * @param size Message size
+     */
+    void QueueMessage(const void* pData, u32 size);
+
+    /**
+     * @brief Fails all pending messages after the peer stops responding
+     *
+     * @param result Socket library result
+     */
+    void Fail(SOResult result);
+
+    /**
+     * @brief Collects pending user callbacks
+     *
+     * @param[out] rCompletions Callback list
+     */
+    void TakeCompletions(Completions& rCompletions);
+    /**
+     * @brief Invokes the collected user callbacks
+     * @note Must be called without the transport lock, as the callbacks may
+     * destroy the socket
+     *
+     * @param rCompletions Callback list
+     */
+    static void InvokeCompletions(Completions& rCompletions);
+
+    /**
+     * @brief Receives data and records sender address (internal implementation)
+     *
+     * @param pDst Destination buffer
+     * @param len Buffer size
+     * @param[out] rRecv Number of bytes received
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult RecvImpl(void* pDst, u32 len, u32& rRecv,
+                              SockAddrAny* pAddr, Callback pCallback,
+                              void* pArg);
+
+    /**
+     * @brief Sends data to specified connection (internal implementation)
+     *
+     * @param pSrc Source buffer
+     * @param len Buffer size
+     * @param[out] rSend Number of bytes sent
+     * @param pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult SendImpl(const void* pSrc, u32 len, u32& rSend,
+                              const SockAddrAny* pAddr, Callback pCallback,
+                              void* pArg);
+
+    /**
+     * @brief Receives data into several buffers and records sender address
+     * (internal implementation)
+     * @details Messages are received whole and then split up
+     *
+     * @param pSegments Destination segments
+     * @param num Number of segments
+     * @param[out] rRecv Number of bytes received
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
+    /**
+     * @brief Sends data from several buffers to specified connection
+     * (internal implementation)
+     * @details Segments are gathered into one message
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param[out] rSend Number of bytes sent
+     * @param pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
+    /**
+     * @brief Tests whether an address belongs to the peer
+     *
+     * @param rAddr Socket address
+     */
+    bool IsPeerAddr(const SockAddrAny& rAddr) const;
+
+    /**
+     * @brief Converts a sequence ID to a window slot
+     *
+     * @param seq Sequence ID
+     */
+    static u32 ToSlot(u16 seq) {
+        return seq & (WINDOW_SIZE - 1);
+    }
+
+private:
+    //! Initial retransmission timeout, in milliseconds
+    static const u32 scInitialRto = 200;
+    //! Shortest retransmission timeout, in milliseconds
+    static const u32 scMinRto = 20;
+    //! Longest retransmission timeout, in milliseconds
+    static const u32 scMaxRto = 2000;
+    //! Longest time to hold back an acknowledgement, in milliseconds
+    static const u32 scAckDelay = 10;
+    //! Packets received before an acknowledgement is sent immediately
+    static const u32 scAckBatch = 2;
+    //! Later packets acknowledged before a missing one is sent again
+    static const u32 scFastResendThreshold = 3;
+    //! Transmissions before the peer is considered lost
+    static const u32 scMaxSends = 10;
+    //! Timer period, in milliseconds (finer than the ACK/coalescing delays)
+    static const u32 scTimerPeriod = 2;
+
+    SockAddrAny mPeer; // Peer address
+    bool mIsConnected; // Whether the peer is set
+    SOResult mStatus;  // Transport error
+
+    DatagramList mDatagrams;  // All packet buffers owned by the socket
+    Datagram* mpFreeList;     // Unused packet buffers
+    Datagram* mpRecvDatagram; // Packet buffer of the posted receive
+
+    // Send window
+    u16 mSendSeq;                        // Next sequence ID to send
+    u16 mSendBase;                       // Oldest unacknowledged sequence ID
+    Datagram* mpSendWindow[WINDOW_SIZE]; // Unacknowledged packets
+    OutMessageList mSendQueue;           // Messages not yet in packets
+    u32 mSendQueueSize;                  // Bytes needed by queued messages
+    OutMessageList mSendFlight;          // Messages waiting for ACKs
+    OutMessageList mSendDone;            // Messages waiting for callbacks
+
+    // Receive window
+    u16 mRecvBase;                       // Next sequence ID to deliver
+    Datagram* mpRecvWindow[WINDOW_SIZE]; // Packets received out of order
+    u32 mNumUnacked;                     // Packets received since last ACK
+    bool mIsAckPending;                  // Whether an ACK is held back
+    u32 mAckTick;                        // When the held ACK was scheduled
+
+    // Message reassembly
+    u8* mpAssembly;        // Fragments received so far
+    u32 mAssemblySize;     // Size of the fragments received so far
+    u32 mAssemblyCapacity; // Reassembly buffer size
+    u16 mAssemblyFragment; // Next expected fragment ID
+
+    InMessageList mRecvQueue; // Messages waiting for the user
+    RecvRequest mRecvRequest; // Outstanding receive request
+    bool mHasRecvRequest;     // Whether a receive request is outstanding
+
+    MessageCallback mpMessageCallback; // Received message callback
+    void* mpMessageCallbackArg;        // Message callback user argument
+
+    bool mIsCoalescing; // Whether small messages are coalesced
+    u32 mCoalesceDelay; // Longest time to hold a small message
+
+    // Round-trip time estimates (RFC 6298)
+    u32 mSmoothRtt; // Smoothed round-trip time
+    u32 mRttVar;    // Round-trip time variation
+    u32 mRto;       // Retransmission timeout
+
+    TimerRequest* mpTimer; // Timer driving retransmissions and ACKs
+
+    Stats mStats;           // Transport statistics
+    mutable OSMutex mMutex; // Transport lock
+
+    static OSMutex sMutex; // Packet/timer ownership lock
+};
 
 //! @}
 } // namespace kiwi
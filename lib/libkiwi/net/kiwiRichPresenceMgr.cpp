@@ -8,12 +8,19 @@ namespace kiwi {
  * @brief Constructor
  */
 RichPresenceMgr::RichPresenceMgr()
-    : ISceneHook(-1), mpClient(nullptr), mpProfile(nullptr) {
+    : ISceneHook(-1), mpClient(nullptr), mpProfile(nullptr), mEvents(0) {
 
     // TODO: Only Dolphin Emulator is supported for now
     mpClient = new EmuRichPresenceClient();
     K_ASSERT(mpClient != nullptr);
 
+    // Client updates are slow, so they shouldn't hold up the game
+    OSInitThreadQueue(&mWakeupQueue);
+    OSCreateThread(&mThread, ThreadFunc, this,
+                   mThreadStack + sizeof(mThreadStack), sizeof(mThreadStack),
+                   OS_PRIORITY_MAX, 0);
+    OSResumeThread(&mThread);
+
     // Start periodic alarm for routine updates
     OSCreateAlarm(&mAlarm);
     OSSetPeriodicAlarm(&mAlarm, OSGetTime(), OS_SEC_TO_TICKS(ALARM_PERIOD_SEC),
@@ -26,6 +33,10 @@ RichPresenceMgr::RichPresenceMgr()
 RichPresenceMgr::~RichPresenceMgr() {
     OSCancelAlarm(&mAlarm);
 
+    // Worker thread may be using the client
+    Signal(EEvent_Exit);
+    OSJoinThread(&mThread, nullptr);
+
     delete mpClient;
     mpClient = nullptr;
 
@@ -46,7 +57,8 @@ void RichPresenceMgr::SetProfile(IRichPresenceProfile* pProfile) {
 
     K_ASSERT(mpClient != nullptr);
     mpClient->SetAppID(pProfile->GetAppID());
-    mpClient->UpdateApp();
+
+    Signal(EEvent_Flush);
 }
 
 /**
@@ -70,6 +82,9 @@ void RichPresenceMgr::Reset(RPSysScene* pScene) {
 #elif defined(PACK_RESORT)
     K_ASSERT_EX(false, "Not implemented.");
 #endif
+
+    // Send any changes from the worker thread
+    Signal(EEvent_Flush);
 }
 
 /**
@@ -82,19 +97,71 @@ void RichPresenceMgr::AlarmCallbackFunc(OSAlarm* pAlarm, OSContext* pCtx) {
 #pragma unused(pAlarm)
 #pragma unused(pCtx)
 
-    RichPresenceMgr& r = GetInstance();
+    // Client updates are too slow for interrupt context
+    GetInstance().Signal(EEvent_Alarm);
+}
 
-    if (r.mpProfile == nullptr) {
-        return;
+/**
+ * @brief Worker thread function
+ *
+ * @param pArg Thread function argument
+ */
+void* RichPresenceMgr::ThreadFunc(void* pArg) {
+    K_ASSERT(pArg != nullptr);
+    RichPresenceMgr& r = *static_cast<RichPresenceMgr*>(pArg);
+
+    while (true) {
+        u32 events = r.WaitForEvents();
+
+        if (events & EEvent_Exit) {
+            break;
+        }
+
+        K_ASSERT(r.mpClient != nullptr);
+
+        // Allow user to update activity
+        if ((events & EEvent_Alarm) && r.mpProfile != nullptr) {
+            r.mpProfile->AlarmCallback(*r.mpClient);
+        }
+
+        // Display most recent activity data (only if it changed)
+        r.mpClient->Flush();
     }
 
-    K_ASSERT(r.mpClient != nullptr);
+    return nullptr;
+}
 
-    // Allow user to update activity
-    r.mpProfile->AlarmCallback(*r.mpClient);
+/**
+ * @brief Sends events to the worker thread
+ * @note Safe to call from interrupt context
+ *
+ * @param events Events to send (EEvent)
+ */
+void RichPresenceMgr::Signal(u32 events) {
+    AutoInterruptLock lock;
+
+    // Events sent before the worker wakes up are coalesced
+    mEvents |= events;
+    OSWakeupThread(&mWakeupQueue);
+}
+
+/**
+ * @brief Takes the pending worker thread events
+ * @note Sleeps until an event is sent
+ *
+ * @return Pending events (EEvent)
+ */
+u32 RichPresenceMgr::WaitForEvents() {
+    // Interrupts are disabled to avoid missing the wakeup signal
+    AutoInterruptLock lock;
+
+    while (mEvents == 0) {
+        OSSleepThread(&mWakeupQueue);
+    }
 
-    // Display most recent activity data
-    r.mpClient->UpdateActivity();
+    u32 events = mEvents;
+    mEvents = 0;
+    return events;
 }
 
 } // namespace kiwi
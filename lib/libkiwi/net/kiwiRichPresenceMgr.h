@@ -44,7 +44,8 @@ public:
 
     /**
      * @brief Handles periodic alarm event
-     * @note The alarm period is 20 seconds.
+     * @note The alarm period is 20 seconds. This is called from the rich
+     * presence worker thread, not from the alarm interrupt.
      *
      * @param rClient Active rich presence client
      */
@@ -53,6 +54,9 @@ public:
 
 /**
  * @brief Discord rich presence manager
+ * @details Presence changes are only recorded by the scene/alarm events. A
+ * low-priority worker thread sends them to the client in batches, and only
+ * when something actually changed.
  */
 class RichPresenceMgr : public StaticSingleton<RichPresenceMgr>,
                         public ISceneHook {
@@ -70,6 +74,18 @@ private:
     //! Alarm period, in seconds
     static const int ALARM_PERIOD_SEC = 20;
 
+    /**
+     * @brief Worker thread events
+     */
+    enum EEvent {
+        EEvent_Alarm = 1 << 0, //!< Periodic alarm fired
+        EEvent_Flush = 1 << 1, //!< Presence data may have changed
+        EEvent_Exit = 1 << 2,  //!< Manager is being destroyed
+    };
+
+    //! Worker thread stack size
+    static const u32 scThreadStackSize = 0x4000;
+
 private:
     /**
      * @brief Constructor
@@ -95,6 +111,28 @@ private:
      */
     static void AlarmCallbackFunc(OSAlarm* pAlarm, OSContext* pCtx);
 
+    /**
+     * @brief Worker thread function
+     *
+     * @param pArg Thread function argument
+     */
+    static void* ThreadFunc(void* pArg);
+
+    /**
+     * @brief Sends events to the worker thread
+     * @note Safe to call from interrupt context
+     *
+     * @param events Events to send (EEvent)
+     */
+    void Signal(u32 events);
+    /**
+     * @brief Takes the pending worker thread events
+     * @note Sleeps until an event is sent
+     *
+     * @return Pending events (EEvent)
+     */
+    u32 WaitForEvents();
+
 private:
     //! Active rich presence client
     IRichPresenceClient* mpClient;
@@ -103,6 +141,15 @@ private:
 
     //! Periodic alarm for updates
     OSAlarm mAlarm;
+
+    //! Worker thread
+    OSThread mThread;
+    //! Worker thread stack
+    u8 mThreadStack[scThreadStackSize];
+    //! Idle worker thread
+    OSThreadQueue mWakeupQueue;
+    //! Pending worker thread events (EEvent)
+    u32 mEvents;
 };
 
 } // namespace kiwi
@@ -210,6 +210,23 @@ bool SocketBase::SetRecvBufferSize(s32 size) const {
                              sizeof(s32)) == SO_SUCCESS;
 }
 
+/**
+ * @brief Gets this socket's I/O counters
+ * @note Counters are only updated while NetStats is enabled
+ */
+NetCounters SocketBase::GetCounters() const {
+    AutoInterruptLock lock;
+    return mCounters;
+}
+
+/**
+ * @brief Clears this socket's I/O counters
+ */
+void SocketBase::ResetCounters() {
+    AutoInterruptLock lock;
+    mCounters.Reset();
+}
+
 /**
  * @brief Tests whether socket can receive data
  */
@@ -296,6 +313,67 @@ Optional<u32> SocketBase::RecvBytesFrom(void* pDst, u32 len, SockAddrAny& rAddr,
     return kiwi::nullopt;
 }
 
+/**
+ * @brief Receives bytes from bound connection into several buffers
+ * @details Stream data lands directly in the segments, which are filled
+ * in order. Datagrams are received whole and then split up.
+ *
+ * @param pSegments Destination segments (MEM2)
+ * @param num Number of segments
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Number of bytes received
+ */
+Optional<u32> SocketBase::RecvV(const SockSegment* pSegments, u32 num,
+                                Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(IsSegmentsMEM2(pSegments, num));
+    K_ASSERT(GetSegmentsSize(pSegments, num) > 0);
+
+    // Implementation version is responsible for using the callback
+    u32 nrecv = 0;
+    SOResult result =
+        RecvVImpl(pSegments, num, nrecv, nullptr, pCallback, pArg);
+
+    if (result == SO_SUCCESS || result == SO_EWOULDBLOCK) {
+        return nrecv;
+    }
+
+    return kiwi::nullopt;
+}
+
+/**
+ * @brief Receives bytes into several buffers and records sender address
+ * @details Stream data lands directly in the segments, which are filled
+ * in order. Datagrams are received whole and then split up.
+ *
+ * @param pSegments Destination segments (MEM2)
+ * @param num Number of segments
+ * @param rAddr[out] Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Number of bytes received
+ */
+Optional<u32> SocketBase::RecvVFrom(const SockSegment* pSegments, u32 num,
+                                    SockAddrAny& rAddr, Callback pCallback,
+                                    void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(IsSegmentsMEM2(pSegments, num));
+    K_ASSERT(GetSegmentsSize(pSegments, num) > 0);
+
+    // Implementation version is responsible for using the callback
+    u32 nrecv = 0;
+    SOResult result = RecvVImpl(pSegments, num, nrecv, &rAddr, pCallback, pArg);
+
+    if (result == SO_SUCCESS || result == SO_EWOULDBLOCK) {
+        return nrecv;
+    }
+
+    return kiwi::nullopt;
+}
+
 /**
  * @brief Sends bytes to bound connection
  *
@@ -352,4 +430,204 @@ Optional<u32> SocketBase::SendBytesTo(const void* pSrc, u32 len,
     return kiwi::nullopt;
 }
 
+/**
+ * @brief Sends bytes from several buffers to bound connection
+ * @details The segments are sent in order, as one message. Segments
+ * don't need to be in MEM2, but those which aren't will be copied.
+ * @note Asynchronous sockets may send MEM2 segments in place, so they
+ * must outlive the operation
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Number of bytes sent
+ */
+Optional<u32> SocketBase::SendV(const SockSegment* pSegments, u32 num,
+                                Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(GetSegmentsSize(pSegments, num) > 0);
+
+    // Implementation version is responsible for using the callback
+    u32 nsend = 0;
+    SOResult result =
+        SendVImpl(pSegments, num, nsend, nullptr, pCallback, pArg);
+
+    if (result == SO_SUCCESS || result == SO_EWOULDBLOCK) {
+        return nsend;
+    }
+
+    return kiwi::nullopt;
+}
+
+/**
+ * @brief Sends bytes from several buffers to specified connection
+ * @details The segments are sent in order, as one message. Segments
+ * don't need to be in MEM2, but those which aren't will be copied.
+ * @note Asynchronous sockets may send MEM2 segments in place, so they
+ * must outlive the operation
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param rAddr Destination address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Number of bytes sent
+ */
+Optional<u32> SocketBase::SendVTo(const SockSegment* pSegments, u32 num,
+                                  const SockAddrAny& rAddr,
+                                  Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(GetSegmentsSize(pSegments, num) > 0);
+
+    // Implementation version is responsible for using the callback
+    u32 nsend = 0;
+    SOResult result = SendVImpl(pSegments, num, nsend, &rAddr, pCallback, pArg);
+
+    if (result == SO_SUCCESS || result == SO_EWOULDBLOCK) {
+        return nsend;
+    }
+
+    return kiwi::nullopt;
+}
+
+/**
+ * @brief Gets the total size of a segment list
+ *
+ * @param pSegments Segments
+ * @param num Number of segments
+ */
+u32 SocketBase::GetSegmentsSize(const SockSegment* pSegments, u32 num) {
+    K_ASSERT(pSegments != nullptr || num == 0);
+
+    u32 size = 0;
+    for (u32 i = 0; i < num; i++) {
+        size += pSegments[i].size;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Tests whether all segments can be used by IOS directly
+ *
+ * @param pSegments Segments
+ * @param num Number of segments
+ */
+bool SocketBase::IsSegmentsMEM2(const SockSegment* pSegments, u32 num) {
+    K_ASSERT(pSegments != nullptr || num == 0);
+
+    for (u32 i = 0; i < num; i++) {
+        // Empty segments are never touched
+        if (pSegments[i].size == 0) {
+            continue;
+        }
+
+        if (pSegments[i].pData == nullptr ||
+            !OSIsMEM2Region(pSegments[i].pData)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Receives data into several buffers and records sender address
+ * (internal implementation)
+ * @details IOS only accepts one receive buffer, so by default the data is
+ * received into a staging buffer and split up afterwards.
+ * @note Asynchronous completion of multiple segments is not supported by
+ * default
+ *
+ * @param pSegments Destination segments
+ * @param num Number of segments
+ * @param[out] rRecv Number of bytes received
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult SocketBase::RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg) {
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    // Single buffer can be used directly
+    if (num == 1) {
+        return RecvImpl(pSegments[0].pData, pSegments[0].size, rRecv, pAddr,
+                        pCallback, pArg);
+    }
+
+    K_ASSERT_EX(pCallback == nullptr,
+                "This socket can't scatter asynchronous receives");
+
+    u32 size = GetSegmentsSize(pSegments, num);
+
+    // Socket needs memory allocated in MEM2
+    u8* pStaging = new (32, EMemory_MEM2) u8[size];
+    K_ASSERT(pStaging != nullptr);
+
+    SOResult result = RecvImpl(pStaging, size, rRecv, pAddr, nullptr, nullptr);
+
+    // Split up whatever was received
+    u32 offset = 0;
+    for (u32 i = 0; i < num && offset < rRecv; i++) {
+        u32 n = Min(pSegments[i].size, rRecv - offset);
+        std::memcpy(pSegments[i].pData, pStaging + offset, n);
+        offset += n;
+    }
+
+    delete[] pStaging;
+    return result;
+}
+
+/**
+ * @brief Sends data from several buffers to specified connection
+ * (internal implementation)
+ * @details IOS only accepts one send buffer, so by default the segments
+ * are gathered into a staging buffer.
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param[out] rSend Number of bytes sent
+ * @param pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult SocketBase::SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg) {
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    // Single buffer can be used directly
+    if (num == 1 && IsSegmentsMEM2(pSegments, num)) {
+        return SendImpl(pSegments[0].pData, pSegments[0].size, rSend, pAddr,
+                        pCallback, pArg);
+    }
+
+    u32 size = GetSegmentsSize(pSegments, num);
+
+    // Socket needs memory allocated in MEM2
+    u8* pStaging = new (32, EMemory_MEM2) u8[size];
+    K_ASSERT(pStaging != nullptr);
+
+    u32 offset = 0;
+    for (u32 i = 0; i < num; i++) {
+        std::memcpy(pStaging + offset, pSegments[i].pData, pSegments[i].size);
+        offset += pSegments[i].size;
+    }
+
+    // Implementations copy the data if they need it beyond this call
+    SOResult result = SendImpl(pStaging, size, rSend, pAddr, pCallback, pArg);
+
+    delete[] pStaging;
+    return result;
+}
+
 } // namespace kiwi
@@ -1,6 +1,7 @@
 #ifndef LIBKIWI_NET_SOCKET_BASE_H
 #define LIBKIWI_NET_SOCKET_BASE_H
 #include <libkiwi/k_types.h>
+#include <libkiwi/net/kiwiNetStats.h>
 #include <libkiwi/prim/kiwiOptional.h>
 #include <libkiwi/support/kiwiLibSO.h>
 
@@ -8,6 +9,37 @@ namespace kiwi {
 //! @addtogroup libkiwi_net
 //! @{
 
+/**
+ * @brief Scatter-gather buffer segment
+ */
+struct SockSegment {
+    void* pData; //!< Segment data
+    u32 size;    //!< Segment size
+
+    /**
+     * @brief Constructor
+     */
+    SockSegment() : pData(nullptr), size(0) {}
+
+    /**
+     * @brief Constructor
+     *
+     * @param pData Segment data
+     * @param size Segment size
+     */
+    SockSegment(void* pData, u32 size) : pData(pData), size(size) {}
+
+    /**
+     * @brief Constructor
+     * @note Only for segments which will be sent (read from)
+     *
+     * @param pData Segment data
+     * @param size Segment size
+     */
+    SockSegment(const void* pData, u32 size)
+        : pData(const_cast<void*>(pData)), size(size) {}
+};
+
 /**
  * @brief IOS Berkeley socket wrapper
  */
@@ -60,6 +92,13 @@ public:
         return mHandle >= 0;
     }
 
+    /**
+     * @brief Gets the socket descriptor
+     */
+    SOSocket GetHandle() const {
+        return mHandle;
+    }
+
     /**
      * @brief Connects to a peer
      *
@@ -163,6 +202,16 @@ public:
      */
     bool SetRecvBufferSize(s32 size) const;
 
+    /**
+     * @brief Gets this socket's I/O counters
+     * @note Counters are only updated while NetStats is enabled
+     */
+    NetCounters GetCounters() const;
+    /**
+     * @brief Clears this socket's I/O counters
+     */
+    void ResetCounters();
+
     /**
      * @brief Tests whether socket can receive data
      */
@@ -228,6 +277,35 @@ public:
                            Callback pCallback = nullptr, void* pArg = nullptr) {
         return RecvBytesFrom(&rDst, sizeof(T), rAddr, pCallback, pArg);
     }
+
+    /**
+     * @brief Receives bytes from bound connection into several buffers
+     * @details Stream data lands directly in the segments, which are filled
+     * in order. Datagrams are received whole and then split up.
+     *
+     * @param pSegments Destination segments (MEM2)
+     * @param num Number of segments
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Number of bytes received
+     */
+    Optional<u32> RecvV(const SockSegment* pSegments, u32 num,
+                        Callback pCallback = nullptr, void* pArg = nullptr);
+    /**
+     * @brief Receives bytes into several buffers and records sender address
+     * @details Stream data lands directly in the segments, which are filled
+     * in order. Datagrams are received whole and then split up.
+     *
+     * @param pSegments Destination segments (MEM2)
+     * @param num Number of segments
+     * @param rAddr[out] Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Number of bytes received
+     */
+    Optional<u32> RecvVFrom(const SockSegment* pSegments, u32 num,
+                            SockAddrAny& rAddr, Callback pCallback = nullptr,
+                            void* pArg = nullptr);
     /**@}*/
 
     /**
@@ -317,8 +395,45 @@ public:
         return SendBytesTo(rSrc.CStr(), rSrc.Length() * sizeof(T), rAddr,
                            pCallback, pArg);
     }
+
+    /**
+     * @brief Sends bytes from several buffers to bound connection
+     * @details The segments are sent in order, as one message. Segments
+     * don't need to be in MEM2, but those which aren't will be copied.
+     * @note Asynchronous sockets may send MEM2 segments in place, so they
+     * must outlive the operation
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Number of bytes sent
+     */
+    Optional<u32> SendV(const SockSegment* pSegments, u32 num,
+                        Callback pCallback = nullptr, void* pArg = nullptr);
+    /**
+     * @brief Sends bytes from several buffers to specified connection
+     * @details The segments are sent in order, as one message. Segments
+     * don't need to be in MEM2, but those which aren't will be copied.
+     * @note Asynchronous sockets may send MEM2 segments in place, so they
+     * must outlive the operation
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param rAddr Destination address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Number of bytes sent
+     */
+    Optional<u32> SendVTo(const SockSegment* pSegments, u32 num,
+                          const SockAddrAny& rAddr,
+                          Callback pCallback = nullptr, void* pArg = nullptr);
     /**@}*/
 
+protected:
+    //! Largest stream message which is gathered rather than sent in pieces
+    static const u32 scMaxGatherSize = 1024;
+
 protected:
     /**
      * @brief Constructor
@@ -329,6 +444,59 @@ protected:
      */
     SocketBase(SOSocket socket, SOProtoFamily family, SOSockType type);
 
+    /**
+     * @brief Gets the total size of a segment list
+     *
+     * @param pSegments Segments
+     * @param num Number of segments
+     */
+    static u32 GetSegmentsSize(const SockSegment* pSegments, u32 num);
+    /**
+     * @brief Tests whether all segments can be used by IOS directly
+     *
+     * @param pSegments Segments
+     * @param num Number of segments
+     */
+    static bool IsSegmentsMEM2(const SockSegment* pSegments, u32 num);
+
+    /**
+     * @brief Receives data into several buffers and records sender address
+     * (internal implementation)
+     * @details IOS only accepts one receive buffer, so by default the data is
+     * received into a staging buffer and split up afterwards.
+     * @note Asynchronous completion of multiple segments is not supported by
+     * default
+     *
+     * @param pSegments Destination segments
+     * @param num Number of segments
+     * @param[out] rRecv Number of bytes received
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
+    /**
+     * @brief Sends data from several buffers to specified connection
+     * (internal implementation)
+     * @details IOS only accepts one send buffer, so by default the segments
+     * are gathered into a staging buffer.
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param[out] rSend Number of bytes sent
+     * @param pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
 private:
     /**
      * @brief Receives data and records sender address (internal implementation)
@@ -364,6 +532,7 @@ protected:
     SOSocket mHandle;      // File descriptor
     SOProtoFamily mFamily; // Protocol family
     SOSockType mType;      // Socket type
+    NetCounters mCounters; // I/O counters
 };
 
 //! @}
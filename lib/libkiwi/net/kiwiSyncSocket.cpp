@@ -15,6 +15,8 @@ bool SyncSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
     K_ASSERT(IsOpen());
 
     s32 result = LibSO::Connect(mHandle, rAddr);
+    NetStats::Count(mCounters, NetStats::EOp_Connect, result);
+
     bool success = result == SO_SUCCESS || result == SO_EISCONN;
 
     if (pCallback != nullptr) {
@@ -75,6 +77,8 @@ SOResult SyncSocket::RecvImpl(void* pDst, u32 len, u32& rRecv,
     SockAddr4 addr;
 
     s32 result = LibSO::RecvFrom(mHandle, pDst, len, 0, addr);
+    NetStats::Count(mCounters, NetStats::EOp_Recv, result);
+
     if (result > 0) {
         rRecv += result;
     }
@@ -119,6 +123,8 @@ SOResult SyncSocket::SendImpl(const void* pSrc, u32 len, u32& rSend,
         result = LibSO::Send(mHandle, pSrc, len - rSend, 0);
     }
 
+    NetStats::Count(mCounters, NetStats::EOp_Send, result);
+
     if (result > 0) {
         rSend += result;
     }
@@ -131,4 +137,142 @@ SOResult SyncSocket::SendImpl(const void* pSrc, u32 len, u32& rSend,
     return result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result);
 }
 
+/**
+ * @brief Receives data into several buffers and records sender address
+ * (internal implementation)
+ * @details Stream data is received directly into each segment in turn
+ *
+ * @param pSegments Destination segments
+ * @param num Number of segments
+ * @param[out] rRecv Number of bytes received
+ * @param[out] pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult SyncSocket::RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    // Datagrams can't be split between receives
+    if (mType != SO_SOCK_STREAM) {
+        SOResult result = SocketBase::RecvVImpl(pSegments, num, rRecv, pAddr,
+                                                nullptr, nullptr);
+
+        if (pCallback != nullptr) {
+            pCallback(LibSO::GetLastError(), pArg);
+        }
+
+        return result;
+    }
+
+    rRecv = 0;
+    SockAddr4 addr;
+
+    s32 result = 0;
+    for (u32 i = 0; i < num; i++) {
+        if (pSegments[i].size == 0) {
+            continue;
+        }
+
+        // Don't block waiting for more than the peer has sent
+        if (rRecv > 0 && !CanRecv()) {
+            break;
+        }
+
+        result = LibSO::RecvFrom(mHandle, pSegments[i].pData, pSegments[i].size,
+                                 0, addr);
+        NetStats::Count(mCounters, NetStats::EOp_Recv, result);
+
+        if (result > 0) {
+            rRecv += result;
+        }
+
+        // Segment couldn't be filled
+        if (result <= 0 || static_cast<u32>(result) < pSegments[i].size) {
+            break;
+        }
+    }
+
+    if (pAddr != nullptr) {
+        *pAddr = addr;
+    }
+
+    if (pCallback != nullptr) {
+        pCallback(LibSO::GetLastError(), pArg);
+    }
+
+    // Successful if some amount of bytes read
+    return result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result);
+}
+
+/**
+ * @brief Sends data from several buffers to specified connection
+ * (internal implementation)
+ * @details Large stream messages are sent directly from each segment in
+ * turn, rather than being gathered into a staging buffer.
+ *
+ * @param pSegments Source segments
+ * @param num Number of segments
+ * @param[out] rSend Number of bytes sent
+ * @param pAddr Sender address
+ * @param pCallback Completion callback
+ * @param pArg Callback user argument
+ * @return Socket library result
+ */
+SOResult SyncSocket::SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg) {
+    K_ASSERT(IsOpen());
+    K_ASSERT(pSegments != nullptr);
+    K_ASSERT(num > 0);
+
+    // Datagrams must be sent whole, and copying a small message is cheaper
+    // than sending it in pieces
+    if (mType != SO_SOCK_STREAM || num == 1 ||
+        !IsSegmentsMEM2(pSegments, num) ||
+        GetSegmentsSize(pSegments, num) <= scMaxGatherSize) {
+        return SocketBase::SendVImpl(pSegments, num, rSend, pAddr, pCallback,
+                                     pArg);
+    }
+
+    rSend = 0;
+
+    s32 result = 0;
+    for (u32 i = 0; i < num; i++) {
+        if (pSegments[i].size == 0) {
+            continue;
+        }
+
+        if (pAddr != nullptr) {
+            result = LibSO::SendTo(mHandle, pSegments[i].pData,
+                                   pSegments[i].size, 0, *pAddr);
+        } else {
+            result = LibSO::Send(mHandle, pSegments[i].pData,
+                                 pSegments[i].size, 0);
+        }
+
+        NetStats::Count(mCounters, NetStats::EOp_Send, result);
+
+        if (result > 0) {
+            rSend += result;
+        }
+
+        // Later segments can't be sent before the rest of this one
+        if (result < 0 || static_cast<u32>(result) < pSegments[i].size) {
+            break;
+        }
+    }
+
+    if (pCallback != nullptr) {
+        pCallback(LibSO::GetLastError(), pArg);
+    }
+
+    // Successful if some amount of bytes sent
+    return result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result);
+}
+
 } // namespace kiwi
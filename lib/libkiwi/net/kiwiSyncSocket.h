@@ -82,6 +82,41 @@ private:
     virtual SOResult SendImpl(const void* pSrc, u32 len, u32& rSend,
                               const SockAddrAny* pAddr, Callback pCallback,
                               void* pArg);
+
+    /**
+     * @brief Receives data into several buffers and records sender address
+     * (internal implementation)
+     * @details Stream data is received directly into each segment in turn
+     *
+     * @param pSegments Destination segments
+     * @param num Number of segments
+     * @param[out] rRecv Number of bytes received
+     * @param[out] pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult RecvVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rRecv, SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
+
+    /**
+     * @brief Sends data from several buffers to specified connection
+     * (internal implementation)
+     * @details Large stream messages are sent directly from each segment in
+     * turn, rather than being gathered into a staging buffer.
+     *
+     * @param pSegments Source segments
+     * @param num Number of segments
+     * @param[out] rSend Number of bytes sent
+     * @param pAddr Sender address
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @return Socket library result
+     */
+    virtual SOResult SendVImpl(const SockSegment* pSegments, u32 num,
+                               u32& rSend, const SockAddrAny* pAddr,
+                               Callback pCallback, void* pArg);
 };
 
 //! @}
@@ -1,74 +1,10 @@
 #include <libkiwi.h>
 
+#include <cstring>
+
 namespace kiwi {
 namespace {
 
-/**
- * @brief Frame opcode
- */
-enum EOpcode {
-    EOpcode_Continuation, //!< Intermediate frame of a fragmented message
-    EOpcode_Text,         //!< UTF-8 encoded application text
-    EOpcode_Binary,       //!< Application binary data
-    EOpcode_Close = 8,    //!< Close frame
-    EOpcode_Ping,         //!< Heartbeat/latency (first)
-    EOpcode_Pong,         //!< Heartbeat/latency (second)
-};
-
-/**
- * @brief Data frame
- */
-struct Frame {
-    /* 0x00:0 */ u8 fin : 1;    //!< Final frame of a message
-    /* 0x00:1 */ u8 rsv1 : 1;   //! Reserved, must be zero
-    /* 0x00:2 */ u8 rsv2 : 1;   //! Reserved, must be zero
-    /* 0x00:3 */ u8 rsv3 : 1;   //! Reserved, must be zero
-    /* 0x00:4 */ u8 opcode : 4; //! Frame opcode
-    /* 0x01:0 */ u8 mask : 1;   //! Frame is masked (and masking key is present)
-    /* 0x01:1 */ u8 length : 7; //! Payload length
-
-    union {
-        //! Length is 7 + the following 16 bits
-        union {
-            struct {
-                u16 length;
-                u8 payload[1];
-            } unmasked;
-
-            struct {
-                u16 length;
-                u32 masking;
-                u8 payload[1];
-            } masked;
-        } len16;
-
-        //! Length is 7 + the following 64 bits
-        union {
-            struct {
-                u64 length;
-                u8 payload[1];
-            } unmasked;
-
-            struct {
-                u64 length;
-                u32 masking;
-                u8 payload[1];
-            } masked;
-        } len64;
-
-        union {
-            struct {
-                u8 payload[1];
-            } unmasked;
-
-            struct {
-                u32 masking;
-                u8 payload[1];
-            } masked;
-        };
-    };
-};
-
 /**
  * @brief Websocket protocol version
  */
@@ -99,36 +35,131 @@ String GenerateKey() {
  * @param rKey Key ('Sec-WebSocket-Key')
  */
 String GenerateAccept(const String& rKey) {
-    String expected = rKey + WEBSOCKET_KEY_CONST;
-    expected = SHA1Hash(expected, expected.Length());
-    expected = B64Encode(expected, expected.Length());
-    return expected;
+    String key = rKey + WEBSOCKET_KEY_CONST;
+
+    // Server encodes the binary digest, not its hex string
+    u8 digest[SHA1::DIGEST_SIZE];
+    SHA1 sha;
+    sha.Process(key.CStr(), key.Length());
+    sha.Finalize(digest);
+
+    return B64Encode(digest, sizeof(digest));
 }
 
 } // namespace
 
+namespace detail {
+
+/**
+ * @brief Applies a WebSocket masking key to payload data (in-place)
+ * @details The key repeats every four bytes, so once the data is aligned it
+ * is XOR'd a word at a time.
+ *
+ * @param pData Payload data
+ * @param size Data size
+ * @param pKey Masking key
+ * @param phase Position of the data within the payload
+ */
+void WebSockMask(u8* pData, u32 size, const u8* pKey, u32 phase) {
+    K_ASSERT(pData != nullptr || size == 0);
+    K_ASSERT(pKey != nullptr);
+
+    // Leading bytes until the data is word-aligned
+    for (; size > 0 && !PtrUtil::IsAlignedPointer(pData, sizeof(u32));
+         size--) {
+        *pData++ ^= pKey[phase++ % 4];
+    }
+
+    // Key bytes in the order they line up with each word
+    u8 rotated[sizeof(u32)];
+    for (int i = 0; i < LENGTHOF(rotated); i++) {
+        rotated[i] = pKey[(phase + i) % 4];
+    }
+
+    u32 mask;
+    std::memcpy(&mask, rotated, sizeof(u32));
+
+    u32* pWords = reinterpret_cast<u32*>(pData);
+    u32 words = size / sizeof(u32);
+
+    // Four words per iteration keeps the loop overhead down
+    for (; words >= 4; words -= 4, pWords += 4) {
+        pWords[0] ^= mask;
+        pWords[1] ^= mask;
+        pWords[2] ^= mask;
+        pWords[3] ^= mask;
+    }
+
+    for (; words > 0; words--) {
+        *pWords++ ^= mask;
+    }
+
+    // Trailing bytes continue the same key rotation
+    pData = reinterpret_cast<u8*>(pWords);
+    for (u32 i = 0; i < size % sizeof(u32); i++) {
+        pData[i] ^= rotated[i];
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Socket lock
+ */
+OSMutex WebSocket::sMutex;
+
 /**
  * @brief Constructor
  */
 WebSocket::WebSocket()
     : mState(EState_None),
       mpSocket(nullptr),
-      mpRequest(nullptr),
+      mpUpgradeJob(nullptr),
       mpConnectCallback(nullptr),
       mpConnectCallbackArg(nullptr),
+      mpCloseCallback(nullptr),
+      mpCloseCallbackArg(nullptr),
       mpMessageCallback(nullptr),
-      mpMessageCallbackArg(nullptr) {}
+      mpMessageCallbackArg(nullptr),
+      mpRecvJob(nullptr),
+      mpSendBuffer(nullptr),
+      mSendBufferSize(0),
+      mHeaderSize(0),
+      mHeaderNeed(2),
+      mOpcode(EOpcode_Continuation),
+      mIsFin(false),
+      mIsMasked(false),
+      mPayloadSize(0),
+      mPayloadRead(0),
+      mpMessage(nullptr),
+      mMessageCapacity(0),
+      mMessageSize(0),
+      mMessageOpcode(EOpcode_Continuation),
+      mMaxMessageSize(DEFAULT_MAX_MESSAGE_SIZE),
+      mCloseCode(0),
+      mIsCloseSent(false),
+      mIsPingPending(false),
+      mPingTick(0),
+      mPingTime(0) {
+
+    // Socket needs memory allocated in MEM2
+    mSendBufferSize = scSendHeaderRoom + scMaxSendPayload;
+    mpSendBuffer = new (32, EMemory_MEM2) u8[mSendBufferSize];
+    K_ASSERT(mpSendBuffer != nullptr);
+}
 
 /**
  * @brief Destructor
+ * @note Don't destroy the socket from one of its own callbacks
  */
 WebSocket::~WebSocket() {
-    // TODO: Will we need a close function?
-    delete mpSocket;
-    mpSocket = nullptr;
+    Disconnect();
 
-    delete mpRequest;
-    mpRequest = nullptr;
+    delete[] mpSendBuffer;
+    mpSendBuffer = nullptr;
+
+    delete[] mpMessage;
+    mpMessage = nullptr;
 }
 
 /**
@@ -139,6 +170,9 @@ WebSocket::~WebSocket() {
  * @param pArg Callback user argument
  */
 void WebSocket::Connect(const String& rHost, Callback pCallback, void* pArg) {
+    // Server may be hosting more than one site
+    mHost = rHost;
+
     // Assume port 80
     SockAddr4 addr;
     if (LibSO::ResolveHostName(addr, rHost, "80")) {
@@ -168,10 +202,7 @@ void WebSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
               "You probably want to use a callback function.");
 
     // Close existing connection
-    if (mpSocket != nullptr) {
-        // TODO: Will we need a close function?
-        delete mpSocket;
-    }
+    Disconnect();
 
     SOProtoFamily family =
         rAddr.len == sizeof(SOSockAddrIn) ? SO_PF_INET : SO_PF_INET6;
@@ -180,6 +211,15 @@ void WebSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
     mpSocket = new AsyncSocket(family, SO_SOCK_STREAM);
     K_ASSERT(mpSocket != nullptr);
 
+    // Forget anything from the previous connection
+    mHeaderSize = 0;
+    mHeaderNeed = 2;
+    mMessageSize = 0;
+    mMessageOpcode = EOpcode_Continuation;
+    mCloseCode = 0;
+    mIsCloseSent = false;
+    mIsPingPending = false;
+
     K_LOG("Connecting...\n");
 
     mState = EState_Connecting;
@@ -188,6 +228,104 @@ void WebSocket::Connect(const SockAddrAny& rAddr, Callback pCallback,
     mpSocket->Connect(rAddr, SocketCallbackFunc, this);
 }
 
+/**
+ * @brief Sends a text message
+ *
+ * @param rText UTF-8 encoded text
+ * @return Success
+ */
+bool WebSocket::SendText(const String& rText) {
+    return SendMessage(EOpcode_Text, rText.CStr(), rText.Length());
+}
+
+/**
+ * @brief Sends a binary message
+ *
+ * @param pData Message data
+ * @param size Data size
+ * @return Success
+ */
+bool WebSocket::SendBinary(const void* pData, u32 size) {
+    K_ASSERT(pData != nullptr || size == 0);
+    return SendMessage(EOpcode_Binary, pData, size);
+}
+
+/**
+ * @brief Sends a ping to the server
+ * @details The round-trip time is available from GetPingTime once the
+ * server responds.
+ *
+ * @return Success
+ */
+bool WebSocket::Ping() {
+    AutoMutexLock lock(sMutex);
+
+    if (mState != EState_Open) {
+        return false;
+    }
+
+    mIsPingPending = true;
+    mPingTick = OSGetTick();
+
+    return SendFrame(EOpcode_Ping, nullptr, 0, true);
+}
+
+/**
+ * @brief Begins the close handshake
+ * @details The close callback is invoked once the server responds
+ *
+ * @param code Close status code
+ * @return Success
+ */
+bool WebSocket::Close(u16 code) {
+    AutoMutexLock lock(sMutex);
+
+    if (mState != EState_Open) {
+        return false;
+    }
+
+    // Messages may still arrive until the server answers
+    mState = EState_Closing;
+    return SendClose(code);
+}
+
+/**
+ * @brief Releases the connection and its buffers
+ */
+void WebSocket::Disconnect() {
+    AutoMutexLock lock(sMutex);
+
+    if (mpRecvJob != nullptr) {
+        // Closing the socket aborts the receive, and its callback finishes
+        // the cleanup
+        if (mpRecvJob->isPosted) {
+            mpRecvJob->pSocket = nullptr;
+        } else {
+            delete[] mpRecvJob->pBuffer;
+            delete mpRecvJob;
+        }
+
+        mpRecvJob = nullptr;
+    }
+
+    if (mpUpgradeJob != nullptr) {
+        // Request can't be cancelled while it is in flight, so it keeps the
+        // connection until its callback finishes the cleanup
+        mpUpgradeJob->pSocket = nullptr;
+        mpUpgradeJob->pConnection = mpSocket;
+        mpUpgradeJob = nullptr;
+
+        // Pending operations complete sooner once the connection is shut
+        mpSocket->Shutdown(SO_SHUT_RDWR);
+        mpSocket = nullptr;
+    }
+
+    delete mpSocket;
+    mpSocket = nullptr;
+
+    mState = EState_None;
+}
+
 /**
  * @brief Socket callback function
  *
@@ -202,40 +340,48 @@ void WebSocket::SocketCallbackFunc(SOResult result, void* pArg) {
     // User argument is this object
     WebSocket* p = static_cast<WebSocket*>(pArg);
 
-    // Dispatch state machine
-    switch (p->mState) {
-    case EState_Connecting: {
-        // Connection to the server failed
-        if (result != SO_SUCCESS && result != SO_EISCONN) {
-            if (p->mpConnectCallback != nullptr) {
-                p->mpConnectCallback(EResult_CantConnect,
-                                     p->mpConnectCallbackArg);
-            }
+    AutoMutexLock lock(sMutex);
 
-            p->mState = EState_None;
-            return;
-        }
+    // Socket was disconnected while the connection was in progress
+    if (p->mState != EState_Connecting) {
+        return;
+    }
 
-        K_LOG("Connected, upgrading...\n");
+    // Connection to the server failed
+    if (result != SO_SUCCESS && result != SO_EISCONN) {
+        p->mState = EState_None;
 
-        // Request connection upgrade to WebSocket
-        p->mpRequest = new HttpRequest(p->mpSocket);
-        K_ASSERT(p->mpRequest != nullptr);
+        if (p->mpConnectCallback != nullptr) {
+            p->mpConnectCallback(EResult_CantConnect, p->mpConnectCallbackArg);
+        }
 
-        p->mpRequest->SetHeaderField("Connection", "Upgrade");
-        p->mpRequest->SetHeaderField("Upgrade", "websocket");
-        p->mpRequest->SetHeaderField("Sec-WebSocket-Version",
-                                     WEBSOCKET_VERSION);
-        p->mpRequest->SetHeaderField("Sec-WebSocket-Key", GenerateKey());
-        p->mpRequest->SendAsync(RequestCallback, p);
-        break;
+        return;
     }
 
-    case EState_Receiving: {
-        // TODO: Receive frame and then dispatch to proper state
-        break;
-    }
+    K_LOG("Connected, upgrading...\n");
+
+    UpgradeJob* pJob = new UpgradeJob();
+    K_ASSERT(pJob != nullptr);
+
+    pJob->pSocket = p;
+    pJob->pConnection = nullptr;
+
+    // Request connection upgrade to WebSocket
+    pJob->pRequest = new HttpRequest(p->mpSocket);
+    K_ASSERT(pJob->pRequest != nullptr);
+
+    if (!p->mHost.Empty()) {
+        pJob->pRequest->SetHeaderField("Host", p->mHost);
     }
+
+    pJob->pRequest->SetHeaderField("Connection", "Upgrade");
+    pJob->pRequest->SetHeaderField("Upgrade", "websocket");
+    pJob->pRequest->SetHeaderField("Sec-WebSocket-Version", WEBSOCKET_VERSION);
+    pJob->pRequest->SetHeaderField("Sec-WebSocket-Key", GenerateKey());
+
+    p->mpUpgradeJob = pJob;
+    p->mState = EState_Upgrading;
+    pJob->pRequest->SendAsync(RequestCallback, pJob);
 }
 
 /**
@@ -247,9 +393,30 @@ void WebSocket::SocketCallbackFunc(SOResult result, void* pArg) {
 void WebSocket::RequestCallback(const HttpResponse& rResp, void* pArg) {
     K_ASSERT(pArg != nullptr);
 
-    // User argument is this object
-    WebSocket* p = static_cast<WebSocket*>(pArg);
-    K_ASSERT(p->mpRequest != nullptr);
+    // User argument is the job
+    UpgradeJob* pJob = static_cast<UpgradeJob*>(pArg);
+
+    // Held through the user callbacks, so the socket can't be destroyed by
+    // another thread while they run
+    AutoMutexLock lock(sMutex);
+
+    // Request is finished with the response (see HttpRequest::FinishAsync)
+    HttpRequest* pRequest = pJob->pRequest;
+    WebSocket* p = pJob->pSocket;
+
+    // Socket was disconnected while the request was in flight
+    if (p == nullptr) {
+        delete pRequest;
+        delete pJob->pConnection;
+        delete pJob;
+        return;
+    }
+
+    K_ASSERT(p->mpUpgradeJob == pJob);
+    p->mpUpgradeJob = nullptr;
+    delete pJob;
+
+    EResult result = EResult_Success;
 
     // Validate upgrade-related fields
     if (rResp.error != EHttpErr_Success ||
@@ -257,32 +424,557 @@ void WebSocket::RequestCallback(const HttpResponse& rResp, void* pArg) {
         rResp.header.Get("Connection") != "Upgrade" ||
         rResp.header.Get("Upgrade") != "websocket") {
 
-        if (p->mpConnectCallback != nullptr) {
-            p->mpConnectCallback(EResult_CantUpgrade, p->mpConnectCallbackArg);
-        }
+        result = EResult_CantUpgrade;
+    }
+    // Validate server secret
+    else if (rResp.header.Get("Sec-WebSocket-Accept") !=
+             GenerateAccept(*pRequest->GetHeaderField("Sec-WebSocket-Key"))) {
 
-        p->mState = EState_None;
-        return;
+        result = EResult_CantAccept;
     }
 
-    // Validate server secret
-    if (rResp.header.Get("Sec-WebSocket-Accept") !=
-        GenerateAccept(*p->mpRequest->GetHeaderField("Sec-WebSocket-Key"))) {
+    if (result != EResult_Success) {
+        delete pRequest;
+        p->mState = EState_None;
 
         if (p->mpConnectCallback != nullptr) {
-            p->mpConnectCallback(EResult_CantAccept, p->mpConnectCallbackArg);
+            p->mpConnectCallback(result, p->mpConnectCallbackArg);
         }
 
-        p->mState = EState_None;
         return;
     }
 
+    // Receive buffer is kept for the lifetime of the connection
+    if (p->mpRecvJob == nullptr) {
+        p->mpRecvJob = new RecvJob();
+        K_ASSERT(p->mpRecvJob != nullptr);
+
+        p->mpRecvJob->pSocket = p;
+        p->mpRecvJob->isPosted = false;
+
+        // Socket needs memory allocated in MEM2
+        p->mpRecvJob->pBuffer = new (32, EMemory_MEM2) u8[scRecvBufferSize];
+        K_ASSERT(p->mpRecvJob->pBuffer != nullptr);
+    }
+
+    p->mState = EState_Open;
+
     if (p->mpConnectCallback != nullptr) {
         p->mpConnectCallback(EResult_Success, p->mpConnectCallbackArg);
     }
 
-    p->mState = EState_Receiving;
-    SocketCallbackFunc(SO_SUCCESS, p);
+    // Connect callback may have given up the connection
+    bool active = p->mState == EState_Open || p->mState == EState_Closing;
+
+    // Server may send frames right behind the upgrade response
+    if (active && pRequest->GetUpgradeDataSize() > 0) {
+        active = p->Parse(pRequest->GetUpgradeData(),
+                          pRequest->GetUpgradeDataSize());
+    }
+
+    delete pRequest;
+
+    if (active) {
+        p->PostRecv();
+    }
+}
+
+/**
+ * @brief Receive callback function
+ *
+ * @param result Number of bytes received, or IOS error code
+ * @param pArg Receive job
+ */
+void WebSocket::RecvCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    // User argument is the job
+    RecvJob* pJob = static_cast<RecvJob*>(pArg);
+
+    // Held through the user callbacks, so the socket can't be destroyed by
+    // another thread while they run
+    AutoMutexLock lock(sMutex);
+
+    pJob->isPosted = false;
+
+    // Socket was destroyed while the job was in flight
+    if (pJob->pSocket == nullptr) {
+        delete[] pJob->pBuffer;
+        delete pJob;
+        return;
+    }
+
+    pJob->pSocket->CalcRecv(result);
+}
+
+/**
+ * @brief Receives more frame data
+ */
+void WebSocket::PostRecv() {
+    AutoMutexLock lock(sMutex);
+
+    K_ASSERT(mpSocket != nullptr);
+    K_ASSERT(mpRecvJob != nullptr);
+    K_ASSERT(!mpRecvJob->isPosted);
+
+    mpRecvJob->isPosted = true;
+    LibSO::RecvAsync(mpSocket->GetHandle(), mpRecvJob->pBuffer,
+                     scRecvBufferSize, 0, nullptr, RecvCallbackFunc,
+                     mpRecvJob);
+}
+
+/**
+ * @brief Handles received frame data
+ *
+ * @param result Number of bytes received, or IOS error code
+ */
+void WebSocket::CalcRecv(s32 result) {
+    // Connection was already given up
+    if (mState != EState_Open && mState != EState_Closing) {
+        return;
+    }
+
+    if (result < 0) {
+        mCloseCode = ECloseCode_Abnormal;
+        Finish(EResult_Socket);
+        return;
+    }
+
+    // Server has terminated the connection without a close frame
+    if (result == 0) {
+        mCloseCode = ECloseCode_Abnormal;
+        Finish(EResult_Closed);
+        return;
+    }
+
+    if (!Parse(mpRecvJob->pBuffer, result)) {
+        return;
+    }
+
+    PostRecv();
+}
+
+/**
+ * @brief Parses received frame data
+ *
+ * @param pData Received data
+ * @param size Data size
+ * @return Success (false if the connection was closed)
+ */
+bool WebSocket::Parse(const u8* pData, u32 size) {
+    K_ASSERT(pData != nullptr);
+
+    while (size > 0) {
+        // Frame header
+        if (mHeaderSize < mHeaderNeed) {
+            u32 n = Min(size, mHeaderNeed - mHeaderSize);
+            std::memcpy(mHeader + mHeaderSize, pData, n);
+
+            mHeaderSize += n;
+            pData += n;
+            size -= n;
+
+            if (mHeaderSize < mHeaderNeed) {
+                break;
+            }
+
+            // First two bytes give the size of the rest of the header
+            if (mHeaderNeed == 2) {
+                u32 len = mHeader[1] & 0x7F;
+
+                mHeaderNeed += len == 126 ? 2 : len == 127 ? 8 : 0;
+                mHeaderNeed += (mHeader[1] & 0x80) != 0 ? 4 : 0;
+
+                if (mHeaderSize < mHeaderNeed) {
+                    continue;
+                }
+            }
+
+            if (!ParseHeader()) {
+                return false;
+            }
+
+            // Frame may not have any payload
+            if (mPayloadSize == 0 && !HandleFrame()) {
+                return false;
+            }
+
+            continue;
+        }
+
+        // Control frames may arrive in the middle of a fragmented message
+        u8* pDst = mOpcode >= EOpcode_Close ? mControl
+                                            : mpMessage + mMessageSize;
+
+        u32 n = Min(size, mPayloadSize - mPayloadRead);
+        std::memcpy(pDst + mPayloadRead, pData, n);
+
+        // Servers shouldn't mask their frames, but it costs little to allow
+        if (mIsMasked) {
+            detail::WebSockMask(pDst + mPayloadRead, n, mMaskKey, mPayloadRead);
+        }
+
+        mPayloadRead += n;
+        pData += n;
+        size -= n;
+
+        if (mPayloadRead == mPayloadSize && !HandleFrame()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decodes a complete frame header
+ *
+ * @return Success (false if the connection was closed)
+ */
+bool WebSocket::ParseHeader() {
+    // No extensions were negotiated, so the reserved bits must be clear
+    if ((mHeader[0] & 0x70) != 0) {
+        Fail(EResult_Protocol, ECloseCode_Protocol);
+        return false;
+    }
+
+    mIsFin = (mHeader[0] & 0x80) != 0;
+    mOpcode = mHeader[0] & 0x0F;
+    mIsMasked = (mHeader[1] & 0x80) != 0;
+
+    u32 len = mHeader[1] & 0x7F;
+    u32 pos = 2;
+
+    // Extended lengths are big endian
+    if (len == 126) {
+        len = mHeader[2] << 8 | mHeader[3];
+        pos += 2;
+    } else if (len == 127) {
+        // Anything over 4GB could never fit in memory
+        if (mHeader[2] != 0 || mHeader[3] != 0 || mHeader[4] != 0 ||
+            mHeader[5] != 0) {
+            Fail(EResult_Protocol, ECloseCode_TooBig);
+            return false;
+        }
+
+        len = static_cast<u32>(mHeader[6]) << 24 | mHeader[7] << 16 |
+              mHeader[8] << 8 | mHeader[9];
+        pos += 8;
+    }
+
+    if (mIsMasked) {
+        std::memcpy(mMaskKey, mHeader + pos, sizeof(mMaskKey));
+    }
+
+    mPayloadSize = len;
+    mPayloadRead = 0;
+
+    switch (mOpcode) {
+    case EOpcode_Continuation: {
+        // Nothing to continue
+        if (mMessageOpcode == EOpcode_Continuation) {
+            Fail(EResult_Protocol, ECloseCode_Protocol);
+            return false;
+        }
+
+        return ReserveMessage(len);
+    }
+
+    case EOpcode_Text:
+    case EOpcode_Binary: {
+        // Previous message isn't finished
+        if (mMessageOpcode != EOpcode_Continuation) {
+            Fail(EResult_Protocol, ECloseCode_Protocol);
+            return false;
+        }
+
+        mMessageOpcode = mOpcode;
+        mMessageSize = 0;
+        return ReserveMessage(len);
+    }
+
+    case EOpcode_Close:
+    case EOpcode_Ping:
+    case EOpcode_Pong: {
+        // Control frames can't be fragmented
+        if (!mIsFin || len > scMaxControlSize) {
+            Fail(EResult_Protocol, ECloseCode_Protocol);
+            return false;
+        }
+
+        return true;
+    }
+
+    default: {
+        Fail(EResult_Protocol, ECloseCode_Protocol);
+        return false;
+    }
+    }
+}
+
+/**
+ * @brief Handles a complete frame
+ *
+ * @return Success (false if the connection was closed)
+ */
+bool WebSocket::HandleFrame() {
+    // Prepare for the next frame
+    mHeaderSize = 0;
+    mHeaderNeed = 2;
+
+    switch (mOpcode) {
+    case EOpcode_Continuation:
+    case EOpcode_Text:
+    case EOpcode_Binary: {
+        mMessageSize += mPayloadSize;
+
+        // Wait for the rest of the fragments
+        if (!mIsFin) {
+            return true;
+        }
+
+        // Terminator makes text messages usable as C-style strings
+        mpMessage[mMessageSize] = '\0';
+
+        WebSockMessage msg;
+        msg.type = WebSockMessage::EType_Binary;
+        if (mMessageOpcode == EOpcode_Text) {
+            msg.type = WebSockMessage::EType_Text;
+        }
+
+        msg.pData = mpMessage;
+        msg.size = mMessageSize;
+
+        mMessageOpcode = EOpcode_Continuation;
+        mMessageSize = 0;
+
+        if (mpMessageCallback != nullptr) {
+            mpMessageCallback(&msg, mpMessageCallbackArg);
+        }
+
+        return true;
+    }
+
+    case EOpcode_Ping: {
+        // Nothing may follow our close frame
+        if (!mIsCloseSent) {
+            SendFrame(EOpcode_Pong, mControl, mPayloadSize, true);
+        }
+
+        return true;
+    }
+
+    case EOpcode_Pong: {
+        // Unsolicited pongs are only heartbeats
+        if (mIsPingPending) {
+            mPingTime = OS_TICKS_TO_MSEC(OSGetTick() - mPingTick);
+            mIsPingPending = false;
+        }
+
+        return true;
+    }
+
+    case EOpcode_Close: {
+        // Status code is optional (big endian)
+        mCloseCode = mPayloadSize >= 2 ? mControl[0] << 8 | mControl[1]
+                                       : ECloseCode_NoStatus;
+
+        // Echo the status code to complete the handshake
+        if (!mIsCloseSent) {
+            SendClose(mPayloadSize >= 2 ? mCloseCode : ECloseCode_Normal);
+        }
+
+        Finish(EResult_Success);
+        return false;
+    }
+
+    default: {
+        K_ASSERT_EX(false, "Unexpected opcode: %d", mOpcode);
+        return false;
+    }
+    }
+}
+
+/**
+ * @brief Makes room for a data frame's payload in the message buffer
+ *
+ * @param size Payload size
+ * @return Success
+ */
+bool WebSocket::ReserveMessage(u32 size) {
+    // Written this way to avoid overflow
+    if (size > mMaxMessageSize - mMessageSize) {
+        Fail(EResult_Protocol, ECloseCode_TooBig);
+        return false;
+    }
+
+    // Includes space for the terminator
+    u32 need = mMessageSize + size + 1;
+    if (need <= mMessageCapacity) {
+        return true;
+    }
+
+    // Grow geometrically so fragmented messages don't reallocate every frame
+    u32 capacity = Max(need, Min(mMessageCapacity * 2, mMaxMessageSize + 1));
+
+    u8* pMessage = new u8[capacity];
+    K_ASSERT(pMessage != nullptr);
+
+    if (mpMessage != nullptr) {
+        std::memcpy(pMessage, mpMessage, mMessageSize);
+        delete[] mpMessage;
+    }
+
+    mpMessage = pMessage;
+    mMessageCapacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Sends a message, fragmenting it if necessary
+ *
+ * @param opcode Message opcode
+ * @param pData Message data
+ * @param size Data size
+ * @return Success
+ */
+bool WebSocket::SendMessage(EOpcode opcode, const void* pData, u32 size) {
+    // Fragments of one message can't be interleaved with another's
+    AutoMutexLock lock(sMutex);
+
+    if (mState != EState_Open) {
+        return false;
+    }
+
+    const u8* pBytes = static_cast<const u8*>(pData);
+
+    // Empty messages still need a frame
+    do {
+        u32 n = Min(size, static_cast<u32>(scMaxSendPayload));
+
+        if (!SendFrame(opcode, pBytes, n, n == size)) {
+            return false;
+        }
+
+        // Later frames continue the message
+        opcode = EOpcode_Continuation;
+        pBytes += n;
+        size -= n;
+    } while (size > 0);
+
+    return true;
+}
+
+/**
+ * @brief Sends a single (masked) frame
+ *
+ * @param opcode Frame opcode
+ * @param pData Payload data
+ * @param size Payload size
+ * @param fin Whether this is the final frame of the message
+ * @return Success
+ */
+bool WebSocket::SendFrame(EOpcode opcode, const void* pData, u32 size,
+                          bool fin) {
+    K_ASSERT(pData != nullptr || size == 0);
+    K_ASSERT(size <= scMaxSendPayload);
+
+    AutoMutexLock lock(sMutex);
+
+    if (mpSocket == nullptr) {
+        return false;
+    }
+
+    // Header goes right before the payload, which starts word-aligned so
+    // masking can work a word at a time
+    u8* pPayload = mpSendBuffer + scSendHeaderRoom;
+
+    // Sent frames are always masked, and never need a 64-bit length
+    u32 headerSize = (size < 126 ? 2 : 4) + sizeof(mMaskKey);
+    u8* pHeader = pPayload - headerSize;
+
+    pHeader[0] = (fin ? 0x80 : 0x00) | opcode;
+
+    if (size < 126) {
+        pHeader[1] = 0x80 | size;
+    } else {
+        pHeader[1] = 0x80 | 126;
+        pHeader[2] = static_cast<u8>(size >> 8);
+        pHeader[3] = static_cast<u8>(size);
+    }
+
+    // Clients must use a new masking key for every frame
+    u8* pKey = pPayload - sizeof(mMaskKey);
+    u32 key = mRandom.NextU32();
+    std::memcpy(pKey, &key, sizeof(u32));
+
+    if (size > 0) {
+        std::memcpy(pPayload, pData, size);
+        detail::WebSockMask(pPayload, size, pKey, 0);
+    }
+
+    // Data is copied by the socket, so the buffer can be reused right away
+    Optional<u32> sent = mpSocket->SendBytes(pHeader, headerSize + size);
+    return sent.HasValue();
+}
+
+/**
+ * @brief Sends a close frame
+ *
+ * @param code Close status code
+ * @return Success
+ */
+bool WebSocket::SendClose(u16 code) {
+    // Status code is big endian
+    u8 payload[2];
+    payload[0] = static_cast<u8>(code >> 8);
+    payload[1] = static_cast<u8>(code);
+
+    mIsCloseSent = true;
+    return SendFrame(EOpcode_Close, payload, sizeof(payload), true);
+}
+
+/**
+ * @brief Closes the connection without a handshake
+ *
+ * @param result Close result
+ * @param code Close status code to send (none if zero)
+ */
+void WebSocket::Fail(EResult result, u16 code) {
+    // Let the server know why, if it is still listening
+    if (code != 0 && !mIsCloseSent) {
+        SendClose(code);
+    }
+
+    mCloseCode = code;
+    Finish(result);
+}
+
+/**
+ * @brief Ends the connection and notifies the user
+ *
+ * @param result Close result
+ */
+void WebSocket::Finish(EResult result) {
+    if (mState == EState_Closed) {
+        return;
+    }
+
+    mState = EState_Closed;
+
+    // Socket is kept until the next connection (or destruction), as this
+    // may be running from its callback
+    if (mpSocket != nullptr) {
+        mpSocket->Shutdown(SO_SHUT_RD);
+    }
+
+    // Partial message will never be completed
+    mMessageOpcode = EOpcode_Continuation;
+    mMessageSize = 0;
+
+    if (mpCloseCallback != nullptr) {
+        mpCloseCallback(result, mpCloseCallbackArg);
+    }
 }
 
 } // namespace kiwi
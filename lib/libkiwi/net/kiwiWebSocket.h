@@ -3,18 +3,59 @@
 #include <libkiwi/k_types.h>
 #include <libkiwi/net/kiwiAsyncSocket.h>
 #include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/util/kiwiRandom.h>
+
+#include <revolution/OS.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_net
 //! @{
 
+// Forward declarations
+class HttpRequest;
+struct HttpResponse;
+
 /**
  * @brief WebSocket message
  */
-struct WebSockMessage {};
+struct WebSockMessage {
+    /**
+     * @brief Message type
+     */
+    enum EType {
+        EType_Text,   //!< UTF-8 encoded application text
+        EType_Binary, //!< Application binary data
+    };
+
+    EType type;      //!< Message type
+    const u8* pData; //!< Message payload (null-terminated)
+    u32 size;        //!< Payload size (excluding the terminator)
+};
+
+namespace detail {
+//! @addtogroup libkiwi_net
+//! @{
+
+/**
+ * @brief Applies a WebSocket masking key to payload data (in-place)
+ *
+ * @param pData Payload data
+ * @param size Data size
+ * @param pKey Masking key
+ * @param phase Position of the data within the payload
+ */
+void WebSockMask(u8* pData, u32 size, const u8* pKey, u32 phase);
+
+//! @}
+} // namespace detail
 
 /**
  * @brief Web socket (asynchronous)
+ * @details Messages may arrive fragmented across several frames, and are
+ * only delivered once complete. Pings from the server are answered
+ * automatically. Frames are received into a reusable buffer, and payload
+ * (un)masking is done a word at a time.
+ * @note Callbacks are invoked from the IOS dispatcher thread
  */
 class WebSocket {
 public:
@@ -26,6 +67,22 @@ public:
         EResult_CantConnect, //!< Can't connect to the server
         EResult_CantUpgrade, //!< Can't upgrade the HTTP connection
         EResult_CantAccept,  //!< Can't authenticate server Accept field
+        EResult_Closed,      //!< Connection closed without a close frame
+        EResult_Protocol,    //!< Server violated the protocol
+        EResult_Socket,      //!< Misc. socket error
+    };
+
+    /**
+     * @brief Close status codes
+     */
+    enum ECloseCode {
+        ECloseCode_Normal = 1000,      //!< Normal closure
+        ECloseCode_GoingAway = 1001,   //!< Endpoint is going away
+        ECloseCode_Protocol = 1002,    //!< Protocol error
+        ECloseCode_Unsupported = 1003, //!< Unsupported data type
+        ECloseCode_NoStatus = 1005,    //!< No status code was given
+        ECloseCode_Abnormal = 1006,    //!< Connection closed abnormally
+        ECloseCode_TooBig = 1009,      //!< Message is too big to process
     };
 
     /**
@@ -46,6 +103,9 @@ public:
      */
     typedef void (*MessageCallback)(const WebSockMessage* pMessage, void* pArg);
 
+    //! Default limit on the size of received messages
+    static const u32 DEFAULT_MAX_MESSAGE_SIZE = 64 * 1024;
+
 public:
     /**
      * @brief Constructor
@@ -53,6 +113,7 @@ public:
     WebSocket();
     /**
      * @brief Destructor
+     * @note Don't destroy the socket from one of its own callbacks
      */
     ~WebSocket();
 
@@ -67,6 +128,29 @@ public:
         mpMessageCallbackArg = pArg;
     }
 
+    /**
+     * @brief Sets the connection close callback function
+     * @details The result is EResult_Success if the close handshake
+     * completed, and the close status code is available from GetCloseCode.
+     *
+     * @param pCallback Callback function
+     * @param pArg Callback user argument
+     */
+    void SetCloseCallback(Callback pCallback, void* pArg = nullptr) {
+        mpCloseCallback = pCallback;
+        mpCloseCallbackArg = pArg;
+    }
+
+    /**
+     * @brief Sets the size limit for received messages
+     * @details Larger messages close the connection (ECloseCode_TooBig)
+     *
+     * @param max Maximum message size
+     */
+    void SetMaxMessageSize(u32 max) {
+        mMaxMessageSize = max;
+    }
+
     /**
      * @brief Connects to the specified server hostname
      *
@@ -85,17 +169,126 @@ public:
     void Connect(const SockAddrAny& rAddr, Callback pCallback,
                  void* pArg = nullptr);
 
+    /**
+     * @brief Tests whether messages can be sent
+     */
+    bool IsOpen() const {
+        return mState == EState_Open;
+    }
+
+    /**
+     * @brief Sends a text message
+     *
+     * @param rText UTF-8 encoded text
+     * @return Success
+     */
+    bool SendText(const String& rText);
+    /**
+     * @brief Sends a binary message
+     *
+     * @param pData Message data
+     * @param size Data size
+     * @return Success
+     */
+    bool SendBinary(const void* pData, u32 size);
+
+    /**
+     * @brief Sends a ping to the server
+     * @details The round-trip time is available from GetPingTime once the
+     * server responds.
+     *
+     * @return Success
+     */
+    bool Ping();
+    /**
+     * @brief Gets the round-trip time of the last answered ping
+     *
+     * @return Round-trip time, in milliseconds
+     */
+    u32 GetPingTime() const {
+        return mPingTime;
+    }
+
+    /**
+     * @brief Begins the close handshake
+     * @details The close callback is invoked once the server responds
+     *
+     * @param code Close status code
+     * @return Success
+     */
+    bool Close(u16 code = ECloseCode_Normal);
+    /**
+     * @brief Gets the status code the connection was closed with
+     */
+    u16 GetCloseCode() const {
+        return mCloseCode;
+    }
+
 private:
     /**
      * @brief Asynchronous state
      */
     enum EState {
-        EState_None,
-        EState_Connecting,
-        EState_Receiving,
+        EState_None,       //!< Not connected
+        EState_Connecting, //!< Establishing the TCP connection
+        EState_Upgrading,  //!< Performing the HTTP upgrade
+        EState_Open,       //!< Exchanging messages
+        EState_Closing,    //!< Close frame sent, awaiting the server's
+        EState_Closed,     //!< Connection is over
+    };
+
+    /**
+     * @brief Frame opcode
+     */
+    enum EOpcode {
+        EOpcode_Continuation, //!< Intermediate frame of a fragmented message
+        EOpcode_Text,         //!< UTF-8 encoded application text
+        EOpcode_Binary,       //!< Application binary data
+        EOpcode_Close = 8,    //!< Close frame
+        EOpcode_Ping,         //!< Heartbeat/latency (first)
+        EOpcode_Pong,         //!< Heartbeat/latency (second)
+    };
+
+    /**
+     * @brief Receive operation
+     * @details Outlives the socket if it is destroyed while the operation is
+     * in flight.
+     */
+    struct RecvJob {
+        WebSocket* pSocket; //!< Owner socket (null once destroyed)
+        u8* pBuffer;        //!< Receive buffer (MEM2)
+        bool isPosted;      //!< Whether an ioctl is in flight
     };
 
+    /**
+     * @brief Connection upgrade operation
+     * @details Requests can't be cancelled while they are in flight, so this
+     * keeps the request and its connection alive if the socket is
+     * disconnected in the meantime.
+     */
+    struct UpgradeJob {
+        WebSocket* pSocket;       //!< Owner socket (null once disconnected)
+        HttpRequest* pRequest;    //!< Upgrade request
+        AsyncSocket* pConnection; //!< Connection (once disconnected)
+    };
+
+    //! Largest frame header (2 bytes, 64-bit length, masking key)
+    static const u32 scMaxHeaderSize = 14;
+    //! Largest control frame payload
+    static const u32 scMaxControlSize = 125;
+    //! Room for the header before the (word-aligned) send payload
+    static const u32 scSendHeaderRoom = 16;
+    //! Largest payload of sent frames (larger messages are fragmented)
+    static const u32 scMaxSendPayload = 4096;
+    //! Size of the reusable receive buffer
+    static const u32 scRecvBufferSize = 2048;
+
 private:
+    /**
+     * @brief Releases the connection and its buffers
+     */
+    void Disconnect();
+
     /**
      * @brief Socket callback function
      *
@@ -112,16 +305,138 @@ private:
      */
     static void RequestCallback(const HttpResponse& rResp, void* pArg);
 
+    /**
+     * @brief Receive callback function
+     *
+     * @param result Number of bytes received, or IOS error code
+     * @param pArg Receive job
+     */
+    static void RecvCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Receives more frame data
+     */
+    void PostRecv();
+    /**
+     * @brief Handles received frame data
+     *
+     * @param result Number of bytes received, or IOS error code
+     */
+    void CalcRecv(s32 result);
+
+    /**
+     * @brief Parses received frame data
+     *
+     * @param pData Received data
+     * @param size Data size
+     * @return Success (false if the connection was closed)
+     */
+    bool Parse(const u8* pData, u32 size);
+    /**
+     * @brief Decodes a complete frame header
+     *
+     * @return Success (false if the connection was closed)
+     */
+    bool ParseHeader();
+    /**
+     * @brief Handles a complete frame
+     *
+     * @return Success (false if the connection was closed)
+     */
+    bool HandleFrame();
+    /**
+     * @brief Makes room for a data frame's payload in the message buffer
+     *
+     * @param size Payload size
+     * @return Success
+     */
+    bool ReserveMessage(u32 size);
+
+    /**
+     * @brief Sends a message, fragmenting it if necessary
+     *
+     * @param opcode Message opcode
+     * @param pData Message data
+     * @param size Data size
+     * @return Success
+     */
+    bool SendMessage(EOpcode opcode, const void* pData, u32 size);
+    /**
+     * @brief Sends a single (masked) frame
+     *
+     * @param opcode Frame opcode
+     * @param pData Payload data
+     * @param size Payload size
+     * @param fin Whether this is the final frame of the message
+     * @return Success
+     */
+    bool SendFrame(EOpcode opcode, const void* pData, u32 size, bool fin);
+    /**
+     * @brief Sends a close frame
+     *
+     * @param code Close status code
+     * @return Success
+     */
+    bool SendClose(u16 code);
+
+    /**
+     * @brief Closes the connection without a handshake
+     *
+     * @param result Close result
+     * @param code Close status code to send (none if zero)
+     */
+    void Fail(EResult result, u16 code);
+    /**
+     * @brief Ends the connection and notifies the user
+     *
+     * @param result Close result
+     */
+    void Finish(EResult result);
+
 private:
-    EState mState;          //!< Asynchronous state
-    AsyncSocket* mpSocket;  //!< TCP socket
-    HttpRequest* mpRequest; //!< HTTP request
+    EState mState;            //!< Asynchronous state
+    AsyncSocket* mpSocket;    //!< TCP socket
+    UpgradeJob* mpUpgradeJob; //!< Active upgrade request
+    String mHost;             //!< Server hostname
+    Random mRandom;           //!< Masking key generator
 
     Callback mpConnectCallback; //!< Connect callback
     void* mpConnectCallbackArg; //!< Connect callback user argument
 
+    Callback mpCloseCallback; //!< Close callback
+    void* mpCloseCallbackArg; //!< Close callback user argument
+
     MessageCallback mpMessageCallback; //!< Message receive callback
     void* mpMessageCallbackArg;        //!< Message callback user argument
+
+    RecvJob* mpRecvJob;  //!< Active receive operation
+    u8* mpSendBuffer;    //!< Frame staging buffer
+    u32 mSendBufferSize; //!< Frame staging buffer size
+
+    u8 mHeader[scMaxHeaderSize]; //!< Frame header being received
+    u32 mHeaderSize;             //!< Header data received so far
+    u32 mHeaderNeed;             //!< Header size, once known
+    u8 mOpcode;                  //!< Frame opcode
+    bool mIsFin;                 //!< Whether the frame ends its message
+    bool mIsMasked;              //!< Whether the payload is masked
+    u8 mMaskKey[4];              //!< Payload masking key
+    u32 mPayloadSize;            //!< Frame payload size
+    u32 mPayloadRead;            //!< Frame payload received so far
+
+    u8 mControl[scMaxControlSize + 1]; //!< Control frame payload
+    u8* mpMessage;                     //!< Message being reassembled
+    u32 mMessageCapacity;              //!< Message buffer size
+    u32 mMessageSize;                  //!< Message data received so far
+    u8 mMessageOpcode;                 //!< Message opcode (text/binary)
+    u32 mMaxMessageSize;               //!< Received message size limit
+
+    u16 mCloseCode;      //!< Close status code
+    bool mIsCloseSent;   //!< Whether a close frame has been sent
+    bool mIsPingPending; //!< Whether a ping awaits its pong
+    u32 mPingTick;       //!< Time when the last ping was sent
+    u32 mPingTime;       //!< Round-trip time of the last ping (msec)
+
+    static OSMutex sMutex; //!< Socket lock
 };
 
 //! @}
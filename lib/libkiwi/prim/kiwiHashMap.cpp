@@ -1,5 +1,7 @@
 #include <libkiwi.h>
 
+#include <cstring>
+
 namespace kiwi {
 namespace {
 
@@ -10,6 +12,7 @@ namespace {
  * @param r Number of bits to rotate
  */
 u32 rotl32(register u32 x, register int r) {
+#ifdef __MWERKS__
     // clang-format off
     asm {
         rotlw x, x, r
@@ -17,6 +20,23 @@ u32 rotl32(register u32 x, register int r) {
     // clang-format on
 
     return x;
+#else
+    return (x << r) | (x >> (32 - r));
+#endif
+}
+
+/**
+ * @brief Reads a 32-bit hash block
+ *
+ * @param pData Block data
+ */
+u32 ReadBlock(const u8* pData) {
+#ifdef __MWERKS__
+    return *reinterpret_cast<const u32*>(pData);
+#else
+    // Big endian like the console, and u32 may be wider than 32 bits
+    return pData[0] << 24 | pData[1] << 16 | pData[2] << 8 | pData[3];
+#endif
 }
 
 /**
@@ -45,7 +65,7 @@ u32 fmix32(u32 h) {
  */
 hash_t HashImpl(const void* pKey, s32 len) {
     K_ASSERT(pKey != nullptr);
-    K_ASSERT(len > 0);
+    K_ASSERT(len >= 0);
 
     const u8* pData = static_cast<const u8*>(pKey);
     int nblocks = len / 4;
@@ -54,9 +74,9 @@ hash_t HashImpl(const void* pKey, s32 len) {
     u32 c1 = 0xCC9E2D51;
     u32 c2 = 0x1B873593;
 
-    const u32* pBlocks = reinterpret_cast<const u32*>(pData + (nblocks * 4));
+    const u8* pBlocks = pData + (nblocks * 4);
     for (int i = -nblocks; i; i++) {
-        u32 k1 = pBlocks[i];
+        u32 k1 = ReadBlock(pBlocks + i * 4);
 
         k1 *= c1;
         k1 = rotl32(k1, 15);
@@ -85,4 +105,32 @@ hash_t HashImpl(const void* pKey, s32 len) {
     return fmix32(h1);
 }
 
+/**
+ * @brief Hashes a key of any type
+ * @note Hash support for C-style strings (matches the String hash)
+ *
+ * @param pKey Key
+ */
+hash_t Hash(const char* pKey) {
+    K_ASSERT(pKey != nullptr);
+    return HashImpl(pKey, std::strlen(pKey));
+}
+
+/**
+ * @brief Hashes a key of any type
+ * @note Hash support for wide-char C-style strings (matches the WString hash)
+ *
+ * @param pwKey Key
+ */
+hash_t Hash(const wchar_t* pwKey) {
+    K_ASSERT(pwKey != nullptr);
+
+    u32 len = 0;
+    while (pwKey[len] != L'\0') {
+        len++;
+    }
+
+    return HashImpl(pwKey, len * sizeof(wchar_t));
+}
+
 } // namespace kiwi
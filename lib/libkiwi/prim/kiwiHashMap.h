@@ -1,8 +1,9 @@
 #ifndef LIBKIWI_PRIM_HASHMAP_H
 #define LIBKIWI_PRIM_HASHMAP_H
+#include <libkiwi/core/kiwiAllocator.h>
+#include <libkiwi/debug/kiwiAssert.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/prim/kiwiLinkList.h>
-#include <libkiwi/prim/kiwiOptional.h>
 
 namespace kiwi {
 //! @addtogroup libkiwi_prim
@@ -33,37 +34,66 @@ template <typename TKey> K_INLINE hash_t Hash(const TKey& rKey) {
 }
 
 /**
- * @brief Key/value pair map
+ * @brief Hashes a key of any type
+ * @note Hash support for C-style strings (matches the String hash)
+ *
+ * @param pKey Key
+ */
+hash_t Hash(const char* pKey);
+/**
+ * @brief Hashes a key of any type
+ * @note Hash support for wide-char C-style strings (matches the WString hash)
  *
- * @todo Track load factor, expand + re-hash when high
+ * @param pwKey Key
+ */
+hash_t Hash(const wchar_t* pwKey);
+
+/**
+ * @brief Key/value pair map
+ * @details Open-addressing hash table with linear probing. Each slot has a
+ * control byte which holds either its state (empty/deleted) or seven bits of
+ * its key's hash, so most probes never have to compare keys.
  */
 template <typename TKey, typename TValue> class TMap {
-    friend class ConstIterator; // Access 'Bucket' structure
+    friend class ConstIterator; // Access 'Slot' structure
 
 public:
-    // Default bucket count
-    static const u32 scDefaultCapacity = 32;
+    // Bucket count allocated on the first insertion
+    static const u32 scDefaultCapacity = 8;
 
 private:
-    struct Bucket {
+    /**
+     * @brief Key/value storage
+     */
+    struct Slot {
         /**
          * @brief Constructor
+         *
+         * @param rKey Key
          */
-        Bucket() : used(false), pChained(nullptr) {}
+        explicit Slot(const TKey& rKey) : key(rKey), value() {}
 
         /**
-         * @brief Destructor
+         * @brief Constructor
+         *
+         * @param rKey Key
+         * @param rValue Value
          */
-        ~Bucket() {
-            // Recurse
-            delete pChained;
-        }
+        Slot(const TKey& rKey, const TValue& rValue)
+            : key(rKey), value(rValue) {}
 
-        Optional<TKey> key;
-        Optional<TValue> value;
+        TKey key;
+        TValue value;
+    };
 
-        bool used;        // Bucket is in use
-        Bucket* pChained; // Chains
+    /**
+     * @brief Slot control byte
+     * @details Values below 0x80 mark a used slot (and are the upper seven
+     * bits of the key's hash)
+     */
+    enum ECtrl {
+        ECtrl_Empty = 0x80,   //!< Slot has never been used
+        ECtrl_Deleted = 0xFE, //!< Slot was used, but the key was removed
     };
 
 public:
@@ -74,16 +104,15 @@ public:
         /**
          * @brief Constructor
          *
-         * @param capacity Map capacity
-         * @param pBuckets Array of buckets
+         * @param pMap Parent map
+         * @param index Slot index
          */
-        ConstIterator(u32 capacity, const Bucket* pBuckets)
-            : mIndex(0),
-              mCapacity(capacity),
-              mpBuckets(pBuckets),
-              mpIter(mpBuckets) {
+        ConstIterator(const TMap* pMap, u32 index)
+            : mpParent(pMap), mIndex(index) {
+            K_ASSERT(mpParent != nullptr);
+
             // Find first non-empty value
-            if (mpIter != nullptr && !mpIter->used) {
+            if (mIndex < mpParent->mCapacity && !mpParent->IsUsed(mIndex)) {
                 ++*this;
             }
         }
@@ -106,15 +135,15 @@ public:
          * @brief Get key from this element
          */
         const TKey& Key() const {
-            K_ASSERT(mpIter != nullptr);
-            return *mpIter->key;
+            K_ASSERT(mIndex < mpParent->mCapacity);
+            return mpParent->GetSlot(mIndex).key;
         }
         /**
          * @brief Get value from this element
          */
         const TValue& Value() const {
-            K_ASSERT(mpIter != nullptr);
-            return *mpIter->value;
+            K_ASSERT(mIndex < mpParent->mCapacity);
+            return mpParent->GetSlot(mIndex).value;
         }
 
         /**
@@ -131,33 +160,33 @@ public:
         }
 
         bool operator==(ConstIterator rhs) const {
-            return mpIter == rhs.mpIter;
+            return mpParent == rhs.mpParent && mIndex == rhs.mIndex;
         }
         bool operator!=(ConstIterator rhs) const {
-            return mpIter != rhs.mpIter;
+            return mpParent != rhs.mpParent || mIndex != rhs.mIndex;
         }
 
     private:
-        u32 mIndex;    // Current bucket index
-        u32 mCapacity; // Maximum bucket index
-
-        const Bucket* mpBuckets; // Current bucket root
-        const Bucket* mpIter;    // Current bucket chain
+        const TMap* mpParent; // Parent map
+        u32 mIndex;           // Current slot index
     };
 
 public:
     /**
      * @brief Constructor
+     * @note No memory is allocated until the first insertion
      *
-     * @param capacity Starting number of buckets
+     * @param capacity Number of elements to reserve space for
+     * @param pAllocator Slot allocator (nullptr for the default heap)
      */
-    TMap(u32 capacity = scDefaultCapacity)
-        : mSize(0), mCapacity(capacity), mpBuckets(nullptr) {
-        K_ASSERT(mCapacity > 0);
-        K_ASSERT(mCapacity < HASH_MAX);
-
-        mpBuckets = new Bucket[mCapacity];
-        K_ASSERT(mpBuckets != nullptr);
+    TMap(u32 capacity = 0, IAllocator* pAllocator = nullptr)
+        : mSize(0),
+          mDeleted(0),
+          mCapacity(0),
+          mpSlots(nullptr),
+          mpCtrl(nullptr),
+          mpAllocator(pAllocator) {
+        Reserve(capacity);
     }
 
     /**
@@ -172,7 +201,32 @@ public:
      * @brief Destructor
      */
     ~TMap() {
-        delete[] mpBuckets;
+        Clear();
+        IAllocator::FreeTo(mpAllocator, mpSlots);
+    }
+
+    /**
+     * @brief Map copy assignment
+     *
+     * @param rOther Map to copy
+     */
+    TMap& operator=(const TMap& rOther);
+
+    /**
+     * @brief Sets the allocator used for the slots
+     * @note Only possible before the slots are allocated
+     *
+     * @param pAllocator Slot allocator (nullptr for the default heap)
+     */
+    void SetAllocator(IAllocator* pAllocator) {
+        K_ASSERT_EX(mpSlots == nullptr, "Slots are already allocated");
+        mpAllocator = pAllocator;
+    }
+    /**
+     * @brief Gets the allocator used for the slots
+     */
+    IAllocator* GetAllocator() const {
+        return mpAllocator;
     }
 
     /**
@@ -183,7 +237,7 @@ public:
      * @return Existing value, or new entry
      */
     TValue& operator[](const TKey& rKey) {
-        return *Create(rKey).value;
+        return Create(rKey).value;
     }
 
     /**
@@ -205,6 +259,20 @@ public:
      */
     bool Remove(const TKey& rKey, TValue* pRemoved = nullptr);
 
+    /**
+     * @brief Removes all keys from the map
+     * @note The slot buffer is kept for reuse
+     */
+    void Clear();
+
+    /**
+     * @brief Reserves space so the specified number of elements can be held
+     * without rehashing
+     *
+     * @param capacity Number of elements
+     */
+    void Reserve(u32 capacity);
+
     /**
      * @brief Look for the value corresponding to a key
      *
@@ -212,13 +280,22 @@ public:
      * @return Value if it exists
      */
     TValue* Find(const TKey& rKey) const {
-        Bucket* pBucket = Search(rKey);
-
-        if (pBucket != nullptr) {
-            return &*pBucket->value;
-        }
+        u32 i = Search(rKey);
+        return i != npos ? &GetSlot(i).value : nullptr;
+    }
 
-        return nullptr;
+    /**
+     * @brief Look for the value corresponding to a key
+     * @details Heterogeneous lookup, for when the key type can be compared
+     * with TKey without constructing a TKey (i.e. C-style strings).
+     * @note Hash(pKey) must give the same result as the equivalent TKey
+     *
+     * @param pKey Key
+     * @return Value if it exists
+     */
+    template <typename TLookup> TValue* Find(const TLookup* pKey) const {
+        u32 i = Search(pKey);
+        return i != npos ? &GetSlot(i).value : nullptr;
     }
 
     /**
@@ -242,6 +319,15 @@ public:
     bool Contains(const TKey& rKey) const {
         return Find(rKey) != nullptr;
     }
+    /**
+     * @brief Check whether a key exists
+     * @details Heterogeneous lookup (see Find)
+     *
+     * @param pKey Key
+     */
+    template <typename TLookup> bool Contains(const TLookup* pKey) const {
+        return Find(pKey) != nullptr;
+    }
 
     /**
      * @brief Get number of elements in the map
@@ -287,24 +373,99 @@ public:
      * @brief Gets iterator to beginning of map (const view)
      */
     ConstIterator Begin() const {
-        return ConstIterator(mCapacity, mpBuckets);
+        return ConstIterator(this, 0);
     }
 
     /**
      * @brief Gets iterator to end of map (const-view)
      */
     ConstIterator End() const {
-        return ConstIterator(0, nullptr);
+        return ConstIterator(this, mCapacity);
     }
 
 private:
-    Bucket* Search(const TKey& rKey) const;
-    Bucket& Create(const TKey& rKey);
+    //! Invalid slot index
+    static const u32 npos = static_cast<u32>(-1);
+
+    // Maximum load factor (used + deleted slots), in eighths (75%)
+    static const u32 scMaxLoad = 6;
+
+private:
+    /**
+     * @brief Accesses a slot's storage
+     *
+     * @param i Slot index
+     */
+    Slot& GetSlot(u32 i) const {
+        K_ASSERT(i < mCapacity);
+        return reinterpret_cast<Slot*>(mpSlots)[i];
+    }
+
+    /**
+     * @brief Tests whether a slot holds a key
+     *
+     * @param i Slot index
+     */
+    bool IsUsed(u32 i) const {
+        K_ASSERT(i < mCapacity);
+        return (mpCtrl[i] & ECtrl_Empty) == 0;
+    }
+
+    /**
+     * @brief Gets the control byte for a used slot with the specified hash
+     *
+     * @param hash Key hash
+     */
+    static u8 HashCtrl(hash_t hash) {
+        // Masked in case hash_t is wider than 32 bits (i.e. host builds)
+        return static_cast<u8>((hash >> 25) & 0x7F);
+    }
+
+    /**
+     * @brief Finds the slot index of a key
+     *
+     * @param rKey Key (any type comparable with TKey)
+     * @return Slot index, or npos if the key doesn't exist
+     */
+    template <typename TLookup> u32 Search(const TLookup& rKey) const;
+
+    /**
+     * @brief Finds the slot for a key, inserting it if it doesn't exist
+     *
+     * @param rKey Key
+     */
+    Slot& Create(const TKey& rKey);
+
+    /**
+     * @brief Finds the first free slot for a key with the specified hash
+     *
+     * @param hash Key hash
+     * @return Slot index
+     */
+    u32 FindFree(hash_t hash) const;
+
+    /**
+     * @brief Rebuilds the table with the specified number of slots
+     * @details Also compacts any deleted slots
+     *
+     * @param capacity New slot count (must be a power of two)
+     */
+    void Rehash(u32 capacity);
+
+    /**
+     * @brief Copies the contents of another map into this map
+     *
+     * @param rOther Map to copy
+     */
+    void CopyFrom(const TMap& rOther);
 
 private:
-    u32 mSize;         // Number of elements
-    u32 mCapacity;     // Maximum number of elements
-    Bucket* mpBuckets; // Element buckets
+    u32 mSize;               // Number of elements
+    u32 mDeleted;            // Number of deleted slots
+    u32 mCapacity;           // Number of slots (power of two)
+    u8* mpSlots;             // Slot storage (control bytes stored afterwards)
+    u8* mpCtrl;              // Slot control bytes
+    IAllocator* mpAllocator; // Slot allocator (nullptr for the heap)
 };
 
 //! @}
@@ -7,6 +7,8 @@
 #include <libkiwi/prim/kiwiHashMap.h>
 #endif
 
+#include <cstring>
+
 namespace kiwi {
 
 /**
@@ -16,32 +18,15 @@ template <typename TKey, typename TValue>
 K_INLINE typename TMap<TKey, TValue>::ConstIterator&
 TMap<TKey, TValue>::ConstIterator::operator++() {
     // Can't iterate
-    if (mpIter == nullptr) {
+    if (mIndex >= mpParent->mCapacity) {
         return *this;
     }
 
-    // Increment
-    mpIter = mpIter->pChained;
-
-    // Find next non-empty chain
-    while (true) {
-        // End of chain, advance to next bucket
-        if (mpIter == nullptr) {
-            if (++mIndex >= mCapacity) {
-                break;
-            }
-
-            mpIter = &mpBuckets[mIndex];
-        }
-
-        // Did we find an item?
-        K_ASSERT(mpIter != nullptr);
-        if (mpIter->used) {
+    // Find next used slot
+    while (++mIndex < mpParent->mCapacity) {
+        if (mpParent->IsUsed(mIndex)) {
             break;
         }
-
-        // Keep searching
-        mpIter = mpIter->pChained;
     }
 
     return *this;
@@ -55,18 +40,28 @@ TMap<TKey, TValue>::ConstIterator::operator++() {
  */
 template <typename TKey, typename TValue>
 K_INLINE TMap<TKey, TValue>::TMap(const TMap& rOther)
-    : mCapacity(rOther.mCapacity) {
-    K_ASSERT(mCapacity > 0);
-    K_ASSERT(mCapacity < HASH_MAX);
-
-    // Create buckets for copy
-    mpBuckets = new Bucket[mCapacity];
-    K_ASSERT(mpBuckets != nullptr);
+    : mSize(0),
+      mDeleted(0),
+      mCapacity(0),
+      mpSlots(nullptr),
+      mpCtrl(nullptr),
+      mpAllocator(nullptr) {
+    CopyFrom(rOther);
+}
 
-    // Re-insert all members
-    for (ConstIterator it = rOther.Begin(); it != rOther.End(); ++it) {
-        Insert(it.Key(), it.Value());
+/**
+ * @brief Map copy assignment
+ *
+ * @param rOther Map to copy
+ */
+template <typename TKey, typename TValue>
+K_INLINE TMap<TKey, TValue>&
+TMap<TKey, TValue>::operator=(const TMap& rOther) {
+    if (&rOther != this) {
+        CopyFrom(rOther);
     }
+
+    return *this;
 }
 
 /**
@@ -78,93 +73,242 @@ K_INLINE TMap<TKey, TValue>::TMap(const TMap& rOther)
  */
 template <typename TKey, typename TValue>
 K_INLINE bool TMap<TKey, TValue>::Remove(const TKey& rKey, TValue* pRemoved) {
-    Bucket* pBucket = Search(rKey);
+    u32 i = Search(rKey);
 
     // Can't remove, doesn't exist
-    if (pBucket == nullptr) {
+    if (i == npos) {
         return false;
     }
 
     // Write out value about to be removed
     if (pRemoved != nullptr) {
-        *pRemoved = *pBucket->value;
+        *pRemoved = GetSlot(i).value;
+    }
+
+    GetSlot(i).~Slot();
+
+    // If the next slot is empty, no probe sequence continues through this
+    // slot, so it doesn't need to leave a tombstone behind.
+    if (mpCtrl[(i + 1) & (mCapacity - 1)] == ECtrl_Empty) {
+        mpCtrl[i] = ECtrl_Empty;
+    } else {
+        mpCtrl[i] = ECtrl_Deleted;
+        mDeleted++;
     }
 
-    // Just mark as unused
-    pBucket->used = false;
     mSize--;
     return true;
 }
 
 /**
- * @brief Find key in hashmap
+ * @brief Removes all keys from the map
+ * @note The slot buffer is kept for reuse
+ */
+template <typename TKey, typename TValue>
+K_INLINE void TMap<TKey, TValue>::Clear() {
+    for (u32 i = 0; i < mCapacity; i++) {
+        if (IsUsed(i)) {
+            GetSlot(i).~Slot();
+        }
+    }
+
+    if (mpCtrl != nullptr) {
+        std::memset(mpCtrl, ECtrl_Empty, mCapacity);
+    }
+
+    mSize = 0;
+    mDeleted = 0;
+}
+
+/**
+ * @brief Reserves space so the specified number of elements can be held
+ * without rehashing
  *
- * @param rKey Key
+ * @param capacity Number of elements
  */
 template <typename TKey, typename TValue>
-K_INLINE typename TMap<TKey, TValue>::Bucket*
-TMap<TKey, TValue>::Search(const TKey& rKey) const {
-    // Calculate bucket index
-    u32 i = Hash(rKey) % mCapacity;
-
-    // Iterate through chains
-    for (Bucket* pIt = &mpBuckets[i]; pIt != nullptr; pIt = pIt->pChained) {
-        // Unused entry
-        if (!pIt->used) {
-            continue;
+K_INLINE void TMap<TKey, TValue>::Reserve(u32 capacity) {
+    if (capacity == 0) {
+        return;
+    }
+
+    // Smallest power-of-two slot count that stays under the load limit
+    u32 slots = scDefaultCapacity;
+    while (slots * scMaxLoad < capacity * 8) {
+        slots <<= 1;
+    }
+
+    if (slots > mCapacity) {
+        Rehash(slots);
+    }
+}
+
+/**
+ * @brief Finds the slot index of a key
+ *
+ * @param rKey Key (any type comparable with TKey)
+ * @return Slot index, or npos if the key doesn't exist
+ */
+template <typename TKey, typename TValue>
+template <typename TLookup>
+K_INLINE u32 TMap<TKey, TValue>::Search(const TLookup& rKey) const {
+    if (mSize == 0) {
+        return npos;
+    }
+
+    hash_t hash = Hash(rKey);
+    u8 ctrl = HashCtrl(hash);
+    u32 mask = mCapacity - 1;
+
+    // Load limit guarantees that the probe will find an empty slot
+    for (u32 i = hash & mask;; i = (i + 1) & mask) {
+        // End of the probe sequence
+        if (mpCtrl[i] == ECtrl_Empty) {
+            break;
         }
 
-        // Matches key
-        if (*pIt->key == rKey) {
-            return pIt;
+        // Only compare keys when the hash bits match
+        if (mpCtrl[i] == ctrl && GetSlot(i).key == rKey) {
+            return i;
         }
     }
 
-    return nullptr;
+    return npos;
 }
 
 /**
- * @brief Create key in hashmap
+ * @brief Finds the slot for a key, inserting it if it doesn't exist
  *
  * @param rKey Key
  */
 template <typename TKey, typename TValue>
-K_INLINE typename TMap<TKey, TValue>::Bucket&
+K_INLINE typename TMap<TKey, TValue>::Slot&
 TMap<TKey, TValue>::Create(const TKey& rKey) {
-    // Calculate bucket index
-    u32 i = Hash(rKey) % mCapacity;
-
-    // Iterate through chains
-    Bucket* pLast = nullptr;
-    for (Bucket* pIt = &mpBuckets[i]; pIt != nullptr; pIt = pIt->pChained) {
-        // Unused entry
-        if (!pIt->used) {
-            // Override this entry
-            pIt->key = rKey;
-            pIt->value.Emplace();
-            pIt->used = true;
-            mSize++;
-            return *pIt;
-        }
+    u32 i = Search(rKey);
 
-        // Matches key
-        if (*pIt->key == rKey) {
-            return *pIt;
+    // Key already exists
+    if (i != npos) {
+        return GetSlot(i);
+    }
+
+    // Used and deleted slots both lengthen probe sequences
+    if ((mSize + mDeleted + 1) * 8 > mCapacity * scMaxLoad) {
+        u32 capacity = mCapacity > 0 ? mCapacity : scDefaultCapacity;
+
+        // Only grow if the live keys need the space. Otherwise, rehashing
+        // at the same size is enough to compact the tombstones.
+        if ((mSize + 1) * 16 > capacity * scMaxLoad) {
+            capacity <<= 1;
         }
 
-        pLast = pIt;
+        Rehash(capacity);
     }
 
-    // Chain new bucket
-    K_ASSERT(pLast != nullptr);
-    pLast->pChained = new Bucket();
-    K_ASSERT(pLast->pChained != nullptr);
+    hash_t hash = Hash(rKey);
+    i = FindFree(hash);
+
+    // Reusing a tombstone
+    if (mpCtrl[i] == ECtrl_Deleted) {
+        mDeleted--;
+    }
 
-    pLast->pChained->key = rKey;
-    pLast->pChained->value.Emplace();
-    pLast->pChained->used = true;
+    mpCtrl[i] = HashCtrl(hash);
     mSize++;
-    return *pLast->pChained;
+
+    return *new (&GetSlot(i)) Slot(rKey);
+}
+
+/**
+ * @brief Finds the first free slot for a key with the specified hash
+ *
+ * @param hash Key hash
+ * @return Slot index
+ */
+template <typename TKey, typename TValue>
+K_INLINE u32 TMap<TKey, TValue>::FindFree(hash_t hash) const {
+    K_ASSERT(mCapacity > 0);
+
+    u32 mask = mCapacity - 1;
+    u32 i = hash & mask;
+
+    // Load limit guarantees that the probe will find a free slot
+    while (IsUsed(i)) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+/**
+ * @brief Rebuilds the table with the specified number of slots
+ * @details Also compacts any deleted slots
+ *
+ * @param capacity New slot count (must be a power of two)
+ */
+template <typename TKey, typename TValue>
+K_INLINE void TMap<TKey, TValue>::Rehash(u32 capacity) {
+    K_ASSERT(capacity >= scDefaultCapacity);
+    K_ASSERT((capacity & (capacity - 1)) == 0);
+    K_ASSERT(mSize * 8 < capacity * scMaxLoad);
+
+    u8* pOldSlots = mpSlots;
+    u8* pOldCtrl = mpCtrl;
+    u32 oldCapacity = mCapacity;
+
+    // Slots and control bytes share one allocation
+    mpSlots = static_cast<u8*>(IAllocator::AllocFrom(
+        mpAllocator, capacity * sizeof(Slot) + capacity));
+    K_ASSERT(mpSlots != nullptr);
+    mpCtrl = mpSlots + capacity * sizeof(Slot);
+
+    std::memset(mpCtrl, ECtrl_Empty, capacity);
+    mCapacity = capacity;
+    mDeleted = 0;
+
+    // Re-insert all members
+    for (u32 i = 0; i < oldCapacity; i++) {
+        // Unused slot
+        if ((pOldCtrl[i] & ECtrl_Empty) != 0) {
+            continue;
+        }
+
+        Slot& rOld = reinterpret_cast<Slot*>(pOldSlots)[i];
+
+        hash_t hash = Hash(rOld.key);
+        u32 j = FindFree(hash);
+
+        new (&GetSlot(j)) Slot(rOld.key, rOld.value);
+        mpCtrl[j] = HashCtrl(hash);
+
+        rOld.~Slot();
+    }
+
+    IAllocator::FreeTo(mpAllocator, pOldSlots);
+}
+
+/**
+ * @brief Copies the contents of another map into this map
+ *
+ * @param rOther Map to copy
+ */
+template <typename TKey, typename TValue>
+K_INLINE void TMap<TKey, TValue>::CopyFrom(const TMap& rOther) {
+    Clear();
+    Reserve(rOther.mSize);
+
+    for (u32 i = 0; i < rOther.mCapacity; i++) {
+        // Unused slot
+        if (!rOther.IsUsed(i)) {
+            continue;
+        }
+
+        const Slot& rSlot = rOther.GetSlot(i);
+        u32 j = FindFree(Hash(rSlot.key));
+
+        new (&GetSlot(j)) Slot(rSlot.key, rSlot.value);
+        mpCtrl[j] = rOther.mpCtrl[i];
+        mSize++;
+    }
 }
 
 } // namespace kiwi
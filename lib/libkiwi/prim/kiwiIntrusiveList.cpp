@@ -0,0 +1,106 @@
+#include <libkiwi.h>
+
+namespace kiwi {
+
+/**
+ * @brief Removes this node from its list (if it is in one)
+ */
+void IntrusiveListNode::Unlink() {
+    if (mpList != nullptr) {
+        mpList->Erase(this);
+    }
+}
+
+namespace detail {
+
+/**
+ * @brief Constructor
+ */
+IntrusiveListImpl::IntrusiveListImpl() : mSize(0) {
+    // End node links to itself when the list is empty
+    mEndNode.mpNext = &mEndNode;
+    mEndNode.mpPrev = &mEndNode;
+}
+
+/**
+ * @brief Unlinks all nodes from the list
+ * @note Elements are not destroyed
+ */
+void IntrusiveListImpl::Clear() {
+    IntrusiveListNode* pIt = mEndNode.mpNext;
+
+    while (pIt != &mEndNode) {
+        IntrusiveListNode* pNext = pIt->mpNext;
+
+        pIt->mpNext = nullptr;
+        pIt->mpPrev = nullptr;
+        pIt->mpList = nullptr;
+
+        pIt = pNext;
+    }
+
+    mEndNode.mpNext = &mEndNode;
+    mEndNode.mpPrev = &mEndNode;
+    mSize = 0;
+}
+
+/**
+ * @brief Inserts node before another node
+ *
+ * @param pNext Node to insert before
+ * @param pNode Node to insert
+ */
+void IntrusiveListImpl::Insert(IntrusiveListNode* pNext,
+                               IntrusiveListNode* pNode) {
+    K_ASSERT(pNext != nullptr);
+    K_ASSERT(pNode != nullptr);
+    K_ASSERT_EX(pNext == &mEndNode || pNext->mpList == this,
+                "Iterator is not from this list");
+    K_ASSERT_EX(!pNode->IsLinked(), "Node is already linked into a list");
+
+    IntrusiveListNode* pPrev = pNext->mpPrev;
+    K_ASSERT(pPrev != nullptr);
+
+    // pPrev <-> pNode
+    pPrev->mpNext = pNode;
+    pNode->mpPrev = pPrev;
+
+    // pNode <-> pNext
+    pNode->mpNext = pNext;
+    pNext->mpPrev = pNode;
+
+    pNode->mpList = this;
+    mSize++;
+}
+
+/**
+ * @brief Unlinks node from the list
+ *
+ * @param pNode Node to unlink
+ * @return Next node
+ */
+IntrusiveListNode* IntrusiveListImpl::Erase(IntrusiveListNode* pNode) {
+    K_ASSERT(pNode != nullptr);
+    K_ASSERT_EX(pNode != &mEndNode, "Can't erase the end node");
+    K_ASSERT_EX(pNode->mpList == this, "Node is not linked into this list");
+
+    IntrusiveListNode* pNext = pNode->mpNext;
+    IntrusiveListNode* pPrev = pNode->mpPrev;
+
+    K_ASSERT(pNext != nullptr);
+    K_ASSERT(pPrev != nullptr);
+
+    // pPrev <-> pNext
+    pPrev->mpNext = pNext;
+    pNext->mpPrev = pPrev;
+
+    pNode->mpNext = nullptr;
+    pNode->mpPrev = nullptr;
+    pNode->mpList = nullptr;
+
+    mSize--;
+    return pNext;
+}
+
+} // namespace detail
+} // namespace kiwi
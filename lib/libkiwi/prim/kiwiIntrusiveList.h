@@ -0,0 +1,439 @@
+#ifndef LIBKIWI_PRIM_INTRUSIVE_LIST_H
+#define LIBKIWI_PRIM_INTRUSIVE_LIST_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_prim
+//! @{
+
+// Forward declarations
+namespace detail {
+class IntrusiveListImpl;
+} // namespace detail
+
+/**
+ * @brief Intrusive linked-list node
+ * @details Embed this in the element type to link it into a TIntrusiveList
+ * without allocating a separate list node. Nodes unlink themselves when they
+ * are destroyed.
+ */
+class IntrusiveListNode : private NonCopyable {
+    friend class detail::IntrusiveListImpl;
+
+public:
+    /**
+     * @brief Constructor
+     */
+    IntrusiveListNode() : mpNext(nullptr), mpPrev(nullptr), mpList(nullptr) {}
+
+    /**
+     * @brief Destructor
+     */
+    ~IntrusiveListNode() {
+        Unlink();
+    }
+
+    /**
+     * @brief Tests whether this node is linked into a list
+     */
+    bool IsLinked() const {
+        return mpList != nullptr;
+    }
+
+    /**
+     * @brief Removes this node from its list (if it is in one)
+     */
+    void Unlink();
+
+    /**
+     * @brief Gets the next node in the list
+     */
+    IntrusiveListNode* GetNext() const {
+        return mpNext;
+    }
+    /**
+     * @brief Gets the previous node in the list
+     */
+    IntrusiveListNode* GetPrev() const {
+        return mpPrev;
+    }
+
+private:
+    IntrusiveListNode* mpNext;         // Next node in the linked-list
+    IntrusiveListNode* mpPrev;         // Previous node in the linked-list
+    detail::IntrusiveListImpl* mpList; // Parent linked-list
+};
+
+namespace detail {
+
+/**
+ * @brief Intrusive linked-list implementation
+ * @details Element-agnostic operations shared by all TIntrusiveList types
+ */
+class IntrusiveListImpl : private NonCopyable {
+public:
+    /**
+     * @brief Gets list size
+     */
+    u32 Size() const {
+        return mSize;
+    }
+
+    /**
+     * @brief Tests whether list is empty
+     */
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    /**
+     * @brief Unlinks all nodes from the list
+     * @note Elements are not destroyed
+     */
+    void Clear();
+
+    /**
+     * @brief Inserts node before another node
+     *
+     * @param pNext Node to insert before
+     * @param pNode Node to insert
+     */
+    void Insert(IntrusiveListNode* pNext, IntrusiveListNode* pNode);
+
+    /**
+     * @brief Unlinks node from the list
+     *
+     * @param pNode Node to unlink
+     * @return Next node
+     */
+    IntrusiveListNode* Erase(IntrusiveListNode* pNode);
+
+    /**
+     * @brief Tests whether a node is linked into this list
+     *
+     * @param pNode Node
+     */
+    bool Contains(const IntrusiveListNode* pNode) const {
+        return pNode->mpList == this;
+    }
+
+protected:
+    /**
+     * @brief Constructor
+     */
+    IntrusiveListImpl();
+
+    /**
+     * @brief Destructor
+     */
+    ~IntrusiveListImpl() {
+        Clear();
+    }
+
+protected:
+    u32 mSize;                  // List size
+    IntrusiveListNode mEndNode; // List end node
+};
+
+} // namespace detail
+
+/**
+ * @brief Templated intrusive linked-list
+ * @details Unlike TList, the link lives inside the element, so insertion and
+ * removal never allocate memory, and elements can unlink themselves in O(1).
+ * @note List DOES NOT OWN ELEMENTS
+ *
+ * @tparam T Element type
+ * @tparam PNode Pointer to the element's list node member
+ */
+template <typename T, IntrusiveListNode T::*PNode>
+class TIntrusiveList : public detail::IntrusiveListImpl {
+public:
+    // Forward declarations
+    class ConstIterator;
+
+    /**
+     * @brief Linked-list iterator
+     */
+    class Iterator {
+        template <typename U, IntrusiveListNode U::*>
+        friend class TIntrusiveList;
+        friend class ConstIterator;
+
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param pNode Iterator node
+         */
+        explicit Iterator(IntrusiveListNode* pNode) : mpNode(pNode) {
+            K_ASSERT(mpNode != nullptr);
+        }
+
+        /**
+         * @brief Pre-increment operator
+         */
+        Iterator& operator++() {
+            mpNode = mpNode->GetNext();
+            return *this;
+        }
+        /**
+         * @brief Post-increment operator
+         */
+        Iterator operator++(int) {
+            Iterator clone(*this);
+            ++*this;
+            return clone;
+        }
+
+        /**
+         * @brief Pre-decrement operator
+         */
+        Iterator& operator--() {
+            mpNode = mpNode->GetPrev();
+            return *this;
+        }
+        /**
+         * @brief Post-decrement operator
+         */
+        Iterator operator--(int) {
+            Iterator clone(*this);
+            --*this;
+            return clone;
+        }
+
+        // clang-format off
+        T* operator->() const { return GetElement(mpNode); }
+        T& operator*()  const { return *GetElement(mpNode); }
+
+        bool operator==(Iterator rhs) const { return mpNode == rhs.mpNode; }
+        bool operator!=(Iterator rhs) const { return mpNode != rhs.mpNode; }
+        // clang-format on
+
+    private:
+        IntrusiveListNode* mpNode;
+    };
+
+    /**
+     * @brief Linked-list iterator (const view)
+     */
+    class ConstIterator {
+        template <typename U, IntrusiveListNode U::*>
+        friend class TIntrusiveList;
+
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param pNode Iterator node
+         */
+        explicit ConstIterator(IntrusiveListNode* pNode) : mpNode(pNode) {
+            K_ASSERT(mpNode != nullptr);
+        }
+
+        /**
+         * @brief Constructor
+         *
+         * @param iter Iterator
+         */
+        ConstIterator(Iterator iter) : mpNode(iter.mpNode) {
+            K_ASSERT(mpNode != nullptr);
+        }
+
+        /**
+         * @brief Pre-increment operator
+         */
+        ConstIterator& operator++() {
+            mpNode = mpNode->GetNext();
+            return *this;
+        }
+        /**
+         * @brief Post-increment operator
+         */
+        ConstIterator operator++(int) {
+            ConstIterator clone(*this);
+            ++*this;
+            return clone;
+        }
+
+        /**
+         * @brief Pre-decrement operator
+         */
+        ConstIterator& operator--() {
+            mpNode = mpNode->GetPrev();
+            return *this;
+        }
+        /**
+         * @brief Post-decrement operator
+         */
+        ConstIterator operator--(int) {
+            ConstIterator clone(*this);
+            --*this;
+            return clone;
+        }
+
+        // clang-format off
+        const T* operator->() const { return GetElement(mpNode); }
+        const T& operator*()  const { return *GetElement(mpNode); }
+
+        bool operator==(ConstIterator rhs) const { return mpNode == rhs.mpNode; }
+        bool operator!=(ConstIterator rhs) const { return mpNode != rhs.mpNode; }
+        // clang-format on
+
+    private:
+        IntrusiveListNode* mpNode;
+    };
+
+public:
+    /**
+     * @brief Gets iterator to beginning of list
+     */
+    Iterator Begin() {
+        return Iterator(mEndNode.GetNext());
+    }
+    /**
+     * @brief Gets iterator to beginning of list (const view)
+     */
+    ConstIterator Begin() const {
+        return ConstIterator(const_cast<TIntrusiveList*>(this)->Begin());
+    }
+
+    /**
+     * @brief Gets iterator to end of list
+     */
+    Iterator End() {
+        return Iterator(&mEndNode);
+    }
+    /**
+     * @brief Gets iterator to end of list (const-view)
+     */
+    ConstIterator End() const {
+        return ConstIterator(const_cast<TIntrusiveList*>(this)->End());
+    }
+
+    /**
+     * @brief Unlinks beginning element from list
+     */
+    void PopFront() {
+        Erase(Begin());
+    }
+
+    /**
+     * @brief Unlinks end element from list
+     */
+    void PopBack() {
+        Erase(--End());
+    }
+
+    /**
+     * @brief Prepends element to front of list
+     *
+     * @param pElem New element
+     */
+    void PushFront(T* pElem) {
+        Insert(Begin(), pElem);
+    }
+
+    /**
+     * @brief Appends element to end of list
+     *
+     * @param pElem New element
+     */
+    void PushBack(T* pElem) {
+        Insert(End(), pElem);
+    }
+
+    /**
+     * @brief Gets reference to first element of list
+     */
+    T& Front() {
+        K_ASSERT(!Empty());
+        return *Begin();
+    }
+    /**
+     * @brief Gets reference to first element of list (const-view)
+     */
+    const T& Front() const {
+        K_ASSERT(!Empty());
+        return *Begin();
+    }
+
+    /**
+     * @brief Gets reference to last element of list
+     */
+    T& Back() {
+        K_ASSERT(!Empty());
+        return *--End();
+    }
+    /**
+     * @brief Gets reference to last element of list (const-view)
+     */
+    const T& Back() const {
+        K_ASSERT(!Empty());
+        return *--End();
+    }
+
+    /**
+     * @brief Inserts element at iterator
+     *
+     * @param iter Iterator at which to insert element
+     * @param pElem Element to insert
+     * @return Iterator to new element
+     */
+    Iterator Insert(Iterator iter, T* pElem) {
+        K_ASSERT(pElem != nullptr);
+        IntrusiveListImpl::Insert(iter.mpNode, &(pElem->*PNode));
+        return Iterator(&(pElem->*PNode));
+    }
+
+    /**
+     * @brief Unlinks element at iterator
+     *
+     * @param iter Iterator at which to erase element
+     * @return Iterator to next element
+     */
+    Iterator Erase(Iterator iter) {
+        return Iterator(IntrusiveListImpl::Erase(iter.mpNode));
+    }
+
+    /**
+     * @brief Unlinks element from list
+     * @details Unlike TList, this does not need to search the list
+     *
+     * @param pElem Element to remove
+     */
+    void Remove(const T* pElem) {
+        K_ASSERT(pElem != nullptr);
+        Erase(Iterator(const_cast<IntrusiveListNode*>(&(pElem->*PNode))));
+    }
+
+    /**
+     * @brief Tests whether an element is linked into this list
+     *
+     * @param pElem Element
+     */
+    bool Contains(const T* pElem) const {
+        K_ASSERT(pElem != nullptr);
+        return IntrusiveListImpl::Contains(&(pElem->*PNode));
+    }
+
+private:
+    /**
+     * @brief Gets the element which contains the specified node
+     *
+     * @param pNode List node
+     */
+    static T* GetElement(IntrusiveListNode* pNode);
+};
+
+//! @}
+} // namespace kiwi
+
+// Implementation header
+#ifndef LIBKIWI_PRIM_INTRUSIVE_LIST_IMPL_HPP
+#include <libkiwi/prim/kiwiIntrusiveListImpl.hpp>
+#endif
+
+#endif
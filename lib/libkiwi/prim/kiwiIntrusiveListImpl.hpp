@@ -0,0 +1,30 @@
+// Implementation header
+#ifndef LIBKIWI_PRIM_INTRUSIVE_LIST_IMPL_HPP
+#define LIBKIWI_PRIM_INTRUSIVE_LIST_IMPL_HPP
+
+// Declaration header
+#ifndef LIBKIWI_PRIM_INTRUSIVE_LIST_H
+#include <libkiwi/prim/kiwiIntrusiveList.h>
+#endif
+
+namespace kiwi {
+
+/**
+ * @brief Gets the element which contains the specified node
+ *
+ * @param pNode List node
+ */
+template <typename T, IntrusiveListNode T::*PNode>
+K_INLINE T* TIntrusiveList<T, PNode>::GetElement(IntrusiveListNode* pNode) {
+    K_ASSERT(pNode != nullptr);
+    K_ASSERT_EX(pNode->IsLinked(), "Can't dereference the end node");
+
+    // Byte offset of the node member inside the element (like offsetof)
+    u32 offset = reinterpret_cast<u32>(&(static_cast<T*>(nullptr)->*PNode));
+
+    return reinterpret_cast<T*>(reinterpret_cast<u8*>(pNode) - offset);
+}
+
+} // namespace kiwi
+
+#endif
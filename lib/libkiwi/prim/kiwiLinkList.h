@@ -1,5 +1,6 @@
 #ifndef LIBKIWI_PRIM_LINKLIST_H
 #define LIBKIWI_PRIM_LINKLIST_H
+#include <libkiwi/core/kiwiAllocator.h>
 #include <libkiwi/debug/kiwiAssert.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/util/kiwiNonCopyable.h>
@@ -8,6 +9,9 @@ namespace kiwi {
 //! @addtogroup libkiwi_prim
 //! @{
 
+// Forward declarations
+template <typename T> class TList;
+
 /**
  * @brief Templated linked-list node
  * @note List node DOES NOT OWN ELEMENT
@@ -176,8 +180,11 @@ public:
 public:
     /**
      * @brief Constructor
+     *
+     * @param pAllocator Node allocator (nullptr for the default heap)
      */
-    TList() : mSize(0), mEndNode(nullptr) {
+    explicit TList(IAllocator* pAllocator = nullptr)
+        : mSize(0), mEndNode(nullptr), mpAllocator(pAllocator) {
         mEndNode.mpNext = &mEndNode;
         mEndNode.mpPrev = &mEndNode;
     }
@@ -195,6 +202,23 @@ public:
         Erase(Begin(), End());
     }
 
+    /**
+     * @brief Sets the allocator used for the nodes
+     * @note Only possible while the list is empty
+     *
+     * @param pAllocator Node allocator (nullptr for the default heap)
+     */
+    void SetAllocator(IAllocator* pAllocator) {
+        K_ASSERT_EX(Empty(), "List already has nodes");
+        mpAllocator = pAllocator;
+    }
+    /**
+     * @brief Gets the allocator used for the nodes
+     */
+    IAllocator* GetAllocator() const {
+        return mpAllocator;
+    }
+
     /**
      * @brief Gets iterator to beginning of list
      */
@@ -255,7 +279,7 @@ public:
      * @param pElem New element
      */
     void PushFront(T* pElem) {
-        Insert(Begin(), new TListNode<T>(pElem));
+        Insert(Begin(), CreateNode(pElem));
     }
 
     /**
@@ -264,7 +288,7 @@ public:
      * @param pElem New element
      */
     void PushBack(T* pElem) {
-        Insert(End(), new TListNode<T>(pElem));
+        Insert(End(), CreateNode(pElem));
     }
 
     /**
@@ -343,6 +367,7 @@ public:
         for (Iterator it = Begin(); it != End(); ++it) {
             if (&*it == pElem) {
                 Erase(it);
+                return;
             }
         }
     }
@@ -375,8 +400,21 @@ public:
     }
 
 private:
-    u32 mSize;             // List size
-    TListNode<T> mEndNode; // List end node
+    /**
+     * @brief Creates a new node for an element
+     *
+     * @param pElem Element
+     */
+    TListNode<T>* CreateNode(T* pElem) {
+        void* pNode = IAllocator::AllocFrom(mpAllocator, sizeof(TListNode<T>));
+        K_ASSERT(pNode != nullptr);
+        return new (pNode) TListNode<T>(pElem);
+    }
+
+private:
+    u32 mSize;               // List size
+    TListNode<T> mEndNode;   // List end node
+    IAllocator* mpAllocator; // Node allocator (nullptr for the heap)
 };
 
 //! @}
@@ -56,7 +56,8 @@ K_INLINE typename TList<T>::Iterator TList<T>::Erase(TListNode<T>* pNode) {
     pNode->mpNext = nullptr;
     pNode->mpPrev = nullptr;
     // Free memory
-    delete pNode;
+    pNode->~TListNode<T>();
+    IAllocator::FreeTo(mpAllocator, pNode);
 
     mSize--;
 
@@ -5,23 +5,10 @@
 
 namespace kiwi {
 
-/**
- * @brief Static string for empty String objects
- */
-template <> const char* StringImpl<char>::scEmptyCStr = "";
-/**
- * @brief Static string for empty String objects
- */
-template <> const wchar_t* StringImpl<wchar_t>::scEmptyCStr = L"";
-
 namespace {
 
 template <typename T> u32 StrLen(const T* pStr);
-template <typename T> T* StrNCat(T* pDst, const T* pSrc, u32 n);
 template <typename T> int StrNCmp(const T* pStr1, const T* pStr2, u32 n);
-template <typename T> T* StrNCpy(T* pDst, const T* pSrc, u32 n);
-template <typename T> const T* StrChr(const T* pStr, T c);
-template <typename T> const T* StrStr(const T* pStr1, const T* pStr2);
 
 template <typename T>
 int VsNPrintf(T* pDst, u32 n, const T* pFmt, std::va_list args);
@@ -32,17 +19,19 @@ int VsNPrintf(T* pDst, u32 n, const T* pFmt, std::va_list args);
  * @brief Destructor
  */
 template <typename T> StringImpl<T>::~StringImpl() {
-    // Don't delete static memory
-    if (mpBuffer == scEmptyCStr) {
+    // Don't delete local memory
+    if (IsLocal()) {
         return;
     }
 
-    delete[] mpBuffer;
+    IAllocator::FreeTo(mpAllocator, mpBuffer);
     mpBuffer = nullptr;
 }
 
 /**
  * @brief Reserves string buffer of specified size
+ * @details The buffer grows geometrically, so repeated appends take
+ * amortized constant time
  *
  * @param n Number of characters to reserve (ignoring null terminator)
  */
@@ -52,213 +41,79 @@ template <typename T> void StringImpl<T>::Reserve(u32 n) {
         return;
     }
 
+    // At least double the buffer to avoid reallocating on every append
+    u32 capacity = Max(n + 1, mCapacity * 2);
+
+    // Contents stay where they are
+    if (!IsLocal() &&
+        IAllocator::ResizeIn(mpAllocator, mpBuffer, capacity * sizeof(T))) {
+        mCapacity = capacity;
+        return;
+    }
+
     // Reallocate buffer
-    T* pBuffer = new T[n + 1];
+    T* pBuffer = static_cast<T*>(
+        IAllocator::AllocFrom(mpAllocator, capacity * sizeof(T)));
+    K_ASSERT(pBuffer != nullptr);
 
-    // Copy existing data
-    StrNCpy(pBuffer, mpBuffer, mLength);
-    pBuffer[mLength] = '\0';
+    // Copy existing data (including null terminator)
+    std::memcpy(pBuffer, mpBuffer, (mLength + 1) * sizeof(T));
 
     // Delete old data
-    if (mpBuffer != scEmptyCStr) {
-        delete[] mpBuffer;
+    if (!IsLocal()) {
+        IAllocator::FreeTo(mpAllocator, mpBuffer);
     }
 
     // Set new configuration
     mpBuffer = pBuffer;
-    mCapacity = n + 1;
+    mCapacity = capacity;
 }
 
 /**
  * @brief Shrinks buffer to fit string contents
  */
 template <typename T> void StringImpl<T>::Shrink() {
-    K_ASSERT(mCapacity > Length());
-
-    mCapacity = 0;
-    Reserve(Length());
-}
-
-/**
- * @brief Generates substring of this string
- *
- * @param pos Substring start position
- * @param len Substring size
- */
-template <typename T>
-StringImpl<T> StringImpl<T>::SubStr(u32 pos, u32 len) const {
-    K_ASSERT(pos <= mLength);
-
-    // Empty string if the substring begins at the end
-    if (pos == mLength) {
-        return StringImpl();
-    }
-
-    // Clamp substring length
-    len = Min(len, mLength - pos);
-
-    // Create C-style substring
-    T* pBuffer = new T[len + 1];
-    StrNCpy(pBuffer, mpBuffer + pos, len);
-    pBuffer[len] = '\0';
-
-    // Construct string wrapper
-    StringImpl<T> str = StringImpl(pBuffer);
-
-    delete[] pBuffer;
-    return str;
-}
-
-/**
- * @brief Finds first occurrence of sequence in string
- *
- * @param rStr Sequence to search for
- * @param pos Search offset (from string start)
- * @return Match position if found, otherwise npos
- */
-template <typename T>
-u32 StringImpl<T>::Find(const StringImpl<T>& rStr, u32 pos) const {
-    // Cannot match empty string
-    if (rStr.Empty()) {
-        return npos;
-    }
-
-    // Cannot match past end of string
-    if (pos >= mLength) {
-        return npos;
-    }
-
-    return Find(rStr.CStr(), pos);
-}
-
-/**
- * @brief Finds first occurrence of sequence in string
- *
- * @param pStr Sequence to search for
- * @param pos Search offset (from string start)
- * @return Match position if found, otherwise npos
- */
-template <typename T> u32 StringImpl<T>::Find(const T* pStr, u32 pos) const {
-    K_ASSERT(pStr != nullptr);
-
-    // Cannot match past end of string
-    if (pos >= mLength) {
-        return npos;
-    }
-
-    // Call down to C STL
-    const T* pResult = StrStr(mpBuffer + pos, pStr);
-
-    // Not found
-    if (pResult == nullptr) {
-        return npos;
-    }
-
-    // Determine index by pointer arithmetic
-    return PtrDistance(mpBuffer, pResult) / sizeof(T);
-}
-
-/**
- * @brief Finds first occurrence of sequence in string
- *
- * @param c Character to search for
- * @param pos Search offset (from string start)
- * @return Match position if found, otherwise npos
- */
-template <typename T> u32 StringImpl<T>::Find(T c, u32 pos) const {
-    // Cannot match past end of string
-    if (pos >= mLength) {
-        return npos;
+    // Already as small as possible
+    if (IsLocal() || mCapacity == mLength + 1) {
+        return;
     }
 
-    // Call down to C STL
-    const T* pResult = StrChr(mpBuffer + pos, c);
+    T* pBuffer = mLocalBuffer;
+    u32 capacity = scLocalSize;
 
-    // Not found
-    if (pResult == nullptr) {
-        return npos;
+    // Contents may no longer fit in the local buffer
+    if (mLength + 1 > scLocalSize) {
+        capacity = mLength + 1;
+        pBuffer = static_cast<T*>(
+            IAllocator::AllocFrom(mpAllocator, capacity * sizeof(T)));
+        K_ASSERT(pBuffer != nullptr);
     }
 
-    // Determine index by pointer arithmetic
-    return PtrDistance(mpBuffer, pResult) / sizeof(T);
-}
-
-/**
- * @brief Tests whether this string starts with the specified prefix
- *
- * @param rStr Prefix sequence
- */
-template <typename T>
-bool StringImpl<T>::StartsWith(const StringImpl<T>& rStr) const {
-    return Find(rStr) == 0;
-}
+    // Copy existing data (including null terminator)
+    std::memcpy(pBuffer, mpBuffer, (mLength + 1) * sizeof(T));
+    IAllocator::FreeTo(mpAllocator, mpBuffer);
 
-/**
- * @brief Tests whether this string starts with the specified prefix
- *
- * @param pStr Prefix sequence
- */
-template <typename T> bool StringImpl<T>::StartsWith(const T* pStr) const {
-    K_ASSERT(pStr != nullptr);
-    return Find(pStr) == 0;
-}
-
-/**
- * @brief Tests whether this string ends with the specified suffix
- *
- * @param rStr Suffix sequence
- */
-template <typename T>
-bool StringImpl<T>::EndsWith(const StringImpl<T>& rStr) const {
-    size_t pos = mLength - rStr.Length();
-    return Find(rStr, pos) == pos;
-}
-
-/**
- * @brief Tests whether this string ends with the specified suffix
- *
- * @param pStr Suffix sequence
- */
-template <typename T> bool StringImpl<T>::EndsWith(const T* pStr) const {
-    K_ASSERT(pStr != nullptr);
-
-    size_t pos = mLength - StrLen(pStr);
-    return Find(pStr, pos) == pos;
+    // Set new configuration
+    mpBuffer = pBuffer;
+    mCapacity = capacity;
 }
 
 /**
  * @brief Split this string into tokens by the specified delimiter
+ * @note Use View().Split to avoid copying the tokens
  *
  * @param rDelim Delimiter sequence
  */
 template <typename T>
-TVector<StringImpl<T> > StringImpl<T>::Split(const StringImpl& rDelim) const {
-    K_ASSERT(rDelim.Length() > 0);
+TVector<StringImpl<T> >
+StringImpl<T>::Split(const StringViewImpl<T>& rDelim) const {
+    TVector<StringViewImpl<T> > views = View().Split(rDelim);
 
     TVector<StringImpl> tokens;
+    tokens.Reserve(views.Size());
 
-    // Search window
-    u32 start = 0;
-    u32 end = 0;
-
-    while (start < mLength) {
-        // Next occurrence in search window
-        end = Find(rDelim, start);
-
-        // No more occurrences in the string
-        if (end == npos) {
-            break;
-        }
-
-        // Split off token
-        tokens.PushBack(SubStr(start, end - start));
-        // Search window now ignores previous characters
-        start = end + rDelim.Length();
-    }
-
-    // Push back very last token
-    if (start != mLength) {
-        tokens.PushBack(SubStr(start));
+    for (u32 i = 0; i < views.Size(); i++) {
+        tokens.EmplaceBack(views[i]);
     }
 
     return tokens;
@@ -271,13 +126,7 @@ TVector<StringImpl<T> > StringImpl<T>::Split(const StringImpl& rDelim) const {
  */
 template <typename T>
 bool StringImpl<T>::operator==(const StringImpl<T>& rStr) const {
-    // Don't bother comparing data if lengths are different
-    if (mLength != rStr.Length()) {
-        return false;
-    }
-
-    // Compare string data
-    return StrNCmp(mpBuffer, rStr.CStr(), mLength) == 0;
+    return View() == rStr.View();
 }
 
 /**
@@ -288,25 +137,9 @@ bool StringImpl<T>::operator==(const StringImpl<T>& rStr) const {
 template <typename T> bool StringImpl<T>::operator==(const T* pStr) const {
     K_ASSERT(pStr != nullptr);
 
-    // Compare string data
-    return StrNCmp(mpBuffer, pStr, mLength) == 0;
-}
-
-/**
- * @brief Assigns data to string
- *
- * @param rStr String to copy
- */
-template <typename T> void StringImpl<T>::Assign(const StringImpl<T>& rStr) {
-    // Reserve string buffer
-    Reserve(rStr.Length());
-
-    // Copy data
-    StrNCpy(mpBuffer, rStr.CStr(), rStr.Length());
-    mLength = rStr.Length();
-
-    // Null terminator
-    mpBuffer[mLength] = static_cast<T>(0);
+    // Compare string data (and make sure the other string ends here too)
+    return StrNCmp(mpBuffer, pStr, mLength) == 0 &&
+           pStr[mLength] == static_cast<T>(0);
 }
 
 /**
@@ -316,14 +149,24 @@ template <typename T> void StringImpl<T>::Assign(const StringImpl<T>& rStr) {
  * @param n Number of characters to copy
  */
 template <typename T> void StringImpl<T>::Assign(const T* pStr, u32 n) {
-    K_ASSERT(pStr != nullptr);
+    K_ASSERT(pStr != nullptr || n == 0);
+
+    // Self-assignment
+    if (pStr == mpBuffer && (n == npos || n == mLength)) {
+        return;
+    }
 
-    // Reserve string buffer
     u32 len = n != npos ? n : StrLen(pStr);
+
+    // Source may be part of this string, which is safe because it already
+    // fits in the buffer (so the buffer won't be reallocated)
     Reserve(len);
 
     // Copy data
-    StrNCpy(mpBuffer, pStr, len);
+    if (len > 0) {
+        std::memmove(mpBuffer, pStr, len * sizeof(T));
+    }
+
     mLength = len;
 
     // Null terminator
@@ -350,32 +193,32 @@ template <typename T> void StringImpl<T>::Assign(T c) {
 /**
  * @brief Appends a string to this string
  *
- * @param rStr String to append
+ * @param pStr C-style string to append
+ * @param n Number of characters to append
  */
-template <typename T> void StringImpl<T>::Append(const StringImpl<T>& rStr) {
-    // Reserve string buffer
-    Reserve(mLength + rStr.Length());
+template <typename T> void StringImpl<T>::Append(const T* pStr, u32 n) {
+    K_ASSERT(pStr != nullptr || n == 0);
 
-    // Concatenate data
-    StrNCat(mpBuffer, rStr.CStr(), rStr.Length());
-    mLength += rStr.Length();
+    u32 len = n != npos ? n : StrLen(pStr);
 
-    // Null terminator
-    mpBuffer[mLength] = static_cast<T>(0);
-}
+    // Nothing to append
+    if (len == 0) {
+        return;
+    }
+
+    // Source may be part of this string (i.e. appending to itself)
+    bool alias = pStr >= mpBuffer && pStr < mpBuffer + mCapacity;
+    u32 offset = alias ? pStr - mpBuffer : 0;
 
-/**
- * @brief Appends a C-style string to this string
- *
- * @param pStr C-style string to append
- */
-template <typename T> void StringImpl<T>::Append(const T* pStr) {
     // Reserve string buffer
-    u32 len = StrLen(pStr);
     Reserve(mLength + len);
 
+    if (alias) {
+        pStr = mpBuffer + offset;
+    }
+
     // Concatenate data
-    StrNCat(mpBuffer, pStr, len);
+    std::memmove(mpBuffer + mLength, pStr, len * sizeof(T));
     mLength += len;
 
     // Null terminator
@@ -399,6 +242,42 @@ template <typename T> void StringImpl<T>::Append(T c) {
     mpBuffer[mLength] = static_cast<T>(0);
 }
 
+#ifdef LIBKIWI_CPP1X
+/**
+ * @brief Moves string contents
+ *
+ * @param rOther String to move
+ */
+template <typename T> void StringImpl<T>::MoveFrom(StringImpl&& rOther) {
+    // Self-assignment
+    if (&rOther == this) {
+        return;
+    }
+
+    // Local buffers can't be stolen, so copy the (short) contents instead
+    if (rOther.IsLocal()) {
+        Assign(rOther.CStr(), rOther.Length());
+        rOther.Clear();
+        return;
+    }
+
+    // Free existing buffer
+    if (!IsLocal()) {
+        IAllocator::FreeTo(mpAllocator, mpBuffer);
+    }
+
+    // Buffer can only be freed by the allocator that owns it
+    mpBuffer = rOther.mpBuffer;
+    mCapacity = rOther.mCapacity;
+    mLength = rOther.mLength;
+    mpAllocator = rOther.mpAllocator;
+
+    rOther.mpBuffer = rOther.mLocalBuffer;
+    rOther.mCapacity = scLocalSize;
+    rOther.Clear();
+}
+#endif
+
 /**
  * @brief Convert this string to a multi-byte string
  */
@@ -508,16 +387,6 @@ template <> u32 StrLen<wchar_t>(const wchar_t* pStr) {
     return std::wcslen(pStr);
 }
 
-/**
- * strncat wrapper function
- */
-template <> char* StrNCat(char* pDst, const char* pSrc, u32 n) {
-    return std::strncat(pDst, pSrc, n);
-}
-template <> wchar_t* StrNCat(wchar_t* pDst, const wchar_t* pSrc, u32 n) {
-    return std::wcsncat(pDst, pSrc, n);
-}
-
 /**
  * strncmp wrapper function
  */
@@ -529,38 +398,6 @@ int StrNCmp<wchar_t>(const wchar_t* pStr1, const wchar_t* pStr2, u32 n) {
     return std::wcsncmp(pStr1, pStr2, n);
 }
 
-/**
- * strncpy wrapper function
- */
-template <> char* StrNCpy<char>(char* pDst, const char* pSrc, u32 n) {
-    return std::strncpy(pDst, pSrc, n);
-}
-template <>
-wchar_t* StrNCpy<wchar_t>(wchar_t* pDst, const wchar_t* pSrc, u32 n) {
-    return std::wcsncpy(pDst, pSrc, n);
-}
-
-/**
- * strchr wrapper function
- */
-template <> const char* StrChr<char>(const char* pStr, char c) {
-    return std::strchr(pStr, c);
-}
-template <> const wchar_t* StrChr<wchar_t>(const wchar_t* pStr, wchar_t c) {
-    return std::wcschr(pStr, c);
-}
-
-/**
- * strstr wrapper function
- */
-template <> const char* StrStr<char>(const char* pStr1, const char* pStr2) {
-    return std::strstr(pStr1, pStr2);
-}
-template <>
-const wchar_t* StrStr<wchar_t>(const wchar_t* pStr1, const wchar_t* pStr2) {
-    return std::wcsstr(pStr1, pStr2);
-}
-
 /**
  * vsnprintf wrapper function
  */
@@ -1,8 +1,10 @@
 #ifndef LIBKIWI_PRIM_STRING_H
 #define LIBKIWI_PRIM_STRING_H
+#include <libkiwi/core/kiwiAllocator.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/prim/kiwiBitCast.h>
 #include <libkiwi/prim/kiwiHashMap.h>
+#include <libkiwi/prim/kiwiStringView.h>
 #include <libkiwi/prim/kiwiVector.h>
 
 namespace kiwi {
@@ -11,13 +13,19 @@ namespace kiwi {
 
 /**
  * @brief String wrapper
+ * @details Short strings are stored inside the string object itself, so they
+ * don't need to allocate any memory.
  */
 template <typename T> class StringImpl {
 public:
     /**
      * @brief Constructor
      */
-    StringImpl() : mpBuffer(nullptr), mCapacity(0), mLength(0) {
+    StringImpl()
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
         Clear();
     }
 
@@ -28,10 +36,29 @@ public:
      * @param rOther String to copy
      */
     StringImpl(const StringImpl& rOther)
-        : mpBuffer(nullptr), mCapacity(0), mLength(0) {
-        Assign(rOther);
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
+        Assign(rOther.CStr(), rOther.Length());
     }
 
+#ifdef LIBKIWI_CPP1X
+    /**
+     * @brief Constructor
+     * @details Move constructor
+     *
+     * @param rOther String to move
+     */
+    StringImpl(StringImpl&& rOther)
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
+        MoveFrom(std::move(rOther));
+    }
+#endif
+
     /**
      * @brief Constructor
      * @details Substring constructor
@@ -41,8 +68,11 @@ public:
      * @param len Substring length
      */
     StringImpl(const StringImpl& rOther, u32 pos, u32 len = npos)
-        : mpBuffer(nullptr), mCapacity(0), mLength(0) {
-        Assign(rOther.SubStr(pos, len));
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
+        Assign(StringViewImpl<T>(rOther).SubStr(pos, len));
     }
 
     /**
@@ -51,7 +81,11 @@ public:
      *
      * @param pStr C-style string
      */
-    StringImpl(const T* pStr) : mpBuffer(nullptr), mCapacity(0), mLength(0) {
+    StringImpl(const T* pStr)
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
         Assign(pStr);
     }
 
@@ -63,17 +97,38 @@ public:
      * @param n Number of characters to copy
      */
     StringImpl(const T* pStr, u32 n)
-        : mpBuffer(nullptr), mCapacity(0), mLength(0) {
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
         Assign(pStr, n);
     }
 
+    /**
+     * @brief Constructor
+     * @details String view constructor
+     *
+     * @param rStr String view to copy
+     */
+    explicit StringImpl(const StringViewImpl<T>& rStr)
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
+        Assign(rStr);
+    }
+
     /**
      * @brief Constructor
      * @details Character constructor
      *
      * @param c Character
      */
-    explicit StringImpl(char c) : mpBuffer(nullptr), mCapacity(0), mLength(0) {
+    explicit StringImpl(char c)
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(nullptr) {
         Assign(c);
     }
 
@@ -82,8 +137,14 @@ public:
      * @details Reserve space
      *
      * @param n Number of characters to reserve
+     * @param pAllocator Buffer allocator (nullptr for the default heap)
      */
-    explicit StringImpl(u32 n) : mpBuffer(nullptr), mCapacity(0), mLength(0) {
+    explicit StringImpl(u32 n, IAllocator* pAllocator = nullptr)
+        : mpBuffer(mLocalBuffer),
+          mCapacity(scLocalSize),
+          mLength(0),
+          mpAllocator(pAllocator) {
+        Clear();
         Reserve(n);
     }
 
@@ -121,6 +182,16 @@ public:
         return mpBuffer;
     }
 
+    /**
+     * @brief Gets a view of (part of) this string
+     *
+     * @param pos View start position
+     * @param len View size
+     */
+    StringViewImpl<T> View(u32 pos = 0, u32 len = npos) const {
+        return StringViewImpl<T>(*this).SubStr(pos, len);
+    }
+
     /**
      * @brief Accesses a character in the string
      *
@@ -148,10 +219,13 @@ public:
      */
     void Clear() {
         mLength = 0;
+        mpBuffer[0] = static_cast<T>(0);
     }
 
     /**
      * @brief Reserves string buffer of specified size
+     * @details The buffer grows geometrically, so repeated appends take
+     * amortized constant time
      *
      * @param n Number of characters to reserve (ignoring null terminator)
      */
@@ -161,13 +235,33 @@ public:
      */
     void Shrink();
 
+    /**
+     * @brief Sets the allocator used for the buffer
+     * @note Only possible while the string uses its local buffer
+     *
+     * @param pAllocator Buffer allocator (nullptr for the default heap)
+     */
+    void SetAllocator(IAllocator* pAllocator) {
+        K_ASSERT_EX(IsLocal(), "Buffer is already allocated");
+        mpAllocator = pAllocator;
+    }
+    /**
+     * @brief Gets the allocator used for the buffer
+     */
+    IAllocator* GetAllocator() const {
+        return mpAllocator;
+    }
+
     /**
      * @brief Generates substring of this string
+     * @note Use View to avoid the copy
      *
      * @param pos Substring start position
      * @param len Substring size
      */
-    StringImpl SubStr(u32 pos = 0, u32 len = npos) const;
+    StringImpl SubStr(u32 pos = 0, u32 len = npos) const {
+        return StringImpl(View(pos, len));
+    }
 
     /**
      * @brief Finds first occurrence of sequence in string
@@ -176,15 +270,9 @@ public:
      * @param pos Search offset (from string start)
      * @return Match position if found, otherwise npos
      */
-    u32 Find(const StringImpl& rStr, u32 pos = 0) const;
-    /**
-     * @brief Finds first occurrence of sequence in string
-     *
-     * @param pStr Sequence to search for
-     * @param pos Search offset (from string start)
-     * @return Match position if found, otherwise npos
-     */
-    u32 Find(const T* pStr, u32 pos = 0) const;
+    u32 Find(const StringViewImpl<T>& rStr, u32 pos = 0) const {
+        return StringViewImpl<T>(*this).Find(rStr, pos);
+    }
     /**
      * @brief Finds first occurrence of sequence in string
      *
@@ -192,40 +280,35 @@ public:
      * @param pos Search offset (from string start)
      * @return Match position if found, otherwise npos
      */
-    u32 Find(T c, u32 pos = 0) const;
+    u32 Find(T c, u32 pos = 0) const {
+        return StringViewImpl<T>(*this).Find(c, pos);
+    }
 
     /**
      * @brief Tests whether this string starts with the specified prefix
      *
      * @param rStr Prefix sequence
      */
-    bool StartsWith(const StringImpl& rStr) const;
-    /**
-     * @brief Tests whether this string starts with the specified prefix
-     *
-     * @param pStr Prefix sequence
-     */
-    bool StartsWith(const T* pStr) const;
+    bool StartsWith(const StringViewImpl<T>& rStr) const {
+        return StringViewImpl<T>(*this).StartsWith(rStr);
+    }
 
     /**
      * @brief Tests whether this string ends with the specified suffix
      *
      * @param rStr Suffix sequence
      */
-    bool EndsWith(const StringImpl& rStr) const;
-    /**
-     * @brief Tests whether this string ends with the specified suffix
-     *
-     * @param pStr Suffix sequence
-     */
-    bool EndsWith(const T* pStr) const;
+    bool EndsWith(const StringViewImpl<T>& rStr) const {
+        return StringViewImpl<T>(*this).EndsWith(rStr);
+    }
 
     /**
      * @brief Split this string into tokens by the specified delimiter
+     * @note Use View().Split to avoid copying the tokens
      *
      * @param rDelim Delimiter sequence
      */
-    TVector<StringImpl> Split(const StringImpl& rDelim) const;
+    TVector<StringImpl> Split(const StringViewImpl<T>& rDelim) const;
 
     /**
      * @brief Convert this string to a multi-byte string
@@ -238,13 +321,14 @@ public:
     StringImpl<wchar_t> ToWideChar() const;
 
     // clang-format off
-    StringImpl& operator=(const StringImpl& rStr) { Assign(rStr); return *this; }
+    StringImpl& operator=(const StringImpl& rStr) { Assign(rStr.CStr(), rStr.Length()); return *this; }
     StringImpl& operator=(const T* pStr)          { K_ASSERT(pStr != nullptr); Assign(pStr); return *this; }
     StringImpl& operator=(T c)                    { Assign(c); return *this; }
 
-    StringImpl& operator+=(const StringImpl& rStr) { Append(rStr); return *this; }
-    StringImpl& operator+=(const T* pStr)          { K_ASSERT(pStr != nullptr); Append(pStr); return *this; }
-    StringImpl& operator+=(T c)                    { Append(c); return *this; }
+    StringImpl& operator+=(const StringImpl& rStr)         { Append(rStr.CStr(), rStr.Length()); return *this; }
+    StringImpl& operator+=(const StringViewImpl<T>& rStr) { Append(rStr.Data(), rStr.Length()); return *this; }
+    StringImpl& operator+=(const T* pStr)                 { K_ASSERT(pStr != nullptr); Append(pStr); return *this; }
+    StringImpl& operator+=(T c)                           { Append(c); return *this; }
 
     bool operator==(const StringImpl& rStr) const;
     bool operator==(const T* pStr) const;
@@ -255,8 +339,21 @@ public:
     bool operator!=(T c) const                    { return (*this == c)    == false; }
     // clang-format on
 
+#ifdef LIBKIWI_CPP1X
+    /**
+     * @brief String move assignment
+     *
+     * @param rOther String to move
+     */
+    StringImpl& operator=(StringImpl&& rOther) {
+        MoveFrom(std::move(rOther));
+        return *this;
+    }
+#endif
+
     friend StringImpl operator+(const StringImpl& lhs, const StringImpl& rhs) {
-        StringImpl str = lhs;
+        StringImpl str(lhs.Length() + rhs.Length());
+        str += lhs;
         str += rhs;
         return str;
     }
@@ -268,18 +365,28 @@ public:
     }
 
     friend StringImpl operator+(const StringImpl& lhs, T rhs) {
-        StringImpl str = lhs;
+        StringImpl str(lhs.Length() + 1);
+        str += lhs;
         str += rhs;
         return str;
     }
 
 private:
+    /**
+     * @brief Tests whether the string is using its local buffer
+     */
+    bool IsLocal() const {
+        return mpBuffer == mLocalBuffer;
+    }
+
     /**
      * @brief Assigns data to string
      *
-     * @param rStr String to copy
+     * @param rStr String view to copy
      */
-    void Assign(const StringImpl& rStr);
+    void Assign(const StringViewImpl<T>& rStr) {
+        Assign(rStr.Data(), rStr.Length());
+    }
     /**
      * @brief Assigns data to string
      *
@@ -294,18 +401,13 @@ private:
      */
     void Assign(T c);
 
-    /**
-     * @brief Appends a string to this string
-     *
-     * @param rStr String to append
-     */
-    void Append(const StringImpl& rStr);
     /**
      * @brief Appends a string to this string
      *
      * @param pStr C-style string to append
+     * @param n Number of characters to append
      */
-    void Append(const T* pStr);
+    void Append(const T* pStr, u32 n = npos);
     /**
      * @brief Appends a character to this string
      *
@@ -313,13 +415,25 @@ private:
      */
     void Append(T c);
 
+#ifdef LIBKIWI_CPP1X
+    /**
+     * @brief Moves string contents
+     *
+     * @param rOther String to move
+     */
+    void MoveFrom(StringImpl&& rOther);
+#endif
+
 private:
-    T* mpBuffer;   // String buffer
-    u32 mCapacity; // Buffer size
-    u32 mLength;   // String length (not including null terminator)
+    //! Local buffer size (in characters, including null terminator)
+    static const u32 scLocalSize = 16 / sizeof(T);
+
+    T* mpBuffer;             // String buffer
+    u32 mCapacity;           // Buffer size
+    u32 mLength;             // String length (not including null terminator)
+    IAllocator* mpAllocator; // Buffer allocator (nullptr for the heap)
 
-    // Static string for empty String objects
-    static const T* scEmptyCStr;
+    T mLocalBuffer[scLocalSize]; // Storage for short strings
 
 public:
     static const u32 npos = -1;
@@ -0,0 +1,244 @@
+#include <libkiwi.h>
+
+#include <cstring>
+#include <cwchar>
+
+namespace kiwi {
+namespace {
+
+template <typename T> u32 StrLen(const T* pStr);
+template <typename T> const T* MemChr(const T* pData, T c, u32 n);
+template <typename T> int MemCmp(const T* pData1, const T* pData2, u32 n);
+
+} // namespace
+
+/**
+ * @brief Constructor
+ * @details C-style string constructor
+ *
+ * @param pStr C-style string
+ */
+template <typename T>
+StringViewImpl<T>::StringViewImpl(const T* pStr)
+    : mpData(pStr), mLength(0) {
+    K_ASSERT(pStr != nullptr);
+    mLength = StrLen(pStr);
+}
+
+/**
+ * @brief Generates a view of part of this view
+ *
+ * @param pos Substring start position
+ * @param len Substring size
+ */
+template <typename T>
+StringViewImpl<T> StringViewImpl<T>::SubStr(u32 pos, u32 len) const {
+    K_ASSERT(pos <= mLength);
+
+    // Clamp substring length
+    len = Min(len, mLength - pos);
+
+    return StringViewImpl(mpData + pos, len);
+}
+
+/**
+ * @brief Finds first occurrence of sequence in view
+ *
+ * @param rStr Sequence to search for
+ * @param pos Search offset (from view start)
+ * @return Match position if found, otherwise npos
+ */
+template <typename T>
+u32 StringViewImpl<T>::Find(const StringViewImpl& rStr, u32 pos) const {
+    // Cannot match empty string
+    if (rStr.Empty()) {
+        return npos;
+    }
+
+    // Cannot match past end of string
+    if (pos >= mLength || rStr.Length() > mLength - pos) {
+        return npos;
+    }
+
+    // Last position where the sequence still fits
+    u32 last = mLength - rStr.Length();
+
+    while (pos <= last) {
+        // Skip ahead to the next candidate
+        const T* pCandidate =
+            MemChr(mpData + pos, rStr.mpData[0], last - pos + 1);
+
+        // Not found
+        if (pCandidate == nullptr) {
+            return npos;
+        }
+
+        pos = pCandidate - mpData;
+
+        // First character already matched
+        if (MemCmp(pCandidate + 1, rStr.mpData + 1, rStr.Length() - 1) == 0) {
+            return pos;
+        }
+
+        pos++;
+    }
+
+    return npos;
+}
+
+/**
+ * @brief Finds first occurrence of character in view
+ *
+ * @param c Character to search for
+ * @param pos Search offset (from view start)
+ * @return Match position if found, otherwise npos
+ */
+template <typename T> u32 StringViewImpl<T>::Find(T c, u32 pos) const {
+    // Cannot match past end of string
+    if (pos >= mLength) {
+        return npos;
+    }
+
+    const T* pResult = MemChr(mpData + pos, c, mLength - pos);
+
+    // Not found
+    if (pResult == nullptr) {
+        return npos;
+    }
+
+    return pResult - mpData;
+}
+
+/**
+ * @brief Tests whether this view starts with the specified prefix
+ *
+ * @param rStr Prefix sequence
+ */
+template <typename T>
+bool StringViewImpl<T>::StartsWith(const StringViewImpl& rStr) const {
+    // Prefix can't be longer than the string
+    if (rStr.Length() > mLength) {
+        return false;
+    }
+
+    return MemCmp(mpData, rStr.mpData, rStr.Length()) == 0;
+}
+
+/**
+ * @brief Tests whether this view ends with the specified suffix
+ *
+ * @param rStr Suffix sequence
+ */
+template <typename T>
+bool StringViewImpl<T>::EndsWith(const StringViewImpl& rStr) const {
+    // Suffix can't be longer than the string
+    if (rStr.Length() > mLength) {
+        return false;
+    }
+
+    u32 pos = mLength - rStr.Length();
+    return MemCmp(mpData + pos, rStr.mpData, rStr.Length()) == 0;
+}
+
+/**
+ * @brief Split this view into tokens by the specified delimiter
+ * @note Tokens view the same data as this view
+ *
+ * @param rDelim Delimiter sequence
+ */
+template <typename T>
+TVector<StringViewImpl<T> >
+StringViewImpl<T>::Split(const StringViewImpl& rDelim) const {
+    K_ASSERT(rDelim.Length() > 0);
+
+    TVector<StringViewImpl> tokens;
+
+    // Search window
+    u32 start = 0;
+    u32 end = 0;
+
+    while (start < mLength) {
+        // Next occurrence in search window
+        end = Find(rDelim, start);
+
+        // No more occurrences in the string
+        if (end == npos) {
+            break;
+        }
+
+        // Split off token
+        tokens.PushBack(SubStr(start, end - start));
+        // Search window now ignores previous characters
+        start = end + rDelim.Length();
+    }
+
+    // Push back very last token
+    if (start < mLength) {
+        tokens.PushBack(SubStr(start));
+    }
+
+    return tokens;
+}
+
+/**
+ * @brief Tests for equality between views
+ *
+ * @param rStr View to compare against
+ */
+template <typename T>
+bool StringViewImpl<T>::operator==(const StringViewImpl& rStr) const {
+    // Don't bother comparing data if lengths are different
+    if (mLength != rStr.Length()) {
+        return false;
+    }
+
+    return MemCmp(mpData, rStr.mpData, mLength) == 0;
+}
+
+namespace {
+
+/**
+ * strlen wrapper function
+ */
+template <> u32 StrLen<char>(const char* pStr) {
+    return std::strlen(pStr);
+}
+template <> u32 StrLen<wchar_t>(const wchar_t* pStr) {
+    return std::wcslen(pStr);
+}
+
+/**
+ * memchr wrapper function
+ */
+template <> const char* MemChr<char>(const char* pData, char c, u32 n) {
+    return static_cast<const char*>(std::memchr(pData, c, n));
+}
+template <>
+const wchar_t* MemChr<wchar_t>(const wchar_t* pData, wchar_t c, u32 n) {
+    for (u32 i = 0; i < n; i++) {
+        if (pData[i] == c) {
+            return pData + i;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * memcmp wrapper function
+ */
+template <> int MemCmp<char>(const char* pData1, const char* pData2, u32 n) {
+    return n > 0 ? std::memcmp(pData1, pData2, n) : 0;
+}
+template <>
+int MemCmp<wchar_t>(const wchar_t* pData1, const wchar_t* pData2, u32 n) {
+    return n > 0 ? std::memcmp(pData1, pData2, n * sizeof(wchar_t)) : 0;
+}
+
+} // namespace
+
+// Instantiate supported view types
+template class StringViewImpl<char>;
+template class StringViewImpl<wchar_t>;
+
+} // namespace kiwi
@@ -0,0 +1,167 @@
+#ifndef LIBKIWI_PRIM_STRING_VIEW_H
+#define LIBKIWI_PRIM_STRING_VIEW_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+#include <libkiwi/prim/kiwiHashMap.h>
+#include <libkiwi/prim/kiwiVector.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_prim
+//! @{
+
+// Forward declarations
+template <typename T> class StringImpl;
+
+/**
+ * @brief Non-owning view of a character sequence
+ * @details Views are not null-terminated, and never allocate memory. Use them
+ * to parse strings without creating temporary copies.
+ * @note The viewed data must outlive the view
+ */
+template <typename T> class StringViewImpl {
+public:
+    /**
+     * @brief Constructor
+     */
+    StringViewImpl() : mpData(nullptr), mLength(0) {}
+
+    /**
+     * @brief Constructor
+     * @details C-style string constructor
+     *
+     * @param pStr C-style string
+     */
+    StringViewImpl(const T* pStr);
+
+    /**
+     * @brief Constructor
+     * @details Buffer/sequence constructor
+     *
+     * @param pData Buffer/sequence
+     * @param n Number of characters to view
+     */
+    StringViewImpl(const T* pData, u32 n) : mpData(pData), mLength(n) {
+        K_ASSERT(mpData != nullptr || mLength == 0);
+    }
+
+    /**
+     * @brief Constructor
+     * @details String constructor
+     *
+     * @param rStr String to view
+     */
+    StringViewImpl(const StringImpl<T>& rStr)
+        : mpData(rStr.CStr()), mLength(rStr.Length()) {}
+
+    /**
+     * @brief Gets the length of the viewed sequence
+     */
+    u32 Length() const {
+        return mLength;
+    }
+
+    /**
+     * @brief Tests whether the view is empty
+     */
+    bool Empty() const {
+        return Length() == 0;
+    }
+
+    /**
+     * @brief Gets the viewed data
+     * @note Not null-terminated
+     */
+    const T* Data() const {
+        return mpData;
+    }
+
+    /**
+     * @brief Accesses a character in the view
+     *
+     * @param i Character index
+     */
+    const T& operator[](u32 i) const {
+        K_ASSERT(i < mLength);
+        return mpData[i];
+    }
+
+    /**
+     * @brief Generates a view of part of this view
+     *
+     * @param pos Substring start position
+     * @param len Substring size
+     */
+    StringViewImpl SubStr(u32 pos = 0, u32 len = npos) const;
+
+    /**
+     * @brief Finds first occurrence of sequence in view
+     *
+     * @param rStr Sequence to search for
+     * @param pos Search offset (from view start)
+     * @return Match position if found, otherwise npos
+     */
+    u32 Find(const StringViewImpl& rStr, u32 pos = 0) const;
+    /**
+     * @brief Finds first occurrence of character in view
+     *
+     * @param c Character to search for
+     * @param pos Search offset (from view start)
+     * @return Match position if found, otherwise npos
+     */
+    u32 Find(T c, u32 pos = 0) const;
+
+    /**
+     * @brief Tests whether this view starts with the specified prefix
+     *
+     * @param rStr Prefix sequence
+     */
+    bool StartsWith(const StringViewImpl& rStr) const;
+    /**
+     * @brief Tests whether this view ends with the specified suffix
+     *
+     * @param rStr Suffix sequence
+     */
+    bool EndsWith(const StringViewImpl& rStr) const;
+
+    /**
+     * @brief Split this view into tokens by the specified delimiter
+     * @note Tokens view the same data as this view
+     *
+     * @param rDelim Delimiter sequence
+     */
+    TVector<StringViewImpl> Split(const StringViewImpl& rDelim) const;
+
+    // clang-format off
+    bool operator==(const StringViewImpl& rStr) const;
+    bool operator!=(const StringViewImpl& rStr) const { return (*this == rStr) == false; }
+    // clang-format on
+
+private:
+    const T* mpData; // Viewed data
+    u32 mLength;     // View length
+
+public:
+    static const u32 npos = -1;
+};
+
+typedef StringViewImpl<char> StringView;
+typedef StringViewImpl<wchar_t> WStringView;
+
+// Views only hold a pointer and a length
+K_TRIVIALLY_RELOCATABLE(StringView)
+K_TRIVIALLY_RELOCATABLE(WStringView)
+
+/**
+ * @brief Hashes a key of any type
+ * @note Hash support for StringView types (matches the String hash)
+ *
+ * @param rKey Key
+ */
+template <typename T> K_INLINE hash_t Hash(const StringViewImpl<T>& rKey) {
+    return HashImpl(rKey.Data(), rKey.Length() * sizeof(T));
+}
+
+//! @}
+} // namespace kiwi
+
+#endif
@@ -1,14 +1,67 @@
 #ifndef LIBKIWI_PRIM_VECTOR_H
 #define LIBKIWI_PRIM_VECTOR_H
+#include <libkiwi/core/kiwiAllocator.h>
 #include <libkiwi/debug/kiwiAssert.h>
 #include <libkiwi/k_types.h>
 
 #include <algorithm>
 
+/**
+ * @brief Vector capacity growth factor, as a percentage
+ * @details Define this in your LIBKIWI_USER_CONFIG to override it. Values
+ * closer to 100 waste less memory, while larger values reallocate less often.
+ */
+#ifndef LIBKIWI_VECTOR_GROWTH_PERCENT
+#define LIBKIWI_VECTOR_GROWTH_PERCENT 150
+#endif
+
 namespace kiwi {
 //! @addtogroup libkiwi_prim
 //! @{
 
+/**
+ * @brief Tests whether objects of a type can be relocated with memcpy
+ * @details Relocation is a move construction followed by destruction of the
+ * source object. Types with trivial copy constructors and destructors can be
+ * relocated byte-wise, which is much faster for large containers.
+ * @note Specialize this for your custom types
+ */
+template <typename T> struct TIsTriviallyRelocatable {
+    static const bool value = false;
+};
+
+/**
+ * @brief Marks a type as trivially relocatable
+ * @note Must be used from inside the kiwi namespace
+ *
+ * @param T Type name
+ */
+#define K_TRIVIALLY_RELOCATABLE(T)                                             \
+    template <> struct TIsTriviallyRelocatable<T> {                            \
+        static const bool value = true;                                        \
+    };
+
+// Primitive types
+K_TRIVIALLY_RELOCATABLE(bool)
+K_TRIVIALLY_RELOCATABLE(char)
+K_TRIVIALLY_RELOCATABLE(u8)
+K_TRIVIALLY_RELOCATABLE(s8)
+K_TRIVIALLY_RELOCATABLE(u16)
+K_TRIVIALLY_RELOCATABLE(s16)
+K_TRIVIALLY_RELOCATABLE(u32)
+K_TRIVIALLY_RELOCATABLE(s32)
+K_TRIVIALLY_RELOCATABLE(u64)
+K_TRIVIALLY_RELOCATABLE(s64)
+K_TRIVIALLY_RELOCATABLE(int)
+K_TRIVIALLY_RELOCATABLE(unsigned int)
+K_TRIVIALLY_RELOCATABLE(f32)
+K_TRIVIALLY_RELOCATABLE(f64)
+
+// Pointer types
+template <typename T> struct TIsTriviallyRelocatable<T*> {
+    static const bool value = true;
+};
+
 /**
  * @brief Dynamically-sized, contiguous array (std::vector)
  */
@@ -210,14 +263,17 @@ public:
     /**
      * @brief Constructor
      */
-    TVector() : mpData(nullptr), mCapacity(0), mSize(0) {}
+    TVector()
+        : mpData(nullptr), mCapacity(0), mSize(0), mpAllocator(nullptr) {}
 
     /**
      * @brief Constructor
      *
      * @param capacity Buffer capacity
+     * @param pAllocator Buffer allocator (nullptr for the default heap)
      */
-    explicit TVector(u32 capacity) : mpData(nullptr), mCapacity(0), mSize(0) {
+    explicit TVector(u32 capacity, IAllocator* pAllocator = nullptr)
+        : mpData(nullptr), mCapacity(0), mSize(0), mpAllocator(pAllocator) {
         Reserve(capacity);
     }
 
@@ -227,7 +283,8 @@ public:
      *
      * @param rOther Vector to copy
      */
-    TVector(const TVector& rOther) : mpData(nullptr), mCapacity(0), mSize(0) {
+    TVector(const TVector& rOther)
+        : mpData(nullptr), mCapacity(0), mSize(0), mpAllocator(nullptr) {
         CopyFrom(rOther);
     }
 
@@ -238,7 +295,8 @@ public:
      *
      * @param rOther Vector to move
      */
-    TVector(TVector&& rOther) : mpData(nullptr), mCapacity(0), mSize(0) {
+    TVector(TVector&& rOther)
+        : mpData(nullptr), mCapacity(0), mSize(0), mpAllocator(nullptr) {
         MoveFrom(std::move(rOther));
     }
 #endif
@@ -251,7 +309,7 @@ public:
         Clear();
 
         // Free array buffer
-        delete mpData;
+        IAllocator::FreeTo(mpAllocator, mpData);
     }
 
     /**
@@ -276,6 +334,23 @@ public:
     }
 #endif
 
+    /**
+     * @brief Sets the allocator used for the buffer
+     * @note Only possible before the buffer is allocated
+     *
+     * @param pAllocator Buffer allocator (nullptr for the default heap)
+     */
+    void SetAllocator(IAllocator* pAllocator) {
+        K_ASSERT_EX(mpData == nullptr, "Buffer is already allocated");
+        mpAllocator = pAllocator;
+    }
+    /**
+     * @brief Gets the allocator used for the buffer
+     */
+    IAllocator* GetAllocator() const {
+        return mpAllocator;
+    }
+
     /**
      * @brief Gets iterator to beginning of vector
      */
@@ -309,6 +384,14 @@ public:
         return mSize;
     }
 
+    /**
+     * @brief Gets the number of elements the vector can hold before it must
+     * reallocate
+     */
+    u32 Capacity() const {
+        return mCapacity;
+    }
+
     /**
      * @brief Tests whether the vector is empty
      */
@@ -339,11 +422,37 @@ public:
         return Buffer()[i];
     }
 
+    /**
+     * @brief Accesses underlying array buffer
+     */
+    T* Data() {
+        return Buffer();
+    }
+    /**
+     * @brief Accesses underlying array buffer (read-only)
+     */
+    const T* Data() const {
+        return Buffer();
+    }
+
     /**
      * @brief Clears vector contents
+     * @note The buffer is kept for reuse. Call ShrinkToFit to release it.
      */
     void Clear();
 
+    /**
+     * @brief Reserves space for elements in the vector
+     *
+     * @param capacity New capacity
+     */
+    void Reserve(u32 capacity);
+
+    /**
+     * @brief Shrinks the buffer to fit the current number of elements
+     */
+    void ShrinkToFit();
+
     /**
      * @brief Inserts a new element at the specified position
      *
@@ -374,6 +483,46 @@ public:
      */
     void PushBack(const T& rElem);
 
+    /**
+     * @brief Constructs a new element in-place at the back of the vector
+     *
+     * @return Reference to new element
+     */
+    T& EmplaceBack();
+
+    /**
+     * @brief Constructs a new element in-place at the back of the vector
+     *
+     * @param rArg Constructor argument
+     * @return Reference to new element
+     */
+    template <typename TArg> T& EmplaceBack(const TArg& rArg);
+
+    /**
+     * @brief Appends a range of elements to the back of the vector
+     *
+     * @param pElems Element array
+     * @param num Number of elements
+     */
+    void Append(const T* pElems, u32 num);
+
+    /**
+     * @brief Appends the contents of another vector to the back of the vector
+     *
+     * @param rOther Vector to append
+     */
+    void Append(const TVector& rOther) {
+        Append(rOther.Buffer(), rOther.Size());
+    }
+
+    /**
+     * @brief Appends a range of elements to the back of the vector
+     *
+     * @param begin Beginning of range (inclusive)
+     * @param end End of range (exclusive)
+     */
+    template <typename TIter> void Append(TIter begin, TIter end);
+
     /**
      * @brief Removes the last element from the vector
      */
@@ -388,11 +537,59 @@ private:
     }
 
     /**
-     * @brief Reserves space for elements in the vector
+     * @brief Calculates the capacity to use when growing the vector
+     *
+     * @param required Minimum number of elements that must fit
+     */
+    u32 GrowCapacity(u32 required) const;
+
+    /**
+     * @brief Makes space for the specified number of elements, growing the
+     * buffer geometrically if needed
+     *
+     * @param required Minimum number of elements that must fit
+     */
+    void EnsureCapacity(u32 required) {
+        if (required > mCapacity) {
+            Reserve(GrowCapacity(required));
+        }
+    }
+
+    /**
+     * @brief Reallocates the underlying buffer
      *
      * @param capacity New capacity
      */
-    void Reserve(u32 capacity);
+    void Reallocate(u32 capacity);
+    /**
+     * @brief Tries to resize the underlying buffer without moving it
+     *
+     * @param capacity New capacity
+     * @return Success
+     */
+    bool ResizeBuffer(u32 capacity);
+
+    /**
+     * @brief Moves the vector contents into a new buffer
+     * @details A gap is left at the specified position, so the caller can
+     * construct a new element there
+     *
+     * @param pBuffer New buffer
+     * @param capacity New buffer capacity
+     * @param gap Position of the gap
+     */
+    void Adopt(u8* pBuffer, u32 capacity, u32 gap);
+
+    /**
+     * @brief Relocates a range of elements to a new location
+     * @details Elements are move-constructed at the destination and destroyed
+     * at the source. The ranges may overlap.
+     *
+     * @param pDst Destination
+     * @param pSrc Source
+     * @param num Number of elements
+     */
+    static void Relocate(T* pDst, T* pSrc, u32 num);
 
     /**
      * @brief Copies vector contents
@@ -409,9 +606,14 @@ private:
     void MoveFrom(TVector&& rOther);
 
 private:
-    u8* mpData;    // Allocated buffer
-    u32 mCapacity; // Buffer size
-    u32 mSize;     // Number of elements
+    //! Smallest capacity allocated when growing
+    static const u32 scMinCapacity = 4;
+
+private:
+    u8* mpData;              // Allocated buffer
+    u32 mCapacity;           // Buffer size
+    u32 mSize;               // Number of elements
+    IAllocator* mpAllocator; // Buffer allocator (nullptr for the heap)
 };
 
 //! @}
@@ -13,6 +13,7 @@ namespace kiwi {
 
 /**
  * @brief Clears vector contents
+ * @note The buffer is kept for reuse. Call ShrinkToFit to release it.
  */
 template <typename T> K_INLINE void TVector<T>::Clear() {
     K_ASSERT(mSize == 0 || mpData != nullptr);
@@ -24,6 +25,32 @@ template <typename T> K_INLINE void TVector<T>::Clear() {
     mSize = 0;
 }
 
+/**
+ * @brief Reserves space for elements in the vector
+ *
+ * @param capacity New capacity
+ */
+template <typename T> K_INLINE void TVector<T>::Reserve(u32 capacity) {
+    // All good!
+    if (mCapacity >= capacity) {
+        return;
+    }
+
+    Reallocate(capacity);
+}
+
+/**
+ * @brief Shrinks the buffer to fit the current number of elements
+ */
+template <typename T> K_INLINE void TVector<T>::ShrinkToFit() {
+    // All good!
+    if (mCapacity == mSize) {
+        return;
+    }
+
+    Reallocate(mSize);
+}
+
 /**
  * @brief Inserts a new element at the specified position
  *
@@ -34,19 +61,37 @@ template <typename T>
 K_INLINE void TVector<T>::Insert(const T& rElem, u32 pos) {
     K_ASSERT(pos <= mSize);
 
-    // Make space for one extra element
-    Reserve(mSize + 1);
+    // Need to grow the buffer
+    if (mSize + 1 > mCapacity && !ResizeBuffer(GrowCapacity(mSize + 1))) {
+        u32 capacity = GrowCapacity(mSize + 1);
+
+        u8* pBuffer = static_cast<u8*>(
+            IAllocator::AllocFrom(mpAllocator, capacity * sizeof(T)));
+        K_ASSERT(pBuffer != nullptr);
+
+        // The element may live in the old buffer, so construct it first
+        new (reinterpret_cast<T*>(pBuffer) + pos) T(rElem);
+
+        Adopt(pBuffer, capacity, pos);
+        mSize++;
+        return;
+    }
 
     K_ASSERT(mpData != nullptr);
+    const T* pElem = &rElem;
 
-    // Inserted in the middle, copy forward
+    // Inserted in the middle, relocate forward
     if (pos < mSize) {
-        std::memcpy(Buffer() + pos + 1, Buffer() + pos,
-                    (mSize - pos) * sizeof(T));
+        // The element may live in the range that is about to move
+        if (pElem >= Buffer() + pos && pElem < Buffer() + mSize) {
+            pElem++;
+        }
+
+        Relocate(Buffer() + pos + 1, Buffer() + pos, mSize - pos);
     }
 
     // Copy construct in-place
-    new (&Buffer()[pos]) T(rElem);
+    new (&Buffer()[pos]) T(*pElem);
     mSize++;
 }
 
@@ -83,11 +128,8 @@ template <typename T> K_INLINE void TVector<T>::RemoveAt(u32 pos) {
     // Destroy element
     Buffer()[pos].~T();
 
-    // Removed from the middle, copy backward
-    if (pos < mSize) {
-        std::memcpy(Buffer() + pos, Buffer() + pos + 1,
-                    (mSize - pos) * sizeof(T));
-    }
+    // Removed from the middle, relocate backward
+    Relocate(Buffer() + pos, Buffer() + pos + 1, mSize - pos - 1);
 
     mSize--;
 }
@@ -101,33 +143,197 @@ template <typename T> K_INLINE void TVector<T>::PushBack(const T& rElem) {
     Insert(rElem, mSize);
 }
 
+/**
+ * @brief Constructs a new element in-place at the back of the vector
+ *
+ * @return Reference to new element
+ */
+template <typename T> K_INLINE T& TVector<T>::EmplaceBack() {
+    EnsureCapacity(mSize + 1);
+    K_ASSERT(mpData != nullptr);
+
+    T* pElem = new (&Buffer()[mSize]) T();
+    mSize++;
+
+    return *pElem;
+}
+
+/**
+ * @brief Constructs a new element in-place at the back of the vector
+ *
+ * @param rArg Constructor argument
+ * @return Reference to new element
+ */
+template <typename T>
+template <typename TArg>
+K_INLINE T& TVector<T>::EmplaceBack(const TArg& rArg) {
+    // Need to grow the buffer
+    if (mSize + 1 > mCapacity && !ResizeBuffer(GrowCapacity(mSize + 1))) {
+        u32 capacity = GrowCapacity(mSize + 1);
+
+        u8* pBuffer = static_cast<u8*>(
+            IAllocator::AllocFrom(mpAllocator, capacity * sizeof(T)));
+        K_ASSERT(pBuffer != nullptr);
+
+        // The argument may live in the old buffer, so construct it first
+        T* pElem = new (reinterpret_cast<T*>(pBuffer) + mSize) T(rArg);
+
+        Adopt(pBuffer, capacity, mSize);
+        mSize++;
+        return *pElem;
+    }
+
+    T* pElem = new (&Buffer()[mSize]) T(rArg);
+    mSize++;
+
+    return *pElem;
+}
+
+/**
+ * @brief Appends a range of elements to the back of the vector
+ *
+ * @param pElems Element array
+ * @param num Number of elements
+ */
+template <typename T>
+K_INLINE void TVector<T>::Append(const T* pElems, u32 num) {
+    K_ASSERT(num == 0 || pElems != nullptr);
+
+    if (num == 0) {
+        return;
+    }
+
+    // Need to grow the buffer
+    if (mSize + num > mCapacity) {
+        // Appending from our own buffer (i.e. duplicating contents)
+        bool alias = pElems >= Buffer() && pElems < Buffer() + mSize;
+        u32 offset = alias ? pElems - Buffer() : 0;
+
+        Reserve(GrowCapacity(mSize + num));
+
+        if (alias) {
+            pElems = Buffer() + offset;
+        }
+    }
+
+    K_ASSERT(mpData != nullptr);
+
+    for (u32 i = 0; i < num; i++) {
+        new (&Buffer()[mSize + i]) T(pElems[i]);
+    }
+
+    mSize += num;
+}
+
+/**
+ * @brief Appends a range of elements to the back of the vector
+ *
+ * @param begin Beginning of range (inclusive)
+ * @param end End of range (exclusive)
+ */
+template <typename T>
+template <typename TIter>
+K_INLINE void TVector<T>::Append(TIter begin, TIter end) {
+    // Count elements so we only grow the buffer once
+    u32 num = 0;
+    for (TIter it = begin; it != end; ++it) {
+        num++;
+    }
+
+    EnsureCapacity(mSize + num);
+
+    for (TIter it = begin; it != end; ++it) {
+        new (&Buffer()[mSize]) T(*it);
+        mSize++;
+    }
+}
+
 /**
  * @brief Removes the last element from the vector
  */
 template <typename T> K_INLINE void TVector<T>::PopBack() {
     K_ASSERT(mSize > 0);
-    Remove(mSize - 1);
+    RemoveAt(mSize - 1);
 }
 
 /**
- * @brief Reserves space for elements in the vector
+ * @brief Calculates the capacity to use when growing the vector
+ *
+ * @param required Minimum number of elements that must fit
+ */
+template <typename T>
+K_INLINE u32 TVector<T>::GrowCapacity(u32 required) const {
+    u32 capacity = mCapacity * LIBKIWI_VECTOR_GROWTH_PERCENT / 100;
+
+    // Small buffers would otherwise grow one element at a time
+    if (capacity < scMinCapacity) {
+        capacity = scMinCapacity;
+    }
+
+    return capacity > required ? capacity : required;
+}
+
+/**
+ * @brief Reallocates the underlying buffer
  *
  * @param capacity New capacity
  */
-template <typename T> K_INLINE void TVector<T>::Reserve(u32 capacity) {
-    // All good!
-    if (mCapacity >= capacity) {
+template <typename T> K_INLINE void TVector<T>::Reallocate(u32 capacity) {
+    K_ASSERT(capacity >= mSize);
+
+    // Elements stay where they are
+    if (capacity > 0 && ResizeBuffer(capacity)) {
         return;
     }
 
-    // Need to reallocate
-    u8* pBuffer = new u8[capacity * sizeof(T)];
-    K_ASSERT(pBuffer != nullptr);
+    u8* pBuffer = nullptr;
+
+    if (capacity > 0) {
+        pBuffer = static_cast<u8*>(
+            IAllocator::AllocFrom(mpAllocator, capacity * sizeof(T)));
+        K_ASSERT(pBuffer != nullptr);
+    }
+
+    Adopt(pBuffer, capacity, mSize);
+}
+
+/**
+ * @brief Tries to resize the underlying buffer without moving it
+ *
+ * @param capacity New capacity
+ * @return Success
+ */
+template <typename T> K_INLINE bool TVector<T>::ResizeBuffer(u32 capacity) {
+    K_ASSERT(capacity >= mSize);
+
+    if (!IAllocator::ResizeIn(mpAllocator, mpData, capacity * sizeof(T))) {
+        return false;
+    }
+
+    mCapacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Moves the vector contents into a new buffer
+ * @details A gap is left at the specified position, so the caller can
+ * construct a new element there
+ *
+ * @param pBuffer New buffer
+ * @param capacity New buffer capacity
+ * @param gap Position of the gap
+ */
+template <typename T>
+K_INLINE void TVector<T>::Adopt(u8* pBuffer, u32 capacity, u32 gap) {
+    K_ASSERT(gap <= mSize);
+
+    T* pDst = reinterpret_cast<T*>(pBuffer);
 
-    // Copy in old data
     if (mpData != nullptr) {
-        std::memcpy(pBuffer, mpData, mSize * sizeof(T));
-        delete mpData;
+        Relocate(pDst, Buffer(), gap);
+        Relocate(pDst + gap + 1, Buffer() + gap, mSize - gap);
+
+        IAllocator::FreeTo(mpAllocator, mpData);
     }
 
     // Swap buffer
@@ -135,6 +341,45 @@ template <typename T> K_INLINE void TVector<T>::Reserve(u32 capacity) {
     mCapacity = capacity;
 }
 
+/**
+ * @brief Relocates a range of elements to a new location
+ * @details Elements are move-constructed at the destination and destroyed
+ * at the source. The ranges may overlap.
+ *
+ * @param pDst Destination
+ * @param pSrc Source
+ * @param num Number of elements
+ */
+template <typename T>
+K_INLINE void TVector<T>::Relocate(T* pDst, T* pSrc, u32 num) {
+    if (num == 0 || pDst == pSrc) {
+        return;
+    }
+
+    K_ASSERT(pDst != nullptr && pSrc != nullptr);
+
+    // Plain data can be moved byte-wise
+    if (TIsTriviallyRelocatable<T>::value) {
+        std::memmove(pDst, pSrc, num * sizeof(T));
+        return;
+    }
+
+    // Copy forward so we never overwrite elements we haven't moved yet
+    if (pDst < pSrc) {
+        for (u32 i = 0; i < num; i++) {
+            new (&pDst[i]) T(std::move(pSrc[i]));
+            pSrc[i].~T();
+        }
+    }
+    // Copy backward for the same reason
+    else {
+        for (u32 i = num; i > 0; i--) {
+            new (&pDst[i - 1]) T(std::move(pSrc[i - 1]));
+            pSrc[i - 1].~T();
+        }
+    }
+}
+
 /**
  * @brief Copies vector contents
  *
@@ -142,12 +387,22 @@ template <typename T> K_INLINE void TVector<T>::Reserve(u32 capacity) {
  */
 template <typename T>
 K_INLINE void TVector<T>::CopyFrom(const TVector& rOther) {
+    // Self-assignment
+    if (&rOther == this) {
+        return;
+    }
+
     // Destroy existing contents
     Clear();
 
     // Make sure we can fit the contents
     Reserve(rOther.mSize);
-    std::memcpy(mpData, rOther.mpData, rOther.mSize * sizeof(T));
+
+    for (u32 i = 0; i < rOther.mSize; i++) {
+        new (&Buffer()[i]) T(rOther.Buffer()[i]);
+    }
+
+    mSize = rOther.mSize;
 }
 
 /**
@@ -156,13 +411,20 @@ K_INLINE void TVector<T>::CopyFrom(const TVector& rOther) {
  * @param rOther Vector to move
  */
 template <typename T> K_INLINE void TVector<T>::MoveFrom(TVector&& rOther) {
+    // Self-assignment
+    if (&rOther == this) {
+        return;
+    }
+
     // Destroy contents & free buffer
     Clear();
-    delete mpData;
+    IAllocator::FreeTo(mpAllocator, mpData);
 
+    // Buffer can only be freed by the allocator that owns it
     mpData = rOther.mpData;
     mCapacity = rOther.mCapacity;
     mSize = rOther.mSize;
+    mpAllocator = rOther.mpAllocator;
 
     rOther.mpData = nullptr;
     rOther.mCapacity = 0;
@@ -275,9 +275,12 @@ SOResult LibSO::Connect(SOSocket socket, const SockAddrAny& addr) {
     args->hasDest = TRUE;
     args->dest = addr;
 
+    u32 start = OSGetTick();
     s32 result = sDevNetIpTop.Ioctl(Ioctl_SOConnect, args, dummy);
     sLastError = static_cast<SOResult>(result);
 
+    NetStats::Record(NetStats::EOp_Connect, result, start);
+
     return sLastError;
 }
 
@@ -455,33 +458,37 @@ s32 LibSO::RecvImpl(SOSocket socket, void* dst, u32 len, u32 flags,
     K_ASSERT(dst != nullptr);
     K_ASSERT(addr == nullptr || addr->IsValid());
 
-    TVector<IosVector> input;
-    TVector<IosVector> output;
+    // Fixed-size vector lists avoid heap allocations on this hot path
+    IosVector input[1];
+    IosVector output[2];
 
     // Input vector 1: Ioctl args
     IosObject<SORecvArgs> args;
     args->fd = socket;
     args->flags = flags;
-    input.PushBack(args);
+    input[0] = args;
 
     // Output vector 1: Destination buffer
-    IosVector buffer;
-    buffer.Set(dst, len);
-    output.PushBack(buffer);
+    output[0].Set(dst, len);
 
     // Output vector 2: Source address
     IosObject<SockAddrAny> from;
-    IosVector dummy;
     if (addr != nullptr) {
         *from = *addr;
-        output.PushBack(from);
-    } else {
-        output.PushBack(dummy);
+        output[1] = from;
     }
 
-    s32 result = sDevNetIpTop.IoctlV(Ioctl_SORecvFrom, input, output);
+    u32 start = OSGetTick();
+    s32 result = sDevNetIpTop.IoctlV(Ioctl_SORecvFrom, input, LENGTHOF(input),
+                                     output, LENGTHOF(output));
     sLastError = result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result);
 
+    NetStats::Record(NetStats::EOp_Recv, result, start);
+
+    if (addr != nullptr && result >= 0) {
+        *addr = *from;
+    }
+
     return result;
 }
 
@@ -507,19 +514,17 @@ s32 LibSO::SendImpl(SOSocket socket, const void* src, u32 len, u32 flags,
     K_ASSERT(src != nullptr);
     K_ASSERT(addr == nullptr || addr->IsValid());
 
-    TVector<IosVector> input;
-    TVector<IosVector> output;
+    // Fixed-size vector list avoids heap allocations on this hot path
+    IosVector input[2];
 
     // Input vector 1: Source buffer
-    IosVector buffer;
-    buffer.Set(src, len);
-    input.PushBack(buffer);
+    input[0].Set(src, len);
 
     // Input vector 2: Ioctl args
     IosObject<SOSendArgs> args;
     args->fd = socket;
     args->flags = flags;
-    input.PushBack(args);
+    input[1] = args;
 
     // Copy in destination address
     if (addr != nullptr) {
@@ -530,12 +535,220 @@ s32 LibSO::SendImpl(SOSocket socket, const void* src, u32 len, u32 flags,
     }
 
     // Request send
-    s32 result = sDevNetIpTop.IoctlV(Ioctl_SOSendTo, input, output);
+    u32 start = OSGetTick();
+    s32 result = sDevNetIpTop.IoctlV(Ioctl_SOSendTo, input, LENGTHOF(input),
+                                     nullptr, 0);
     sLastError = result >= 0 ? SO_SUCCESS : static_cast<SOResult>(result);
 
+    NetStats::Record(NetStats::EOp_Send, result, start);
+
     return result;
 }
 
+/**
+ * @brief Asynchronous socket ioctl
+ * @details Owns the ioctl buffers until IOS completes the request
+ *
+ * @tparam T Ioctl argument type
+ */
+template <typename T> struct SOAsyncRequest : public IosRequest {
+    /**
+     * @brief Constructor
+     *
+     * @param pCallback Completion callback
+     * @param pArg Callback user argument
+     * @param[out] pAddr Where to write the peer address
+     */
+    SOAsyncRequest(LibSO::AsyncCallback pCallback, void* pArg,
+                   SockAddrAny* pAddr = nullptr)
+        : pCallback(pCallback),
+          pArg(pArg),
+          pAddr(pAddr),
+          op(NetStats::EOp_Max),
+          start(OSGetTick()) {}
+
+    /**
+     * @brief Handles request completion
+     *
+     * @param result IOS result code
+     */
+    virtual void OnComplete(s32 result) {
+        if (op != NetStats::EOp_Max) {
+            NetStats::Record(op, result, start);
+        }
+
+        // Write out peer address
+        if (result >= 0 && pAddr != nullptr) {
+            *pAddr = *peer;
+        }
+
+        if (pCallback != nullptr) {
+            pCallback(result, pArg);
+        }
+
+        delete this;
+    }
+
+    IosObject<T> args;           // Ioctl arguments
+    IosObject<SockAddrAny> peer; // Peer address
+    IosVector dummy;             // Unused vector
+
+    LibSO::AsyncCallback pCallback; // Completion callback
+    void* pArg;                     // Callback user argument
+    SockAddrAny* pAddr;             // Where to write the peer address
+
+    NetStats::EOp op; // Operation to record in the statistics
+    u32 start;        // Tick when the request was created
+};
+
+/**
+ * @brief Accepts a new connection on a socket asynchronously
+ * @note The address must outlive the operation
+ *
+ * @param socket Socket descriptor
+ * @param[in,out] addr Remote address
+ * @param pCallback Completion callback (socket descriptor or IOS error code)
+ * @param pArg Callback user argument
+ */
+void LibSO::AcceptAsync(SOSocket socket, SockAddrAny& addr,
+                        AsyncCallback pCallback, void* pArg) {
+    K_ASSERT_EX(sDevNetIpTop.IsOpen(), "Please call LibSO::Initialize");
+    K_ASSERT(addr.IsValid());
+
+    SOAsyncRequest<s32>* pRequest =
+        new SOAsyncRequest<s32>(pCallback, pArg, &addr);
+    K_ASSERT(pRequest != nullptr);
+
+    *pRequest->args = socket;
+
+    // Input hints at address type
+    pRequest->peer->len = addr.len;
+
+    sDevNetIpTop.IoctlAsync(Ioctl_SOAccept, pRequest->args, pRequest->peer,
+                            *pRequest);
+}
+
+/**
+ * @brief Connects a socket asynchronously
+ *
+ * @param socket Socket descriptor
+ * @param addr Remote address
+ * @param pCallback Completion callback (IOS error code)
+ * @param pArg Callback user argument
+ */
+void LibSO::ConnectAsync(SOSocket socket, const SockAddrAny& addr,
+                         AsyncCallback pCallback, void* pArg) {
+    K_ASSERT_EX(sDevNetIpTop.IsOpen(), "Please call LibSO::Initialize");
+    K_ASSERT(addr.IsValid());
+
+    SOAsyncRequest<SOConnectArgs>* pRequest =
+        new SOAsyncRequest<SOConnectArgs>(pCallback, pArg);
+    K_ASSERT(pRequest != nullptr);
+
+    pRequest->op = NetStats::EOp_Connect;
+
+    pRequest->args->fd = socket;
+    pRequest->args->hasDest = TRUE;
+    pRequest->args->dest = addr;
+
+    sDevNetIpTop.IoctlAsync(Ioctl_SOConnect, pRequest->args, pRequest->dummy,
+                            *pRequest);
+}
+
+/**
+ * @brief Receives a message asynchronously and records its sender
+ * @note The buffer and address must outlive the operation
+ *
+ * @param socket Socket descriptor
+ * @param dst Destination buffer
+ * @param len Number of bytes to read
+ * @param flags Operation flags
+ * @param[out] addr Sender address (optional)
+ * @param pCallback Completion callback (bytes read or IOS error code)
+ * @param pArg Callback user argument
+ */
+void LibSO::RecvAsync(SOSocket socket, void* dst, u32 len, u32 flags,
+                      SockAddrAny* addr, AsyncCallback pCallback, void* pArg) {
+    K_ASSERT_EX(sDevNetIpTop.IsOpen(), "Please call LibSO::Initialize");
+    K_ASSERT(dst != nullptr);
+    K_ASSERT(addr == nullptr || addr->IsValid());
+
+    SOAsyncRequest<SORecvArgs>* pRequest =
+        new SOAsyncRequest<SORecvArgs>(pCallback, pArg, addr);
+    K_ASSERT(pRequest != nullptr);
+
+    pRequest->op = NetStats::EOp_Recv;
+
+    IosVector input[1];
+    IosVector output[2];
+
+    // Input vector 1: Ioctl args
+    pRequest->args->fd = socket;
+    pRequest->args->flags = flags;
+    input[0] = pRequest->args;
+
+    // Output vector 1: Destination buffer
+    output[0].Set(dst, len);
+
+    // Output vector 2: Source address
+    if (addr != nullptr) {
+        *pRequest->peer = *addr;
+        output[1] = pRequest->peer;
+    }
+
+    // Vector list is copied, so the arrays don't need to outlive this call
+    sDevNetIpTop.IoctlVAsync(Ioctl_SORecvFrom, input, LENGTHOF(input), output,
+                             LENGTHOF(output), *pRequest);
+}
+
+/**
+ * @brief Sends a message asynchronously
+ * @note The buffer must outlive the operation
+ *
+ * @param socket Socket descriptor
+ * @param src Source buffer
+ * @param len Number of bytes to write
+ * @param flags Operation flags
+ * @param addr Recipient address (optional)
+ * @param pCallback Completion callback (bytes written or IOS error code)
+ * @param pArg Callback user argument
+ */
+void LibSO::SendAsync(SOSocket socket, const void* src, u32 len, u32 flags,
+                      const SockAddrAny* addr, AsyncCallback pCallback,
+                      void* pArg) {
+    K_ASSERT_EX(sDevNetIpTop.IsOpen(), "Please call LibSO::Initialize");
+    K_ASSERT(src != nullptr);
+    K_ASSERT(addr == nullptr || addr->IsValid());
+
+    SOAsyncRequest<SOSendArgs>* pRequest =
+        new SOAsyncRequest<SOSendArgs>(pCallback, pArg);
+    K_ASSERT(pRequest != nullptr);
+
+    pRequest->op = NetStats::EOp_Send;
+
+    IosVector input[2];
+
+    // Input vector 1: Source buffer
+    input[0].Set(src, len);
+
+    // Input vector 2: Ioctl args
+    pRequest->args->fd = socket;
+    pRequest->args->flags = flags;
+    input[1] = pRequest->args;
+
+    // Copy in destination address
+    if (addr != nullptr) {
+        pRequest->args->dest = *addr;
+        pRequest->args->hasDest = TRUE;
+    } else {
+        pRequest->args->hasDest = FALSE;
+    }
+
+    // Vector list is copied, so the array doesn't need to outlive this call
+    sDevNetIpTop.IoctlVAsync(Ioctl_SOSendTo, input, LENGTHOF(input), nullptr,
+                             0, *pRequest);
+}
+
 struct SOFcntlArgs {
     /* 0x00 */ s32 fd;
     /* 0x04 */ s32 cmd;
@@ -625,6 +838,85 @@ s32 LibSO::Poll(SOPollFD fds[], u32 numfds, s64 timeout) {
     return result;
 }
 
+/**
+ * @brief Asynchronous poll request
+ * @details Owns the descriptor buffer until IOS completes the request
+ */
+struct SOPollRequest : public IosRequest {
+    /**
+     * @brief Constructor
+     *
+     * @param[in,out] _pFDs Socket descriptor array
+     * @param _numfds Socket descriptor array size
+     * @param timeout Timeout for blocking
+     * @param _pCallback Completion callback
+     * @param _pArg Callback user argument
+     */
+    SOPollRequest(SOPollFD* _pFDs, u32 _numfds, s64 timeout,
+                  LibSO::AsyncCallback _pCallback, void* _pArg)
+        : msec(OS_TICKS_TO_MSEC(timeout)),
+          results(_numfds),
+          pFDs(_pFDs),
+          numfds(_numfds),
+          pCallback(_pCallback),
+          pArg(_pArg) {
+
+        std::memcpy(results.Ptr(), pFDs, numfds * sizeof(SOPollFD));
+    }
+
+    /**
+     * @brief Handles request completion
+     *
+     * @param result IOS result code
+     */
+    virtual void OnComplete(s32 result) {
+        // Output provides search results
+        if (result >= 0) {
+            std::memcpy(pFDs, results.Ptr(), numfds * sizeof(SOPollFD));
+        }
+
+        if (pCallback != nullptr) {
+            pCallback(result, pArg);
+        }
+
+        delete this;
+    }
+
+    IosObject<s64> msec;         // Timeout, in milliseconds
+    IosBuffer<SOPollFD> results; // Poll results
+    SOPollFD* pFDs;              // Where to write the poll results
+    u32 numfds;                  // Socket descriptor array size
+
+    LibSO::AsyncCallback pCallback; // Completion callback
+    void* pArg;                     // Callback user argument
+};
+
+/**
+ * @brief Waits for events on socket file descriptors asynchronously
+ * @note The descriptor array must outlive the operation. Results are written
+ * to it before the callback is invoked.
+ *
+ * @param[in,out] fds Socket descriptor array
+ * @param numfds Socket descriptor array size
+ * @param timeout Timeout for blocking
+ * @param pCallback Completion callback (number of socket results written
+ * out, or IOS error code)
+ * @param pArg Callback user argument
+ */
+void LibSO::PollAsync(SOPollFD fds[], u32 numfds, s64 timeout,
+                      AsyncCallback pCallback, void* pArg) {
+    K_ASSERT_EX(sDevNetIpTop.IsOpen(), "Please call LibSO::Initialize");
+    K_ASSERT(fds != nullptr);
+    K_ASSERT(numfds > 0);
+
+    SOPollRequest* pRequest =
+        new SOPollRequest(fds, numfds, timeout, pCallback, pArg);
+    K_ASSERT(pRequest != nullptr);
+
+    sDevNetIpTop.IoctlAsync(Ioctl_SOPoll, pRequest->msec, pRequest->results,
+                            *pRequest);
+}
+
 /**
  * @brief Convert hostname to IPv4 address
  *
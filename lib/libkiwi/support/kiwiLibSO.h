@@ -20,6 +20,16 @@ class SockAddr6;
  * @brief SO library wrapper/extension
  */
 class LibSO {
+public:
+    /**
+     * @brief Asynchronous operation callback
+     * @note Called from the IOS dispatcher thread
+     *
+     * @param result Operation result (same as the synchronous function)
+     * @param pArg User callback argument
+     */
+    typedef void (*AsyncCallback)(s32 result, void* pArg);
+
 public:
     static void Initialize();
     static SOResult GetLastError();
@@ -43,9 +53,22 @@ public:
     static s32 SendTo(SOSocket socket, const void* src, u32 len, u32 flags,
                       const SockAddrAny& addr);
 
+    static void AcceptAsync(SOSocket socket, SockAddrAny& addr,
+                            AsyncCallback pCallback, void* pArg);
+    static void ConnectAsync(SOSocket socket, const SockAddrAny& addr,
+                             AsyncCallback pCallback, void* pArg);
+    static void RecvAsync(SOSocket socket, void* dst, u32 len, u32 flags,
+                          SockAddrAny* addr, AsyncCallback pCallback,
+                          void* pArg);
+    static void SendAsync(SOSocket socket, const void* src, u32 len, u32 flags,
+                          const SockAddrAny* addr, AsyncCallback pCallback,
+                          void* pArg);
+
     static s32 Fcntl(SOSocket socket, SOFcntlCmd cmd, ...);
     static SOResult Shutdown(SOSocket socket, SOShutdownType how);
     static s32 Poll(SOPollFD fds[], u32 numfds, s64 timeout);
+    static void PollAsync(SOPollFD fds[], u32 numfds, s64 timeout,
+                          AsyncCallback pCallback, void* pArg);
 
     static bool INetAtoN(const String& str, SockAddr4& addr);
 
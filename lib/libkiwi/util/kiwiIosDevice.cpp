@@ -1,7 +1,78 @@
 #include <libkiwi.h>
 
+#include <cstring>
+
 namespace kiwi {
 
+/**
+ * @brief Ioctl statistics
+ */
+IosDevice::Stats IosDevice::sStats;
+
+/**
+ * @brief Gets the ioctl statistics (all devices)
+ */
+IosDevice::Stats IosDevice::GetStats() {
+    AutoInterruptLock lock;
+    return sStats;
+}
+
+/**
+ * @brief Resets the ioctl statistics (all devices)
+ */
+void IosDevice::ResetStats() {
+    AutoInterruptLock lock;
+    std::memset(&sStats, 0, sizeof(Stats));
+}
+
+/**
+ * @brief Records the latency of a completed ioctl
+ *
+ * @param start Tick when the ioctl started
+ */
+void IosDevice::RecordIoctl(u32 start) {
+    u32 ticks = OSGetTick() - start;
+
+    AutoInterruptLock lock;
+
+    sStats.numIoctls++;
+    sStats.maxTicks = Max(sStats.maxTicks, ticks);
+    sStats.totalTicks += ticks;
+}
+
+/**
+ * @brief Builds a contiguous IOS vector list
+ *
+ * @param pIn Input vectors
+ * @param numIn Number of input vectors
+ * @param pOut Output vectors
+ * @param numOut Number of output vectors
+ * @return Vector list (free with IosScratch::Free)
+ */
+IPCIOVector* IosDevice::CreateVectors(const IosVector* pIn, u32 numIn,
+                                      const IosVector* pOut, u32 numOut) {
+    K_ASSERT(pIn != nullptr || numIn == 0);
+    K_ASSERT(pOut != nullptr || numOut == 0);
+
+    // Vectors need to be contiguous and usually(?) in MEM2
+    IPCIOVector* vectors = static_cast<IPCIOVector*>(
+        IosScratch::Alloc((numIn + numOut) * sizeof(IPCIOVector)));
+    K_ASSERT(vectors != nullptr);
+
+    // Copy in user vectors
+    u32 i = 0;
+    for (u32 j = 0; j < numIn; j++, i++) {
+        vectors[i].base = pIn[j].Base();
+        vectors[i].length = pIn[j].Length();
+    }
+    for (u32 j = 0; j < numOut; j++, i++) {
+        vectors[i].base = pOut[j].Base();
+        vectors[i].length = pOut[j].Length();
+    }
+
+    return vectors;
+}
+
 /**
  * @brief Attempt to open this device
  *
@@ -52,7 +123,11 @@ bool IosDevice::Close() {
 s32 IosDevice::Ioctl(s32 id) const {
     K_ASSERT_EX(IsOpen(), "Please open this device");
 
-    return IOS_Ioctl(mHandle, id, nullptr, 0, nullptr, 0);
+    u32 start = OSGetTick();
+    s32 result = IOS_Ioctl(mHandle, id, nullptr, 0, nullptr, 0);
+    RecordIoctl(start);
+
+    return result;
 }
 
 /**
@@ -66,42 +141,98 @@ s32 IosDevice::Ioctl(s32 id) const {
 s32 IosDevice::Ioctl(s32 id, const IosVector& in, IosVector& out) const {
     K_ASSERT_EX(IsOpen(), "Please open this device");
 
-    return IOS_Ioctl(mHandle, id, in.Base(), in.Length(), out.Base(),
-                     out.Length());
+    u32 start = OSGetTick();
+    s32 result = IOS_Ioctl(mHandle, id, in.Base(), in.Length(), out.Base(),
+                           out.Length());
+    RecordIoctl(start);
+
+    return result;
 }
 
 /**
  * @brief Perform I/O control (multiple vectors) on this device
+ * @details Use this with fixed-size arrays to avoid heap allocations
  *
  * @param id Ioctl ID
- * @param in Input vectors
- * @param out Output vectors
+ * @param pIn Input vectors
+ * @param numIn Number of input vectors
+ * @param pOut Output vectors
+ * @param numOut Number of output vectors
  * @return IOS result code
  */
-s32 IosDevice::IoctlV(s32 id, const TVector<IosVector>& in,
-                      const TVector<IosVector>& out) const {
+s32 IosDevice::IoctlV(s32 id, const IosVector* pIn, u32 numIn,
+                      const IosVector* pOut, u32 numOut) const {
     K_ASSERT_EX(IsOpen(), "Please open this device");
+    K_ASSERT(pIn != nullptr || numIn == 0);
+    K_ASSERT(pOut != nullptr || numOut == 0);
 
-    // Vectors need to be contiguous and usually(?) in MEM2
-    IPCIOVector* vectors =
-        new (32, EMemory_MEM2) IPCIOVector[in.Size() + out.Size()];
-    K_ASSERT(vectors != nullptr);
+    IPCIOVector* vectors = CreateVectors(pIn, numIn, pOut, numOut);
 
-    // Copy in user vectors
-    int i = 0;
-    for (int j = 0; j < in.Size(); j++, i++) {
-        vectors[i].base = in[j].Base();
-        vectors[i].length = in[j].Length();
-    }
-    for (int j = 0; j < out.Size(); j++, i++) {
-        vectors[i].base = out[j].Base();
-        vectors[i].length = out[j].Length();
+    u32 start = OSGetTick();
+    s32 result = IOS_Ioctlv(mHandle, id, numIn, numOut, vectors);
+    RecordIoctl(start);
+
+    IosScratch::Free(vectors);
+    return result;
+}
+
+/**
+ * @brief Perform I/O control (single vectors) on this device asynchronously
+ * @note The request always completes through the IOS dispatcher, even if
+ * IOS rejects it
+ *
+ * @param id Ioctl ID
+ * @param in Input vector
+ * @param out Output vector
+ * @param rRequest Request to complete
+ */
+void IosDevice::IoctlAsync(s32 id, const IosVector& in, IosVector& out,
+                           IosRequest& rRequest) const {
+    K_ASSERT_EX(IsOpen(), "Please open this device");
+
+    IosDispatcher::Submit(rRequest);
+
+    s32 result = IOS_IoctlAsync(mHandle, id, in.Base(), in.Length(),
+                                out.Base(), out.Length(),
+                                IosDispatcher::IpcCallbackFunc, &rRequest);
+
+    // IOS won't call back for rejected requests
+    if (result != IPC_RESULT_OK) {
+        IosDispatcher::Complete(rRequest, result);
     }
+}
+
+/**
+ * @brief Perform I/O control (multiple vectors) on this device
+ * asynchronously
+ * @note The request always completes through the IOS dispatcher, even if
+ * IOS rejects it
+ *
+ * @param id Ioctl ID
+ * @param pIn Input vectors
+ * @param numIn Number of input vectors
+ * @param pOut Output vectors
+ * @param numOut Number of output vectors
+ * @param rRequest Request to complete
+ */
+void IosDevice::IoctlVAsync(s32 id, const IosVector* pIn, u32 numIn,
+                            const IosVector* pOut, u32 numOut,
+                            IosRequest& rRequest) const {
+    K_ASSERT_EX(IsOpen(), "Please open this device");
 
-    s32 result = IOS_Ioctlv(mHandle, id, in.Size(), out.Size(), vectors);
+    IosDispatcher::Submit(rRequest);
 
-    delete[] vectors;
-    return result;
+    // Vector list must live until the request completes
+    rRequest.mpVectors = CreateVectors(pIn, numIn, pOut, numOut);
+
+    s32 result = IOS_IoctlvAsync(mHandle, id, numIn, numOut,
+                                 rRequest.mpVectors,
+                                 IosDispatcher::IpcCallbackFunc, &rRequest);
+
+    // IOS won't call back for rejected requests
+    if (result != IPC_RESULT_OK) {
+        IosDispatcher::Complete(rRequest, result);
+    }
 }
 
 } // namespace kiwi
@@ -5,6 +5,7 @@
 #include <libkiwi/prim/kiwiOptional.h>
 #include <libkiwi/prim/kiwiString.h>
 #include <libkiwi/prim/kiwiVector.h>
+#include <libkiwi/util/kiwiIosDispatcher.h>
 #include <libkiwi/util/kiwiIosObject.h>
 #include <revolution/IPC.h>
 #include <revolution/OS.h>
@@ -17,7 +18,28 @@ namespace kiwi {
  * @brief IOS device handle
  */
 class IosDevice {
+    friend class IosDispatcher;
+
+public:
+    /**
+     * @brief Ioctl statistics
+     */
+    struct Stats {
+        u32 numIoctls;  // Number of completed ioctls
+        u32 maxTicks;   // Longest ioctl latency
+        u64 totalTicks; // Sum of all ioctl latencies
+    };
+
 public:
+    /**
+     * @brief Gets the ioctl statistics (all devices)
+     */
+    static Stats GetStats();
+    /**
+     * @brief Resets the ioctl statistics (all devices)
+     */
+    static void ResetStats();
+
     /**
      * @brief Constructor
      */
@@ -80,11 +102,79 @@ public:
      * @return IOS result code
      */
     s32 IoctlV(s32 id, const TVector<IosVector>& in,
-               const TVector<IosVector>& out) const;
+               const TVector<IosVector>& out) const {
+        return IoctlV(id, in.Data(), in.Size(), out.Data(), out.Size());
+    }
+
+    /**
+     * @brief Perform I/O control (multiple vectors) on this device
+     * @details Use this with fixed-size arrays to avoid heap allocations
+     *
+     * @param id Ioctl ID
+     * @param pIn Input vectors
+     * @param numIn Number of input vectors
+     * @param pOut Output vectors
+     * @param numOut Number of output vectors
+     * @return IOS result code
+     */
+    s32 IoctlV(s32 id, const IosVector* pIn, u32 numIn, const IosVector* pOut,
+               u32 numOut) const;
+
+    /**
+     * @brief Perform I/O control (single vectors) on this device asynchronously
+     * @note The request always completes through the IOS dispatcher, even if
+     * IOS rejects it
+     *
+     * @param id Ioctl ID
+     * @param in Input vector
+     * @param out Output vector
+     * @param rRequest Request to complete
+     */
+    void IoctlAsync(s32 id, const IosVector& in, IosVector& out,
+                    IosRequest& rRequest) const;
+
+    /**
+     * @brief Perform I/O control (multiple vectors) on this device
+     * asynchronously
+     * @note The request always completes through the IOS dispatcher, even if
+     * IOS rejects it
+     *
+     * @param id Ioctl ID
+     * @param pIn Input vectors
+     * @param numIn Number of input vectors
+     * @param pOut Output vectors
+     * @param numOut Number of output vectors
+     * @param rRequest Request to complete
+     */
+    void IoctlVAsync(s32 id, const IosVector* pIn, u32 numIn,
+                     const IosVector* pOut, u32 numOut,
+                     IosRequest& rRequest) const;
+
+private:
+    /**
+     * @brief Records the latency of a completed ioctl
+     *
+     * @param start Tick when the ioctl started
+     */
+    static void RecordIoctl(u32 start);
+
+    /**
+     * @brief Builds a contiguous IOS vector list
+     *
+     * @param pIn Input vectors
+     * @param numIn Number of input vectors
+     * @param pOut Output vectors
+     * @param numOut Number of output vectors
+     * @return Vector list (free with IosScratch::Free)
+     */
+    static IPCIOVector* CreateVectors(const IosVector* pIn, u32 numIn,
+                                      const IosVector* pOut, u32 numOut);
 
 private:
     String mName; // Virtual file path
     s32 mHandle;  // Virtual file descriptor
+
+    static Stats sStats; // Ioctl statistics
 };
 
 //! @}
@@ -0,0 +1,225 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Dispatcher thread
+ */
+OSThread IosDispatcher::sThread;
+
+/**
+ * @brief Thread guard
+ */
+bool IosDispatcher::sThreadCreated = false;
+
+/**
+ * @brief Thread stack
+ */
+u8 IosDispatcher::sThreadStack[scThreadStackSize];
+
+/**
+ * @brief Idle dispatcher thread
+ */
+OSThreadQueue IosDispatcher::sWakeupQueue;
+
+/**
+ * @brief Oldest completed request
+ */
+IosRequest* IosDispatcher::spQueueHead = nullptr;
+
+/**
+ * @brief Newest completed request
+ */
+IosRequest* IosDispatcher::spQueueTail = nullptr;
+
+/**
+ * @brief Dispatcher statistics
+ */
+IosDispatcher::Stats IosDispatcher::sStats;
+
+/**
+ * @brief Gets the dispatcher statistics
+ */
+IosDispatcher::Stats IosDispatcher::GetStats() {
+    AutoInterruptLock lock;
+    return sStats;
+}
+
+/**
+ * @brief Resets the dispatcher statistics
+ * @note Pending count is not reset, as it reflects the current state
+ */
+void IosDispatcher::ResetStats() {
+    AutoInterruptLock lock;
+
+    u32 pending = sStats.numPending;
+    std::memset(&sStats, 0, sizeof(Stats));
+
+    sStats.numPending = pending;
+    sStats.maxPending = pending;
+}
+
+/**
+ * @brief Prepares a request for submission to IOS
+ *
+ * @param rRequest IOS request
+ */
+void IosDispatcher::Submit(IosRequest& rRequest) {
+    K_ASSERT_EX(!rRequest.IsPending(), "Request is already pending");
+
+    AutoInterruptLock lock;
+
+    // Thread must exist before the first completion
+    if (!sThreadCreated) {
+        OSInitThreadQueue(&sWakeupQueue);
+
+        OSCreateThread(&sThread, ThreadFunc, nullptr,
+                       sThreadStack + sizeof(sThreadStack),
+                       sizeof(sThreadStack), scThreadPriority, 0);
+
+        sThreadCreated = true;
+        OSResumeThread(&sThread);
+    }
+
+    rRequest.mIsPending = true;
+    rRequest.mIsPosted = false;
+    rRequest.mResult = IPC_RESULT_OK;
+    rRequest.mStartTick = OSGetTick();
+    rRequest.mpNext = nullptr;
+
+    sStats.numSubmitted++;
+    sStats.numPending++;
+    sStats.maxPending = Max(sStats.maxPending, sStats.numPending);
+}
+
+/**
+ * @brief Queues a request for the dispatcher thread without using IOS
+ * @details Lets interrupt handlers (i.e. alarms) run work on the dispatcher
+ * thread
+ * @note Safe to call from interrupt context, once an IOS request has been
+ * submitted
+ *
+ * @param rRequest Request
+ * @return Success (fails if the request is still pending)
+ */
+bool IosDispatcher::Post(IosRequest& rRequest) {
+    AutoInterruptLock lock;
+
+    // Previous post hasn't been handled yet
+    if (rRequest.IsPending()) {
+        return false;
+    }
+
+    K_ASSERT_EX(sThreadCreated, "Dispatcher thread doesn't exist yet");
+
+    Submit(rRequest);
+    rRequest.mIsPosted = true;
+
+    Complete(rRequest, IPC_RESULT_OK);
+    return true;
+}
+
+/**
+ * @brief Queues a completed request for the dispatcher thread
+ * @note Safe to call from interrupt context
+ *
+ * @param rRequest IOS request
+ * @param result IOS result code
+ */
+void IosDispatcher::Complete(IosRequest& rRequest, s32 result) {
+    AutoInterruptLock lock;
+
+    rRequest.mResult = result;
+
+    // Completions are handled in order
+    if (spQueueTail != nullptr) {
+        spQueueTail->mpNext = &rRequest;
+    } else {
+        spQueueHead = &rRequest;
+    }
+
+    spQueueTail = &rRequest;
+
+    OSWakeupThread(&sWakeupQueue);
+}
+
+/**
+ * @brief IPC completion callback
+ * @note Called from interrupt context
+ *
+ * @param result IOS result code
+ * @param pArg IOS request
+ * @return IOS result code
+ */
+s32 IosDispatcher::IpcCallbackFunc(s32 result, void* pArg) {
+    K_ASSERT(pArg != nullptr);
+
+    Complete(*static_cast<IosRequest*>(pArg), result);
+    return result;
+}
+
+/**
+ * @brief Dispatcher thread function
+ *
+ * @param pArg Thread function argument
+ */
+void* IosDispatcher::ThreadFunc(void* pArg) {
+#pragma unused(pArg)
+
+    while (true) {
+        IosRequest& rRequest = WaitForCompletion();
+
+        // Vector lists come from the scratch pool, which isn't safe to touch
+        // from the IPC callback
+        IosScratch::Free(rRequest.mpVectors);
+        rRequest.mpVectors = nullptr;
+
+        // Posted requests aren't ioctls
+        if (!rRequest.mIsPosted) {
+            IosDevice::RecordIoctl(rRequest.mStartTick);
+        }
+
+        {
+            AutoInterruptLock lock;
+
+            rRequest.mIsPending = false;
+
+            K_ASSERT(sStats.numPending > 0);
+            sStats.numPending--;
+            sStats.numCompleted++;
+        }
+
+        // Request may be deleted by the handler
+        rRequest.OnComplete(rRequest.mResult);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Removes the oldest completed request from the queue
+ * @note Sleeps until a request completes
+ */
+IosRequest& IosDispatcher::WaitForCompletion() {
+    // Interrupts are disabled to avoid missing the wakeup signal
+    AutoInterruptLock lock;
+
+    while (spQueueHead == nullptr) {
+        OSSleepThread(&sWakeupQueue);
+        sStats.numWakeups++;
+    }
+
+    IosRequest* pRequest = spQueueHead;
+    spQueueHead = pRequest->mpNext;
+
+    if (spQueueHead == nullptr) {
+        spQueueTail = nullptr;
+    }
+
+    pRequest->mpNext = nullptr;
+    return *pRequest;
+}
+
+} // namespace kiwi
@@ -0,0 +1,177 @@
+#ifndef LIBKIWI_UTIL_IOS_DISPATCHER_H
+#define LIBKIWI_UTIL_IOS_DISPATCHER_H
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/k_types.h>
+#include <revolution/IPC.h>
+#include <revolution/OS.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_util
+//! @{
+
+/**
+ * @brief Asynchronous IOS request
+ * @details Derived classes own the ioctl buffers, which must stay alive until
+ * the request completes.
+ */
+class IosRequest {
+    friend class IosDevice;
+    friend class IosDispatcher;
+
+public:
+    /**
+     * @brief Constructor
+     */
+    IosRequest()
+        : mIsPending(false),
+          mIsPosted(false),
+          mResult(IPC_RESULT_OK),
+          mStartTick(0),
+          mpVectors(nullptr),
+          mpNext(nullptr) {}
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~IosRequest() {
+        K_ASSERT_EX(!mIsPending, "Don't destroy a pending IOS request");
+    }
+
+    /**
+     * @brief Tests whether the request is still waiting for IOS
+     */
+    bool IsPending() const {
+        return mIsPending;
+    }
+
+    /**
+     * @brief Gets the IOS result code of the completed request
+     */
+    s32 GetResult() const {
+        return mResult;
+    }
+
+protected:
+    /**
+     * @brief Handles request completion
+     * @note Called from the dispatcher thread. The request may delete itself.
+     *
+     * @param result IOS result code
+     */
+    virtual void OnComplete(s32 result) = 0;
+
+private:
+    volatile bool mIsPending; // Whether the request is waiting for IOS
+    bool mIsPosted;           // Whether the request bypassed IOS (see Post)
+    volatile s32 mResult;     // IOS result code
+    u32 mStartTick;           // Tick when the request was submitted
+
+    IPCIOVector* mpVectors; // Ioctlv vector list (owned)
+    IosRequest* mpNext;     // Next request in the completion queue
+};
+
+/**
+ * @brief Completion dispatcher for asynchronous IOS requests
+ * @details IPC callbacks run in interrupt context, where the heap and most
+ * library code can't be used. They only queue the request, and a dedicated
+ * thread runs the completion handlers.
+ */
+class IosDispatcher {
+    friend class IosDevice;
+
+public:
+    /**
+     * @brief Dispatcher statistics
+     */
+    struct Stats {
+        u32 numSubmitted; // Number of submitted requests
+        u32 numCompleted; // Number of completed requests
+        u32 numPending;   // Number of requests waiting for IOS
+        u32 maxPending;   // Largest number of requests waiting for IOS
+        u32 numWakeups;   // Number of times the thread woke up
+    };
+
+public:
+    /**
+     * @brief Gets the dispatcher statistics
+     */
+    static Stats GetStats();
+    /**
+     * @brief Resets the dispatcher statistics
+     * @note Pending count is not reset, as it reflects the current state
+     */
+    static void ResetStats();
+
+    /**
+     * @brief Queues a request for the dispatcher thread without using IOS
+     * @details Lets interrupt handlers (i.e. alarms) run work on the
+     * dispatcher thread
+     * @note Safe to call from interrupt context, once an IOS request has
+     * been submitted
+     *
+     * @param rRequest Request
+     * @return Success (fails if the request is still pending)
+     */
+    static bool Post(IosRequest& rRequest);
+
+private:
+    /**
+     * @brief Prepares a request for submission to IOS
+     *
+     * @param rRequest IOS request
+     */
+    static void Submit(IosRequest& rRequest);
+
+    /**
+     * @brief Queues a completed request for the dispatcher thread
+     * @note Safe to call from interrupt context
+     *
+     * @param rRequest IOS request
+     * @param result IOS result code
+     */
+    static void Complete(IosRequest& rRequest, s32 result);
+
+    /**
+     * @brief IPC completion callback
+     * @note Called from interrupt context
+     *
+     * @param result IOS result code
+     * @param pArg IOS request
+     * @return IOS result code
+     */
+    static s32 IpcCallbackFunc(s32 result, void* pArg);
+
+    /**
+     * @brief Dispatcher thread function
+     *
+     * @param pArg Thread function argument
+     */
+    static void* ThreadFunc(void* pArg);
+
+    /**
+     * @brief Removes the oldest completed request from the queue
+     * @note Sleeps until a request completes
+     */
+    static IosRequest& WaitForCompletion();
+
+private:
+    static const u32 scThreadStackSize = 0x4000;
+    //! Dispatcher thread priority (higher than the game's main thread, so
+    //! completions aren't held back until the main thread sleeps)
+    static const s32 scThreadPriority = 8;
+
+    static OSThread sThread;                   // Dispatcher thread
+    static bool sThreadCreated;                // Thread guard
+    static u8 sThreadStack[scThreadStackSize]; // Thread stack
+
+    static OSThreadQueue sWakeupQueue; // Idle dispatcher thread
+    static IosRequest* spQueueHead;    // Oldest completed request
+    static IosRequest* spQueueTail;    // Newest completed request
+
+    static Stats sStats; // Dispatcher statistics
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
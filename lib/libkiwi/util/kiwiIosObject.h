@@ -4,6 +4,7 @@
 #include <libkiwi/debug/kiwiAssert.h>
 #include <libkiwi/k_types.h>
 #include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/util/kiwiIosScratch.h>
 #include <libkiwi/util/kiwiIosVector.h>
 
 #include <cstring>
@@ -14,28 +15,30 @@ namespace kiwi {
 
 /**
  * @brief Memory buffer for IOS I/O
+ * @details Small buffers are taken from the IOS scratch pool
  */
 template <typename T> class IosBuffer : public IosVector {
 public:
     /**
      * @brief Constructor
      *
-     * @param size Buffer size
+     * @param size Buffer size, in elements
      */
     explicit IosBuffer(u32 size) {
         K_ASSERT(size > 0);
 
-        u8* buffer = new (32, EMemory_MEM2) u8[size * sizeof(T)];
+        void* buffer = IosScratch::Alloc(size * sizeof(T));
         K_ASSERT(buffer != nullptr);
 
-        Set(buffer, size);
+        // IOS expects the length in bytes
+        Set(buffer, size * sizeof(T));
     }
 
     /**
      * @brief Destructor
      */
     virtual ~IosBuffer() {
-        delete static_cast<u8*>(Base());
+        IosScratch::Free(Base());
     }
 
     /**
@@ -172,7 +175,7 @@ public:
      * @brief Convert to String type
      */
     operator StringImpl<T>() const {
-        return StringImpl<T>(this->Ptr(), this->Length());
+        return StringImpl<T>(this->Ptr(), this->Length() / sizeof(T));
     }
 };
 
@@ -0,0 +1,149 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+namespace kiwi {
+
+/**
+ * @brief Pool memory
+ */
+u8* IosScratch::spPoolMemory = nullptr;
+
+/**
+ * @brief Free pool blocks
+ */
+IosScratch::FreeBlock* IosScratch::spFreeList = nullptr;
+
+/**
+ * @brief Pool statistics
+ */
+IosScratch::Stats IosScratch::sStats;
+
+/**
+ * @brief Allocates a scratch buffer
+ *
+ * @param size Buffer size
+ * @return 32-byte aligned MEM2 buffer
+ */
+void* IosScratch::Alloc(u32 size) {
+    if (size <= scBlockSize) {
+        if (spPoolMemory == nullptr) {
+            CreatePool();
+        }
+
+        AutoInterruptLock lock;
+
+        // Take the first free block
+        if (spFreeList != nullptr) {
+            FreeBlock* pBlock = spFreeList;
+            spFreeList = pBlock->pNext;
+
+            sStats.numPooled++;
+            sStats.numInUse++;
+            sStats.maxInUse = Max(sStats.maxInUse, sStats.numInUse);
+
+            return pBlock;
+        }
+    }
+
+    u8* pBuffer = new (32, EMemory_MEM2) u8[size];
+    K_ASSERT(pBuffer != nullptr);
+
+    {
+        AutoInterruptLock lock;
+        sStats.numHeap++;
+    }
+
+    return pBuffer;
+}
+
+/**
+ * @brief Frees a scratch buffer
+ *
+ * @param pBlock Buffer from Alloc
+ */
+void IosScratch::Free(void* pBlock) {
+    if (pBlock == nullptr) {
+        return;
+    }
+
+    if (!IsPoolBlock(pBlock)) {
+        delete[] static_cast<u8*>(pBlock);
+        return;
+    }
+
+    AutoInterruptLock lock;
+
+    FreeBlock* pFree = static_cast<FreeBlock*>(pBlock);
+    pFree->pNext = spFreeList;
+    spFreeList = pFree;
+
+    K_ASSERT(sStats.numInUse > 0);
+    sStats.numInUse--;
+}
+
+/**
+ * @brief Gets the pool statistics
+ */
+IosScratch::Stats IosScratch::GetStats() {
+    AutoInterruptLock lock;
+    return sStats;
+}
+
+/**
+ * @brief Resets the pool statistics
+ * @note Usage is not reset, as it reflects the current state
+ */
+void IosScratch::ResetStats() {
+    AutoInterruptLock lock;
+
+    u32 inUse = sStats.numInUse;
+    std::memset(&sStats, 0, sizeof(Stats));
+
+    sStats.numInUse = inUse;
+    sStats.maxInUse = inUse;
+}
+
+/**
+ * @brief Allocates the pool memory
+ */
+void IosScratch::CreatePool() {
+    // Heap may block, so allocate before taking the lock
+    u8* pMemory = new (32, EMemory_MEM2) u8[scBlockSize * scNumBlocks];
+    K_ASSERT(pMemory != nullptr);
+
+    AutoInterruptLock lock;
+
+    // Another thread created the pool first
+    if (spPoolMemory != nullptr) {
+        delete[] pMemory;
+        return;
+    }
+
+    spPoolMemory = pMemory;
+
+    // Thread all blocks into the free list
+    for (u32 i = 0; i < scNumBlocks; i++) {
+        FreeBlock* pBlock =
+            reinterpret_cast<FreeBlock*>(spPoolMemory + i * scBlockSize);
+
+        pBlock->pNext = spFreeList;
+        spFreeList = pBlock;
+    }
+}
+
+/**
+ * @brief Tests whether a buffer belongs to the pool
+ *
+ * @param pBlock Buffer
+ */
+bool IosScratch::IsPoolBlock(const void* pBlock) {
+    if (spPoolMemory == nullptr) {
+        return false;
+    }
+
+    return pBlock >= spPoolMemory &&
+           pBlock < spPoolMemory + scBlockSize * scNumBlocks;
+}
+
+} // namespace kiwi
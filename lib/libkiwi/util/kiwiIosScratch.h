@@ -0,0 +1,89 @@
+#ifndef LIBKIWI_UTIL_IOS_SCRATCH_H
+#define LIBKIWI_UTIL_IOS_SCRATCH_H
+#include <libkiwi/k_types.h>
+
+namespace kiwi {
+//! @addtogroup libkiwi_util
+//! @{
+
+/**
+ * @brief Pool of MEM2 scratch blocks for IOS I/O
+ * @details IPC arguments are small and short-lived, so they are served from
+ * a fixed set of preallocated blocks instead of the heap. Requests which are
+ * too large (or arrive while the pool is exhausted) fall back to the heap.
+ * @note Safe to use from any thread
+ */
+class IosScratch {
+public:
+    /**
+     * @brief Pool statistics
+     */
+    struct Stats {
+        u32 numPooled; // Allocations served by the pool (heap avoided)
+        u32 numHeap;   // Allocations which fell back to the heap
+        u32 numInUse;  // Number of pool blocks in use
+        u32 maxInUse;  // Largest number of pool blocks in use
+    };
+
+    //! Size of each pool block
+    static const u32 scBlockSize = 256;
+    //! Number of pool blocks
+    static const u32 scNumBlocks = 32;
+
+public:
+    /**
+     * @brief Allocates a scratch buffer
+     *
+     * @param size Buffer size
+     * @return 32-byte aligned MEM2 buffer
+     */
+    static void* Alloc(u32 size);
+
+    /**
+     * @brief Frees a scratch buffer
+     *
+     * @param pBlock Buffer from Alloc
+     */
+    static void Free(void* pBlock);
+
+    /**
+     * @brief Gets the pool statistics
+     */
+    static Stats GetStats();
+    /**
+     * @brief Resets the pool statistics
+     * @note Usage is not reset, as it reflects the current state
+     */
+    static void ResetStats();
+
+private:
+    /**
+     * @brief Free pool block
+     */
+    struct FreeBlock {
+        FreeBlock* pNext; // Next free block
+    };
+
+private:
+    /**
+     * @brief Allocates the pool memory
+     */
+    static void CreatePool();
+
+    /**
+     * @brief Tests whether a buffer belongs to the pool
+     *
+     * @param pBlock Buffer
+     */
+    static bool IsPoolBlock(const void* pBlock);
+
+private:
+    static u8* spPoolMemory;      // Pool memory
+    static FreeBlock* spFreeList; // Free pool blocks
+    static Stats sStats;          // Pool statistics
+};
+
+//! @}
+} // namespace kiwi
+
+#endif
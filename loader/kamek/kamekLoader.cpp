@@ -20,9 +20,13 @@ struct KBHeader {
     u32 codeSize;
     u32 ctorStart;
     u32 ctorEnd;
-    u32 _pad[2];
+    u32 flags; // Version 3+
+    u32 _pad;
 };
 
+// Relocations are grouped by command and sorted by address
+#define kFlagGroupedRelocs (1 << 0)
+
 #define kAddr32 1
 #define kAddr16Lo 4
 #define kAddr16Hi 5
@@ -63,7 +67,7 @@ static inline u32 resolveAddress(u32 text, u32 address) {
     static inline const u8* kHandle##name(const u8* input, u32 text,           \
                                           u32 address)
 #define kDispatchCommand(name)                                                 \
-    case k##name: input = kHandle##name(input, text, address); break
+    case k##name: return kHandle##name(input, text, address)
 
 kCommandHandler(Addr32) {
     u32 target = resolveAddress(text, *(const u32*)input);
@@ -146,6 +150,30 @@ kCommandHandler(BranchLink) {
     return kHandleRel24(input, text, address);
 }
 
+static const u8* applyCommand(u8 cmd, const u8* input, u32 text,
+                              u32 address) {
+    switch (cmd) {
+        kDispatchCommand(Addr32);
+        kDispatchCommand(Addr16Lo);
+        kDispatchCommand(Addr16Hi);
+        kDispatchCommand(Addr16Ha);
+        kDispatchCommand(Rel24);
+        kDispatchCommand(Write32);
+        kDispatchCommand(Write16);
+        kDispatchCommand(Write8);
+        kDispatchCommand(CondWritePointer);
+        kDispatchCommand(CondWrite32);
+        kDispatchCommand(CondWrite16);
+        kDispatchCommand(CondWrite8);
+        kDispatchCommand(Branch);
+        kDispatchCommand(BranchLink);
+    default:
+        OSReport("Unknown command: %d\n", cmd);
+        return input;
+    }
+}
+
+#ifdef __MWERKS__
 inline void cacheInvalidateAddress(u32 address) {
     register u32 addressRegister = address;
     asm {
@@ -154,9 +182,172 @@ inline void cacheInvalidateAddress(u32 address) {
 		icbi 0, addressRegister
     }
 }
+#else
+// Host builds (tools/hosttest) record flushes in a simulated memory image
+void cacheInvalidateAddress(u32 address);
+#endif
+
+#define kCacheLineSize 32
+
+static inline u32 ticksToUsec(u32 ticks) {
+    return (u32)OS_TICKS_TO_USEC((u64)ticks);
+}
+
+struct LineFlusher {
+    LineFlusher(u32 text, u32 textSize)
+        : text(text), textSize(textSize), pendingLine(0), isPending(false) {}
+
+    void flush(u32 address) {
+        // Module memory is flushed all at once afterwards
+        if (address - text < textSize)
+            return;
+
+        // Patches are sorted, so repeated lines are adjacent. A line is only
+        // flushed once every patch to it has been written.
+        u32 line = address & ~(kCacheLineSize - 1);
+        if (isPending && line == pendingLine)
+            return;
+
+        finish();
+        pendingLine = line;
+        isPending = true;
+    }
+
+    void finish() {
+        if (isPending) {
+            cacheInvalidateAddress(pendingLine);
+            isPending = false;
+        }
+    }
+
+    u32 text;
+    u32 textSize;
+    u32 pendingLine;
+    bool isPending;
+};
+
+static void applyBranches(const u8* input, u32 count, u32 text, u32 opcode,
+                          LineFlusher& flusher) {
+    for (; count > 0; count--, input += 8) {
+        u32 address = resolveAddress(text, ((const u32*)input)[0]);
+        u32 target = resolveAddress(text, ((const u32*)input)[1]);
+
+        *(u32*)address = opcode | ((target - address) & 0x3FFFFFC);
+        flusher.flush(address);
+    }
+}
+
+static const u8* applyGroupedRelocs(const u8* input, const u8* inputEnd,
+                                    u32 text, u32 textSize) {
+    LineFlusher flusher(text, textSize);
+
+    while (input < inputEnd) {
+        u32 groupHeader = *((const u32*)input);
+        input += 4;
+
+        u8 cmd = groupHeader >> 24;
+        u32 count = groupHeader & 0xFFFFFF;
+
+        // Hot commands get their own loops. Entries are (address, argument)
+        // pairs, where addresses follow the same rules as arguments.
+        switch (cmd) {
+        case kAddr32:
+            for (u32 i = 0; i < count; i++, input += 8) {
+                u32 address = resolveAddress(text, ((const u32*)input)[0]);
+                *(u32*)address = resolveAddress(text, ((const u32*)input)[1]);
+                flusher.flush(address);
+            }
+            break;
+
+        case kRel24:
+            for (u32 i = 0; i < count; i++, input += 8) {
+                u32 address = resolveAddress(text, ((const u32*)input)[0]);
+                u32 target = resolveAddress(text, ((const u32*)input)[1]);
+
+                *(u32*)address &= 0xFC000003;
+                *(u32*)address |= ((target - address) & 0x3FFFFFC);
+                flusher.flush(address);
+            }
+            break;
+
+        case kBranch:
+            applyBranches(input, count, text, 0x48000000, flusher);
+            input += count * 8;
+            break;
+
+        case kBranchLink:
+            applyBranches(input, count, text, 0x48000001, flusher);
+            input += count * 8;
+            break;
+
+        default:
+            for (u32 i = 0; i < count; i++) {
+                u32 address = resolveAddress(text, *((const u32*)input));
+                input = applyCommand(cmd, input + 4, text, address);
+                flusher.flush(address);
+            }
+            break;
+        }
+    }
+
+    // Last patched line is still pending
+    flusher.finish();
+    return input;
+}
+
+static void copyBlocks(u8* dst, const u8* src, u32 size) {
+    // Word moves need both buffers to be word-aligned
+    if ((((u32)dst | (u32)src) & 3) == 0) {
+        // Copy cache line-sized blocks
+        for (; size >= kCacheLineSize; size -= kCacheLineSize) {
+            const u32* from = (const u32*)src;
+            u32* to = (u32*)dst;
+
+            u32 w0 = from[0], w1 = from[1], w2 = from[2], w3 = from[3];
+            u32 w4 = from[4], w5 = from[5], w6 = from[6], w7 = from[7];
+            to[0] = w0, to[1] = w1, to[2] = w2, to[3] = w3;
+            to[4] = w4, to[5] = w5, to[6] = w6, to[7] = w7;
+
+            src += kCacheLineSize;
+            dst += kCacheLineSize;
+        }
+
+        for (; size >= 4; size -= 4) {
+            *(u32*)dst = *(const u32*)src;
+            src += 4;
+            dst += 4;
+        }
+    }
+
+    while (size-- > 0) {
+        *(dst++) = *(src++);
+    }
+}
+
+static void zeroBlocks(u8* dst, u32 size) {
+    // Clear up to the first cache line boundary
+    while (((u32)dst & (kCacheLineSize - 1)) != 0 && size > 0) {
+        *(dst++) = 0;
+        size--;
+    }
+
+    // Zero whole cache lines without reading memory (dcbz)
+    u32 blockSize = size & ~(kCacheLineSize - 1);
+    if (blockSize > 0) {
+        DCZeroRange(dst, blockSize);
+        dst += blockSize;
+        size -= blockSize;
+    }
+
+    while (size-- > 0) {
+        *(dst++) = 0;
+    }
+}
 
 void loadKamekBinary(const loaderFunctions* funcs, const void* binary,
                      u32 binaryLength) {
+    u32 startTick = OSGetTick();
+
     kokeshi::CURRENT_MODULE.start = const_cast<void*>(binary);
     kokeshi::CURRENT_MODULE.size = binaryLength;
 
@@ -164,7 +355,7 @@ void loadKamekBinary(const loaderFunctions* funcs, const void* binary,
     if (header->magic1 != 'Kame' || header->magic2 != 'k\0')
         kamekError("FATAL ERROR: Corrupted file, please check your game's "
                    "Kamek files");
-    if (header->version != 2) {
+    if (header->version != 2 && header->version != 3) {
         kamekError("FATAL ERROR: Incompatible file (version %d), please "
                    "upgrade your Kamek Loader",
                    header->version);
@@ -201,14 +392,19 @@ void loadKamekBinary(const loaderFunctions* funcs, const void* binary,
     const u8* inputEnd = ((const u8*)binary) + binaryLength;
     u8* output = (u8*)text;
 
+    u32 copyTick = OSGetTick();
+
     // Create text + bss sections
-    for (u32 i = 0; i < header->codeSize; i++) {
-        *output = *(input++);
-        cacheInvalidateAddress((u32)(output++));
-    }
-    for (u32 i = 0; i < header->bssSize; i++) {
-        *output = 0;
-        cacheInvalidateAddress((u32)(output++));
+    copyBlocks(output, input, header->codeSize);
+    input += header->codeSize;
+    output += header->codeSize;
+
+    zeroBlocks(output, header->bssSize);
+
+    u32 sectionTick = OSGetTick();
+
+    if (header->version >= 3 && (header->flags & kFlagGroupedRelocs)) {
+        input = applyGroupedRelocs(input, inputEnd, text, textSize);
     }
 
     while (input < inputEnd) {
@@ -226,30 +422,31 @@ void loadKamekBinary(const loaderFunctions* funcs, const void* binary,
             address += text;
         }
 
-        switch (cmd) {
-            kDispatchCommand(Addr32);
-            kDispatchCommand(Addr16Lo);
-            kDispatchCommand(Addr16Hi);
-            kDispatchCommand(Addr16Ha);
-            kDispatchCommand(Rel24);
-            kDispatchCommand(Write32);
-            kDispatchCommand(Write16);
-            kDispatchCommand(Write8);
-            kDispatchCommand(CondWritePointer);
-            kDispatchCommand(CondWrite32);
-            kDispatchCommand(CondWrite16);
-            kDispatchCommand(CondWrite8);
-            kDispatchCommand(Branch);
-            kDispatchCommand(BranchLink);
-        default: OSReport("Unknown command: %d\n", cmd);
-        }
+        input = applyCommand(cmd, input, text, address);
 
-        cacheInvalidateAddress(address);
+        // Module memory is flushed all at once afterwards
+        if (address - text >= textSize)
+            cacheInvalidateAddress(address);
     }
 
+    u32 relocTick = OSGetTick();
+
+    // Write back the module and discard stale instructions
+    DCFlushRange((void*)text, textSize);
+    ICInvalidateRange((void*)text, textSize);
+
     __sync();
     __isync();
 
+    u32 endTick = OSGetTick();
+
+    OSReport("Kamek load time: %lu us (sections %lu us, relocations %lu us, "
+             "cache %lu us)\n",
+             ticksToUsec(endTick - startTick),
+             ticksToUsec(sectionTick - copyTick),
+             ticksToUsec(relocTick - sectionTick),
+             ticksToUsec(endTick - relocTick));
+
     typedef void (*Func)(void);
     for (Func* f = (Func*)(text + header->ctorStart);
          f < (Func*)(text + header->ctorEnd); f++) {
@@ -56,6 +56,8 @@ ModuleInfo CURRENT_MODULE : 0x80003200;
 static const char* BINARY_PATH = KOKESHI_MODULE_PATH ".bin";
 //! Path to the module's mapfile
 static const char* MAPFILE_PATH = KOKESHI_MODULE_PATH ".map";
+//! Path to the module's precompiled (binary) mapfile
+static const char* BINARY_MAPFILE_PATH = KOKESHI_MODULE_PATH ".kmap";
 
 /**
  * @brief Allocates memory
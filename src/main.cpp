@@ -8,12 +8,16 @@
  * Mod entrypoint
  */
 void KokeshiMain() {
+    // Create shared worker threads for background tasks
+    kiwi::ThreadPool::CreateDefault();
+
 #ifndef NDEBUG
     // Setup libkiwi debugging utilities
     kiwi::Nw4rException::CreateInstance();
     kiwi::MapFile::CreateInstance();
-    kiwi::MapFile::GetInstance().Open(kokeshi::MAPFILE_PATH,
-                                      kiwi::MapFile::ELinkType_Relocatable);
+    // Symbols load in the background, so they don't delay booting
+    kiwi::MapFile::GetInstance().OpenAsync(
+        kokeshi::BINARY_MAPFILE_PATH, kiwi::MapFile::ELinkType_Relocatable);
 #endif
 
     // Initialize network socket system
@@ -12,6 +12,9 @@ from subprocess import run, PIPE
 from hashlib import sha1
 from threading import Thread
 
+from make_binary_map import write_binary as write_binary_map
+from sort_kamek_relocs import sort_relocs
+
 #
 # Configuration
 #
@@ -481,6 +484,18 @@ def build_module(args) -> bool:
         print("[FATAL] Error while linking your module.")
         return False
 
+    # Group relocations so the loader can apply them in batches
+    if not sort_relocs(f"{BUILD_DIR}/{MODULES_DIR}/m_{args.game}.bin",
+                       f"{BUILD_DIR}/{MODULES_DIR}/m_{args.game}.bin"):
+        print("[FATAL] Error while sorting module relocations.")
+        return False
+
+    # Precompile the mapfile so the game doesn't have to parse it
+    if not write_binary_map(f"{BUILD_DIR}/{MODULES_DIR}/m_{args.game}.map",
+                            f"{BUILD_DIR}/{MODULES_DIR}/m_{args.game}.kmap"):
+        print("[FATAL] Error while creating binary mapfile.")
+        return False
+
     return True
 
 
@@ -0,0 +1,40 @@
+#include <libkiwi/debug/kiwiAssert.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * @brief Logs a message to the console
+ *
+ * @param pMsg Message
+ * @param ... Format string arguments
+ */
+void kiwi_log(const char* pMsg, ...) {
+    std::va_list list;
+
+    va_start(list, pMsg);
+    std::vfprintf(stderr, pMsg, list);
+    va_end(list);
+}
+
+/**
+ * @brief Halts the program and displays an error message to the console
+ *
+ * @param pFile Source file name where assertion failed
+ * @param line Source file line where assertion failed
+ * @param pMsg Assertion message
+ * @param ... Format string arguments
+ */
+void kiwi_fail_assert(const char* pFile, int line, const char* pMsg, ...) {
+    std::va_list list;
+
+    std::fprintf(stderr, "%s:%d: assertion failed: ", pFile, line);
+
+    va_start(list, pMsg);
+    std::vfprintf(stderr, pMsg, list);
+    va_end(list);
+
+    std::fputc('\n', stderr);
+    std::abort();
+}
@@ -0,0 +1,55 @@
+#include <libkiwi.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+/**
+ * Nw4rConsole for host tests. Text goes to stdout instead of the screen.
+ */
+
+namespace kiwi {
+
+// K_DYNAMIC_SINGLETON_IMPL, with the syntax that GCC requires
+template <> Nw4rConsole* DynamicSingleton<Nw4rConsole>::sInstance = nullptr;
+template <> OSMutex DynamicSingleton<Nw4rConsole>::sMutex = {};
+
+/**
+ * @brief Constructor
+ */
+Nw4rConsole::Nw4rConsole() : mpTextBuffer(nullptr), mIsVisible(false) {}
+
+/**
+ * @brief Destructor
+ */
+Nw4rConsole::~Nw4rConsole() {}
+
+/**
+ * @brief Prints text to console
+ *
+ * @param pMsg Format string
+ * @param ... Format args
+ */
+void Nw4rConsole::Printf(const char* pMsg, ...) {
+    std::va_list list;
+
+    va_start(list, pMsg);
+    VPrintf(pMsg, list);
+    va_end(list);
+}
+
+/**
+ * @brief Prints text to console
+ *
+ * @param pMsg Format string
+ * @param args Format args
+ */
+void Nw4rConsole::VPrintf(const char* pMsg, std::va_list args) {
+    std::vprintf(pMsg, args);
+}
+
+/**
+ * @brief Draws console using DirectPrint
+ */
+void Nw4rConsole::DrawDirect() const {}
+
+} // namespace kiwi
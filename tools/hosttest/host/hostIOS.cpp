@@ -0,0 +1,348 @@
+#include "hostIOS.h"
+
+#include <pthread.h>
+
+#include <revolution/OS.h>
+
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * The IOS client API, over fake devices which run on the host.
+ *
+ * Asynchronous requests run on a pool of worker threads, which grows so that
+ * every queued request has a thread (requests may block for a long time, like
+ * a receive or a poll, and IOS doesn't hold up the others meanwhile). The
+ * completion callback runs with interrupts disabled, like the IPC interrupt
+ * handler.
+ *
+ * Fake IOS memory comes from malloc, so it doesn't show up in the host heap
+ * statistics (host/hostMemoryMgr.cpp).
+ */
+
+namespace host {
+namespace {
+
+/**
+ * @brief Registered device
+ */
+struct DeviceEntry {
+    const char* pPath;   // Device path
+    FakeDevice* pDevice; // Device
+};
+
+/**
+ * @brief Asynchronous request
+ */
+struct Request {
+    s32 fd;             // Device handle
+    s32 type;           // Ioctl ID
+    bool isVector;      // Whether this is an ioctlv
+    void* pIn;          // Input buffer (ioctl)
+    s32 inSize;         // Input buffer size (ioctl)
+    void* pOut;         // Output buffer (ioctl)
+    s32 outSize;        // Output buffer size (ioctl)
+    s32 inCount;        // Number of input vectors (ioctlv)
+    s32 outCount;       // Number of output vectors (ioctlv)
+    IPCIOVector* pVecs; // Vectors (ioctlv)
+
+    IPCAsyncCallback callback; // Completion callback
+    void* pCallbackArg;        // Callback user argument
+
+    Request* pNext; // Next queued request
+};
+
+const u32 scMaxDevices = 16;
+const u32 scMaxHandles = 32;
+
+//! Guards everything below
+pthread_mutex_t sMutex = PTHREAD_MUTEX_INITIALIZER;
+//! Signalled when a request is queued
+pthread_cond_t sQueueCond = PTHREAD_COND_INITIALIZER;
+
+DeviceEntry sDevices[scMaxDevices]; // Registered devices
+u32 sNumDevices = 0;                // Number of registered devices
+FakeDevice* sHandles[scMaxHandles]; // Open devices
+
+Request* spQueueHead = nullptr; // Oldest queued request
+Request* spQueueTail = nullptr; // Newest queued request
+u32 sNumQueued = 0;             // Number of queued requests
+u32 sNumIdle = 0;               // Number of idle worker threads
+u32 sNumInFlight = 0;           // Number of unfinished requests
+
+IosStats sStats; // Fake IOS statistics
+
+/**
+ * @brief Gets the device behind a handle
+ *
+ * @param fd Device handle
+ * @return Device, or null if the handle isn't open
+ */
+FakeDevice* GetDevice(s32 fd) {
+    if (fd < 0 || fd >= static_cast<s32>(scMaxHandles)) {
+        return nullptr;
+    }
+
+    pthread_mutex_lock(&sMutex);
+    FakeDevice* pDevice = sHandles[fd];
+    pthread_mutex_unlock(&sMutex);
+
+    return pDevice;
+}
+
+/**
+ * @brief Runs a request on its device
+ *
+ * @param rRequest Request
+ * @return IOS result code
+ */
+s32 Execute(const Request& rRequest) {
+    FakeDevice* pDevice = GetDevice(rRequest.fd);
+    if (pDevice == nullptr) {
+        return IPC_RESULT_INVALID;
+    }
+
+    if (rRequest.isVector) {
+        return pDevice->Ioctlv(rRequest.type, rRequest.inCount,
+                               rRequest.outCount, rRequest.pVecs);
+    }
+
+    return pDevice->Ioctl(rRequest.type, rRequest.pIn, rRequest.inSize,
+                          rRequest.pOut, rRequest.outSize);
+}
+
+/**
+ * @brief Worker thread function
+ *
+ * @param pArg Thread function argument
+ */
+void* WorkerThreadFunc(void* pArg) {
+    while (true) {
+        pthread_mutex_lock(&sMutex);
+
+        while (spQueueHead == nullptr) {
+            sNumIdle++;
+            pthread_cond_wait(&sQueueCond, &sMutex);
+            sNumIdle--;
+        }
+
+        Request* pRequest = spQueueHead;
+        spQueueHead = pRequest->pNext;
+        if (spQueueHead == nullptr) {
+            spQueueTail = nullptr;
+        }
+
+        sNumQueued--;
+        pthread_mutex_unlock(&sMutex);
+
+        s32 result = Execute(*pRequest);
+
+        // IPC callbacks run in interrupt context
+        BOOL enabled = OSDisableInterrupts();
+        pRequest->callback(result, pRequest->pCallbackArg);
+        OSRestoreInterrupts(enabled);
+
+        std::free(pRequest);
+
+        pthread_mutex_lock(&sMutex);
+        sNumInFlight--;
+        pthread_mutex_unlock(&sMutex);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Queues an asynchronous request
+ *
+ * @param rRequest Request (copied)
+ * @return IOS result code
+ */
+s32 Submit(const Request& rRequest) {
+    if (GetDevice(rRequest.fd) == nullptr) {
+        return IPC_RESULT_INVALID;
+    }
+
+    Request* pRequest = static_cast<Request*>(std::malloc(sizeof(Request)));
+    *pRequest = rRequest;
+    pRequest->pNext = nullptr;
+
+    pthread_mutex_lock(&sMutex);
+
+    if (spQueueTail != nullptr) {
+        spQueueTail->pNext = pRequest;
+    } else {
+        spQueueHead = pRequest;
+    }
+
+    spQueueTail = pRequest;
+    sNumQueued++;
+
+    sNumInFlight++;
+    sStats.numAsync++;
+    if (sNumInFlight > sStats.maxInFlight) {
+        sStats.maxInFlight = sNumInFlight;
+    }
+
+    // Every queued request needs a thread, in case the others block
+    if (sNumQueued > sNumIdle) {
+        pthread_t handle;
+        pthread_create(&handle, nullptr, WorkerThreadFunc, nullptr);
+        pthread_detach(handle);
+
+        sStats.numWorkers++;
+    } else {
+        pthread_cond_signal(&sQueueCond);
+    }
+
+    pthread_mutex_unlock(&sMutex);
+    return IPC_RESULT_OK;
+}
+
+/**
+ * @brief Runs a synchronous request
+ *
+ * @param rRequest Request
+ * @return IOS result code
+ */
+s32 Run(const Request& rRequest) {
+    __atomic_add_fetch(&sStats.numSync, 1, __ATOMIC_RELAXED);
+    return Execute(rRequest);
+}
+
+} // namespace
+
+/**
+ * @brief Makes a fake device available to IOS_Open
+ *
+ * @param pPath Device path
+ * @param pDevice Device (must outlive the program)
+ */
+void RegisterDevice(const char* pPath, FakeDevice* pDevice) {
+    pthread_mutex_lock(&sMutex);
+
+    if (sNumDevices < scMaxDevices) {
+        sDevices[sNumDevices].pPath = pPath;
+        sDevices[sNumDevices].pDevice = pDevice;
+        sNumDevices++;
+    }
+
+    pthread_mutex_unlock(&sMutex);
+}
+
+/**
+ * @brief Gets the fake IOS statistics
+ */
+IosStats GetIosStats() {
+    pthread_mutex_lock(&sMutex);
+    IosStats stats = sStats;
+    stats.numSync = __atomic_load_n(&sStats.numSync, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&sMutex);
+
+    return stats;
+}
+
+} // namespace host
+
+extern "C" {
+
+s32 IOS_Open(const char* path, IPCOpenMode mode) {
+    pthread_mutex_lock(&host::sMutex);
+
+    host::FakeDevice* pDevice = nullptr;
+    for (u32 i = 0; i < host::sNumDevices; i++) {
+        if (std::strcmp(host::sDevices[i].pPath, path) == 0) {
+            pDevice = host::sDevices[i].pDevice;
+            break;
+        }
+    }
+
+    s32 result = IPC_RESULT_NOEXISTS;
+
+    if (pDevice != nullptr) {
+        result = IPC_RESULT_MAXFD;
+
+        for (u32 i = 0; i < host::scMaxHandles; i++) {
+            if (host::sHandles[i] == nullptr) {
+                host::sHandles[i] = pDevice;
+                result = i;
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&host::sMutex);
+    return result;
+}
+
+s32 IOS_Close(s32 fd) {
+    if (host::GetDevice(fd) == nullptr) {
+        return IPC_RESULT_INVALID;
+    }
+
+    pthread_mutex_lock(&host::sMutex);
+    host::sHandles[fd] = nullptr;
+    pthread_mutex_unlock(&host::sMutex);
+
+    return IPC_RESULT_OK;
+}
+
+s32 IOS_Ioctl(s32 fd, s32 type, void* in, s32 inSize, void* out,
+              s32 outSize) {
+    host::Request request = {};
+    request.fd = fd;
+    request.type = type;
+    request.pIn = in;
+    request.inSize = inSize;
+    request.pOut = out;
+    request.outSize = outSize;
+
+    return host::Run(request);
+}
+
+s32 IOS_IoctlAsync(s32 fd, s32 type, void* in, s32 inSize, void* out,
+                   s32 outSize, IPCAsyncCallback callback,
+                   void* callbackArg) {
+    host::Request request = {};
+    request.fd = fd;
+    request.type = type;
+    request.pIn = in;
+    request.inSize = inSize;
+    request.pOut = out;
+    request.outSize = outSize;
+    request.callback = callback;
+    request.pCallbackArg = callbackArg;
+
+    return host::Submit(request);
+}
+
+s32 IOS_Ioctlv(s32 fd, s32 type, s32 inCount, s32 outCount,
+               IPCIOVector* vectors) {
+    host::Request request = {};
+    request.fd = fd;
+    request.type = type;
+    request.isVector = true;
+    request.inCount = inCount;
+    request.outCount = outCount;
+    request.pVecs = vectors;
+
+    return host::Run(request);
+}
+
+s32 IOS_IoctlvAsync(s32 fd, s32 type, s32 inCount, s32 outCount,
+                    IPCIOVector* vectors, IPCAsyncCallback callback,
+                    void* callbackArg) {
+    host::Request request = {};
+    request.fd = fd;
+    request.type = type;
+    request.isVector = true;
+    request.inCount = inCount;
+    request.outCount = outCount;
+    request.pVecs = vectors;
+    request.callback = callback;
+    request.pCallbackArg = callbackArg;
+
+    return host::Submit(request);
+}
+
+} // extern "C"
@@ -0,0 +1,84 @@
+#ifndef HOSTTEST_HOST_IOS_H
+#define HOSTTEST_HOST_IOS_H
+#include <libkiwi/k_types.h>
+
+#include <revolution/IPC.h>
+
+namespace host {
+
+/**
+ * @brief Fake IOS device, which handles the requests that the IOS client API
+ * (host/hostIOS.cpp) sends to its path
+ * @details Requests may block, and asynchronous requests run on worker
+ * threads, so devices must be thread safe.
+ */
+class FakeDevice {
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~FakeDevice() {}
+
+    /**
+     * @brief Handles I/O control (single vectors)
+     *
+     * @param type Ioctl ID
+     * @param pIn Input buffer
+     * @param inSize Input buffer size
+     * @param pOut Output buffer
+     * @param outSize Output buffer size
+     * @return IOS result code
+     */
+    virtual s32 Ioctl(s32 type, void* pIn, s32 inSize, void* pOut,
+                      s32 outSize) {
+        return IPC_RESULT_INVALID;
+    }
+
+    /**
+     * @brief Handles I/O control (multiple vectors)
+     *
+     * @param type Ioctl ID
+     * @param inCount Number of input vectors
+     * @param outCount Number of output vectors
+     * @param pVectors Input vectors, then output vectors
+     * @return IOS result code
+     */
+    virtual s32 Ioctlv(s32 type, s32 inCount, s32 outCount,
+                       IPCIOVector* pVectors) {
+        return IPC_RESULT_INVALID;
+    }
+};
+
+/**
+ * @brief Makes a fake device available to IOS_Open
+ *
+ * @param pPath Device path
+ * @param pDevice Device (must outlive the program)
+ */
+void RegisterDevice(const char* pPath, FakeDevice* pDevice);
+
+/**
+ * @brief Registers the fake network devices (see hostNet.cpp)
+ * @details /dev/net/ip/top is backed by the host's sockets, and the console
+ * is always online, at 127.0.0.1.
+ */
+void RegisterNetDevices();
+
+/**
+ * @brief Fake IOS statistics
+ */
+struct IosStats {
+    u64 numSync;     // Number of synchronous requests
+    u64 numAsync;    // Number of asynchronous requests
+    u32 numWorkers;  // Number of worker threads created
+    u32 maxInFlight; // Largest number of asynchronous requests in flight
+};
+
+/**
+ * @brief Gets the fake IOS statistics
+ */
+IosStats GetIosStats();
+
+} // namespace host
+
+#endif
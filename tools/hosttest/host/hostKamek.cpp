@@ -0,0 +1,225 @@
+#include "hostKamek.h"
+
+#include <kamekLoader.hpp>
+#include <kokeshi.hpp>
+#include <revolution/OS.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+
+/**
+ * The loader runs against a simulated MEM1, which is mapped at its console
+ * address. The instruction cache is modelled as a shadow copy of the image,
+ * which only sees the contents of a cache line once it has been flushed.
+ */
+
+namespace kamek {
+
+// Not part of the loader's header (only loadKamekBinaryFromDisc is)
+void loadKamekBinary(const loaderFunctions* funcs, const void* binary,
+                     u32 binaryLength);
+
+/**
+ * @brief Writes back and invalidates one cache line
+ *
+ * @param address Address inside the line
+ */
+void cacheInvalidateAddress(u32 address);
+
+} // namespace kamek
+
+namespace kokeshi {
+
+ModuleInfo CURRENT_MODULE;
+
+} // namespace kokeshi
+
+namespace host {
+namespace {
+
+const u32 scCacheLineSize = 32;
+
+u8* spImage = nullptr;   // Simulated MEM1
+u8* spShadow = nullptr;  // Contents visible to instruction fetch
+u32 sNumLineFlushes = 0; // Game code lines flushed since the reset
+
+/**
+ * @brief Gets the image offset of an address
+ *
+ * @param address Address
+ * @param size Access size
+ */
+u32 GetOffset(u32 address, u32 size) {
+    if (address < KAMEK_IMAGE_BASE ||
+        address - KAMEK_IMAGE_BASE + size > KAMEK_IMAGE_SIZE) {
+        std::fprintf(stderr, "Address outside the image: %08X\n", address);
+        std::abort();
+    }
+
+    return address - KAMEK_IMAGE_BASE;
+}
+
+/**
+ * @brief Makes memory visible to instruction fetch
+ *
+ * @param address Start address
+ * @param size Range size
+ */
+void Invalidate(u32 address, u32 size) {
+    u32 offset = GetOffset(address, size);
+    std::memcpy(spShadow + offset, spImage + offset, size);
+}
+
+/**
+ * @brief Allocates memory for the loader
+ *
+ * @param size Block size
+ * @param isForCode Whether the block holds the module
+ */
+void* Alloc(u32 size, bool isForCode) {
+    // The loader only allocates the module itself
+    if (!isForCode ||
+        size > KAMEK_IMAGE_BASE + KAMEK_IMAGE_SIZE - KAMEK_TEXT_BASE) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<void*>(KAMEK_TEXT_BASE);
+}
+
+/**
+ * @brief Frees memory for the loader
+ *
+ * @param pBlock Block
+ * @param isForCode Whether the block holds the module
+ */
+void Free(void* pBlock, bool isForCode) {}
+
+} // namespace
+
+/**
+ * @brief Maps the simulated memory image
+ *
+ * @return Success
+ */
+bool MapKamekImage() {
+    if (spImage != nullptr) {
+        return true;
+    }
+
+    void* pImage = mmap(reinterpret_cast<void*>(KAMEK_IMAGE_BASE),
+                        KAMEK_IMAGE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1,
+                        0);
+
+    if (pImage != reinterpret_cast<void*>(KAMEK_IMAGE_BASE)) {
+        std::fprintf(stderr, "Can't map the image at %08X\n",
+                     KAMEK_IMAGE_BASE);
+        return false;
+    }
+
+    spImage = static_cast<u8*>(pImage);
+    spShadow = static_cast<u8*>(std::malloc(KAMEK_IMAGE_SIZE));
+    return spShadow != nullptr;
+}
+
+/**
+ * @brief Fills the game code with its initial contents, and forgets about
+ * any cache maintenance
+ */
+void ResetKamekImage() {
+    u32* pWords = reinterpret_cast<u32*>(spImage);
+
+    for (u32 i = 0; i < KAMEK_IMAGE_SIZE / sizeof(u32); i++) {
+        pWords[i] = GetKamekInitialWord(KAMEK_IMAGE_BASE + i * sizeof(u32));
+    }
+
+    std::memcpy(spShadow, spImage, KAMEK_IMAGE_SIZE);
+    sNumLineFlushes = 0;
+}
+
+/**
+ * @brief Loads a Kamek binary into the image
+ *
+ * @param pBinary Kamek binary
+ * @param size Binary size
+ */
+void LoadKamekBinary(const void* pBinary, u32 size) {
+    static const kamek::loaderFunctions funcs = {Alloc, Free};
+    kamek::loadKamekBinary(&funcs, pBinary, size);
+}
+
+/**
+ * @brief Gets the image contents
+ */
+const u8* GetKamekImage() {
+    return spImage;
+}
+
+/**
+ * @brief Gets the number of game code cache lines flushed since the image
+ * was reset
+ */
+u32 GetKamekNumLineFlushes() {
+    return sNumLineFlushes;
+}
+
+/**
+ * @brief Counts the cache lines whose latest contents were never flushed
+ */
+u32 GetKamekNumStaleLines() {
+    u32 num = 0;
+
+    for (u32 i = 0; i < KAMEK_IMAGE_SIZE; i += scCacheLineSize) {
+        if (std::memcmp(spImage + i, spShadow + i, scCacheLineSize) != 0) {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+} // namespace host
+
+/**
+ * @brief Writes back and invalidates one cache line
+ *
+ * @param address Address inside the line
+ */
+void kamek::cacheInvalidateAddress(u32 address) {
+    host::Invalidate(address & ~(host::scCacheLineSize - 1),
+                     host::scCacheLineSize);
+    host::sNumLineFlushes++;
+}
+
+/**
+ * The loader's console output isn't interesting on the host
+ */
+void OSReport(const char* msg, ...) {}
+
+void OSFatal(GXColor textColor, GXColor bgColor, const char* msg) {
+    std::fprintf(stderr, "OSFatal: %s\n", msg);
+    std::abort();
+}
+
+u32 OSGetTick() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    u64 nsec = static_cast<u64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    return static_cast<u32>(nsec * (OS_TIME_SPEED / 1000000) / 1000);
+}
+
+void DCFlushRange(void* buf, u32 len) {}
+
+void DCZeroRange(void* buf, u32 len) {
+    std::memset(buf, 0, len);
+}
+
+void ICInvalidateRange(void* buf, u32 len) {
+    host::Invalidate(static_cast<u32>(reinterpret_cast<std::uintptr_t>(buf)),
+                     len);
+}
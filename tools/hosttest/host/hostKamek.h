@@ -0,0 +1,73 @@
+#ifndef HOSTTEST_HOST_KAMEK_H
+#define HOSTTEST_HOST_KAMEK_H
+#include <cstdint>
+
+/**
+ * Simulated memory for the Kamek loader (see hostKamek.cpp).
+ *
+ * The loader and the tests disagree on the width of u32 (see
+ * shim/loader/kamekTypes.hpp), so this interface only uses fixed-width types.
+ */
+
+namespace host {
+
+//! Simulated MEM1 (game code and data)
+static const std::uint32_t KAMEK_IMAGE_BASE = 0x80000000;
+static const std::uint32_t KAMEK_IMAGE_SIZE = 0x01800000;
+
+//! Where the module is allocated (the last 8MB of the image)
+static const std::uint32_t KAMEK_TEXT_BASE = 0x81000000;
+
+/**
+ * @brief Maps the simulated memory image
+ * @note The image has to live at its console address, as the loader stores
+ * addresses in 32-bit words
+ *
+ * @return Success
+ */
+bool MapKamekImage();
+
+/**
+ * @brief Fills the game code with its initial contents, and forgets about
+ * any cache maintenance
+ */
+void ResetKamekImage();
+
+/**
+ * @brief Gets the initial contents of a word of game code
+ *
+ * @param address Word address
+ */
+inline std::uint32_t GetKamekInitialWord(std::uint32_t address) {
+    return 0x60000000 | (address & 0xFFFF); // ori r0, r0, x
+}
+
+/**
+ * @brief Loads a Kamek binary into the image
+ * @note Words must already be in host byte order
+ *
+ * @param pBinary Kamek binary
+ * @param size Binary size
+ */
+void LoadKamekBinary(const void* pBinary, std::uint32_t size);
+
+/**
+ * @brief Gets the image contents
+ */
+const std::uint8_t* GetKamekImage();
+
+/**
+ * @brief Gets the number of game code cache lines flushed since the image
+ * was reset
+ */
+std::uint32_t GetKamekNumLineFlushes();
+
+/**
+ * @brief Counts the cache lines whose latest contents were never flushed
+ * (the instruction cache would still hold stale code)
+ */
+std::uint32_t GetKamekNumStaleLines();
+
+} // namespace host
+
+#endif
@@ -0,0 +1,109 @@
+#include "hostTest.h"
+
+#include <libkiwi/core/kiwiMemoryMgr.h>
+
+#include <cstdlib>
+
+/**
+ * Replaces MemoryMgr's operator new/delete with the host heap, and counts
+ * allocations so tests can measure heap churn. Memory regions and tags are
+ * ignored.
+ */
+
+namespace host {
+namespace {
+
+volatile u64 sNumAllocs = 0; // Number of allocations
+volatile u64 sNumBytes = 0;  // Bytes ever allocated
+
+/**
+ * @brief Allocates a block of memory from the host heap
+ *
+ * @param size Block size
+ * @param align Block alignment
+ */
+void* Alloc(size_t size, s32 align) {
+    // Same alignment as the game heaps at minimum
+    size_t alignment = align > 0 ? align : -align;
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+
+    void* pBlock = nullptr;
+    if (posix_memalign(&pBlock, alignment, size > 0 ? size : 1) != 0) {
+        return nullptr;
+    }
+
+    __atomic_add_fetch(&sNumAllocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sNumBytes, size, __ATOMIC_RELAXED);
+    return pBlock;
+}
+
+} // namespace
+
+/**
+ * @brief Gets the host heap statistics
+ */
+AllocStats GetAllocStats() {
+    AllocStats stats;
+    stats.numAllocs = __atomic_load_n(&sNumAllocs, __ATOMIC_RELAXED);
+    stats.numBytes = __atomic_load_n(&sNumBytes, __ATOMIC_RELAXED);
+    return stats;
+}
+
+} // namespace host
+
+void* operator new(size_t size) {
+    return host::Alloc(size, 4);
+}
+void* operator new[](size_t size) {
+    return host::Alloc(size, 4);
+}
+
+void* operator new(size_t size, s32 align) {
+    return host::Alloc(size, align);
+}
+void* operator new[](size_t size, s32 align) {
+    return host::Alloc(size, align);
+}
+
+void* operator new(size_t size, kiwi::EMemory memory) {
+    return host::Alloc(size, 4);
+}
+void* operator new[](size_t size, kiwi::EMemory memory) {
+    return host::Alloc(size, 4);
+}
+
+void* operator new(size_t size, s32 align, kiwi::EMemory memory) {
+    return host::Alloc(size, align);
+}
+void* operator new[](size_t size, s32 align, kiwi::EMemory memory) {
+    return host::Alloc(size, align);
+}
+
+void* operator new(size_t size, kiwi::EAllocTag tag) {
+    return host::Alloc(size, 4);
+}
+void* operator new[](size_t size, kiwi::EAllocTag tag) {
+    return host::Alloc(size, 4);
+}
+
+void* operator new(size_t size, s32 align, kiwi::EAllocTag tag) {
+    return host::Alloc(size, align);
+}
+void* operator new[](size_t size, s32 align, kiwi::EAllocTag tag) {
+    return host::Alloc(size, align);
+}
+
+void operator delete(void* pBlock) {
+    std::free(pBlock);
+}
+void operator delete[](void* pBlock) {
+    std::free(pBlock);
+}
+void operator delete(void* pBlock, size_t size) {
+    std::free(pBlock);
+}
+void operator delete[](void* pBlock, size_t size) {
+    std::free(pBlock);
+}
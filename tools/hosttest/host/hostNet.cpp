@@ -0,0 +1,578 @@
+#include "hostIOS.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <revolution/SO.h>
+
+#include <climits>
+#include <cstring>
+
+/**
+ * Fake network devices. /dev/net/ip/top runs socket requests on the host's
+ * own sockets (IPv4 only), and the network configuration devices report that
+ * the console is online.
+ *
+ * The SO structures have the host's type widths, like in libkiwi's host
+ * build, so they are filled in field by field. Ports in the SO structures are
+ * numbers, and addresses are bytes in network order (which is how the
+ * big-endian console sees them).
+ */
+
+namespace host {
+namespace {
+
+/**
+ * @brief IOS I/O control codes (see kiwiLibSO.cpp)
+ */
+enum {
+    // dev/net/ip/top
+    Ioctl_SOAccept = 1,
+    Ioctl_SOBind = 2,
+    Ioctl_SOClose = 3,
+    Ioctl_SOConnect = 4,
+    Ioctl_SOFcntl = 5,
+    Ioctl_SOGetPeerName = 6,
+    Ioctl_SOGetSocketName = 7,
+    Ioctl_SOSetSockOpt = 9,
+    Ioctl_SOListen = 10,
+    Ioctl_SOPoll = 11,
+    Ioctl_SORecvFrom = 12,
+    Ioctl_SOSendTo = 13,
+    Ioctl_SOShutdown = 14,
+    Ioctl_SOCreate = 15,
+    Ioctl_SOGetHostID = 16,
+    Ioctl_SOINetAtoN = 21,
+    Ioctl_SOGetAddrInfo = 24,
+    Ioctl_SOStartup = 31,
+
+    // dev/net/ncd/manage
+    IoctlV_NCDGetLinkStatus = 7,
+
+    // dev/net/kd/request
+    Ioctl_NWC24iStartupSocket = 6,
+};
+
+/**
+ * @name Ioctl arguments (see kiwiLibSO.cpp)
+ */
+/**@{*/
+struct SOSocketArgs {
+    s32 family;
+    s32 type;
+    s32 protocol;
+};
+struct SOListenArgs {
+    s32 fd;
+    s32 backlog;
+};
+struct SOBindArgs {
+    s32 fd;
+    BOOL hasDest;
+    SOSockAddr dest;
+};
+struct SORecvArgs {
+    s32 fd;
+    u32 flags;
+};
+struct SOSendArgs {
+    s32 fd;
+    u32 flags;
+    BOOL hasDest;
+    SOSockAddr dest;
+};
+struct SOFcntlArgs {
+    s32 fd;
+    s32 cmd;
+    void* arg;
+};
+struct SOShutdownArgs {
+    s32 fd;
+    s32 type;
+};
+struct SOSetSockOptArgs {
+    s32 fd;
+    s32 level;
+    s32 opt;
+    const void* val;
+    u32 len;
+};
+struct SOGetAddrInfoResult {
+    SOAddrInfo info[35];
+    SOSockAddr addr[35];
+};
+/**@}*/
+
+/**
+ * @brief Converts the last host socket error to an SO result
+ */
+s32 GetError() {
+    switch (errno) {
+    case EAGAIN:      return SO_EWOULDBLOCK;
+    case EALREADY:    return SO_EALREADY;
+    case EINPROGRESS: return SO_EINPROGRESS;
+    case EISCONN:     return SO_EISCONN;
+    case ENOTCONN:    return SO_ENOTCONN;
+    case EMSGSIZE:    return SO_EMSGSIZE;
+    case ENOBUFS:     return SO_ENOBUFS;
+    case ENOMEM:      return SO_ENOMEM;
+    case ETIMEDOUT:   return SO_ETIMEDOUT;
+
+    case EHOSTUNREACH:
+    case ENETUNREACH:
+        return SO_EHOSTUNREACH;
+
+    // SO has no code for a refused connection
+    case ECONNREFUSED:
+    case ECONNRESET:
+    case ECONNABORTED:
+    case EPIPE:
+        return SO_ECONNRESET;
+
+    default:
+        return SO_EINVAL;
+    }
+}
+
+/**
+ * @brief Returns a host socket call's result as an SO result
+ *
+ * @param result Host result
+ */
+s32 ToResult(ssize_t result) {
+    return result >= 0 ? static_cast<s32>(result) : GetError();
+}
+
+/**
+ * @brief Converts an SO address to a host address
+ *
+ * @param rAddr SO address
+ * @param[out] rHost Host address
+ * @return Success
+ */
+bool ToHostAddr(const SOSockAddr& rAddr, sockaddr_in& rHost) {
+    if (rAddr.family != SO_AF_INET) {
+        return false;
+    }
+
+    std::memset(&rHost, 0, sizeof(sockaddr_in));
+    rHost.sin_family = AF_INET;
+    rHost.sin_port = htons(rAddr.port);
+    std::memcpy(&rHost.sin_addr.s_addr, rAddr.in.addr.octets, 4);
+
+    return true;
+}
+
+/**
+ * @brief Converts a host address to an SO address
+ *
+ * @param rHost Host address
+ * @param[out] rAddr SO address
+ */
+void FromHostAddr(const sockaddr_in& rHost, SOSockAddr& rAddr) {
+    std::memset(&rAddr, 0, sizeof(SOSockAddrIn));
+    rAddr.len = sizeof(SOSockAddrIn);
+    rAddr.family = SO_AF_INET;
+    rAddr.port = ntohs(rHost.sin_port);
+    std::memcpy(rAddr.in.addr.octets, &rHost.sin_addr.s_addr, 4);
+}
+
+/**
+ * @brief Converts SO message flags to host message flags
+ *
+ * @param flags SO flags
+ */
+int ToHostMsgFlags(u32 flags) {
+    int hostFlags = MSG_NOSIGNAL;
+
+    if (flags & SO_MSG_OOB) {
+        hostFlags |= MSG_OOB;
+    }
+    if (flags & SO_MSG_PEEK) {
+        hostFlags |= MSG_PEEK;
+    }
+    if (flags & SO_MSG_WAITALL) {
+        hostFlags |= MSG_WAITALL;
+    }
+
+    return hostFlags;
+}
+
+/**
+ * @brief /dev/net/ncd/manage
+ */
+class NcdDevice : public FakeDevice {
+public:
+    virtual s32 Ioctlv(s32 type, s32 inCount, s32 outCount,
+                       IPCIOVector* pVectors) {
+        if (type != IoctlV_NCDGetLinkStatus || outCount < 1) {
+            return IPC_RESULT_INVALID;
+        }
+
+        // Link is up
+        IPCIOVector& rStatus = pVectors[inCount];
+        std::memset(rStatus.base, 0, rStatus.length);
+        return IPC_RESULT_OK;
+    }
+};
+
+/**
+ * @brief /dev/net/kd/request
+ */
+class KdDevice : public FakeDevice {
+public:
+    virtual s32 Ioctl(s32 type, void* pIn, s32 inSize, void* pOut,
+                      s32 outSize) {
+        if (type != Ioctl_NWC24iStartupSocket) {
+            return IPC_RESULT_INVALID;
+        }
+
+        // Startup succeeded
+        std::memset(pOut, 0, outSize);
+        return IPC_RESULT_OK;
+    }
+};
+
+/**
+ * @brief /dev/net/ip/top
+ */
+class IpTopDevice : public FakeDevice {
+public:
+    virtual s32 Ioctl(s32 type, void* pIn, s32 inSize, void* pOut,
+                      s32 outSize) {
+        switch (type) {
+        case Ioctl_SOStartup:       return IPC_RESULT_OK;
+        case Ioctl_SOGetHostID:     return GetHostID();
+        case Ioctl_SOCreate:        return Create(pIn);
+        case Ioctl_SOClose:         return Close(pIn);
+        case Ioctl_SOListen:        return Listen(pIn);
+        case Ioctl_SOAccept:        return Accept(pIn, pOut, outSize);
+        case Ioctl_SOBind:          return Bind(pIn);
+        case Ioctl_SOConnect:       return Connect(pIn);
+        case Ioctl_SOGetSocketName: return GetName(pIn, pOut, false);
+        case Ioctl_SOGetPeerName:   return GetName(pIn, pOut, true);
+        case Ioctl_SOFcntl:         return Fcntl(pIn);
+        case Ioctl_SOSetSockOpt:    return SetSockOpt(pIn);
+        case Ioctl_SOShutdown:      return Shutdown(pIn);
+        case Ioctl_SOPoll:          return Poll(pIn, pOut, outSize);
+        case Ioctl_SOINetAtoN:      return INetAtoN(pIn, pOut);
+        default:                    return IPC_RESULT_INVALID;
+        }
+    }
+
+    virtual s32 Ioctlv(s32 type, s32 inCount, s32 outCount,
+                       IPCIOVector* pVectors) {
+        switch (type) {
+        case Ioctl_SORecvFrom:    return RecvFrom(pVectors);
+        case Ioctl_SOSendTo:      return SendTo(pVectors);
+        case Ioctl_SOGetAddrInfo: return GetAddrInfo(pVectors);
+        default:                  return IPC_RESULT_INVALID;
+        }
+    }
+
+private:
+    s32 GetHostID() {
+        // Bit pattern of the address, as the console would load it
+        return static_cast<s32>(htonl(INADDR_LOOPBACK));
+    }
+
+    s32 Create(void* pIn) {
+        const SOSocketArgs& rArgs = *static_cast<SOSocketArgs*>(pIn);
+
+        if (rArgs.family != SO_PF_INET) {
+            return SO_EINVAL;
+        }
+
+        int type = rArgs.type == SO_SOCK_STREAM ? SOCK_STREAM : SOCK_DGRAM;
+        return ToResult(socket(AF_INET, type, 0));
+    }
+
+    s32 Close(void* pIn) {
+        int fd = *static_cast<s32*>(pIn);
+
+        // Closing aborts pending operations (on Linux, only shutdown does)
+        shutdown(fd, SHUT_RDWR);
+        return ToResult(close(fd));
+    }
+
+    s32 Listen(void* pIn) {
+        const SOListenArgs& rArgs = *static_cast<SOListenArgs*>(pIn);
+        return ToResult(listen(rArgs.fd, rArgs.backlog));
+    }
+
+    s32 Accept(void* pIn, void* pOut, s32 outSize) {
+        int fd = *static_cast<s32*>(pIn);
+
+        sockaddr_in peer;
+        socklen_t len = sizeof(sockaddr_in);
+
+        int result = accept(fd, reinterpret_cast<sockaddr*>(&peer), &len);
+        if (result >= 0 && outSize >= static_cast<s32>(sizeof(SOSockAddrIn))) {
+            FromHostAddr(peer, *static_cast<SOSockAddr*>(pOut));
+        }
+
+        return ToResult(result);
+    }
+
+    s32 Bind(void* pIn) {
+        const SOBindArgs& rArgs = *static_cast<SOBindArgs*>(pIn);
+
+        sockaddr_in addr;
+        if (!ToHostAddr(rArgs.dest, addr)) {
+            return SO_EINVAL;
+        }
+
+        return ToResult(bind(rArgs.fd, reinterpret_cast<sockaddr*>(&addr),
+                             sizeof(sockaddr_in)));
+    }
+
+    s32 Connect(void* pIn) {
+        // Same layout as bind
+        const SOBindArgs& rArgs = *static_cast<SOBindArgs*>(pIn);
+
+        sockaddr_in addr;
+        if (!ToHostAddr(rArgs.dest, addr)) {
+            return SO_EINVAL;
+        }
+
+        return ToResult(connect(rArgs.fd, reinterpret_cast<sockaddr*>(&addr),
+                                sizeof(sockaddr_in)));
+    }
+
+    s32 GetName(void* pIn, void* pOut, bool peer) {
+        int fd = *static_cast<s32*>(pIn);
+
+        sockaddr_in addr;
+        socklen_t len = sizeof(sockaddr_in);
+
+        int result =
+            peer ? getpeername(fd, reinterpret_cast<sockaddr*>(&addr), &len)
+                 : getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+
+        if (result >= 0) {
+            FromHostAddr(addr, *static_cast<SOSockAddr*>(pOut));
+        }
+
+        return ToResult(result);
+    }
+
+    s32 Fcntl(void* pIn) {
+        const SOFcntlArgs& rArgs = *static_cast<SOFcntlArgs*>(pIn);
+
+        int flags = fcntl(rArgs.fd, F_GETFL);
+        if (flags < 0) {
+            return GetError();
+        }
+
+        switch (rArgs.cmd) {
+        case SO_F_GETFL: {
+            return (flags & O_NONBLOCK) ? SO_O_NONBLOCK : 0;
+        }
+
+        case SO_F_SETFL: {
+            // Argument is passed by value
+            u32 value = static_cast<u32>(reinterpret_cast<uintptr_t>(rArgs.arg));
+
+            if (value & SO_O_NONBLOCK) {
+                flags |= O_NONBLOCK;
+            } else {
+                flags &= ~O_NONBLOCK;
+            }
+
+            return ToResult(fcntl(rArgs.fd, F_SETFL, flags));
+        }
+
+        default: {
+            return SO_EINVAL;
+        }
+        }
+    }
+
+    s32 SetSockOpt(void* pIn) {
+        const SOSetSockOptArgs& rArgs = *static_cast<SOSetSockOptArgs*>(pIn);
+
+        if (rArgs.level != SO_SOL_SOCKET) {
+            return SO_EINVAL;
+        }
+
+        int opt;
+        switch (rArgs.opt) {
+        case SO_SO_REUSEADDR: opt = SO_REUSEADDR; break;
+        case SO_SO_SNDBUF:    opt = SO_SNDBUF;    break;
+        case SO_SO_RCVBUF:    opt = SO_RCVBUF;    break;
+        default:              return SO_EINVAL;
+        }
+
+        // Values are s32, which isn't the host's int
+        int value = static_cast<int>(*static_cast<const s32*>(rArgs.val));
+        return ToResult(setsockopt(rArgs.fd, SOL_SOCKET, opt, &value,
+                                   sizeof(int)));
+    }
+
+    s32 Shutdown(void* pIn) {
+        const SOShutdownArgs& rArgs = *static_cast<SOShutdownArgs*>(pIn);
+
+        // Same values as SO_SHUT_*
+        return ToResult(shutdown(rArgs.fd, rArgs.type));
+    }
+
+    s32 Poll(void* pIn, void* pOut, s32 outSize) {
+        s64 msec = *static_cast<s64*>(pIn);
+
+        SOPollFD* pFDs = static_cast<SOPollFD*>(pOut);
+        u32 numfds = outSize / sizeof(SOPollFD);
+
+        pollfd hostFDs[64];
+        if (numfds > LENGTHOF(hostFDs)) {
+            return SO_EINVAL;
+        }
+
+        for (u32 i = 0; i < numfds; i++) {
+            hostFDs[i].fd = pFDs[i].fd;
+            hostFDs[i].events = 0;
+            hostFDs[i].revents = 0;
+
+            if (pFDs[i].events & SO_POLLRDNORM) {
+                hostFDs[i].events |= POLLIN;
+            }
+            if (pFDs[i].events & SO_POLLWRNORM) {
+                hostFDs[i].events |= POLLOUT;
+            }
+        }
+
+        int timeout = msec < 0 ? -1 : msec > INT_MAX ? INT_MAX : msec;
+        int result = poll(hostFDs, numfds, timeout);
+
+        for (u32 i = 0; i < numfds && result >= 0; i++) {
+            pFDs[i].revents = 0;
+
+            if (hostFDs[i].revents & POLLIN) {
+                pFDs[i].revents |= SO_POLLRDNORM;
+            }
+            if (hostFDs[i].revents & POLLOUT) {
+                pFDs[i].revents |= SO_POLLWRNORM;
+            }
+            if (hostFDs[i].revents & (POLLERR | POLLNVAL)) {
+                pFDs[i].revents |= SO_POLLERR;
+            }
+            if (hostFDs[i].revents & POLLHUP) {
+                pFDs[i].revents |= SO_POLLHUP;
+            }
+        }
+
+        return ToResult(result);
+    }
+
+    s32 INetAtoN(void* pIn, void* pOut) {
+        in_addr addr;
+        if (inet_aton(static_cast<const char*>(pIn), &addr) == 0) {
+            return 0;
+        }
+
+        SOInAddr& rOut = *static_cast<SOInAddr*>(pOut);
+        rOut.raw = 0;
+        std::memcpy(rOut.octets, &addr.s_addr, 4);
+        return 1;
+    }
+
+    s32 RecvFrom(IPCIOVector* pVectors) {
+        const SORecvArgs& rArgs = *static_cast<SORecvArgs*>(pVectors[0].base);
+        IPCIOVector& rData = pVectors[1];
+        IPCIOVector& rFrom = pVectors[2];
+
+        sockaddr_in from;
+        socklen_t len = sizeof(sockaddr_in);
+
+        ssize_t result =
+            recvfrom(rArgs.fd, rData.base, rData.length,
+                     ToHostMsgFlags(rArgs.flags),
+                     reinterpret_cast<sockaddr*>(&from), &len);
+
+        if (result >= 0 && rFrom.length >= sizeof(SOSockAddrIn) &&
+            len == sizeof(sockaddr_in)) {
+            FromHostAddr(from, *static_cast<SOSockAddr*>(rFrom.base));
+        }
+
+        return ToResult(result);
+    }
+
+    s32 SendTo(IPCIOVector* pVectors) {
+        IPCIOVector& rData = pVectors[0];
+        const SOSendArgs& rArgs = *static_cast<SOSendArgs*>(pVectors[1].base);
+
+        sockaddr_in to;
+        if (rArgs.hasDest && !ToHostAddr(rArgs.dest, to)) {
+            return SO_EINVAL;
+        }
+
+        return ToResult(sendto(rArgs.fd, rData.base, rData.length,
+                               ToHostMsgFlags(rArgs.flags),
+                               rArgs.hasDest ? reinterpret_cast<sockaddr*>(&to)
+                                             : nullptr,
+                               rArgs.hasDest ? sizeof(sockaddr_in) : 0));
+    }
+
+    s32 GetAddrInfo(IPCIOVector* pVectors) {
+        const char* pName = static_cast<const char*>(pVectors[0].base);
+        const char* pService = static_cast<const char*>(pVectors[1].base);
+        const SOAddrInfo& rHints = *static_cast<SOAddrInfo*>(pVectors[2].base);
+        SOGetAddrInfoResult& rResult =
+            *static_cast<SOGetAddrInfoResult*>(pVectors[3].base);
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(addrinfo));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype =
+            rHints.type == SO_SOCK_DGRAM ? SOCK_DGRAM : SOCK_STREAM;
+
+        addrinfo* pList = nullptr;
+        if (getaddrinfo(pName, *pService != '\0' ? pService : nullptr, &hints,
+                        &pList) != 0) {
+            return SO_EHOSTUNREACH;
+        }
+
+        std::memset(&rResult, 0, sizeof(SOGetAddrInfoResult));
+
+        u32 i = 0;
+        for (addrinfo* it = pList; it != nullptr && i < LENGTHOF(rResult.info);
+             it = it->ai_next, i++) {
+
+            rResult.info[i].family = SO_AF_INET;
+            rResult.info[i].type = it->ai_socktype == SOCK_DGRAM
+                                       ? SO_SOCK_DGRAM
+                                       : SO_SOCK_STREAM;
+            rResult.info[i].len = sizeof(SOSockAddrIn);
+
+            FromHostAddr(*reinterpret_cast<sockaddr_in*>(it->ai_addr),
+                         rResult.addr[i]);
+        }
+
+        freeaddrinfo(pList);
+        return SO_SUCCESS;
+    }
+};
+
+NcdDevice sNcdDevice;     // /dev/net/ncd/manage
+KdDevice sKdDevice;       // /dev/net/kd/request
+IpTopDevice sIpTopDevice; // /dev/net/ip/top
+
+} // namespace
+
+/**
+ * @brief Registers the fake network devices
+ * @details /dev/net/ip/top is backed by the host's sockets, and the console
+ * is always online, at 127.0.0.1.
+ */
+void RegisterNetDevices() {
+    RegisterDevice("/dev/net/ncd/manage", &sNcdDevice);
+    RegisterDevice("/dev/net/kd/request", &sKdDevice);
+    RegisterDevice("/dev/net/ip/top", &sIpTopDevice);
+}
+
+} // namespace host
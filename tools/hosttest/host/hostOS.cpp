@@ -0,0 +1,585 @@
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <revolution/OS.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * The parts of the OS library which libkiwi's threading and IOS code uses,
+ * on top of pthreads.
+ *
+ * The console has one core, and disabling interrupts stops every other thread
+ * (and every interrupt handler) from running. Here that is one global lock,
+ * which alarm handlers and IPC callbacks (host/hostIOS.cpp) also hold while
+ * they run. Thread queues and mutexes are built on that lock like the real
+ * OS builds them, so code that gets the wakeup protocol wrong breaks here
+ * too. Thread priorities are ignored.
+ */
+
+namespace {
+
+//! Interrupt lock (held by the thread which disabled interrupts)
+pthread_mutex_t sIntrMutex = PTHREAD_MUTEX_INITIALIZER;
+//! Signalled whenever a thread queue is woken up or an alarm is set
+pthread_cond_t sIntrCond;
+
+//! Whether this thread has interrupts disabled
+__thread bool sIntrDisabled = false;
+
+//! OSThread for threads which weren't created by OSCreateThread
+__thread OSThread sHostThread;
+//! Current thread
+__thread OSThread* spCurrentThread = nullptr;
+
+//! Host time when the time base started
+u64 sTimeBase = 0;
+
+/**
+ * @brief Host state for threads created by OSCreateThread
+ * @details Kept in the thread's context, which is unused on the host
+ */
+struct HostThread {
+    pthread_t handle;  // Host thread
+    bool isStarted;    // Whether the host thread was created
+    OSThreadFunc func; // Thread function
+    void* pArg;        // Thread function argument
+    void* pResult;     // Thread function result
+};
+
+static_assert(sizeof(HostThread) <= sizeof(OSContext), "Context too small");
+
+/**
+ * @brief Alarm queue (sorted by fire time)
+ */
+OSAlarmQueue sAlarmQueue = {nullptr, nullptr};
+//! Alarm thread guard
+pthread_once_t sAlarmOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Gets the current monotonic time, in nanoseconds
+ */
+u64 GetHostTime() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Sets up the time base and the wakeup condition
+ * @details Runs before any static constructor, which may already use them
+ */
+__attribute__((constructor(101))) void Initialize() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&sIntrCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    sTimeBase = GetHostTime();
+}
+
+/**
+ * @brief Gets the host state of a thread
+ *
+ * @param pThread OS thread
+ */
+HostThread& GetHostThread(OSThread* pThread) {
+    void* pContext = &pThread->context;
+    return *static_cast<HostThread*>(pContext);
+}
+
+/**
+ * @brief Converts a time base value to a host deadline
+ *
+ * @param time Time base value
+ */
+timespec GetDeadline(s64 time) {
+    u64 ns = sTimeBase + static_cast<u64>(OS_TICKS_TO_NSEC(time));
+
+    timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    return ts;
+}
+
+/**
+ * @brief Adds an alarm to the queue
+ * @note Interrupts must be disabled
+ *
+ * @param pAlarm Alarm
+ */
+void InsertAlarm(OSAlarm* pAlarm) {
+    OSAlarm* pNext = sAlarmQueue.head;
+    while (pNext != nullptr && pNext->end <= pAlarm->end) {
+        pNext = pNext->next;
+    }
+
+    pAlarm->next = pNext;
+    pAlarm->prev = pNext != nullptr ? pNext->prev : sAlarmQueue.tail;
+
+    if (pAlarm->prev != nullptr) {
+        pAlarm->prev->next = pAlarm;
+    } else {
+        sAlarmQueue.head = pAlarm;
+    }
+
+    if (pNext != nullptr) {
+        pNext->prev = pAlarm;
+    } else {
+        sAlarmQueue.tail = pAlarm;
+    }
+}
+
+/**
+ * @brief Removes an alarm from the queue
+ * @note Interrupts must be disabled
+ *
+ * @param pAlarm Alarm
+ */
+void RemoveAlarm(OSAlarm* pAlarm) {
+    if (pAlarm->prev != nullptr) {
+        pAlarm->prev->next = pAlarm->next;
+    } else {
+        sAlarmQueue.head = pAlarm->next;
+    }
+
+    if (pAlarm->next != nullptr) {
+        pAlarm->next->prev = pAlarm->prev;
+    } else {
+        sAlarmQueue.tail = pAlarm->prev;
+    }
+
+    pAlarm->prev = pAlarm->next = nullptr;
+}
+
+/**
+ * @brief Alarm thread function
+ * @details Alarm handlers run with interrupts disabled, like on the console
+ *
+ * @param pArg Thread function argument
+ */
+void* AlarmThreadFunc(void* pArg) {
+    OSDisableInterrupts();
+
+    while (true) {
+        OSAlarm* pAlarm = sAlarmQueue.head;
+
+        if (pAlarm == nullptr) {
+            pthread_cond_wait(&sIntrCond, &sIntrMutex);
+            continue;
+        }
+
+        if (OSGetTime() < pAlarm->end) {
+            timespec deadline = GetDeadline(pAlarm->end);
+            pthread_cond_timedwait(&sIntrCond, &sIntrMutex, &deadline);
+            continue;
+        }
+
+        OSAlarmHandler handler = pAlarm->handler;
+        RemoveAlarm(pAlarm);
+
+        if (pAlarm->period > 0) {
+            pAlarm->end += pAlarm->period;
+            InsertAlarm(pAlarm);
+        } else {
+            pAlarm->handler = nullptr;
+        }
+
+        if (handler != nullptr) {
+            handler(pAlarm, nullptr);
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Creates the alarm thread
+ */
+void CreateAlarmThread() {
+    pthread_t handle;
+    pthread_create(&handle, nullptr, AlarmThreadFunc, nullptr);
+    pthread_detach(handle);
+}
+
+/**
+ * @brief Thread entrypoint for threads created by OSCreateThread
+ *
+ * @param pArg OS thread
+ */
+void* ThreadEntry(void* pArg) {
+    OSThread* pThread = static_cast<OSThread*>(pArg);
+    HostThread& rHost = GetHostThread(pThread);
+
+    spCurrentThread = pThread;
+    pThread->state = OS_THREAD_STATE_RUNNING;
+
+    rHost.pResult = rHost.func(rHost.pArg);
+
+    BOOL enabled = OSDisableInterrupts();
+    pThread->state = OS_THREAD_STATE_MORIBUND;
+    OSWakeupThread(&pThread->joinQueue);
+    OSRestoreInterrupts(enabled);
+
+    return rHost.pResult;
+}
+
+} // namespace
+
+extern "C" {
+
+/******************************************************************************
+ *
+ * Interrupts
+ *
+ ******************************************************************************/
+
+BOOL OSDisableInterrupts(void) {
+    if (sIntrDisabled) {
+        return FALSE;
+    }
+
+    pthread_mutex_lock(&sIntrMutex);
+    sIntrDisabled = true;
+    return TRUE;
+}
+
+BOOL OSEnableInterrupts(void) {
+    if (!sIntrDisabled) {
+        return TRUE;
+    }
+
+    sIntrDisabled = false;
+    pthread_mutex_unlock(&sIntrMutex);
+    return FALSE;
+}
+
+BOOL OSRestoreInterrupts(BOOL status) {
+    return status ? OSEnableInterrupts() : OSDisableInterrupts();
+}
+
+/******************************************************************************
+ *
+ * Time
+ *
+ ******************************************************************************/
+
+s64 OSGetTime(void) {
+    // 60.75MHz, counting from program start
+    return static_cast<s64>((GetHostTime() - sTimeBase) * 243 / 4000);
+}
+
+u32 OSGetTick(void) {
+    // Wraps at 32 bits like the console's (after ~70 seconds)
+    return static_cast<u32>(static_cast<std::uint32_t>(OSGetTime()));
+}
+
+/******************************************************************************
+ *
+ * Threads
+ *
+ ******************************************************************************/
+
+OSThread* OSGetCurrentThread(void) {
+    if (spCurrentThread == nullptr) {
+        sHostThread.state = OS_THREAD_STATE_RUNNING;
+        spCurrentThread = &sHostThread;
+    }
+
+    return spCurrentThread;
+}
+
+void OSInitThreadQueue(OSThreadQueue* queue) {
+    queue->head = queue->tail = nullptr;
+}
+
+void OSSleepThread(OSThreadQueue* queue) {
+    BOOL enabled = OSDisableInterrupts();
+    OSThread* pSelf = OSGetCurrentThread();
+
+    pSelf->queue = queue;
+    pSelf->next = nullptr;
+    pSelf->prev = queue->tail;
+
+    if (queue->tail != nullptr) {
+        queue->tail->next = pSelf;
+    } else {
+        queue->head = pSelf;
+    }
+
+    queue->tail = pSelf;
+    pSelf->state = OS_THREAD_STATE_SLEEPING;
+
+    // Other threads can run while this one sleeps
+    while (pSelf->queue == queue) {
+        pthread_cond_wait(&sIntrCond, &sIntrMutex);
+    }
+
+    pSelf->state = OS_THREAD_STATE_RUNNING;
+    OSRestoreInterrupts(enabled);
+}
+
+void OSWakeupThread(OSThreadQueue* queue) {
+    BOOL enabled = OSDisableInterrupts();
+
+    while (queue->head != nullptr) {
+        OSThread* pThread = queue->head;
+        queue->head = pThread->next;
+
+        pThread->queue = nullptr;
+        pThread->next = pThread->prev = nullptr;
+    }
+
+    queue->tail = nullptr;
+    pthread_cond_broadcast(&sIntrCond);
+
+    OSRestoreInterrupts(enabled);
+}
+
+BOOL OSCreateThread(OSThread* thread, OSThreadFunc func, void* funcArg,
+                    void* stackBegin, u32 stackSize, s32 prio, u16 flags) {
+    // Host threads bring their own stack
+    std::memset(thread, 0, sizeof(OSThread));
+
+    thread->state = OS_THREAD_STATE_READY;
+    thread->flags = flags;
+    thread->suspend = 1;
+    thread->priority = thread->base = prio;
+    OSInitThreadQueue(&thread->joinQueue);
+
+    // Stack isn't used, but callers check for overflow like on the console
+    thread->stackBegin = static_cast<u32*>(stackBegin);
+    thread->stackEnd = reinterpret_cast<u32*>(static_cast<u8*>(stackBegin) -
+                                              stackSize);
+    *thread->stackEnd = OS_THREAD_STACK_MAGIC;
+
+    HostThread& rHost = GetHostThread(thread);
+    rHost.func = func;
+    rHost.pArg = funcArg;
+
+    return TRUE;
+}
+
+s32 OSResumeThread(OSThread* thread) {
+    BOOL enabled = OSDisableInterrupts();
+
+    s32 prev = thread->suspend;
+    if (thread->suspend > 0) {
+        thread->suspend--;
+    }
+
+    HostThread& rHost = GetHostThread(thread);
+    bool start = thread->suspend == 0 && !rHost.isStarted;
+    rHost.isStarted = rHost.isStarted || start;
+
+    OSRestoreInterrupts(enabled);
+
+    if (start) {
+        pthread_create(&rHost.handle, nullptr, ThreadEntry, thread);
+
+        if (thread->flags & OS_THREAD_DETACHED) {
+            pthread_detach(rHost.handle);
+        }
+    }
+
+    return prev;
+}
+
+BOOL OSJoinThread(OSThread* thread, void* val) {
+    HostThread& rHost = GetHostThread(thread);
+
+    if (!rHost.isStarted || (thread->flags & OS_THREAD_DETACHED)) {
+        return FALSE;
+    }
+
+    pthread_join(rHost.handle, nullptr);
+    thread->state = OS_THREAD_STATE_EXITED;
+
+    if (val != nullptr) {
+        *static_cast<void**>(val) = rHost.pResult;
+    }
+
+    return TRUE;
+}
+
+void OSDetachThread(OSThread* thread) {
+    HostThread& rHost = GetHostThread(thread);
+
+    if (rHost.isStarted && !(thread->flags & OS_THREAD_DETACHED)) {
+        pthread_detach(rHost.handle);
+    }
+
+    thread->flags |= OS_THREAD_DETACHED;
+}
+
+BOOL OSIsThreadTerminated(OSThread* thread) {
+    return thread->state == OS_THREAD_STATE_EXITED ||
+           thread->state == OS_THREAD_STATE_MORIBUND;
+}
+
+BOOL OSSetThreadPriority(OSThread* thread, s32 prio) {
+    thread->priority = thread->base = prio;
+    return TRUE;
+}
+
+void OSYieldThread(void) {
+    sched_yield();
+}
+
+void OSSleepTicks(s64 ticks) {
+    u64 ns = OS_TICKS_TO_NSEC(ticks);
+
+    timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    nanosleep(&ts, nullptr);
+}
+
+/******************************************************************************
+ *
+ * Mutexes
+ *
+ ******************************************************************************/
+
+void OSInitMutex(OSMutex* mutex) {
+    OSInitThreadQueue(&mutex->queue);
+    mutex->thread = nullptr;
+    mutex->lock = 0;
+}
+
+void OSLockMutex(OSMutex* mutex) {
+    BOOL enabled = OSDisableInterrupts();
+    OSThread* pSelf = OSGetCurrentThread();
+
+    while (mutex->thread != nullptr && mutex->thread != pSelf) {
+        OSSleepThread(&mutex->queue);
+    }
+
+    mutex->thread = pSelf;
+    mutex->lock++;
+
+    OSRestoreInterrupts(enabled);
+}
+
+BOOL OSTryLockMutex(OSMutex* mutex) {
+    BOOL enabled = OSDisableInterrupts();
+    OSThread* pSelf = OSGetCurrentThread();
+
+    bool success = mutex->thread == nullptr || mutex->thread == pSelf;
+    if (success) {
+        mutex->thread = pSelf;
+        mutex->lock++;
+    }
+
+    OSRestoreInterrupts(enabled);
+    return success;
+}
+
+void OSUnlockMutex(OSMutex* mutex) {
+    BOOL enabled = OSDisableInterrupts();
+
+    if (mutex->thread == OSGetCurrentThread() && --mutex->lock == 0) {
+        mutex->thread = nullptr;
+        OSWakeupThread(&mutex->queue);
+    }
+
+    OSRestoreInterrupts(enabled);
+}
+
+/******************************************************************************
+ *
+ * Alarms
+ *
+ ******************************************************************************/
+
+void OSCreateAlarm(OSAlarm* alarm) {
+    alarm->handler = nullptr;
+    alarm->tag = 0;
+}
+
+void OSSetAlarm(OSAlarm* alarm, s64 tick, OSAlarmHandler handler) {
+    pthread_once(&sAlarmOnce, CreateAlarmThread);
+
+    BOOL enabled = OSDisableInterrupts();
+
+    // Setting an alarm again moves it
+    if (alarm->handler != nullptr) {
+        RemoveAlarm(alarm);
+    }
+
+    alarm->handler = handler;
+    alarm->period = 0;
+    alarm->start = 0;
+    alarm->end = OSGetTime() + tick;
+    InsertAlarm(alarm);
+
+    pthread_cond_broadcast(&sIntrCond);
+    OSRestoreInterrupts(enabled);
+}
+
+void OSSetPeriodicAlarm(OSAlarm* alarm, s64 tick, s64 period,
+                        OSAlarmHandler handler) {
+    pthread_once(&sAlarmOnce, CreateAlarmThread);
+
+    BOOL enabled = OSDisableInterrupts();
+
+    // Setting an alarm again moves it
+    if (alarm->handler != nullptr) {
+        RemoveAlarm(alarm);
+    }
+
+    alarm->handler = handler;
+    alarm->period = period;
+    alarm->start = tick;
+
+    // First period boundary after now
+    s64 now = OSGetTime();
+    alarm->end = tick > now ? tick : tick + ((now - tick) / period + 1) * period;
+    InsertAlarm(alarm);
+
+    pthread_cond_broadcast(&sIntrCond);
+    OSRestoreInterrupts(enabled);
+}
+
+void OSCancelAlarm(OSAlarm* alarm) {
+    BOOL enabled = OSDisableInterrupts();
+
+    if (alarm->handler != nullptr) {
+        RemoveAlarm(alarm);
+        alarm->handler = nullptr;
+    }
+
+    OSRestoreInterrupts(enabled);
+}
+
+void OSSetAlarmTag(OSAlarm* alarm, u32 tag) {
+    alarm->tag = tag;
+}
+
+void OSSetAlarmUserData(OSAlarm* alarm, void* userData) {
+    alarm->userData = userData;
+}
+
+void* OSGetAlarmUserData(const OSAlarm* alarm) {
+    return alarm->userData;
+}
+
+/******************************************************************************
+ *
+ * Errors
+ *
+ ******************************************************************************/
+
+void OSReport(const char* msg, ...) {
+    std::va_list list;
+
+    va_start(list, msg);
+    std::vprintf(msg, list);
+    va_end(list);
+}
+
+} // extern "C"
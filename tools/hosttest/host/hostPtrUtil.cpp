@@ -0,0 +1,35 @@
+#include <libkiwi.h>
+
+/**
+ * PtrUtil validity checks for host tests. The real ones (kiwiPtrUtil.cpp)
+ * test for the console's MEM1/MEM2 addresses, so any non-null address counts
+ * as a pointer here.
+ */
+
+namespace kiwi {
+
+/**
+ * @brief Tests whether an address is a valid pointer
+ *
+ * @param addr Address
+ */
+bool PtrUtil::IsPointer(const void* addr) {
+    return addr != nullptr;
+}
+
+/**
+ * @brief Tests whether an address is aligned to the specified number of
+ * bytes
+ *
+ * @param addr Address
+ * @param align Byte alignment
+ */
+bool PtrUtil::IsAlignedPointer(const void* addr, u32 align) {
+    if (!IsPointer(addr)) {
+        return false;
+    }
+
+    return reinterpret_cast<uintptr_t>(addr) % align == 0;
+}
+
+} // namespace kiwi
@@ -0,0 +1,180 @@
+#include <libkiwi.h>
+
+#include <cstring>
+
+/**
+ * SHA-1 for host tests. The real one (kiwiSHA1.cpp) reads message words
+ * straight from memory and rotates them as u32s, which relies on the
+ * console's big endian byte order and 32-bit longs. This version loads the
+ * words byte by byte and keeps the arithmetic in 32 bits.
+ */
+
+namespace kiwi {
+
+/**
+ * @brief Finalizes the hash and returns the digest
+ * @details The digest is printed as uppercase hex
+ */
+String SHA1::Finalize() {
+    u8 buffer[DIGEST_SIZE];
+    Finalize(buffer);
+
+    // Space for the digest printed as hex
+    String digest;
+    digest.Reserve(DIGEST_SIZE * 2);
+
+    // Convert nibbles to characters
+    static const char sHexDigits[] = "0123456789ABCDEF";
+    for (int i = 0; i < LENGTHOF(buffer); i++) {
+        digest += sHexDigits[(buffer[i] & 0xF0) >> 4];
+        digest += sHexDigits[(buffer[i] & 0x0F) >> 0];
+    }
+
+    return digest;
+}
+
+namespace detail {
+namespace {
+
+/**
+ * @brief Rotates a 32-bit value to the left
+ */
+uint32_t Rol(uint32_t value, int bits) {
+    return value << bits | value >> (32 - bits);
+}
+
+/**
+ * @brief Hashes a single 512-bit block
+ *
+ * @param pState Hash state
+ * @param pBuffer Block buffer
+ */
+void SHA1Transform(u32 pState[5], const u8 pBuffer[64]) {
+    uint32_t w[80];
+
+    // Message words are big endian
+    for (int i = 0; i < 16; i++) {
+        w[i] = static_cast<uint32_t>(pBuffer[i * 4 + 0]) << 24 |
+               static_cast<uint32_t>(pBuffer[i * 4 + 1]) << 16 |
+               static_cast<uint32_t>(pBuffer[i * 4 + 2]) << 8 |
+               static_cast<uint32_t>(pBuffer[i * 4 + 3]);
+    }
+
+    for (int i = 16; i < 80; i++) {
+        w[i] = Rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = pState[0], b = pState[1], c = pState[2], d = pState[3],
+             e = pState[4];
+
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t temp = Rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = Rol(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    pState[0] = static_cast<uint32_t>(pState[0] + a);
+    pState[1] = static_cast<uint32_t>(pState[1] + b);
+    pState[2] = static_cast<uint32_t>(pState[2] + c);
+    pState[3] = static_cast<uint32_t>(pState[3] + d);
+    pState[4] = static_cast<uint32_t>(pState[4] + e);
+}
+
+} // namespace
+
+/**
+ * @brief Initializes new context
+ * @details u32 is wide enough on the host to count every byte in count[0]
+ *
+ * @param pContext SHA1 context
+ */
+void SHA1Init(SHA1_CTX* pContext) {
+    pContext->state[0] = 0x67452301;
+    pContext->state[1] = 0xEFCDAB89;
+    pContext->state[2] = 0x98BADCFE;
+    pContext->state[3] = 0x10325476;
+    pContext->state[4] = 0xC3D2E1F0;
+    pContext->count[0] = pContext->count[1] = 0;
+}
+
+/**
+ * @brief Updates the hash value by processing the input data
+ *
+ * @param pContext SHA1 context
+ * @param pData Input data
+ * @param len Data length
+ */
+void SHA1Update(SHA1_CTX* pContext, const u8* pData, u32 len) {
+    u32 used = pContext->count[0] % 64;
+    pContext->count[0] += len;
+
+    while (len > 0) {
+        u32 n = Min<u32>(len, 64 - used);
+        std::memcpy(pContext->buffer + used, pData, n);
+
+        used += n;
+        pData += n;
+        len -= n;
+
+        if (used == 64) {
+            SHA1Transform(pContext->state, pContext->buffer);
+            used = 0;
+        }
+    }
+}
+
+/**
+ * @brief Writes the message digest to an output buffer and finalizes the hash
+ * context
+ *
+ * @param[out] pDigest Digest buffer
+ * @param pContext SHA1 context
+ */
+void SHA1Final(u8 pDigest[20], SHA1_CTX* pContext) {
+    u64 bits = static_cast<u64>(pContext->count[0]) * 8;
+
+    // Padding, then the message length in bits (big endian)
+    u8 c = 0x80;
+    SHA1Update(pContext, &c, 1);
+
+    c = 0x00;
+    while (pContext->count[0] % 64 != 56) {
+        SHA1Update(pContext, &c, 1);
+    }
+
+    u8 length[8];
+    for (int i = 0; i < 8; i++) {
+        length[i] = static_cast<u8>(bits >> ((7 - i) * 8));
+    }
+
+    SHA1Update(pContext, length, sizeof(length));
+
+    for (int i = 0; i < 20; i++) {
+        pDigest[i] =
+            static_cast<u8>(pContext->state[i / 4] >> ((3 - i % 4) * 8));
+    }
+
+    std::memset(pContext, 0, sizeof(*pContext));
+}
+
+} // namespace detail
+} // namespace kiwi
@@ -0,0 +1,113 @@
+#include "hostTest.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace host {
+namespace {
+
+u32 sNumRun = 0;      // Number of test cases run
+u32 sNumFailed = 0;   // Number of failed test cases
+bool sFailed = false; // Whether the current test case failed
+
+const void* volatile spSink = nullptr; // Consumed results
+
+} // namespace
+
+/**
+ * @brief Records a failed check
+ *
+ * @param pFile Source file name
+ * @param line Source file line
+ * @param pExp Failed expression
+ */
+void Fail(const char* pFile, int line, const char* pExp) {
+    std::fprintf(stderr, "  %s:%d: check failed: %s\n", pFile, line, pExp);
+    sFailed = true;
+}
+
+/**
+ * @brief Runs a test case
+ *
+ * @param pName Test name
+ * @param pFunc Test function
+ */
+void Run(const char* pName, void (*pFunc)()) {
+    sFailed = false;
+    pFunc();
+
+    sNumRun++;
+    if (sFailed) {
+        sNumFailed++;
+    }
+
+    std::printf("[%s] %s\n", sFailed ? "FAIL" : " OK ", pName);
+}
+
+/**
+ * @brief Prints the results of all test cases
+ *
+ * @return Process exit code
+ */
+int Finish() {
+    std::printf("%lu/%lu passed\n", sNumRun - sNumFailed, sNumRun);
+    return sNumFailed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Tests whether benchmarks were requested (--bench)
+ *
+ * @param argc Argument count
+ * @param argv Argument values
+ */
+bool IsBench(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bench") == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Gets the current monotonic time, in nanoseconds
+ */
+u64 GetNanoTime() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Constructor
+ *
+ * @param pName Benchmark name
+ */
+Bench::Bench(const char* pName) : mpName(pName), mStart(GetNanoTime()) {}
+
+/**
+ * @brief Stops the timer and prints the time per operation
+ *
+ * @param ops Number of operations done
+ */
+void Bench::Report(u64 ops) {
+    u64 elapsed = GetNanoTime() - mStart;
+
+    std::printf("%-40s %10.2f ms %10.2f ns/op\n", mpName, elapsed / 1.0e6,
+                ops > 0 ? static_cast<double>(elapsed) / ops : 0.0);
+}
+
+/**
+ * @brief Prevents the compiler from removing unused results
+ *
+ * @param pData Result
+ */
+void Consume(const void* pData) {
+    spSink = pData;
+}
+
+} // namespace host
@@ -0,0 +1,102 @@
+#ifndef HOSTTEST_HOST_TEST_H
+#define HOSTTEST_HOST_TEST_H
+#include <libkiwi/k_types.h>
+
+/**
+ * @brief Fails the current test if the condition is FALSE
+ */
+#define HOST_CHECK(exp)                                                        \
+    (!(exp) ? host::Fail(__FILE__, __LINE__, #exp) : (void)0)
+
+/**
+ * @brief Fails the current test if the values differ
+ */
+#define HOST_CHECK_EQ(a, b) HOST_CHECK((a) == (b))
+
+namespace host {
+
+/**
+ * @brief Records a failed check
+ *
+ * @param pFile Source file name
+ * @param line Source file line
+ * @param pExp Failed expression
+ */
+void Fail(const char* pFile, int line, const char* pExp);
+
+/**
+ * @brief Runs a test case
+ *
+ * @param pName Test name
+ * @param pFunc Test function
+ */
+void Run(const char* pName, void (*pFunc)());
+
+/**
+ * @brief Prints the results of all test cases
+ *
+ * @return Process exit code
+ */
+int Finish();
+
+/**
+ * @brief Tests whether benchmarks were requested (--bench)
+ *
+ * @param argc Argument count
+ * @param argv Argument values
+ */
+bool IsBench(int argc, char** argv);
+
+/**
+ * @brief Gets the current monotonic time, in nanoseconds
+ */
+u64 GetNanoTime();
+
+/**
+ * @brief Measures a benchmark and prints its throughput
+ */
+class Bench {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param pName Benchmark name
+     */
+    explicit Bench(const char* pName);
+
+    /**
+     * @brief Stops the timer and prints the time per operation
+     *
+     * @param ops Number of operations done
+     */
+    void Report(u64 ops);
+
+private:
+    const char* mpName; // Benchmark name
+    u64 mStart;         // Start time
+};
+
+/**
+ * @brief Host heap statistics (see hostMemoryMgr.cpp)
+ */
+struct AllocStats {
+    u64 numAllocs; // Number of allocations
+    u64 numBytes;  // Bytes ever allocated
+};
+
+/**
+ * @brief Gets the host heap statistics
+ * @note Only available to tests which link hostMemoryMgr.cpp
+ */
+AllocStats GetAllocStats();
+
+/**
+ * @brief Prevents the compiler from removing unused results
+ *
+ * @param pData Result
+ */
+void Consume(const void* pData);
+
+} // namespace host
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef HOSTTEST_SHIM_EGG_CORE_H
+#define HOSTTEST_SHIM_EGG_CORE_H
+
+/**
+ * EGG's heaps manage the game's arenas, so host tests only see them by name
+ */
+
+namespace EGG {
+
+class Heap;
+class ExpHeap;
+
+} // namespace EGG
+
+#endif
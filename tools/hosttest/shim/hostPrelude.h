@@ -0,0 +1,39 @@
+#ifndef HOSTTEST_SHIM_HOST_PRELUDE_H
+#define HOSTTEST_SHIM_HOST_PRELUDE_H
+
+/**
+ * Forcibly included before every translation unit (see the Makefile).
+ *
+ * libkiwi replaces static_assert with a macro, so the host's standard headers
+ * have to be seen before any libkiwi header.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// CodeWarrior extensions
+#define __decltype__ decltype
+#define __option(x) 0
+#define __declspec(x)
+
+/**
+ * @brief Counts leading zeros (cntlzw), which is 32 for zero
+ */
+inline int __cntlzw(unsigned int x) {
+    return x != 0 ? __builtin_clz(x) : 32;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOSTTEST_SHIM_KAMEK_H
+#define HOSTTEST_SHIM_KAMEK_H
+
+/**
+ * Kamek hooks patch game code, which doesn't exist on the host
+ */
+
+#define KM_BRANCH(addr, ptr)
+#define KM_BRANCH_MF(addr, cls, func)
+#define KM_CALL(addr, ptr)
+#define KM_WRITE_32(addr, value)
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef HOSTTEST_SHIM_KOKESHI_H
+#define HOSTTEST_SHIM_KOKESHI_H
+
+/**
+ * Host builds don't target a game, so per-game hooks are dropped
+ */
+
+#define KOKESHI_BY_PACK(sports, play, resort)
+#define KOKESHI_BY_PACK_NOOP ((void)0)
+#define KOKESHI_NOTIMPLEMENTED KOKESHI_BY_PACK_NOOP
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef HOSTTEST_SHIM_LIBKIWI_H
+#define HOSTTEST_SHIM_LIBKIWI_H
+
+/**
+ * Stands in for libkiwi.h in the libkiwi sources built by the host tests.
+ * Only the modules which build on the host are included.
+ */
+
+#include <libkiwi/core/kiwiAllocator.h>
+#include <libkiwi/core/kiwiFileStream.h>
+#include <libkiwi/core/kiwiIStream.h>
+#include <libkiwi/core/kiwiJSON.h>
+#include <libkiwi/core/kiwiJSONDocument.h>
+#include <libkiwi/core/kiwiJSONStream.h>
+#include <libkiwi/core/kiwiMemStream.h>
+#include <libkiwi/core/kiwiMemoryMgr.h>
+#include <libkiwi/core/kiwiSlabHeap.h>
+#include <libkiwi/core/kiwiThreadPool.h>
+#include <libkiwi/crypt/kiwiBase64.h>
+#include <libkiwi/crypt/kiwiSHA1.h>
+#include <libkiwi/debug/kiwiAssert.h>
+#include <libkiwi/debug/kiwiNw4rConsole.h>
+#include <libkiwi/math/kiwiAlgorithm.h>
+#include <libkiwi/net/kiwiAsyncSocket.h>
+#include <libkiwi/net/kiwiHttpConnectionPool.h>
+#include <libkiwi/net/kiwiHttpRequest.h>
+#include <libkiwi/net/kiwiHttpResponseParser.h>
+#include <libkiwi/net/kiwiNetStats.h>
+#include <libkiwi/net/kiwiPacket.h>
+#include <libkiwi/net/kiwiPacketRing.h>
+#include <libkiwi/net/kiwiReliablePacket.h>
+#include <libkiwi/net/kiwiReliableSocket.h>
+#include <libkiwi/net/kiwiSocketBase.h>
+#include <libkiwi/net/kiwiSyncSocket.h>
+#include <libkiwi/net/kiwiWebSocket.h>
+#include <libkiwi/prim/kiwiBitCast.h>
+#include <libkiwi/prim/kiwiHashMap.h>
+#include <libkiwi/prim/kiwiIntrusiveList.h>
+#include <libkiwi/prim/kiwiLinkList.h>
+#include <libkiwi/prim/kiwiOptional.h>
+#include <libkiwi/prim/kiwiPair.h>
+#include <libkiwi/prim/kiwiSTL.h>
+#include <libkiwi/prim/kiwiString.h>
+#include <libkiwi/prim/kiwiStringView.h>
+#include <libkiwi/prim/kiwiVector.h>
+#include <libkiwi/support/kiwiLibSO.h>
+#include <libkiwi/util/kiwiAutoLock.h>
+#include <libkiwi/util/kiwiIosDevice.h>
+#include <libkiwi/util/kiwiIosDispatcher.h>
+#include <libkiwi/util/kiwiIosObject.h>
+#include <libkiwi/util/kiwiIosScratch.h>
+#include <libkiwi/util/kiwiIosVector.h>
+#include <libkiwi/util/kiwiNonCopyable.h>
+#include <libkiwi/util/kiwiRandom.h>
+#include <libkiwi/util/kiwiStaticSingleton.h>
+#include <libkiwi/util/kiwiWatch.h>
+#include <libkiwi/util/kiwiWorkBuffer.h>
+
+#include <libkiwi/k_types.h>
+#endif
@@ -0,0 +1,37 @@
+#ifndef HOSTTEST_SHIM_LIBKIWI_CORE_SCENE_HOOK_MGR_H
+#define HOSTTEST_SHIM_LIBKIWI_CORE_SCENE_HOOK_MGR_H
+#include <libkiwi/k_types.h>
+
+/**
+ * Stands in for the scene hook manager, which needs the game's scene system.
+ * Hooks aren't registered anywhere: tests call the callbacks themselves.
+ */
+
+class RPSysScene;
+
+namespace kiwi {
+
+/**
+ * @brief Scene hook interface
+ */
+class ISceneHook {
+public:
+    explicit ISceneHook(s32 id) : mSceneID(id) {}
+    virtual ~ISceneHook() {}
+
+    virtual void Configure(RPSysScene* pScene) {}
+    virtual void LoadResource(RPSysScene* pScene) {}
+    virtual void BeforeReset(RPSysScene* pScene) {}
+    virtual void AfterReset(RPSysScene* pScene) {}
+    virtual void BeforeCalculate(RPSysScene* pScene) {}
+    virtual void AfterCalculate(RPSysScene* pScene) {}
+    virtual void Exit(RPSysScene* pScene) {}
+    virtual void Pause(RPSysScene* pScene, bool enter) {}
+
+private:
+    s32 mSceneID; // Scene to which this hook belongs
+};
+
+} // namespace kiwi
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HOSTTEST_SHIM_LOADER_KAMEK_TYPES_H
+#define HOSTTEST_SHIM_LOADER_KAMEK_TYPES_H
+
+/**
+ * The loader reads and writes words through u32 pointers, so unlike the rest
+ * of the host build (see host/hostTest.h), u32 has to be exactly 32 bits.
+ */
+
+typedef unsigned long long u64;
+typedef signed long long s64;
+
+typedef unsigned int u32;
+typedef signed int s32;
+
+typedef unsigned short u16;
+typedef signed short s16;
+
+typedef unsigned char u8;
+typedef signed char s8;
+
+typedef float f32;
+typedef double f64;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOSTTEST_SHIM_LOADER_KOKESHI_H
+#define HOSTTEST_SHIM_LOADER_KOKESHI_H
+#include <kamekTypes.hpp>
+
+/**
+ * Only the module information which the Kamek loader writes
+ */
+
+namespace kokeshi {
+
+struct ModuleInfo {
+    const void* start;
+    u32 size;
+};
+
+//! Defined by host/hostKamek.cpp (at 0x80003200 on the console)
+extern ModuleInfo CURRENT_MODULE;
+
+} // namespace kokeshi
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef HOSTTEST_SHIM_LOADER_REVOLUTION_DVD_H
+#define HOSTTEST_SHIM_LOADER_REVOLUTION_DVD_H
+#include <kamekTypes.hpp>
+
+/**
+ * Only the parts of the DVD library which the Kamek loader uses. There is no
+ * disc on the host, so binaries are passed to the loader directly.
+ */
+
+#define DVD_PRIO_MEDIUM 2
+
+typedef struct DVDCommandBlock {
+    void* addr;
+} DVDCommandBlock;
+
+typedef struct DVDFileInfo {
+    DVDCommandBlock block;
+    u32 size;
+} DVDFileInfo;
+
+static inline s32 DVDConvertPathToEntrynum(const char* path) {
+    return -1;
+}
+static inline bool DVDFastOpen(s32 entrynum, DVDFileInfo* info) {
+    return false;
+}
+static inline s32 DVDReadPrio(DVDFileInfo* info, void* dst, s32 size,
+                              s32 offset, s32 prio) {
+    return -1;
+}
+static inline bool DVDClose(DVDFileInfo* info) {
+    return false;
+}
+
+#endif
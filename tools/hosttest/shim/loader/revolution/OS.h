@@ -0,0 +1,29 @@
+#ifndef HOSTTEST_SHIM_LOADER_REVOLUTION_OS_H
+#define HOSTTEST_SHIM_LOADER_REVOLUTION_OS_H
+#include <kamekTypes.hpp>
+
+/**
+ * Only the parts of the OS library which the Kamek loader uses. The functions
+ * are implemented by host/hostKamek.cpp against the simulated memory image.
+ */
+
+#define OS_TIME_SPEED (243000000 / 4)
+#define OS_TICKS_TO_USEC(x) (((x) * 8) / (OS_TIME_SPEED / 125000))
+
+typedef struct _GXColor {
+    u8 r, g, b, a;
+} GXColor;
+
+void OSReport(const char* msg, ...);
+void OSFatal(GXColor textColor, GXColor bgColor, const char* msg);
+
+u32 OSGetTick(void);
+
+void DCFlushRange(void* buf, u32 len);
+void DCZeroRange(void* buf, u32 len);
+void ICInvalidateRange(void* buf, u32 len);
+
+static inline void __sync(void) {}
+static inline void __isync(void) {}
+
+#endif
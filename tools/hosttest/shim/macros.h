@@ -0,0 +1,7 @@
+#ifndef HOSTTEST_SHIM_MACROS_H
+#define HOSTTEST_SHIM_MACROS_H
+
+// The rest of include/ is the game's C library, so only take this file
+#include "../../../include/macros.h"
+
+#endif
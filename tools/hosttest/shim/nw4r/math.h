@@ -0,0 +1,15 @@
+#ifndef HOSTTEST_SHIM_NW4R_MATH_H
+#define HOSTTEST_SHIM_NW4R_MATH_H
+#include <cmath>
+
+namespace nw4r {
+namespace math {
+
+inline float FLog(float x) {
+    return x > 0.0f ? std::log(x) : NAN;
+}
+
+} // namespace math
+} // namespace nw4r
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HOSTTEST_SHIM_REVOLUTION_IPC_H
+#define HOSTTEST_SHIM_REVOLUTION_IPC_H
+
+/**
+ * Only the IOS client API, which is implemented by host/hostIOS.cpp.
+ * The IPC driver headers place registers at fixed addresses (CodeWarrior
+ * syntax), and the host has no IPC hardware anyway.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <revolution/IPC/ipcclt.h>
+
+#ifdef __cplusplus
+}
+#endif
+#endif
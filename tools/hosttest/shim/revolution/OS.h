@@ -0,0 +1,25 @@
+#ifndef HOSTTEST_SHIM_REVOLUTION_OS_H
+#define HOSTTEST_SHIM_REVOLUTION_OS_H
+
+/**
+ * Only the parts of the OS library which are implemented by host/hostOS.cpp.
+ * The declarations themselves come from the SDK headers in include/.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <revolution/OS/OSAlarm.h>
+#include <revolution/OS/OSCache.h>
+#include <revolution/OS/OSError.h>
+#include <revolution/OS/OSInterrupt.h>
+#include <revolution/OS/OSMemory.h>
+#include <revolution/OS/OSMutex.h>
+#include <revolution/OS/OSThread.h>
+#include <revolution/OS/OSTime.h>
+
+#ifdef __cplusplus
+}
+#endif
+#endif
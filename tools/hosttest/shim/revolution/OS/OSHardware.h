@@ -0,0 +1,15 @@
+#ifndef HOSTTEST_SHIM_REVOLUTION_OS_HARDWARE_H
+#define HOSTTEST_SHIM_REVOLUTION_OS_HARDWARE_H
+#include <types.h>
+
+#include <revolution/OS/OSThread.h>
+
+/**
+ * The real header maps the OS globals at fixed addresses, which only exist on
+ * the console. Host tests only need the clock speeds for OSTime.
+ */
+
+//! Wii bus clock (243MHz), so the time base runs at 60.75MHz
+#define OS_BUS_CLOCK_SPEED 243000000
+
+#endif
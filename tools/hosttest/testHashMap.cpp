@@ -0,0 +1,352 @@
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <cstdlib>
+#include <vector>
+
+/**
+ * TMap tests (insertion, removal, tombstones, rehashing, heterogeneous
+ * lookup, iteration), and insert/find/remove benchmarks.
+ */
+
+namespace {
+
+typedef kiwi::TMap<u32, u32> IntMap;
+
+/**
+ * @brief Allocator which remembers the slot buffers a map allocates
+ */
+class CountAllocator : public kiwi::IAllocator {
+public:
+    CountAllocator() : mNumAllocs(0), mNumFrees(0), mLastSize(0) {}
+
+    virtual void* Alloc(u32 size, s32 align) {
+        mNumAllocs++;
+        mLastSize = size;
+        return std::malloc(size);
+    }
+
+    virtual void Free(void* pBlock) {
+        if (pBlock != nullptr) {
+            mNumFrees++;
+        }
+
+        std::free(pBlock);
+    }
+
+    u32 GetNumAllocs() const {
+        return mNumAllocs;
+    }
+    u32 GetNumFrees() const {
+        return mNumFrees;
+    }
+
+    /**
+     * @brief Gets the slot count of the newest buffer
+     * @details Each slot holds a key, a value, and a control byte
+     */
+    u32 GetCapacity() const {
+        return mLastSize / (2 * sizeof(u32) + 1);
+    }
+
+private:
+    u32 mNumAllocs; // Blocks allocated
+    u32 mNumFrees;  // Blocks freed
+    u32 mLastSize;  // Size of the newest block
+};
+
+void TestInsert() {
+    IntMap map;
+    HOST_CHECK(map.Empty());
+    HOST_CHECK(map.Find(1) == nullptr);
+
+    for (u32 i = 0; i < 1000; i++) {
+        map.Insert(i, i * 3);
+    }
+
+    HOST_CHECK_EQ(map.Size(), 1000);
+
+    for (u32 i = 0; i < 1000; i++) {
+        HOST_CHECK(map.Find(i) != nullptr && *map.Find(i) == i * 3);
+    }
+
+    HOST_CHECK(!map.Contains(1000));
+    HOST_CHECK_EQ(map.Get(1000, 7), 7);
+
+    // Existing keys are updated in place
+    map.Insert(5, 50);
+    map[6] = 60;
+    map[2000]++;
+
+    HOST_CHECK_EQ(map.Size(), 1001);
+    HOST_CHECK_EQ(map.Get(5), 50);
+    HOST_CHECK_EQ(map.Get(6), 60);
+    HOST_CHECK_EQ(map.Get(2000), 1);
+
+    // Copies are independent
+    IntMap copy(map);
+    copy[5] = 0;
+    HOST_CHECK_EQ(copy.Size(), 1001);
+    HOST_CHECK_EQ(map.Get(5), 50);
+
+    IntMap assigned;
+    assigned[9999] = 1;
+    assigned = map;
+    HOST_CHECK_EQ(assigned.Size(), 1001);
+    HOST_CHECK(!assigned.Contains(9999));
+    HOST_CHECK_EQ(assigned.Get(999), 999 * 3);
+}
+
+void TestRemove() {
+    IntMap map;
+
+    for (u32 i = 0; i < 100; i++) {
+        map.Insert(i, i + 1);
+    }
+
+    u32 removed = 0;
+    HOST_CHECK(map.Remove(10, &removed));
+    HOST_CHECK_EQ(removed, 11);
+    HOST_CHECK(!map.Remove(10));
+    HOST_CHECK(!map.Remove(100));
+
+    HOST_CHECK_EQ(map.Size(), 99);
+    HOST_CHECK(!map.Contains(10));
+
+    // Keys after the removed one in a probe sequence are still found
+    for (u32 i = 0; i < 100; i++) {
+        HOST_CHECK_EQ(map.Contains(i), i != 10);
+    }
+
+    map.Insert(10, 5);
+    HOST_CHECK_EQ(map.Get(10), 5);
+    HOST_CHECK_EQ(map.Size(), 100);
+
+    map.Clear();
+    HOST_CHECK(map.Empty());
+    HOST_CHECK(!map.Contains(10));
+    HOST_CHECK(map.Begin() == map.End());
+}
+
+void TestTombstones() {
+    CountAllocator allocator;
+    IntMap map(0, &allocator);
+
+    // Twelve keys fit in 16 slots under the 75% load limit
+    map.Reserve(12);
+    HOST_CHECK_EQ(allocator.GetCapacity(), 16);
+
+    // Churn through many keys with only a few live at once
+    for (u32 i = 0; i < 10000; i++) {
+        map.Insert(i, i);
+
+        if (i >= 4) {
+            HOST_CHECK(map.Remove(i - 4));
+        }
+    }
+
+    // Tombstones were compacted without growing the table
+    HOST_CHECK_EQ(map.Size(), 4);
+    HOST_CHECK_EQ(allocator.GetCapacity(), 16);
+    HOST_CHECK(allocator.GetNumAllocs() > 1);
+
+    for (u32 i = 0; i < 10000; i++) {
+        HOST_CHECK_EQ(map.Contains(i), i >= 9996);
+    }
+}
+
+void TestRehash() {
+    CountAllocator allocator;
+    IntMap map(0, &allocator);
+
+    // Nothing is allocated for an empty map
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 0);
+
+    // Six keys fit in the first eight slots, the seventh doubles the table
+    for (u32 i = 0; i < 6; i++) {
+        map.Insert(i, i);
+    }
+
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 1);
+    HOST_CHECK_EQ(allocator.GetCapacity(), 8);
+
+    map.Insert(6, 6);
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 2);
+    HOST_CHECK_EQ(allocator.GetCapacity(), 16);
+
+    // Old buffers are freed
+    HOST_CHECK_EQ(allocator.GetNumFrees(), 1);
+
+    for (u32 i = 7; i < 1000; i++) {
+        map.Insert(i, i);
+    }
+
+    // Load stays at or under 75%
+    HOST_CHECK_EQ(allocator.GetCapacity(), 2048);
+
+    for (u32 i = 0; i < 1000; i++) {
+        HOST_CHECK_EQ(map.Get(i, 0xFFFF), i);
+    }
+}
+
+void TestReserve() {
+    CountAllocator allocator;
+    IntMap map(0, &allocator);
+
+    map.Reserve(100);
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 1);
+    HOST_CHECK_EQ(allocator.GetCapacity(), 256);
+
+    for (u32 i = 0; i < 100; i++) {
+        map.Insert(i, i);
+    }
+
+    // No rehashing up to the reserved size
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 1);
+
+    // Smaller reservations never shrink the table
+    map.Reserve(10);
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 1);
+
+    // Reserving more keeps the contents
+    map.Reserve(1000);
+    HOST_CHECK_EQ(allocator.GetNumAllocs(), 2);
+    HOST_CHECK_EQ(map.Size(), 100);
+    HOST_CHECK_EQ(map.Get(99), 99);
+}
+
+void TestLookup() {
+    kiwi::TMap<kiwi::String, u32> map;
+    map.Insert("Content-Length", 1);
+    map.Insert("Host", 2);
+    map.Insert("", 3);
+
+    // C-style strings hash like Strings
+    HOST_CHECK_EQ(kiwi::Hash("Host"), kiwi::Hash(kiwi::String("Host")));
+
+    const char* pKey = "Host";
+    HOST_CHECK(map.Find(pKey) != nullptr && *map.Find(pKey) == 2);
+    HOST_CHECK(map.Contains("Content-Length"));
+    HOST_CHECK(map.Contains(""));
+    HOST_CHECK(!map.Contains("host"));
+    HOST_CHECK(!map.Contains("Content-Lengt"));
+}
+
+void TestIterate() {
+    IntMap map;
+
+    for (u32 i = 0; i < 100; i++) {
+        map.Insert(i, i * 2);
+    }
+
+    for (u32 i = 0; i < 100; i += 2) {
+        map.Remove(i);
+    }
+
+    // Each remaining key is visited once, and removed ones are skipped
+    std::vector<u32> seen(100, 0);
+    u32 num = 0;
+
+    for (IntMap::ConstIterator it = map.Begin(); it != map.End(); ++it) {
+        HOST_CHECK(it.Key() < 100 && it.Key() % 2 == 1);
+        HOST_CHECK_EQ(it.Value(), it.Key() * 2);
+
+        seen[it.Key()]++;
+        num++;
+    }
+
+    HOST_CHECK_EQ(num, 50);
+
+    for (u32 i = 1; i < 100; i += 2) {
+        HOST_CHECK_EQ(seen[i], 1);
+    }
+}
+
+void BenchMap() {
+    const u32 num = 100000;
+
+    // Keys spread like pointers/IDs rather than a dense range
+    std::vector<u32> keys(num);
+    for (u32 i = 0; i < num; i++) {
+        keys[i] = static_cast<u32>(i * 2654435761u) >> 4;
+    }
+
+    IntMap map;
+
+    {
+        host::Bench bench("TMap insert (growing)");
+        for (u32 i = 0; i < num; i++) {
+            map.Insert(keys[i], i);
+        }
+        bench.Report(num);
+    }
+
+    {
+        u32 sum = 0;
+
+        host::Bench bench("TMap find (hit)");
+        for (u32 i = 0; i < num; i++) {
+            sum += *map.Find(keys[i]);
+        }
+        bench.Report(num);
+
+        host::Consume(&sum);
+    }
+
+    {
+        u32 hits = 0;
+
+        host::Bench bench("TMap find (miss)");
+        for (u32 i = 0; i < num; i++) {
+            hits += map.Contains(keys[i] + 1);
+        }
+        bench.Report(num);
+
+        host::Consume(&hits);
+    }
+
+    {
+        host::Bench bench("TMap remove + insert (churn)");
+        for (u32 i = 0; i < num; i++) {
+            map.Remove(keys[i]);
+            map.Insert(keys[i] ^ 0x80000000, i);
+        }
+        bench.Report(num);
+    }
+
+    {
+        kiwi::TMap<kiwi::String, u32> strings;
+        strings.Insert("Content-Length", 1);
+        strings.Insert("Content-Type", 2);
+        strings.Insert("Connection", 3);
+
+        u32 hits = 0;
+
+        host::Bench bench("TMap<String> find (const char*)");
+        for (u32 i = 0; i < num; i++) {
+            hits += strings.Contains("Content-Type");
+        }
+        bench.Report(num);
+
+        host::Consume(&hits);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("TMap insert/find", TestInsert);
+    host::Run("TMap remove", TestRemove);
+    host::Run("TMap tombstone compaction", TestTombstones);
+    host::Run("TMap rehash", TestRehash);
+    host::Run("TMap reserve", TestReserve);
+    host::Run("TMap heterogeneous lookup", TestLookup);
+    host::Run("TMap iteration after remove", TestIterate);
+
+    if (host::IsBench(argc, argv)) {
+        BenchMap();
+    }
+
+    return host::Finish();
+}
@@ -0,0 +1,732 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * HttpRequest/HttpConnectionPool tests against a host HTTP server, and a
+ * benchmark of requests per second with and without pooling (sync requests,
+ * and async requests with several in flight).
+ */
+
+namespace {
+
+//! How long to wait for asynchronous requests
+const u64 scTimeoutNsec = 10ull * 1000 * 1000 * 1000;
+
+/**
+ * @brief HTTP/1.1 server, on the host's own sockets (the PC side)
+ * @details Serves every connection from one thread. Each response body is
+ * the requested resource, so responses can be matched to requests.
+ */
+class HttpServer {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param maxPerConn Responses before closing a keep-alive connection
+     * without telling the client (0 for no limit)
+     */
+    explicit HttpServer(u32 maxPerConn = 0)
+        : mMaxPerConn(maxPerConn),
+          mIsRunning(true),
+          mNumConnections(0),
+          mNumRequests(0) {
+
+        mListenFD = socket(AF_INET, SOCK_STREAM, 0);
+
+        int reuse = 1;
+        setsockopt(mListenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(int));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(sockaddr_in));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t len = sizeof(sockaddr_in);
+        bind(mListenFD, reinterpret_cast<sockaddr*>(&addr), len);
+        listen(mListenFD, 128);
+
+        getsockname(mListenFD, reinterpret_cast<sockaddr*>(&addr), &len);
+        mPort = ntohs(addr.sin_port);
+
+        pthread_create(&mThread, nullptr, ThreadFunc, this);
+    }
+
+    /**
+     * @brief Destructor
+     */
+    ~HttpServer() {
+        __atomic_store_n(&mIsRunning, false, __ATOMIC_RELEASE);
+        pthread_join(mThread, nullptr);
+
+        for (u32 i = 0; i < mConnections.size(); i++) {
+            close(mConnections[i].fd);
+        }
+
+        close(mListenFD);
+    }
+
+    u16 GetPort() const {
+        return mPort;
+    }
+
+    /**
+     * @brief Gets the number of connections accepted
+     */
+    u32 GetNumConnections() const {
+        return __atomic_load_n(&mNumConnections, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * @brief Gets the number of requests served
+     */
+    u32 GetNumRequests() const {
+        return __atomic_load_n(&mNumRequests, __ATOMIC_ACQUIRE);
+    }
+
+private:
+    /**
+     * @brief Client connection
+     */
+    struct Connection {
+        int fd;          // Connection socket
+        std::string in;  // Request data not yet handled
+        u32 numServed;   // Responses sent
+    };
+
+    /**
+     * @brief Finds the end of a request header
+     * @note libkiwi ends lines with LF, other clients with CRLF
+     *
+     * @return Offset after the header, or zero if it is incomplete
+     */
+    static size_t FindHeaderEnd(const std::string& rData) {
+        size_t lf = rData.find("\n\n");
+        size_t crlf = rData.find("\r\n\r\n");
+
+        if (lf != std::string::npos &&
+            (crlf == std::string::npos || lf < crlf)) {
+            return lf + 2;
+        }
+
+        return crlf != std::string::npos ? crlf + 4 : 0;
+    }
+
+    /**
+     * @brief Responds to every complete request received on a connection
+     *
+     * @return Whether to keep the connection open
+     */
+    bool Serve(Connection& rConn) {
+        size_t end;
+        while ((end = FindHeaderEnd(rConn.in)) != 0) {
+            std::string request = rConn.in.substr(0, end);
+            rConn.in.erase(0, end);
+
+            // Request line is "<method> <resource> <version>"
+            size_t start = request.find(' ') + 1;
+            std::string resource =
+                request.substr(start, request.find(' ', start) - start);
+
+            bool close =
+                request.find("Connection: close") != std::string::npos;
+
+            char header[256];
+            int headerLen = std::snprintf(
+                header, sizeof(header),
+                "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n"
+                "Content-Type: text/plain\r\nConnection: %s\r\n\r\n",
+                resource.size(), close ? "close" : "keep-alive");
+
+            std::string response(header, headerLen);
+            response += resource;
+
+            for (size_t sent = 0; sent < response.size();) {
+                ssize_t result = send(rConn.fd, response.data() + sent,
+                                      response.size() - sent, MSG_NOSIGNAL);
+                if (result <= 0) {
+                    return false;
+                }
+
+                sent += result;
+            }
+
+            __atomic_add_fetch(&mNumRequests, 1, __ATOMIC_RELEASE);
+            rConn.numServed++;
+
+            if (close || (mMaxPerConn > 0 && rConn.numServed >= mMaxPerConn)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static void* ThreadFunc(void* pArg) {
+        HttpServer* p = static_cast<HttpServer*>(pArg);
+        std::vector<pollfd> fds;
+
+        while (__atomic_load_n(&p->mIsRunning, __ATOMIC_ACQUIRE)) {
+            fds.resize(p->mConnections.size() + 1);
+
+            fds[0].fd = p->mListenFD;
+            fds[0].events = POLLIN;
+            fds[0].revents = 0;
+
+            for (u32 i = 0; i < p->mConnections.size(); i++) {
+                fds[i + 1].fd = p->mConnections[i].fd;
+                fds[i + 1].events = POLLIN;
+                fds[i + 1].revents = 0;
+            }
+
+            if (poll(fds.data(), fds.size(), 10) <= 0) {
+                continue;
+            }
+
+            // Connections which are closed are removed from the back
+            for (u32 i = p->mConnections.size(); i > 0; i--) {
+                if (fds[i].revents == 0) {
+                    continue;
+                }
+
+                Connection& rConn = p->mConnections[i - 1];
+
+                char buffer[0x1000];
+                ssize_t len = recv(rConn.fd, buffer, sizeof(buffer), 0);
+
+                bool keep = len > 0;
+                if (keep) {
+                    rConn.in.append(buffer, len);
+                    keep = p->Serve(rConn);
+                }
+
+                if (!keep) {
+                    close(rConn.fd);
+                    p->mConnections.erase(p->mConnections.begin() + (i - 1));
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                Connection conn;
+                conn.fd = accept(p->mListenFD, nullptr, nullptr);
+                conn.numServed = 0;
+
+                if (conn.fd >= 0) {
+                    p->mConnections.push_back(conn);
+                    __atomic_add_fetch(&p->mNumConnections, 1,
+                                       __ATOMIC_RELEASE);
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    int mListenFD;    // Listening socket
+    u16 mPort;        // Listening port
+    u32 mMaxPerConn;  // Responses before closing a connection
+    pthread_t mThread; // Server thread
+
+    volatile bool mIsRunning;     // Whether the server thread should run
+    volatile u32 mNumConnections; // Connections accepted
+    volatile u32 mNumRequests;    // Requests served
+
+    std::vector<Connection> mConnections; // Open connections
+};
+
+/**
+ * @brief Gets the resource requested by the specified request
+ */
+kiwi::String GetResource(u32 index) {
+    return kiwi::Format("/item/%lu", index);
+}
+
+/**
+ * @brief Checks the response to the specified request
+ *
+ * @return Error code (EHttpErr_BadResponse if it is the wrong response)
+ */
+kiwi::EHttpErr CheckResponse(const kiwi::HttpResponse& rResp, u32 index) {
+    if (rResp.error != kiwi::EHttpErr_Success) {
+        return rResp.error;
+    }
+
+    return rResp.status == kiwi::EHttpStatus_OK &&
+                   rResp.body == GetResource(index)
+               ? kiwi::EHttpErr_Success
+               : kiwi::EHttpErr_BadResponse;
+}
+
+/**
+ * @brief Sends a synchronous GET request and checks the response
+ *
+ * @return Error code
+ */
+kiwi::EHttpErr SendSync(const HttpServer& rServer, u32 index,
+                        bool keepAlive) {
+    kiwi::HttpRequest request("127.0.0.1", rServer.GetPort());
+    request.SetKeepAlive(keepAlive);
+    request.SetURI(GetResource(index));
+
+    return CheckResponse(request.Send(), index);
+}
+
+/**
+ * @brief Asynchronous requests in flight
+ */
+struct AsyncBatch {
+    AsyncBatch(u32 num)
+        : numRequests(num),
+          numSent(0),
+          numDone(0),
+          numError(0),
+          numCantConnect(0),
+          ppRequests(new kiwi::HttpRequest*[num]) {}
+
+    ~AsyncBatch() {
+        for (u32 i = 0; i < numSent; i++) {
+            delete ppRequests[i];
+        }
+
+        delete[] ppRequests;
+    }
+
+    u32 numRequests;                // Number of requests to send
+    u32 numSent;                    // Number of requests sent
+    volatile u32 numDone;           // Number of requests completed
+    volatile u32 numError;          // Number of requests failed
+    volatile u32 numCantConnect;    // Number of connections which failed
+    kiwi::HttpRequest** ppRequests; // Requests
+};
+
+/**
+ * @brief Async request argument
+ */
+struct AsyncArg {
+    AsyncBatch* pBatch; // Request batch
+    u32 index;          // Request index
+};
+
+/**
+ * @brief Async response callback
+ */
+void ResponseFunc(const kiwi::HttpResponse& rResp, void* pArg) {
+    AsyncArg* pAsyncArg = static_cast<AsyncArg*>(pArg);
+    AsyncBatch* pBatch = pAsyncArg->pBatch;
+
+    kiwi::EHttpErr error = CheckResponse(rResp, pAsyncArg->index);
+    delete pAsyncArg;
+
+    if (error != kiwi::EHttpErr_Success) {
+        __atomic_add_fetch(&pBatch->numError, 1, __ATOMIC_RELEASE);
+    }
+    if (error == kiwi::EHttpErr_CantConnect) {
+        __atomic_add_fetch(&pBatch->numCantConnect, 1, __ATOMIC_RELEASE);
+    }
+
+    __atomic_add_fetch(&pBatch->numDone, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Sends asynchronous GET requests, keeping several in flight
+ *
+ * @param rServer HTTP server
+ * @param rBatch Request batch
+ * @param keepAlive Whether to use pooled connections
+ * @param window Largest number of requests in flight
+ * @return Success (false if timed out)
+ */
+bool SendAsync(const HttpServer& rServer, AsyncBatch& rBatch, bool keepAlive,
+               u32 window) {
+    u64 start = host::GetNanoTime();
+
+    while (__atomic_load_n(&rBatch.numDone, __ATOMIC_ACQUIRE) <
+           rBatch.numRequests) {
+
+        if (rBatch.numSent < rBatch.numRequests &&
+            rBatch.numSent - rBatch.numDone < window) {
+
+            u32 i = rBatch.numSent++;
+
+            kiwi::HttpRequest* pRequest =
+                new kiwi::HttpRequest("127.0.0.1", rServer.GetPort());
+            pRequest->SetKeepAlive(keepAlive);
+            pRequest->SetURI(GetResource(i));
+            rBatch.ppRequests[i] = pRequest;
+
+            AsyncArg* pArg = new AsyncArg;
+            pArg->pBatch = &rBatch;
+            pArg->index = i;
+
+            pRequest->SendAsync(ResponseFunc, pArg);
+            continue;
+        }
+
+        if (host::GetNanoTime() - start > scTimeoutNsec) {
+            return false;
+        }
+
+        usleep(50);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parses a whole response in one piece
+ *
+ * @param pData Response data
+ * @param rResp Response to fill in
+ * @param maxBody Size limit for stored bodies
+ * @param close Whether the server closes the connection afterwards
+ * @return Whether the response was complete and well-formed
+ */
+bool ParseResponse(
+    const char* pData, kiwi::HttpResponse& rResp,
+    u32 maxBody = kiwi::HttpResponseParser::DEFAULT_MAX_BODY_SIZE,
+    bool close = false) {
+    kiwi::HttpResponseParser parser(rResp);
+    parser.SetMaxBodySize(maxBody);
+
+    u32 used = 0;
+    if (!parser.Parse(pData, std::strlen(pData), used)) {
+        return false;
+    }
+
+    return close ? parser.Close() : parser.IsDone();
+}
+
+/**
+ * @brief Counts body data passed to a callback
+ */
+void CountBodyFunc(const void* pData, u32 size, void* pArg) {
+    *static_cast<u32*>(pArg) += size;
+}
+
+void TestContentLength() {
+    kiwi::HttpResponse resp;
+    HOST_CHECK(ParseResponse("HTTP/1.1 200 OK\r\n"
+                             "Content-Length: 5\r\n\r\nhello",
+                             resp));
+    HOST_CHECK(resp.body == "hello");
+
+    // Anything but digits is malformed, rather than read as zero
+    const char* bad[] = {"", "abc", "5x", "-1", "+5", "0x10", "4294967296"};
+
+    for (u32 i = 0; i < LENGTHOF(bad); i++) {
+        kiwi::String data = "HTTP/1.1 200 OK\r\nContent-Length: ";
+        data += bad[i];
+        data += "\r\n\r\nhello";
+
+        kiwi::HttpResponse bad;
+        HOST_CHECK(!ParseResponse(data, bad));
+    }
+
+    // Repeated fields must agree
+    kiwi::HttpResponse same;
+    HOST_CHECK(ParseResponse("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n"
+                             "Content-Length: 2\r\n\r\nok",
+                             same));
+
+    kiwi::HttpResponse conflict;
+    HOST_CHECK(!ParseResponse("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n"
+                              "Content-Length: 3\r\n\r\nok!",
+                              conflict));
+}
+
+void TestMaxBodySize() {
+    // Announced length is rejected before any body arrives (or is reserved)
+    host::AllocStats before = host::GetAllocStats();
+
+    kiwi::HttpResponse huge;
+    HOST_CHECK(!ParseResponse("HTTP/1.1 200 OK\r\n"
+                              "Content-Length: 4000000000\r\n\r\n",
+                              huge));
+
+    HOST_CHECK(host::GetAllocStats().numBytes - before.numBytes < 4096);
+
+    kiwi::HttpResponse fits;
+    HOST_CHECK(ParseResponse("HTTP/1.1 200 OK\r\n"
+                             "Content-Length: 4\r\n\r\nabcd",
+                             fits, 4));
+
+    kiwi::HttpResponse over;
+    HOST_CHECK(!ParseResponse("HTTP/1.1 200 OK\r\n"
+                              "Content-Length: 5\r\n\r\nabcde",
+                              over, 4));
+
+    // Chunked bodies are limited as a whole, and by each chunk size
+    const char* pChunked = "HTTP/1.1 200 OK\r\n"
+                           "Transfer-Encoding: chunked\r\n\r\n"
+                           "3\r\nabc\r\n3\r\ndef\r\n0\r\n\r\n";
+
+    kiwi::HttpResponse chunked;
+    HOST_CHECK(ParseResponse(pChunked, chunked, 6));
+    HOST_CHECK(chunked.body == "abcdef");
+
+    kiwi::HttpResponse chunkedOver;
+    HOST_CHECK(!ParseResponse(pChunked, chunkedOver, 5));
+
+    kiwi::HttpResponse chunkHuge;
+    HOST_CHECK(!ParseResponse("HTTP/1.1 200 OK\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n"
+                              "FFFFFFF\r\n",
+                              chunkHuge));
+
+    // Close-delimited bodies are limited as they arrive
+    const char* pUntilClose = "HTTP/1.1 200 OK\r\n"
+                              "Connection: close\r\n\r\n"
+                              "0123456789";
+
+    kiwi::HttpResponse untilClose;
+    HOST_CHECK(ParseResponse(pUntilClose, untilClose, 10, true));
+    HOST_CHECK(untilClose.body == "0123456789");
+
+    kiwi::HttpResponse untilCloseOver;
+    HOST_CHECK(!ParseResponse(pUntilClose, untilCloseOver, 9, true));
+
+    // Bodies passed to a callback aren't stored, so they aren't limited
+    kiwi::HttpResponse streamed;
+    kiwi::HttpResponseParser parser(streamed);
+    parser.SetMaxBodySize(4);
+
+    u32 num = 0;
+    parser.SetBodyCallback(CountBodyFunc, &num);
+
+    const char* pData = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n"
+                        "0123456789";
+
+    u32 used = 0;
+    HOST_CHECK(parser.Parse(pData, std::strlen(pData), used));
+    HOST_CHECK(parser.IsDone());
+    HOST_CHECK_EQ(num, 10);
+}
+
+/**
+ * @brief Starts a test with an empty pool and default settings
+ */
+void ResetPool() {
+    kiwi::HttpConnectionPool& rPool = kiwi::HttpConnectionPool::GetInstance();
+
+    rPool.Clear();
+    rPool.ResetStats();
+    rPool.SetMaxConnections(kiwi::HttpConnectionPool::DEFAULT_MAX_CONNECTIONS);
+    rPool.SetMaxPipeline(kiwi::HttpConnectionPool::DEFAULT_MAX_PIPELINE);
+    rPool.SetIdleTimeOut(kiwi::HttpConnectionPool::DEFAULT_IDLE_TIMEOUT);
+}
+
+void TestUnpooled() {
+    HttpServer server;
+    ResetPool();
+
+    for (u32 i = 0; i < 10; i++) {
+        HOST_CHECK_EQ(SendSync(server, i, false), kiwi::EHttpErr_Success);
+    }
+
+    // Connection per request
+    HOST_CHECK_EQ(server.GetNumConnections(), 10);
+    HOST_CHECK_EQ(kiwi::HttpConnectionPool::GetInstance().GetStats().numConnects,
+                  0);
+}
+
+void TestPooled() {
+    HttpServer server;
+    ResetPool();
+
+    for (u32 i = 0; i < 10; i++) {
+        HOST_CHECK_EQ(SendSync(server, i, true), kiwi::EHttpErr_Success);
+    }
+
+    HOST_CHECK_EQ(server.GetNumConnections(), 1);
+
+    kiwi::HttpConnectionPool::Stats stats =
+        kiwi::HttpConnectionPool::GetInstance().GetStats();
+    HOST_CHECK_EQ(stats.numConnects, 1);
+    HOST_CHECK_EQ(stats.numReuses, 9);
+
+    ResetPool();
+}
+
+void TestPipelined() {
+    HttpServer server;
+    ResetPool();
+
+    // All queued at once, so they must share the connections
+    AsyncBatch batch(32);
+    HOST_CHECK(SendAsync(server, batch, true, batch.numRequests));
+    HOST_CHECK_EQ(batch.numError, 0);
+
+    HOST_CHECK(server.GetNumConnections() <=
+               kiwi::HttpConnectionPool::DEFAULT_MAX_CONNECTIONS);
+    HOST_CHECK_EQ(server.GetNumRequests(), batch.numRequests);
+
+    kiwi::HttpConnectionPool::Stats stats =
+        kiwi::HttpConnectionPool::GetInstance().GetStats();
+    HOST_CHECK(stats.numPipelined > 0);
+
+    ResetPool();
+}
+
+void TestRetry() {
+    // Server closes each connection after one response, without saying so
+    HttpServer server(1);
+    ResetPool();
+
+    // Requests after the first find a closed connection, and are sent again
+    for (u32 i = 0; i < 5; i++) {
+        HOST_CHECK_EQ(SendSync(server, i, true), kiwi::EHttpErr_Success);
+    }
+
+    kiwi::HttpConnectionPool::Stats stats =
+        kiwi::HttpConnectionPool::GetInstance().GetStats();
+    HOST_CHECK(stats.numRetries > 0);
+    HOST_CHECK_EQ(server.GetNumRequests(), 5);
+
+    ResetPool();
+}
+
+void TestEviction() {
+    HttpServer server;
+    ResetPool();
+
+    kiwi::HttpConnectionPool& rPool = kiwi::HttpConnectionPool::GetInstance();
+    rPool.SetIdleTimeOut(10);
+
+    HOST_CHECK_EQ(SendSync(server, 0, true), kiwi::EHttpErr_Success);
+
+    // Not idle for long enough yet
+    rPool.AfterCalculate(nullptr);
+    HOST_CHECK_EQ(rPool.GetStats().numEvicted, 0);
+
+    usleep(30 * 1000);
+    rPool.AfterCalculate(nullptr);
+    HOST_CHECK_EQ(rPool.GetStats().numEvicted, 1);
+
+    // Next request needs a new connection
+    HOST_CHECK_EQ(SendSync(server, 1, true), kiwi::EHttpErr_Success);
+    HOST_CHECK_EQ(rPool.GetStats().numConnects, 2);
+    HOST_CHECK_EQ(server.GetNumConnections(), 2);
+
+    ResetPool();
+}
+
+/**
+ * @brief Reports requests which couldn't connect
+ * @details Unpooled requests bind a random local port for every connection.
+ * Once thousands of connections have been closed, new ones start to pick
+ * ports which are still in TIME_WAIT, and the host refuses to connect them.
+ */
+void PrintConnectFailures(u32 num) {
+    if (num > 0) {
+        std::printf("%-40s %10lu (local port in TIME_WAIT)\n",
+                    "  connect failures", num);
+    }
+}
+
+/**
+ * @brief Measures synchronous requests per second
+ */
+void BenchSync(bool keepAlive, u32 num) {
+    HttpServer server;
+    ResetPool();
+
+    u32 numError = 0;
+    u32 numCantConnect = 0;
+
+    u64 start = host::GetNanoTime();
+
+    for (u32 i = 0; i < num; i++) {
+        kiwi::EHttpErr error = SendSync(server, i, keepAlive);
+
+        numError += error != kiwi::EHttpErr_Success;
+        numCantConnect += error == kiwi::EHttpErr_CantConnect;
+    }
+
+    double seconds = (host::GetNanoTime() - start) / 1e9;
+
+    // See PrintConnectFailures
+    HOST_CHECK_EQ(numError, numCantConnect);
+    HOST_CHECK(keepAlive ? numError == 0 : numError < num / 4);
+
+    std::printf("sync  %-10s                      %8.0f req/s  "
+                "%6.1f us/req  %5lu connections\n",
+                keepAlive ? "pooled" : "unpooled", num / seconds,
+                seconds * 1e6 / num, server.GetNumConnections());
+
+    PrintConnectFailures(numCantConnect);
+
+    ResetPool();
+}
+
+/**
+ * @brief Measures asynchronous requests per second
+ */
+void BenchAsync(bool keepAlive, u32 window, u32 num) {
+    HttpServer server;
+    ResetPool();
+
+    AsyncBatch batch(num);
+
+    u64 start = host::GetNanoTime();
+    HOST_CHECK(SendAsync(server, batch, keepAlive, window));
+    double seconds = (host::GetNanoTime() - start) / 1e9;
+
+    // See PrintConnectFailures
+    HOST_CHECK_EQ(batch.numError, batch.numCantConnect);
+    HOST_CHECK(keepAlive ? batch.numError == 0 : batch.numError < num / 4);
+
+    kiwi::HttpConnectionPool::Stats stats =
+        kiwi::HttpConnectionPool::GetInstance().GetStats();
+
+    std::printf("async %-10s %2lu in flight        %8.0f req/s  "
+                "%6.1f us/req  %5lu connections  %5lu pipelined\n",
+                keepAlive ? "pooled" : "unpooled", window, num / seconds,
+                seconds * 1e6 / num, server.GetNumConnections(),
+                stats.numPipelined);
+
+    PrintConnectFailures(batch.numCantConnect);
+
+    ResetPool();
+}
+
+void BenchHttp() {
+    BenchSync(false, 2000);
+    BenchSync(true, 2000);
+
+    BenchAsync(false, 8, 2000);
+    BenchAsync(true, 1, 2000);
+    BenchAsync(true, 8, 2000);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+
+    host::Run("HttpResponseParser Content-Length", TestContentLength);
+    host::Run("HttpResponseParser body size limit", TestMaxBodySize);
+    host::Run("HttpRequest without pooling", TestUnpooled);
+    host::Run("HttpConnectionPool reuse", TestPooled);
+    host::Run("HttpConnectionPool pipelining", TestPipelined);
+    host::Run("HttpConnectionPool retry after server close", TestRetry);
+    host::Run("HttpConnectionPool idle eviction", TestEviction);
+
+    if (host::IsBench(argc, argv)) {
+        BenchHttp();
+    }
+
+    return host::Finish();
+}
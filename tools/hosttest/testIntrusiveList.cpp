@@ -0,0 +1,221 @@
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+/**
+ * TIntrusiveList tests, and benchmarks against TList (insert, iterate,
+ * erase).
+ */
+
+namespace {
+
+/**
+ * @brief List element
+ */
+struct Elem {
+    explicit Elem(u32 _value = 0) : value(_value) {}
+
+    u32 value;                    // Element value
+    kiwi::IntrusiveListNode node; // Intrusive list node
+};
+
+typedef kiwi::TIntrusiveList<Elem, &Elem::node> ElemList;
+
+void TestOrder() {
+    Elem elems[4];
+    ElemList list;
+
+    for (u32 i = 0; i < LENGTHOF(elems); i++) {
+        elems[i].value = i;
+    }
+
+    list.PushBack(&elems[1]);
+    list.PushBack(&elems[2]);
+    list.PushFront(&elems[0]);
+    list.Insert(list.End(), &elems[3]);
+
+    HOST_CHECK_EQ(list.Size(), 4);
+    HOST_CHECK_EQ(list.Front().value, 0);
+    HOST_CHECK_EQ(list.Back().value, 3);
+
+    u32 expected = 0;
+    K_FOREACH (list) {
+        HOST_CHECK_EQ(it->value, expected++);
+    }
+
+    HOST_CHECK_EQ(expected, 4);
+
+    list.PopFront();
+    list.PopBack();
+    HOST_CHECK_EQ(list.Size(), 2);
+    HOST_CHECK_EQ(list.Front().value, 1);
+    HOST_CHECK(!elems[0].node.IsLinked());
+    HOST_CHECK(!elems[3].node.IsLinked());
+
+    list.Clear();
+    HOST_CHECK(list.Empty());
+    HOST_CHECK(!elems[1].node.IsLinked());
+}
+
+void TestUnlink() {
+    ElemList list;
+    Elem a(1), b(2), c(3);
+
+    list.PushBack(&a);
+    list.PushBack(&b);
+    list.PushBack(&c);
+
+    // Self-unlink without the list
+    b.node.Unlink();
+    HOST_CHECK(!b.node.IsLinked());
+    HOST_CHECK(!list.Contains(&b));
+    HOST_CHECK_EQ(list.Size(), 2);
+
+    list.Remove(&a);
+    HOST_CHECK_EQ(list.Size(), 1);
+    HOST_CHECK_EQ(list.Front().value, 3);
+
+    {
+        Elem d(4);
+        list.PushBack(&d);
+        HOST_CHECK_EQ(list.Size(), 2);
+    }
+
+    // Destroyed elements unlink themselves
+    HOST_CHECK_EQ(list.Size(), 1);
+    HOST_CHECK_EQ(list.Back().value, 3);
+}
+
+void TestEraseWhileIterating() {
+    Elem elems[10];
+    ElemList list;
+
+    for (u32 i = 0; i < LENGTHOF(elems); i++) {
+        elems[i].value = i;
+        list.PushBack(&elems[i]);
+    }
+
+    for (ElemList::Iterator it = list.Begin(); it != list.End();) {
+        if (it->value % 2 == 0) {
+            it = list.Erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    HOST_CHECK_EQ(list.Size(), 5);
+
+    u32 expected = 1;
+    K_FOREACH (list) {
+        HOST_CHECK_EQ(it->value, expected);
+        expected += 2;
+    }
+}
+
+void BenchTList(Elem* pElems, u32 num, u32 rounds) {
+    kiwi::TList<Elem> list;
+    u64 sum = 0;
+
+    host::Bench bench("TList push/iterate/pop");
+
+    for (u32 r = 0; r < rounds; r++) {
+        for (u32 i = 0; i < num; i++) {
+            list.PushBack(&pElems[i]);
+        }
+
+        K_FOREACH (list) {
+            sum += it->value;
+        }
+
+        while (!list.Empty()) {
+            list.PopFront();
+        }
+    }
+
+    host::Consume(&sum);
+    bench.Report(static_cast<u64>(num) * rounds);
+}
+
+void BenchIntrusiveList(Elem* pElems, u32 num, u32 rounds) {
+    ElemList list;
+    u64 sum = 0;
+
+    host::Bench bench("TIntrusiveList push/iterate/pop");
+
+    for (u32 r = 0; r < rounds; r++) {
+        for (u32 i = 0; i < num; i++) {
+            list.PushBack(&pElems[i]);
+        }
+
+        K_FOREACH (list) {
+            sum += it->value;
+        }
+
+        while (!list.Empty()) {
+            list.PopFront();
+        }
+    }
+
+    host::Consume(&sum);
+    bench.Report(static_cast<u64>(num) * rounds);
+}
+
+void BenchTListRemove(Elem* pElems, u32 num) {
+    kiwi::TList<Elem> list;
+
+    for (u32 i = 0; i < num; i++) {
+        list.PushBack(&pElems[i]);
+    }
+
+    host::Bench bench("TList Remove (middle out)");
+
+    // TList has to search for the element
+    for (u32 i = 0; i < num; i++) {
+        list.Remove(&pElems[(i + num / 2) % num]);
+    }
+
+    bench.Report(num);
+}
+
+void BenchIntrusiveListRemove(Elem* pElems, u32 num) {
+    ElemList list;
+
+    for (u32 i = 0; i < num; i++) {
+        list.PushBack(&pElems[i]);
+    }
+
+    host::Bench bench("TIntrusiveList Remove (middle out)");
+
+    for (u32 i = 0; i < num; i++) {
+        list.Remove(&pElems[(i + num / 2) % num]);
+    }
+
+    bench.Report(num);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("TIntrusiveList order", TestOrder);
+    host::Run("TIntrusiveList unlink", TestUnlink);
+    host::Run("TIntrusiveList erase while iterating", TestEraseWhileIterating);
+
+    if (host::IsBench(argc, argv)) {
+        const u32 num = 1000;
+        const u32 rounds = 1000;
+
+        Elem* pElems = new Elem[num];
+        for (u32 i = 0; i < num; i++) {
+            pElems[i].value = i;
+        }
+
+        BenchTList(pElems, num, rounds);
+        BenchIntrusiveList(pElems, num, rounds);
+        BenchTListRemove(pElems, num);
+        BenchIntrusiveListRemove(pElems, num);
+
+        delete[] pElems;
+    }
+
+    return host::Finish();
+}
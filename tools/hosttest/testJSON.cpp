@@ -0,0 +1,210 @@
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <cstring>
+
+/**
+ * json::Document tests, and parse benchmarks against json::Reader (time and
+ * heap allocations per parse).
+ */
+
+namespace {
+
+const char scSample[] =
+    "{\n"
+    "  \"name\": \"kiwi\",\n"
+    "  \"escaped\": \"a\\\"b\\\\c\\n\\u00e9\\u3042\",\n"
+    "  \"int\": 42,\n"
+    "  \"neg\": -17,\n"
+    "  \"frac\": 3.25,\n"
+    "  \"exp\": -1.5e3,\n"
+    "  \"yes\": true,\n"
+    "  \"no\": false,\n"
+    "  \"nothing\": null,\n"
+    "  \"list\": [1, \"two\", [3], {\"four\": 4}],\n"
+    "  \"empty\": {}\n"
+    "}";
+
+/**
+ * @brief Tests whether a string view views the specified buffer
+ */
+bool IsInside(const kiwi::StringView& rStr, const char* pBuffer, u32 size) {
+    return rStr.Data() >= pBuffer &&
+           rStr.Data() + rStr.Length() <= pBuffer + size;
+}
+
+void TestDocument() {
+    kiwi::json::Document doc;
+    HOST_CHECK(doc.Parse(scSample, std::strlen(scSample)));
+
+    const kiwi::json::Value& rRoot = doc.Get();
+    HOST_CHECK_EQ(rRoot.GetType(), kiwi::json::Element::EType_Object);
+    HOST_CHECK_EQ(rRoot.Size(), 11);
+
+    HOST_CHECK(rRoot["name"].GetString() == "kiwi");
+    HOST_CHECK_EQ(rRoot["int"].GetNumber(), 42.0);
+    HOST_CHECK_EQ(rRoot["neg"].GetNumber(), -17.0);
+    HOST_CHECK_EQ(rRoot["frac"].GetNumber(), 3.25);
+    HOST_CHECK_EQ(rRoot["exp"].GetNumber(), -1500.0);
+    HOST_CHECK_EQ(rRoot["yes"].GetBoolean(), true);
+    HOST_CHECK_EQ(rRoot["no"].GetBoolean(), false);
+    HOST_CHECK(rRoot["nothing"].IsNull());
+    HOST_CHECK(rRoot["missing"].IsUndefined());
+    HOST_CHECK(rRoot["missing"]["chained"].IsUndefined());
+    HOST_CHECK_EQ(rRoot["empty"].Size(), 0);
+
+    const kiwi::json::Value& rList = rRoot["list"];
+    HOST_CHECK_EQ(rList.Size(), 4);
+    HOST_CHECK_EQ(rList[0].GetNumber(), 1.0);
+    HOST_CHECK(rList[1].GetString() == "two");
+    HOST_CHECK_EQ(rList[2][0].GetNumber(), 3.0);
+    HOST_CHECK_EQ(rList[3]["four"].GetNumber(), 4.0);
+
+    // Escapes are decoded into the arena (UTF-8)
+    kiwi::StringView escaped = rRoot["escaped"].GetString();
+    HOST_CHECK(escaped == "a\"b\\c\n\xC3\xA9\xE3\x81\x82");
+    HOST_CHECK(!IsInside(escaped, scSample, sizeof(scSample)));
+
+    // Everything else is zero-copy
+    HOST_CHECK(IsInside(rRoot["name"].GetString(), scSample, sizeof(scSample)));
+    HOST_CHECK(IsInside(rList[1].GetString(), scSample, sizeof(scSample)));
+    HOST_CHECK(IsInside(rRoot[0u].GetKey(), scSample, sizeof(scSample)));
+}
+
+void TestMatchesReader() {
+    kiwi::json::Reader reader;
+    reader.Decode(scSample, std::strlen(scSample));
+
+    kiwi::json::Document doc;
+    HOST_CHECK(doc.Parse(scSample, std::strlen(scSample)));
+
+    kiwi::json::Element converted;
+    doc.Get().ToElement(converted);
+
+    const kiwi::json::Element& rExpected = reader.Get();
+    HOST_CHECK_EQ(converted.GetType(), rExpected.GetType());
+
+    // json::Reader doesn't decode escape sequences, so "escaped" is left out
+    const char* keys[] = {"name", "int", "neg", "frac", "exp"};
+    for (u32 i = 0; i < LENGTHOF(keys); i++) {
+        const kiwi::json::Element& rA = converted[kiwi::String(keys[i])];
+        const kiwi::json::Element& rB = rExpected[kiwi::String(keys[i])];
+
+        HOST_CHECK_EQ(rA.GetType(), rB.GetType());
+
+        if (rA.GetType() == kiwi::json::Element::EType_String) {
+            HOST_CHECK(rA.Get<kiwi::String>() == rB.Get<kiwi::String>());
+        } else {
+            HOST_CHECK_EQ(rA.Get<f64>(), rB.Get<f64>());
+        }
+    }
+}
+
+void TestInvalid() {
+    const char* inputs[] = {
+        "",           "{",       "[1, 2",   "{\"a\" 1}", "[01]",
+        "\"\\x\"",    "tru",     "[1,]",    "{\"a\":}",  "\"\\u12\"",
+        "[1] trailing", "-",     "1.",      "1e",
+    };
+
+    for (u32 i = 0; i < LENGTHOF(inputs); i++) {
+        kiwi::json::Document doc;
+
+        if (doc.Parse(inputs[i], std::strlen(inputs[i]))) {
+            std::fprintf(stderr, "  accepted invalid input: %s\n", inputs[i]);
+            HOST_CHECK(false);
+        }
+
+        HOST_CHECK(doc.Get().IsUndefined());
+    }
+}
+
+/**
+ * @brief Builds a config-like JSON document
+ *
+ * @param numEntries Number of array entries
+ * @param[out] rSize Document size
+ */
+char* MakeConfig(u32 numEntries, u32& rSize) {
+    u32 capacity = numEntries * 256 + 64;
+    char* pBuffer = new char[capacity];
+    u32 size = 0;
+
+    size += std::snprintf(pBuffer + size, capacity - size,
+                          "{\"version\": 3, \"entries\": [\n");
+
+    for (u32 i = 0; i < numEntries; i++) {
+        size += std::snprintf(
+            pBuffer + size, capacity - size,
+            "  {\"id\": %lu, \"name\": \"entry_%lu\", \"scale\": %lu.%02lu, "
+            "\"enabled\": %s, \"tags\": [\"a\", \"b\", \"c\"], "
+            "\"pos\": {\"x\": -%lu.5, \"y\": %lue2, \"z\": 0}}%s\n",
+            i, i, i % 10, i % 100, i % 2 == 0 ? "true" : "false", i, i % 7,
+            i + 1 < numEntries ? "," : "");
+    }
+
+    size += std::snprintf(pBuffer + size, capacity - size, "]}");
+
+    rSize = size;
+    return pBuffer;
+}
+
+void BenchParse() {
+    const u32 rounds = 20;
+
+    u32 size;
+    char* pConfig = MakeConfig(2500, size);
+    std::printf("Config size: %lu KB\n", size / 1024);
+
+    {
+        host::AllocStats before = host::GetAllocStats();
+        host::Bench bench("json::Reader parse (per KB)");
+
+        for (u32 i = 0; i < rounds; i++) {
+            kiwi::json::Reader reader;
+            reader.Decode(pConfig, size);
+            HOST_CHECK(reader.Get().IsValid());
+        }
+
+        bench.Report(static_cast<u64>(size / 1024) * rounds);
+
+        host::AllocStats after = host::GetAllocStats();
+        std::printf("%-40s %10llu allocs %10llu KB\n", "  per parse",
+                    (after.numAllocs - before.numAllocs) / rounds,
+                    (after.numBytes - before.numBytes) / rounds / 1024);
+    }
+
+    {
+        host::AllocStats before = host::GetAllocStats();
+        host::Bench bench("json::Document parse (per KB)");
+
+        for (u32 i = 0; i < rounds; i++) {
+            kiwi::json::Document doc;
+            HOST_CHECK(doc.Parse(pConfig, size));
+        }
+
+        bench.Report(static_cast<u64>(size / 1024) * rounds);
+
+        host::AllocStats after = host::GetAllocStats();
+        std::printf("%-40s %10llu allocs %10llu KB\n", "  per parse",
+                    (after.numAllocs - before.numAllocs) / rounds,
+                    (after.numBytes - before.numBytes) / rounds / 1024);
+    }
+
+    delete[] pConfig;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("json::Document values", TestDocument);
+    host::Run("json::Document matches json::Reader", TestMatchesReader);
+    host::Run("json::Document invalid input", TestInvalid);
+
+    if (host::IsBench(argc, argv)) {
+        BenchParse();
+    }
+
+    return host::Finish();
+}
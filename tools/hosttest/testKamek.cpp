@@ -0,0 +1,610 @@
+#include "host/hostKamek.h"
+#include "host/hostTest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * Kamek loader tests and benchmarks (legacy against grouped relocations).
+ *
+ * Modules are generated with a similar mix of relocations to a real one. Real
+ * binaries can be replayed as well, see "make bench-kamek" in the Makefile.
+ */
+
+namespace {
+
+// Relocation commands (see kamekLoader.cpp)
+enum {
+    kAddr32 = 1,
+    kAddr16Lo = 4,
+    kAddr16Hi = 5,
+    kAddr16Ha = 6,
+    kRel24 = 10,
+    kWrite32 = 32,
+    kCondWritePointer = 35,
+    kBranch = 64,
+    kBranchLink = 65,
+};
+
+// Header flag for grouped relocations (version 3+)
+const u32 scFlagGroupedRelocs = 1 << 0;
+
+// Relative address which signals that an absolute address follows
+const u32 scAbsoluteAddress = 0xFFFFFE;
+
+const u32 scHeaderSize = 32;
+const u32 scCacheLineSize = 32;
+
+// Loader words (u32 is wider on the host)
+const u32 scWordSize = 4;
+
+//! Game code which generated modules patch
+const u32 scGameCodeStart = 0x80004000;
+const u32 scGameCodeEnd = 0x80400000;
+
+/**
+ * @brief Relocation command
+ * @details Addresses and arguments use the loader's encoding, where values
+ * with the high bit set are absolute and the rest are relative to the module
+ */
+struct Reloc {
+    u32 cmd;     // Command
+    u32 address; // Patch address
+    u32 args[2]; // Arguments
+    u32 numArgs; // Number of arguments
+
+    bool operator<(const Reloc& rOther) const {
+        return cmd != rOther.cmd ? cmd < rOther.cmd
+                                 : address < rOther.address;
+    }
+
+    bool IsAbsolute() const {
+        return (address & 0x80000000) != 0;
+    }
+};
+
+/**
+ * @brief Kamek module before it is encoded
+ */
+struct Module {
+    std::vector<u32> code;     // Module code
+    u32 bssSize;               // Module BSS size
+    std::vector<Reloc> relocs; // Relocations, in the order Kamek writes them
+};
+
+/**
+ * @brief Deterministic random numbers (xorshift)
+ */
+class Random {
+public:
+    explicit Random(u32 seed) : mState(seed) {}
+
+    u32 Next() {
+        mState ^= mState << 13;
+        mState ^= mState >> 17;
+        mState ^= mState << 5;
+        return mState;
+    }
+
+    u32 Next(u32 max) {
+        return Next() % max;
+    }
+
+private:
+    std::uint32_t mState; // Generator state
+};
+
+/**
+ * @brief Appends a big endian word
+ *
+ * @param rData Binary data
+ * @param word Word value
+ */
+void PutWord(std::vector<u8>& rData, u32 word) {
+    rData.push_back(word >> 24 & 0xFF);
+    rData.push_back(word >> 16 & 0xFF);
+    rData.push_back(word >> 8 & 0xFF);
+    rData.push_back(word & 0xFF);
+}
+
+/**
+ * @brief Makes a relocation
+ *
+ * @param cmd Command
+ * @param address Patch address
+ * @param arg0 First argument
+ * @param arg1 Second argument (CondWrite commands)
+ */
+Reloc MakeReloc(u32 cmd, u32 address, u32 arg0, u32 arg1 = 0) {
+    u32 numArgs = cmd == kCondWritePointer ? 2 : 1;
+
+    Reloc r = {cmd, address, {arg0, arg1}, numArgs};
+    return r;
+}
+
+/**
+ * @brief Generates a module with a similar mix of relocations to a real one
+ * @details Module code references its own data (Addr32 in tables, Addr16
+ * pairs in code) and calls into the game (Rel24). The game is patched with
+ * hooks (Branch/BranchLink), and with runs of Write32/Addr32 for tables.
+ *
+ * @param numModuleRelocs Number of relocations inside the module
+ * @param numGamePatches Number of game code patches
+ */
+Module MakeModule(u32 numModuleRelocs, u32 numGamePatches) {
+    Random rand(0x4B616D65);
+    Module module;
+
+    module.code.resize(numModuleRelocs * 4);
+    module.bssSize = 0x10000;
+
+    for (u32 i = 0; i < module.code.size(); i++) {
+        module.code[i] = 0x38600000 | (i & 0xFFFF); // li r3, x
+    }
+
+    u32 textSize = module.code.size() * scWordSize + module.bssSize;
+
+    // Module relocations are written in address order
+    for (u32 i = 0; i < module.code.size() - 1 &&
+                    module.relocs.size() < numModuleRelocs;
+         i += 1 + rand.Next(5)) {
+        u32 address = i * scWordSize;
+        u32 local = rand.Next(textSize) & ~3;
+        u32 game = scGameCodeStart + (rand.Next(scGameCodeEnd -
+                                                scGameCodeStart) & ~3);
+
+        switch (rand.Next(4)) {
+        case 0:
+            module.relocs.push_back(MakeReloc(kAddr32, address, local));
+            break;
+
+        case 1:
+            module.code[i] = 0x48000001; // bl
+            module.relocs.push_back(MakeReloc(kRel24, address, game));
+            break;
+
+        default:
+            // lis/addi pair, which can't be split across the last word
+            module.relocs.push_back(MakeReloc(kAddr16Ha, address + 2, local));
+            module.relocs.push_back(
+                MakeReloc(kAddr16Lo, address + 2 + scWordSize, local));
+            i++;
+            break;
+        }
+    }
+
+    // Game patches can't overlap, so pick from a shuffled list of words
+    std::vector<u32> words((scGameCodeEnd - scGameCodeStart) / 64);
+    for (u32 i = 0; i < words.size(); i++) {
+        words[i] = scGameCodeStart + i * 64;
+    }
+
+    for (u32 i = words.size() - 1; i > 0; i--) {
+        std::swap(words[i], words[rand.Next(i + 1)]);
+    }
+
+    // Game patches are written in declaration order
+    for (u32 i = 0, n = 0; n < numGamePatches && i < words.size(); i++) {
+        u32 address = words[i];
+        u32 func = rand.Next(module.code.size()) * scWordSize;
+
+        switch (rand.Next(8)) {
+        case 0:
+        case 1:
+        case 2: {
+            module.relocs.push_back(MakeReloc(kBranch, address, func));
+            n++;
+            break;
+        }
+
+        case 3:
+        case 4: {
+            module.relocs.push_back(MakeReloc(kBranchLink, address, func));
+            n++;
+            break;
+        }
+
+        case 5: {
+            // Half of the conditional writes find what they expect
+            u32 original = host::GetKamekInitialWord(address);
+            if (rand.Next(2) == 0) {
+                original ^= 1;
+            }
+
+            module.relocs.push_back(
+                MakeReloc(kCondWritePointer, address, func, original));
+            n++;
+            break;
+        }
+
+        default: {
+            // Tables (up to one cache line each)
+            u32 cmd = rand.Next(2) == 0 ? kWrite32 : kAddr32;
+            u32 num = 1 + rand.Next(8);
+
+            for (u32 j = 0; j < num && n < numGamePatches; j++, n++) {
+                u32 arg = cmd == kWrite32 ? rand.Next() : func;
+                module.relocs.push_back(
+                    MakeReloc(cmd, address + j * scWordSize, arg));
+            }
+            break;
+        }
+        }
+    }
+
+    return module;
+}
+
+/**
+ * @brief Encodes a module as a Kamek binary (big endian, like the console)
+ *
+ * @param rModule Module
+ * @param grouped Whether to group relocations by command and address
+ */
+std::vector<u8> Encode(const Module& rModule, bool grouped) {
+    std::vector<u8> data;
+
+    PutWord(data, 0x4B616D65);                        // 'Kame'
+    PutWord(data, 0x6B000000 | (grouped ? 3 : 2));    // 'k\0', version
+    PutWord(data, rModule.bssSize);                   // BSS size
+    PutWord(data, rModule.code.size() * scWordSize); // Code size
+    PutWord(data, 0);                                 // Ctor start
+    PutWord(data, 0);                                 // Ctor end
+    PutWord(data, grouped ? scFlagGroupedRelocs : 0); // Flags
+    PutWord(data, 0);                                 // Padding
+
+    for (u32 i = 0; i < rModule.code.size(); i++) {
+        PutWord(data, rModule.code[i]);
+    }
+
+    if (!grouped) {
+        for (u32 i = 0; i < rModule.relocs.size(); i++) {
+            const Reloc& rReloc = rModule.relocs[i];
+
+            if (rReloc.IsAbsolute()) {
+                PutWord(data, rReloc.cmd << 24 | scAbsoluteAddress);
+                PutWord(data, rReloc.address);
+            } else {
+                PutWord(data, rReloc.cmd << 24 | rReloc.address);
+            }
+
+            for (u32 j = 0; j < rReloc.numArgs; j++) {
+                PutWord(data, rReloc.args[j]);
+            }
+        }
+
+        return data;
+    }
+
+    std::vector<Reloc> sorted = rModule.relocs;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (u32 i = 0; i < sorted.size();) {
+        u32 end = i;
+        while (end < sorted.size() && sorted[end].cmd == sorted[i].cmd) {
+            end++;
+        }
+
+        PutWord(data, sorted[i].cmd << 24 | (end - i));
+
+        for (; i < end; i++) {
+            PutWord(data, sorted[i].address);
+
+            for (u32 j = 0; j < sorted[i].numArgs; j++) {
+                PutWord(data, sorted[i].args[j]);
+            }
+        }
+    }
+
+    return data;
+}
+
+/**
+ * @brief Swaps the byte order of a value in place
+ *
+ * @param pData Value
+ * @param size Value size
+ */
+void Swap(u8* pData, u32 size) {
+    std::reverse(pData, pData + size);
+}
+
+/**
+ * @brief Converts a Kamek binary to host byte order, so the loader can read
+ * its words
+ * @note Patches smaller than a word land in the other half of it, which is
+ * the same for both relocation formats
+ *
+ * @param[in, out] rData Kamek binary
+ * @return Success
+ */
+bool ToHostOrder(std::vector<u8>& rData) {
+    if (rData.size() < scHeaderSize || rData.size() % 4 != 0) {
+        return false;
+    }
+
+    // magic1, then magic2/version (u16), then the rest of the header
+    Swap(&rData[0], 4);
+    Swap(&rData[4], 2);
+    Swap(&rData[6], 2);
+
+    for (u32 i = 8; i < rData.size(); i += 4) {
+        Swap(&rData[i], 4);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Counts the game code cache lines which a module patches
+ *
+ * @param rModule Module
+ */
+u32 CountGameLines(const Module& rModule) {
+    std::vector<u32> lines;
+
+    for (u32 i = 0; i < rModule.relocs.size(); i++) {
+        if (rModule.relocs[i].IsAbsolute()) {
+            lines.push_back(rModule.relocs[i].address & ~(scCacheLineSize - 1));
+        }
+    }
+
+    std::sort(lines.begin(), lines.end());
+    return std::unique(lines.begin(), lines.end()) - lines.begin();
+}
+
+/**
+ * @brief Counts the game code patches in a module
+ *
+ * @param rModule Module
+ */
+u32 CountGamePatches(const Module& rModule) {
+    u32 num = 0;
+
+    for (u32 i = 0; i < rModule.relocs.size(); i++) {
+        if (rModule.relocs[i].IsAbsolute()) {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+/**
+ * @brief Loads a host order binary into a freshly reset image
+ *
+ * @param rData Kamek binary
+ * @param[out] rImage Image contents after loading
+ */
+void LoadFresh(const std::vector<u8>& rData, std::vector<u8>& rImage) {
+    host::ResetKamekImage();
+    host::LoadKamekBinary(rData.data(), rData.size());
+
+    const u8* pImage = host::GetKamekImage();
+    rImage.assign(pImage, pImage + host::KAMEK_IMAGE_SIZE);
+}
+
+void TestCommands() {
+    // Module (four words), then the game
+    Module module;
+    module.code.assign(4, 0);
+    module.bssSize = 32;
+
+    const u32 text = host::KAMEK_TEXT_BASE;
+    const u32 game = scGameCodeStart;
+
+    module.code[1] = 0x48000001;
+    module.relocs.push_back(MakeReloc(kAddr32, 0x0, 0x10));
+    module.relocs.push_back(MakeReloc(kRel24, 0x4, game));
+    module.relocs.push_back(MakeReloc(kAddr16Ha, 0x8, 0x80018000));
+    module.relocs.push_back(MakeReloc(kAddr16Hi, 0xA, 0x80018000));
+    module.relocs.push_back(MakeReloc(kAddr16Lo, 0xC, 0x80018000));
+    module.relocs.push_back(MakeReloc(kBranch, game, 0x8));
+    module.relocs.push_back(MakeReloc(kBranchLink, game + 4, 0x8));
+    module.relocs.push_back(MakeReloc(kWrite32, game + 8, 0x12345678));
+    module.relocs.push_back(MakeReloc(kCondWritePointer, game + 12, 0x10,
+                                      host::GetKamekInitialWord(game + 12)));
+    module.relocs.push_back(MakeReloc(kCondWritePointer, game + 16, 0x10,
+                                      ~host::GetKamekInitialWord(game + 16)));
+
+    for (u32 grouped = 0; grouped < 2; grouped++) {
+        std::vector<u8> data = Encode(module, grouped);
+        HOST_CHECK(ToHostOrder(data));
+
+        std::vector<u8> image;
+        LoadFresh(data, image);
+
+        const u8* pImage = image.data() - host::KAMEK_IMAGE_BASE;
+        const std::uint32_t* pText =
+            reinterpret_cast<const std::uint32_t*>(pImage + text);
+        const std::uint32_t* pGame =
+            reinterpret_cast<const std::uint32_t*>(pImage + game);
+
+        HOST_CHECK_EQ(pText[0], text + 0x10);
+        HOST_CHECK_EQ(pText[1], 0x48000001 | ((game - (text + 4)) & 0x3FFFFFC));
+        HOST_CHECK_EQ(*reinterpret_cast<const u16*>(pImage + text + 0x8),
+                      0x8002);
+        HOST_CHECK_EQ(*reinterpret_cast<const u16*>(pImage + text + 0xA),
+                      0x8001);
+        HOST_CHECK_EQ(*reinterpret_cast<const u16*>(pImage + text + 0xC),
+                      0x8000);
+
+        HOST_CHECK_EQ(pGame[0], 0x48000000 | ((text + 0x8 - game) & 0x3FFFFFC));
+        HOST_CHECK_EQ(pGame[1],
+                      0x48000001 | ((text + 0x8 - (game + 4)) & 0x3FFFFFC));
+        HOST_CHECK_EQ(pGame[2], 0x12345678);
+        HOST_CHECK_EQ(pGame[3], text + 0x10);
+        HOST_CHECK_EQ(pGame[4], host::GetKamekInitialWord(game + 16));
+
+        // Game code is all in one line, which is flushed once when grouped
+        HOST_CHECK_EQ(host::GetKamekNumStaleLines(), 0);
+        HOST_CHECK_EQ(host::GetKamekNumLineFlushes(), grouped ? 1 : 5);
+    }
+}
+
+void TestGroupedMatchesLegacy() {
+    Module module = MakeModule(4000, 1000);
+
+    std::vector<u8> legacy = Encode(module, false);
+    std::vector<u8> grouped = Encode(module, true);
+    HOST_CHECK(ToHostOrder(legacy));
+    HOST_CHECK(ToHostOrder(grouped));
+
+    std::vector<u8> legacyImage, groupedImage;
+
+    LoadFresh(legacy, legacyImage);
+    HOST_CHECK_EQ(host::GetKamekNumStaleLines(), 0);
+    HOST_CHECK_EQ(host::GetKamekNumLineFlushes(), CountGamePatches(module));
+
+    LoadFresh(grouped, groupedImage);
+    HOST_CHECK_EQ(host::GetKamekNumStaleLines(), 0);
+    HOST_CHECK_EQ(host::GetKamekNumLineFlushes(), CountGameLines(module));
+
+    HOST_CHECK(legacyImage == groupedImage);
+}
+
+/**
+ * @brief Measures loading a host order binary
+ *
+ * @param pName Benchmark name
+ * @param rData Kamek binary
+ * @param numRelocs Number of relocations in the binary
+ * @param rounds Number of times to load it
+ */
+void BenchLoad(const char* pName, const std::vector<u8>& rData, u32 numRelocs,
+               u32 rounds) {
+    host::ResetKamekImage();
+    host::LoadKamekBinary(rData.data(), rData.size());
+    u32 flushes = host::GetKamekNumLineFlushes();
+
+    // Loading again patches the same memory, so the image isn't reset
+    host::Bench bench(pName);
+
+    for (u32 i = 0; i < rounds; i++) {
+        host::LoadKamekBinary(rData.data(), rData.size());
+    }
+
+    bench.Report(static_cast<u64>(numRelocs) * rounds);
+    std::printf("%-40s %10lu game code line flushes\n", "  per load", flushes);
+}
+
+void BenchSynthetic() {
+    const u32 rounds = 200;
+
+    Module module = MakeModule(16000, 3000);
+    std::printf("Module: %lu KB code, %lu relocations (%lu game patches in "
+                "%lu lines)\n",
+                module.code.size() * scWordSize / 1024, module.relocs.size(),
+                CountGamePatches(module), CountGameLines(module));
+
+    Module sections = module;
+    sections.relocs.clear();
+
+    std::vector<u8> empty = Encode(sections, false);
+    std::vector<u8> legacy = Encode(module, false);
+    std::vector<u8> grouped = Encode(module, true);
+    ToHostOrder(empty);
+    ToHostOrder(legacy);
+    ToHostOrder(grouped);
+
+    // Copying the sections is the same for both, so it's measured on its own
+    BenchLoad("Sections only (per relocation)", empty, module.relocs.size(),
+              rounds);
+    BenchLoad("Legacy relocations (per relocation)", legacy,
+              module.relocs.size(), rounds);
+    BenchLoad("Grouped relocations (per relocation)", grouped,
+              module.relocs.size(), rounds);
+}
+
+/**
+ * @brief Reads a file
+ *
+ * @param pPath File path
+ * @param[out] rData File contents
+ * @return Success
+ */
+bool ReadFile(const char* pPath, std::vector<u8>& rData) {
+    std::FILE* pFile = std::fopen(pPath, "rb");
+    if (pFile == nullptr) {
+        return false;
+    }
+
+    u8 buffer[4096];
+    for (size_t n; (n = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0;) {
+        rData.insert(rData.end(), buffer, buffer + n);
+    }
+
+    std::fclose(pFile);
+    return true;
+}
+
+/**
+ * @brief Replays a real module, and the same module after
+ * tools/sort_kamek_relocs.py grouped its relocations
+ *
+ * @param pLegacyPath Original binary
+ * @param pGroupedPath Grouped binary
+ */
+void BenchFile(const char* pLegacyPath, const char* pGroupedPath) {
+    const u32 rounds = 200;
+
+    std::vector<u8> legacy, grouped;
+    if (!ReadFile(pLegacyPath, legacy) || !ReadFile(pGroupedPath, grouped)) {
+        std::fprintf(stderr, "Can't read %s or %s\n", pLegacyPath,
+                     pGroupedPath);
+        HOST_CHECK(false);
+        return;
+    }
+
+    HOST_CHECK(ToHostOrder(legacy));
+    HOST_CHECK(ToHostOrder(grouped));
+    std::printf("Module: %s (%lu KB)\n", pLegacyPath, legacy.size() / 1024);
+
+    std::vector<u8> legacyImage, groupedImage;
+    LoadFresh(legacy, legacyImage);
+    LoadFresh(grouped, groupedImage);
+    HOST_CHECK(legacyImage == groupedImage);
+    HOST_CHECK_EQ(host::GetKamekNumStaleLines(), 0);
+
+    // Real binaries aren't parsed, so the time is per load
+    BenchLoad("Legacy relocations (per load)", legacy, 1, rounds);
+    BenchLoad("Grouped relocations (per load)", grouped, 1, rounds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!host::MapKamekImage()) {
+#ifdef __SANITIZE_ADDRESS__
+        // The sanitizer's shadow memory is where MEM1 would go
+        std::printf("[SKIP] Kamek image can't be mapped with ASan\n");
+        return EXIT_SUCCESS;
+#else
+        return EXIT_FAILURE;
+#endif
+    }
+
+    host::Run("Kamek relocation commands", TestCommands);
+    host::Run("Kamek grouped relocations match legacy",
+              TestGroupedMatchesLegacy);
+
+    if (host::IsBench(argc, argv)) {
+        BenchSynthetic();
+
+        // Pairs of original and grouped binaries
+        std::vector<const char*> files;
+        for (int i = 1; i < argc; i++) {
+            if (std::strncmp(argv[i], "--", 2) != 0) {
+                files.push_back(argv[i]);
+            }
+        }
+
+        for (u32 i = 0; i + 1 < files.size(); i += 2) {
+            BenchFile(files[i], files[i + 1]);
+        }
+    }
+
+    return host::Finish();
+}
@@ -0,0 +1,389 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/**
+ * NetStats tests (histograms, per-socket and global counters, console and
+ * JSON output), and benchmarks of what recording costs, per call and per
+ * socket round trip.
+ */
+
+namespace {
+
+/**
+ * @brief Connected pair of sync sockets
+ */
+class Pair {
+public:
+    Pair()
+        : server(SO_PF_INET, SO_SOCK_STREAM),
+          client(SO_PF_INET, SO_SOCK_STREAM),
+          pPeer(nullptr) {
+
+        kiwi::SockAddr4 addr("127.0.0.1");
+        HOST_CHECK(server.Bind(addr) && server.Listen());
+
+        // Connection completes in the backlog, before the accept
+        HOST_CHECK(client.Connect(addr));
+        pPeer = server.Accept();
+        HOST_CHECK(pPeer != nullptr);
+    }
+
+    ~Pair() {
+        delete pPeer;
+    }
+
+    /**
+     * @brief Sends data from one socket, and receives all of it on the other
+     *
+     * @return Success
+     */
+    static bool Transfer(kiwi::SocketBase& rFrom, kiwi::SocketBase& rTo,
+                         u8* pBuffer, u32 size) {
+        kiwi::Optional<u32> sent = rFrom.SendBytes(pBuffer, size);
+        if (!sent || *sent != size) {
+            return false;
+        }
+
+        for (u32 recv = 0; recv < size;) {
+            kiwi::Optional<u32> n = rTo.RecvBytes(pBuffer + recv, size - recv);
+            if (!n || *n == 0) {
+                return false;
+            }
+
+            recv += *n;
+        }
+
+        return true;
+    }
+
+public:
+    kiwi::SyncSocket server; // Listening socket
+    kiwi::SyncSocket client; // Connecting socket
+    kiwi::SyncSocket* pPeer; // Accepted socket
+};
+
+/**
+ * @brief Captures what NetStats::Print writes to the console (stdout here)
+ */
+std::string CapturePrint() {
+    std::fflush(stdout);
+
+    std::FILE* pFile = std::tmpfile();
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(pFile), STDOUT_FILENO);
+
+    kiwi::NetStats::Print();
+    std::fflush(stdout);
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::string text;
+    std::rewind(pFile);
+
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), pFile) != nullptr) {
+        text += buffer;
+    }
+
+    std::fclose(pFile);
+    return text;
+}
+
+void TestHistogram() {
+    kiwi::LatencyHistogram hist;
+    HOST_CHECK_EQ(hist.GetCount(), 0);
+    HOST_CHECK_EQ(hist.GetPercentile(50), 0);
+
+    // Sub-microsecond latencies share the first bucket
+    hist.Record(0);
+    hist.Record(1);
+    HOST_CHECK_EQ(hist.GetBucket(0), 2);
+
+    // Bucket N counts [2^N, 2^(N+1))
+    hist.Record(2);
+    hist.Record(3);
+    hist.Record(1000);
+    HOST_CHECK_EQ(hist.GetBucket(1), 2);
+    HOST_CHECK_EQ(hist.GetBucket(9), 1);
+    HOST_CHECK_EQ(kiwi::LatencyHistogram::GetBucketMin(9), 512);
+
+    // Last bucket takes anything larger
+    hist.Record(0xFFFFFFFF);
+    HOST_CHECK_EQ(hist.GetBucket(kiwi::LatencyHistogram::NUM_BUCKETS - 1), 1);
+
+    HOST_CHECK_EQ(hist.GetCount(), 6);
+    HOST_CHECK_EQ(hist.GetMax(), 0xFFFFFFFF);
+
+    // Percentiles are bucket upper bounds, never above the largest sample
+    kiwi::LatencyHistogram small;
+    for (u32 i = 0; i < 99; i++) {
+        small.Record(10);
+    }
+    small.Record(100);
+
+    HOST_CHECK_EQ(small.GetMean(), 10);
+    HOST_CHECK_EQ(small.GetPercentile(50), 15);
+    HOST_CHECK_EQ(small.GetPercentile(99), 15);
+    HOST_CHECK_EQ(small.GetPercentile(100), 100);
+
+    hist.Reset();
+    HOST_CHECK_EQ(hist.GetCount(), 0);
+    HOST_CHECK_EQ(hist.GetBucket(0), 0);
+}
+
+void TestDisabled() {
+    kiwi::NetStats::SetEnabled(false);
+    kiwi::NetStats::Reset();
+
+    Pair pair;
+
+    u8 data[100] = {};
+    HOST_CHECK(Pair::Transfer(pair.client, *pair.pPeer, data, sizeof(data)));
+
+    // Nothing is recorded until stats are enabled
+    HOST_CHECK_EQ(pair.client.GetCounters().numSends, 0);
+    HOST_CHECK_EQ(kiwi::NetStats::GetCounters().numConnects, 0);
+    HOST_CHECK_EQ(
+        kiwi::NetStats::GetHistogram(kiwi::NetStats::EOp_Send).GetCount(), 0);
+}
+
+void TestCounters() {
+    kiwi::NetStats::SetEnabled(true);
+    kiwi::NetStats::Reset();
+
+    Pair pair;
+
+    u8 data[1000];
+    std::memset(data, 0xAB, sizeof(data));
+
+    HOST_CHECK(Pair::Transfer(pair.client, *pair.pPeer, data, sizeof(data)));
+    HOST_CHECK(Pair::Transfer(pair.client, *pair.pPeer, data, sizeof(data)));
+    HOST_CHECK(Pair::Transfer(*pair.pPeer, pair.client, data, 500));
+
+    // Non-blocking receive with nothing to read
+    HOST_CHECK(pair.client.SetBlocking(false));
+    HOST_CHECK(pair.client.RecvBytes(data, sizeof(data)).HasValue());
+
+    kiwi::NetCounters client = pair.client.GetCounters();
+    HOST_CHECK_EQ(client.numConnects, 1);
+    HOST_CHECK_EQ(client.numSends, 2);
+    HOST_CHECK_EQ(client.sendBytes, 2000);
+    HOST_CHECK_EQ(client.recvBytes, 500);
+    HOST_CHECK(client.numRecvs >= 2);
+    HOST_CHECK_EQ(client.numWouldBlock, 1);
+    HOST_CHECK_EQ(client.numErrors, 0);
+
+    kiwi::NetCounters peer = pair.pPeer->GetCounters();
+    HOST_CHECK_EQ(peer.numConnects, 0);
+    HOST_CHECK_EQ(peer.numSends, 1);
+    HOST_CHECK_EQ(peer.sendBytes, 500);
+    HOST_CHECK_EQ(peer.recvBytes, 2000);
+
+    // Global counters see every socket
+    kiwi::NetCounters global = kiwi::NetStats::GetCounters();
+    HOST_CHECK_EQ(global.numConnects, 1);
+    HOST_CHECK_EQ(global.numSends, client.numSends + peer.numSends);
+    HOST_CHECK_EQ(global.numRecvs, client.numRecvs + peer.numRecvs);
+    HOST_CHECK_EQ(global.sendBytes, 2500);
+    HOST_CHECK_EQ(global.recvBytes, 2500);
+    HOST_CHECK_EQ(global.numWouldBlock, 1);
+
+    // Every LibSO call has a latency sample
+    HOST_CHECK_EQ(
+        kiwi::NetStats::GetHistogram(kiwi::NetStats::EOp_Connect).GetCount(),
+        1);
+    HOST_CHECK_EQ(
+        kiwi::NetStats::GetHistogram(kiwi::NetStats::EOp_Send).GetCount(),
+        global.numSends);
+    HOST_CHECK_EQ(
+        kiwi::NetStats::GetHistogram(kiwi::NetStats::EOp_Recv).GetCount(),
+        global.numRecvs);
+
+    // Bound socket which isn't listening refuses connections
+    kiwi::SyncSocket unused(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::SockAddr4 addr("127.0.0.1");
+    HOST_CHECK(unused.Bind(addr));
+
+    kiwi::SyncSocket refused(SO_PF_INET, SO_SOCK_STREAM);
+    HOST_CHECK(!refused.Connect(addr));
+    HOST_CHECK_EQ(refused.GetCounters().numErrors, 1);
+    HOST_CHECK_EQ(kiwi::NetStats::GetCounters().numErrors, 1);
+
+    pair.client.ResetCounters();
+    HOST_CHECK_EQ(pair.client.GetCounters().sendBytes, 0);
+
+    kiwi::NetStats::SetEnabled(false);
+}
+
+void TestPrint() {
+    kiwi::NetStats::SetEnabled(true);
+    kiwi::NetStats::Reset();
+
+    {
+        Pair pair;
+        u8 data[300] = {};
+        HOST_CHECK(
+            Pair::Transfer(pair.client, *pair.pPeer, data, sizeof(data)));
+    }
+
+    std::string text = CapturePrint();
+
+    HOST_CHECK(text.find("Network I/O statistics\n") == 0);
+    HOST_CHECK(text.find("  connect: 1 calls\n") != std::string::npos);
+    HOST_CHECK(text.find("  send:    1 calls, 300 bytes\n") !=
+               std::string::npos);
+    HOST_CHECK(text.find("  send latency (us): mean ") != std::string::npos);
+
+    // Disabled stats are labelled as such
+    kiwi::NetStats::SetEnabled(false);
+    text = CapturePrint();
+    HOST_CHECK(text.find("Network I/O statistics (disabled)\n") == 0);
+}
+
+void TestJSON() {
+    kiwi::NetStats::SetEnabled(true);
+    kiwi::NetStats::Reset();
+
+    {
+        Pair pair;
+        u8 data[300] = {};
+        HOST_CHECK(
+            Pair::Transfer(pair.client, *pair.pPeer, data, sizeof(data)));
+    }
+
+    // Zeroed, so the output is null-terminated
+    char buffer[0x2000];
+    std::memset(buffer, 0, sizeof(buffer));
+
+    kiwi::MemStream strm(buffer, sizeof(buffer) - 1);
+    HOST_CHECK(kiwi::NetStats::Dump(strm, true));
+
+    kiwi::json::Document doc;
+    HOST_CHECK(doc.Parse(buffer, std::strlen(buffer)));
+
+    const kiwi::json::Value& rRoot = doc.Get();
+    HOST_CHECK_EQ(rRoot["enabled"].GetBoolean(), true);
+
+    const kiwi::json::Value& rCounters = rRoot["counters"];
+    HOST_CHECK_EQ(rCounters["connects"].GetNumber(), 1.0);
+    HOST_CHECK_EQ(rCounters["sends"].GetNumber(), 1.0);
+    HOST_CHECK_EQ(rCounters["sendBytes"].GetNumber(), 300.0);
+    HOST_CHECK_EQ(rCounters["recvBytes"].GetNumber(), 300.0);
+    HOST_CHECK_EQ(rCounters["errors"].GetNumber(), 0.0);
+
+    const kiwi::json::Value& rSend = rRoot["latency"]["send"];
+    HOST_CHECK_EQ(rSend["count"].GetNumber(), 1.0);
+    HOST_CHECK_EQ(rSend["buckets"].Size(),
+                  kiwi::LatencyHistogram::NUM_BUCKETS);
+
+    // Bucket counts add up to the sample count
+    const kiwi::json::Value& rRecv = rRoot["latency"]["recv"];
+    f64 total = 0.0;
+    for (u32 i = 0; i < rRecv["buckets"].Size(); i++) {
+        total += rRecv["buckets"][i].GetNumber();
+    }
+    HOST_CHECK_EQ(total, rRecv["count"].GetNumber());
+
+    kiwi::NetStats::SetEnabled(false);
+}
+
+/**
+ * @brief Measures the cost of recording one operation
+ * @details Includes the start tick, which LibSO reads either way
+ */
+void BenchRecord(const char* pName, bool enable, u32 num) {
+    kiwi::NetStats::SetEnabled(enable);
+    kiwi::NetStats::Reset();
+
+    kiwi::NetCounters counters;
+
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            u32 start = OSGetTick();
+            kiwi::NetStats::Record(kiwi::NetStats::EOp_Send, 64, start);
+            kiwi::NetStats::Count(counters, kiwi::NetStats::EOp_Send, 64);
+        }
+
+        bench.Report(num);
+    }
+
+    kiwi::NetStats::SetEnabled(false);
+}
+
+/**
+ * @brief Measures sync socket round trips
+ */
+void BenchRoundTrip(const char* pName, bool enable, u32 size, u32 num) {
+    kiwi::NetStats::SetEnabled(enable);
+    kiwi::NetStats::Reset();
+
+    Pair pair;
+    u8* pData = new u8[size];
+    std::memset(pData, 0, size);
+
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            HOST_CHECK(Pair::Transfer(pair.client, *pair.pPeer, pData, size));
+            HOST_CHECK(Pair::Transfer(*pair.pPeer, pair.client, pData, size));
+        }
+
+        bench.Report(num);
+    }
+
+    delete[] pData;
+
+    if (enable) {
+        kiwi::LatencyHistogram send =
+            kiwi::NetStats::GetHistogram(kiwi::NetStats::EOp_Send);
+
+        std::printf("%-40s p50 %lu us  p99 %lu us  max %lu us\n",
+                    "  send latency", send.GetPercentile(50),
+                    send.GetPercentile(99), send.GetMax());
+    }
+
+    kiwi::NetStats::SetEnabled(false);
+}
+
+void BenchNetStats() {
+    BenchRecord("tick+Record+Count (stats off)", false, 10000000);
+    BenchRecord("tick+Record+Count (stats on)", true, 10000000);
+
+    BenchRoundTrip("sync round trip 64 B (stats off)", false, 64, 20000);
+    BenchRoundTrip("sync round trip 64 B (stats on)", true, 64, 20000);
+    BenchRoundTrip("sync round trip 4 KB (stats off)", false, 4096, 20000);
+    BenchRoundTrip("sync round trip 4 KB (stats on)", true, 4096, 20000);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+    kiwi::Nw4rConsole::CreateInstance();
+
+    host::Run("LatencyHistogram", TestHistogram);
+    host::Run("NetStats disabled", TestDisabled);
+    host::Run("NetStats counters", TestCounters);
+    host::Run("NetStats Print", TestPrint);
+    host::Run("NetStats JSON", TestJSON);
+
+    if (host::IsBench(argc, argv)) {
+        BenchNetStats();
+    }
+
+    kiwi::Nw4rConsole::DestroyInstance();
+    return host::Finish();
+}
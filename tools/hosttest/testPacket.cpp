@@ -0,0 +1,581 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * Packet and packet ring tests, and benchmarks of the per-message cost (a new
+ * packet for each message, against one packet recycling its buffer, against
+ * a ring shared by two threads) and of UDP latency and throughput over the
+ * fake IOS socket device (host/hostNet.cpp).
+ */
+
+namespace {
+
+/**
+ * @brief Fills a buffer with a pattern which depends on the seed
+ */
+void FillPattern(u8* pBuffer, u32 size, u32 seed) {
+    for (u32 i = 0; i < size; i++) {
+        pBuffer[i] = static_cast<u8>(seed * 31 + i * 7);
+    }
+}
+
+/**
+ * @brief UDP socket bound to a random loopback port
+ */
+class UdpSocket {
+public:
+    UdpSocket() : mAddr("127.0.0.1") {
+        mHandle = kiwi::LibSO::Socket(SO_PF_INET, SO_SOCK_DGRAM);
+        HOST_CHECK(mHandle >= 0);
+
+        // Let bursts queue up in the receive buffer
+        s32 size = 0x40000;
+        kiwi::LibSO::SetSockOpt(mHandle, SO_SOL_SOCKET, SO_SO_RCVBUF, &size,
+                                sizeof(s32));
+
+        mAddr.port = 49152 + host::GetNanoTime() % 16384;
+        while (kiwi::LibSO::Bind(mHandle, mAddr) != SO_SUCCESS) {
+            mAddr.port = 49152 + (mAddr.port + 1) % 16384;
+        }
+    }
+
+    ~UdpSocket() {
+        kiwi::LibSO::Close(mHandle);
+    }
+
+    SOSocket GetHandle() const {
+        return mHandle;
+    }
+    const kiwi::SockAddr4& GetAddr() const {
+        return mAddr;
+    }
+
+private:
+    SOSocket mHandle;      // Socket descriptor
+    kiwi::SockAddr4 mAddr; // Bound address
+};
+
+/**
+ * @brief Sends a whole packet
+ */
+bool SendPacket(kiwi::Packet& rPacket, SOSocket socket) {
+    kiwi::Optional<u32> sent = rPacket.Send(socket);
+    return sent && rPacket.IsReadComplete();
+}
+
+/**
+ * @brief Receives a whole packet (one datagram)
+ */
+bool RecvPacket(kiwi::Packet& rPacket, SOSocket socket) {
+    kiwi::Optional<u32> recv = rPacket.Recv(socket);
+    return recv && rPacket.IsWriteComplete();
+}
+
+void TestReadWrite() {
+    kiwi::Packet packet(100);
+    HOST_CHECK_EQ(packet.GetContentSize(), 100);
+    HOST_CHECK_EQ(packet.WriteRemain(), 100);
+
+    u8 data[150];
+    FillPattern(data, sizeof(data), 0);
+
+    // Writes are clamped to the packet size
+    HOST_CHECK_EQ(packet.Write(data, 60), 60);
+    HOST_CHECK_EQ(packet.Write(data + 60, 90), 40);
+    HOST_CHECK(packet.IsWriteComplete());
+
+    u8 read[150];
+    HOST_CHECK_EQ(packet.Read(read, 150), 100);
+    HOST_CHECK(packet.IsReadComplete());
+    HOST_CHECK(std::memcmp(data, read, 100) == 0);
+}
+
+void TestRecycle() {
+    kiwi::Packet packet;
+    packet.Alloc(256);
+    const void* pBuffer = packet.GetContent();
+
+    // Smaller messages reuse the buffer, and reset the offsets
+    host::AllocStats before = host::GetAllocStats();
+
+    u8 data[256] = {};
+    packet.Write(data, 100);
+    packet.Alloc(128);
+
+    HOST_CHECK_EQ(host::GetAllocStats().numAllocs, before.numAllocs);
+    HOST_CHECK_EQ(packet.GetContent(), pBuffer);
+    HOST_CHECK_EQ(packet.GetContentSize(), 128);
+    HOST_CHECK_EQ(packet.GetBufferCapacity(), 256);
+    HOST_CHECK_EQ(packet.WriteRemain(), 128);
+
+    // Larger messages need a new buffer
+    packet.Alloc(512);
+    HOST_CHECK_EQ(host::GetAllocStats().numAllocs, before.numAllocs + 1);
+    HOST_CHECK_EQ(packet.GetBufferCapacity(), 512);
+
+    // Header overhead is part of the buffer
+    kiwi::ReliablePacket reliable(100);
+    HOST_CHECK_EQ(reliable.GetBufferSize(), 100 + sizeof(kiwi::KUDPHeader));
+    HOST_CHECK_EQ(reliable.GetBufferCapacity(),
+                  100 + sizeof(kiwi::KUDPHeader));
+}
+
+void TestAttach() {
+    u8 memory[64];
+
+    kiwi::Packet packet;
+    packet.Attach(memory, sizeof(memory));
+
+    host::AllocStats before = host::GetAllocStats();
+    packet.Alloc(48);
+    HOST_CHECK_EQ(host::GetAllocStats().numAllocs, before.numAllocs);
+    HOST_CHECK_EQ(packet.GetContent(), memory);
+
+    u8 data[48];
+    FillPattern(data, sizeof(data), 1);
+    HOST_CHECK_EQ(packet.Write(data, sizeof(data)), sizeof(data));
+    HOST_CHECK(std::memcmp(memory, data, sizeof(data)) == 0);
+}
+
+void TestSendRecv() {
+    UdpSocket a, b;
+
+    u8 data[1000];
+    FillPattern(data, sizeof(data), 2);
+
+    kiwi::Packet send(sizeof(data), &static_cast<const kiwi::SockAddrAny&>(
+                                        b.GetAddr()));
+    send.Write(data, sizeof(data));
+    HOST_CHECK(SendPacket(send, a.GetHandle()));
+
+    kiwi::Packet recv(sizeof(data));
+    HOST_CHECK(RecvPacket(recv, b.GetHandle()));
+
+    u8 read[1000];
+    HOST_CHECK_EQ(recv.Read(read, sizeof(read)), sizeof(read));
+    HOST_CHECK(std::memcmp(data, read, sizeof(data)) == 0);
+
+    // Sender is recorded
+    kiwi::SockAddr4 peer = recv.GetPeer();
+    HOST_CHECK_EQ(peer.port, a.GetAddr().port);
+}
+
+void TestRing() {
+    // Slot size is rounded up for IOS
+    kiwi::PacketRing ring(4, 100);
+    HOST_CHECK_EQ(ring.GetCapacity(), 4);
+    HOST_CHECK_EQ(ring.GetSlotSize(), 128);
+    HOST_CHECK(ring.IsEmpty());
+    HOST_CHECK(ring.BeginPop() == nullptr);
+
+    kiwi::Packet other;
+    HOST_CHECK(!ring.IsSlot(&other));
+
+    // Wraps around many times, in FIFO order
+    host::AllocStats before = host::GetAllocStats();
+    u32 pushed = 0;
+    u32 popped = 0;
+
+    for (u32 round = 0; round < 100; round++) {
+        // Fill the ring up
+        kiwi::Packet* pPacket;
+        while ((pPacket = ring.BeginPush()) != nullptr) {
+            HOST_CHECK(ring.IsSlot(pPacket));
+
+            u8 data[100];
+            FillPattern(data, sizeof(data), pushed);
+
+            pPacket->Alloc(sizeof(data));
+            pPacket->Write(data, sizeof(data));
+            ring.EndPush();
+            pushed++;
+        }
+
+        HOST_CHECK(ring.IsFull());
+        HOST_CHECK_EQ(ring.GetSize(), 4);
+
+        // Drain some, but not all of it
+        for (u32 i = 0; i < 3; i++) {
+            pPacket = ring.BeginPop();
+            HOST_CHECK(pPacket != nullptr);
+
+            u8 expected[100];
+            u8 data[100];
+            FillPattern(expected, sizeof(expected), popped);
+
+            HOST_CHECK_EQ(pPacket->Read(data, sizeof(data)), sizeof(data));
+            HOST_CHECK(std::memcmp(data, expected, sizeof(data)) == 0);
+            ring.EndPop();
+            popped++;
+        }
+    }
+
+    HOST_CHECK_EQ(ring.GetSize(), 1);
+    HOST_CHECK_EQ(pushed - popped, 1);
+
+    // Slots are recycled, so nothing else is allocated
+    HOST_CHECK_EQ(host::GetAllocStats().numAllocs, before.numAllocs);
+}
+
+void TestRingStats() {
+    kiwi::PacketRing ring(4, 64);
+
+    for (u32 i = 0; i < 5; i++) {
+        kiwi::Packet* pPacket = ring.BeginPush();
+        if (pPacket == nullptr) {
+            break;
+        }
+
+        pPacket->Alloc(10 + i);
+        ring.EndPush();
+    }
+
+    ring.BeginPop();
+    ring.EndPop();
+    ring.BeginPop();
+    ring.EndPop();
+
+    kiwi::PacketRing::Stats stats = ring.GetStats();
+    HOST_CHECK_EQ(stats.numPushed, 4);
+    HOST_CHECK_EQ(stats.numFull, 1);
+    HOST_CHECK_EQ(stats.maxUsed, 4);
+    HOST_CHECK_EQ(stats.numPopped, 2);
+    HOST_CHECK_EQ(stats.numBytes, 10 + 11);
+    HOST_CHECK(stats.maxLatency <= stats.totalLatency);
+
+    // Counters read as cleared right away, though each side only clears its
+    // own once it runs again
+    ring.ResetStats();
+    stats = ring.GetStats();
+    HOST_CHECK_EQ(stats.numPushed + stats.numFull + stats.numPopped, 0);
+    HOST_CHECK_EQ(stats.numBytes + stats.totalLatency, 0);
+    HOST_CHECK_EQ(stats.maxUsed, 2);
+
+    ring.BeginPop();
+    ring.EndPop();
+    HOST_CHECK_EQ(ring.GetStats().numPopped, 1);
+    HOST_CHECK_EQ(ring.GetStats().numBytes, 12);
+    HOST_CHECK_EQ(ring.GetStats().numPushed, 0);
+
+    ring.BeginPush()->Alloc(1);
+    ring.EndPush();
+    HOST_CHECK_EQ(ring.GetStats().numPushed, 1);
+    HOST_CHECK_EQ(ring.GetStats().maxUsed, 2);
+
+    // Byte rate follows the bytes released over time
+    usleep(20 * 1000);
+    stats = ring.GetStats();
+    HOST_CHECK(stats.elapsed >= 20);
+    HOST_CHECK(stats.byteRate > 0 && stats.byteRate <= 12 * 1000 / 20);
+}
+
+/**
+ * @brief Ring shared by two threads
+ */
+struct RingTransfer {
+    kiwi::PacketRing* pRing; // Ring to fill
+    u32 size;                // Message size
+    u32 num;                 // Number of messages
+    bool isVerify;           // Whether to check the message contents
+};
+
+/**
+ * @brief Producer thread: pushes numbered messages, waiting while full
+ */
+void* RingProducerFunc(void* pArg) {
+    RingTransfer* pTransfer = static_cast<RingTransfer*>(pArg);
+
+    u8* pData = new u8[pTransfer->size];
+    FillPattern(pData, pTransfer->size, 0);
+
+    for (u32 i = 0; i < pTransfer->num; i++) {
+        kiwi::Packet* pPacket;
+        while ((pPacket = pTransfer->pRing->BeginPush()) == nullptr) {
+            sched_yield();
+        }
+
+        if (pTransfer->isVerify) {
+            FillPattern(pData, pTransfer->size, i);
+        }
+
+        pPacket->Alloc(pTransfer->size);
+        pPacket->Write(pData, pTransfer->size);
+        pTransfer->pRing->EndPush();
+    }
+
+    delete[] pData;
+    return nullptr;
+}
+
+/**
+ * @brief Consumer side: pops the messages from RingProducerFunc
+ *
+ * @return Number of messages which arrived intact and in order
+ */
+u32 ConsumeRing(const RingTransfer& rTransfer) {
+    u8* pExpected = new u8[rTransfer.size];
+    u8* pData = new u8[rTransfer.size];
+    FillPattern(pExpected, rTransfer.size, 0);
+
+    u32 numValid = 0;
+
+    for (u32 i = 0; i < rTransfer.num; i++) {
+        kiwi::Packet* pPacket;
+        while ((pPacket = rTransfer.pRing->BeginPop()) == nullptr) {
+            sched_yield();
+        }
+
+        if (rTransfer.isVerify) {
+            FillPattern(pExpected, rTransfer.size, i);
+        }
+
+        u32 n = pPacket->Read(pData, rTransfer.size);
+        if (n == rTransfer.size &&
+            std::memcmp(pData, pExpected, rTransfer.size) == 0) {
+            numValid++;
+        }
+
+        rTransfer.pRing->EndPop();
+    }
+
+    delete[] pExpected;
+    delete[] pData;
+    return numValid;
+}
+
+void TestRingThreads() {
+    kiwi::PacketRing ring(16, 256);
+    RingTransfer transfer = {&ring, 200, 100000, true};
+
+    pthread_t producer;
+    pthread_create(&producer, nullptr, RingProducerFunc, &transfer);
+
+    HOST_CHECK_EQ(ConsumeRing(transfer), transfer.num);
+    pthread_join(producer, nullptr);
+
+    kiwi::PacketRing::Stats stats = ring.GetStats();
+    HOST_CHECK(ring.IsEmpty());
+    HOST_CHECK_EQ(stats.numPushed, transfer.num);
+    HOST_CHECK_EQ(stats.numPopped, transfer.num);
+    HOST_CHECK_EQ(stats.numBytes, transfer.num * transfer.size);
+    HOST_CHECK(stats.maxUsed <= ring.GetCapacity());
+}
+
+/**
+ * @brief Builds and consumes messages, with a new packet for each one
+ */
+void BenchNewPacket(const char* pName, u32 size, u32 num) {
+    u8* pData = new u8[size];
+    FillPattern(pData, size, 0);
+
+    host::AllocStats before = host::GetAllocStats();
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            kiwi::Packet* pPacket = new kiwi::Packet(size);
+            pPacket->Write(pData, size);
+            pPacket->Read(pData, size);
+            delete pPacket;
+        }
+
+        bench.Report(num);
+    }
+    host::AllocStats after = host::GetAllocStats();
+
+    std::printf("%-40s %10.2f per msg\n", "  allocations",
+                static_cast<double>(after.numAllocs - before.numAllocs) / num);
+
+    delete[] pData;
+}
+
+/**
+ * @brief Builds and consumes messages, with one packet recycling its buffer
+ */
+void BenchRecycledPacket(const char* pName, u32 size, u32 num) {
+    u8* pData = new u8[size];
+    FillPattern(pData, size, 0);
+
+    kiwi::Packet packet;
+
+    host::AllocStats before = host::GetAllocStats();
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            packet.Alloc(size);
+            packet.Write(pData, size);
+            packet.Read(pData, size);
+        }
+
+        bench.Report(num);
+    }
+    host::AllocStats after = host::GetAllocStats();
+
+    std::printf("%-40s %10.2f per msg\n", "  allocations",
+                static_cast<double>(after.numAllocs - before.numAllocs) / num);
+
+    delete[] pData;
+}
+
+/**
+ * @brief Passes messages between two threads through a ring
+ */
+void BenchRing(const char* pName, u32 size, u32 num) {
+    kiwi::PacketRing ring(16, size);
+    RingTransfer transfer = {&ring, size, num, false};
+
+    host::AllocStats before = host::GetAllocStats();
+    {
+        host::Bench bench(pName);
+
+        pthread_t producer;
+        pthread_create(&producer, nullptr, RingProducerFunc, &transfer);
+        HOST_CHECK_EQ(ConsumeRing(transfer), num);
+        pthread_join(producer, nullptr);
+
+        bench.Report(num);
+    }
+    host::AllocStats after = host::GetAllocStats();
+
+    // Only the producer's staging buffer is allocated
+    std::printf("%-40s %10.2f per msg\n", "  allocations",
+                static_cast<double>(after.numAllocs - before.numAllocs) / num);
+
+    kiwi::PacketRing::Stats stats = ring.GetStats();
+    std::printf("  ring: %lu full, max %lu queued, avg latency %lu us\n",
+                stats.numFull, stats.maxUsed, stats.totalLatency / num);
+}
+
+/**
+ * @brief Measures UDP round trips, one packet at a time
+ */
+void BenchLatency(u32 size, u32 num) {
+    UdpSocket a, b;
+
+    u8* pData = new u8[size];
+    FillPattern(pData, size, 0);
+
+    kiwi::Packet ping, pong;
+    u64* pTimes = new u64[num];
+
+    for (u32 i = 0; i < num; i++) {
+        u64 start = host::GetNanoTime();
+
+        ping.Alloc(size);
+        ping.SetPeer(b.GetAddr());
+        ping.Write(pData, size);
+        HOST_CHECK(SendPacket(ping, a.GetHandle()));
+
+        pong.Alloc(size);
+        HOST_CHECK(RecvPacket(pong, b.GetHandle()));
+
+        // Echo back to the sender
+        pong.SetPeer(a.GetAddr());
+        HOST_CHECK(SendPacket(pong, b.GetHandle()));
+
+        ping.Alloc(size);
+        HOST_CHECK(RecvPacket(ping, a.GetHandle()));
+
+        pTimes[i] = host::GetNanoTime() - start;
+    }
+
+    std::sort(pTimes, pTimes + num);
+
+    u64 total = 0;
+    for (u32 i = 0; i < num; i++) {
+        total += pTimes[i];
+    }
+
+    std::printf("UDP Packet round trip %4lu B              avg %6.2f us  "
+                "p50 %6.2f us  p99 %6.2f us  max %7.2f us\n",
+                size, total / 1000.0 / num, pTimes[num / 2] / 1000.0,
+                pTimes[num * 99 / 100] / 1000.0, pTimes[num - 1] / 1000.0);
+
+    delete[] pTimes;
+    delete[] pData;
+}
+
+/**
+ * @brief Measures UDP throughput, sending bursts of packets
+ */
+void BenchThroughput(u32 size, u32 num, u32 burst) {
+    UdpSocket a, b;
+
+    u8* pData = new u8[size];
+    FillPattern(pData, size, 0);
+
+    kiwi::Packet send, recv;
+
+    u64 start = host::GetNanoTime();
+
+    for (u32 i = 0; i < num; i += burst) {
+        for (u32 j = 0; j < burst; j++) {
+            send.Alloc(size);
+            send.SetPeer(b.GetAddr());
+            send.Write(pData, size);
+            HOST_CHECK(SendPacket(send, a.GetHandle()));
+        }
+
+        for (u32 j = 0; j < burst; j++) {
+            recv.Alloc(size);
+            HOST_CHECK(RecvPacket(recv, b.GetHandle()));
+        }
+    }
+
+    u64 elapsed = host::GetNanoTime() - start;
+    double seconds = elapsed / 1e9;
+
+    std::printf("UDP Packet burst %2lu x %4lu B               %8.0f pkt/s  "
+                "%7.2f MB/s  %7.1f Mbit/s\n",
+                burst, size, num / seconds, num * size / seconds / 1e6,
+                num * size * 8 / seconds / 1e6);
+
+    delete[] pData;
+}
+
+void BenchPacket() {
+    BenchNewPacket("new Packet per message 64 B", 64, 1000000);
+    BenchRecycledPacket("recycled Packet 64 B", 64, 1000000);
+    BenchNewPacket("new Packet per message 1000 B", 1000, 1000000);
+    BenchRecycledPacket("recycled Packet 1000 B", 1000, 1000000);
+    BenchRing("PacketRing across threads 64 B", 64, 1000000);
+    BenchRing("PacketRing across threads 1000 B", 1000, 1000000);
+
+    BenchLatency(64, 20000);
+    BenchLatency(1000, 20000);
+
+    BenchThroughput(1000, 100000, 1);
+    BenchThroughput(1000, 100000, 32);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+
+    host::Run("Packet Read/Write", TestReadWrite);
+    host::Run("Packet buffer recycling", TestRecycle);
+    host::Run("Packet attached buffer", TestAttach);
+    host::Run("Packet UDP Send/Recv", TestSendRecv);
+    host::Run("PacketRing push/pop", TestRing);
+    host::Run("PacketRing statistics", TestRingStats);
+    host::Run("PacketRing across threads", TestRingThreads);
+
+    if (host::IsBench(argc, argv)) {
+        BenchPacket();
+    }
+
+    return host::Finish();
+}
@@ -0,0 +1,569 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * ReliableSocket tests through a lossy UDP relay, which drops, reorders and
+ * duplicates packets in both directions, and benchmarks of message
+ * throughput and delivery latency at several loss rates.
+ */
+
+namespace {
+
+//! How long to wait for the transport to finish
+const u64 scTimeoutNsec = 20ull * 1000 * 1000 * 1000;
+
+/**
+ * @brief Link impairments, in percent per packet
+ */
+struct LinkConfig {
+    u32 loss;      // Dropped packets
+    u32 reorder;   // Packets held back until after the next one
+    u32 duplicate; // Packets delivered twice
+};
+
+/**
+ * @brief UDP relay between two endpoints, which impairs the link
+ * @details Each endpoint talks to its own relay port, and the relay
+ * forwards packets out of the other port. Runs on a host thread with the
+ * host's own sockets.
+ */
+class LossyRelay {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param rConfig Link impairments
+     * @param seed Random seed
+     */
+    LossyRelay(const LinkConfig& rConfig, u32 seed)
+        : mConfig(rConfig), mSeed(seed), mIsRunning(true) {
+        std::memset(&mStats, 0, sizeof(Stats));
+
+        for (u32 i = 0; i < 2; i++) {
+            mSides[i].fd = socket(AF_INET, SOCK_DGRAM, 0);
+            mSides[i].heldSize = 0;
+            mSides[i].hasEndpoint = false;
+
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(sockaddr_in));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            socklen_t len = sizeof(sockaddr_in);
+            bind(mSides[i].fd, reinterpret_cast<sockaddr*>(&addr), len);
+            getsockname(mSides[i].fd, reinterpret_cast<sockaddr*>(&addr),
+                        &len);
+
+            mSides[i].port = ntohs(addr.sin_port);
+        }
+
+        pthread_create(&mThread, nullptr, ThreadFunc, this);
+    }
+
+    /**
+     * @brief Destructor
+     */
+    ~LossyRelay() {
+        __atomic_store_n(&mIsRunning, false, __ATOMIC_RELEASE);
+        pthread_join(mThread, nullptr);
+
+        close(mSides[0].fd);
+        close(mSides[1].fd);
+    }
+
+    /**
+     * @brief Sets the endpoint address of the specified side
+     * @note Call before the endpoint sends anything
+     *
+     * @param side Endpoint (0 or 1)
+     * @param rAddr Endpoint address
+     */
+    void SetEndpoint(u32 side, const kiwi::SockAddr4& rAddr) {
+        Side& rSide = mSides[side];
+
+        std::memset(&rSide.endpoint, 0, sizeof(sockaddr_in));
+        rSide.endpoint.sin_family = AF_INET;
+        rSide.endpoint.sin_port = htons(rAddr.port);
+        rSide.endpoint.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        __atomic_store_n(&rSide.hasEndpoint, true, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief Gets the relay address which an endpoint should send to
+     *
+     * @param side Endpoint (0 or 1)
+     */
+    kiwi::SockAddr4 GetAddr(u32 side) const {
+        return kiwi::SockAddr4("127.0.0.1", mSides[side].port);
+    }
+
+    /**
+     * @brief Relay statistics
+     */
+    struct Stats {
+        u32 numForwarded;  // Packets forwarded
+        u32 numDropped;    // Packets dropped
+        u32 numReordered;  // Packets held back
+        u32 numDuplicated; // Packets sent twice
+    };
+
+    /**
+     * @brief Gets the relay statistics
+     */
+    Stats GetStats() const {
+        Stats stats;
+        __atomic_load(&mStats, &stats, __ATOMIC_ACQUIRE);
+        return stats;
+    }
+
+private:
+    /**
+     * @brief Relay port for one endpoint
+     */
+    struct Side {
+        int fd;                // Relay socket
+        u16 port;              // Relay port
+        sockaddr_in endpoint;  // Endpoint address
+        volatile bool hasEndpoint; // Whether the endpoint is known
+        u8 held[0x800];        // Packet held back for reordering
+        ssize_t heldSize;      // Size of the held packet (0 if none)
+    };
+
+    /**
+     * @brief Rolls a random percentage
+     */
+    u32 Roll() {
+        // xorshift32
+        mSeed ^= mSeed << 13;
+        mSeed ^= mSeed >> 17;
+        mSeed ^= mSeed << 5;
+        return (mSeed & 0xFFFFFFFF) % 100;
+    }
+
+    /**
+     * @brief Sends a packet to the endpoint of the specified side
+     */
+    void Forward(Side& rTo, const void* pData, ssize_t size) {
+        if (!__atomic_load_n(&rTo.hasEndpoint, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+
+        sendto(rTo.fd, pData, size, 0,
+               reinterpret_cast<const sockaddr*>(&rTo.endpoint),
+               sizeof(sockaddr_in));
+
+        mStats.numForwarded++;
+    }
+
+    /**
+     * @brief Sends the packet that was held back, if any
+     */
+    void Flush(Side& rTo) {
+        if (rTo.heldSize > 0) {
+            Forward(rTo, rTo.held, rTo.heldSize);
+            rTo.heldSize = 0;
+        }
+    }
+
+    /**
+     * @brief Relays one packet from the endpoint of the specified side
+     */
+    void Relay(Side& rFrom, Side& rTo) {
+        u8 buffer[0x800];
+        ssize_t size = recv(rFrom.fd, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            return;
+        }
+
+        if (Roll() < mConfig.loss) {
+            mStats.numDropped++;
+            return;
+        }
+
+        // Goes out after the next packet in this direction
+        if (rTo.heldSize == 0 && Roll() < mConfig.reorder) {
+            std::memcpy(rTo.held, buffer, size);
+            rTo.heldSize = size;
+            mStats.numReordered++;
+            return;
+        }
+
+        Forward(rTo, buffer, size);
+        Flush(rTo);
+
+        if (Roll() < mConfig.duplicate) {
+            Forward(rTo, buffer, size);
+            mStats.numDuplicated++;
+        }
+    }
+
+    static void* ThreadFunc(void* pArg) {
+        LossyRelay* p = static_cast<LossyRelay*>(pArg);
+
+        while (__atomic_load_n(&p->mIsRunning, __ATOMIC_ACQUIRE)) {
+            pollfd fds[2];
+            for (u32 i = 0; i < 2; i++) {
+                fds[i].fd = p->mSides[i].fd;
+                fds[i].events = POLLIN;
+                fds[i].revents = 0;
+            }
+
+            // Held packets don't wait for long on a quiet link
+            if (poll(fds, 2, 1) == 0) {
+                p->Flush(p->mSides[0]);
+                p->Flush(p->mSides[1]);
+                continue;
+            }
+
+            for (u32 i = 0; i < 2; i++) {
+                if (fds[i].revents & POLLIN) {
+                    p->Relay(p->mSides[i], p->mSides[i ^ 1]);
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    LinkConfig mConfig;         // Link impairments
+    u32 mSeed;                  // Random state
+    volatile bool mIsRunning;   // Whether the relay thread should run
+    pthread_t mThread;          // Relay thread
+    Side mSides[2];             // Relay ports
+    Stats mStats;               // Relay statistics
+};
+
+/**
+ * @brief Message header, followed by a pattern which depends on the index
+ */
+struct MessageHeader {
+    u32 index;    // Message index
+    u64 sendTime; // When the message was sent (host time)
+};
+
+/**
+ * @brief Records received messages
+ */
+struct Receiver {
+    Receiver(u32 num)
+        : numExpected(num), numRecv(0), numBad(0), pLatency(new u64[num]) {}
+
+    ~Receiver() {
+        delete[] pLatency;
+    }
+
+    u32 numExpected;        // Number of messages to receive
+    volatile u32 numRecv;   // Number of messages received
+    volatile u32 numBad;    // Number of corrupt/out of order messages
+    u64* pLatency;          // Delivery time of each message
+};
+
+/**
+ * @brief Counts completed sends
+ */
+struct Sender {
+    Sender() : numDone(0), numError(0) {}
+
+    volatile u32 numDone;  // Number of acknowledged messages
+    volatile u32 numError; // Number of failed messages
+};
+
+/**
+ * @brief Gets the size of the specified message
+ *
+ * @param index Message index
+ * @param maxSize Largest message size
+ */
+u32 GetMessageSize(u32 index, u32 maxSize) {
+    u32 size = sizeof(MessageHeader) + (index * 2654435761u) % maxSize;
+    return kiwi::Min(size, maxSize);
+}
+
+/**
+ * @brief Fills in a message
+ */
+void BuildMessage(u8* pBuffer, u32 index, u32 size) {
+    MessageHeader header;
+    header.index = index;
+    header.sendTime = host::GetNanoTime();
+    std::memcpy(pBuffer, &header, sizeof(MessageHeader));
+
+    for (u32 i = sizeof(MessageHeader); i < size; i++) {
+        pBuffer[i] = static_cast<u8>(index * 31 + i * 7);
+    }
+}
+
+/**
+ * @brief Received message callback
+ */
+void MessageFunc(const void* pData, u32 size, void* pArg) {
+    Receiver* pRecv = static_cast<Receiver*>(pArg);
+    const u8* pBuffer = static_cast<const u8*>(pData);
+
+    MessageHeader header;
+    std::memcpy(&header, pBuffer, sizeof(MessageHeader));
+
+    // Messages arrive whole and in order
+    bool ok = size >= sizeof(MessageHeader) && header.index == pRecv->numRecv;
+    for (u32 i = sizeof(MessageHeader); ok && i < size; i++) {
+        ok = pBuffer[i] == static_cast<u8>(header.index * 31 + i * 7);
+    }
+
+    if (!ok) {
+        pRecv->numBad++;
+    }
+
+    if (pRecv->numRecv < pRecv->numExpected) {
+        pRecv->pLatency[pRecv->numRecv] =
+            host::GetNanoTime() - header.sendTime;
+    }
+
+    __atomic_add_fetch(&pRecv->numRecv, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Message acknowledgement callback
+ */
+void SendFunc(SOResult result, void* pArg) {
+    Sender* pSender = static_cast<Sender*>(pArg);
+
+    if (result != SO_SUCCESS) {
+        __atomic_add_fetch(&pSender->numError, 1, __ATOMIC_RELEASE);
+    }
+
+    __atomic_add_fetch(&pSender->numDone, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Pair of reliable sockets connected through a relay
+ */
+struct Link {
+    Link(const LinkConfig& rConfig, u32 seed)
+        : relay(rConfig, seed), a(SO_PF_INET), b(SO_PF_INET) {
+
+        kiwi::SockAddr4 addrA("127.0.0.1");
+        HOST_CHECK(a.Bind(addrA));
+        relay.SetEndpoint(0, addrA);
+
+        kiwi::SockAddr4 addrB("127.0.0.1");
+        HOST_CHECK(b.Bind(addrB));
+        relay.SetEndpoint(1, addrB);
+
+        a.Connect(relay.GetAddr(0));
+        b.Connect(relay.GetAddr(1));
+    }
+
+    LossyRelay relay;     // Relay between the sockets
+    kiwi::ReliableSocket a; // Sending side
+    kiwi::ReliableSocket b; // Receiving side
+};
+
+/**
+ * @brief Result of a transfer
+ */
+struct Transfer {
+    bool isComplete; // Whether everything arrived in time
+    u64 elapsed;     // Time taken (nanoseconds)
+    u64 bytes;       // Message bytes sent
+};
+
+/**
+ * @brief Sends messages from one side of the link to the other
+ *
+ * @param rLink Link
+ * @param rRecv Receiver
+ * @param rSender Sender
+ * @param maxSize Largest message size
+ * @param window Largest number of unacknowledged messages
+ */
+Transfer Send(Link& rLink, Receiver& rRecv, Sender& rSender, u32 maxSize,
+              u32 window) {
+    rLink.b.SetMessageCallback(MessageFunc, &rRecv);
+
+    u8* pBuffer = new u8[maxSize];
+    Transfer transfer = {true, 0, 0};
+
+    u64 start = host::GetNanoTime();
+
+    for (u32 i = 0; i < rRecv.numExpected && transfer.isComplete; i++) {
+        // Don't queue more than the window
+        while (i - __atomic_load_n(&rSender.numDone, __ATOMIC_ACQUIRE) >=
+               window) {
+            if (host::GetNanoTime() - start > scTimeoutNsec) {
+                transfer.isComplete = false;
+                break;
+            }
+
+            usleep(50);
+        }
+
+        u32 size = GetMessageSize(i, maxSize);
+        BuildMessage(pBuffer, i, size);
+
+        HOST_CHECK_EQ(rLink.a.SendMessage(pBuffer, size, SendFunc, &rSender),
+                      SO_SUCCESS);
+        transfer.bytes += size;
+    }
+
+    while (transfer.isComplete &&
+           (__atomic_load_n(&rRecv.numRecv, __ATOMIC_ACQUIRE) <
+                rRecv.numExpected ||
+            __atomic_load_n(&rSender.numDone, __ATOMIC_ACQUIRE) <
+                rRecv.numExpected)) {
+
+        if (host::GetNanoTime() - start > scTimeoutNsec) {
+            transfer.isComplete = false;
+            break;
+        }
+
+        usleep(50);
+    }
+
+    transfer.elapsed = host::GetNanoTime() - start;
+
+    delete[] pBuffer;
+    return transfer;
+}
+
+/**
+ * @brief Sends messages through a link and checks that all of them arrive
+ */
+void CheckTransfer(const LinkConfig& rConfig, u32 num, u32 maxSize,
+                   kiwi::ReliableSocket::Stats* pStats = nullptr,
+                   bool coalesce = false) {
+    Link link(rConfig, 1234);
+    link.a.SetCoalescing(coalesce);
+
+    Receiver recv(num);
+    Sender sender;
+
+    Transfer transfer = Send(link, recv, sender, maxSize, num);
+    HOST_CHECK(transfer.isComplete);
+    HOST_CHECK_EQ(recv.numRecv, num);
+    HOST_CHECK_EQ(recv.numBad, 0);
+    HOST_CHECK_EQ(sender.numDone, num);
+    HOST_CHECK_EQ(sender.numError, 0);
+    HOST_CHECK_EQ(link.a.GetStatus(), SO_SUCCESS);
+    HOST_CHECK(link.a.IsIdle());
+
+    if (pStats != nullptr) {
+        *pStats = link.a.GetStats();
+    }
+
+    // Stop the callbacks before the receiver goes away
+    link.b.SetMessageCallback(nullptr);
+}
+
+void TestCleanLink() {
+    LinkConfig config = {0, 0, 0};
+    kiwi::ReliableSocket::Stats stats;
+
+    CheckTransfer(config, 200, 100, &stats);
+    HOST_CHECK_EQ(stats.numRetransmits, 0);
+    HOST_CHECK_EQ(stats.numFragmented, 0);
+}
+
+void TestFragmentation() {
+    LinkConfig config = {0, 0, 0};
+    kiwi::ReliableSocket::Stats stats;
+
+    // Up to 8 KB, so most messages span several packets
+    CheckTransfer(config, 100, 0x2000, &stats);
+    HOST_CHECK(stats.numFragmented > 0);
+}
+
+void TestLossyLink() {
+    LinkConfig config = {10, 10, 2};
+    kiwi::ReliableSocket::Stats stats;
+
+    CheckTransfer(config, 300, 3000, &stats);
+    HOST_CHECK(stats.numRetransmits + stats.numFastResends > 0);
+}
+
+void TestCoalescing() {
+    LinkConfig config = {0, 0, 0};
+    kiwi::ReliableSocket::Stats stats;
+
+    // Small messages share packets while earlier ones are unacknowledged
+    CheckTransfer(config, 500, 32, &stats, true);
+    HOST_CHECK(stats.numCoalesced > 0);
+    HOST_CHECK(stats.numSent - stats.numAckOnly < 500);
+}
+
+/**
+ * @brief Measures throughput and delivery latency over a lossy link
+ */
+void BenchLink(u32 loss, u32 num, u32 maxSize, u32 window) {
+    LinkConfig config = {loss, loss, 0};
+    Link link(config, 5678);
+
+    Receiver recv(num);
+    Sender sender;
+
+    Transfer transfer = Send(link, recv, sender, maxSize, window);
+    HOST_CHECK(transfer.isComplete);
+    HOST_CHECK_EQ(recv.numBad, 0);
+
+    kiwi::ReliableSocket::Stats stats = link.a.GetStats();
+    link.b.SetMessageCallback(nullptr);
+
+    u32 numRecv = kiwi::Min<u32>(static_cast<u32>(recv.numRecv), num);
+    std::sort(recv.pLatency, recv.pLatency + numRecv);
+
+    double seconds = transfer.elapsed / 1e9;
+    std::printf("loss/reorder %2lu%%, msgs <= %4lu B, window %2lu  "
+                "%7.0f msg/s %6.2f MB/s  latency p50 %7.2f ms "
+                "p99 %7.2f ms\n",
+                loss, maxSize, window, numRecv / seconds,
+                transfer.bytes / seconds / 1e6,
+                numRecv > 0 ? recv.pLatency[numRecv / 2] / 1e6 : 0.0,
+                numRecv > 0 ? recv.pLatency[numRecv * 99 / 100] / 1e6 : 0.0);
+
+    std::printf("  %lu sent, %lu retransmits, %lu fast resends, "
+                "%lu ACK-only, srtt %.2f ms, rto %.2f ms\n",
+                stats.numSent, stats.numRetransmits, stats.numFastResends,
+                stats.numAckOnly, OS_TICKS_TO_USEC(stats.smoothRtt) / 1000.0,
+                OS_TICKS_TO_USEC(stats.rto) / 1000.0);
+}
+
+void BenchReliable() {
+    BenchLink(0, 20000, 64, 32);
+    BenchLink(1, 20000, 64, 32);
+    BenchLink(5, 20000, 64, 32);
+
+    BenchLink(0, 5000, 4000, 8);
+    BenchLink(1, 5000, 4000, 8);
+    BenchLink(5, 5000, 4000, 8);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+
+    host::Run("ReliableSocket clean link", TestCleanLink);
+    host::Run("ReliableSocket fragmentation", TestFragmentation);
+    host::Run("ReliableSocket loss/reorder/duplication", TestLossyLink);
+    host::Run("ReliableSocket coalescing", TestCoalescing);
+
+    if (host::IsBench(argc, argv)) {
+        BenchReliable();
+    }
+
+    return host::Finish();
+}
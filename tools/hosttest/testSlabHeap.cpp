@@ -0,0 +1,799 @@
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * SlabHeap tests, and an allocation trace replay comparing a first-fit
+ * expanded heap on its own (before) against a slab heap in front of it
+ * (after, as MemoryMgr::AllocFromRegion does), for throughput and
+ * fragmentation.
+ */
+
+namespace {
+
+/**
+ * @brief Expanded heap model
+ * @details EGG's heaps aren't available on the host, so this follows what
+ * MEMiExpHeap does in first-fit mode: 16-byte block headers in front of
+ * every block, one free list sorted by address which allocation walks from
+ * the start, and neighbouring free blocks merged when a block is freed.
+ */
+class FirstFitHeap {
+public:
+    //! Block header size (MEMiExpHeapMBlock)
+    static const std::uint32_t HEADER_SIZE = 16;
+
+    /**
+     * @brief Heap statistics
+     */
+    struct Stats {
+        u64 numAllocs;  // Allocations served
+        u64 numSteps;   // Free blocks visited by allocations
+        u32 numFailed;  // Allocations which didn't fit
+        u32 usedBytes;  // Bytes taken by used blocks (with headers)
+        u32 freeBytes;  // Bytes in free blocks (without headers)
+        u32 maxFree;    // Largest free block (without header)
+        u32 numFree;    // Number of free blocks
+        u32 highWater;  // Highest offset ever used
+    };
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param size Heap size
+     */
+    explicit FirstFitHeap(u32 size) : mSize(size) {
+        // Offsets are 32-bit like the console's pointers
+        int result = posix_memalign(reinterpret_cast<void**>(&mpMemory), 32,
+                                    size);
+        HOST_CHECK(result == 0);
+
+        std::memset(&mStats, 0, sizeof(Stats));
+
+        mFreeHead = 0;
+        Block& rBlock = At(0);
+        rBlock.magic = scMagicFree;
+        rBlock.pad = 0;
+        rBlock.size = size - HEADER_SIZE;
+        rBlock.prev = scNone;
+        rBlock.next = scNone;
+    }
+
+    ~FirstFitHeap() {
+        std::free(mpMemory);
+    }
+
+    /**
+     * @brief Allocates a block of memory
+     *
+     * @param size Block size
+     * @param align Block alignment
+     * @return Pointer to allocated block, or nullptr if nothing fits
+     */
+    void* Alloc(u32 size, s32 align) {
+        kiwi::AutoInterruptLock lock;
+
+        std::uint32_t need = ROUND_UP(size, 4);
+        std::uint32_t absAlign = kiwi::Max<s32>(align < 0 ? -align : align, 4);
+
+        for (std::uint32_t at = mFreeHead; at != scNone; at = At(at).next) {
+            mStats.numSteps++;
+
+            Block& rFree = At(at);
+            std::uint32_t end = at + HEADER_SIZE + rFree.size;
+
+            std::uint32_t data = ROUND_UP(at + HEADER_SIZE, absAlign);
+            if (data + need > end) {
+                continue;
+            }
+
+            std::uint32_t header = data - HEADER_SIZE;
+            std::uint32_t front = header - at;
+            std::uint32_t pad = 0;
+
+            // Alignment gap stays free if it can hold a block
+            if (front >= HEADER_SIZE + 4) {
+                rFree.size = front - HEADER_SIZE;
+            } else {
+                pad = front;
+                Unlink(at);
+            }
+
+            // Leftover space at the back becomes a new free block
+            std::uint32_t back = end - (data + need);
+            if (back >= HEADER_SIZE + 4) {
+                std::uint32_t rest = data + need;
+                At(rest).magic = scMagicFree;
+                At(rest).pad = 0;
+                At(rest).size = back - HEADER_SIZE;
+                Insert(rest);
+            } else {
+                need += back;
+            }
+
+            Block& rUsed = At(header);
+            rUsed.magic = scMagicUsed;
+            rUsed.pad = pad;
+            rUsed.size = need;
+
+            mStats.numAllocs++;
+            mStats.highWater = kiwi::Max<u32>(mStats.highWater, data + need);
+            return mpMemory + data;
+        }
+
+        mStats.numFailed++;
+        return nullptr;
+    }
+
+    /**
+     * @brief Frees a block of memory
+     *
+     * @param pBlock Block
+     */
+    void Free(void* pBlock) {
+        kiwi::AutoInterruptLock lock;
+
+        std::uint32_t header =
+            static_cast<std::uint32_t>(static_cast<u8*>(pBlock) - mpMemory) -
+            HEADER_SIZE;
+
+        Block& rUsed = At(header);
+        HOST_CHECK(rUsed.magic == scMagicUsed);
+
+        // Free block covers the alignment gap as well
+        std::uint32_t at = header - rUsed.pad;
+        std::uint32_t size = rUsed.pad + rUsed.size;
+        rUsed.magic = 0;
+
+        At(at).magic = scMagicFree;
+        At(at).pad = 0;
+        At(at).size = size;
+        Insert(at);
+
+        // Merge with the neighbours
+        std::uint32_t next = At(at).next;
+        if (next != scNone && at + HEADER_SIZE + At(at).size == next) {
+            At(at).size += HEADER_SIZE + At(next).size;
+            Unlink(next);
+        }
+
+        std::uint32_t prev = At(at).prev;
+        if (prev != scNone && prev + HEADER_SIZE + At(prev).size == at) {
+            At(prev).size += HEADER_SIZE + At(at).size;
+            Unlink(at);
+        }
+    }
+
+    /**
+     * @brief Tests whether an address points to this heap's memory
+     */
+    bool IsHeapMemory(const void* pAddr) const {
+        return pAddr >= mpMemory && pAddr < mpMemory + mSize;
+    }
+
+    /**
+     * @brief Gets the heap statistics
+     */
+    Stats GetStats() const {
+        Stats stats = mStats;
+        stats.usedBytes = mSize;
+
+        for (std::uint32_t at = mFreeHead; at != scNone; at = At(at).next) {
+            stats.numFree++;
+            stats.freeBytes += At(at).size;
+            stats.maxFree = kiwi::Max<u32>(stats.maxFree, At(at).size);
+            stats.usedBytes -= HEADER_SIZE + At(at).size;
+        }
+
+        return stats;
+    }
+
+private:
+    /**
+     * @brief Block header (MEMiExpHeapMBlock, with offsets for pointers)
+     */
+    struct Block {
+        std::uint16_t magic; // Block state
+        std::uint16_t pad;   // Alignment gap in front of the header
+        std::uint32_t size;  // Block size (without header)
+        std::uint32_t prev;  // Previous free block
+        std::uint32_t next;  // Next free block
+    };
+
+    //! No block
+    static const std::uint32_t scNone = 0xFFFFFFFF;
+    //! Free block state
+    static const std::uint16_t scMagicFree = 0x4652; // 'FR'
+    //! Used block state
+    static const std::uint16_t scMagicUsed = 0x5544; // 'UD'
+
+private:
+    Block& At(std::uint32_t offset) const {
+        return *reinterpret_cast<Block*>(mpMemory + offset);
+    }
+
+    /**
+     * @brief Adds a free block to the list (by address, like MEM)
+     */
+    void Insert(std::uint32_t at) {
+        std::uint32_t prev = scNone;
+        std::uint32_t next = mFreeHead;
+
+        while (next != scNone && next < at) {
+            prev = next;
+            next = At(next).next;
+        }
+
+        At(at).prev = prev;
+        At(at).next = next;
+
+        if (prev != scNone) {
+            At(prev).next = at;
+        } else {
+            mFreeHead = at;
+        }
+
+        if (next != scNone) {
+            At(next).prev = at;
+        }
+    }
+
+    /**
+     * @brief Removes a free block from the list
+     */
+    void Unlink(std::uint32_t at) {
+        std::uint32_t prev = At(at).prev;
+        std::uint32_t next = At(at).next;
+
+        if (prev != scNone) {
+            At(prev).next = next;
+        } else {
+            mFreeHead = next;
+        }
+
+        if (next != scNone) {
+            At(next).prev = prev;
+        }
+    }
+
+private:
+    u8* mpMemory;            // Heap memory
+    u32 mSize;               // Heap size
+    std::uint32_t mFreeHead; // First free block
+    Stats mStats;            // Heap statistics
+};
+
+/**
+ * @brief Region allocator, with or without a slab heap in front
+ */
+class Region {
+public:
+    //! Expanded heap size (MemoryMgr::scHeapSize)
+    static const u32 scHeapSize = 512 * 1024;
+    //! Slab heap size (MemoryMgr::scSlabSizeMEM1)
+    static const u32 scSlabSize = 64 * 1024;
+
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param slab Whether to use a slab heap
+     */
+    explicit Region(bool slab) : mHeap(scHeapSize), mIsSlab(slab) {
+        // Slab memory is carved out of the heap and never returned
+        if (mIsSlab) {
+            void* pMemory = mHeap.Alloc(scSlabSize, 32);
+            HOST_CHECK(pMemory != nullptr);
+            mSlab.Init(pMemory, scSlabSize);
+        }
+    }
+
+    void* Alloc(u32 size, s32 align) {
+        if (mIsSlab) {
+            void* pBlock = mSlab.Alloc(size, align);
+            if (pBlock != nullptr) {
+                return pBlock;
+            }
+        }
+
+        return mHeap.Alloc(size, align);
+    }
+
+    void Free(void* pBlock) {
+        if (mIsSlab && mSlab.IsHeapMemory(pBlock)) {
+            mSlab.Free(pBlock);
+            return;
+        }
+
+        mHeap.Free(pBlock);
+    }
+
+    bool IsSlab() const {
+        return mIsSlab;
+    }
+
+    const FirstFitHeap& GetHeap() const {
+        return mHeap;
+    }
+    const kiwi::SlabHeap& GetSlab() const {
+        return mSlab;
+    }
+
+private:
+    FirstFitHeap mHeap;   // Expanded heap
+    kiwi::SlabHeap mSlab; // Slab heap (if used)
+    bool mIsSlab;         // Whether the slab heap is used
+};
+
+/**
+ * @brief Trace event
+ */
+struct Event {
+    u32 id;    // Block index
+    u32 size;  // Block size (zero to free the block)
+    s32 align; // Block alignment
+};
+
+/**
+ * @brief Generates an allocation trace resembling libkiwi's
+ * @details Mostly list nodes, strings, optionals and hash map buckets,
+ * with some packet-sized buffers and a few large IOS buffers. Most blocks
+ * die within a few events, some live for a while and a few for much of the
+ * trace.
+ *
+ * @param num Number of allocations
+ * @param seed Random seed
+ */
+std::vector<Event> MakeTrace(u32 num, u32 seed) {
+    std::vector<Event> trace;
+    std::vector<std::vector<u32> > deaths(num + 1);
+
+    std::uint32_t state = seed;
+    struct Random {
+        static std::uint32_t Next(std::uint32_t& rState) {
+            rState ^= rState << 13;
+            rState ^= rState >> 17;
+            rState ^= rState << 5;
+            return rState;
+        }
+    };
+
+    for (u32 i = 0; i < num; i++) {
+        // Blocks which die now are freed first
+        for (u32 j = 0; j < deaths[i].size(); j++) {
+            Event free = {deaths[i][j], 0, 0};
+            trace.push_back(free);
+        }
+
+        u32 kind = Random::Next(state) % 100;
+        u32 r = Random::Next(state);
+
+        Event alloc = {i, 0, 4};
+
+        if (kind < 40) {
+            alloc.size = 12; // TListNode
+        } else if (kind < 60) {
+            alloc.size = 16 + r % 17; // String, Optional
+        } else if (kind < 75) {
+            alloc.size = 33 + r % 96; // Short strings, hash map buckets
+        } else if (kind < 85) {
+            alloc.size = 129 + r % 128; // Vectors
+        } else if (kind < 95) {
+            alloc.size = 257 + r % 1792; // Packets
+        } else {
+            alloc.size = 2048 + r % 6144; // IOS buffers
+            alloc.align = 32;
+        }
+
+        trace.push_back(alloc);
+
+        // Lifetime, in allocations
+        u32 life = Random::Next(state) % 100;
+        if (life < 70) {
+            life = 1 + Random::Next(state) % 8;
+        } else if (life < 98) {
+            life = 1 + Random::Next(state) % 1000;
+        } else {
+            // Only small blocks stay for long
+            life = alloc.size <= 256 ? 1 + Random::Next(state) % 20000
+                                     : 1 + Random::Next(state) % 1000;
+        }
+
+        deaths[kiwi::Min(i + life, num)].push_back(i);
+    }
+
+    // Everything left is freed at the end
+    for (u32 j = 0; j < deaths[num].size(); j++) {
+        Event free = {deaths[num][j], 0, 0};
+        trace.push_back(free);
+    }
+
+    return trace;
+}
+
+/**
+ * @brief Trace replay results
+ */
+struct Replay {
+    u64 nsec;        // Replay time
+    u32 numOps;      // Allocations and frees
+    u32 numFailed;   // Allocations which didn't fit
+    u32 peakLive;    // Most requested bytes live at once
+    u32 peakUsed;    // Heap bytes in use at that point
+    f64 fragMean;    // Average external fragmentation of the heap
+    f64 fragMax;     // Worst external fragmentation of the heap
+    f64 stepsMean;   // Free blocks visited per heap allocation
+    u32 heapAllocs;  // Allocations which reached the heap
+    u32 highWater;   // Highest heap offset ever used
+};
+
+/**
+ * @brief Gets the bytes a region has taken for its blocks
+ * @details Slab pages count once they are assigned to a size class
+ */
+u32 GetUsedBytes(const Region& rRegion) {
+    u32 used = rRegion.GetHeap().GetStats().usedBytes;
+
+    if (rRegion.IsSlab()) {
+        kiwi::SlabHeap::Stats stats = rRegion.GetSlab().GetStats();
+        used -= Region::scSlabSize + FirstFitHeap::HEADER_SIZE;
+        used += (stats.numPages - stats.numFreePages) * 1024;
+    }
+
+    return used;
+}
+
+/**
+ * @brief Replays a trace
+ *
+ * @param rTrace Allocation trace
+ * @param slab Whether to use a slab heap
+ * @param measure Whether to sample fragmentation (slower)
+ * @param check Whether to check block contents
+ */
+Replay RunTrace(const std::vector<Event>& rTrace, bool slab, bool measure,
+                bool check) {
+    Region region(slab);
+
+    Replay result;
+    std::memset(&result, 0, sizeof(Replay));
+
+    // Largest id is the number of allocations
+    std::vector<u8*> blocks(rTrace.size());
+    std::vector<u32> sizes(rTrace.size());
+
+    u32 live = 0, samples = 0;
+    u64 start = host::GetNanoTime();
+
+    for (u32 i = 0; i < rTrace.size(); i++) {
+        const Event& rEvent = rTrace[i];
+
+        if (rEvent.size == 0) {
+            u8* pBlock = blocks[rEvent.id];
+            if (pBlock == nullptr) {
+                continue;
+            }
+
+            // Blocks mustn't overlap
+            if (check) {
+                for (u32 j = 0; j < sizes[rEvent.id]; j++) {
+                    HOST_CHECK_EQ(pBlock[j], static_cast<u8>(rEvent.id + j));
+                }
+            }
+
+            region.Free(pBlock);
+            live -= sizes[rEvent.id];
+            result.numOps++;
+            continue;
+        }
+
+        u8* pBlock =
+            static_cast<u8*>(region.Alloc(rEvent.size, rEvent.align));
+        result.numOps++;
+
+        if (pBlock == nullptr) {
+            result.numFailed++;
+            continue;
+        }
+
+        if (check) {
+            HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(pBlock) % rEvent.align,
+                          0);
+
+            for (u32 j = 0; j < rEvent.size; j++) {
+                pBlock[j] = static_cast<u8>(rEvent.id + j);
+            }
+        }
+
+        blocks[rEvent.id] = pBlock;
+        sizes[rEvent.id] = rEvent.size;
+        live += rEvent.size;
+
+        if (!measure) {
+            continue;
+        }
+
+        if (live > result.peakLive) {
+            result.peakLive = live;
+            result.peakUsed = GetUsedBytes(region);
+        }
+
+        // Free space which can't serve the largest request
+        if (i % 256 == 0) {
+            FirstFitHeap::Stats stats = region.GetHeap().GetStats();
+
+            f64 frag = stats.freeBytes > 0
+                           ? 1.0 - static_cast<f64>(stats.maxFree) /
+                                       stats.freeBytes
+                           : 0.0;
+
+            result.fragMean += frag;
+            result.fragMax = kiwi::Max(result.fragMax, frag);
+            samples++;
+        }
+    }
+
+    result.nsec = host::GetNanoTime() - start;
+
+    FirstFitHeap::Stats stats = region.GetHeap().GetStats();
+    result.heapAllocs = static_cast<u32>(stats.numAllocs);
+    result.stepsMean =
+        stats.numAllocs > 0 ? static_cast<f64>(stats.numSteps) /
+                                  stats.numAllocs
+                            : 0.0;
+    result.highWater = stats.highWater;
+
+    if (samples > 0) {
+        result.fragMean /= samples;
+    }
+
+    // Everything was freed, so the heap is whole again (except the slab)
+    if (!slab) {
+        HOST_CHECK_EQ(stats.numFree, 1);
+        HOST_CHECK_EQ(stats.maxFree,
+                      Region::scHeapSize - FirstFitHeap::HEADER_SIZE);
+    } else {
+        HOST_CHECK(stats.numFree <= 2);
+    }
+
+    return result;
+}
+
+void TestClasses() {
+    static u8 memory[16 * 1024] __attribute__((aligned(32)));
+
+    kiwi::SlabHeap heap;
+    heap.Init(memory, sizeof(memory));
+
+    // Blocks are aligned to their class size
+    for (u32 size = 1; size <= kiwi::SlabHeap::MAX_BLOCK_SIZE; size++) {
+        void* pBlock = heap.Alloc(size, 4);
+        HOST_CHECK(pBlock != nullptr);
+        HOST_CHECK(heap.IsHeapMemory(pBlock));
+
+        u32 expected = 8;
+        while (expected < size) {
+            expected *= 2;
+        }
+
+        HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(pBlock) %
+                          kiwi::Min<u32>(expected, 32),
+                      0);
+
+        heap.Free(pBlock);
+    }
+
+    // Freed blocks are reused first
+    void* pFirst = heap.Alloc(12, 4);
+    heap.Free(pFirst);
+    HOST_CHECK_EQ(heap.Alloc(16, 4), pFirst);
+
+    // Larger sizes and alignments are left to the expanded heap
+    HOST_CHECK(heap.Alloc(kiwi::SlabHeap::MAX_BLOCK_SIZE + 1, 4) == nullptr);
+    HOST_CHECK(heap.Alloc(8, 64) == nullptr);
+
+    // Large alignment picks a larger class
+    void* pAligned = heap.Alloc(8, 32);
+    HOST_CHECK(pAligned != nullptr);
+    HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(pAligned) % 32, 0);
+
+    kiwi::SlabHeap::Stats stats = heap.GetStats();
+    HOST_CHECK_EQ(stats.numPages, 16);
+    HOST_CHECK_EQ(stats.classes[1].numInUse, 1);
+    HOST_CHECK_EQ(stats.classes[2].numInUse, 1);
+    HOST_CHECK_EQ(stats.classes[1].maxInUse, 1);
+}
+
+void TestExhaust() {
+    static u8 memory[2 * 1024] __attribute__((aligned(32)));
+
+    kiwi::SlabHeap heap;
+    heap.Init(memory, sizeof(memory));
+
+    // Two pages of 256-byte blocks
+    std::vector<void*> blocks;
+    for (u32 i = 0; i < 8; i++) {
+        blocks.push_back(heap.Alloc(256, 4));
+        HOST_CHECK(blocks.back() != nullptr);
+    }
+
+    HOST_CHECK(heap.Alloc(256, 4) == nullptr);
+    HOST_CHECK(heap.Alloc(8, 4) == nullptr);
+    HOST_CHECK_EQ(heap.GetStats().numFailed, 2);
+    HOST_CHECK_EQ(heap.GetStats().numFreePages, 0);
+
+    for (u32 i = 0; i < blocks.size(); i++) {
+        heap.Free(blocks[i]);
+    }
+
+    // One empty page goes back, the class keeps the other
+    kiwi::SlabHeap::Stats stats = heap.GetStats();
+    HOST_CHECK_EQ(stats.numFreePages, 1);
+    HOST_CHECK_EQ(stats.classes[5].numPages, 1);
+    HOST_CHECK_EQ(stats.classes[5].numInUse, 0);
+
+    HOST_CHECK(heap.Alloc(8, 4) != nullptr);
+    HOST_CHECK(heap.Alloc(256, 4) != nullptr);
+    HOST_CHECK_EQ(heap.GetStats().numFreePages, 0);
+}
+
+void TestRelease() {
+    static u8 memory[4 * 1024] __attribute__((aligned(32)));
+
+    kiwi::SlabHeap heap;
+    heap.Init(memory, sizeof(memory));
+
+    // Fill three pages of 64-byte blocks, then free them out of order
+    std::vector<void*> blocks;
+    for (u32 i = 0; i < 48; i++) {
+        blocks.push_back(heap.Alloc(64, 4));
+    }
+
+    HOST_CHECK_EQ(heap.GetStats().classes[3].numPages, 3);
+
+    for (u32 i = 0; i < 16; i++) {
+        for (u32 j = 0; j < 3; j++) {
+            heap.Free(blocks[j * 16 + (i * 7) % 16]);
+        }
+    }
+
+    kiwi::SlabHeap::Stats stats = heap.GetStats();
+    HOST_CHECK_EQ(stats.classes[3].numPages, 1);
+    HOST_CHECK_EQ(stats.numFreePages, 3);
+
+    // Freeing and allocating one block keeps the same page
+    for (u32 i = 0; i < 100; i++) {
+        void* pBlock = heap.Alloc(64, 4);
+        HOST_CHECK(pBlock != nullptr);
+        heap.Free(pBlock);
+    }
+
+    HOST_CHECK_EQ(heap.GetStats().numFreePages, 3);
+
+    // Released pages serve other classes
+    for (u32 i = 0; i < 3 * 1024 / 8; i++) {
+        HOST_CHECK(heap.Alloc(8, 4) != nullptr);
+    }
+
+    HOST_CHECK(heap.Alloc(8, 4) == nullptr);
+    HOST_CHECK_EQ(heap.GetStats().classes[0].numPages, 3);
+}
+
+void TestDoubleFree() {
+    // Assertions abort, so the double free happens in a child process
+    pid_t pid = fork();
+    HOST_CHECK(pid >= 0);
+
+    if (pid == 0) {
+        std::freopen("/dev/null", "w", stderr);
+
+        static u8 memory[1024] __attribute__((aligned(32)));
+
+        kiwi::SlabHeap heap;
+        heap.Init(memory, sizeof(memory));
+
+        void* pFirst = heap.Alloc(16, 4);
+        void* pSecond = heap.Alloc(16, 4);
+        heap.Free(pFirst);
+        heap.Free(pSecond);
+        heap.Free(pFirst);
+
+        _exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    HOST_CHECK(WIFSIGNALED(status));
+    HOST_CHECK_EQ(WTERMSIG(status), SIGABRT);
+}
+
+void TestReplay() {
+    std::vector<Event> trace = MakeTrace(50000, 1);
+
+    // Blocks are checked for overlap, and the heap must coalesce fully
+    Replay before = RunTrace(trace, false, true, true);
+    Replay after = RunTrace(trace, true, true, true);
+
+    HOST_CHECK_EQ(before.numFailed, 0);
+    HOST_CHECK_EQ(after.numFailed, 0);
+
+    // Small blocks never reach the expanded heap
+    HOST_CHECK(after.heapAllocs < before.heapAllocs / 2);
+}
+
+/**
+ * @brief Prints a trace replay
+ */
+void PrintReplay(const char* pName, const Replay& rReplay) {
+    std::printf("%-40s %10.2f ms %10.2f ns/op\n", pName,
+                rReplay.nsec / 1.0e6,
+                static_cast<f64>(rReplay.nsec) / rReplay.numOps);
+}
+
+/**
+ * @brief Prints the fragmentation measured by a trace replay
+ */
+void PrintFragmentation(const Replay& rReplay) {
+    std::printf("%-40s %10lu of %lu (%.2f steps each)\n",
+                "  allocations reaching heap", rReplay.heapAllocs,
+                rReplay.numOps / 2, rReplay.stepsMean);
+    std::printf("%-40s %9.1f%% mean %9.1f%% max\n",
+                "  heap fragmentation (1-maxFree/free)",
+                rReplay.fragMean * 100.0, rReplay.fragMax * 100.0);
+    std::printf("%-40s %10lu B live, %lu B used (%.1f%% overhead)\n",
+                "  at peak", rReplay.peakLive, rReplay.peakUsed,
+                (1.0 - static_cast<f64>(rReplay.peakLive) / rReplay.peakUsed) *
+                    100.0);
+    std::printf("%-40s %10lu B high water, %lu failed\n", "  heap",
+                rReplay.highWater, rReplay.numFailed);
+}
+
+void BenchReplay() {
+    std::vector<Event> trace = MakeTrace(500000, 2);
+
+    // Best of several runs, with fragmentation measured separately
+    Replay before, after;
+    for (u32 i = 0; i < 5; i++) {
+        Replay b = RunTrace(trace, false, false, false);
+        Replay a = RunTrace(trace, true, false, false);
+
+        if (i == 0 || b.nsec < before.nsec) {
+            before = b;
+        }
+        if (i == 0 || a.nsec < after.nsec) {
+            after = a;
+        }
+    }
+
+    PrintReplay("trace replay, first-fit heap (before)", before);
+    PrintFragmentation(RunTrace(trace, false, true, false));
+
+    PrintReplay("trace replay, slab + first-fit (after)", after);
+    PrintFragmentation(RunTrace(trace, true, true, false));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("SlabHeap size classes", TestClasses);
+    host::Run("SlabHeap exhaustion", TestExhaust);
+    host::Run("SlabHeap page release", TestRelease);
+    host::Run("SlabHeap double free", TestDoubleFree);
+    host::Run("SlabHeap trace replay", TestReplay);
+
+    if (host::IsBench(argc, argv)) {
+        BenchReplay();
+    }
+
+    return host::Finish();
+}
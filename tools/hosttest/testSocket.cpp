@@ -0,0 +1,873 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * SyncSocket/AsyncSocket tests over the fake IOS socket device
+ * (host/hostNet.cpp), and throughput benchmarks against a host echo server:
+ * blocking ping-pong, against asynchronous jobs which keep several messages
+ * in flight.
+ */
+
+namespace {
+
+//! How long to wait for asynchronous jobs
+const u64 scTimeoutNsec = 5ull * 1000 * 1000 * 1000;
+
+/**
+ * @brief Counts completed asynchronous jobs
+ */
+struct Completion {
+    volatile u32 numDone;  // Number of completed jobs
+    volatile u32 numError; // Number of failed jobs
+
+    Completion() : numDone(0), numError(0) {}
+
+    /**
+     * @brief Waits until the specified number of jobs have completed
+     *
+     * @param num Number of jobs
+     * @return Success (FALSE if timed out)
+     */
+    bool Wait(u32 num) const {
+        u64 start = host::GetNanoTime();
+
+        while (__atomic_load_n(&numDone, __ATOMIC_ACQUIRE) < num) {
+            if (host::GetNanoTime() - start > scTimeoutNsec) {
+                return false;
+            }
+
+            usleep(50);
+        }
+
+        return true;
+    }
+};
+
+/**
+ * @brief Job completion callback
+ */
+void CompletionFunc(SOResult result, void* pArg) {
+    Completion* pCompletion = static_cast<Completion*>(pArg);
+
+    if (result != SO_SUCCESS) {
+        __atomic_add_fetch(&pCompletion->numError, 1, __ATOMIC_RELEASE);
+    }
+
+    __atomic_add_fetch(&pCompletion->numDone, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Accepted connection
+ */
+struct AcceptResult {
+    Completion completion;  // Whether the connection was accepted
+    kiwi::SocketBase* pPeer; // Peer socket
+
+    AcceptResult() : pPeer(nullptr) {}
+};
+
+/**
+ * @brief Accept completion callback
+ */
+void AcceptFunc(SOResult result, kiwi::SocketBase* pPeer,
+                const kiwi::SockAddrAny& rAddr, void* pArg) {
+    AcceptResult* pResult = static_cast<AcceptResult*>(pArg);
+    pResult->pPeer = pPeer;
+
+    CompletionFunc(result, &pResult->completion);
+}
+
+/**
+ * @brief Fills a buffer with a pattern which depends on the seed
+ */
+void FillPattern(u8* pBuffer, u32 size, u32 seed) {
+    for (u32 i = 0; i < size; i++) {
+        pBuffer[i] = static_cast<u8>(seed * 31 + i * 7);
+    }
+}
+
+/**
+ * @brief Receives exactly the specified number of bytes (blocking sockets)
+ */
+bool RecvAll(kiwi::SocketBase& rSocket, void* pDst, u32 len) {
+    u8* pBuffer = static_cast<u8*>(pDst);
+
+    for (u32 recv = 0; recv < len;) {
+        kiwi::Optional<u32> result = rSocket.RecvBytes(pBuffer + recv,
+                                                       len - recv);
+        if (!result || *result == 0) {
+            return false;
+        }
+
+        recv += *result;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sends exactly the specified number of bytes (blocking sockets)
+ */
+bool SendAll(kiwi::SocketBase& rSocket, const void* pSrc, u32 len) {
+    const u8* pBuffer = static_cast<const u8*>(pSrc);
+
+    for (u32 sent = 0; sent < len;) {
+        kiwi::Optional<u32> result = rSocket.SendBytes(pBuffer + sent,
+                                                       len - sent);
+        if (!result || *result == 0) {
+            return false;
+        }
+
+        sent += *result;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Creates a listening socket on a random loopback port
+ *
+ * @param rSocket Socket
+ * @param[out] rAddr Listening address
+ */
+bool Listen(kiwi::SocketBase& rSocket, kiwi::SockAddr4& rAddr) {
+    rAddr = kiwi::SockAddr4("127.0.0.1");
+    return rSocket.Bind(rAddr) && rSocket.Listen();
+}
+
+void TestSync() {
+    kiwi::SyncSocket server(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::SyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+
+    kiwi::SockAddr4 addr;
+    HOST_CHECK(Listen(server, addr));
+    HOST_CHECK(addr.port != 0);
+
+    // Connection completes in the backlog, before the accept
+    HOST_CHECK(client.Connect(addr));
+    kiwi::SyncSocket* pPeer = server.Accept();
+    HOST_CHECK(pPeer != nullptr);
+
+    kiwi::SockAddr4 peerAddr;
+    HOST_CHECK(client.GetSocketAddr(peerAddr));
+    HOST_CHECK(pPeer->GetPeerAddr(addr));
+    HOST_CHECK_EQ(addr.port, peerAddr.port);
+
+    u8 send[0x4000];
+    u8 recv[0x4000];
+    FillPattern(send, sizeof(send), 1);
+
+    HOST_CHECK(SendAll(client, send, sizeof(send)));
+    HOST_CHECK(RecvAll(*pPeer, recv, sizeof(recv)));
+    HOST_CHECK(std::memcmp(send, recv, sizeof(send)) == 0);
+
+    // Non-blocking receive with nothing to read
+    HOST_CHECK(pPeer->SetBlocking(false));
+    HOST_CHECK(!pPeer->IsBlocking());
+    kiwi::Optional<u32> empty = pPeer->RecvBytes(recv, sizeof(recv));
+    HOST_CHECK(empty && *empty == 0);
+    HOST_CHECK_EQ(kiwi::LibSO::GetLastError(), SO_EWOULDBLOCK);
+
+    // Peer sees the end of the stream
+    HOST_CHECK(client.Shutdown(SO_SHUT_RDWR));
+    HOST_CHECK(pPeer->SetBlocking(true));
+    kiwi::Optional<u32> end = pPeer->RecvBytes(recv, sizeof(recv));
+    HOST_CHECK(end && *end == 0);
+    HOST_CHECK_EQ(kiwi::LibSO::GetLastError(), SO_SUCCESS);
+
+    delete pPeer;
+}
+
+void TestAsync() {
+    kiwi::AsyncSocket server(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::AsyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+
+    kiwi::SockAddr4 addr;
+    HOST_CHECK(Listen(server, addr));
+
+    AcceptResult accept;
+    Completion connect;
+    server.Accept(AcceptFunc, &accept);
+    client.Connect(addr, CompletionFunc, &connect);
+
+    HOST_CHECK(accept.completion.Wait(1) && connect.Wait(1));
+    HOST_CHECK_EQ(accept.completion.numError + connect.numError, 0);
+    HOST_CHECK(accept.pPeer != nullptr);
+    if (accept.pPeer == nullptr) {
+        return;
+    }
+
+    // Many jobs in flight, in both directions, completed in order
+    const u32 num = 64;
+    const u32 size = 1000;
+
+    u8* pSend = new u8[num * size];
+    u8* pRecv = new u8[num * size];
+    u8* pEchoSend = new u8[num * size];
+    u8* pEchoRecv = new u8[num * size];
+
+    for (u32 i = 0; i < num; i++) {
+        FillPattern(pSend + i * size, size, i);
+        FillPattern(pEchoSend + i * size, size, i + num);
+    }
+
+    Completion sends, recvs;
+    for (u32 i = 0; i < num; i++) {
+        accept.pPeer->RecvBytes(pRecv + i * size, size, CompletionFunc,
+                                &recvs);
+        client.RecvBytes(pEchoRecv + i * size, size, CompletionFunc, &recvs);
+    }
+    for (u32 i = 0; i < num; i++) {
+        client.SendBytes(pSend + i * size, size, CompletionFunc, &sends);
+        accept.pPeer->SendBytes(pEchoSend + i * size, size, CompletionFunc,
+                                &sends);
+    }
+
+    HOST_CHECK(sends.Wait(num * 2) && recvs.Wait(num * 2));
+    HOST_CHECK_EQ(sends.numError + recvs.numError, 0);
+    HOST_CHECK(std::memcmp(pSend, pRecv, num * size) == 0);
+    HOST_CHECK(std::memcmp(pEchoSend, pEchoRecv, num * size) == 0);
+
+    kiwi::AsyncSocket::Stats stats = kiwi::AsyncSocket::GetStats();
+    HOST_CHECK_EQ(stats.queueDepth, 0);
+    HOST_CHECK(stats.maxQueueDepth >= num * 2);
+
+    // Peer closing the connection fails the pending receive
+    Completion aborted;
+    client.RecvBytes(pRecv, size, CompletionFunc, &aborted);
+    delete accept.pPeer;
+    HOST_CHECK(aborted.Wait(1));
+    HOST_CHECK_EQ(aborted.numError, 1);
+
+    delete[] pSend;
+    delete[] pRecv;
+    delete[] pEchoSend;
+    delete[] pEchoRecv;
+}
+
+void TestSyncSegments() {
+    kiwi::SyncSocket server(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::SyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+
+    kiwi::SockAddr4 addr;
+    HOST_CHECK(Listen(server, addr));
+    HOST_CHECK(client.Connect(addr));
+    kiwi::SyncSocket* pPeer = server.Accept();
+    HOST_CHECK(pPeer != nullptr);
+    if (pPeer == nullptr) {
+        return;
+    }
+
+    u8 send[0x2000];
+    u8 recv[0x2000];
+    FillPattern(send, sizeof(send), 2);
+
+    // Small message is gathered, and empty segments are skipped
+    {
+        kiwi::SockSegment out[] = {
+            kiwi::SockSegment(send, 10), kiwi::SockSegment(send + 10, 0),
+            kiwi::SockSegment(send + 10, 20), kiwi::SockSegment(send, 0)};
+
+        kiwi::Optional<u32> sent = client.SendV(out, LENGTHOF(out));
+        HOST_CHECK(sent && *sent == 30);
+
+        std::memset(recv, 0, sizeof(recv));
+        kiwi::SockSegment in[] = {
+            kiwi::SockSegment(recv, 0), kiwi::SockSegment(recv, 12),
+            kiwi::SockSegment(recv + 100, 0),
+            kiwi::SockSegment(recv + 200, 18)};
+
+        kiwi::Optional<u32> got = pPeer->RecvV(in, LENGTHOF(in));
+        HOST_CHECK(got && *got == 30);
+        HOST_CHECK(std::memcmp(recv, send, 12) == 0);
+        HOST_CHECK(std::memcmp(recv + 200, send + 12, 18) == 0);
+        HOST_CHECK_EQ(recv[100], 0);
+    }
+
+    // Segments are filled in order when less data is available
+    {
+        HOST_CHECK(SendAll(client, send, 20));
+
+        std::memset(recv, 0, sizeof(recv));
+        kiwi::SockSegment in[] = {kiwi::SockSegment(recv, 8),
+                                  kiwi::SockSegment(recv + 8, 0),
+                                  kiwi::SockSegment(recv + 100, 32)};
+
+        kiwi::Optional<u32> got = pPeer->RecvV(in, LENGTHOF(in));
+        HOST_CHECK(got && *got == 20);
+        HOST_CHECK(std::memcmp(recv, send, 8) == 0);
+        HOST_CHECK(std::memcmp(recv + 100, send + 8, 12) == 0);
+        HOST_CHECK_EQ(recv[112], 0);
+    }
+
+    // Large message is sent straight from the segments
+    {
+        kiwi::SockSegment out[] = {kiwi::SockSegment(send, 0x800),
+                                   kiwi::SockSegment(send, 0),
+                                   kiwi::SockSegment(send + 0x800, 0x1800)};
+
+        kiwi::Optional<u32> sent = client.SendV(out, LENGTHOF(out));
+        HOST_CHECK(sent && *sent == sizeof(send));
+        HOST_CHECK(RecvAll(*pPeer, recv, sizeof(recv)));
+        HOST_CHECK(std::memcmp(recv, send, sizeof(send)) == 0);
+    }
+
+    delete pPeer;
+
+    // Datagrams are sent whole and split up on arrival
+    kiwi::SyncSocket sender(SO_PF_INET, SO_SOCK_DGRAM);
+    kiwi::SyncSocket receiver(SO_PF_INET, SO_SOCK_DGRAM);
+
+    kiwi::SockAddr4 recvAddr("127.0.0.1");
+    HOST_CHECK(receiver.Bind(recvAddr));
+
+    {
+        kiwi::SockSegment out[] = {kiwi::SockSegment(send, 10),
+                                   kiwi::SockSegment(send, 0),
+                                   kiwi::SockSegment(send + 10, 20)};
+
+        kiwi::Optional<u32> sent = sender.SendVTo(out, LENGTHOF(out),
+                                                  recvAddr);
+        HOST_CHECK(sent && *sent == 30);
+
+        std::memset(recv, 0, sizeof(recv));
+        kiwi::SockSegment in[] = {kiwi::SockSegment(recv, 15),
+                                  kiwi::SockSegment(recv + 50, 0),
+                                  kiwi::SockSegment(recv + 100, 15)};
+
+        kiwi::Optional<u32> got = receiver.RecvV(in, LENGTHOF(in));
+        HOST_CHECK(got && *got == 30);
+        HOST_CHECK(std::memcmp(recv, send, 15) == 0);
+        HOST_CHECK(std::memcmp(recv + 100, send + 15, 15) == 0);
+        HOST_CHECK_EQ(recv[50], 0);
+    }
+
+    // Short datagram only fills the first segments
+    {
+        HOST_CHECK(sender.SendBytesTo(send, 10, recvAddr));
+
+        std::memset(recv, 0, sizeof(recv));
+        kiwi::SockSegment in[] = {kiwi::SockSegment(recv, 4),
+                                  kiwi::SockSegment(recv + 100, 20)};
+
+        kiwi::Optional<u32> got = receiver.RecvV(in, LENGTHOF(in));
+        HOST_CHECK(got && *got == 10);
+        HOST_CHECK(std::memcmp(recv, send, 4) == 0);
+        HOST_CHECK(std::memcmp(recv + 100, send + 4, 6) == 0);
+        HOST_CHECK_EQ(recv[106], 0);
+    }
+}
+
+void TestAsyncSegments() {
+    kiwi::AsyncSocket server(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::AsyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+
+    kiwi::SockAddr4 addr;
+    HOST_CHECK(Listen(server, addr));
+
+    AcceptResult accept;
+    Completion connect;
+    server.Accept(AcceptFunc, &accept);
+    client.Connect(addr, CompletionFunc, &connect);
+
+    HOST_CHECK(accept.completion.Wait(1) && connect.Wait(1));
+    HOST_CHECK(accept.pPeer != nullptr);
+    if (accept.pPeer == nullptr) {
+        return;
+    }
+
+    u8 send[0x2800];
+    u8 recv[0x2800];
+    FillPattern(send, sizeof(send), 3);
+    std::memset(recv, 0, sizeof(recv));
+
+    kiwi::AsyncSocket::ResetStats();
+
+    // Stream receive has one job per non-empty segment, and completes once
+    {
+        kiwi::SockSegment in[] = {
+            kiwi::SockSegment(recv, 100), kiwi::SockSegment(recv + 100, 0),
+            kiwi::SockSegment(recv + 200, 200),
+            kiwi::SockSegment(recv + 400, 300),
+            kiwi::SockSegment(recv + 700, 0)};
+
+        Completion recvs;
+        accept.pPeer->RecvV(in, LENGTHOF(in), CompletionFunc, &recvs);
+        HOST_CHECK_EQ(kiwi::AsyncSocket::GetStats().queueDepth, 3);
+
+        // Small pieces fill each segment over several receives
+        Completion sends;
+        for (u32 i = 0; i < 600; i += 50) {
+            client.SendBytes(send + i, 50, CompletionFunc, &sends);
+            HOST_CHECK(sends.Wait(i / 50 + 1));
+        }
+
+        HOST_CHECK(recvs.Wait(1));
+        HOST_CHECK_EQ(recvs.numDone, 1);
+        HOST_CHECK_EQ(recvs.numError + sends.numError, 0);
+
+        HOST_CHECK(std::memcmp(recv, send, 100) == 0);
+        HOST_CHECK(std::memcmp(recv + 200, send + 100, 500) == 0);
+        HOST_CHECK_EQ(recv[100], 0);
+        HOST_CHECK_EQ(recv[700], 0);
+    }
+
+    // Large send is queued as one job per segment, straight from MEM2
+    {
+        Completion recvs;
+        accept.pPeer->RecvBytes(recv, 0x2000, CompletionFunc, &recvs);
+
+        kiwi::AsyncSocket::ResetStats();
+        u32 depth = kiwi::AsyncSocket::GetStats().queueDepth;
+
+        kiwi::SockSegment out[] = {kiwi::SockSegment(send, 0x800),
+                                   kiwi::SockSegment(send, 0),
+                                   kiwi::SockSegment(send + 0x800, 0x1800)};
+
+        Completion sends;
+        client.SendV(out, LENGTHOF(out), CompletionFunc, &sends);
+
+        HOST_CHECK(sends.Wait(1) && recvs.Wait(1));
+        HOST_CHECK_EQ(sends.numError + recvs.numError, 0);
+        HOST_CHECK(std::memcmp(recv, send, 0x2000) == 0);
+        HOST_CHECK_EQ(kiwi::AsyncSocket::GetStats().maxQueueDepth, depth + 2);
+
+        // Only the last segment completes the operation
+        usleep(1000);
+        HOST_CHECK_EQ(sends.numDone, 1);
+    }
+
+    // Small send is gathered into one job
+    {
+        Completion recvs;
+        accept.pPeer->RecvBytes(recv, 30, CompletionFunc, &recvs);
+
+        kiwi::AsyncSocket::ResetStats();
+        u32 depth = kiwi::AsyncSocket::GetStats().queueDepth;
+
+        kiwi::SockSegment out[] = {kiwi::SockSegment(send + 5, 10),
+                                   kiwi::SockSegment(send, 0),
+                                   kiwi::SockSegment(send + 15, 20)};
+
+        Completion sends;
+        client.SendV(out, LENGTHOF(out), CompletionFunc, &sends);
+
+        HOST_CHECK(sends.Wait(1) && recvs.Wait(1));
+        HOST_CHECK(std::memcmp(recv, send + 5, 30) == 0);
+        HOST_CHECK_EQ(kiwi::AsyncSocket::GetStats().maxQueueDepth, depth + 1);
+    }
+
+    delete accept.pPeer;
+
+    // Datagrams are received whole and split up, even when short
+    kiwi::AsyncSocket receiver(SO_PF_INET, SO_SOCK_DGRAM);
+    kiwi::SyncSocket sender(SO_PF_INET, SO_SOCK_DGRAM);
+
+    kiwi::SockAddr4 recvAddr("127.0.0.1");
+    HOST_CHECK(receiver.Bind(recvAddr));
+
+    {
+        std::memset(recv, 0, sizeof(recv));
+        kiwi::SockSegment in[] = {kiwi::SockSegment(recv, 10),
+                                  kiwi::SockSegment(recv + 50, 0),
+                                  kiwi::SockSegment(recv + 100, 20)};
+
+        Completion full, part;
+        receiver.RecvV(in, LENGTHOF(in), CompletionFunc, &full);
+        HOST_CHECK(sender.SendBytesTo(send, 30, recvAddr));
+        HOST_CHECK(full.Wait(1) && full.numError == 0);
+
+        HOST_CHECK(std::memcmp(recv, send, 10) == 0);
+        HOST_CHECK(std::memcmp(recv + 100, send + 10, 20) == 0);
+        HOST_CHECK_EQ(recv[50], 0);
+
+        std::memset(recv, 0, sizeof(recv));
+        receiver.RecvV(in, LENGTHOF(in), CompletionFunc, &part);
+        HOST_CHECK(sender.SendBytesTo(send + 30, 14, recvAddr));
+        HOST_CHECK(part.Wait(1) && part.numError == 0);
+
+        HOST_CHECK(std::memcmp(recv, send + 30, 10) == 0);
+        HOST_CHECK(std::memcmp(recv + 100, send + 40, 4) == 0);
+        HOST_CHECK_EQ(recv[104], 0);
+    }
+}
+
+void TestAsyncManySockets() {
+    // More sockets than fit in one poll
+    const u32 num = 40;
+
+    kiwi::AsyncSocket* sockets[num];
+    kiwi::SockAddr4 addrs[num];
+    u32 recv[num];
+
+    kiwi::SyncSocket sender(SO_PF_INET, SO_SOCK_DGRAM);
+
+    Completion recvs;
+    for (u32 i = 0; i < num; i++) {
+        sockets[i] = new kiwi::AsyncSocket(SO_PF_INET, SO_SOCK_DGRAM);
+
+        addrs[i] = kiwi::SockAddr4("127.0.0.1");
+        HOST_CHECK(sockets[i]->Bind(addrs[i]));
+
+        recv[i] = 0;
+        sockets[i]->RecvBytes(&recv[i], sizeof(u32), CompletionFunc, &recvs);
+    }
+
+    // Sockets at the end of the list must not be starved by those at the
+    // front, which never become readable (and so never leave the poll)
+    const u32 first = num - 8;
+    for (u32 i = first; i < num; i++) {
+        u32 send = i + 1;
+        HOST_CHECK(sender.SendBytesTo(&send, sizeof(u32), addrs[i]));
+    }
+
+    HOST_CHECK(recvs.Wait(num - first));
+    HOST_CHECK_EQ(recvs.numError, 0);
+
+    for (u32 i = 0; i < num; i++) {
+        HOST_CHECK_EQ(recv[i], i >= first ? i + 1 : 0);
+    }
+
+    for (u32 i = 0; i < num; i++) {
+        delete sockets[i];
+    }
+}
+
+void TestAsyncPollRestart() {
+    kiwi::AsyncSocket idle(SO_PF_INET, SO_SOCK_DGRAM);
+    kiwi::AsyncSocket ready(SO_PF_INET, SO_SOCK_DGRAM);
+    kiwi::SyncSocket sender(SO_PF_INET, SO_SOCK_DGRAM);
+
+    kiwi::SockAddr4 idleAddr("127.0.0.1");
+    kiwi::SockAddr4 readyAddr("127.0.0.1");
+    HOST_CHECK(idle.Bind(idleAddr) && ready.Bind(readyAddr));
+
+    // Keeps a poll in flight for the whole test
+    u32 unused;
+    Completion never;
+    idle.RecvBytes(&unused, sizeof(u32), CompletionFunc, &never);
+
+    kiwi::AsyncSocket::ResetStats();
+
+    u64 maxWait = 0;
+    for (u32 i = 0; i < 10; i++) {
+        u32 send = i;
+        HOST_CHECK(sender.SendBytesTo(&send, sizeof(u32), readyAddr));
+
+        // Data is already there, so the receive shouldn't wait for the poll
+        // in flight to time out
+        u32 recv = 0;
+        Completion done;
+
+        u64 start = host::GetNanoTime();
+        ready.RecvBytes(&recv, sizeof(u32), CompletionFunc, &done);
+        HOST_CHECK(done.Wait(1) && done.numError == 0);
+        maxWait = kiwi::Max(maxWait, host::GetNanoTime() - start);
+
+        HOST_CHECK_EQ(recv, i);
+    }
+
+    // Poll timeout is 500 ms
+    HOST_CHECK(maxWait < 250ull * 1000 * 1000);
+    HOST_CHECK(kiwi::AsyncSocket::GetStats().restarts > 0);
+    HOST_CHECK_EQ(never.numDone, 0);
+}
+
+void TestAsyncSendRing() {
+    kiwi::SyncSocket server(SO_PF_INET, SO_SOCK_STREAM);
+    kiwi::AsyncSocket* pClient =
+        new kiwi::AsyncSocket(SO_PF_INET, SO_SOCK_STREAM);
+
+    kiwi::SockAddr4 addr;
+    HOST_CHECK(Listen(server, addr));
+
+    // Connection completes in the backlog, before the accept
+    Completion connect;
+    pClient->Connect(addr, CompletionFunc, &connect);
+    kiwi::SyncSocket* pPeer = server.Accept();
+    HOST_CHECK(pPeer != nullptr && connect.Wait(1));
+    if (pPeer == nullptr) {
+        return;
+    }
+
+    // Nothing is allocated until the socket sends
+    HOST_CHECK_EQ(pClient->GetRingStats().numPushed, 0);
+
+    // More messages than slots, so some wait for a free slot
+    const u32 num = 64;
+    const u32 size = 1000;
+
+    u8* pSend = new u8[num * size];
+    u8* pRecv = new u8[num * size];
+    for (u32 i = 0; i < num; i++) {
+        FillPattern(pSend + i * size, size, i);
+    }
+
+    Completion sends;
+    for (u32 i = 0; i < num; i++) {
+        pClient->SendBytes(pSend + i * size, size, CompletionFunc, &sends);
+    }
+
+    HOST_CHECK(RecvAll(*pPeer, pRecv, num * size));
+    HOST_CHECK(sends.Wait(num) && sends.numError == 0);
+    HOST_CHECK(std::memcmp(pSend, pRecv, num * size) == 0);
+
+    // Messages which found the ring full went through the heap instead
+    kiwi::PacketRing::Stats stats = pClient->GetRingStats();
+    HOST_CHECK(stats.numPushed > 0);
+    HOST_CHECK_EQ(stats.numPushed + stats.numFull, num);
+    HOST_CHECK_EQ(stats.numPopped, stats.numPushed);
+    HOST_CHECK_EQ(stats.numBytes, stats.numPopped * size);
+    HOST_CHECK(stats.maxUsed <= 16);
+
+    // Once the ring exists, message buffers don't come from the heap
+    pClient->ResetRingStats();
+    host::AllocStats before = host::GetAllocStats();
+
+    Completion small;
+    for (u32 i = 0; i < 8; i++) {
+        pClient->SendBytes(pSend + i * size, size, CompletionFunc, &small);
+        HOST_CHECK(small.Wait(i + 1));
+    }
+
+    HOST_CHECK(host::GetAllocStats().numBytes - before.numBytes < 8 * size);
+    HOST_CHECK(RecvAll(*pPeer, pRecv, 8 * size));
+    HOST_CHECK_EQ(pClient->GetRingStats().numPopped, 8);
+
+    // Messages larger than a slot never use the ring
+    Completion large;
+    pClient->SendBytes(pSend, num * size, CompletionFunc, &large);
+    HOST_CHECK(RecvAll(*pPeer, pRecv, num * size));
+    HOST_CHECK(large.Wait(1) && large.numError == 0);
+    HOST_CHECK_EQ(pClient->GetRingStats().numPushed, 8);
+
+    // Fill the connection up until a ring send can't finish, then destroy the
+    // socket. Its slot must stay valid until IOS aborts the send.
+    Completion blocked;
+    bool isBlocked = false;
+
+    for (u32 i = 0; i < 100000 && !isBlocked; i++) {
+        pClient->SendBytes(pSend, size, CompletionFunc, &blocked);
+
+        u64 start = host::GetNanoTime();
+        while (__atomic_load_n(&blocked.numDone, __ATOMIC_ACQUIRE) <= i) {
+            if (host::GetNanoTime() - start > 50ull * 1000 * 1000) {
+                isBlocked = true;
+                break;
+            }
+
+            sched_yield();
+        }
+    }
+
+    HOST_CHECK(isBlocked);
+    delete pClient;
+
+    // Aborted send destroys the ring (the leak checker catches it if not)
+    usleep(100 * 1000);
+    HOST_CHECK_EQ(kiwi::AsyncSocket::GetStats().queueDepth, 0);
+
+    delete pPeer;
+    delete[] pSend;
+    delete[] pRecv;
+}
+
+/**
+ * @brief Echo server, on the host's own sockets (the PC side)
+ */
+class EchoServer {
+public:
+    EchoServer() {
+        mListenFD = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(sockaddr_in));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t len = sizeof(sockaddr_in);
+        bind(mListenFD, reinterpret_cast<sockaddr*>(&addr), len);
+        listen(mListenFD, 1);
+
+        getsockname(mListenFD, reinterpret_cast<sockaddr*>(&addr), &len);
+        mPort = ntohs(addr.sin_port);
+
+        pthread_create(&mThread, nullptr, ThreadFunc, this);
+    }
+
+    ~EchoServer() {
+        pthread_join(mThread, nullptr);
+        close(mListenFD);
+    }
+
+    kiwi::SockAddr4 GetAddr() const {
+        return kiwi::SockAddr4("127.0.0.1", mPort);
+    }
+
+private:
+    static void* ThreadFunc(void* pArg) {
+        EchoServer* p = static_cast<EchoServer*>(pArg);
+
+        int fd = accept(p->mListenFD, nullptr, nullptr);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        // Echo until the client disconnects
+        u8 buffer[0x10000];
+        ssize_t len;
+        while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            for (ssize_t sent = 0; sent < len;) {
+                ssize_t result = send(fd, buffer + sent, len - sent,
+                                      MSG_NOSIGNAL);
+                if (result <= 0) {
+                    break;
+                }
+
+                sent += result;
+            }
+        }
+
+        close(fd);
+        return nullptr;
+    }
+
+private:
+    int mListenFD;
+    u16 mPort;
+    pthread_t mThread;
+};
+
+/**
+ * @brief Blocking ping-pong: each message waits for its echo
+ */
+void BenchSync(const char* pName, u32 size, u32 num) {
+    EchoServer server;
+    kiwi::SyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+    HOST_CHECK(client.Connect(server.GetAddr()));
+
+    u8* pSend = new u8[size];
+    u8* pRecv = new u8[size];
+    FillPattern(pSend, size, 0);
+
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            HOST_CHECK(SendAll(client, pSend, size));
+            HOST_CHECK(RecvAll(client, pRecv, size));
+        }
+
+        bench.Report(num);
+    }
+
+    HOST_CHECK(std::memcmp(pSend, pRecv, size) == 0);
+
+    delete[] pSend;
+    delete[] pRecv;
+}
+
+/**
+ * @brief Asynchronous jobs, keeping a window of messages in flight
+ */
+void BenchAsync(const char* pName, u32 size, u32 num, u32 window) {
+    EchoServer server;
+    kiwi::AsyncSocket client(SO_PF_INET, SO_SOCK_STREAM);
+
+    Completion connect;
+    client.Connect(server.GetAddr(), CompletionFunc, &connect);
+    HOST_CHECK(connect.Wait(1) && connect.numError == 0);
+
+    u8* pSend = new u8[size];
+    u8* pRecv = new u8[size * window];
+    FillPattern(pSend, size, 0);
+
+    kiwi::AsyncSocket::ResetStats();
+    kiwi::IosDispatcher::ResetStats();
+    client.ResetRingStats();
+    host::IosStats before = host::GetIosStats();
+
+    Completion sends, recvs;
+    {
+        host::Bench bench(pName);
+
+        for (u32 i = 0; i < num; i++) {
+            // Wait for room in the window
+            HOST_CHECK(recvs.Wait(i < window ? 0 : i - window + 1));
+
+            client.RecvBytes(pRecv + (i % window) * size, size,
+                             CompletionFunc, &recvs);
+            client.SendBytes(pSend, size, CompletionFunc, &sends);
+        }
+
+        HOST_CHECK(sends.Wait(num) && recvs.Wait(num));
+        bench.Report(num);
+    }
+
+    HOST_CHECK_EQ(sends.numError + recvs.numError, 0);
+    HOST_CHECK(std::memcmp(pSend, pRecv, size) == 0);
+
+    kiwi::AsyncSocket::Stats socket = kiwi::AsyncSocket::GetStats();
+    kiwi::PacketRing::Stats ring = client.GetRingStats();
+    kiwi::IosDispatcher::Stats dispatcher = kiwi::IosDispatcher::GetStats();
+    host::IosStats after = host::GetIosStats();
+
+    std::printf("  reactor: %lu wakeups, %lu timeouts, %lu restarts, "
+                "max %lu jobs queued\n",
+                socket.wakeups, socket.timeouts, socket.restarts,
+                socket.maxQueueDepth);
+    std::printf("  send ring: %lu sent, %lu full, avg latency %lu us, "
+                "%lu KB/s\n",
+                ring.numPopped, ring.numFull,
+                ring.numPopped > 0 ? ring.totalLatency / ring.numPopped : 0,
+                ring.byteRate / 1024);
+    std::printf("  dispatcher: %lu completed, max %lu pending, %lu wakeups\n",
+                dispatcher.numCompleted, dispatcher.maxPending,
+                dispatcher.numWakeups);
+    std::printf("  fake IOS: %llu async, %llu sync, max %lu in flight\n",
+                after.numAsync - before.numAsync,
+                after.numSync - before.numSync, after.maxInFlight);
+
+    delete[] pSend;
+    delete[] pRecv;
+}
+
+void BenchThroughput() {
+    BenchSync("SyncSocket ping-pong 64 B", 64, 20000);
+    BenchAsync("AsyncSocket window 8 64 B", 64, 20000, 8);
+
+    BenchSync("SyncSocket ping-pong 16 KB", 0x4000, 5000);
+    BenchAsync("AsyncSocket window 8 16 KB", 0x4000, 5000, 8);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+
+    host::Run("SyncSocket loopback", TestSync);
+    host::Run("AsyncSocket loopback", TestAsync);
+    host::Run("SyncSocket scatter/gather", TestSyncSegments);
+    host::Run("AsyncSocket scatter/gather", TestAsyncSegments);
+    host::Run("AsyncSocket many sockets", TestAsyncManySockets);
+    host::Run("AsyncSocket poll restart", TestAsyncPollRestart);
+    host::Run("AsyncSocket send ring", TestAsyncSendRing);
+
+    if (host::IsBench(argc, argv)) {
+        BenchThroughput();
+    }
+
+    return host::Finish();
+}
@@ -0,0 +1,249 @@
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+#include <unistd.h>
+
+#include <cstring>
+
+/**
+ * ThreadPool tests: priority ordering, queue rejection, waiting on tasks, and
+ * draining the queue on destruction.
+ */
+
+namespace {
+
+/**
+ * @brief Task which blocks its worker thread until it is released
+ */
+class GateTask : public kiwi::Task {
+public:
+    GateTask() : mIsOpen(false), mIsEntered(false) {}
+
+    /**
+     * @brief Waits until a worker thread is blocked in the task
+     */
+    void WaitEntered() const {
+        while (!mIsEntered) {
+            usleep(100);
+        }
+    }
+
+    /**
+     * @brief Releases the worker thread
+     */
+    void Open() {
+        mIsOpen = true;
+    }
+
+protected:
+    virtual void Run() {
+        mIsEntered = true;
+
+        while (!mIsOpen) {
+            usleep(100);
+        }
+    }
+
+private:
+    volatile bool mIsOpen;    // Whether the worker thread is released
+    volatile bool mIsEntered; // Whether a worker thread is in the task
+};
+
+/**
+ * @brief Task which records the order it ran in
+ */
+class OrderTask : public kiwi::Task {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param id Task identifier
+     * @param pLog Run order log (only written by one worker thread)
+     * @param pLogNum Number of log entries
+     */
+    OrderTask(char id, char* pLog, u32* pLogNum)
+        : mId(id), mpLog(pLog), mpLogNum(pLogNum) {}
+
+protected:
+    virtual void Run() {
+        mpLog[(*mpLogNum)++] = mId;
+    }
+
+private:
+    char mId;      // Task identifier
+    char* mpLog;   // Run order log
+    u32* mpLogNum; // Number of log entries
+};
+
+/**
+ * @brief Task function which doubles its argument
+ */
+void* Double(void* pArg) {
+    return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(pArg) * 2);
+}
+
+/**
+ * @brief Completion callback which stores the task result
+ */
+void StoreResult(void* pResult, void* pArg) {
+    *static_cast<void**>(pArg) = pResult;
+}
+
+/**
+ * @brief Tasks run by priority, then in submission order
+ */
+void TestPriority() {
+    kiwi::ThreadPool pool(1);
+
+    // Threads don't exist until something is submitted
+    HOST_CHECK_EQ(pool.GetStats().numSubmitted, 0);
+
+    GateTask gate;
+    HOST_CHECK(pool.Submit(gate));
+    gate.WaitEntered();
+
+    char log[8];
+    u32 logNum = 0;
+
+    OrderTask low('L', log, &logNum);
+    OrderTask normal1('n', log, &logNum);
+    OrderTask high1('H', log, &logNum);
+    OrderTask high2('h', log, &logNum);
+    OrderTask normal2('N', log, &logNum);
+
+    HOST_CHECK(pool.Submit(low, kiwi::ThreadPool::EPriority_Low));
+    HOST_CHECK(pool.Submit(normal1, kiwi::ThreadPool::EPriority_Normal));
+    HOST_CHECK(pool.Submit(high1, kiwi::ThreadPool::EPriority_High));
+    HOST_CHECK(pool.Submit(high2, kiwi::ThreadPool::EPriority_High));
+    HOST_CHECK(pool.Submit(normal2, kiwi::ThreadPool::EPriority_Normal));
+
+    HOST_CHECK_EQ(pool.GetStats().numQueued, 5);
+
+    gate.Open();
+    low.Wait();
+
+    HOST_CHECK_EQ(logNum, 5);
+    HOST_CHECK(std::memcmp(log, "HhnNL", 5) == 0);
+
+    kiwi::ThreadPool::Stats stats = pool.GetStats();
+    HOST_CHECK_EQ(stats.numSubmitted, 6);
+    HOST_CHECK_EQ(stats.numQueued, 0);
+    HOST_CHECK_EQ(stats.maxQueued, 5);
+    HOST_CHECK_EQ(stats.numRejected, 0);
+
+    gate.Wait();
+}
+
+/**
+ * @brief A full queue rejects tasks without queueing them
+ */
+void TestReject() {
+    kiwi::ThreadPool pool(1, kiwi::ThreadPool::DEFAULT_STACK_SIZE,
+                          kiwi::ThreadPool::DEFAULT_PRIORITY, 2);
+
+    GateTask gate;
+    HOST_CHECK(pool.Submit(gate));
+    gate.WaitEntered();
+
+    char log[4];
+    u32 logNum = 0;
+
+    OrderTask a('a', log, &logNum);
+    OrderTask b('b', log, &logNum);
+    OrderTask c('c', log, &logNum);
+
+    HOST_CHECK(pool.Submit(a));
+    HOST_CHECK(pool.Submit(b, kiwi::ThreadPool::EPriority_Low));
+
+    // Priority doesn't matter once the queue is full
+    HOST_CHECK(!pool.Submit(c, kiwi::ThreadPool::EPriority_High));
+    HOST_CHECK_EQ(c.GetState(), kiwi::Task::EState_Idle);
+    HOST_CHECK_EQ(pool.GetStats().numRejected, 1);
+
+    gate.Open();
+    b.Wait();
+
+    HOST_CHECK_EQ(logNum, 2);
+    HOST_CHECK(std::memcmp(log, "ab", 2) == 0);
+
+    // Rejected task can be submitted once there is room
+    HOST_CHECK(pool.Submit(c));
+    c.Wait();
+
+    HOST_CHECK_EQ(logNum, 3);
+    HOST_CHECK_EQ(log[2], 'c');
+
+    gate.Wait();
+}
+
+/**
+ * @brief Waiting returns once the result and callback are done
+ */
+void TestWait() {
+    kiwi::ThreadPool pool(2);
+
+    void* pCallbackResult = nullptr;
+    kiwi::FuncTask task(Double, reinterpret_cast<void*>(21), StoreResult,
+                        &pCallbackResult);
+
+    HOST_CHECK_EQ(task.GetState(), kiwi::Task::EState_Idle);
+    HOST_CHECK(pool.Submit(task));
+
+    task.Wait();
+    HOST_CHECK(task.IsDone());
+    HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(task.GetResult()), 42);
+    HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(pCallbackResult), 42);
+
+    // Waiting on a finished task returns right away
+    task.Wait();
+
+    // Tasks can be submitted again once they are done
+    pCallbackResult = nullptr;
+    HOST_CHECK(pool.Submit(task, kiwi::ThreadPool::EPriority_High));
+    task.Wait();
+    HOST_CHECK_EQ(reinterpret_cast<uintptr_t>(pCallbackResult), 42);
+    HOST_CHECK_EQ(pool.GetStats().numCompleted, 2);
+}
+
+/**
+ * @brief Queued tasks still run when the pool is destroyed
+ */
+void TestDrain() {
+    char log[4];
+    u32 logNum = 0;
+
+    GateTask gate;
+    OrderTask a('a', log, &logNum);
+    OrderTask b('b', log, &logNum);
+
+    {
+        kiwi::ThreadPool pool(1);
+
+        HOST_CHECK(pool.Submit(gate));
+        gate.WaitEntered();
+
+        HOST_CHECK(pool.Submit(a));
+        HOST_CHECK(pool.Submit(b));
+
+        gate.Open();
+    }
+
+    HOST_CHECK(gate.IsDone());
+    HOST_CHECK(a.IsDone());
+    HOST_CHECK(b.IsDone());
+    HOST_CHECK_EQ(logNum, 2);
+
+    // Unused pool never starts its threads
+    kiwi::ThreadPool unused(2);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("ThreadPool priority order", TestPriority);
+    host::Run("ThreadPool queue rejection", TestReject);
+    host::Run("ThreadPool task wait", TestWait);
+    host::Run("ThreadPool destroy drains queue", TestDrain);
+
+    return host::Finish();
+}
@@ -0,0 +1,276 @@
+#include "host/hostTest.h"
+
+#include <libkiwi/prim/kiwiVector.h>
+
+/**
+ * TVector tests and benchmarks (push/insert/erase throughput).
+ *
+ * Build with LIBKIWI_VECTOR_GROWTH_PERCENT=100 (the Makefile's
+ * testVectorLinear) to grow one element at a time, like TVector did before
+ * it grew geometrically.
+ */
+
+namespace {
+
+/**
+ * @brief Element which tracks its own lifetime
+ * @details Not trivially relocatable, so TVector has to move it element-wise
+ */
+class Tracked {
+public:
+    static s32 sNumLive; // Number of constructed objects
+
+    explicit Tracked(u32 value = 0) : mValue(value), mpSelf(this) {
+        sNumLive++;
+    }
+
+    Tracked(const Tracked& rOther) : mValue(rOther.mValue), mpSelf(this) {
+        HOST_CHECK(rOther.IsValid());
+        sNumLive++;
+    }
+
+    ~Tracked() {
+        HOST_CHECK(IsValid());
+        mpSelf = nullptr;
+        sNumLive--;
+    }
+
+    Tracked& operator=(const Tracked& rOther) {
+        HOST_CHECK(IsValid() && rOther.IsValid());
+        mValue = rOther.mValue;
+        return *this;
+    }
+
+    bool operator==(const Tracked& rOther) const {
+        return mValue == rOther.mValue;
+    }
+
+    // Objects which were moved byte-wise no longer point to themselves
+    bool IsValid() const {
+        return mpSelf == this;
+    }
+
+    u32 GetValue() const {
+        return mValue;
+    }
+
+private:
+    u32 mValue;            // Element value
+    const Tracked* mpSelf; // Address the object was constructed at
+};
+
+s32 Tracked::sNumLive = 0;
+
+void TestPushBack() {
+    {
+        kiwi::TVector<Tracked> v;
+
+        for (u32 i = 0; i < 1000; i++) {
+            v.PushBack(Tracked(i));
+        }
+
+        HOST_CHECK_EQ(v.Size(), 1000);
+        HOST_CHECK(v.Capacity() >= v.Size());
+
+        for (u32 i = 0; i < v.Size(); i++) {
+            HOST_CHECK(v[i].IsValid());
+            HOST_CHECK_EQ(v[i].GetValue(), i);
+        }
+
+        HOST_CHECK_EQ(Tracked::sNumLive, 1000);
+    }
+
+    HOST_CHECK_EQ(Tracked::sNumLive, 0);
+}
+
+void TestInsertRemove() {
+    {
+        kiwi::TVector<Tracked> v;
+
+        for (u32 i = 0; i < 10; i++) {
+            v.PushBack(Tracked(i));
+        }
+
+        v.Insert(Tracked(100), 0);
+        v.Insert(Tracked(200), 5);
+        v.Insert(Tracked(300), v.Size());
+
+        HOST_CHECK_EQ(v.Size(), 13);
+        HOST_CHECK_EQ(v[0].GetValue(), 100);
+        HOST_CHECK_EQ(v[5].GetValue(), 200);
+        HOST_CHECK_EQ(v[12].GetValue(), 300);
+        HOST_CHECK_EQ(v[1].GetValue(), 0);
+        HOST_CHECK_EQ(v[6].GetValue(), 4);
+
+        v.RemoveAt(5);
+        v.RemoveAt(0);
+        HOST_CHECK(v.Remove(Tracked(300)));
+        HOST_CHECK(!v.Remove(Tracked(300)));
+
+        HOST_CHECK_EQ(v.Size(), 10);
+        for (u32 i = 0; i < v.Size(); i++) {
+            HOST_CHECK(v[i].IsValid());
+            HOST_CHECK_EQ(v[i].GetValue(), i);
+        }
+
+        HOST_CHECK_EQ(Tracked::sNumLive, 10);
+    }
+
+    HOST_CHECK_EQ(Tracked::sNumLive, 0);
+}
+
+void TestSelfInsert() {
+    kiwi::TVector<Tracked> v;
+
+    // Inserting an element of the vector itself, while it has to grow
+    for (u32 i = 0; i < 64; i++) {
+        v.PushBack(Tracked(i));
+        v.PushBack(v[0]);
+    }
+
+    HOST_CHECK_EQ(v.Size(), 128);
+    HOST_CHECK_EQ(v[1].GetValue(), 0);
+    HOST_CHECK_EQ(v[127].GetValue(), 0);
+
+    // Inserting an element which is about to be moved
+    v.Insert(v[10], 0);
+    HOST_CHECK_EQ(v[0].GetValue(), v[11].GetValue());
+}
+
+void TestAppendShrink() {
+    kiwi::TVector<u32> v;
+    u32 values[100];
+
+    for (u32 i = 0; i < LENGTHOF(values); i++) {
+        values[i] = i;
+    }
+
+    v.Append(values, LENGTHOF(values));
+    v.Append(values, values + 10);
+    HOST_CHECK_EQ(v.Size(), 110);
+    HOST_CHECK_EQ(v[100], 0);
+    HOST_CHECK_EQ(v[109], 9);
+
+    kiwi::TVector<u32> copy(v);
+    v.Append(copy);
+    HOST_CHECK_EQ(v.Size(), 220);
+    HOST_CHECK_EQ(v[219], 9);
+
+    for (u32 i = 0; i < 200; i++) {
+        v.PopBack();
+    }
+
+    v.ShrinkToFit();
+    HOST_CHECK_EQ(v.Size(), 20);
+    HOST_CHECK_EQ(v.Capacity(), 20);
+    HOST_CHECK_EQ(v[19], 19);
+
+    v.Clear();
+    v.ShrinkToFit();
+    HOST_CHECK(v.Empty());
+    HOST_CHECK_EQ(v.Capacity(), 0);
+}
+
+void TestEmplaceBack() {
+    {
+        kiwi::TVector<Tracked> v;
+
+        Tracked& rFirst = v.EmplaceBack();
+        HOST_CHECK_EQ(rFirst.GetValue(), 0);
+
+        for (u32 i = 1; i < 100; i++) {
+            HOST_CHECK_EQ(v.EmplaceBack(i).GetValue(), i);
+        }
+
+        HOST_CHECK_EQ(v.Size(), 100);
+        HOST_CHECK_EQ(Tracked::sNumLive, 100);
+    }
+
+    HOST_CHECK_EQ(Tracked::sNumLive, 0);
+}
+
+void BenchPushBack(u32 num) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "PushBack u32 x%lu", num);
+
+    host::Bench bench(name);
+    kiwi::TVector<u32> v;
+
+    for (u32 i = 0; i < num; i++) {
+        v.PushBack(i);
+    }
+
+    host::Consume(v.Data());
+    bench.Report(num);
+}
+
+void BenchPushBackTracked(u32 num) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "PushBack Tracked x%lu", num);
+
+    host::Bench bench(name);
+    kiwi::TVector<Tracked> v;
+
+    for (u32 i = 0; i < num; i++) {
+        v.PushBack(Tracked(i));
+    }
+
+    host::Consume(v.Data());
+    bench.Report(num);
+}
+
+void BenchInsertFront(u32 num) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "Insert front u32 x%lu", num);
+
+    host::Bench bench(name);
+    kiwi::TVector<u32> v;
+
+    for (u32 i = 0; i < num; i++) {
+        v.Insert(i, 0);
+    }
+
+    host::Consume(v.Data());
+    bench.Report(num);
+}
+
+void BenchEraseFront(u32 num) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "RemoveAt front u32 x%lu", num);
+
+    kiwi::TVector<u32> v(num);
+    for (u32 i = 0; i < num; i++) {
+        v.PushBack(i);
+    }
+
+    host::Bench bench(name);
+
+    while (!v.Empty()) {
+        v.RemoveAt(0);
+    }
+
+    host::Consume(v.Data());
+    bench.Report(num);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::Run("TVector PushBack", TestPushBack);
+    host::Run("TVector Insert/Remove", TestInsertRemove);
+    host::Run("TVector self-insert", TestSelfInsert);
+    host::Run("TVector Append/ShrinkToFit", TestAppendShrink);
+    host::Run("TVector EmplaceBack", TestEmplaceBack);
+
+    if (host::IsBench(argc, argv)) {
+        std::printf("Growth factor: %d%%\n", LIBKIWI_VECTOR_GROWTH_PERCENT);
+
+        BenchPushBack(1000);
+        BenchPushBack(20000);
+        BenchPushBackTracked(20000);
+        BenchInsertFront(10000);
+        BenchEraseFront(10000);
+    }
+
+    return host::Finish();
+}
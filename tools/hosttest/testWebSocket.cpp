@@ -0,0 +1,821 @@
+#include "host/hostIOS.h"
+#include "host/hostTest.h"
+
+#include <libkiwi.h>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * WebSocket tests against a host echo server, and benchmarks of the payload
+ * masking (a word at a time, against one byte at a time) and of message
+ * round trips and throughput.
+ */
+
+namespace {
+
+//! How long to wait for asynchronous operations
+const u64 scTimeoutNsec = 5ull * 1000 * 1000 * 1000;
+
+/**
+ * @brief Fills a buffer with a pattern which depends on the seed
+ */
+void FillPattern(u8* pBuffer, u32 size, u32 seed) {
+    for (u32 i = 0; i < size; i++) {
+        pBuffer[i] = static_cast<u8>(seed * 31 + i * 7);
+    }
+}
+
+/**
+ * @brief Masks payload data one byte at a time (the reference)
+ */
+void MaskBytes(u8* pData, u32 size, const u8* pKey, u32 phase) {
+    for (u32 i = 0; i < size; i++) {
+        pData[i] ^= pKey[(phase + i) % 4];
+    }
+}
+
+/**
+ * @brief Computes the 'Sec-WebSocket-Accept' value for a client key
+ */
+std::string MakeAccept(const std::string& rKey) {
+    std::string key = rKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    u8 digest[kiwi::SHA1::DIGEST_SIZE];
+    kiwi::SHA1 sha;
+    sha.Process(key.data(), key.size());
+    sha.Finalize(digest);
+
+    return kiwi::B64Encode(digest, sizeof(digest)).CStr();
+}
+
+/**
+ * @brief WebSocket echo server, on the host's own sockets (the PC side)
+ * @details Serves one connection at a time. Data frames are echoed back
+ * as they arrive (so fragmented messages come back fragmented), with a ping
+ * after every non-final frame. The text message "big <n>" is answered with
+ * one n-byte binary frame.
+ */
+class EchoServer {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param badAccept Whether to answer the upgrade with the wrong key
+     */
+    explicit EchoServer(bool badAccept = false)
+        : mIsBadAccept(badAccept),
+          mIsRunning(true),
+          mNumConnections(0),
+          mNumPings(0),
+          mNumPongs(0),
+          mNumUnmasked(0),
+          mCloseCode(0) {
+
+        mListenFD = socket(AF_INET, SOCK_STREAM, 0);
+
+        int reuse = 1;
+        setsockopt(mListenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(int));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(sockaddr_in));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t len = sizeof(sockaddr_in);
+        bind(mListenFD, reinterpret_cast<sockaddr*>(&addr), len);
+        listen(mListenFD, 16);
+
+        getsockname(mListenFD, reinterpret_cast<sockaddr*>(&addr), &len);
+        mPort = ntohs(addr.sin_port);
+
+        pthread_create(&mThread, nullptr, ThreadFunc, this);
+    }
+
+    /**
+     * @brief Destructor
+     */
+    ~EchoServer() {
+        __atomic_store_n(&mIsRunning, false, __ATOMIC_RELEASE);
+        pthread_join(mThread, nullptr);
+        close(mListenFD);
+    }
+
+    /**
+     * @brief Gets the server address
+     */
+    kiwi::SockAddr4 GetAddr() const {
+        kiwi::SockAddr4 addr("127.0.0.1");
+        addr.port = mPort;
+        return addr;
+    }
+
+    /**
+     * @brief Gets the number of connections upgraded
+     */
+    u32 GetNumConnections() const {
+        return __atomic_load_n(&mNumConnections, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * @brief Gets the number of pings received
+     */
+    u32 GetNumPings() const {
+        return __atomic_load_n(&mNumPings, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * @brief Gets the number of pongs received for the server's pings
+     */
+    u32 GetNumPongs() const {
+        return __atomic_load_n(&mNumPongs, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * @brief Gets the number of frames received without a masking key
+     */
+    u32 GetNumUnmasked() const {
+        return __atomic_load_n(&mNumUnmasked, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * @brief Gets the status code of the last close frame received
+     */
+    u16 GetCloseCode() const {
+        return __atomic_load_n(&mCloseCode, __ATOMIC_ACQUIRE);
+    }
+
+private:
+    /**
+     * @brief Receives exactly the specified number of bytes
+     *
+     * @return Success (false if the connection or server is closing)
+     */
+    bool RecvAll(int fd, void* pDst, size_t size) {
+        u8* pBytes = static_cast<u8*>(pDst);
+
+        while (size > 0) {
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+
+            if (poll(&pfd, 1, 10) <= 0) {
+                if (!__atomic_load_n(&mIsRunning, __ATOMIC_ACQUIRE)) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            ssize_t len = recv(fd, pBytes, size, 0);
+            if (len <= 0) {
+                return false;
+            }
+
+            pBytes += len;
+            size -= len;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Sends all of the specified data
+     *
+     * @return Success
+     */
+    static bool SendAll(int fd, const void* pSrc, size_t size) {
+        const u8* pBytes = static_cast<const u8*>(pSrc);
+
+        while (size > 0) {
+            ssize_t len = send(fd, pBytes, size, MSG_NOSIGNAL);
+            if (len <= 0) {
+                return false;
+            }
+
+            pBytes += len;
+            size -= len;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Sends an unmasked frame
+     *
+     * @return Success
+     */
+    static bool SendFrame(int fd, u8 opcode, const void* pData, size_t size,
+                          bool fin) {
+        u8 header[10];
+        u32 headerSize = 2;
+
+        header[0] = (fin ? 0x80 : 0x00) | opcode;
+
+        // Extended lengths are big endian
+        if (size < 126) {
+            header[1] = static_cast<u8>(size);
+        } else if (size <= 0xFFFF) {
+            header[1] = 126;
+            header[2] = static_cast<u8>(size >> 8);
+            header[3] = static_cast<u8>(size);
+            headerSize = 4;
+        } else {
+            header[1] = 127;
+            for (int i = 0; i < 8; i++) {
+                header[2 + i] = static_cast<u8>(
+                    static_cast<u64>(size) >> ((7 - i) * 8));
+            }
+            headerSize = 10;
+        }
+
+        // One send, so Nagle's algorithm doesn't hold back the payload
+        std::string frame(reinterpret_cast<char*>(header), headerSize);
+        frame.append(static_cast<const char*>(pData), size);
+
+        return SendAll(fd, frame.data(), frame.size());
+    }
+
+    /**
+     * @brief Performs the HTTP upgrade
+     * @note libkiwi ends lines with LF, other clients with CRLF
+     *
+     * @return Success
+     */
+    bool Upgrade(int fd) {
+        std::string request;
+
+        while (request.find("\n\n") == std::string::npos &&
+               request.find("\r\n\r\n") == std::string::npos) {
+            char c;
+            if (!RecvAll(fd, &c, 1)) {
+                return false;
+            }
+
+            request += c;
+        }
+
+        const char* pField = "Sec-WebSocket-Key: ";
+        size_t start = request.find(pField);
+        if (start == std::string::npos) {
+            return false;
+        }
+
+        start += std::strlen(pField);
+        size_t end = request.find_first_of("\r\n", start);
+        std::string accept = MakeAccept(request.substr(start, end - start));
+
+        if (mIsBadAccept) {
+            accept[0] = accept[0] == 'A' ? 'B' : 'A';
+        }
+
+        std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                               "Upgrade: websocket\r\n"
+                               "Connection: Upgrade\r\n"
+                               "Sec-WebSocket-Accept: " +
+                               accept + "\r\n\r\n";
+
+        return SendAll(fd, response.data(), response.size());
+    }
+
+    /**
+     * @brief Echoes frames until the connection is closed
+     */
+    void Serve(int fd) {
+        if (!Upgrade(fd)) {
+            return;
+        }
+
+        __atomic_add_fetch(&mNumConnections, 1, __ATOMIC_RELEASE);
+
+        std::vector<u8> payload;
+
+        for (;;) {
+            u8 header[2];
+            if (!RecvAll(fd, header, sizeof(header))) {
+                return;
+            }
+
+            bool fin = (header[0] & 0x80) != 0;
+            u8 opcode = header[0] & 0x0F;
+            bool masked = (header[1] & 0x80) != 0;
+
+            u64 size = header[1] & 0x7F;
+            if (size >= 126) {
+                u8 ext[8];
+                u32 extSize = size == 126 ? 2 : 8;
+
+                if (!RecvAll(fd, ext, extSize)) {
+                    return;
+                }
+
+                size = 0;
+                for (u32 i = 0; i < extSize; i++) {
+                    size = size << 8 | ext[i];
+                }
+            }
+
+            u8 key[4] = {};
+            if (masked && !RecvAll(fd, key, sizeof(key))) {
+                return;
+            }
+
+            if (!masked) {
+                __atomic_add_fetch(&mNumUnmasked, 1, __ATOMIC_RELEASE);
+            }
+
+            payload.resize(size);
+            if (size > 0 && !RecvAll(fd, payload.data(), size)) {
+                return;
+            }
+
+            MaskBytes(payload.data(), size, key, 0);
+
+            switch (opcode) {
+            case 0x0:
+            case 0x1:
+            case 0x2: {
+                std::string text(payload.begin(), payload.end());
+
+                if (opcode == 0x1 && fin && text.compare(0, 4, "big ") == 0) {
+                    std::vector<u8> big(std::atoi(text.c_str() + 4));
+                    FillPattern(big.data(), big.size(), big.size());
+                    SendFrame(fd, 0x2, big.data(), big.size(), true);
+                    break;
+                }
+
+                SendFrame(fd, opcode, payload.data(), size, fin);
+
+                // Control frames may come between fragments
+                if (!fin) {
+                    SendFrame(fd, 0x9, "mid", 3, true);
+                }
+                break;
+            }
+
+            case 0x8: {
+                u16 code = size >= 2 ? payload[0] << 8 | payload[1] : 1005;
+                __atomic_store_n(&mCloseCode, code, __ATOMIC_RELEASE);
+
+                // Echo the status code to complete the handshake
+                SendFrame(fd, 0x8, payload.data(), kiwi::Min<u64>(size, 2),
+                          true);
+                return;
+            }
+
+            case 0x9: {
+                __atomic_add_fetch(&mNumPings, 1, __ATOMIC_RELEASE);
+                SendFrame(fd, 0xA, payload.data(), size, true);
+                break;
+            }
+
+            case 0xA: {
+                if (size == 3 && std::memcmp(payload.data(), "mid", 3) == 0) {
+                    __atomic_add_fetch(&mNumPongs, 1, __ATOMIC_RELEASE);
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    static void* ThreadFunc(void* pArg) {
+        EchoServer* p = static_cast<EchoServer*>(pArg);
+
+        while (__atomic_load_n(&p->mIsRunning, __ATOMIC_ACQUIRE)) {
+            pollfd pfd;
+            pfd.fd = p->mListenFD;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+
+            if (poll(&pfd, 1, 10) <= 0) {
+                continue;
+            }
+
+            int fd = accept(p->mListenFD, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+
+            p->Serve(fd);
+            close(fd);
+        }
+
+        return nullptr;
+    }
+
+private:
+    int mListenFD;     // Listening socket
+    u16 mPort;         // Listening port
+    bool mIsBadAccept; // Whether to send the wrong accept key
+    pthread_t mThread; // Server thread
+
+    volatile bool mIsRunning;     // Whether the server thread should run
+    volatile u32 mNumConnections; // Connections upgraded
+    volatile u32 mNumPings;       // Pings received
+    volatile u32 mNumPongs;       // Pongs received for the server's pings
+    volatile u32 mNumUnmasked;    // Frames received without a masking key
+    volatile u16 mCloseCode;      // Last close status code received
+};
+
+/**
+ * @brief Waits until a counter reaches the specified value
+ *
+ * @return Success (FALSE if timed out)
+ */
+bool WaitFor(const volatile u32& rCount, u32 num) {
+    u64 start = host::GetNanoTime();
+
+    while (__atomic_load_n(&rCount, __ATOMIC_ACQUIRE) < num) {
+        if (host::GetNanoTime() - start > scTimeoutNsec) {
+            return false;
+        }
+
+        usleep(50);
+    }
+
+    return true;
+}
+
+/**
+ * @brief WebSocket with its callback results
+ */
+class Client {
+public:
+    Client() : numConnect(0), numClose(0), numMessages(0) {
+        pthread_mutex_init(&mMutex, nullptr);
+
+        socket.SetMessageCallback(MessageFunc, this);
+        socket.SetCloseCallback(CloseFunc, this);
+    }
+
+    ~Client() {
+        pthread_mutex_destroy(&mMutex);
+    }
+
+    /**
+     * @brief Connects to the specified server
+     *
+     * @return Connect result
+     */
+    kiwi::WebSocket::EResult Connect(const EchoServer& rServer) {
+        socket.Connect(rServer.GetAddr(), ConnectFunc, this);
+
+        if (!WaitFor(numConnect, 1)) {
+            return kiwi::WebSocket::EResult_Socket;
+        }
+
+        return connectResult;
+    }
+
+    /**
+     * @brief Gets a copy of the specified received message
+     */
+    std::string GetMessage(u32 index, kiwi::WebSockMessage::EType* pType) {
+        pthread_mutex_lock(&mMutex);
+
+        std::string data = mMessages[index];
+        if (pType != nullptr) {
+            *pType = mTypes[index];
+        }
+
+        pthread_mutex_unlock(&mMutex);
+        return data;
+    }
+
+public:
+    kiwi::WebSocket socket; // Socket under test
+
+    volatile u32 numConnect;  // Number of connect callbacks
+    volatile u32 numClose;    // Number of close callbacks
+    volatile u32 numMessages; // Number of messages received
+
+    kiwi::WebSocket::EResult connectResult; // Last connect result
+    kiwi::WebSocket::EResult closeResult;   // Last close result
+
+private:
+    static void ConnectFunc(kiwi::WebSocket::EResult result, void* pArg) {
+        Client* p = static_cast<Client*>(pArg);
+        p->connectResult = result;
+        __atomic_add_fetch(&p->numConnect, 1, __ATOMIC_RELEASE);
+    }
+
+    static void CloseFunc(kiwi::WebSocket::EResult result, void* pArg) {
+        Client* p = static_cast<Client*>(pArg);
+        p->closeResult = result;
+        __atomic_add_fetch(&p->numClose, 1, __ATOMIC_RELEASE);
+    }
+
+    static void MessageFunc(const kiwi::WebSockMessage* pMessage, void* pArg) {
+        Client* p = static_cast<Client*>(pArg);
+
+        // Text messages are also null-terminated
+        HOST_CHECK_EQ(pMessage->pData[pMessage->size], '\0');
+
+        pthread_mutex_lock(&p->mMutex);
+        p->mMessages.push_back(std::string(
+            reinterpret_cast<const char*>(pMessage->pData), pMessage->size));
+        p->mTypes.push_back(pMessage->type);
+        pthread_mutex_unlock(&p->mMutex);
+
+        __atomic_add_fetch(&p->numMessages, 1, __ATOMIC_RELEASE);
+    }
+
+private:
+    pthread_mutex_t mMutex;                          // Message list lock
+    std::vector<std::string> mMessages;              // Received messages
+    std::vector<kiwi::WebSockMessage::EType> mTypes; // Message types
+};
+
+void TestAccept() {
+    // Sample handshake from RFC 6455
+    HOST_CHECK(MakeAccept("dGhlIHNhbXBsZSBub25jZQ==") ==
+               "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+
+    // Hex digest is printed in full
+    HOST_CHECK(kiwi::SHA1Hash("abc", 3) ==
+               "A9993E364706816ABA3E25717850C26C9CD0D89D");
+}
+
+void TestMask() {
+    const u8 key[4] = {0x12, 0x34, 0x56, 0x78};
+
+    u8 data[256 + 16], expected[256 + 16];
+
+    // Every alignment, phase and tail length
+    for (u32 offset = 0; offset < 16; offset++) {
+        for (u32 phase = 0; phase < 4; phase++) {
+            for (u32 size = 0; size <= 256; size += 1 + size / 8) {
+                FillPattern(data, sizeof(data), size);
+                FillPattern(expected, sizeof(expected), size);
+
+                kiwi::detail::WebSockMask(data + offset, size, key, phase);
+                MaskBytes(expected + offset, size, key, phase);
+
+                HOST_CHECK(std::memcmp(data, expected, sizeof(data)) == 0);
+            }
+        }
+    }
+}
+
+void TestConnect() {
+    EchoServer server;
+    Client client;
+
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+    HOST_CHECK(client.socket.IsOpen());
+    HOST_CHECK_EQ(server.GetNumConnections(), 1);
+
+    // Wrong server key is rejected
+    EchoServer bad(true);
+    Client rejected;
+
+    HOST_CHECK_EQ(rejected.Connect(bad), kiwi::WebSocket::EResult_CantAccept);
+    HOST_CHECK(!rejected.socket.IsOpen());
+}
+
+void TestEcho() {
+    EchoServer server;
+    Client client;
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+
+    kiwi::WebSockMessage::EType type;
+
+    HOST_CHECK(client.socket.SendText("Hello, world!"));
+    HOST_CHECK(WaitFor(client.numMessages, 1));
+    HOST_CHECK(client.GetMessage(0, &type) == "Hello, world!");
+    HOST_CHECK_EQ(type, kiwi::WebSockMessage::EType_Text);
+
+    // Every length encoding, and messages fragmented by the client (over
+    // 4096 bytes), which come back fragmented with pings in between
+    static const u32 scSizes[] = {0,    1,    125,  126,  1000,
+                                  4096, 4097, 9000, 65535};
+
+    std::vector<u8> data(65535);
+    u32 numFragmented = 0;
+
+    for (u32 i = 0; i < LENGTHOF(scSizes); i++) {
+        FillPattern(data.data(), scSizes[i], i);
+        HOST_CHECK(client.socket.SendBinary(data.data(), scSizes[i]));
+        HOST_CHECK(WaitFor(client.numMessages, i + 2));
+
+        std::string echo = client.GetMessage(i + 1, &type);
+        HOST_CHECK_EQ(type, kiwi::WebSockMessage::EType_Binary);
+        HOST_CHECK_EQ(echo.size(), scSizes[i]);
+        HOST_CHECK(std::memcmp(echo.data(), data.data(), scSizes[i]) == 0);
+
+        numFragmented += (scSizes[i] + 4095) / 4096 - (scSizes[i] > 0);
+    }
+
+    // Pings between fragments were answered
+    u64 start = host::GetNanoTime();
+    while (server.GetNumPongs() < numFragmented &&
+           host::GetNanoTime() - start < scTimeoutNsec) {
+        usleep(50);
+    }
+
+    HOST_CHECK_EQ(server.GetNumPongs(), numFragmented);
+    HOST_CHECK_EQ(server.GetNumUnmasked(), 0);
+}
+
+void TestLargeFrame() {
+    EchoServer server;
+    Client client;
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+
+    // One frame with a 64-bit length
+    HOST_CHECK(client.socket.SendText("big 60000"));
+    HOST_CHECK(WaitFor(client.numMessages, 1));
+
+    std::vector<u8> expected(60000);
+    FillPattern(expected.data(), expected.size(), expected.size());
+
+    std::string big = client.GetMessage(0, nullptr);
+    HOST_CHECK_EQ(big.size(), expected.size());
+    HOST_CHECK(std::memcmp(big.data(), expected.data(), big.size()) == 0);
+
+    // Messages over the limit close the connection
+    client.socket.SetMaxMessageSize(1000);
+    HOST_CHECK(client.socket.SendText("big 2000"));
+    HOST_CHECK(WaitFor(client.numClose, 1));
+
+    HOST_CHECK_EQ(client.closeResult, kiwi::WebSocket::EResult_Protocol);
+    HOST_CHECK_EQ(client.socket.GetCloseCode(),
+                  kiwi::WebSocket::ECloseCode_TooBig);
+    HOST_CHECK(!client.socket.IsOpen());
+    HOST_CHECK_EQ(client.numMessages, 1);
+}
+
+void TestPingClose() {
+    EchoServer server;
+    Client client;
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+
+    HOST_CHECK(client.socket.Ping());
+
+    // Messages still flow around the ping
+    HOST_CHECK(client.socket.SendText("after ping"));
+    HOST_CHECK(WaitFor(client.numMessages, 1));
+    HOST_CHECK_EQ(server.GetNumPings(), 1);
+
+    HOST_CHECK(client.socket.Close(4000));
+    HOST_CHECK(WaitFor(client.numClose, 1));
+
+    HOST_CHECK_EQ(client.closeResult, kiwi::WebSocket::EResult_Success);
+    HOST_CHECK_EQ(client.socket.GetCloseCode(), 4000);
+    HOST_CHECK_EQ(server.GetCloseCode(), 4000);
+
+    // Nothing can be sent once closed
+    HOST_CHECK(!client.socket.SendText("too late"));
+    HOST_CHECK(!client.socket.Ping());
+}
+
+/**
+ * @brief Masks a buffer repeatedly, a word at a time and a byte at a time
+ */
+void BenchMask(u32 size, u32 num) {
+    const u8 key[4] = {0x12, 0x34, 0x56, 0x78};
+
+    // Payloads start word-aligned in the send buffer
+    std::vector<u8> data(size);
+    FillPattern(data.data(), size, 0);
+
+    char name[64];
+    double wordTime, byteTime;
+
+    {
+        std::snprintf(name, sizeof(name), "WebSockMask (words) %lu B", size);
+        host::Bench bench(name);
+        u64 start = host::GetNanoTime();
+
+        for (u32 i = 0; i < num; i++) {
+            kiwi::detail::WebSockMask(data.data(), size, key, i);
+            host::Consume(data.data());
+        }
+
+        wordTime = static_cast<double>(host::GetNanoTime() - start);
+        bench.Report(num);
+    }
+
+    {
+        std::snprintf(name, sizeof(name), "MaskBytes (reference) %lu B", size);
+        host::Bench bench(name);
+        u64 start = host::GetNanoTime();
+
+        for (u32 i = 0; i < num; i++) {
+            MaskBytes(data.data(), size, key, i);
+            host::Consume(data.data());
+        }
+
+        byteTime = static_cast<double>(host::GetNanoTime() - start);
+        bench.Report(num);
+    }
+
+    std::printf("%-40s %10.0f MB/s %9.0f MB/s %6.2fx\n", "  words/bytes",
+                static_cast<double>(size) * num / wordTime * 1e3,
+                static_cast<double>(size) * num / byteTime * 1e3,
+                byteTime / wordTime);
+}
+
+/**
+ * @brief Measures message round trips, one message at a time
+ */
+void BenchLatency(u32 size, u32 num) {
+    EchoServer server;
+    Client client;
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+
+    std::vector<u8> data(size);
+    FillPattern(data.data(), size, 0);
+
+    std::vector<u64> times(num);
+
+    for (u32 i = 0; i < num; i++) {
+        u64 start = host::GetNanoTime();
+
+        HOST_CHECK(client.socket.SendBinary(data.data(), size));
+        HOST_CHECK(WaitFor(client.numMessages, i + 1));
+
+        times[i] = host::GetNanoTime() - start;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    u64 total = 0;
+    for (u32 i = 0; i < num; i++) {
+        total += times[i];
+    }
+
+    std::printf("WebSocket round trip %5lu B              avg %6.2f us  "
+                "p50 %6.2f us  p99 %6.2f us  max %7.2f us\n",
+                size, total / 1000.0 / num, times[num / 2] / 1000.0,
+                times[num * 99 / 100] / 1000.0, times[num - 1] / 1000.0);
+}
+
+/**
+ * @brief Measures echo throughput, with a window of messages in flight
+ */
+void BenchThroughput(u32 size, u32 num, u32 window) {
+    EchoServer server;
+    Client client;
+    HOST_CHECK_EQ(client.Connect(server), kiwi::WebSocket::EResult_Success);
+
+    std::vector<u8> data(size);
+    FillPattern(data.data(), size, 0);
+
+    u64 start = host::GetNanoTime();
+
+    for (u32 i = 0; i < num; i++) {
+        // Wait for room in the window
+        HOST_CHECK(
+            WaitFor(client.numMessages, i < window ? 0 : i - window + 1));
+        HOST_CHECK(client.socket.SendBinary(data.data(), size));
+    }
+
+    HOST_CHECK(WaitFor(client.numMessages, num));
+
+    double seconds = (host::GetNanoTime() - start) / 1e9;
+
+    std::printf("WebSocket echo %2lu x %5lu B               %8.0f msg/s  "
+                "%7.2f MB/s\n",
+                window, size, num / seconds, num * size / seconds / 1e6);
+}
+
+void BenchWebSocket() {
+    BenchMask(64, 1000000);
+    BenchMask(1024, 200000);
+    BenchMask(4096, 50000);
+
+    BenchLatency(64, 5000);
+    BenchLatency(4096, 5000);
+
+    BenchThroughput(64, 20000, 16);
+    BenchThroughput(4096, 20000, 16);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    host::RegisterNetDevices();
+    kiwi::LibSO::Initialize();
+
+    host::Run("WebSocket accept key", TestAccept);
+    host::Run("WebSocket masking", TestMask);
+    host::Run("WebSocket connect/upgrade", TestConnect);
+    host::Run("WebSocket echo", TestEcho);
+    host::Run("WebSocket large frames", TestLargeFrame);
+    host::Run("WebSocket ping/close", TestPingClose);
+
+    if (host::IsBench(argc, argv)) {
+        BenchWebSocket();
+    }
+
+    return host::Finish();
+}
@@ -0,0 +1,15 @@
+from libkiwi_py.binary.block.block_base import BlockBase
+from libkiwi_py.binary.types.primitive import Primitive
+
+
+class NAMEBlock(BlockBase):
+    """Map file symbol name index block"""
+
+    SIGNATURE = "NAME"
+
+    def __init__(self, indices: list[int] = []):
+        """Indices refer to the symbol table, sorted by symbol name"""
+        super().__init__(self.SIGNATURE)
+
+        self.add_member(Primitive("u32", "numSym", value=len(indices)))
+        self.add_member(Primitive("u32", "indices", arr="[]", value=indices))
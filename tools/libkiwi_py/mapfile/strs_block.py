@@ -0,0 +1,23 @@
+from libkiwi_py.binary.block.block_base import BlockBase
+from libkiwi_py.binary.types.primitive import Primitive
+from libkiwi_py.binary.types.string import String
+from libkiwi_py.utility.util import Util
+
+
+class STRSBlock(BlockBase):
+    """Map file symbol string pool block"""
+
+    SIGNATURE = "STRS"
+
+    def __init__(self, names: list[str] = []):
+        super().__init__(self.SIGNATURE)
+
+        self.offsets = []
+        pool_size = 0
+
+        for name in names:
+            self.offsets.append(pool_size)
+            pool_size += Util.str_len(name, terminator=True)
+
+        self.add_member(Primitive("u32", "poolSize", value=pool_size))
+        self.add_member(String("pool", arr="[]", value=names))
@@ -0,0 +1,20 @@
+from libkiwi_py.binary.block.block_base import BlockBase
+from libkiwi_py.binary.types.primitive import Primitive
+
+
+class SYMBBlock(BlockBase):
+    """Map file symbol table block"""
+
+    SIGNATURE = "SYMB"
+
+    def __init__(self, symbols: list[tuple[int, int, int]] = []):
+        """Symbols are (address, size, name offset) tuples, sorted by address"""
+        super().__init__(self.SIGNATURE)
+
+        # Flatten symbol structures (u32 addr, u32 size, u32 name)
+        data = []
+        for sym in symbols:
+            data.extend(sym)
+
+        self.add_member(Primitive("u32", "numSym", value=len(symbols)))
+        self.add_member(Primitive("u32", "symbols", arr="[]", value=data))
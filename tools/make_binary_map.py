@@ -0,0 +1,105 @@
+from argparse import ArgumentParser
+from sys import argv
+
+from libkiwi_py.stream.file_stream import FileStream, OpenMode, DataMode
+from libkiwi_py.stream.stream_base import Endian
+from libkiwi_py.mapfile.kmap_block import KMAPBlock
+from libkiwi_py.mapfile.symb_block import SYMBBlock
+from libkiwi_py.mapfile.name_block import NAMEBlock
+from libkiwi_py.mapfile.strs_block import STRSBlock
+
+
+def read_symbols(path: str) -> list[tuple[int, int, str]]:
+    """Read (address, size, name) symbols from a Kamek or Dolphin map file"""
+
+    with open(path, "r") as f:
+        lines = f.readlines()
+
+    symbols = []
+
+    # Kamek Binary Map
+    #   Offset   Size   Name
+    if lines[0] == "Kamek Binary Map\n":
+        for line in lines[2:]:
+            tokens = line.split()  # offset, size, name
+            if len(tokens) < 3:
+                continue
+
+            symbols.append((int(tokens[0], base=16),
+                            int(tokens[1], base=16),
+                            tokens[2]))
+
+    # .text section layout (see make_dolphin_map.py)
+    #   Address   Size   Address   Alignment   Name
+    elif lines[0] == ".text section layout\n":
+        for line in lines[1:]:
+            tokens = line.split()  # address, size, address, align, name
+            if len(tokens) < 5:
+                continue
+
+            symbols.append((int(tokens[0], base=16),
+                            int(tokens[1], base=16),
+                            tokens[4]))
+
+    else:
+        print(f"[FATAL] Input file is not a Kamek or Dolphin map file: {path}")
+        return None
+
+    return symbols
+
+
+def write_binary(infile: str, outfile: str) -> bool:
+    """Convert the specified map file to a KMAP binary"""
+
+    symbols = read_symbols(infile)
+    if symbols == None:
+        return False
+
+    # Runtime lookups binary search by address
+    symbols.sort(key=lambda sym: sym[0])
+
+    names = [sym[2] for sym in symbols]
+    strs_blk = STRSBlock(names)
+
+    # Runtime reverse lookups binary search by name (strcmp order)
+    name_order = sorted(range(len(symbols)),
+                        key=lambda i: names[i].encode("ascii"))
+
+    table = [(sym[0], sym[1], strs_blk.offsets[i])
+             for i, sym in enumerate(symbols)]
+
+    try:
+        strm = FileStream(Endian.Big)
+        strm.open(outfile, OpenMode.Write, DataMode.Binary)
+    except OSError:
+        print(f"[FATAL] Could not open KMAP file for writing: {outfile}")
+        return False
+
+    # Header
+    header_blk = KMAPBlock([])
+
+    # Append blocks
+    header_blk.append_child(SYMBBlock(table))
+    header_blk.append_child(NAMEBlock(name_order))
+    header_blk.append_child(strs_blk)
+
+    # Write to file
+    header_blk.write(strm)
+
+    strm.close()
+    return True
+
+
+def main():
+    parser = ArgumentParser()
+    parser.add_argument("--infile", type=str, required=True,
+                        help="Map file (Kamek or Dolphin)")
+    parser.add_argument("--outfile", type=str, required=True,
+                        help="Binary map file (KMAP)")
+
+    args = parser.parse_args(argv[1:])
+    write_binary(args.infile, args.outfile)
+
+
+if __name__ == "__main__":
+    main()
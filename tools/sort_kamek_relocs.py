@@ -0,0 +1,332 @@
+from argparse import ArgumentParser
+from struct import Struct
+from sys import argv
+
+# Kamek binary header (see loader/kamek/kamekLoader.cpp)
+#   magic1, magic2, version, bssSize, codeSize, ctorStart, ctorEnd, flags, pad
+HEADER = Struct(">IHHIIIIII")
+WORD = Struct(">I")
+
+KAMEK_MAGIC = (0x4B616D65, 0x6B00)  # 'Kamek\0'
+
+# Header flags (version 3+)
+FLAG_GROUPED_RELOCS = 1 << 0
+
+# Relative address which signals that an absolute address follows
+ABSOLUTE_ADDRESS = 0xFFFFFE
+
+CACHE_LINE_SIZE = 32
+
+# Command: (name, number of argument words, patch size)
+COMMANDS = {
+    1: ("Addr32", 1, 4),
+    4: ("Addr16Lo", 1, 2),
+    5: ("Addr16Hi", 1, 2),
+    6: ("Addr16Ha", 1, 2),
+    10: ("Rel24", 1, 4),
+    32: ("Write32", 1, 4),
+    33: ("Write16", 1, 2),
+    34: ("Write8", 1, 1),
+    35: ("CondWritePointer", 2, 4),
+    36: ("CondWrite32", 2, 4),
+    37: ("CondWrite16", 2, 2),
+    38: ("CondWrite8", 2, 1),
+    64: ("Branch", 1, 4),
+    65: ("BranchLink", 1, 4),
+}
+
+
+class Reloc:
+    """Relocation command.
+
+    Addresses and arguments use the loader's encoding, where values with the
+    high bit set are absolute and the rest are relative to the module.
+    """
+
+    def __init__(self, cmd: int, address: int, args: list[int]):
+        self.cmd = cmd
+        self.address = address
+        self.args = args
+
+    def is_absolute(self) -> bool:
+        return (self.address & 0x80000000) != 0
+
+    def size(self) -> int:
+        return COMMANDS[self.cmd][2]
+
+
+def read_relocs(data: bytes, offset: int) -> list[Reloc]:
+    """Read a Kamek relocation stream"""
+
+    relocs = []
+
+    while offset < len(data):
+        header, = WORD.unpack_from(data, offset)
+        offset += 4
+
+        cmd = header >> 24
+        address = header & 0xFFFFFF
+
+        if cmd not in COMMANDS:
+            raise ValueError(f"Unknown relocation command: {cmd}")
+
+        if address == ABSOLUTE_ADDRESS:
+            address, = WORD.unpack_from(data, offset)
+            offset += 4
+
+        num_args = COMMANDS[cmd][1]
+        args = [WORD.unpack_from(data, offset + i * 4)[0]
+                for i in range(num_args)]
+        offset += num_args * 4
+
+        relocs.append(Reloc(cmd, address, args))
+
+    return relocs
+
+
+def has_overlap(relocs: list[Reloc]) -> bool:
+    """Check whether any relocations patch the same bytes.
+
+    Those depend on the stream order, so they can't be reordered.
+    """
+
+    patches = sorted((r.address, r.address + r.size()) for r in relocs)
+
+    for prev, cur in zip(patches, patches[1:]):
+        if cur[0] < prev[1]:
+            return True
+
+    return False
+
+
+def write_grouped(relocs: list[Reloc]) -> bytes:
+    """Write a relocation stream grouped by command and sorted by address"""
+
+    groups = {}
+    for r in relocs:
+        groups.setdefault(r.cmd, []).append(r)
+
+    data = bytearray()
+
+    for cmd in sorted(groups):
+        group = sorted(groups[cmd], key=lambda r: r.address)
+
+        data += WORD.pack((cmd << 24) | len(group))
+        for r in group:
+            data += WORD.pack(r.address)
+            for arg in r.args:
+                data += WORD.pack(arg)
+
+    return bytes(data)
+
+
+class Memory:
+    """Simulated memory for replaying relocations.
+
+    Memory outside the module (game code) reads as zero until patched.
+    """
+
+    # Arbitrary module base (must not collide with absolute addresses)
+    TEXT = 0x10000000
+
+    def __init__(self, code: bytes, bss_size: int):
+        self.text = bytearray(code) + bytearray(bss_size)
+        self.game = {}
+
+    def resolve(self, value: int) -> int:
+        return value if value & 0x80000000 else Memory.TEXT + value
+
+    def read(self, address: int, size: int) -> int:
+        value = 0
+        for i in range(size):
+            value = (value << 8) | self.read8(address + i)
+        return value
+
+    def write(self, address: int, size: int, value: int):
+        for i in range(size):
+            shift = (size - 1 - i) * 8
+            self.write8(address + i, (value >> shift) & 0xFF)
+
+    def read8(self, address: int) -> int:
+        if address & 0x80000000:
+            return self.game.get(address, 0)
+        return self.text[address - Memory.TEXT]
+
+    def write8(self, address: int, value: int):
+        if address & 0x80000000:
+            self.game[address] = value
+        else:
+            self.text[address - Memory.TEXT] = value
+
+    def apply(self, r: Reloc):
+        """Apply relocation (see kCommandHandler in kamekLoader.cpp)"""
+
+        name = COMMANDS[r.cmd][0]
+        address = self.resolve(r.address)
+        target = self.resolve(r.args[0])
+        value = r.args[0]
+
+        if name == "Addr32":
+            self.write(address, 4, target)
+        elif name == "Addr16Lo":
+            self.write(address, 2, target & 0xFFFF)
+        elif name == "Addr16Hi":
+            self.write(address, 2, target >> 16)
+        elif name == "Addr16Ha":
+            self.write(address, 2, ((target >> 16) +
+                                    (1 if target & 0x8000 else 0)) & 0xFFFF)
+        elif name in ("Rel24", "Branch", "BranchLink"):
+            if name == "Branch":
+                self.write(address, 4, 0x48000000)
+            elif name == "BranchLink":
+                self.write(address, 4, 0x48000001)
+
+            delta = (target - address) & 0x3FFFFFC
+            self.write(address, 4,
+                       (self.read(address, 4) & 0xFC000003) | delta)
+        elif name.startswith("Write"):
+            size = r.size()
+            self.write(address, size, value & ((1 << (size * 8)) - 1))
+        elif name.startswith("CondWrite"):
+            size = r.size()
+            mask = (1 << (size * 8)) - 1
+            if name == "CondWritePointer":
+                value = target
+            if self.read(address, size) == r.args[1] & mask:
+                self.write(address, size, value & mask)
+
+
+def simulate_flushes(relocs: list[Reloc], grouped: bool) -> tuple[int, int]:
+    """Simulate the loader's game code cache maintenance.
+
+    Mirrors LineFlusher in kamekLoader.cpp: a line is flushed once the patches
+    move on to another line, and the last line is flushed at the end.
+
+    Returns the number of flushes, and the number of lines which were patched
+    after their last flush (stale instructions).
+    """
+
+    flushes = 0
+    dirty = set()
+    pending = None
+
+    def flush(line: int):
+        nonlocal flushes
+        flushes += 1
+        dirty.discard(line)
+
+    for r in relocs:
+        # Module memory is flushed all at once
+        if not r.is_absolute():
+            continue
+
+        line = r.address & ~(CACHE_LINE_SIZE - 1)
+        dirty.add(line)
+
+        # Ungrouped streams flush after every patch
+        if not grouped:
+            flush(line)
+            continue
+
+        if line != pending:
+            if pending is not None:
+                flush(pending)
+            pending = line
+
+    if pending is not None:
+        flush(pending)
+
+    return flushes, len(dirty)
+
+
+def replay(code: bytes, bss_size: int, relocs: list[Reloc]) -> Memory:
+    """Replay relocations into a simulated memory image"""
+
+    mem = Memory(code, bss_size)
+    for r in relocs:
+        mem.apply(r)
+
+    return mem
+
+
+def sort_relocs(infile: str, outfile: str) -> bool:
+    """Rewrite a Kamek binary with a grouped relocation stream"""
+
+    with open(infile, "rb") as f:
+        data = f.read()
+
+    magic1, magic2, version, bss_size, code_size, ctor_start, ctor_end, \
+        flags, _ = HEADER.unpack_from(data, 0)
+
+    if (magic1, magic2) != KAMEK_MAGIC:
+        print(f"[FATAL] Input file is not a Kamek binary: {infile}")
+        return False
+
+    # Nothing to do
+    if version >= 3 and flags & FLAG_GROUPED_RELOCS:
+        return True
+
+    if version != 2:
+        print(f"[FATAL] Unsupported Kamek binary version {version}: {infile}")
+        return False
+
+    code = data[HEADER.size:HEADER.size + code_size]
+
+    try:
+        relocs = read_relocs(data, HEADER.size + code_size)
+    except ValueError as err:
+        print(f"[FATAL] {err}: {infile}")
+        return False
+
+    # Order-dependent streams are left alone (still valid for the loader)
+    if has_overlap(relocs):
+        print(f"[WARN] Relocations overlap, not grouping them: {infile}")
+        is_grouped = False
+        grouped = relocs
+        stream = data[HEADER.size + code_size:]
+    else:
+        is_grouped = True
+        grouped = sorted(relocs, key=lambda r: (r.cmd, r.address))
+        stream = write_grouped(relocs)
+        version = 3
+        flags |= FLAG_GROUPED_RELOCS
+
+    # Both streams must produce the same image
+    before = replay(code, bss_size, relocs)
+    after = replay(code, bss_size, grouped)
+    if before.text != after.text or before.game != after.game:
+        print(f"[FATAL] Grouped relocations changed the module: {infile}")
+        return False
+
+    # Every patched game code line must be flushed after its last patch
+    flushes_before, _ = simulate_flushes(relocs, False)
+    flushes_after, stale = simulate_flushes(grouped, is_grouped)
+    if stale > 0:
+        print(f"[FATAL] {stale} game code lines left stale: {infile}")
+        return False
+
+    print(f"[INFO] {len(relocs)} relocations, game code flushes: "
+          f"{flushes_before} -> {flushes_after}")
+
+    header = HEADER.pack(magic1, magic2, version, bss_size, code_size,
+                         ctor_start, ctor_end, flags, 0)
+
+    with open(outfile, "wb") as f:
+        f.write(header + code + stream)
+
+    return True
+
+
+def main():
+    parser = ArgumentParser()
+    parser.add_argument("--infile", type=str, required=True,
+                        help="Kamek binary")
+    parser.add_argument("--outfile", type=str, required=True,
+                        help="Kamek binary with grouped relocations")
+
+    args = parser.parse_args(argv[1:])
+    sort_relocs(args.infile, args.outfile)
+
+
+if __name__ == "__main__":
+    main()